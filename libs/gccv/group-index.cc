@@ -0,0 +1,287 @@
+// -*- C++ -*-
+
+/*
+ * Gnome Chemistry Utils
+ * gccv/group-index.cc
+ *
+ * Copyright (C) 2026 Jean Bréfort <jean.brefort@normalesup.org>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301
+ * USA
+ */
+
+#include "config.h"
+#include "group-index.h"
+#include "item.h"
+#include <glib.h>
+#include <algorithm>
+#include <cmath>
+
+// the maximum number of children of a tree node
+#define NODE_SIZE 8
+// the number of children kept out of the tree before it is always rebuilt
+#define MAX_DIRTY 16
+// some items, such as arcs, detect hits slightly outside of their bounds
+#define DISTANCE_SLACK 1.
+
+using namespace std;
+
+namespace gccv {
+
+GroupIndex::GroupIndex (list < Item * > const &children):
+	m_Leaves (0),
+	m_Stale (0),
+	m_First (0),
+	m_Last (-1)
+{
+	list < Item * >::const_iterator i, end = children.end ();
+	for (i = children.begin (); i != end; i++) {
+		Child &child = m_Children[*i];
+		child.rank = ++m_Last;
+		child.entry = -1;
+		m_Dirty.insert (*i);
+	}
+}
+
+GroupIndex::~GroupIndex ()
+{
+}
+
+void GroupIndex::AddItem (Item *item, bool front)
+{
+	Child &child = m_Children[item];
+	child.rank = (front)? --m_First: ++m_Last;
+	child.entry = -1;
+	m_Dirty.insert (item);
+}
+
+void GroupIndex::RemoveItem (Item *item)
+{
+	map < Item *, Child >::iterator i = m_Children.find (item);
+	if (i == m_Children.end ())
+		return;
+	if ((*i).second.entry >= 0) {
+		m_Entries[(*i).second.entry].item = NULL;
+		m_Stale++;
+	}
+	m_Children.erase (i);
+	m_Dirty.erase (item);
+}
+
+void GroupIndex::Restack (Item *item, bool front)
+{
+	map < Item *, Child >::iterator i = m_Children.find (item);
+	if (i == m_Children.end ())
+		return;
+	(*i).second.rank = (front)? --m_First: ++m_Last;
+	if ((*i).second.entry >= 0)
+		m_Entries[(*i).second.entry].rank = (*i).second.rank;
+}
+
+void GroupIndex::ItemChanged (Item *item)
+{
+	map < Item *, Child >::iterator i = m_Children.find (item);
+	if (i == m_Children.end () || (*i).second.entry < 0)
+		return;
+	m_Entries[(*i).second.entry].item = NULL;
+	(*i).second.entry = -1;
+	m_Stale++;
+	m_Dirty.insert (item);
+}
+
+double GroupIndex::Distance (double x, double y, Item **item)
+{
+	Update ();
+	Nearest nearest;
+	nearest.distance = G_MAXDOUBLE;
+	nearest.item = NULL;
+	nearest.rank = 0;
+	if (!m_Nodes.empty ())
+		Search (m_Nodes.size () - 1, x, y, nearest);
+	set < Item * >::iterator i, end = m_Dirty.end ();
+	for (i = m_Dirty.begin (); i != end; i++)
+		Test (*i, m_Children[*i].rank, x, y, nearest);
+	if (item)
+		*item = nearest.item;
+	return nearest.distance;
+}
+
+void GroupIndex::GetItems (double x0, double y0, double x1, double y1, vector < Item * > &items)
+{
+	Update ();
+	Box box = {x0, y0, x1, y1}, bounds;
+	vector < pair < long, Item * > > found;
+	if (!m_Nodes.empty ())
+		Search (m_Nodes.size () - 1, box, found);
+	set < Item * >::iterator i, end = m_Dirty.end ();
+	for (i = m_Dirty.begin (); i != end; i++) {
+		(*i)->GetBounds (bounds.x0, bounds.y0, bounds.x1, bounds.y1);
+		if (Overlap (bounds, box))
+			found.push_back (pair < long, Item * > (m_Children[*i].rank, *i));
+	}
+	sort (found.begin (), found.end ());
+	items.clear ();
+	vector < pair < long, Item * > >::iterator j, jend = found.end ();
+	for (j = found.begin (); j != jend; j++)
+		items.push_back ((*j).second);
+}
+
+void GroupIndex::Update ()
+{
+	if (m_Dirty.size () > MAX_DIRTY + m_Children.size () / 8 || m_Stale > MAX_DIRTY + m_Entries.size () / 2)
+		Build ();
+}
+
+void GroupIndex::Build ()
+{
+	m_Entries.clear ();
+	m_Nodes.clear ();
+	m_Dirty.clear ();
+	m_Stale = 0;
+	m_Leaves = 0;
+	map < Item *, Child >::iterator i, iend = m_Children.end ();
+	Entry entry;
+	for (i = m_Children.begin (); i != iend; i++) {
+		(*i).first->GetBounds (entry.box.x0, entry.box.y0, entry.box.x1, entry.box.y1);
+		entry.item = (*i).first;
+		entry.rank = (*i).second.rank;
+		m_Entries.push_back (entry);
+	}
+	unsigned n = m_Entries.size (), j, k;
+	if (n == 0)
+		return;
+	// sort tile recursive packing: vertical slices sorted by y
+	m_Leaves = (n + NODE_SIZE - 1) / NODE_SIZE;
+	unsigned slices = ceil (sqrt (static_cast < double > (m_Leaves)));
+	unsigned slice = ((m_Leaves + slices - 1) / slices) * NODE_SIZE;
+	sort (m_Entries.begin (), m_Entries.end (), CompareX);
+	for (j = 0; j < n; j += slice)
+		sort (m_Entries.begin () + j, m_Entries.begin () + MIN (j + slice, n), CompareY);
+	Node node;
+	for (j = 0; j < n; j++) {
+		m_Children[m_Entries[j].item].entry = j;
+		if (j % NODE_SIZE == 0) {
+			node.box = m_Entries[j].box;
+			node.first = j;
+		} else
+			Merge (node.box, m_Entries[j].box);
+		if (j % NODE_SIZE == NODE_SIZE - 1 || j == n - 1) {
+			node.last = j + 1;
+			m_Nodes.push_back (node);
+		}
+	}
+	// upper levels until there is only one root node
+	unsigned start = 0, end = m_Nodes.size ();
+	while (end - start > 1) {
+		for (j = start; j < end; j += NODE_SIZE) {
+			node.box = m_Nodes[j].box;
+			node.first = j;
+			node.last = MIN (j + NODE_SIZE, end);
+			for (k = j + 1; k < node.last; k++)
+				Merge (node.box, m_Nodes[k].box);
+			m_Nodes.push_back (node);
+		}
+		start = end;
+		end = m_Nodes.size ();
+	}
+}
+
+void GroupIndex::Search (unsigned node, double x, double y, Nearest &nearest) const
+{
+	Node const &cur = m_Nodes[node];
+	unsigned i;
+	if (node < m_Leaves) {
+		for (i = cur.first; i < cur.last; i++) {
+			Entry const &entry = m_Entries[i];
+			if (entry.item && BoxDistance (entry.box, x, y) - DISTANCE_SLACK <= nearest.distance)
+				Test (entry.item, entry.rank, x, y, nearest);
+		}
+		return;
+	}
+	// visit the nearest nodes first so that the others are more likely to be skipped
+	pair < double, unsigned > children[NODE_SIZE];
+	unsigned n = 0;
+	for (i = cur.first; i < cur.last; i++)
+		children[n++] = pair < double, unsigned > (BoxDistance (m_Nodes[i].box, x, y), i);
+	sort (children, children + n);
+	for (i = 0; i < n; i++)
+		if (children[i].first - DISTANCE_SLACK <= nearest.distance)
+			Search (children[i].second, x, y, nearest);
+}
+
+void GroupIndex::Search (unsigned node, Box const &box, vector < pair < long, Item * > > &items) const
+{
+	Node const &cur = m_Nodes[node];
+	if (!Overlap (cur.box, box))
+		return;
+	unsigned i;
+	if (node < m_Leaves) {
+		for (i = cur.first; i < cur.last; i++) {
+			Entry const &entry = m_Entries[i];
+			if (entry.item && Overlap (entry.box, box))
+				items.push_back (pair < long, Item * > (entry.rank, entry.item));
+		}
+	} else
+		for (i = cur.first; i < cur.last; i++)
+			Search (i, box, items);
+}
+
+void GroupIndex::Test (Item *item, long rank, double x, double y, Nearest &nearest)
+{
+	Item *cur = NULL;
+	double d = item->Distance (x, y, &cur);
+	// on equal distances, the child displayed first wins, as when scanning the list
+	if (d < nearest.distance || (d == nearest.distance && nearest.item && rank < nearest.rank)) {
+		nearest.distance = d;
+		nearest.item = cur? cur: item;
+		nearest.rank = rank;
+	}
+}
+
+double GroupIndex::BoxDistance (Box const &box, double x, double y)
+{
+	double dx = MAX (MAX (box.x0 - x, x - box.x1), 0.),
+	       dy = MAX (MAX (box.y0 - y, y - box.y1), 0.);
+	return sqrt (dx * dx + dy * dy);
+}
+
+bool GroupIndex::Overlap (Box const &box, Box const &other)
+{
+	return box.x0 <= other.x1 && box.x1 >= other.x0 && box.y0 <= other.y1 && box.y1 >= other.y0;
+}
+
+void GroupIndex::Merge (Box &box, Box const &other)
+{
+	if (other.x0 < box.x0)
+		box.x0 = other.x0;
+	if (other.y0 < box.y0)
+		box.y0 = other.y0;
+	if (other.x1 > box.x1)
+		box.x1 = other.x1;
+	if (other.y1 > box.y1)
+		box.y1 = other.y1;
+}
+
+bool GroupIndex::CompareX (Entry const &e1, Entry const &e2)
+{
+	return e1.box.x0 + e1.box.x1 < e2.box.x0 + e2.box.x1;
+}
+
+bool GroupIndex::CompareY (Entry const &e1, Entry const &e2)
+{
+	return e1.box.y0 + e1.box.y1 < e2.box.y0 + e2.box.y1;
+}
+
+}	//	namespace gccv
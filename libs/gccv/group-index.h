@@ -0,0 +1,150 @@
+// -*- C++ -*-
+
+/*
+ * Gnome Chemistry Utils
+ * gccv/group-index.h
+ *
+ * Copyright (C) 2026 Jean Bréfort <jean.brefort@normalesup.org>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301
+ * USA
+ */
+
+#ifndef GCCV_GROUP_INDEX_H
+#define GCCV_GROUP_INDEX_H
+
+/*!\file*/
+
+#include <list>
+#include <map>
+#include <set>
+#include <vector>
+
+namespace gccv {
+
+class Item;
+
+/*!\class GroupIndex gccv/group-index.h
+A bounding box tree over the children of a Group, used to find the nearest
+child and the children overlapping a region without evaluating all of them.
+The tree is packed at once from the children bounds. Children added or whose
+bounds changed since are kept apart and scanned linearly until there are enough
+of them to make rebuilding the tree worthwhile.
+
+The index also stores the children order, so that results are the same as when
+scanning the children list: overlapping children are returned in display order,
+and when several children are at the same distance, the first displayed wins.
+*/
+class GroupIndex
+{
+public:
+/*!
+@param children the Group children, in display order.
+
+Creates an index for \a children. The tree is built when first needed.
+*/
+	GroupIndex (std::list < Item * > const &children);
+/*!
+The destructor.
+*/
+	~GroupIndex ();
+
+/*!
+@param item the new child.
+@param front whether \a item is displayed first, below other children.
+*/
+	void AddItem (Item *item, bool front);
+/*!
+@param item the child to remove.
+*/
+	void RemoveItem (Item *item);
+/*!
+@param item a child.
+@param front whether \a item is now displayed first or last.
+*/
+	void Restack (Item *item, bool front);
+/*!
+@param item a child which bounds have changed.
+*/
+	void ItemChanged (Item *item);
+
+/*!
+@param x horizontal position in the Group coordinates.
+@param y vertical position in the Group coordinates.
+@param item where to store the nearest Item.
+
+Evaluates Item::Distance() only for the children which bounds are not farther
+than the nearest distance found so far.
+@return the distance to the nearest child.
+*/
+	double Distance (double x, double y, Item **item);
+/*!
+@param x0 the top left horizontal bound of the region.
+@param y0 the top left vertical bound of the region.
+@param x1 the bottom right horizontal bound of the region.
+@param y1 the bottom right vertical bound of the region.
+@param items where to store the children.
+
+Retrieves the children which bounds overlap the region, in display order.
+*/
+	void GetItems (double x0, double y0, double x1, double y1, std::vector < Item * > &items);
+
+private:
+	struct Box {
+		double x0, y0, x1, y1;
+	};
+	struct Entry {
+		Box box;
+		Item *item;	// NULL when the entry is no longer valid
+		long rank;
+	};
+	struct Node {
+		Box box;
+		unsigned first, last;	// children nodes or entries for leaves
+	};
+	struct Child {
+		long rank;
+		int entry;	// -1 when the child is not in the tree
+	};
+	struct Nearest {
+		double distance;
+		Item *item;
+		long rank;
+	};
+
+	void Update ();
+	void Build ();
+	void Search (unsigned node, double x, double y, Nearest &nearest) const;
+	void Search (unsigned node, Box const &box, std::vector < std::pair < long, Item * > > &items) const;
+	static void Test (Item *item, long rank, double x, double y, Nearest &nearest);
+	static double BoxDistance (Box const &box, double x, double y);
+	static bool Overlap (Box const &box, Box const &other);
+	static void Merge (Box &box, Box const &other);
+	static bool CompareX (Entry const &e1, Entry const &e2);
+	static bool CompareY (Entry const &e1, Entry const &e2);
+
+private:
+	std::map < Item *, Child > m_Children;
+	std::set < Item * > m_Dirty;
+	std::vector < Entry > m_Entries;
+	std::vector < Node > m_Nodes;
+	unsigned m_Leaves;	// the first m_Leaves nodes are leaves
+	unsigned m_Stale;
+	long m_First, m_Last;
+};
+
+}	//	namespace gccv
+
+#endif	//	GCCV_GROUP_INDEX_H
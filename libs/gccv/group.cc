@@ -24,8 +24,13 @@
 
 #include "config.h"
 #include "group.h"
+#include "group-index.h"
 
 #include <cstdio>
+#include <vector>
+
+// groups with less children are not indexed
+#define INDEX_MIN_SIZE 64
 
 using namespace std;
 
@@ -34,28 +39,32 @@ namespace gccv {
 Group::Group (Canvas *canvas):
 	Item (canvas),
 	m_x (0.),
-	m_y (0.)
+	m_y (0.),
+	m_Index (NULL)
 {
 }
 
 Group::Group (Canvas *canvas, double x, double y):
 	Item (canvas),
 	m_x (x),
-	m_y (y)
+	m_y (y),
+	m_Index (NULL)
 {
 }
 
 Group::Group (Group *parent, ItemClient *client):
 	Item (parent, client),
 	m_x (0.),
-	m_y (0.)
+	m_y (0.),
+	m_Index (NULL)
 {
 }
 
 Group::Group (Group *parent, double x, double y, ItemClient *client):
 	Item (parent, client),
 	m_x (x),
-	m_y (y)
+	m_y (y),
+	m_Index (NULL)
 {
 }
 
@@ -63,6 +72,7 @@ Group::~Group()
 {
 	while (!m_Children.empty ())
 		delete (*(m_Children.begin ()));
+	delete m_Index;
 }
 
 void Group::UpdateBounds ()
@@ -99,6 +109,9 @@ double Group::Distance (double x, double y, Item **item) const
 		return Item::Distance (x, y, item);
 	x -= m_x;
 	y -= m_y;
+	GroupIndex *index = GetIndex ();
+	if (index)
+		return index->Distance (x, y, item);
 	double d = G_MAXDOUBLE, di;
 	Item *nearest = NULL, *cur;
 	list <Item *>::const_iterator i, end = m_Children.end ();
@@ -125,6 +138,21 @@ bool Group::Draw (cairo_t *cr, double x0, double y0, double x1, double y1, bool
 	y0 -= m_y;
 	x1 -= m_x;
 	y1 -= m_y;
+	GroupIndex *index = GetIndex ();
+	if (index) {
+		vector <Item *> items;
+		index->GetItems (x0, y0, x1, y1, items);
+		vector <Item *>::iterator i, end = items.end ();
+		for (i = items.begin (); i != end; i++) {
+			if (!(*i)->GetVisible ())
+				continue;
+			cairo_set_operator (cr, (*i)->GetOperator ());
+			if (!(*i)->Draw (cr, x0, y0, x1, y1, is_vector))
+				(*i)->Draw (cr, is_vector);
+		}
+		cairo_restore (cr);
+		return true;
+	}
 	list <Item *>::const_iterator i, end = m_Children.end ();
 	for (i = m_Children.begin (); i != end; i++) {
 		double x, y, x_, y_;
@@ -144,12 +172,16 @@ bool Group::Draw (cairo_t *cr, double x0, double y0, double x1, double y1, bool
 void Group::AddChild (Item *item)
 {
 	m_Children.push_front (item);
+	if (m_Index)
+		m_Index->AddItem (item, true);
 	BoundsChanged ();
 }
 
 void Group::RemoveChild (Item *item)
 {
 	m_Children.remove (item);
+	if (m_Index)
+		m_Index->RemoveItem (item);
 	BoundsChanged ();
 }
 
@@ -200,6 +232,8 @@ void Group::MoveToFront (Item *item)
 	if (i != end) {
 		m_Children.erase (i);
 		m_Children.push_back (item); // back items are displayed at last
+		if (m_Index)
+			m_Index->Restack (item, false);
 	}
 }
 
@@ -212,7 +246,23 @@ void Group::MoveToBack (Item *item)
 	if (i != end) {
 		m_Children.erase (i);
 		m_Children.push_front (item); // front items are displayed at first
+		if (m_Index)
+			m_Index->Restack (item, true);
 	}
 }
 
+GroupIndex *Group::GetIndex () const
+{
+	if (!m_Index && m_Children.size () >= INDEX_MIN_SIZE)
+		m_Index = new GroupIndex (m_Children);
+	return m_Index;
+}
+
+void Group::ChildBoundsChanged (Item *item)
+{
+	if (m_Index)
+		m_Index->ItemChanged (item);
+	BoundsChanged ();
+}
+
 }
@@ -32,6 +32,8 @@
 
 namespace gccv {
 
+class GroupIndex;
+
 /*!
 @brief Item with Item children.
 
@@ -42,6 +44,8 @@ hierarchical tree if Item instances. The Canvas class owns a top level Group
 of this root Group.
 The Group class owns a pair of coordinates, x and y, which are used to shift all
 the children.
+Groups with many children build a GroupIndex over their bounds the first time
+they are drawn or searched, so that only the relevant children are visited.
 */
 class Group: public Item
 {
@@ -176,9 +180,16 @@ Moves the Group and hence all its descendants by changing the Group shift values
 protected:
 	void UpdateBounds ();
 
+private:
+	GroupIndex *GetIndex () const;
+	void ChildBoundsChanged (Item *item);
+
 private:
 	std::list<Item *> m_Children;
 	double m_x, m_y;	// translation offset
+	mutable GroupIndex *m_Index;
+
+friend class Item;
 };
 
 }
@@ -86,7 +86,7 @@ void Item::BoundsChanged ()
 {
 	m_CachedBounds = false;
 	if (m_Parent)
-		m_Parent->BoundsChanged ();
+		m_Parent->ChildBoundsChanged (this);
 }
 
 void Item::UpdateBounds ()
@@ -431,6 +431,7 @@ Application::Application (gcugtk::CmdContextGtk *cc):
 		// load settings before plugins
 		m_ConfNode = go_conf_get_node (GetConfDir (), GCP_CONF_DIR_SETTINGS);
 		GCU_GCONF_GET ("compression", int, CompressionLevel, 0)
+		GCU_GCONF_GET_NO_CHECK ("undo-budget", int, UndoBudget, 128)
 		GCU_GCONF_GET ("invert-wedge-hashes", bool, InvertWedgeHashes, false)
 		GCU_GCONF_GET ("use-atom-colors", bool, m_UseAtomColors, false)
 		bool CopyAsText;
@@ -1058,6 +1059,7 @@ void Application::UpdateAllTargets ()
 void Application::OnConfigChanged (GOConfNode *node, char const *name)
 {
 	GCU_UPDATE_KEY ("compression", int, CompressionLevel, {})
+	GCU_UPDATE_KEY ("undo-budget", int, UndoBudget, {})
 	bool CopyAsText;
 	GCU_UPDATE_KEY ("invert-wedge-hashes", bool, InvertWedgeHashes, UpdateAllTargets ();)
 	GCU_UPDATE_KEY ("use-atom-colors", bool, m_UseAtomColors, {})
@@ -914,6 +914,9 @@ bool Atom::Load (xmlNodePtr node)
 {
 	if (!gcu::Atom::Load (node))
 		return false;
+	Molecule *mol = dynamic_cast < Molecule * > (GetMolecule ());
+	if (mol)
+		mol->AtomMoved (this);
 	//Load electrons
 	xmlNodePtr child = node->children;
 	Electron *electron;
@@ -1066,6 +1069,9 @@ void Atom::SetCharge (int charge)
 void Atom::Move (double x, double y, double z)
 {
 	gcu::Atom::Move (x, y, z);
+	Molecule *mol = dynamic_cast < Molecule * > (GetMolecule ());
+	if (mol)
+		mol->AtomMoved (this);
 	map<string, Object*>::iterator i;
 	Object* electron = GetFirstChild (i);
 	while (electron) {
@@ -1082,9 +1088,20 @@ void Atom::Move (double x, double y, double z)
 	}
 }
 
+void Atom::SetCoords (double x, double y, double z)
+{
+	gcu::Atom::SetCoords (x, y, z);
+	Molecule *mol = dynamic_cast < Molecule * > (GetMolecule ());
+	if (mol)
+		mol->AtomMoved (this);
+}
+
 void Atom::Transform2D (Matrix2D& m, double x, double y)
 {
 	gcu::Atom::Transform2D (m, x, y);
+	Molecule *mol = dynamic_cast < Molecule * > (GetMolecule ());
+	if (mol)
+		mol->AtomMoved (this);
 	// Now transform electrons
 	map<string, Object*>::iterator i;
 	Object* electron = GetFirstChild (i);
@@ -1276,6 +1293,11 @@ bool Atom::Match (gcu::Atom *atom, AtomMatchState &state)
 	return gcu::Atom::Match (atom, state);
 }
 
+int Atom::GetMatchInvariant () const
+{
+	return (m_nH << 8) + gcu::Atom::GetMatchInvariant ();
+}
+
 void Atom::GetSymbolGeometry (double &width, double &height, double &angle, bool up) const
 {
 	if ((GetZ() != 6) || (GetBondsNumber () == 0) || m_ShowSymbol) {
@@ -1509,6 +1531,15 @@ bool Atom::SetProperty (unsigned property, char const *value)
 		static_cast < Molecule * > (GetMolecule ())->AddChiralAtom (this);
 		break;
 	}
+	case GCU_PROP_X:
+	case GCU_PROP_Y: {
+		// GCU_PROP_POS2D goes through SetCoords ()
+		gcu::Atom::SetProperty (property, value);
+		Molecule *mol = dynamic_cast < Molecule * > (GetMolecule ());
+		if (mol)
+			mol->AtomMoved (this);
+		break;
+	}
 	default:
 		return gcu::Atom::SetProperty (property, value);
 	}
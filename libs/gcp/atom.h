@@ -268,6 +268,14 @@ Used to move an Atom.
 */
 	virtual void Move (double x, double y, double z = 0.);
 /*!
+@param x the new x coordinate of the atom.
+@param y the new y coordinate of the atom.
+@param z the new z coordinate of the atom.
+
+Changes the position of the atom and updates the spatial index of its molecule.
+*/
+	void SetCoords (double x, double y, double z = 0);
+/*!
 @param m the Matrix2D of the transformation.
 @param x the x component of the center of the transformation.
 @param y the y component of the center of the transformation.
@@ -358,6 +366,11 @@ and return its result.
 @return true if the atoms match, false otherwise.
 */
 	bool Match (gcu::Atom *atom, gcu::AtomMatchState &state);
+/*!
+@return the invariant of the atom, which also depends on the number of
+implicit hydrogens.
+*/
+	int GetMatchInvariant () const;
 
 /*!
 @param width where to store the width.
@@ -728,9 +728,9 @@ void Document::RemoveBond (Bond* pBond)
 	}
 	pMol->Lock (false);
 	if (pBond->IsCyclic ()) {
-		pBond->RemoveAllCycles ();
 		pMol->Remove (pBond);
-		pMol->UpdateCycles ();
+		pMol->UpdateCycles (pBond);
+		pBond->RemoveAllCycles ();
 		Update ();
 	} else {
 		Object *Parent = pMol->GetParent ();
@@ -929,6 +929,7 @@ void Document::FinishOperation ()
 		m_RedoList.pop_front ();
 	}
 	m_pCurOp = NULL;
+	TrimUndoList ();
 	SetDirty (true);
 	m_Empty = !HasChildren ();
 	if (m_Window) {
@@ -949,6 +950,28 @@ void Document::AbortOperation()
 	m_pCurOp = NULL;
 }
 
+void Document::TrimUndoList ()
+{
+	size_t size = 0, budget = static_cast < size_t > (UndoBudget) << 20;
+	std::list < Operation * >::iterator i, end = m_UndoList.end ();
+	if (budget)
+		for (i = m_UndoList.begin (); i != end; i++)
+			size += (*i)->GetSize ();
+	// always keep the last operation
+	while (m_UndoList.size () > 1 &&
+	       ((MaxStackSize && m_UndoList.size () > MaxStackSize) || (budget && size > budget))) {
+		Operation *op = m_UndoList.back ();
+		size -= op->GetSize ();
+		delete op;
+		m_UndoList.pop_back ();
+		// the saved state is one operation nearer to the bottom of the stack, or lost
+		if (m_LastStackSize == 0)
+			m_LastStackSize = G_MAXUINT;
+		else if (m_LastStackSize != G_MAXUINT)
+			m_LastStackSize--;
+	}
+}
+
 void Document::PopOperation ()
 {
 	if (!m_UndoList.empty ()) {
@@ -1050,6 +1073,10 @@ Operation* Document::GetNewOperation (OperationType type)
 			return m_pCurOp = new DeleteOperation (this, m_OpID);
 		case GCP_MODIFY_OPERATION:
 			return m_pCurOp = new ModifyOperation (this, m_OpID);
+		case GCP_TRANSFORM_OPERATION:
+			return m_pCurOp = new TransformOperation (this, m_OpID);
+		case GCP_PROPERTY_OPERATION:
+			return m_pCurOp = new PropertyOperation (this, m_OpID);
 		default:
 			return NULL;
 	}
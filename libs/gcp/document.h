@@ -256,7 +256,8 @@ Sets the document author e-mail address.
 /*!
 Ends the current operation and pushes it on top of the undo stack. This method
 must be called after all changes have been done in  the document and the changes
-described in the operation.
+described in the operation. The oldest operations are then deleted if the undo
+stack exceeds MaxStackSize or UndoBudget.
 */
 	void FinishOperation ();
 /*!
@@ -449,6 +450,7 @@ private:
 	void RemoveAtom (Atom* pAtom);
 	void RemoveBond (Bond* pBond);
 	void RemoveFragment (Fragment* pFragment);
+	void TrimUndoList ();
 
 	//Implementation
 private:
@@ -164,6 +164,10 @@ and return its result. FragmentAtom instances can't be matched currently.
 */
 	bool Match (gcu::Atom *atom, gcu::AtomMatchState &state);
 /*!
+@return -1 since FragmentAtom instances can't be matched.
+*/
+	int GetMatchInvariant () const {return -1;}
+/*!
 @param pView the document view.
 
 Builds the symbol geometry if necessary.
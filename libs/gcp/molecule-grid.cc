@@ -0,0 +1,252 @@
+// -*- C++ -*-
+
+/*
+ * GChemPaint library
+ * molecule-grid.cc
+ *
+ * Copyright (C) 2026 Jean Bréfort <jean.brefort@normalesup.org>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301
+ * USA
+ */
+
+#include "config.h"
+#include "molecule-grid.h"
+#include "bond.h"
+#include "fragment-atom.h"
+#include <algorithm>
+#include <cmath>
+
+// bonds overlapping more cells are not indexed
+#define MAX_CELLS 64
+
+using namespace std;
+
+namespace gcp {
+
+MoleculeGrid::MoleculeGrid (double size):
+	m_Size (size),
+	m_NextRank (0)
+{
+}
+
+MoleculeGrid::~MoleculeGrid ()
+{
+}
+
+int MoleculeGrid::GetCell (double coord) const
+{
+	return static_cast < int > (floor (coord / m_Size));
+}
+
+bool MoleculeGrid::GetBox (Bond *bond, Box &box) const
+{
+	gcu::Atom *atom0 = bond->GetAtom (0), *atom1 = bond->GetAtom (1);
+	if (!atom0 || !atom1 || dynamic_cast < FragmentAtom * > (atom0) || dynamic_cast < FragmentAtom * > (atom1))
+		return false;
+	int x0 = GetCell (atom0->x ()), y0 = GetCell (atom0->y ()),
+		x1 = GetCell (atom1->x ()), y1 = GetCell (atom1->y ());
+	box.x0 = MIN (x0, x1);
+	box.x1 = MAX (x0, x1);
+	box.y0 = MIN (y0, y1);
+	box.y1 = MAX (y0, y1);
+	return (box.x1 - box.x0 + 1) * (box.y1 - box.y0 + 1) <= MAX_CELLS;
+}
+
+void MoleculeGrid::AddAtom (gcu::Atom *atom)
+{
+	map < gcu::Atom *, AtomEntry >::iterator i = m_Atoms.find (atom);
+	if (i != m_Atoms.end ()) {
+		(*i).second.bonds++;
+		return;
+	}
+	AtomEntry &entry = m_Atoms[atom];
+	entry.x = GetCell (atom->x ());
+	entry.y = GetCell (atom->y ());
+	entry.bonds = 1;
+	m_Cells[pair < int, int > (entry.x, entry.y)].atoms.push_back (atom);
+}
+
+void MoleculeGrid::RemoveAtom (gcu::Atom *atom)
+{
+	map < gcu::Atom *, AtomEntry >::iterator i = m_Atoms.find (atom);
+	if (i == m_Atoms.end () || --(*i).second.bonds > 0)
+		return;
+	vector < gcu::Atom * > &atoms = m_Cells[pair < int, int > ((*i).second.x, (*i).second.y)].atoms;
+	vector < gcu::Atom * >::iterator j = find (atoms.begin (), atoms.end (), atom);
+	if (j != atoms.end ()) {
+		*j = atoms.back ();
+		atoms.pop_back ();
+	}
+	m_Atoms.erase (i);
+}
+
+void MoleculeGrid::IndexBond (Bond *bond, BondEntry &entry)
+{
+	entry.atoms[0] = bond->GetAtom (0);
+	entry.atoms[1] = bond->GetAtom (1);
+	entry.indexed = GetBox (bond, entry.box);
+	if (!entry.indexed) {
+		m_Unindexed.push_back (bond);
+		return;
+	}
+	for (int x = entry.box.x0; x <= entry.box.x1; x++)
+		for (int y = entry.box.y0; y <= entry.box.y1; y++)
+			m_Cells[pair < int, int > (x, y)].bonds.push_back (bond);
+	AddAtom (entry.atoms[0]);
+	AddAtom (entry.atoms[1]);
+}
+
+void MoleculeGrid::UnindexBond (Bond *bond, BondEntry &entry)
+{
+	if (!entry.indexed) {
+		vector < Bond * >::iterator i = find (m_Unindexed.begin (), m_Unindexed.end (), bond);
+		if (i != m_Unindexed.end ())
+			m_Unindexed.erase (i);
+		return;
+	}
+	for (int x = entry.box.x0; x <= entry.box.x1; x++)
+		for (int y = entry.box.y0; y <= entry.box.y1; y++) {
+			vector < Bond * > &bonds = m_Cells[pair < int, int > (x, y)].bonds;
+			vector < Bond * >::iterator i = find (bonds.begin (), bonds.end (), bond);
+			if (i != bonds.end ()) {
+				*i = bonds.back ();
+				bonds.pop_back ();
+			}
+		}
+	RemoveAtom (entry.atoms[0]);
+	RemoveAtom (entry.atoms[1]);
+}
+
+void MoleculeGrid::AddBond (Bond *bond)
+{
+	if (m_Bonds.find (bond) != m_Bonds.end ())
+		return;
+	BondEntry &entry = m_Bonds[bond];
+	entry.rank = m_NextRank++;
+	IndexBond (bond, entry);
+}
+
+void MoleculeGrid::RemoveBond (Bond *bond)
+{
+	map < Bond *, BondEntry >::iterator i = m_Bonds.find (bond);
+	if (i == m_Bonds.end ())
+		return;
+	UnindexBond (bond, (*i).second);
+	m_Bonds.erase (i);
+}
+
+void MoleculeGrid::UpdateBond (Bond *bond)
+{
+	map < Bond *, BondEntry >::iterator i = m_Bonds.find (bond);
+	if (i == m_Bonds.end ())
+		return;
+	BondEntry &entry = (*i).second;
+	Box box;
+	bool indexed = GetBox (bond, box);
+	// fragment atoms move often, keep unindexed bonds in place
+	if (entry.atoms[0] == bond->GetAtom (0) && entry.atoms[1] == bond->GetAtom (1) && indexed == entry.indexed &&
+	    (!indexed || (box.x0 == entry.box.x0 && box.x1 == entry.box.x1 &&
+	    box.y0 == entry.box.y0 && box.y1 == entry.box.y1)))
+		return;
+	UnindexBond (bond, entry);
+	IndexBond (bond, entry);
+}
+
+void MoleculeGrid::MoveAtom (gcu::Atom *atom)
+{
+	map < gcu::Atom *, AtomEntry >::iterator i = m_Atoms.find (atom);
+	if (i != m_Atoms.end ()) {
+		AtomEntry &entry = (*i).second;
+		int x = GetCell (atom->x ()), y = GetCell (atom->y ());
+		if (x != entry.x || y != entry.y) {
+			vector < gcu::Atom * > &atoms = m_Cells[pair < int, int > (entry.x, entry.y)].atoms;
+			vector < gcu::Atom * >::iterator j = find (atoms.begin (), atoms.end (), atom);
+			if (j != atoms.end ()) {
+				*j = atoms.back ();
+				atoms.pop_back ();
+			}
+			entry.x = x;
+			entry.y = y;
+			m_Cells[pair < int, int > (x, y)].atoms.push_back (atom);
+		}
+	}
+	map < gcu::Bondable *, gcu::Bond * >::iterator j;
+	for (gcu::Bond *bond = atom->GetFirstBond (j); bond; bond = atom->GetNextBond (j))
+		UpdateBond (static_cast < Bond * > (bond));
+}
+
+gcu::Object *MoleculeGrid::GetAtomAt (double x, double y, double tolerance) const
+{
+	gcu::Object *found = NULL;
+	double best = 2. * tolerance * tolerance, dx, dy;
+	int x0 = GetCell (x - tolerance), x1 = GetCell (x + tolerance),
+		y0 = GetCell (y - tolerance), y1 = GetCell (y + tolerance);
+	for (int cx = x0; cx <= x1; cx++)
+		for (int cy = y0; cy <= y1; cy++) {
+			map < pair < int, int >, Cell >::const_iterator c = m_Cells.find (pair < int, int > (cx, cy));
+			if (c == m_Cells.end ())
+				continue;
+			vector < gcu::Atom * > const &atoms = (*c).second.atoms;
+			for (unsigned i = 0; i < atoms.size (); i++) {
+				dx = fabs (atoms[i]->x () - x);
+				dy = fabs (atoms[i]->y () - y);
+				if (dx < tolerance && dy < tolerance && dx * dx + dy * dy < best) {
+					best = dx * dx + dy * dy;
+					found = atoms[i];
+				}
+			}
+		}
+	for (unsigned i = 0; !found && i < m_Unindexed.size (); i++)
+		found = m_Unindexed[i]->GetAtomAt (x, y);
+	return found;
+}
+
+void MoleculeGrid::GetBonds (Bond *bond, vector < Bond * > &bonds)
+{
+	vector < pair < unsigned, Bond * > > found;
+	map < Bond *, BondEntry >::iterator i = m_Bonds.find (bond);
+	Box box;
+	bool indexed = (i != m_Bonds.end ())? (*i).second.indexed: GetBox (bond, box);
+	if (i != m_Bonds.end ())
+		box = (*i).second.box;
+	bonds.clear ();
+	if (!indexed) {
+		// the bond might cross any other one
+		for (i = m_Bonds.begin (); i != m_Bonds.end (); i++)
+			if ((*i).first != bond)
+				found.push_back (pair < unsigned, Bond * > ((*i).second.rank, (*i).first));
+	} else {
+		for (int x = box.x0; x <= box.x1; x++)
+			for (int y = box.y0; y <= box.y1; y++) {
+				map < pair < int, int >, Cell >::iterator c = m_Cells.find (pair < int, int > (x, y));
+				if (c == m_Cells.end ())
+					continue;
+				vector < Bond * > &cell = (*c).second.bonds;
+				for (unsigned j = 0; j < cell.size (); j++)
+					if (cell[j] != bond)
+						found.push_back (pair < unsigned, Bond * > (m_Bonds[cell[j]].rank, cell[j]));
+			}
+		for (unsigned j = 0; j < m_Unindexed.size (); j++)
+			if (m_Unindexed[j] != bond)
+				found.push_back (pair < unsigned, Bond * > (m_Bonds[m_Unindexed[j]].rank, m_Unindexed[j]));
+	}
+	sort (found.begin (), found.end ());
+	for (unsigned j = 0; j < found.size (); j++)
+		if (j == 0 || found[j].second != found[j - 1].second)
+			bonds.push_back (found[j].second);
+}
+
+}	//	namespace gcp
@@ -0,0 +1,146 @@
+// -*- C++ -*-
+
+/*
+ * GChemPaint library
+ * molecule-grid.h
+ *
+ * Copyright (C) 2026 Jean Bréfort <jean.brefort@normalesup.org>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301
+ * USA
+ */
+
+#ifndef GCHEMPAINT_MOLECULE_GRID_H
+#define GCHEMPAINT_MOLECULE_GRID_H
+
+#include <map>
+#include <vector>
+
+/*!\file*/
+
+namespace gcu {
+class Atom;
+class Object;
+}
+
+namespace gcp {
+
+class Bond;
+
+/*!\class MoleculeGrid gcp/molecule-grid.h
+\brief Spatial index of the bonds of a molecule.
+
+Bonds are stored in each square cell their bounding box overlaps, and their
+atoms in the cell which contains them, so that looking for an atom at a given
+position or for the bonds which might cross another one only needs to examine
+a few cells. Bonds ending on a fragment, which can move without notice, and
+very long bonds are not indexed and are always examined.
+
+The grid does not watch the atoms, MoveAtom() must be called each time an
+atom moves. gcp::Molecule does that for Atom::Move(), Atom::Transform2D(),
+Atom::SetCoords() and Atom::SetProperty().
+*/
+class MoleculeGrid
+{
+public:
+/*!
+@param size the size of the cells, typically the default bond length.
+*/
+	MoleculeGrid (double size);
+/*!
+The destructor.
+*/
+	~MoleculeGrid ();
+
+/*!
+@param bond a bond.
+
+Adds \a bond to the grid. The bonds are returned by GetBonds() in the order
+they were added.
+*/
+	void AddBond (Bond *bond);
+/*!
+@param bond a bond.
+
+Removes \a bond from the grid. Its atoms are removed too if no other bond in
+the grid uses them.
+*/
+	void RemoveBond (Bond *bond);
+/*!
+@param atom an atom which has moved.
+
+Updates the cell of \a atom and the cells of all its bonds.
+*/
+	void MoveAtom (gcu::Atom *atom);
+/*!
+@param bond a bond.
+
+Updates the cells of \a bond after its atoms have been set or replaced.
+*/
+	void UpdateBond (Bond *bond);
+/*!
+@param x the x coordinate.
+@param y the y coordinate.
+@param tolerance the maximum distance along each axis.
+@return the nearest bonded atom at the given position, or NULL.
+*/
+	gcu::Object *GetAtomAt (double x, double y, double tolerance) const;
+/*!
+@param bond a bond.
+@param bonds where to store the bonds.
+
+Gets the bonds which might cross \a bond, in the order they were added.
+\a bond itself is not included.
+*/
+	void GetBonds (Bond *bond, std::vector < Bond * > &bonds);
+
+private:
+	struct Box {
+		int x0, y0, x1, y1;
+	};
+	struct BondEntry {
+		Box box;
+		unsigned rank;
+		bool indexed;
+		gcu::Atom *atoms[2];
+	};
+	struct AtomEntry {
+		int x, y;
+		unsigned bonds;
+	};
+	struct Cell {
+		std::vector < gcu::Atom * > atoms;
+		std::vector < Bond * > bonds;
+	};
+
+	int GetCell (double coord) const;
+	bool GetBox (Bond *bond, Box &box) const;
+	void IndexBond (Bond *bond, BondEntry &entry);
+	void UnindexBond (Bond *bond, BondEntry &entry);
+	void AddAtom (gcu::Atom *atom);
+	void RemoveAtom (gcu::Atom *atom);
+
+private:
+	double m_Size;
+	unsigned m_NextRank;
+	std::map < std::pair < int, int >, Cell > m_Cells;
+	std::map < Bond *, BondEntry > m_Bonds;
+	std::map < gcu::Atom *, AtomEntry > m_Atoms;
+	std::vector < Bond * > m_Unindexed;
+};
+
+}	//	namespace gcp
+
+#endif	//	GCHEMPAINT_MOLECULE_GRID_H
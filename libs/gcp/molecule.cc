@@ -28,6 +28,7 @@
 #include "bond.h"
 #include "document.h"
 #include "molecule.h"
+#include "molecule-grid.h"
 #include "tool.h"
 #include "view.h"
 #include <gcugtk/stringdlg.h>
@@ -153,16 +154,19 @@ Molecule::Molecule (TypeId Type): gcugtk::Molecule (Type, gcu::ContentType2D)
 {
 	m_Alignment = NULL;
 	m_IsResidue = false;
+	m_Grid = NULL;
 }
 
 Molecule::Molecule (Atom* pAtom): gcugtk::Molecule (pAtom, gcu::ContentType2D)
 {
 	m_Alignment = NULL;
 	m_IsResidue = false;
+	m_Grid = NULL;
 }
 
 Molecule::~Molecule ()
 {
+	delete m_Grid;
 }
 
 void Molecule::AddChild (Object* object)
@@ -206,6 +210,8 @@ void Molecule::AddBond (gcu::Bond* pBond)
 	if (pBond->GetAtom (0) && pBond->GetAtom (1))
 		CheckCrossings (reinterpret_cast <Bond *> (pBond));
 	gcu::Molecule::AddBond (pBond);
+	if (m_Grid)
+		m_Grid->AddBond (reinterpret_cast <Bond *> (pBond));
 	EmitSignal (OnChangedSignal);
 }
 
@@ -217,6 +223,10 @@ void Molecule::Remove (Object* pObject)
 	case FragmentType:
 		m_Fragments.remove ((Fragment*) pObject);
 		break;
+	case gcu::BondType:
+		if (m_Grid)
+			m_Grid->RemoveBond ((Bond*) pObject);
+		// fall through
 	default:
 		gcu::Molecule::Remove (pObject);
 		break;
@@ -473,6 +483,7 @@ bool Molecule::Load (xmlNodePtr node)
 		AddBond ((Bond*) pObject);
 		if (!pObject->Load (child)) {
 			m_Bonds.remove ((Bond*) pObject);
+			ClearGrid ();
 			delete pObject;
 			return false;
 		}
@@ -517,6 +528,7 @@ bool Molecule::Load (xmlNodePtr node)
 
 void Molecule::Clear ()
 {
+	ClearGrid ();
 	m_Bonds.clear ();
 	m_Atoms.clear ();
 	m_Fragments.clear ();
@@ -533,13 +545,8 @@ void Molecule::Transform2D (Matrix2D& m, double x, double y)
 
 Object* Molecule::GetAtomAt (double x, double y, G_GNUC_UNUSED double z)
 {
-	// Make use of Bond::GetAtomAt
-	std::list<gcu::Bond*>::iterator n, end = m_Bonds.end ();
-	Object* pObj = NULL;
-	for (n = m_Bonds.begin(); n != end; n++)
-		if ((pObj = (*n)->GetAtomAt (x, y)))
-			break;
-	return pObj;
+	// same tolerance as Bond::GetAtomAt
+	return GetGrid ()->GetAtomAt (x, y, 10.);
 }
 
 double Molecule::GetYAlign () const
@@ -687,15 +694,47 @@ void Molecule::OpenCalc ()
 
 void Molecule::CheckCrossings (Bond *pBond)
 {
-	View *pView = reinterpret_cast<Document*> (GetDocument ())->GetView ();
-	list<gcu::Bond*>::iterator i, iend = m_Bonds.end ();
-	for (i = m_Bonds.begin (); i != iend; i++)
-		if (((*i) != pBond) && reinterpret_cast <Bond *> (*i)->IsCrossing (pBond)) {
+	Document *pDoc = dynamic_cast <Document*> (GetDocument ());
+	View *pView = (pDoc)? pDoc->GetView (): NULL;
+	MoleculeGrid *grid = GetGrid ();
+	// the bond atoms might have been set after it was added
+	grid->UpdateBond (pBond);
+	if (!pView)
+		return;
+	vector < Bond * > bonds;
+	grid->GetBonds (pBond, bonds);
+	vector < Bond * >::iterator i, iend = bonds.end ();
+	for (i = bonds.begin (); i != iend; i++)
+		if ((*i)->IsCrossing (pBond)) {
 			pView->Update (pBond);
 			pView->Update (*i);
 		}
 }
 
+void Molecule::AtomMoved (gcu::Atom *atom)
+{
+	if (m_Grid)
+		m_Grid->MoveAtom (atom);
+}
+
+MoleculeGrid *Molecule::GetGrid ()
+{
+	if (!m_Grid) {
+		Document *doc = dynamic_cast < Document * > (GetDocument ());
+		m_Grid = new MoleculeGrid ((doc && doc->GetBondLength () > 0.)? doc->GetBondLength (): 140.);
+		list < gcu::Bond * >::iterator i, iend = m_Bonds.end ();
+		for (i = m_Bonds.begin (); i != iend; i++)
+			m_Grid->AddBond (reinterpret_cast <Bond *> (*i));
+	}
+	return m_Grid;
+}
+
+void Molecule::ClearGrid ()
+{
+	delete m_Grid;
+	m_Grid = NULL;
+}
+
 std::string Molecule::GetRawFormula () const
 {
 	ostringstream ofs;
@@ -787,6 +826,7 @@ void Molecule::OnLoaded ()
 				m_Atoms.remove (*a);
 			for (b = new_mol->m_Bonds.begin (); b != bend; b++)
 				m_Bonds.remove (*b);
+			ClearGrid ();
 			for (f = new_mol->m_Fragments.begin (); f != fend; f++)
 				m_Fragments.remove (*f);
 			// clean connected atoms for the next round
@@ -38,6 +38,7 @@ class UIManager;
 namespace gcp {
 
 class Bond;
+class MoleculeGrid;
 
 /*!\class Molecule gcp/molecule.h
 \brief GChemPaint molecule class.
@@ -183,10 +184,20 @@ are not currently supported.
 @param pBond a bond in the molecule.
 
 Checks if any other bond in the molecule crosses \a pBond, and notify both bonds
-that they are crossing.
+that they are crossing. Nothing is notified if the molecule is not in a
+document with a view.
 */
 	void CheckCrossings (Bond *pBond);
 /*!
+@param atom an atom of the molecule which has moved.
+
+Updates the spatial index used by GetAtomAt() and CheckCrossings(). This is
+called by Atom::Move(), Atom::Transform2D(), Atom::SetCoords() and
+Atom::SetProperty(), other code changing the position of a bonded atom must
+call it.
+*/
+	void AtomMoved (gcu::Atom *atom);
+/*!
 @return the raw formula as a string. Molecules with fragments
 are not currently supported.
 */
@@ -219,11 +230,16 @@ Adds \a atom to the list of chiral atoms.
 */
 	bool AtomIsChiral (Atom *atom) const;
 
+private:
+	MoleculeGrid *GetGrid ();
+	void ClearGrid ();
+
 private:
 	std::list< Fragment * > m_Fragments;
 	std::set < Atom * > m_ChiralAtoms;
 	gcu::Object *m_Alignment;
 	bool m_IsResidue;
+	MoleculeGrid *m_Grid;
 };
 
 }	//	namespace gcp
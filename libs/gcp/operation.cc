@@ -24,9 +24,16 @@
 
 #include "config.h"
 #include "operation.h"
+#include "atom.h"
+#include "bond.h"
 #include "document.h"
+#include "molecule.h"
 #include "view.h"
+#include <gcu/matrix2d.h>
+#include <gcu/objprops.h>
 #include <cstring>
+#include <set>
+#include <typeinfo>
 
 using namespace gcu;
 
@@ -35,7 +42,9 @@ namespace gcp {
 xmlDocPtr pXmlDoc = xmlNewDoc ((const xmlChar*) "1.0"); // Needed to create xmlNodes
 
 Operation::Operation (gcp::Document* pDoc, unsigned long ID):
+	m_Nodes (NULL),
 	m_pDoc (pDoc),
+	m_Size (0),
 	m_ID (ID)
 {
 }
@@ -80,6 +89,145 @@ void Operation::AddNode (xmlNodePtr node, unsigned type)
 		xmlAddChild (m_Nodes[type], node);
 }
 
+size_t Operation::GetSize ()
+{
+	if (!m_Size)
+		m_Size = EvalSize ();
+	return m_Size;
+}
+
+size_t Operation::EvalSize () const
+{
+	size_t size = sizeof (Operation) + ((m_Nodes)? GetNodeSize (m_Nodes[0]): 0);
+	size += m_Atoms.capacity () * sizeof (AtomRecord) + m_Bonds.capacity () * sizeof (BondRecord);
+	std::vector < AtomRecord >::const_iterator i, iend = m_Atoms.end ();
+	for (i = m_Atoms.begin (); i != iend; i++)
+		size += (*i).Id.capacity () + (*i).ParentId.capacity ();
+	std::vector < BondRecord >::const_iterator j, jend = m_Bonds.end ();
+	for (j = m_Bonds.begin (); j != jend; j++)
+		size += (*j).Id.capacity () + (*j).Begin.capacity () + (*j).End.capacity ();
+	return size;
+}
+
+size_t Operation::GetNodeSize (xmlNodePtr node)
+{
+	if (!node)
+		return 0;
+	size_t size = sizeof (xmlNode);
+	if (node->name)
+		size += strlen (reinterpret_cast < char const * > (node->name)) + 1;
+	if (node->content)
+		size += strlen (reinterpret_cast < char const * > (node->content)) + 1;
+	for (xmlAttrPtr attr = node->properties; attr; attr = attr->next) {
+		size += sizeof (xmlAttr) + strlen (reinterpret_cast < char const * > (attr->name)) + 1;
+		size += GetNodeSize (attr->children);
+	}
+	for (xmlNodePtr child = node->children; child; child = child->next)
+		size += GetNodeSize (child);
+	return size;
+}
+
+bool Operation::AddRecord (Object* pObject)
+{
+	if (!pObject->GetId () || !pObject->GetParent () || !pObject->GetParent ()->GetId ())
+		return false;
+	if (typeid (*pObject) == typeid (Atom)) {
+		Atom *atom = static_cast < Atom * > (pObject);
+		if (atom->HasChildren () || (atom->GetZ () == 6 && atom->GetShowSymbol ()) ||
+		    atom->GetHPosStyle () != AUTO_HPOS || !atom->GetShowCharge () ||
+		    (atom->GetCharge () && atom->GetChargePosition (NULL, NULL) != -1))
+			return false;
+		AtomRecord record;
+		record.Id = atom->GetId ();
+		record.ParentId = atom->GetParent ()->GetId ();
+		record.Z = atom->GetZ ();
+		record.Charge = atom->GetCharge ();
+		atom->GetCoords (&record.x, &record.y, &record.z);
+		m_Atoms.push_back (record);
+		return true;
+	}
+	if (typeid (*pObject) == typeid (Bond)) {
+		Bond *bond = static_cast < Bond * > (pObject);
+		gcu::Atom *begin = bond->GetAtom (0), *end = bond->GetAtom (1);
+		if (!begin || !end || bond->GetType () == NewmanBondType ||
+		    bond->GetProperty (GCU_PROP_BOND_LEVEL) != "0")
+			return false;
+		BondRecord record;
+		record.Id = bond->GetId ();
+		record.Begin = begin->GetId ();
+		record.End = end->GetId ();
+		record.Order = bond->GetOrder ();
+		record.Type = bond->GetType ();
+		record.DoublePosition = bond->GetDoublePosition ();
+		m_Bonds.push_back (record);
+		return true;
+	}
+	return false;
+}
+
+void Operation::AddRecordedAtoms ()
+{
+	View *view = m_pDoc->GetView ();
+	std::vector < AtomRecord >::iterator i, end = m_Atoms.end ();
+	for (i = m_Atoms.begin (); i != end; i++) {
+		Atom *atom = new Atom ((*i).Z, (*i).x, (*i).y, (*i).z);
+		atom->SetId ((*i).Id.c_str ());
+		if ((*i).Charge)
+			atom->SetCharge ((*i).Charge);
+		if (m_pDoc->GetDescendant ((*i).ParentId.c_str ()))
+			// the molecule Id has been reused when the atom bonds were removed
+			m_pDoc->AddAtom (atom);
+		else {
+			Molecule *mol = new Molecule ();
+			mol->SetId ((*i).ParentId.c_str ());
+			m_pDoc->AddChild (mol);
+			mol->AddAtom (atom);
+			if (view->GetCanvas ())
+				view->AddObject (atom);
+		}
+		atom->Update ();
+	}
+	view->EnsureSize ();
+}
+
+void Operation::AddRecordedBonds ()
+{
+	View *view = m_pDoc->GetView ();
+	std::vector < BondRecord >::iterator i, end = m_Bonds.end ();
+	for (i = m_Bonds.begin (); i != end; i++) {
+		Atom *begin = dynamic_cast < Atom * > (m_pDoc->GetDescendant ((*i).Begin.c_str ())),
+			*last = dynamic_cast < Atom * > (m_pDoc->GetDescendant ((*i).End.c_str ()));
+		if (!begin || !last)
+			continue;
+		Bond *bond = new Bond (begin, last, (*i).Order);
+		bond->SetId ((*i).Id.c_str ());
+		bond->SetType (static_cast < BondType > ((*i).Type));
+		bond->SetDoublePosition (static_cast < DoubleBondPosition > ((*i).DoublePosition));
+		m_pDoc->AddBond (bond);
+		begin->Update ();
+		last->Update ();
+		view->Update (begin);
+		view->Update (last);
+	}
+	view->EnsureSize ();
+}
+
+void Operation::DeleteRecordedAtoms ()
+{
+	std::vector < AtomRecord >::iterator i, end = m_Atoms.end ();
+	for (i = m_Atoms.begin (); i != end; i++)
+		m_pDoc->Remove ((*i).Id.c_str ());
+	m_pDoc->GetView ()->EnsureSize ();
+}
+
+void Operation::DeleteRecordedBonds ()
+{
+	std::vector < BondRecord >::iterator i, end = m_Bonds.end ();
+	for (i = m_Bonds.begin (); i != end; i++)
+		m_pDoc->Remove ((*i).Id.c_str ());
+	m_pDoc->GetView ()->EnsureSize ();
+}
+
 AddOperation::AddOperation (gcp::Document* pDoc, unsigned long ID):  Operation(pDoc, ID)
 {
 	m_Nodes = new xmlNodePtr[1];
@@ -96,12 +244,24 @@ AddOperation::~AddOperation ()
 
 void AddOperation::Undo ()
 {
-	Delete ();
+	DeleteRecordedBonds ();
+	if (HasNodes ())
+		Delete ();
+	DeleteRecordedAtoms ();
 }
 
 void AddOperation::Redo ()
 {
-	Add ();
+	AddRecordedAtoms ();
+	if (HasNodes ())
+		Add ();
+	AddRecordedBonds ();
+}
+
+void AddOperation::AddObject (Object* pObject, unsigned type)
+{
+	if (!AddRecord (pObject))
+		Operation::AddObject (pObject, type);
 }
 
 DeleteOperation::DeleteOperation (gcp::Document* pDoc, unsigned long ID): Operation (pDoc, ID)
@@ -120,12 +280,24 @@ DeleteOperation::~DeleteOperation ()
 
 void DeleteOperation::Undo ()
 {
-	Add ();
+	AddRecordedAtoms ();
+	if (HasNodes ())
+		Add ();
+	AddRecordedBonds ();
 }
 
 void DeleteOperation::Redo ()
 {
-	Delete ();
+	DeleteRecordedBonds ();
+	if (HasNodes ())
+		Delete ();
+	DeleteRecordedAtoms ();
+}
+
+void DeleteOperation::AddObject (Object* pObject, unsigned type)
+{
+	if (!AddRecord (pObject))
+		Operation::AddObject (pObject, type);
 }
 
 ModifyOperation::ModifyOperation (gcp::Document* pDoc, unsigned long ID): Operation (pDoc, ID)
@@ -161,4 +333,265 @@ void ModifyOperation::Redo ()
 	Add (1);
 }
 
+size_t ModifyOperation::EvalSize () const
+{
+	return Operation::EvalSize () + GetNodeSize (m_Nodes[1]);
+}
+
+TransformOperation::TransformOperation (gcp::Document* pDoc, unsigned long ID):
+	Operation (pDoc, ID),
+	m_x (0.),
+	m_y (0.),
+	m_dx (0.),
+	m_dy (0.),
+	m_Transformed (false)
+{
+}
+
+TransformOperation::~TransformOperation ()
+{
+}
+
+void TransformOperation::Undo ()
+{
+	// the operation is the last one applied to the objects, so they are where
+	// the operation left them
+	if (m_After.empty () && !m_Before.empty ()) {
+		Document *doc = GetDocument ();
+		m_After.reserve (m_Before.size ());
+		std::vector < AtomPosition >::iterator i, end = m_Before.end ();
+		for (i = m_Before.begin (); i != end; i++) {
+			AtomPosition pos;
+			gcu::Atom *atom = dynamic_cast < gcu::Atom * > (doc->GetDescendant ((*i).Id.c_str ()));
+			if (!atom)
+				continue;
+			pos.Id = (*i).Id;
+			atom->GetCoords (&pos.x, &pos.y, &pos.z);
+			m_After.push_back (pos);
+		}
+	}
+	Apply (true);
+}
+
+void TransformOperation::Redo ()
+{
+	Apply (false);
+}
+
+void TransformOperation::AddObject (Object* pObject, unsigned type)
+{
+	if (type == 0 && pObject->GetId ()) {
+		m_Ids.push_back (pObject->GetId ());
+		SavePositions (pObject);
+	}
+}
+
+void TransformOperation::SavePositions (Object *obj)
+{
+	gcu::Atom *atom = dynamic_cast < gcu::Atom * > (obj);
+	// atoms inside fragments move with them
+	if (atom && dynamic_cast < Molecule * > (atom->GetParent ()) && atom->GetId ()) {
+		AtomPosition pos;
+		pos.Id = atom->GetId ();
+		atom->GetCoords (&pos.x, &pos.y, &pos.z);
+		m_Before.push_back (pos);
+		return;
+	}
+	std::map < std::string, Object * >::iterator i;
+	for (Object *child = obj->GetFirstChild (i); child; child = obj->GetNextChild (i))
+		SavePositions (child);
+}
+
+void TransformOperation::AddNode (xmlNodePtr node, G_GNUC_UNUSED unsigned type)
+{
+	if (node)
+		xmlFreeNode (node);
+}
+
+void TransformOperation::Translate (double dx, double dy)
+{
+	m_dx += dx;
+	m_dy += dy;
+}
+
+void TransformOperation::SetTransform (double x11, double x12, double x21, double x22, double x, double y)
+{
+	double det = x11 * x22 - x12 * x21;
+	m_Matrix[0] = x11;
+	m_Matrix[1] = x12;
+	m_Matrix[2] = x21;
+	m_Matrix[3] = x22;
+	m_Inverse[0] = x22 / det;
+	m_Inverse[1] = -x12 / det;
+	m_Inverse[2] = -x21 / det;
+	m_Inverse[3] = x11 / det;
+	m_x = x;
+	m_y = y;
+	m_Transformed = true;
+}
+
+void TransformOperation::SetRotation (double angle, double x, double y)
+{
+	// get the matrix components from the images of the base vectors
+	Matrix2D m (angle);
+	double x11 = 1., x21 = 0., x12 = 0., x22 = 1.;
+	m.Transform (x11, x21);
+	m.Transform (x12, x22);
+	SetTransform (x11, x12, x21, x22, x, y);
+}
+
+size_t TransformOperation::EvalSize () const
+{
+	size_t size = sizeof (TransformOperation) + m_Ids.capacity () * sizeof (std::string);
+	std::vector < std::string >::const_iterator i, end = m_Ids.end ();
+	for (i = m_Ids.begin (); i != end; i++)
+		size += (*i).capacity ();
+	// the positions after the operation will be saved too
+	size += 2 * m_Before.capacity () * sizeof (AtomPosition);
+	std::vector < AtomPosition >::const_iterator j, jend = m_Before.end ();
+	for (j = m_Before.begin (); j != jend; j++)
+		size += 2 * (*j).Id.capacity ();
+	return size;
+}
+
+void TransformOperation::Apply (bool undo)
+{
+	Document *doc = GetDocument ();
+	View *view = doc->GetView ();
+	double const *c = (undo)? m_Inverse: m_Matrix;
+	Matrix2D m (c[0], c[1], c[2], c[3]);
+	std::set < Molecule * > molecules;
+	std::vector < std::string >::iterator i, end = m_Ids.end ();
+	for (i = m_Ids.begin (); i != end; i++) {
+		Object *obj = doc->GetDescendant ((*i).c_str ());
+		if (!obj)
+			continue;
+		if (undo) {
+			if (m_dx != 0. || m_dy != 0.)
+				obj->Move (-m_dx, -m_dy);
+			if (m_Transformed)
+				obj->Transform2D (m, m_x, m_y);
+		} else {
+			if (m_Transformed)
+				obj->Transform2D (m, m_x, m_y);
+			if (m_dx != 0. || m_dy != 0.)
+				obj->Move (m_dx, m_dy);
+		}
+		// objects inside a molecule, such as atoms, need their bonds to be updated
+		Molecule *mol = dynamic_cast < Molecule * > (obj->GetParent ());
+		if (mol)
+			molecules.insert (mol);
+		else
+			view->Update (obj);
+	}
+	// put the atoms back exactly where they were, the transforms are not exact
+	std::vector < AtomPosition > &positions = (undo)? m_Before: m_After;
+	std::vector < AtomPosition >::iterator p, pend = positions.end ();
+	for (p = positions.begin (); p != pend; p++) {
+		gcu::Atom *atom = dynamic_cast < gcu::Atom * > (doc->GetDescendant ((*p).Id.c_str ()));
+		if (atom)
+			atom->SetCoords ((*p).x, (*p).y, (*p).z);
+	}
+	std::set < Molecule * >::iterator j, jend = molecules.end ();
+	for (j = molecules.begin (); j != jend; j++) {
+		std::list < gcu::Bond * >::const_iterator b;
+		Bond const *bond = static_cast < Bond const * > ((*j)->GetFirstBond (b));
+		while (bond) {
+			const_cast < Bond * > (bond)->SetDirty ();
+			bond = static_cast < Bond const * > ((*j)->GetNextBond (b));
+		}
+		view->Update (*j);
+	}
+	view->EnsureSize ();
+}
+
+PropertyOperation::PropertyOperation (gcp::Document* pDoc, unsigned long ID):
+	Operation (pDoc, ID),
+	m_AfterSaved (false)
+{
+}
+
+PropertyOperation::~PropertyOperation ()
+{
+}
+
+void PropertyOperation::Undo ()
+{
+	// the operation is the last one applied to the objects, so they have the
+	// values set by the operation
+	if (!m_AfterSaved) {
+		Document *doc = GetDocument ();
+		std::vector < PropertyChange >::iterator i, end = m_Changes.end ();
+		for (i = m_Changes.begin (); i != end; i++) {
+			Object *obj = doc->GetDescendant ((*i).Id.c_str ());
+			(*i).After = (obj)? obj->GetProperty ((*i).Property): (*i).Before;
+		}
+		m_AfterSaved = true;
+	}
+	Apply (true);
+}
+
+void PropertyOperation::Redo ()
+{
+	Apply (false);
+}
+
+void PropertyOperation::AddObject (G_GNUC_UNUSED Object* pObject, G_GNUC_UNUSED unsigned type)
+{
+}
+
+void PropertyOperation::AddNode (xmlNodePtr node, G_GNUC_UNUSED unsigned type)
+{
+	if (node)
+		xmlFreeNode (node);
+}
+
+void PropertyOperation::AddProperty (Object *pObject, unsigned property)
+{
+	if (!pObject->GetId ())
+		return;
+	PropertyChange change;
+	change.Id = pObject->GetId ();
+	change.Property = property;
+	change.Before = pObject->GetProperty (property);
+	m_Changes.push_back (change);
+}
+
+size_t PropertyOperation::EvalSize () const
+{
+	size_t size = sizeof (PropertyOperation) + m_Changes.capacity () * sizeof (PropertyChange);
+	std::vector < PropertyChange >::const_iterator i, end = m_Changes.end ();
+	for (i = m_Changes.begin (); i != end; i++)
+		// the value after the operation should have about the same size
+		size += (*i).Id.capacity () + 2 * (*i).Before.capacity ();
+	return size;
+}
+
+void PropertyOperation::Apply (bool undo)
+{
+	Document *doc = GetDocument ();
+	View *view = doc->GetView ();
+	size_t n, max = m_Changes.size ();
+	for (n = 0; n < max; n++) {
+		// a property might be modified several times, so undo in reverse order
+		PropertyChange &change = m_Changes[(undo)? max - n - 1: n];
+		Object *obj = doc->GetDescendant (change.Id.c_str ());
+		if (!obj)
+			continue;
+		obj->SetProperty (change.Property, ((undo)? change.Before: change.After).c_str ());
+		Atom *atom = dynamic_cast < Atom * > (obj);
+		if (atom) {
+			atom->Update ();
+			std::map < gcu::Bondable *, gcu::Bond * >::iterator b;
+			Bond *bond = static_cast < Bond * > (atom->GetFirstBond (b));
+			while (bond) {
+				bond->SetDirty ();
+				view->Update (bond);
+				bond = static_cast < Bond * > (atom->GetNextBond (b));
+			}
+		}
+		view->Update (obj);
+	}
+}
+
 } // namespace gcp
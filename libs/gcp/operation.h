@@ -28,6 +28,8 @@
 
 #include <gcu/macros.h>
 #include <gcu/object.h>
+#include <string>
+#include <vector>
 
 /*!\file*/
 namespace gcp {
@@ -52,6 +54,14 @@ Object deletion operation, see the DeleteOperation class.
 Object modification operation, see the ModifyOperation class.
 */
 	GCP_MODIFY_OPERATION,
+/*!
+Objects translation or linear transform, see the TransformOperation class.
+*/
+	GCP_TRANSFORM_OPERATION,
+/*!
+Objects properties modification, see the PropertyOperation class.
+*/
+	GCP_PROPERTY_OPERATION,
 } OperationType;
 
 /*!\class Operation gcp/operation.h
@@ -115,6 +125,13 @@ Adds the node to the document owning the operation. This might be used when
 Objects are not available such as when editing text.
 */
 	virtual void AddNode (xmlNodePtr node, unsigned type = 0);
+/*!
+@return an estimate of the memory used by the operation, in bytes. The value
+is evaluated on the first call, so this should not be called before the
+operation is complete. It is used by the Document to limit the memory used by
+the undo and redo stacks, see UndoBudget.
+*/
+	size_t GetSize ();
 
 protected:
 /*!
@@ -137,6 +154,58 @@ state of the objects after the operation.
 Deletes the stored objects to the document owning the operation.
 */
 	void Delete (unsigned type = 0);
+/*!
+Evaluates the memory used by the operation. The default implementation
+evaluates the size of the first xml node.
+@return the size in bytes.
+*/
+	virtual size_t EvalSize () const;
+/*!
+@param node an xml node.
+@return an estimate of the memory used by \a node and its descendants.
+*/
+	static size_t GetNodeSize (xmlNodePtr node);
+/*!
+@return the document owning the operation.
+*/
+	Document *GetDocument () const {return m_pDoc;}
+/*!
+@param pObject an Object.
+
+Stores \a pObject as a compact record instead of an xml node, if it is a
+gcp::Atom or a gcp::Bond which can be rebuilt from its Id, its parent Id, its
+element, position and charge, or its atoms, order and type. Atoms with
+children, such as electrons, or with a non default display of their symbol,
+charge or hydrogens, derived classes, and any other object are not recorded.
+@return true if \a pObject has been recorded.
+*/
+	bool AddRecord (gcu::Object *pObject);
+/*!
+Adds the recorded atoms to the document, each in a new molecule which gets the
+Id of its former molecule if that Id is not used.
+*/
+	void AddRecordedAtoms ();
+/*!
+Adds the recorded bonds to the document, the atoms they join must exist.
+*/
+	void AddRecordedBonds ();
+/*!
+Removes the recorded atoms from the document.
+*/
+	void DeleteRecordedAtoms ();
+/*!
+Removes the recorded bonds from the document.
+*/
+	void DeleteRecordedBonds ();
+/*!
+@return true if the operation has recorded atoms or bonds.
+*/
+	bool HasRecords () const {return !m_Atoms.empty () || !m_Bonds.empty ();}
+/*!
+@param type a number indicationg the role of the stored objects.
+@return true if some objects have been saved to xml for \a type.
+*/
+	bool HasNodes (unsigned type = 0) const {return m_Nodes && m_Nodes[type] && m_Nodes[type]->children;}
 
 protected:
 /*!
@@ -145,7 +214,21 @@ The xml nodes storing the changes.
 	xmlNodePtr* m_Nodes;
 
 private:
+	struct AtomRecord {
+		std::string Id, ParentId;
+		int Z, Charge;
+		double x, y, z;
+	};
+	struct BondRecord {
+		std::string Id, Begin, End;
+		unsigned char Order;
+		int Type, DoublePosition;
+	};
+
 	gcp::Document* m_pDoc;
+	size_t m_Size;
+	std::vector < AtomRecord > m_Atoms;
+	std::vector < BondRecord > m_Bonds;
 
 GCU_RO_PROP (unsigned long, ID);
 };
@@ -174,6 +257,14 @@ Undo the additions represented by this operation.
 Redo the additions represented by this operation.
 */
 	void Redo ();
+/*!
+@param pObject an added Object.
+@param type unused.
+
+Records \a pObject as a compact record when possible, see
+Operation::AddRecord(), or saves it to xml.
+*/
+	void AddObject (gcu::Object* pObject, unsigned type = 0);
 };
 
 /*!\class DeleteOperation gcp/operation.h
@@ -200,6 +291,14 @@ Undo the deletions represented by this operation.
 Redo the deletions represented by this operation.
 */
 	void Redo ();
+/*!
+@param pObject a deleted Object.
+@param type unused.
+
+Records \a pObject as a compact record when possible, see
+Operation::AddRecord(), or saves it to xml.
+*/
+	void AddObject (gcu::Object* pObject, unsigned type = 0);
 };
 
 /*!\class ModifyOperation gcp/operation.h
@@ -226,6 +325,191 @@ Undo the modifications represented by this operation.
 Redo the modifications represented by this operation.
 */
 	void Redo ();
+
+protected:
+	size_t EvalSize () const;
+};
+
+/*!\class TransformOperation gcp/operation.h
+Operation class representing the translation or the linear transform of a set
+of objects, such as when moving, rotating or flipping the selection. Only the
+objects Ids and the transform parameters are stored, nothing is serialized, so
+that undoing and redoing only need to apply the inverse or the direct transform
+to the objects, using gcu::Object::Transform2D() and gcu::Object::Move().
+The positions of the atoms of the objects are saved too, and restored exactly
+after the transform, so that undoing and redoing many times does not make them
+drift. The positions after the operation are saved on the first call to Undo().
+
+The objects must be added with type 0 before the operation is finished, and
+calls with other types are ignored, so that code written for ModifyOperation
+still works. The transform is applied first, then the translation.
+\code
+	Operation *op = doc->GetNewOperation (GCP_TRANSFORM_OPERATION);
+	op->AddObject (obj);
+	obj->Move (dx, dy);
+	static_cast < TransformOperation * > (op)->Translate (dx, dy);
+	doc->FinishOperation ();
+\endcode
+*/
+class TransformOperation: public Operation
+{
+public:
+/*!
+@param pDoc a document.
+@param ID a unique operation ID for the document and the session.
+
+Creates a new TransformOperation. Operations should always created by calls to
+Document::GetNewOperation().
+*/
+	TransformOperation (gcp::Document *pDoc, unsigned long ID);
+	virtual ~TransformOperation ();
+
+/*!
+Applies the inverse translation and transform to the objects.
+*/
+	void Undo ();
+/*!
+Applies the transform and translation to the objects again.
+*/
+	void Redo ();
+/*!
+@param pObject a transformed Object.
+@param type must be 0, other values are ignored.
+
+Adds the Id of \a pObject to the operation, and saves the positions of the
+atoms it contains.
+*/
+	void AddObject (gcu::Object* pObject, unsigned type = 0);
+/*!
+@param node an xml node.
+@param type unused.
+
+Xml nodes are not supported by this class, so \a node is just freed.
+*/
+	void AddNode (xmlNodePtr node, unsigned type = 0);
+
+/*!
+@param dx the horizontal translation.
+@param dy the vertical translation.
+
+Adds (\a dx, \a dy) to the translation of the objects.
+*/
+	void Translate (double dx, double dy);
+/*!
+@param x11 value at first line and first column of the matrix.
+@param x12 value at first line and second column of the matrix.
+@param x21 value at second line and first column of the matrix.
+@param x22 value at second line and second column of the matrix.
+@param x the horizontal position of the transform center.
+@param y the vertical position of the transform center.
+
+Sets the linear transform applied to the objects, as passed to
+gcu::Object::Transform2D(). The matrix must be invertible.
+*/
+	void SetTransform (double x11, double x12, double x21, double x22, double x, double y);
+/*!
+@param angle the rotation angle in degrees.
+@param x the horizontal position of the rotation center.
+@param y the vertical position of the rotation center.
+
+Sets the transform to a rotation, as when using gcu::Matrix2D (\a angle).
+*/
+	void SetRotation (double angle, double x, double y);
+
+protected:
+	size_t EvalSize () const;
+
+private:
+	struct AtomPosition {
+		std::string Id;
+		double x, y, z;
+	};
+
+	void Apply (bool undo);
+	void SavePositions (gcu::Object *obj);
+
+private:
+	std::vector < std::string > m_Ids;
+	std::vector < AtomPosition > m_Before, m_After;
+	double m_Matrix[4], m_Inverse[4];
+	double m_x, m_y, m_dx, m_dy;
+	bool m_Transformed;
+};
+
+/*!\class PropertyOperation gcp/operation.h
+Operation class representing the modification of some properties of objects,
+such as the element of an atom. Only the objects Ids and the property values
+are stored, as returned by gcu::Object::GetProperty(), and undoing and redoing
+pass them to gcu::Object::SetProperty().
+
+Properties must be added before they are modified, their new values are saved
+on the first call to Undo().
+\code
+	Operation *op = doc->GetNewOperation (GCP_PROPERTY_OPERATION);
+	static_cast < PropertyOperation * > (op)->AddProperty (atom, GCU_PROP_ATOM_Z);
+	atom->SetZ (Z);
+	doc->FinishOperation ();
+\endcode
+*/
+class PropertyOperation: public Operation
+{
+public:
+/*!
+@param pDoc a document.
+@param ID a unique operation ID for the document and the session.
+
+Creates a new PropertyOperation. Operations should always created by calls to
+Document::GetNewOperation().
+*/
+	PropertyOperation (gcp::Document *pDoc, unsigned long ID);
+	virtual ~PropertyOperation ();
+
+/*!
+Restores the properties values as they were before the operation.
+*/
+	void Undo ();
+/*!
+Restores the properties values as they were after the operation.
+*/
+	void Redo ();
+/*!
+@param pObject an Object.
+@param type unused.
+
+Objects are not supported by this class, use AddProperty() instead.
+*/
+	void AddObject (gcu::Object* pObject, unsigned type = 0);
+/*!
+@param node an xml node.
+@param type unused.
+
+Xml nodes are not supported by this class, so \a node is just freed.
+*/
+	void AddNode (xmlNodePtr node, unsigned type = 0);
+/*!
+@param pObject an Object.
+@param property the property which will be modified, one of the GCU_PROP_*
+values.
+
+Saves the current value of \a property for \a pObject.
+*/
+	void AddProperty (gcu::Object *pObject, unsigned property);
+
+protected:
+	size_t EvalSize () const;
+
+private:
+	struct PropertyChange {
+		std::string Id;
+		unsigned Property;
+		std::string Before, After;
+	};
+
+	void Apply (bool undo);
+
+private:
+	std::vector < PropertyChange > m_Changes;
+	bool m_AfterSaved;
 };
 
 }	// namespace gcp
@@ -32,6 +32,7 @@ GOColor DeleteColor = GO_COLOR_RED;
 GOColor AddColor = GO_COLOR_GREEN;
 GOColor SelectColor = GO_COLOR_CYAN;
 unsigned MaxStackSize = 0;//infinite size authorized for undo:redo stacks
+unsigned UndoBudget = 128;
 bool MergeAtoms = true;
 int CompressionLevel = 0;
 bool TearableMendeleiev = false;
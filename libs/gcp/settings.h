@@ -54,6 +54,11 @@ The stack size for undo/redo operations. Default is no limit.
 */
 extern unsigned MaxStackSize;
 /*!
+The memory available for the undo stack of each document, in megabytes. The
+oldest operations are deleted when it is exceeded. 0 means no limit.
+*/
+extern unsigned UndoBudget;
+/*!
 Whether to use existing atoms or create new one at the same place when
 adding bonds.
 */
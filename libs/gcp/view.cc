@@ -897,6 +897,8 @@ GdkPixbuf *View::BuildPixbuf (int resolution, bool transparent)
 
 void View::EnsureSize ()
 {
+	if (!m_Canvas)
+		return;
 	double x1, y1, x2, y2;
 	m_Canvas->GetRoot ()->GetBounds (x1, y1, x2, y2);
 	if (x1 < 0.) x2 -= x1;
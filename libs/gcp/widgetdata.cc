@@ -328,14 +328,16 @@ void WidgetData::MoveSelection (double dx, double dy)
 		return;
 	std::set < Object * >::iterator i, end = SelectedObjects.end ();
 	Document* pDoc = m_View->GetDoc ();
-	Operation* pOp = pDoc-> GetNewOperation (GCP_MODIFY_OPERATION);
+	TransformOperation* pOp = static_cast < TransformOperation * > (pDoc-> GetNewOperation (GCP_TRANSFORM_OPERATION));
 	Theme *pTheme = pDoc->GetTheme ();
+	dx /= pTheme->GetZoomFactor ();
+	dy /= pTheme->GetZoomFactor ();
 	for (i = SelectedObjects.begin (); i != end; i++) {
-		pOp->AddObject (*i,0);
-		(*i)->Move (dx / pTheme->GetZoomFactor (), dy / pTheme->GetZoomFactor ());
+		pOp->AddObject (*i);
+		(*i)->Move (dx, dy);
 		m_View->Update (*i);
-		pOp->AddObject (*i,1);
 	}
+	pOp->Translate (dx, dy);
 	pDoc->FinishOperation ();
 }
 
@@ -101,7 +101,7 @@ void AtomsDlgPrivate::AddRow (AtomsDlg *pBox)
 		pBox->m_Atoms.resize (max_row + 10);
 	pBox->m_Atoms[new_row] = new_atom;
 	pBox->m_pDoc->GetAtomList ()->push_back (new_atom);
-	pBox->m_pDoc->Update ();
+	pBox->m_pDoc->QueueUpdate ();
 	pBox->m_pDoc->SetDirty (true);
 	gtk_widget_set_sensitive (pBox->DeleteAllBtn, true);
 }
@@ -112,7 +112,7 @@ void AtomsDlgPrivate::DeleteRow (AtomsDlg *pBox)
 	delete pBox->m_Atoms[pBox->m_AtomSelected];
 	pBox->m_Atoms.erase (pBox->m_Atoms.begin () + pBox->m_AtomSelected);
 	gcr_grid_delete_row (GCR_GRID (pBox->m_Grid), pBox->m_AtomSelected);
-	pBox->m_pDoc->Update ();
+	pBox->m_pDoc->QueueUpdate ();
 	pBox->m_pDoc->SetDirty (true);
 	gtk_widget_set_sensitive (pBox->DeleteAllBtn, !pBox->m_pDoc->GetAtomList ()->empty ());
 }
@@ -124,7 +124,7 @@ void AtomsDlgPrivate::DeleteAll (AtomsDlg *pBox)
 		delete pBox->m_Atoms[i];
 	pBox->m_Atoms.clear ();
 	pBox->m_pDoc->GetAtomList ()->clear ();
-	pBox->m_pDoc->Update ();
+	pBox->m_pDoc->QueueUpdate ();
 	pBox->m_pDoc->SetDirty (true);
 	gtk_widget_set_sensitive (pBox->DeleteAllBtn, false);
 }
@@ -155,7 +155,7 @@ void AtomsDlgPrivate::ValueChanged (AtomsDlg *pBox, unsigned row, unsigned colum
 		pBox->m_Atoms[pBox->m_AtomSelected]->z () = coord;
 		break;
 	}
-	pBox->m_pDoc->Update ();
+	pBox->m_pDoc->QueueUpdate ();
 	pBox->m_pDoc->SetDirty (true);
 }
 
@@ -238,7 +238,7 @@ void AtomsDlgPrivate::ElementChanged (AtomsDlg *pBox, unsigned Z)
 	}
 	if (pBox->m_AtomSelected >= 0) {
 		gcr_grid_for_each_selected (pBox->m_Grid, reinterpret_cast < GridCb > (SetElement), pBox);
-		pBox->m_pDoc->Update ();
+		pBox->m_pDoc->QueueUpdate ();
 		pBox->m_pDoc->SetDirty (true);
 	}
 }
@@ -253,7 +253,7 @@ void AtomsDlgPrivate::ColorSet (GtkColorChooser *btn, AtomsDlg *pBox)
 	if (pBox->m_AtomSelected >= 0) {
 		gtk_color_chooser_get_rgba (btn, &pBox->m_RGBA);
 		gcr_grid_for_each_selected (pBox->m_Grid, reinterpret_cast < GridCb > (SetColor), pBox);
-		pBox->m_pDoc->Update ();
+		pBox->m_pDoc->QueueUpdate ();
 		pBox->m_pDoc->SetDirty (true);
 	}
 }
@@ -288,7 +288,7 @@ void AtomsDlgPrivate::ChargeChanged (GtkSpinButton *btn, AtomsDlg *pBox)
 	pBox->PopulateRadiiMenu ();
 	if (pBox->m_AtomSelected >= 0) {
 		gcr_grid_for_each_selected (pBox->m_Grid, reinterpret_cast < GridCb > (SetCharge), pBox);
-		pBox->m_pDoc->Update ();
+		pBox->m_pDoc->QueueUpdate ();
 		pBox->m_pDoc->SetDirty (true);
 	}
 }
@@ -342,7 +342,7 @@ void AtomsDlgPrivate::RadiusTypeChanged (GtkComboBox *menu, AtomsDlg *pBox)
 	pBox->PopulateRadiiMenu ();
 	if (pBox->m_AtomSelected >= 0) {
 		gcr_grid_for_each_selected (pBox->m_Grid, reinterpret_cast < GridCb > (SetRadius), pBox);
-		pBox->m_pDoc->Update ();
+		pBox->m_pDoc->QueueUpdate ();
 		pBox->m_pDoc->SetDirty (true);
 	}
 }
@@ -366,7 +366,7 @@ void AtomsDlgPrivate::RadiusIndexChanged (GtkComboBox *menu, AtomsDlg *pBox)
 	}
 	if (pBox->m_AtomSelected >= 0) {
 		gcr_grid_for_each_selected (pBox->m_Grid, reinterpret_cast < GridCb > (SetRadius), pBox);
-		pBox->m_pDoc->Update ();
+		pBox->m_pDoc->QueueUpdate ();
 		pBox->m_pDoc->SetDirty (true);
 	}
 }
@@ -381,7 +381,7 @@ bool AtomsDlgPrivate::RadiusEdited (AtomsDlg *pBox)
 	g_signal_handler_block (pBox->AtomR, pBox->m_EntryFocusOutSignalID);
 	if (pBox->GetNumber (pBox->AtomR, &(pBox->m_Radius.value.value), gcugtk::Min, 0) && pBox->m_AtomSelected >= 0) {
 		gcr_grid_for_each_selected (pBox->m_Grid, reinterpret_cast < GridCb > (SetRadius), pBox);
-		pBox->m_pDoc->Update ();
+		pBox->m_pDoc->QueueUpdate ();
 		pBox->m_pDoc->SetDirty (true);
 	}
 	g_signal_handler_unblock (pBox->AtomR, pBox->m_EntryFocusOutSignalID);
@@ -398,7 +398,7 @@ void AtomsDlgPrivate::RadiusScaleChanged (GtkSpinButton *btn, AtomsDlg *pBox)
 	pBox->m_Ratio = gtk_spin_button_get_value (btn) / 100.;
 	if (pBox->m_AtomSelected >= 0) {
 		gcr_grid_for_each_selected (pBox->m_Grid, reinterpret_cast < GridCb > (SetRadiusScale), pBox);
-		pBox->m_pDoc->Update ();
+		pBox->m_pDoc->QueueUpdate ();
 		pBox->m_pDoc->SetDirty (true);
 	}
 }
@@ -431,12 +431,8 @@ AtomsDlg::AtomsDlg (Application *App, Document* pDoc): gcugtk::Dialog (App, UIDI
 	g_signal_connect_swapped (G_OBJECT (m_Grid), "value-changed", G_CALLBACK (AtomsDlgPrivate::ValueChanged), this);
 	m_nElt = 0;
 	m_AtomSelected = -1;
-	gcr::AtomList* Atoms = m_pDoc->GetAtomList ();
-	m_Atoms.resize ((Atoms->size () / 10 + 1) * 10);
-	list < gcr::Atom * >::iterator i, end = Atoms->end ();
-	for (i = Atoms->begin (); i != end; i++)
-		m_Atoms[gcr_grid_append_row (m_Grid, ((*i)->GetZ () > 0)? Element::Symbol ((*i)->GetZ ()): _("Unknown"), (*i)->x (), (*i)->y (), (*i)->z ())] = *i;
-	if (Atoms->empty ())
+	FillGrid ();
+	if (m_pDoc->GetAtomList ()->empty ())
 		gtk_widget_set_sensitive (DeleteAllBtn, false);
 	AtomColor = GTK_COLOR_CHOOSER (GetWidget ("color"));
 	m_ColorSignalID = g_signal_connect (G_OBJECT (AtomColor), "color-set", G_CALLBACK (AtomsDlgPrivate::ColorSet), this);
@@ -531,12 +527,34 @@ void AtomsDlg::ReloadData ()
 		return;
 	gcr_grid_delete_all (GCR_GRID (m_Grid));
 	m_Atoms.clear ();
-	gcr::AtomList* Atoms = m_pDoc->GetAtomList ();
-	for (list < Atom * >::iterator i = Atoms->begin (); i != Atoms->end (); i++)
-		m_Atoms[gcr_grid_append_row (GCR_GRID (m_Grid), ((*i)->GetZ ())? Element::Symbol ((*i)->GetZ ()): _("Unknown"),
-	                                        (*i)->x (), (*i)->y (), (*i)->z ())] = *i;
-	if (!m_Atoms.size ())
+	FillGrid ();
+	if (m_pDoc->GetAtomList ()->empty ())
 		gtk_widget_set_sensitive (DeleteAllBtn, false);
 }
 
+void AtomsDlg::FillGrid ()
+{
+	gcr::AtomList* Atoms = m_pDoc->GetAtomList ();
+	unsigned n = Atoms->size (), row, first;
+	m_Atoms.resize ((n / 10 + 1) * 10);
+	// fill the whole columns at once, appending rows one by one is slow for large crystals
+	vector < char const * > symbols (n);
+	vector < double > x (n), y (n), z (n);
+	list < gcr::Atom * >::iterator i, end = Atoms->end ();
+	for (i = Atoms->begin (), row = 0; i != end; i++, row++) {
+		m_Atoms[row] = *i;
+		symbols[row] = ((*i)->GetZ () > 0)? Element::Symbol ((*i)->GetZ ()): _("Unknown");
+		x[row] = (*i)->x ();
+		y[row] = (*i)->y ();
+		z[row] = (*i)->z ();
+	}
+	if (n == 0)
+		return;
+	first = gcr_grid_append_rows (m_Grid, n);
+	gcr_grid_set_column (m_Grid, COLUMN_ELT, first, n, &symbols[0]);
+	gcr_grid_set_column (m_Grid, COLUMN_X, first, n, &x[0]);
+	gcr_grid_set_column (m_Grid, COLUMN_Y, first, n, &y[0]);
+	gcr_grid_set_column (m_Grid, COLUMN_Z, first, n, &z[0]);
+}
+
 }	//	namespace gcr
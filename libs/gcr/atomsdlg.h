@@ -67,6 +67,7 @@ simplification following symmetry detection.
 private:
 	void Closed ();
 	void PopulateRadiiMenu ();
+	void FillGrid ();
 
 private:
 	Document *m_pDoc;
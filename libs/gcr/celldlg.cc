@@ -185,7 +185,7 @@ bool CellDlg::Apply ()
 		m_pDoc->SetAutoSpaceGroup (false);
 		m_pDoc->SetSpaceGroup (gcu::SpaceGroup::GetSpaceGroup (gtk_spin_button_get_value (SpaceGroup)));
 	}
-	m_pDoc->Update ();
+	m_pDoc->QueueUpdate ();
 	m_pDoc->SetDirty (true);
 	return true;
 }
@@ -269,7 +269,7 @@ void CellDlgPrivate::OnSpaceGroupChanged (GtkSpinButton *btn, CellDlg *dlg)
 		break;
 	}
 	g_signal_handler_unblock (dlg->TypeMenu, dlg->TypeSignal);
-	dlg->m_pDoc->Update ();
+	dlg->m_pDoc->QueueUpdate ();
 	dlg->m_pDoc->SetDirty (true);
 }
 
@@ -278,7 +278,7 @@ void CellDlgPrivate::OnAutoSpaceGroupToggled (GtkToggleButton *btn, CellDlg *dlg
 	bool autosp = gtk_toggle_button_get_active (btn);
 	gtk_widget_set_sensitive (GTK_WIDGET (dlg->SpaceGroup), !autosp);
 	dlg->m_pDoc->SetAutoSpaceGroup (autosp);
-	dlg->m_pDoc->Update ();
+	dlg->m_pDoc->QueueUpdate ();
 	dlg->m_pDoc->SetDirty (true);
 }
 
@@ -439,7 +439,7 @@ monoclinic_end:
 	dlg->m_pDoc->SetCell (i, a, b, c, alpha, beta, gamma);
 	gtk_spin_button_set_value (dlg->SpaceGroup, (spg)? spg->GetId (): id);
 	g_signal_handler_unblock (dlg->SpaceGroup, dlg->SpaceGroupSignal);
-	dlg->m_pDoc->Update ();
+	dlg->m_pDoc->QueueUpdate ();
 	dlg->m_pDoc->SetDirty (true);
 }
 
@@ -467,7 +467,7 @@ bool CellDlgPrivate::OnAEdited (CellDlg *dlg)
 			break;
 		}
 		dlg->m_pDoc->SetCell (lattice, val, b, c, alpha, beta, gamma);
-		dlg->m_pDoc->Update ();
+		dlg->m_pDoc->QueueUpdate ();
 		dlg->m_pDoc->SetDirty (true);
 	}
 	g_signal_handler_unblock (dlg->A, dlg->ASignal);
@@ -482,7 +482,7 @@ bool CellDlgPrivate::OnBEdited (CellDlg *dlg)
 	dlg->m_pDoc->GetCell (&lattice, &a, &b, &c, &alpha, &beta, &gamma);
 	if (dlg->GetNumber (dlg->B, &val, gcugtk::Min, 0) && val != b) {
 		dlg->m_pDoc->SetCell (lattice, a, val, c, alpha, beta, gamma);
-		dlg->m_pDoc->Update ();
+		dlg->m_pDoc->QueueUpdate ();
 		dlg->m_pDoc->SetDirty (true);
 	}
 	g_signal_handler_unblock (dlg->B, dlg->BSignal);
@@ -497,7 +497,7 @@ bool CellDlgPrivate::OnCEdited (CellDlg *dlg)
 	dlg->m_pDoc->GetCell (&lattice, &a, &b, &c, &alpha, &beta, &gamma);
 	if (dlg->GetNumber (dlg->C, &val, gcugtk::Min, 0) && val != c) {
 		dlg->m_pDoc->SetCell (lattice, a, b, val, alpha, beta, gamma);
-		dlg->m_pDoc->Update ();
+		dlg->m_pDoc->QueueUpdate ();
 		dlg->m_pDoc->SetDirty (true);
 	}
 	g_signal_handler_unblock (dlg->C, dlg->CSignal);
@@ -517,7 +517,7 @@ bool CellDlgPrivate::OnAlphaEdited (CellDlg *dlg)
 			gtk_entry_set_text (dlg->Gamma, gtk_entry_get_text (dlg->Alpha));
 		}
 		dlg->m_pDoc->SetCell (lattice, a, b, c, val, beta, gamma);
-		dlg->m_pDoc->Update ();
+		dlg->m_pDoc->QueueUpdate ();
 		dlg->m_pDoc->SetDirty (true);
 	}
 	g_signal_handler_unblock (dlg->Alpha, dlg->AlphaSignal);
@@ -532,7 +532,7 @@ bool CellDlgPrivate::OnBetaEdited (CellDlg *dlg)
 	dlg->m_pDoc->GetCell (&lattice, &a, &b, &c, &alpha, &beta, &gamma);
 	if (dlg->GetNumber (dlg->Beta, &val, gcugtk::Min, 0) && val != beta) {
 		dlg->m_pDoc->SetCell (lattice, a, b, c, alpha, val, gamma);
-		dlg->m_pDoc->Update ();
+		dlg->m_pDoc->QueueUpdate ();
 		dlg->m_pDoc->SetDirty (true);
 	}
 	g_signal_handler_unblock (dlg->Beta, dlg->BetaSignal);
@@ -547,7 +547,7 @@ bool CellDlgPrivate::OnGammaEdited (CellDlg *dlg)
 	dlg->m_pDoc->GetCell (&lattice, &a, &b, &c, &alpha, &beta, &gamma);
 	if (dlg->GetNumber (dlg->Gamma, &val, gcugtk::Min, 0) && val != gamma) {
 		dlg->m_pDoc->SetCell (lattice, a, b, c, alpha, beta, val);
-		dlg->m_pDoc->Update ();
+		dlg->m_pDoc->QueueUpdate ();
 		dlg->m_pDoc->SetDirty (true);
 	}
 	g_signal_handler_unblock (dlg->Gamma, dlg->GammaSignal);
@@ -63,7 +63,7 @@ void CleavagesDlgPrivate::AddRow (G_GNUC_UNUSED CleavagesDlg *pBox)
 		pBox->m_Cleavages.resize (max_row + 5);
 	pBox->m_Cleavages[new_row] = c;
 	pBox->m_pDoc->GetCleavageList ()->push_back (c);
-	pBox->m_pDoc->Update ();
+	pBox->m_pDoc->QueueUpdate ();
 	pBox->m_pDoc->SetDirty (true);
 	gtk_widget_set_sensitive (pBox->DeleteAllBtn, true);
 }
@@ -74,7 +74,7 @@ void CleavagesDlgPrivate::DeleteRow (G_GNUC_UNUSED CleavagesDlg *pBox)
 	delete pBox->m_Cleavages[pBox->m_CurRow];
 	pBox->m_Cleavages.erase (pBox->m_Cleavages.begin () + pBox->m_CurRow);
 	gcr_grid_delete_row (GCR_GRID (pBox->m_Grid), pBox->m_CurRow);
-	pBox->m_pDoc->Update ();
+	pBox->m_pDoc->QueueUpdate ();
 	pBox->m_pDoc->SetDirty (true);
 }
 
@@ -85,7 +85,7 @@ void CleavagesDlgPrivate::DeleteAll (G_GNUC_UNUSED CleavagesDlg *pBox)
 		delete pBox->m_Cleavages[i];
 	pBox->m_Cleavages.clear ();
 	pBox->m_pDoc->GetCleavageList ()->clear ();
-	pBox->m_pDoc->Update ();
+	pBox->m_pDoc->QueueUpdate ();
 	pBox->m_pDoc->SetDirty (true);
 	gtk_widget_set_sensitive (pBox->DeleteAllBtn, false);
 }
@@ -106,7 +106,7 @@ void CleavagesDlgPrivate::ValueChanged (CleavagesDlg *pBox, G_GNUC_UNUSED unsign
 		pBox->m_Cleavages[row]->Planes () = gcr_grid_get_uint (GCR_GRID (pBox->m_Grid), row, column);
 		break;
 	}
-	pBox->m_pDoc->Update ();
+	pBox->m_pDoc->QueueUpdate ();
 	pBox->m_pDoc->SetDirty (true);
 }
 
@@ -119,7 +119,7 @@ void CleavagesDlgPrivate::RowSelected (CleavagesDlg *pBox, int row)
 void CleavagesDlgPrivate::FixedSizeChanged (CleavagesDlg *pBox, GtkToggleButton *btn)
 {
 	pBox->m_pDoc->SetFixedSize (gtk_toggle_button_get_active (btn));
-	pBox->m_pDoc->Update ();
+	pBox->m_pDoc->QueueUpdate ();
 	pBox->m_pDoc->SetDirty (true);
 }
 
@@ -31,10 +31,13 @@
 #include "atomsdlg.h"
 #include "linesdlg.h"
 #include "sizedlg.h"
+#include "symmetry.h"
 #include "cleavagesdlg.h"
 #include "window.h"
 #include <gcugtk/filechooser.h>
 #include <gcu/cylinder.h>
+#include <gcu/geometry-cache.h>
+#include <gcu/glbatch.h>
 #include <gcu/matrix.h>
 #include <gcu/objprops.h>
 #include <gcu/spacegroup.h>
@@ -45,7 +48,9 @@
 #include <gtk/gtk.h>
 #include <glib/gi18n-lib.h>
 #include <libintl.h>
+#include <algorithm>
 #include <cmath>
+#include <functional>
 #include <set>
 #include <vector>
 #include <GL/gl.h>
@@ -83,7 +88,7 @@ char const *LatticeName[] = {
 };
 
 Document::Document (gcu::Application *App): gcu::GLDocument (App),
-	m_SpaceGroup (NULL), m_AutoSpaceGroup (false)
+	m_SpaceGroup (NULL), m_AutoSpaceGroup (false), m_UpdateSource (0)
 {
 	m_xmin = m_ymin = m_zmin = 0;
 	m_xmax = m_ymax = m_zmax = 1;
@@ -93,6 +98,8 @@ Document::Document (gcu::Application *App): gcu::GLDocument (App),
 
 Document::~Document()
 {
+	if (m_UpdateSource)
+		g_source_remove (m_UpdateSource);
 	g_free (m_filename);
 	Reinit ();
 }
@@ -104,18 +111,11 @@ void Document::Reinit()
 		delete AtomDef.front ();
 		AtomDef.pop_front ();
 	}
-	while (!Atoms.empty ()) {
-		delete Atoms.front ();
-		Atoms.pop_front ();
-	}
 	while (!LineDef.empty ()) {
 		delete LineDef.front ();
 		LineDef.pop_front ();
 	}
-	while (!Lines.empty ()) {
-		delete Lines.front ();
-		Lines.pop_front ();
-	}
+	ClearImages ();
 	while (!Cleavages.empty ()) {
 		delete Cleavages.front ();
 		Cleavages.pop_front ();
@@ -123,6 +123,7 @@ void Document::Reinit()
 	g_free (m_Author);
 	g_free (m_Mail);
 	g_free (m_Comment);
+	m_Batch->Clear ();
 	Init ();
 }
 
@@ -137,6 +138,8 @@ void Document::Init()
 	m_xmax = m_ymax = m_zmax = 1;
 	m_FixedSize = false;
 	m_MaxDist = 0;
+	m_ImagesValid = false;
+	m_SymmetryValid = false;
 	m_filename = NULL;
 	m_Label = NULL;
 	m_Author = NULL;
@@ -257,201 +260,266 @@ View *Document::GetView ()
  	return m_Views.front ();
 }
 
+static bool SamePosition (Atom &a, Atom &b)
+{
+	return a.x () == b.x () && a.y () == b.y () && a.z () == b.z ();
+}
+
+static bool SamePosition (Line &a, Line &b)
+{
+	return a.Type () == b.Type ()
+		&& a.X1 () == b.X1 () && a.Y1 () == b.Y1 () && a.Z1 () == b.Z1 ()
+		&& a.X2 () == b.X2 () && a.Y2 () == b.Y2 () && a.Z2 () == b.Z2 ();
+}
+
+// data used to find the planes removed by a cleavage, possibly in a separate thread
+typedef struct {
+	AtomImages const *atoms;
+	int h, k, l;
+	unsigned planes;
+	double threshold;	// the scalar product of the last removed plane
+	bool all;	// true if there are no more than planes planes
+} CleavageEval;
+
+static gpointer EvalCleavage (gpointer data)
+{
+	CleavageEval *eval = reinterpret_cast <CleavageEval *> (data);
+	AtomImages const *atoms = eval->atoms;
+	unsigned i, n = atoms->GetCount (), planes = 0;
+	std::vector <double> products (n);
+	for (i = 0; i < n; i++)
+		products[i] = atoms->x[i] * eval->h + atoms->y[i] * eval->k + atoms->z[i] * eval->l;
+	std::sort (products.begin (), products.end (), std::greater <double> ());
+	// a plane gathers all products within PREC of its highest one
+	eval->all = true;
+	for (i = 0; i < n; i++) {
+		if (planes && products[i] > eval->threshold - PREC)
+			continue;
+		if (planes == eval->planes) {
+			eval->all = false;
+			break;
+		}
+		eval->threshold = products[i];
+		planes++;
+	}
+	return NULL;
+}
+
+void Document::QueueUpdate ()
+{
+	// GTK+ redraws at G_PRIORITY_HIGH_IDLE + 20
+	if (!m_UpdateSource)
+		m_UpdateSource = g_idle_add_full (G_PRIORITY_HIGH_IDLE + 10, reinterpret_cast <GSourceFunc> (OnIdleUpdate), this, NULL);
+}
+
+gboolean Document::OnIdleUpdate (Document *doc)
+{
+	doc->m_UpdateSource = 0;
+	doc->Update ();
+	return false;
+}
+
 void Document::Update ()
 {
+	if (m_UpdateSource) {
+		g_source_remove (m_UpdateSource);
+		m_UpdateSource = 0;
+	}
 	m_Empty = AtomDef.empty () && LineDef.empty ();
-	Atom atom;
-	Line line;
 	double alpha = m_alpha * M_PI / 180;
 	double beta = m_beta * M_PI / 180;
 	double gamma = m_gamma * M_PI / 180;
-	// Remove all atoms
-	while (!Atoms.empty ()) {
-		delete Atoms.front ();
-		Atoms.pop_front ();
-	}
-	// Remove all bonds
-	while (!Lines.empty ()) {
-		delete Lines.front ();
-		Lines.pop_front ();
-	}
+	double box[6] = {m_xmin, m_xmax, m_ymin, m_ymax, m_zmin, m_zmax};
+	double const *skip = NULL;
+	unsigned n, nb;
 
 	// update space group
 	m_SpaceGroup = FindSpaceGroup ();
 
+	// the cell parameters are only used when converting to cartesian coordinates,
+	// so everything needs to be regenerated only if the symmetry changed. If only
+	// the size changed, the images in the previous box are kept.
+	bool regenerate = !m_ImagesValid || m_ImagesLattice != m_lattice || m_ImagesGroup != m_SpaceGroup;
+	if (!regenerate && memcmp (box, m_ImagesBox, sizeof (box)))
+		skip = m_ImagesBox;
+
 	////////////////////////////////////////////////////////////
 	//Establish list of atoms
+	// definitions which need to be expanded again are mapped to -1
 	AtomList::iterator i, iend = AtomDef.end ();
-
-	if (m_SpaceGroup) {
-		gcu::Vector v;
-		list <gcu::Vector> d;
-		for (i = AtomDef.begin(); i != iend; i++) {
-			v.SetX ((*i)->x ());
-			v.SetY ((*i)->y ());
-			v.SetZ ((*i)->z ());
-			d = m_SpaceGroup->Transform (v);
-			list <gcu::Vector>::iterator vi, viend = d.end();
-			Atom atom (**i);
-			for (vi=d.begin (); vi!= viend; vi++) {
-				atom.SetCoords ((*vi).GetX(), (*vi).GetY(), (*vi).GetZ());
-				Duplicate (atom);
-			}
-		}
-	} else for (i = AtomDef.begin(); i != iend; i++) {
-		Duplicate (**i);
-		switch (m_lattice) {
-		case body_centered_cubic:
-		case body_centered_tetragonal:
-		case body_centered_orthorhombic:
-			atom = **i;
-			atom.Move(0.5, 0.5, 0.5);
-			Duplicate (atom);
-			break;
-		case face_centered_cubic:
-		case face_centered_orthorhombic:
-			atom = **i;
-			atom.Move (0.5, 0, 0.5);
-			Duplicate (atom);
-			atom = **i;
-			atom.Move(0, 0.5, 0.5);
-			Duplicate (atom);
-		case base_centered_orthorhombic:
-		case base_centered_monoclinic:
-			atom = **i;
-			atom.Move (0.5, 0.5, 0);
-			Duplicate (atom);
-			break;
-		default:
-			break;
-		}
+	map <Atom *, int> atomdefs;
+	for (n = 0, i = AtomDef.begin (); i != iend; i++, n++) {
+		Atom *&snapshot = m_AtomSnapshots[*i];
+		if (regenerate || !snapshot || !SamePosition (**i, *snapshot))
+			atomdefs[*i] = -1;
+		else
+			atomdefs[*i] = n;
+		if (snapshot)
+			*snapshot = **i;
+		else
+			snapshot = new Atom (**i);
+	}
+	map <Atom *, Atom *>::iterator as = m_AtomSnapshots.begin ();
+	while (as != m_AtomSnapshots.end ())
+		if (atomdefs.find ((*as).first) == atomdefs.end ()) {
+			// the definition has been removed
+			delete (*as).second;
+			m_AtomSnapshots.erase (as++);
+		} else
+			as++;
+	nb = m_AtomSources.size ();
+	vector <int> remap (nb, -1);
+	for (n = 0; n < nb; n++) {
+		map <Atom *, int>::iterator def = atomdefs.find (m_AtomSources[n]);
+		if (def != atomdefs.end ())
+			remap[n] = (*def).second;
+	}
+	// remove what is no more needed, including what is outside of a new box,
+	// then add the new images
+	Atoms.Filter (remap, skip? box: NULL);
+	Atoms.SetDefinitionsNumber (AtomDef.size ());
+	// with a space group, all the positions are expanded at once
+	vector <double> positions;
+	vector <unsigned> indices;
+	vector <double const *> skips;
+	for (n = 0, i = AtomDef.begin (); i != iend; i++, n++) {
+		Atoms.SetDefinition (n, **i);
+		if (atomdefs[*i] >= 0 && !skip)
+			continue;
+		if (m_SpaceGroup) {
+			positions.push_back ((*i)->x ());
+			positions.push_back ((*i)->y ());
+			positions.push_back ((*i)->z ());
+			indices.push_back (n);
+			skips.push_back ((atomdefs[*i] < 0)? NULL: skip);
+		} else
+			ExpandAtom (**i, n, (atomdefs[*i] < 0)? NULL: skip);
+	}
+	if (!indices.empty ()) {
+		vector <double> images (positions.size () * m_SpaceGroup->GetTransformsNumber ());
+		vector <unsigned> counts (indices.size ());
+		m_SpaceGroup->Expand (&positions[0], indices.size (), &images[0], &counts[0]);
+		double const *image = &images[0];
+		for (n = 0; n < indices.size (); n++)
+			for (unsigned k = 0; k < counts[n]; k++, image += 3)
+				Duplicate (image[0], image[1], image[2], indices[n], skips[n]);
 	}
+	m_AtomSources.assign (AtomDef.begin (), AtomDef.end ());
 
 	////////////////////////////////////////////////////////////
 	//Establish list of lines
-	LineList::iterator j, jend = LineDef.end();
-	for (j = LineDef.begin() ; j != jend ; j++) {
-		switch ((*j)->Type()) {
-		case edges:
-			line = **j;
-			line.SetPosition (0 ,0, 0, 1, 0, 0);
-			Duplicate (line);
-			line.SetPosition (0 ,0, 0, 0, 1, 0);
-			Duplicate (line);
-			line.SetPosition (0 ,0, 0, 0, 0, 1);
-			Duplicate (line);
-			break ;
-		case diagonals:
-			line = **j;
-			line.SetPosition (0 ,0, 0, 1, 1, 1);
-			Duplicate (line);
-			line.SetPosition (1 ,0, 0, 0, 1, 1);
-			Duplicate (line);
-			line.SetPosition (0 ,1, 0, 1, 0, 1);
-			Duplicate (line);
-			line.SetPosition (1 ,1, 0, 0, 0, 1);
-			Duplicate (line);
-			break ;
-		case medians:
-			line = **j;
-			line.SetPosition (.5, .5, 0, .5, .5, 1);
-			Duplicate (line);
-			line.SetPosition (0, .5, .5, 1, .5, .5);
-			Duplicate (line);
-			line.SetPosition (.5, 0, .5, .5, 1, .5);
-			Duplicate (line);
-			break ;
-		case normal:
-			Duplicate (**j) ;
-			switch (m_lattice) {
-			case body_centered_cubic:
-			case body_centered_tetragonal:
-			case body_centered_orthorhombic:
-				line = **j;
-				line.Move (0.5, 0.5, 0.5);
-				Duplicate (line);
-				break;
-			case face_centered_cubic:
-			case face_centered_orthorhombic:
-				line = **j;
-				line.Move (0.5, 0, 0.5);
-				Duplicate (line);
-				line = **j;
-				line.Move (0, 0.5, 0.5);
-				Duplicate (line);
-			case base_centered_orthorhombic:
-			case base_centered_monoclinic:
-				line = **j;
-				line.Move (0.5, 0.5, 0);
-				Duplicate (line);
-				break;
-			default:
-				break;
-			}
-			break ;
-		case unique:
-			if (((*j)->Xmin() >= m_xmin) && ((*j)->Xmax() <= m_xmax)
-				&& ((*j)->Ymin() >= m_ymin) && ((*j)->Ymax() <= m_ymax)
-				&& ((*j)->Zmin() >= m_zmin) && ((*j)->Zmax() <= m_zmax))
-					Lines.push_back(new Line(**j)) ;
-		}
+	LineList::iterator j, jend = LineDef.end ();
+	map <Line *, int> linedefs;
+	for (n = 0, j = LineDef.begin (); j != jend; j++, n++) {
+		Line *&snapshot = m_LineSnapshots[*j];
+		if (regenerate || !snapshot || !SamePosition (**j, *snapshot))
+			linedefs[*j] = -1;
+		else
+			linedefs[*j] = n;
+		if (snapshot)
+			*snapshot = **j;
+		else
+			snapshot = new Line (**j);
 	}
-
-	//Manage cleavages
+	map <Line *, Line *>::iterator ls = m_LineSnapshots.begin ();
+	while (ls != m_LineSnapshots.end ())
+		if (linedefs.find ((*ls).first) == linedefs.end ()) {
+			delete (*ls).second;
+			m_LineSnapshots.erase (ls++);
+		} else
+			ls++;
+	nb = m_LineSources.size ();
+	remap.assign (nb, -1);
+	for (n = 0; n < nb; n++) {
+		map <Line *, int>::iterator def = linedefs.find (m_LineSources[n]);
+		if (def != linedefs.end ())
+			remap[n] = (*def).second;
+	}
+	Lines.Filter (remap, skip? box: NULL);
+	Lines.SetDefinitionsNumber (LineDef.size ());
+	for (n = 0, j = LineDef.begin (); j != jend; j++, n++) {
+		Lines.SetDefinition (n, **j);
+		if (linedefs[*j] < 0)
+			ExpandLine (**j, n, NULL);
+		else if (skip)
+			ExpandLine (**j, n, skip);
+	}
+	m_LineSources.assign (LineDef.begin (), LineDef.end ());
+	m_ImagesValid = true;
+	m_ImagesLattice = m_lattice;
+	m_ImagesGroup = m_SpaceGroup;
+	memcpy (m_ImagesBox, box, sizeof (box));
+
+	//Manage cleavages, images are still in net coordinates
+	unsigned a, na = Atoms.GetCount (), l, nl = Lines.GetCount (), e, ne;
+	double x, y, z;
+	Atoms.Uncleave ();
+	Lines.Uncleave ();
+	std::vector <CleavageEval> evals;
 	CleavageList::iterator k;
-	for (k = Cleavages.begin(); k != Cleavages.end(); k++)
-	{
-		double x;
-		std::vector<double> ScalarProducts;
-		std::vector<double>::iterator m;
-		unsigned n;
-
+	for (k = Cleavages.begin(); k != Cleavages.end(); k++) {
 		// we might have invalid cleavages, so we need to skip them
 		if ((*k)->Planes () == 0 || ((*k)->h () == 0 && (*k)->k () == 0 && (*k)->l () == 0))
 			continue;	// invalid cleavage
-		//scalar products calculus and storing
-		for (i = Atoms.begin(); i != Atoms.end(); i++)
-		{
-			x = (*i)->ScalProd((*k)->h(), (*k)->k(), (*k)->l());
-			for (m = ScalarProducts.begin(); m != (ScalarProducts.end()) && ((*m) > (x + PREC)); m++) ;
-			if ((m == ScalarProducts.end()) || (fabs(*m - x) > PREC)) ScalarProducts.insert(m, x);
-		}
+		CleavageEval eval = {&Atoms, (*k)->h (), (*k)->k (), (*k)->l (), (*k)->Planes (), 0., true};
+		evals.push_back (eval);
+	}
+	// find the cleaved planes, each cleavage in its own thread for large crystals
+	ne = evals.size ();
+	if (ne > 1 && na >= 4096) {
+		std::vector <GThread *> threads (ne);
+		for (e = 1; e < ne; e++)
+			threads[e] = g_thread_new ("cleavage", EvalCleavage, &evals[e]);
+		EvalCleavage (&evals[0]);
+		for (e = 1; e < ne; e++)
+			g_thread_join (threads[e]);
+	} else
+		for (e = 0; e < ne; e++)
+			EvalCleavage (&evals[e]);
 
-		//cleave atoms and bonds
-		if ((n = (*k)->Planes()) >= ScalarProducts.size())
-		{
+	//cleave atoms and bonds
+	for (e = 0; e < ne; e++) {
+		CleavageEval &eval = evals[e];
+		if (eval.all) {
 			GtkWidget* message = gtk_message_dialog_new(NULL, (GtkDialogFlags) 0, GTK_MESSAGE_WARNING, GTK_BUTTONS_OK, _("Everything has been cleaved"));
 			g_signal_connect (G_OBJECT (message), "response", G_CALLBACK (gtk_widget_destroy), NULL);
 			gtk_widget_show(message);
-			for (i = Atoms.begin(); i != Atoms.end(); i++) (*i)->Cleave();
-			for (j = Lines.begin(); j != Lines.end(); j++) (*j)->Cleave();
+			Atoms.cleaved.assign (na, 1);
+			Lines.cleaved.assign (nl, 1);
+			continue;
 		}
-		else
-		{
-			x = ScalarProducts[n - 1];
-			for (i = Atoms.begin(); i != Atoms.end(); i++)
-				if (x < (*i)->ScalProd((*k)->h(), (*k)->k(), (*k)->l())+ PREC)
-					(*i)->Cleave() ;
-
-			//bonds cleavage
-			for (j = Lines.begin(); j != Lines.end(); j++)
-				if (x < (*j)->ScalProd((*k)->h(), (*k)->k(), (*k)->l())+ PREC)
-					(*j)->Cleave();
+		x = eval.threshold - PREC;
+		for (a = 0; a < na; a++)
+			if (Atoms.x[a] * eval.h + Atoms.y[a] * eval.k + Atoms.z[a] * eval.l > x)
+				Atoms.cleaved[a] = 1;
+		for (l = 0; l < nl; l++) {
+			y = Lines.x1[l] * eval.h + Lines.y1[l] * eval.k + Lines.z1[l] * eval.l;
+			z = Lines.x2[l] * eval.h + Lines.y2[l] * eval.k + Lines.z2[l] * eval.l;
+			if (y > x || z > x)
+				Lines.cleaved[l] = 1;
 		}
-
-		ScalarProducts.clear() ;
 	}
 
-	//Transform coordinates to Cartesians and find center of visible view
-	double x, y, z, d,
+	//Evaluate the net to cartesian transform and find center of visible view
+	double t = (cos (gamma) - cos (beta) * cos (alpha)) / sin (alpha);
+	m_Cartesian[0][0] = m_a * sqrt (1 - square (cos (beta)) - square (t));
+	m_Cartesian[0][1] = m_Cartesian[0][2] = m_Cartesian[1][2] = 0.;
+	m_Cartesian[1][0] = m_a * t;
+	m_Cartesian[1][1] = m_b * sin (alpha);
+	m_Cartesian[2][0] = m_a * cos (beta);
+	m_Cartesian[2][1] = m_b * cos (alpha);
+	m_Cartesian[2][2] = m_c;
+	m_Center[0] = m_Center[1] = m_Center[2] = 0.;
+	double x1, y1, z1, d,
 		xmin = G_MAXDOUBLE, ymin = G_MAXDOUBLE, zmin = G_MAXDOUBLE,
 		xmax = -G_MAXDOUBLE, ymax = -G_MAXDOUBLE, zmax = -G_MAXDOUBLE;
-	iend = Atoms.end ();
-	for (i = Atoms.begin(); i != iend; i++) {
-		(*i)->NetToCartesian(m_a, m_b, m_c, alpha, beta, gamma);
-		if ((*i)->IsCleaved ())
+	for (a = 0; a < na; a++) {
+		if (Atoms.cleaved[a])
 			continue;
-		(*i)->GetCoords (&x, &y, &z);
+		x = Atoms.x[a];
+		y = Atoms.y[a];
+		z = Atoms.z[a];
+		NetToCartesian (x, y, z);
 		if (x < xmin)
 			xmin = x;
 		if (y < ymin)
@@ -465,46 +533,54 @@ void Document::Update ()
 		if (z > zmax)
 			zmax = z;
 	}
-	jend = Lines.end ();
-	for (j = Lines.begin (); j != jend; j++) {
-		(*j)->NetToCartesian (m_a, m_b, m_c, alpha, beta, gamma);
-		if ((*j)->IsCleaved ())
+	for (l = 0; l < nl; l++) {
+		if (Lines.cleaved[l])
 			continue;
-		x = (*j)->Xmin ();
-		y = (*j)->Ymin ();
-		z = (*j)->Zmin ();
-		if (x < xmin)
-			xmin = x;
-		if (y < ymin)
-			ymin = y;
-		if (z < zmin)
-			zmin = z;
-		x = (*j)->Xmax ();
-		y = (*j)->Ymax ();
-		z = (*j)->Zmax ();
-		if (x > xmax)
-			xmax = x;
-		if (y > ymax)
-			ymax = y;
-		if (z > zmax)
-			zmax = z;
+		x = Lines.x1[l];
+		y = Lines.y1[l];
+		z = Lines.z1[l];
+		NetToCartesian (x, y, z);
+		x1 = Lines.x2[l];
+		y1 = Lines.y2[l];
+		z1 = Lines.z2[l];
+		NetToCartesian (x1, y1, z1);
+		xmin = __min (xmin, __min (x, x1));
+		ymin = __min (ymin, __min (y, y1));
+		zmin = __min (zmin, __min (z, z1));
+		xmax = __max (xmax, __max (x, x1));
+		ymax = __max (ymax, __max (y, y1));
+		zmax = __max (zmax, __max (z, z1));
 	}
 
 	//Searching the center of the crystal and find maximum distance from center
-	x = (xmin + xmax) / 2.;
-	y = (ymin + ymax) / 2.;
-	z = (zmin + zmax) / 2.;
+	m_Center[0] = (xmin + xmax) / 2.;
+	m_Center[1] = (ymin + ymax) / 2.;
+	m_Center[2] = (zmin + zmax) / 2.;
 	m_MaxDist = 0;
-	for (i = Atoms.begin(); i != iend; i++) {
-		d =  (*i)->Distance (x, y, z, m_FixedSize);
+	for (a = 0; a < na; a++) {
+		if (Atoms.cleaved[a] && !m_FixedSize)
+			continue;
+		x = Atoms.x[a];
+		y = Atoms.y[a];
+		z = Atoms.z[a];
+		NetToCartesian (x, y, z);
+		d = sqrt (x * x + y * y + z * z) + Atoms.radii[Atoms.def[a]];
 		m_MaxDist = __max (m_MaxDist, d);
-		(*i)->Move (- x, - y, - z);
 	}
 
-	for (j = Lines.begin(); j != Lines.end(); j++) {
-		d =  (*j)->Distance (x, y, z, m_FixedSize);
+	for (l = 0; l < nl; l++) {
+		if (Lines.cleaved[l] && !m_FixedSize)
+			continue;
+		x = Lines.x1[l];
+		y = Lines.y1[l];
+		z = Lines.z1[l];
+		NetToCartesian (x, y, z);
+		x1 = Lines.x2[l];
+		y1 = Lines.y2[l];
+		z1 = Lines.z2[l];
+		NetToCartesian (x1, y1, z1);
+		d = sqrt (__max (x * x + y * y + z * z, x1 * x1 + y1 * y1 + z1 * z1));
 		m_MaxDist = __max (m_MaxDist, d);
-		(*j)->Move (- x, - y, - z);
 	}
 	m_SpaceGroup = FindSpaceGroup ();
 	UpdateAllViews ();
@@ -512,6 +588,7 @@ void Document::Update ()
 
 void Document::UpdateAllViews()
 {
+	m_Batch->Clear ();
 	std::list < View * >::iterator i;
 	for (i = m_Views.begin (); i != m_Views.end (); i++) {
 		(*i)->Update();
@@ -521,80 +598,250 @@ void Document::UpdateAllViews()
 	}
 }
 
-void Document::Duplicate (Atom& atom)
+void Document::NetToCartesian (double &x, double &y, double &z) const
 {
-	Atom AtomX, AtomY, AtomZ;
-	AtomX = atom ;
-	AtomX.Move (- floor (AtomX.x ()-m_xmin + 1e-7), - floor (AtomX.y ()-m_ymin + 1e-7), - floor (AtomX.z ()-m_zmin + 1e-7)) ;
-	while (AtomX.x () <= m_xmax + 1e-7) {
-		AtomY = AtomX ;
-		while (AtomY.y () <= m_ymax + 1e-7) {
-			AtomZ = AtomY ;
-			while (AtomZ.z () <= m_zmax + 1e-7) {
-				Atoms.push_back (new Atom (AtomZ)) ;
-				AtomZ.Move (0,0,1) ;
-			}
-			AtomY.Move (0,1,0) ;
-		}
-		AtomX.Move (1,0,0) ;
+	double x1 = m_Cartesian[0][0] * x - m_Center[0];
+	double y1 = m_Cartesian[1][0] * x + m_Cartesian[1][1] * y - m_Center[1];
+	z = m_Cartesian[2][0] * x + m_Cartesian[2][1] * y + m_Cartesian[2][2] * z - m_Center[2];
+	x = x1;
+	y = y1;
+}
+
+void Document::ClearImages ()
+{
+	map <Atom *, Atom *>::iterator i, iend = m_AtomSnapshots.end ();
+	for (i = m_AtomSnapshots.begin (); i != iend; i++)
+		delete (*i).second;
+	m_AtomSnapshots.clear ();
+	map <Line *, Line *>::iterator j, jend = m_LineSnapshots.end ();
+	for (j = m_LineSnapshots.begin (); j != jend; j++)
+		delete (*j).second;
+	m_LineSnapshots.clear ();
+	m_AtomSources.clear ();
+	m_LineSources.clear ();
+	Atoms.Clear ();
+	Lines.Clear ();
+	m_ImagesValid = false;
+}
+
+void Document::ExpandAtom (Atom &def, unsigned index, double const *skip)
+{
+	double x = def.x (), y = def.y (), z = def.z ();
+	Duplicate (x, y, z, index, skip);
+	switch (m_lattice) {
+	case body_centered_cubic:
+	case body_centered_tetragonal:
+	case body_centered_orthorhombic:
+		Duplicate (x + 0.5, y + 0.5, z + 0.5, index, skip);
+		break;
+	case face_centered_cubic:
+	case face_centered_orthorhombic:
+		Duplicate (x + 0.5, y, z + 0.5, index, skip);
+		Duplicate (x, y + 0.5, z + 0.5, index, skip);
+	case base_centered_orthorhombic:
+	case base_centered_monoclinic:
+		Duplicate (x + 0.5, y + 0.5, z, index, skip);
+		break;
+	default:
+		break;
 	}
 }
 
-void Document::Duplicate (Line& line)
+void Document::ExpandLine (Line &def, unsigned index, double const *skip)
 {
-	Line LineX, LineY, LineZ ;
-	LineX = line ;
-	LineX.Move (- floor (LineX.Xmin ()-m_xmin + 1e-7), - floor (LineX.Ymin ()-m_ymin + 1e-7), - floor (LineX.Zmin ()-m_zmin + 1e-7)) ;
-	while (LineX.Xmax () <= m_xmax + 1e-7) {
-		LineY = LineX ;
-		while (LineY.Ymax () <= m_ymax + 1e-7) {
-			LineZ = LineY ;
-			while (LineZ.Zmax () <= m_zmax + 1e-7) {
-				Lines.push_back (new Line (LineZ)) ;
-				LineZ.Move (0,0,1) ;
-			}
-			LineY.Move (0,1,0) ;
+	Line line;
+	switch (def.Type()) {
+	case edges:
+		line = def;
+		line.SetPosition (0 ,0, 0, 1, 0, 0);
+		Duplicate (line, index, skip);
+		line.SetPosition (0 ,0, 0, 0, 1, 0);
+		Duplicate (line, index, skip);
+		line.SetPosition (0 ,0, 0, 0, 0, 1);
+		Duplicate (line, index, skip);
+		break ;
+	case diagonals:
+		line = def;
+		line.SetPosition (0 ,0, 0, 1, 1, 1);
+		Duplicate (line, index, skip);
+		line.SetPosition (1 ,0, 0, 0, 1, 1);
+		Duplicate (line, index, skip);
+		line.SetPosition (0 ,1, 0, 1, 0, 1);
+		Duplicate (line, index, skip);
+		line.SetPosition (1 ,1, 0, 0, 0, 1);
+		Duplicate (line, index, skip);
+		break ;
+	case medians:
+		line = def;
+		line.SetPosition (.5, .5, 0, .5, .5, 1);
+		Duplicate (line, index, skip);
+		line.SetPosition (0, .5, .5, 1, .5, .5);
+		Duplicate (line, index, skip);
+		line.SetPosition (.5, 0, .5, .5, 1, .5);
+		Duplicate (line, index, skip);
+		break ;
+	case normal:
+		Duplicate (def, index, skip) ;
+		switch (m_lattice) {
+		case body_centered_cubic:
+		case body_centered_tetragonal:
+		case body_centered_orthorhombic:
+			line = def;
+			line.Move (0.5, 0.5, 0.5);
+			Duplicate (line, index, skip);
+			break;
+		case face_centered_cubic:
+		case face_centered_orthorhombic:
+			line = def;
+			line.Move (0.5, 0, 0.5);
+			Duplicate (line, index, skip);
+			line = def;
+			line.Move (0, 0.5, 0.5);
+			Duplicate (line, index, skip);
+		case base_centered_orthorhombic:
+		case base_centered_monoclinic:
+			line = def;
+			line.Move (0.5, 0.5, 0);
+			Duplicate (line, index, skip);
+			break;
+		default:
+			break;
 		}
-		LineX.Move (1,0,0) ;
+		break ;
+	case unique:
+		if ((def.Xmin() >= m_xmin) && (def.Xmax() <= m_xmax)
+			&& (def.Ymin() >= m_ymin) && (def.Ymax() <= m_ymax)
+			&& (def.Zmin() >= m_zmin) && (def.Zmax() <= m_zmax)
+		    && (!skip || !InBox (skip, def.X1 (), def.Y1 (), def.Z1 ())
+		        || !InBox (skip, def.X2 (), def.Y2 (), def.Z2 ())))
+				Lines.Add (def.X1 (), def.Y1 (), def.Z1 (), def.X2 (), def.Y2 (), def.Z2 (), index);
 	}
 }
 
+// skip, if not NULL, is the previous box, images inside it already exist
+void Document::Duplicate (double x, double y, double z, unsigned index, double const *skip)
+{
+	double x0 = x - floor (x - m_xmin + 1e-7), y0 = y - floor (y - m_ymin + 1e-7), z0 = z - floor (z - m_zmin + 1e-7);
+	for (x = x0; x <= m_xmax + 1e-7; x++)
+		for (y = y0; y <= m_ymax + 1e-7; y++)
+			for (z = z0; z <= m_zmax + 1e-7; z++)
+				if (!skip || !InBox (skip, x, y, z))
+					Atoms.Add (x, y, z, index);
+}
+
+void Document::Duplicate (Line& line, unsigned index, double const *skip)
+{
+	double x1 = line.X1 (), y1 = line.Y1 (), z1 = line.Z1 (),
+		x2 = line.X2 (), y2 = line.Y2 (), z2 = line.Z2 (),
+		x0 = - floor (line.Xmin () - m_xmin + 1e-7), y0 = - floor (line.Ymin () - m_ymin + 1e-7), z0 = - floor (line.Zmin () - m_zmin + 1e-7),
+		xmax = line.Xmax (), ymax = line.Ymax (), zmax = line.Zmax (), x, y, z;
+	for (x = x0; xmax + x <= m_xmax + 1e-7; x++)
+		for (y = y0; ymax + y <= m_ymax + 1e-7; y++)
+			for (z = z0; zmax + z <= m_zmax + 1e-7; z++)
+				if (!skip || !InBox (skip, x1 + x, y1 + y, z1 + z)
+				    || !InBox (skip, x2 + x, y2 + y, z2 + z))
+					Lines.Add (x1 + x, y1 + y, z1 + z, x2 + x, y2 + y, z2 + z, index);
+}
+
 void Document::Draw (gcu::Matrix const &m) const
 {
-	gcu::Vector v, v1;
-	gcu::Sphere sp (10);
 	glEnable (GL_RESCALE_NORMAL);
-	AtomList::const_iterator i, iend = Atoms.end ();
-	double red, green, blue, alpha;
-	for (i = Atoms.begin (); i != iend; i++)
-		if (!(*i)->IsCleaved ()) {
-			v.SetZ ((*i)->x ());
-			v.SetX ((*i)->y ());
-			v.SetY ((*i)->z ());
+	gcu::GeometryCache cache;
+	if (GetBatchRendering ()) {
+		if (!m_Batch->IsValid (cache)) {
+			m_Batch->SetProjection (cache);
+			BuildBatch ();
+		}
+		m_Batch->Draw (m);
+		return;
+	}
+	gcu::Vector v, v1;
+	unsigned i, max = Atoms.GetCount ();
+	double x, y, z, r;
+	float const *color;
+	for (i = 0; i < max; i++)
+		if (!Atoms.cleaved[i]) {
+			x = Atoms.x[i];
+			y = Atoms.y[i];
+			z = Atoms.z[i];
+			NetToCartesian (x, y, z);
+			v.SetZ (x);
+			v.SetX (y);
+			v.SetY (z);
 			v = m.glmult (v);
-			(*i)->GetColor (&red, &green, &blue, &alpha);
-			glColor4d (red, green, blue, alpha) ;
-			sp.draw (v, (*i)->r () * (*i)->GetEffectiveRadiusRatio ());
+			color = &Atoms.colors[4 * Atoms.def[i]];
+			glColor4f (color[0], color[1], color[2], color[3]);
+			r = Atoms.drawn_radii[Atoms.def[i]];
+			cache.GetSphere (v, r).draw (v, r);
 		}
 	glEnable (GL_NORMALIZE);
-	LineList::const_iterator j, jend = Lines.end ();
-	gcu::Cylinder cyl (10);
-	for (j = Lines.begin (); j != jend; j++)
-		if (!(*j)->IsCleaved ()) {
-			v.SetZ ((*j)->X1 ());
-			v.SetX ((*j)->Y1 ());
-			v.SetY ((*j)->Z1 ());
+	max = Lines.GetCount ();
+	for (i = 0; i < max; i++)
+		if (!Lines.cleaved[i]) {
+			x = Lines.x1[i];
+			y = Lines.y1[i];
+			z = Lines.z1[i];
+			NetToCartesian (x, y, z);
+			v.SetZ (x);
+			v.SetX (y);
+			v.SetY (z);
 			v = m.glmult (v);
-			v1.SetZ ((*j)->X2 ());
-			v1.SetX ((*j)->Y2 ());
-			v1.SetY ((*j)->Z2 ());
+			x = Lines.x2[i];
+			y = Lines.y2[i];
+			z = Lines.z2[i];
+			NetToCartesian (x, y, z);
+			v1.SetZ (x);
+			v1.SetX (y);
+			v1.SetY (z);
 			v1 = m.glmult (v1);
-			(*j)->GetColor (&red, &green, &blue, &alpha);
-			glColor4d (red, green, blue, alpha) ;
-			cyl.draw (v, v1, (*j)->GetRadius ());
+			color = &Lines.colors[4 * Lines.def[i]];
+			glColor4f (color[0], color[1], color[2], color[3]);
+			r = Lines.radii[Lines.def[i]];
+			cache.GetCylinder (v, v1, r).draw (v, v1, r);
 		}
 }
 
+void Document::BuildBatch () const
+{
+	gcu::Vector v, v1;
+	unsigned i, max = Atoms.GetCount ();
+	double x, y, z;
+	float const *color;
+	m_Batch->Clear ();
+	m_Batch->Reserve (Atoms.GetCount (), Lines.GetCount ());
+	for (i = 0; i < max; i++)
+		if (!Atoms.cleaved[i]) {
+			x = Atoms.x[i];
+			y = Atoms.y[i];
+			z = Atoms.z[i];
+			NetToCartesian (x, y, z);
+			v.SetZ (x);
+			v.SetX (y);
+			v.SetY (z);
+			color = &Atoms.colors[4 * Atoms.def[i]];
+			m_Batch->AddSphere (v, Atoms.drawn_radii[Atoms.def[i]], color[0], color[1], color[2], color[3]);
+		}
+	max = Lines.GetCount ();
+	for (i = 0; i < max; i++)
+		if (!Lines.cleaved[i]) {
+			x = Lines.x1[i];
+			y = Lines.y1[i];
+			z = Lines.z1[i];
+			NetToCartesian (x, y, z);
+			v.SetZ (x);
+			v.SetX (y);
+			v.SetY (z);
+			x = Lines.x2[i];
+			y = Lines.y2[i];
+			z = Lines.z2[i];
+			NetToCartesian (x, y, z);
+			v1.SetZ (x);
+			v1.SetX (y);
+			v1.SetY (z);
+			color = &Lines.colors[4 * Lines.def[i]];
+			m_Batch->AddCylinder (v, v1, Lines.radii[Lines.def[i]], color[0], color[1], color[2], color[3]);
+		}
+}
 View* Document::CreateNewView()
 {
 	return new View(this);
@@ -978,6 +1225,37 @@ void Document::AddChild (Object* object)
 	}
 }
 
+static inline void hash_bytes (guint64 &key, void const *data, size_t size)
+{
+	// FNV-1a
+	unsigned char const *bytes = reinterpret_cast <unsigned char const *> (data);
+	for (size_t i = 0; i < size; i++) {
+		key ^= bytes[i];
+		key *= G_GUINT64_CONSTANT (0x100000001b3);
+	}
+}
+
+guint64 Document::SymmetryKey ()
+{
+	guint64 key = G_GUINT64_CONSTANT (0xcbf29ce484222325);
+	hash_bytes (key, &m_lattice, sizeof (m_lattice));
+	double values[8];
+	int Z;
+	char charge;
+	AtomList::iterator i, iend = AtomDef.end ();
+	for (i = AtomDef.begin (); i != iend; i++) {
+		Z = (*i)->GetZ ();
+		charge = (*i)->GetCharge ();
+		(*i)->GetCoords (values, values + 1, values + 2);
+		(*i)->GetColor (values + 3, values + 4, values + 5, values + 6);
+		values[7] = (*i)->GetSize ();
+		hash_bytes (key, &Z, sizeof (Z));
+		hash_bytes (key, &charge, sizeof (charge));
+		hash_bytes (key, values, sizeof (values));
+	}
+	return key;
+}
+
 gcu::SpaceGroup const *Document::FindSpaceGroup ()
 {
 	if (!AtomDef.size ())
@@ -1024,140 +1302,58 @@ gcu::SpaceGroup const *Document::FindSpaceGroup ()
 	default:
 		start = end = 0;
 	}
-	//make a list of all atoms inside the cell
-	list <Atom *> atoms;
-	Atom *a;
+	// nothing changed since the last search
+	guint64 key = SymmetryKey ();
+	if (m_SymmetryValid && key == m_SymmetryKey)
+		return m_SymmetryGroup;
+	// add all positions inside the cell, including the centering translations
+	SymmetryFinder finder, cell;
 	double x, y, z;
-	AtomList::iterator i, i0, iend = AtomDef.end ();
+	AtomList::iterator i, iend = AtomDef.end ();
 	for (i = AtomDef.begin (); i != iend; i++) {
-		atoms.push_back (new Atom (**i));
+		(*i)->GetCoords (&x, &y, &z);
+		finder.AddAtom (**i, x, y, z);
+		cell.AddAtom (**i, x, y, z);
 		switch (m_lattice) {
 		case body_centered_cubic:
 		case body_centered_tetragonal:
 		case body_centered_orthorhombic:
-			a = new Atom (**i);
-			a->GetCoords (&x, &y, &z);
-			x = (x > .5 - PREC)? x - .5: x + .5;
-			y = (y > .5 - PREC)? y - .5: y + .5;
-			z = (z > .5 - PREC)? z - .5: z + .5;
-			a->SetCoords (x, y, z);
-			atoms.push_back (a);
+			finder.AddAtom (**i, (x > .5 - PREC)? x - .5: x + .5,
+			                     (y > .5 - PREC)? y - .5: y + .5,
+			                     (z > .5 - PREC)? z - .5: z + .5);
 			break;
 		case face_centered_cubic:
 		case face_centered_orthorhombic:
-			a = new Atom (**i);
-			a->GetCoords (&x, &y, &z);
-			x = (x > .5 - PREC)? x - .5: x + .5;
-			z = (z > .5 - PREC)? z - .5: z + .5;
-			a->SetCoords (x, y, z);
-			atoms.push_back (a);
-			a = new Atom (**i);
-			a->GetCoords (&x, &y, &z);
-			y = (y > .5 - PREC)? y - .5: y + .5;
-			z = (z > .5 - PREC)? z - .5: z + .5;
-			a->SetCoords (x, y, z);
-			atoms.push_back (a);
+			finder.AddAtom (**i, (x > .5 - PREC)? x - .5: x + .5, y,
+			                     (z > .5 - PREC)? z - .5: z + .5);
+			finder.AddAtom (**i, x, (y > .5 - PREC)? y - .5: y + .5,
+			                     (z > .5 - PREC)? z - .5: z + .5);
 		case base_centered_orthorhombic:
 		case base_centered_monoclinic:
-			a = new Atom (**i);
-			a->GetCoords (&x, &y, &z);
-			x = (x > .5 - PREC)? x - .5: x + .5;
-			y = (y > .5 - PREC)? y - .5: y + .5;
-			a->SetCoords (x, y, z);
-			atoms.push_back (a);
+			finder.AddAtom (**i, (x > .5 - PREC)? x - .5: x + .5,
+			                     (y > .5 - PREC)? y - .5: y + .5, z);
 			break;
 		default:
 			break;
 		}
 	}
-	iend = atoms.end ();
-	gcu::SpaceGroup const *res = NULL;
-	gcu::Vector v;
-	std::list <gcu::Vector>::iterator j, jend;
-	for (id = end; id >= start; id--) {
-		std::list <gcu::SpaceGroup const *> &groups = gcu::SpaceGroup::GetSpaceGroups (id);
-		std::list <gcu::SpaceGroup const *>::iterator g, gend = groups.end ();
-		for (g = groups.begin (); g != gend; g++) {
-			for (i = atoms.begin (); i != iend; i++) {
-				a = new Atom (**i);
-				v = a->GetVector ();
-				std::list <gcu::Vector> vv = (*g)->Transform (v);
-				jend = vv.end ();
-				for (j = vv.begin (); j != jend; j++) {
-					x = (*j).GetX ();
-					y = (*j).GetY ();
-					z = (*j).GetZ ();
-					while (x > 1. - PREC)
-						x -= 1.;
-					while (y > 1. - PREC)
-						y -= 1.;
-					while (z > 1. - PREC)
-						z -= 1.;
-					a->SetCoords (x, y, z);
-					for (i0 = atoms.begin (); i0 != iend; i0++)
-						if (*a == **i0)
-							break;
-					if (i0 == iend)
-						goto end_loop;
-				}
-				delete a;
-				if (j != jend)
-					goto end_loop;
-			}
-			if (i == iend)
-				break;
-end_loop:;
-		}
-		if (g != gend) {
-			res = *g;
-			break;
-		}
-	}
-	// clean atoms
-	for (i = atoms.begin (); i != iend; i++)
-		delete *i;
-	// now, search for duplicates in AtomDef
-	if (!res)
-		return NULL;
-	set <Atom *> dups;
-	iend = AtomDef.end ();
-	for (i = AtomDef.begin (); i != iend; i++) {
-		if (dups.find (*i) != dups.end ())
-			continue;
-		a = new Atom (**i);
-		v = a->GetVector ();
-		std::list <gcu::Vector> vv = res->Transform (v);
-		jend = vv.end ();
-		for (j = vv.begin (); j != jend; j++) {
-			x = (*j).GetX ();
-			y = (*j).GetY ();
-			z = (*j).GetZ ();
-			while (x > 1. - PREC)
-				x -= 1.;
-			while (y > 1. - PREC)
-				y -= 1.;
-			while (z > 1. - PREC)
-				z -= 1.;
-			a->SetCoords (x, y, z);
-			for (i0 = i, i0++; i0 != iend; i0++) {
-				if (dups.find (*i0) != dups.end ())
-					continue;
-				if (*a == **i0) {
-					if ((*i0)->x () < (*i)->x () || (*i0)->y () < (*i)->y () || (*i0)->z () < (*i)->z ()) {
-						dups.insert (*i);
-						goto end_loop1;
-					}
-					dups.insert (*i0);
-				}
-			}
-		}
-end_loop1:;
-	}
-	set <Atom *>::iterator k, kend = dups.end ();
-	for (k = dups.begin (); k != kend; k++) {
-		AtomDef.remove (*k);
-		delete *k;
+	gcu::SpaceGroup const *res = finder.FindSpaceGroup (start, end);
+	// now, remove the symmetry equivalent atoms from AtomDef
+	if (res) {
+		std::vector <bool> dups;
+		cell.FindDuplicates (res, dups);
+		unsigned n = 0;
+		for (i = AtomDef.begin (); i != iend; n++)
+			if (dups[n]) {
+				delete *i;
+				i = AtomDef.erase (i);
+			} else
+				i++;
+		key = SymmetryKey ();
 	}
+	m_SymmetryKey = key;
+	m_SymmetryGroup = res;
+	m_SymmetryValid = true;
 	return res;
 }
 
@@ -1505,13 +1701,10 @@ void Document::SetLabel (char const *label)
 	m_Label = g_strdup (label);
 }
 
-typedef struct {int n; std::list<gcr::Atom*> l;} sAtom;
-typedef struct {int n; std::list<gcr::Line*> l;} sLine;
-
 void Document::OnExportVRML (const string &FileName) const
 {
 	char tmp[128];
-	double x0, x1, x2, x3, x4, x5;
+	double x0, x1, x2, x3, x4, x5, length;
 	int n = 0;
 	try {
 		ostringstream file;
@@ -1524,44 +1717,61 @@ void Document::OnExportVRML (const string &FileName) const
 			g_object_unref (stream);
 			throw (int) 1;
 		}
-		std::map<std::string, sAtom>AtomsMap;
-		std::map<std::string, sLine>LinesMap;
+		std::map<std::string, int>AtomsMap;
+		std::map<std::string, int>LinesMap;
+		std::map<std::string, int>::iterator k;
+		unsigned i, max;
+		float const *color;
 
 		file << "#VRML V2.0 utf8" << endl;
 
-		//Create prototypes for atoms
-		gcr::AtomList::const_iterator i;
-		for (i = Atoms.begin(); i != Atoms.end(); i++)
+		//Create prototypes for atoms, all images of a definition share the same
+		std::vector<int> AtomProtos (Atoms.radii.size ());
+		max = AtomProtos.size ();
+		for (i = 0; i < max; i++)
 		{
-			(*i)->GetColor(&x0, &x1, &x2, &x3);
-			snprintf(tmp, sizeof(tmp), "%g %g %g %g %g", (*i)->GetSize(), x0, x1, x2, x3);
-			if (AtomsMap[tmp].l.empty())
+			color = &Atoms.colors[4 * i];
+			snprintf(tmp, sizeof(tmp), "%g %g %g %g %g", Atoms.radii[i], color[0], color[1], color[2], color[3]);
+			if ((k = AtomsMap.find (tmp)) == AtomsMap.end ())
 			{
-				AtomsMap[tmp].n = n;
-				file << "PROTO Atom" << n++ << " [] {Shape {" << endl << "\tgeometry Sphere {radius " << (*i)->GetSize() / 100 << "}" << endl;
-				file << "\tappearance Appearance {" << endl << "\t\tmaterial Material {" << endl << "\t\t\tdiffuseColor " << x0 << " " << x1 << " " << x2 << endl;
-				if (x3 < 1) file << "\t\t\ttransparency " << (1 - x3) << endl;
+				AtomsMap[tmp] = AtomProtos[i] = n;
+				file << "PROTO Atom" << n++ << " [] {Shape {" << endl << "\tgeometry Sphere {radius " << Atoms.radii[i] / 100 << "}" << endl;
+				file << "\tappearance Appearance {" << endl << "\t\tmaterial Material {" << endl << "\t\t\tdiffuseColor " << color[0] << " " << color[1] << " " << color[2] << endl;
+				if (color[3] < 1) file << "\t\t\ttransparency " << (1 - color[3]) << endl;
 				file << "\t\t\tspecularColor 1 1 1" << endl << "\t\t\tshininess 0.9" << endl << "\t\t}" << endl << "\t}\r\n}}" << endl;
 			}
-			AtomsMap[tmp].l.push_back(*i);
+			else
+				AtomProtos[i] = (*k).second;
 		}
 
-		//Create prototypes for bonds
-		gcr::LineList::const_iterator j;
+		//Create prototypes for bonds, the length depends on the image
+		max = Lines.GetCount ();
+		std::vector<int> LineProtos (max);
 		n = 0;
-		for (j = Lines.begin(); j != Lines.end(); j++)
+		for (i = 0; i < max; i++)
 		{
-			(*j)->GetColor(&x0, &x1, &x2, &x3);
-			snprintf(tmp, sizeof(tmp), "%g %g %g %g %g %g", (*j)->Long(), (*j)->GetRadius(), x0, x1, x2, x3);
-			if (LinesMap[tmp].l.empty())
+			x0 = Lines.x1[i];
+			x1 = Lines.y1[i];
+			x2 = Lines.z1[i];
+			NetToCartesian (x0, x1, x2);
+			x3 = Lines.x2[i];
+			x4 = Lines.y2[i];
+			x5 = Lines.z2[i];
+			NetToCartesian (x3, x4, x5);
+			length = sqrt (square (x3 - x0) + square (x4 - x1) + square (x5 - x2));
+			color = &Lines.colors[4 * Lines.def[i]];
+			x0 = Lines.radii[Lines.def[i]];
+			snprintf(tmp, sizeof(tmp), "%g %g %g %g %g %g", length, x0, color[0], color[1], color[2], color[3]);
+			if ((k = LinesMap.find (tmp)) == LinesMap.end ())
 			{
-				LinesMap[tmp].n = n;
-				file << "PROTO Bond" << n++ << " [] {Shape {" << endl << "\tgeometry Cylinder {radius " << (*j)->GetRadius() / 100 << "\theight " << (*j)->Long() / 100 << "}" << endl;
-				file << "\tappearance Appearance {" << endl << "\t\tmaterial Material {" << endl << "\t\t\tdiffuseColor " << x0 << " " << x1 << " " << x2 << endl;
-				if (x3 < 1) file << "\t\t\ttransparency " << (1 - x3) << endl;
+				LinesMap[tmp] = LineProtos[i] = n;
+				file << "PROTO Bond" << n++ << " [] {Shape {" << endl << "\tgeometry Cylinder {radius " << x0 / 100 << "\theight " << length / 100 << "}" << endl;
+				file << "\tappearance Appearance {" << endl << "\t\tmaterial Material {" << endl << "\t\t\tdiffuseColor " << color[0] << " " << color[1] << " " << color[2] << endl;
+				if (color[3] < 1) file << "\t\t\ttransparency " << (1 - color[3]) << endl;
 				file << "\t\t\tspecularColor 1 1 1" << endl << "\t\t\tshininess 0.9" << endl << "\t\t}" << endl << "\t}\r\n}}" << endl;
 			}
-			LinesMap[tmp].l.push_back(*j);
+			else
+				LineProtos[i] = (*k).second;
 		}
 
 		//world begin
@@ -1572,55 +1782,46 @@ void Document::OnExportVRML (const string &FileName) const
 		gcu::Matrix m(x0/90*1.570796326794897, x1/90*1.570796326794897, x2/90*1.570796326794897, gcu::euler);
 		file << "Transform {" << endl << "\tchildren [" << endl;
 
-		std::map<std::string, sAtom>::iterator k;
-		for (k = AtomsMap.begin(); k != AtomsMap.end(); k++)
+		max = Atoms.GetCount ();
+		for (i = 0; i < max; i++)
 		{
-			for (i = (*k).second.l.begin(); i != (*k).second.l.end(); i++)
+			if (!Atoms.cleaved[i])
 			{
-				if (!(*i)->IsCleaved())
-				{
-					x0 = (*i)->x();
-					x1 = (*i)->y();
-					x2 = (*i)->z();
-					m.Transform(x0, x1, x2);
-					file << "\t\tTransform {translation " << x1 / 100 << " " << x2 / 100 << " " << x0 / 100\
-						<<  " children [Atom" << (*k).second.n << " {}]}" << endl;
-				}
+				x0 = Atoms.x[i];
+				x1 = Atoms.y[i];
+				x2 = Atoms.z[i];
+				NetToCartesian (x0, x1, x2);
+				m.Transform(x0, x1, x2);
+				file << "\t\tTransform {translation " << x1 / 100 << " " << x2 / 100 << " " << x0 / 100\
+					<<  " children [Atom" << AtomProtos[Atoms.def[i]] << " {}]}" << endl;
 			}
-			(*k).second.l.clear();
 		}
-		AtomsMap.clear();
 
-		std::map<std::string, sLine>::iterator l;
-		n = 0;
-		for (l = LinesMap.begin(); l != LinesMap.end(); l++)
+		max = Lines.GetCount ();
+		for (i = 0; i < max; i++)
 		{
-			for (j = (*l).second.l.begin(); j != (*l).second.l.end(); j++)
+			if (!Lines.cleaved[i])
 			{
-				if (!(*j)->IsCleaved())
-				{
-					x0 = (*j)->X1();
-					x1 = (*j)->Y1();
-					x2 = (*j)->Z1();
-					m.Transform(x0, x1, x2);
-					x3 = (*j)->X2();
-					x4 = (*j)->Y2();
-					x5 = (*j)->Z2();
-					m.Transform(x3, x4, x5);
-					gcr::Line line(gcr::unique, x0, x1, x2, x3, x4, x5, 0.0, 0.0, 0.0, 0.0, 0.0);
-					line.GetRotation(x0, x1, x2, x3);
-					file << "\t\tTransform {" << endl << "\t\t\trotation " << x1 << " " << x2 << " " << x0 << " " << x3 << endl;
-					x0 = (line.X1() + line.X2()) / 200;
-					x1 = (line.Y1() + line.Y2()) / 200;
-					x2 = (line.Z1() + line.Z2()) / 200;
-					file << "\t\t\ttranslation " << x1 << " " << x2  << " " << x0 <<  endl\
-							<< "\t\t\tchildren [Bond" << (*l).second.n << " {}]}" << endl;
-				}
+				x0 = Lines.x1[i];
+				x1 = Lines.y1[i];
+				x2 = Lines.z1[i];
+				NetToCartesian (x0, x1, x2);
+				m.Transform(x0, x1, x2);
+				x3 = Lines.x2[i];
+				x4 = Lines.y2[i];
+				x5 = Lines.z2[i];
+				NetToCartesian (x3, x4, x5);
+				m.Transform(x3, x4, x5);
+				gcr::Line line(gcr::unique, x0, x1, x2, x3, x4, x5, 0.0, 0.0, 0.0, 0.0, 0.0);
+				line.GetRotation(x0, x1, x2, x3);
+				file << "\t\tTransform {" << endl << "\t\t\trotation " << x1 << " " << x2 << " " << x0 << " " << x3 << endl;
+				x0 = (line.X1() + line.X2()) / 200;
+				x1 = (line.Y1() + line.Y2()) / 200;
+				x2 = (line.Z1() + line.Z2()) / 200;
+				file << "\t\t\ttranslation " << x1 << " " << x2  << " " << x0 <<  endl\
+						<< "\t\t\tchildren [Bond" << LineProtos[i] << " {}]}" << endl;
 			}
-			n++;
-			(*l).second.l.clear();
 		}
-		LinesMap.clear();
 
 		//end of the world
 		file << "\t]" << endl << "}" << endl;
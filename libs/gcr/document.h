@@ -31,9 +31,12 @@
 #include "bond.h"
 #include "line.h"
 #include "cleavage.h"
+#include "images.h"
 #include <gcu/chemistry.h>
 #include <gcu/macros.h>
 #include <gcu/gldocument.h>
+#include <map>
+#include <vector>
 
 namespace gcu {
 class Application;
@@ -112,9 +115,18 @@ crystal->ParseXMLTree (doc->children);
 	void ParseXMLTree (xmlNode* xml);
 /*!
 This method must be called when a new document is loaded or when the definition of the crystal is changed. It recalculates
-everything and updates all the views.
+what changed since the last call and updates all the views. Only the images of modified atoms or lines definitions, and the
+cells added when the size grows, are regenerated; color, radius and cleavage changes are applied to the existing images.
+Changing the lattice or the space group regenerates everything.
 */
 	void Update ();
+/*!
+Schedules a call to Update() for when the main loop becomes idle, and before
+the views are redrawn, so that successive changes, such as those made from the
+dialogs, only update the crystal once. Calling Update() directly runs a pending
+update immediately.
+*/
+	void QueueUpdate ();
 
 	void UpdateAllViews ();
 
@@ -196,7 +208,8 @@ and add some lines.
 */
 	void AddChild (Object* object);
 /*!
-Attempts to infer the symmetry space group for the crystal.
+Attempts to infer the symmetry space group for the crystal. The result is kept
+until the atoms definitions or the lattice change.
 @return the SpaceGroup found.
 */
 	gcu::SpaceGroup const *FindSpaceGroup ();
@@ -458,8 +471,15 @@ Loads a view from a XML document. This methd must be overrided by applications s
 	virtual bool LoadNewView (xmlNodePtr node);
 
 private:
-	void Duplicate (Atom& Atom);
-	void Duplicate (Line& Line);
+	void Duplicate (double x, double y, double z, unsigned index, double const *skip);
+	void Duplicate (Line& Line, unsigned index, double const *skip);
+	void ExpandAtom (Atom &def, unsigned index, double const *skip);
+	void ExpandLine (Line &def, unsigned index, double const *skip);
+	void ClearImages ();
+	void NetToCartesian (double &x, double &y, double &z) const;
+	void BuildBatch () const;
+	guint64 SymmetryKey ();
+	static gboolean OnIdleUpdate (Document *doc);
 	void Error(int num) const;
 
 protected:
@@ -520,17 +540,19 @@ List of the atoms in the definition of the crystal
 */
 	AtomList AtomDef;
 /*!
-List of the atoms displayed.
+The atoms displayed. Their coordinates are net coordinates, the cartesian ones
+are evaluated when drawing.
 */
-	AtomList Atoms;
+	AtomImages Atoms;
 /*!
 List of the lines in the definition of the crystal
 */
 	LineList LineDef;
 /*!
-List of the lines displayed.
+The lines displayed. Their coordinates are net coordinates, the cartesian ones
+are evaluated when drawing.
 */
-	LineList Lines;
+	LineImages Lines;
 /*!
 List of the cleavages defined.
 */
@@ -553,6 +575,26 @@ The document last revision date.
 private:
 	char *m_filename;
 	bool m_bClosing;
+	// the definitions as of the last update, and the definitions matching
+	// the indices used in Atoms and Lines
+	std::map <Atom *, Atom *> m_AtomSnapshots;
+	std::map <Line *, Line *> m_LineSnapshots;
+	std::vector <Atom *> m_AtomSources;
+	std::vector <Line *> m_LineSources;
+	// the symmetry and size used to generate the images
+	bool m_ImagesValid;
+	Lattice m_ImagesLattice;
+	gcu::SpaceGroup const *m_ImagesGroup;
+	double m_ImagesBox[6];
+	// the atoms and lattice used by the last space group search, as a hash
+	bool m_SymmetryValid;
+	guint64 m_SymmetryKey;
+	gcu::SpaceGroup const *m_SymmetryGroup;
+	// the idle source of a pending update
+	guint m_UpdateSource;
+	// net to cartesian conversion, including the centering translation
+	double m_Cartesian[3][3];
+	double m_Center[3];
 	GtkWidget* m_widget;
 	View *m_pActiveView;
 	std::string m_DefaultLabel;
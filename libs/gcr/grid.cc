@@ -27,6 +27,7 @@
 #include <gcugtk/marshalers.h>
 #include <goffice/goffice.h>
 #include <glib/gi18n-lib.h>
+#include <algorithm>
 #include <list>
 #include <set>
 #include <string>
@@ -38,6 +39,25 @@
 #define CURSOR_ON_TIME 800
 #define CURSOR_OFF_TIME 400
 
+// the values of a column in their native type, only the vector matching the
+// column type is used, booleans being stored as integers
+struct GcrGridColumn
+{
+	std::vector < int > ints;
+	std::vector < unsigned > uints;
+	std::vector < double > doubles;
+	std::vector < std::string > strings;
+};
+
+// the layouts of a displayed row, kept until the row changes or scrolls out
+struct GcrGridRowLayouts
+{
+	int row;
+	PangoLayout *header;
+	std::vector < PangoLayout * > cells; // NULL for boolean columns
+	std::vector < int > widths; // the header width comes last
+};
+
 struct _GcrGrid
 {
 	GtkLayout base;
@@ -53,7 +73,12 @@ struct _GcrGrid
 	std::string *titles;
 	GType *types;
 	bool *editable;
-	std::vector < std::string * > row_data; // storing as string since this is what is displayed
+	GcrGridColumn *columns;
+	// the text of the edited cell, kept until the cell changes
+	std::string *text, *scratch;
+	int text_row, text_col;
+	// the layouts of the displayed rows, row i uses layouts[i % layouts->size ()]
+	std::vector < GcrGridRowLayouts > *layouts;
 	bool cursor_visible;
 	unsigned long cursor_signal;
 	std::string *orig_string;
@@ -87,13 +112,167 @@ typedef struct
 
 // static functions
 
+static void gcr_grid_format (GcrGrid *grid, unsigned row, unsigned col, std::string &text)
+{
+	char *buf = NULL;
+	switch (grid->types[col]) {
+	case G_TYPE_INT: {
+		int value = grid->columns[col].ints[row];
+		buf = (value < 0)? g_strdup_printf ("−%d", -value): g_strdup_printf ("%d", value);
+		break;
+	}
+	case G_TYPE_UINT:
+		buf = g_strdup_printf ("%u", grid->columns[col].uints[row]);
+		break;
+	case G_TYPE_DOUBLE: {
+		double value = grid->columns[col].doubles[row];
+		buf = (value < 0)? g_strdup_printf ("−%f", -value): g_strdup_printf ("%f", value);
+		break;
+	}
+	case G_TYPE_STRING:
+		text = grid->columns[col].strings[row];
+		return;
+	case G_TYPE_BOOLEAN:
+		text = grid->columns[col].ints[row]? "t": "f";
+		return;
+	default:
+		text.clear ();
+		return;
+	}
+	text = buf;
+	g_free (buf);
+}
+
+// returns the text of a cell, the edited text if it is the current cell,
+// otherwise a temporary string overwritten by the next call
+static std::string &gcr_grid_get_text (GcrGrid *grid, int row, int col)
+{
+	if (row == grid->text_row && col == grid->text_col)
+		return *grid->text;
+	if (row == grid->row && col == grid->col) {
+		gcr_grid_format (grid, row, col, *grid->text);
+		grid->text_row = row;
+		grid->text_col = col;
+		return *grid->text;
+	}
+	gcr_grid_format (grid, row, col, *grid->scratch);
+	return *grid->scratch;
+}
+
+static void gcr_grid_invalidate_row (GcrGrid *grid, unsigned row)
+{
+	if (static_cast < int > (row) == grid->text_row)
+		grid->text_row = grid->text_col = -1;
+	if (!grid->layouts->empty ()) {
+		GcrGridRowLayouts &layouts = (*grid->layouts)[row % grid->layouts->size ()];
+		if (layouts.row == static_cast < int > (row))
+			layouts.row = -1;
+	}
+}
+
+static void gcr_grid_clear_layouts (GcrGrid *grid)
+{
+	std::vector < GcrGridRowLayouts >::iterator i, end = grid->layouts->end ();
+	for (i = grid->layouts->begin (); i != end; i++) {
+		if ((*i).header)
+			g_object_unref ((*i).header);
+		for (unsigned j = 0; j < (*i).cells.size (); j++)
+			if ((*i).cells[j])
+				g_object_unref ((*i).cells[j]);
+	}
+	grid->layouts->clear ();
+}
+
+// the rows are renumbered, so nothing can be kept
+static void gcr_grid_invalidate_rows (GcrGrid *grid)
+{
+	grid->text_row = grid->text_col = -1;
+	std::vector < GcrGridRowLayouts >::iterator i, end = grid->layouts->end ();
+	for (i = grid->layouts->begin (); i != end; i++)
+		(*i).row = -1;
+}
+
+static GcrGridRowLayouts &gcr_grid_get_layouts (GcrGrid *grid, unsigned row)
+{
+	// one more slot than the visible rows so that scrolling keeps the rows which stay visible
+	unsigned needed = ((grid->nb_visible < grid->rows)? grid->nb_visible: grid->rows) + 2;
+	if (grid->layouts->size () < needed) {
+		gcr_grid_clear_layouts (grid);
+		GcrGridRowLayouts empty = {-1, NULL, std::vector < PangoLayout * > (), std::vector < int > ()};
+		grid->layouts->resize (needed, empty);
+	}
+	GcrGridRowLayouts &layouts = (*grid->layouts)[row % grid->layouts->size ()];
+	if (layouts.row == static_cast < int > (row))
+		return layouts;
+	GtkWidget *w = GTK_WIDGET (grid);
+	if (!layouts.header) {
+		layouts.header = gtk_widget_create_pango_layout (w, "");
+		layouts.cells.resize (grid->cols);
+		layouts.widths.resize (grid->cols + 1);
+		for (unsigned i = 0; i < grid->cols; i++)
+			// booleans are drawn using pixbufs
+			layouts.cells[i] = (grid->types[i] == G_TYPE_BOOLEAN)? NULL: gtk_widget_create_pango_layout (w, "");
+	}
+	char *buf = g_strdup_printf ("%u", row + 1);
+	pango_layout_set_text (layouts.header, buf, -1);
+	g_free (buf);
+	pango_layout_get_pixel_size (layouts.header, &layouts.widths[grid->cols], NULL);
+	for (unsigned i = 0; i < grid->cols; i++)
+		if (layouts.cells[i]) {
+			gcr_grid_format (grid, row, i, *grid->scratch);
+			pango_layout_set_markup (layouts.cells[i], grid->scratch->c_str (), -1);
+			pango_layout_get_pixel_size (layouts.cells[i], &layouts.widths[i], NULL);
+		}
+	layouts.row = row;
+	return layouts;
+}
+
+static void gcr_grid_resize_columns (GcrGrid *grid, unsigned rows)
+{
+	for (unsigned i = 0; i < grid->cols; i++)
+		switch (grid->types[i]) {
+		case G_TYPE_INT:
+		case G_TYPE_BOOLEAN:
+			grid->columns[i].ints.resize (rows, 0);
+			break;
+		case G_TYPE_UINT:
+			grid->columns[i].uints.resize (rows, 0);
+			break;
+		case G_TYPE_DOUBLE:
+			grid->columns[i].doubles.resize (rows, 0.);
+			break;
+		case G_TYPE_STRING:
+			grid->columns[i].strings.resize (rows);
+			break;
+		default:
+			break;
+		}
+}
+
+static void gcr_grid_rows_changed (GcrGrid *grid)
+{
+	if (grid->rows) {
+		gtk_adjustment_set_page_size (grid->vadj, static_cast < double > (grid->nb_visible) / grid->rows);
+		gtk_adjustment_set_upper (grid->vadj, (grid->nb_visible < grid->rows)? grid->rows - grid->nb_visible: .1);
+		if (grid->rows < grid->nb_visible + grid->first_visible) {
+			grid->first_visible = (grid->nb_visible < grid->rows)? grid->rows - grid->nb_visible: 0;
+			gtk_adjustment_set_value (grid->vadj, grid->first_visible);
+		}
+	} else {
+		gtk_adjustment_set_page_size (grid->vadj, 1.);
+		grid->first_visible = 0;
+	}
+	gtk_widget_queue_draw (GTK_WIDGET (grid));
+}
+
 static bool gcr_grid_validate_change (GcrGrid *grid)
 {
 	if (grid->row < 0 || grid->col < 0)
 		return true;
-	std::string new_string = grid->row_data[grid->row][grid->col];
+	std::string new_string = gcr_grid_get_text (grid, grid->row, grid->col);
 	if (new_string == *grid->orig_string)
 		return true;
+	bool changed;
 	switch (grid->types[grid->col]) {
 	case G_TYPE_INT: {
 		long orig, next;
@@ -114,13 +293,9 @@ static bool gcr_grid_validate_change (GcrGrid *grid)
 			next = -next;
 		if (buf && *buf)
 			goto error_handler;
-		buf = (next < 0)? g_strdup_printf ("−%ld", -next): g_strdup_printf ("%ld", next);
-		grid->row_data[grid->row][grid->col] = buf;
-		grid->sel_start = grid->cursor_index = strlen (buf);
-		g_free (buf);
-		if (orig != next)
-			g_signal_emit (grid, gcr_grid_signals[VALUE_CHANGED], 0, grid->row, grid->col);
-		return true;
+		grid->columns[grid->col].ints[grid->row] = next;
+		changed = orig != next;
+		break;
 	}
 	case G_TYPE_UINT: {
 		unsigned long orig, next;
@@ -129,13 +304,9 @@ static bool gcr_grid_validate_change (GcrGrid *grid)
 		next = strtoul (new_string.c_str (), &buf, 10);
 		if (buf && *buf)
 			goto error_handler;
-		buf = g_strdup_printf ("%lu", next);
-		grid->row_data[grid->row][grid->col] = buf;
-		grid->sel_start = grid->cursor_index = strlen (buf);
-		g_free (buf);
-		if (orig != next)
-			g_signal_emit (grid, gcr_grid_signals[VALUE_CHANGED], 0, grid->row, grid->col);
-		return true;
+		grid->columns[grid->col].uints[grid->row] = next;
+		changed = orig != next;
+		break;
 	}
 	case G_TYPE_DOUBLE: {
 		double orig, next;
@@ -156,20 +327,20 @@ static bool gcr_grid_validate_change (GcrGrid *grid)
 			next = -next;
 		if (buf && *buf)
 			goto error_handler;
-		buf = (next < 0)? g_strdup_printf ("−%f", -next): g_strdup_printf ("%f", next);
-		grid->row_data[grid->row][grid->col] = buf;
-		grid->sel_start = grid->cursor_index = strlen (buf);
-		g_free (buf);
-		if (orig != next)
-			g_signal_emit (grid, gcr_grid_signals[VALUE_CHANGED], 0, grid->row, grid->col);
-		return true;
-	}
-	case G_TYPE_BOOLEAN:
+		grid->columns[grid->col].doubles[grid->row] = next;
+		changed = orig != next;
 		break;
+	}
 	default:
-		break;
+		return false;
 	}
-	return false;
+	// display the value as it is stored
+	gcr_grid_invalidate_row (grid, grid->row);
+	gcr_grid_get_text (grid, grid->row, grid->col);
+	grid->sel_start = grid->cursor_index = grid->text->length ();
+	if (changed)
+		g_signal_emit (grid, gcr_grid_signals[VALUE_CHANGED], 0, grid->row, grid->col);
+	return true;
 error_handler:
 	// directly using gtk to display an error message since we dont't know about Application there
 	GtkWidget *widget = gtk_message_dialog_new (GTK_WINDOW (gtk_widget_get_toplevel (GTK_WIDGET (grid))),
@@ -232,12 +403,9 @@ static gboolean gcr_grid_draw (GtkWidget *w, cairo_t* cr)
 		                             		GTK_STATE_FLAG_ACTIVE: GTK_STATE_FLAG_NORMAL);
 		gtk_render_background (ctxt, cr, 0, y, grid->header_width + 1, grid->row_height + 1);
 		gtk_render_frame (ctxt, cr, 0, y, grid->header_width + 1, grid->row_height + 1);
-		char *buf = g_strdup_printf("%d", ++row);
-		pango_layout_set_text (l, buf, -1);
-		pango_layout_get_pixel_size (l, &width, NULL);
-		cairo_move_to (cr, (grid->header_width - width) / 2, y + grid->line_offset);
-		pango_cairo_show_layout (cr, l);
-		g_free (buf);
+		GcrGridRowLayouts &layouts = gcr_grid_get_layouts (grid, row++);
+		cairo_move_to (cr, (grid->header_width - layouts.widths[grid->cols]) / 2, y + grid->line_offset);
+		pango_cairo_show_layout (cr, layouts.header);
 		y += grid->row_height;
 	}
 	y = grid->row_height;
@@ -267,6 +435,7 @@ static gboolean gcr_grid_draw (GtkWidget *w, cairo_t* cr)
 	row = grid->first_visible;
 	for (j = 0; j < max; j++) {
 		pos = grid->header_width;
+		GcrGridRowLayouts &layouts = gcr_grid_get_layouts (grid, row);
 		for (i = 0; i < grid->cols; i++) {
 			cairo_save (cr);
 			cairo_rectangle (cr, pos + .5, y + .5, grid->col_widths[i], grid->row_height);
@@ -274,7 +443,7 @@ static gboolean gcr_grid_draw (GtkWidget *w, cairo_t* cr)
 			cairo_stroke (cr);
 			cairo_restore (cr);
 			if (grid->types[i] == G_TYPE_BOOLEAN) {
-				GdkPixbuf *pixbuf = (grid->row_data[row][i] == "t")? checked: unchecked;
+				GdkPixbuf *pixbuf = grid->columns[i].ints[row]? checked: unchecked;
 				cairo_save (cr);
 				cairo_translate (cr, pos + .5 * (grid->col_widths[i] - grid->row_height), y);
 				cairo_rectangle (cr, 2., 2.,
@@ -282,42 +451,45 @@ static gboolean gcr_grid_draw (GtkWidget *w, cairo_t* cr)
 				gdk_cairo_set_source_pixbuf (cr, pixbuf, 0., 0.);
 				cairo_fill (cr);
 				cairo_restore (cr);
-			} else {
-				pango_layout_set_text (l, grid->row_data[row][i].c_str(), -1);
+			} else if (static_cast < int > (row) == grid->row && static_cast < int > (i) == grid->col) {
+				// the edited cell is the only one which is not cached
+				std::string &text = gcr_grid_get_text (grid, row, i);
+				pango_layout_set_text (l, text.c_str(), -1);
 				pango_layout_get_pixel_size (l, &width, NULL);
-				pango_layout_set_markup (l, grid->row_data[row][i].c_str(), -1);
-				if (static_cast < int > (row) == grid->row && static_cast < int > (i) == grid->col) {
-					if (grid->cursor_index != grid->sel_start) {
-						PangoAttrList *al = pango_attr_list_new ();
-						int start, end;
-						if (grid->cursor_index < grid->sel_start) {
-							start = grid->cursor_index;
-							end = grid->sel_start;
-						} else {
-							end = grid->cursor_index;
-							start = grid->sel_start;
-						}
-						PangoAttribute *attr = pango_attr_foreground_new (0xffff, 0xffff, 0xffff);
-						attr->start_index = start;
-						attr->end_index =end;
-						pango_attr_list_insert (al, attr);
-						attr = pango_attr_background_new (0, 0, 0);
-						attr->start_index = start;
-						attr->end_index =end;
-						pango_attr_list_insert (al, attr);
-						pango_layout_set_attributes (l, al);
-						pango_attr_list_unref (al);
-					}
-					if (grid->cursor_visible) {
-						PangoRectangle rect;
-						pango_layout_get_cursor_pos (l, grid->cursor_index, &rect, NULL);
-						cairo_move_to (cr, pos + (grid->col_widths[i] - width) / 2 + rect.x / PANGO_SCALE + .5, y + grid->line_offset + rect.y / PANGO_SCALE);
-						cairo_rel_line_to (cr, 0, rect.height / PANGO_SCALE);
-						cairo_stroke (cr);
+				pango_layout_set_markup (l, text.c_str(), -1);
+				if (grid->cursor_index != grid->sel_start) {
+					PangoAttrList *al = pango_attr_list_new ();
+					int start, end;
+					if (grid->cursor_index < grid->sel_start) {
+						start = grid->cursor_index;
+						end = grid->sel_start;
+					} else {
+						end = grid->cursor_index;
+						start = grid->sel_start;
 					}
+					PangoAttribute *attr = pango_attr_foreground_new (0xffff, 0xffff, 0xffff);
+					attr->start_index = start;
+					attr->end_index =end;
+					pango_attr_list_insert (al, attr);
+					attr = pango_attr_background_new (0, 0, 0);
+					attr->start_index = start;
+					attr->end_index =end;
+					pango_attr_list_insert (al, attr);
+					pango_layout_set_attributes (l, al);
+					pango_attr_list_unref (al);
+				}
+				if (grid->cursor_visible) {
+					PangoRectangle rect;
+					pango_layout_get_cursor_pos (l, grid->cursor_index, &rect, NULL);
+					cairo_move_to (cr, pos + (grid->col_widths[i] - width) / 2 + rect.x / PANGO_SCALE + .5, y + grid->line_offset + rect.y / PANGO_SCALE);
+					cairo_rel_line_to (cr, 0, rect.height / PANGO_SCALE);
+					cairo_stroke (cr);
 				}
 				cairo_move_to (cr, pos + (grid->col_widths[i] - width) / 2, y + grid->line_offset);
 				pango_cairo_show_layout (cr, l);
+			} else {
+				cairo_move_to (cr, pos + (grid->col_widths[i] - layouts.widths[i]) / 2, y + grid->line_offset);
+				pango_cairo_show_layout (cr, layouts.cells[i]);
 			}
 			pos += grid->col_widths[i];
 		}
@@ -327,6 +499,7 @@ static gboolean gcr_grid_draw (GtkWidget *w, cairo_t* cr)
 	}
 	cairo_restore (cr);
 	gtk_style_context_restore (ctxt);
+	g_object_unref (l);
 	return parent_class->draw (w, cr);
 }
 
@@ -376,8 +549,12 @@ static void gcr_grid_finalize (GObject *obj)
 	delete [] grid->titles;
 	delete [] grid->types;
 	delete [] grid->editable;
-	for (unsigned i = 0 ; i < grid->rows; i++)
-		delete [] grid->row_data[i];
+	delete [] grid->columns;
+	delete grid->text;
+	delete grid->scratch;
+	delete grid->orig_string;
+	gcr_grid_clear_layouts (grid);
+	delete grid->layouts;
 	delete grid->selected_rows;
 	reinterpret_cast < GObjectClass * > (parent_class)->finalize (obj);
 }
@@ -489,20 +666,21 @@ static gboolean gcr_grid_button_press_event (GtkWidget *widget, GdkEventButton *
 		case G_TYPE_DOUBLE:
 			if (event->type == GDK_BUTTON_PRESS) {
 				x -=  grid->col_widths[grid->col];
-				PangoLayout *l = gtk_widget_create_pango_layout (widget, grid->row_data[grid->row][grid->col].c_str());
+				PangoLayout *l = gtk_widget_create_pango_layout (widget, gcr_grid_get_text (grid, grid->row, grid->col).c_str());
 				int xpos, startx;
 				pango_layout_get_pixel_size (l, &xpos, NULL);
 				startx = x + (grid->col_widths[grid->col] - xpos) / 2;
 				xpos = event->x - startx;
 				int index, trailing;
 				pango_layout_xy_to_index (l, xpos * PANGO_SCALE, 0, &index, &trailing);
+				g_object_unref (l);
 				index += trailing;
 				grid->cursor_index = index;
 				if ((event->state & GDK_SHIFT_MASK) == 0)
 					grid->sel_start = index;
 			} else if (event->type == GDK_2BUTTON_PRESS) {
 				grid->sel_start = 0;
-				grid->cursor_index = grid->row_data[grid->row][grid->col].length ();
+				grid->cursor_index = gcr_grid_get_text (grid, grid->row, grid->col).length ();
 			}
 			break;
 		case G_TYPE_BOOLEAN:
@@ -511,7 +689,8 @@ static gboolean gcr_grid_button_press_event (GtkWidget *widget, GdkEventButton *
 			// for now toggle the button if the click occurs near enough
 			x = event->x - x + grid->col_widths[new_col] / 2.;
 			if (fabs (x) < grid->row_height / 2) {
-				grid->row_data[grid->row][grid->col] = (grid->row_data[grid->row][grid->col] == "t")? "f": "t";
+				grid->columns[grid->col].ints[grid->row] = !grid->columns[grid->col].ints[grid->row];
+				gcr_grid_invalidate_row (grid, grid->row);
 				value_changed = new_col;
 			}
 			break;
@@ -520,7 +699,7 @@ static gboolean gcr_grid_button_press_event (GtkWidget *widget, GdkEventButton *
 			g_critical ("Unsupported type.");
 			break;
 		}
-		*grid->orig_string = grid->row_data[grid->row][grid->col];
+		*grid->orig_string = gcr_grid_get_text (grid, grid->row, grid->col);
 	} else
 		grid->cursor_index = -1;
 	if (grid->cursor_index >= 0 && grid->cursor_signal == 0) {
@@ -574,20 +753,21 @@ static gboolean gcr_grid_motion_notify_event (GtkWidget *widget, GdkEventMotion
 				case G_TYPE_UINT:
 				case G_TYPE_DOUBLE: {
 					x -=  grid->col_widths[grid->col];
-					PangoLayout *l = gtk_widget_create_pango_layout (widget, grid->row_data[grid->row][grid->col].c_str());
+					PangoLayout *l = gtk_widget_create_pango_layout (widget, gcr_grid_get_text (grid, grid->row, grid->col).c_str());
 					int xpos, startx;
 					pango_layout_get_pixel_size (l, &xpos, NULL);
 					startx = x + (grid->col_widths[grid->col] - xpos) / 2;
 					xpos = event->x - startx;
 					int index, trailing;
 					pango_layout_xy_to_index (l, xpos * PANGO_SCALE, 0, &index, &trailing);
+					g_object_unref (l);
 					grid->cursor_index = index + trailing;
 					break;
 				}
 				default:	// nothing to do
 					break;
 				}
-				*grid->orig_string = grid->row_data[grid->row][grid->col];
+				*grid->orig_string = gcr_grid_get_text (grid, grid->row, grid->col);
 			}
 		} else
 			grid->col = -1;
@@ -648,13 +828,14 @@ static gboolean gcr_grid_key_press_event (GtkWidget *widget, GdkEventKey *event)
 					return true;
 			} while (!grid->editable[new_col]);
 		}
-		new_index = grid->row_data[new_row][new_col].length ();
+		new_index = gcr_grid_get_text (grid, new_row, new_col).length ();
 		grid->sel_start = 0;
 		break;
 	case GDK_KEY_Left:
 	case GDK_KEY_KP_Left:
 		if (new_index > 0) {
-			new_index = g_utf8_prev_char (grid->row_data[new_row][new_col].c_str () + grid->cursor_index) - grid->row_data[new_row][new_col].c_str ();
+			char const *text = gcr_grid_get_text (grid, new_row, new_col).c_str ();
+			new_index = g_utf8_prev_char (text + grid->cursor_index) - text;
 			if ((event->state & GDK_SHIFT_MASK) == 0)
 				grid->sel_start = new_index;
 		} else {
@@ -672,14 +853,15 @@ static gboolean gcr_grid_key_press_event (GtkWidget *widget, GdkEventKey *event)
 					} else
 						return true;
 				} while (!grid->editable[new_col]);
-				new_index = grid->row_data[new_row][new_col].length ();
+				new_index = gcr_grid_get_text (grid, new_row, new_col).length ();
 			}
 		}
 		break;
 	case GDK_KEY_Right:
 	case GDK_KEY_KP_Right:
-		if (new_index >= 0 && grid->cursor_index < static_cast < int > (grid->row_data[new_row][new_col].length ())) {
-			new_index = g_utf8_next_char (grid->row_data[new_row][new_col].c_str () + grid->cursor_index) - grid->row_data[new_row][new_col].c_str ();
+		if (new_index >= 0 && grid->cursor_index < static_cast < int > (gcr_grid_get_text (grid, new_row, new_col).length ())) {
+			char const *text = gcr_grid_get_text (grid, new_row, new_col).c_str ();
+			new_index = g_utf8_next_char (text + grid->cursor_index) - text;
 			if ((event->state & GDK_SHIFT_MASK) == 0)
 				grid->sel_start = new_index;
 		} else {
@@ -775,9 +957,9 @@ static gboolean gcr_grid_key_press_event (GtkWidget *widget, GdkEventKey *event)
 	case GDK_KEY_KP_Subtract:
 	case GDK_KEY_minus:
 		if (grid->types[new_col] == G_TYPE_INT || grid->types[new_col] == G_TYPE_DOUBLE) {
-			if ((new_index > 0 && grid->sel_start > 0) || !grid->row_data[new_row][new_col].compare (0, strlen ("−"), "−"))
+			if ((new_index > 0 && grid->sel_start > 0) || !gcr_grid_get_text (grid, new_row, new_col).compare (0, strlen ("−"), "−"))
 				return true;
-			grid->row_data[new_row][new_col].insert (0, "−");
+			gcr_grid_get_text (grid, new_row, new_col).insert (0, "−");
 			grid->sel_start = new_index = strlen ("−");
 		}
 		break;
@@ -817,7 +999,7 @@ static gboolean gcr_grid_key_press_event (GtkWidget *widget, GdkEventKey *event)
 			if (event->state & GDK_SHIFT_MASK)
 				new_row = 0;
 			grid->sel_start = 0;
-			new_index = grid->row_data[new_row][0].length ();
+			new_index = gcr_grid_get_text (grid, new_row, 0).length ();
 			break;
 		}
 		if (new_index <= 0)
@@ -833,12 +1015,12 @@ static gboolean gcr_grid_key_press_event (GtkWidget *widget, GdkEventKey *event)
 			if (event->state & GDK_SHIFT_MASK)
 				new_row = grid->rows - 1;
 			grid->sel_start = 0;
-			new_index = grid->row_data[new_row][new_col].length ();
+			new_index = gcr_grid_get_text (grid, new_row, new_col).length ();
 			break;
 		}
-		if (new_index == static_cast < int > (grid->row_data[new_row][new_col].length ()))
+		if (new_index == static_cast < int > (gcr_grid_get_text (grid, new_row, new_col).length ()))
 			return true;
-		new_index = grid->row_data[new_row][new_col].length ();
+		new_index = gcr_grid_get_text (grid, new_row, new_col).length ();
 		if ((event->state & GDK_SHIFT_MASK) == 0)
 			grid->sel_start = new_index;
 		break;
@@ -851,9 +1033,9 @@ static gboolean gcr_grid_key_press_event (GtkWidget *widget, GdkEventKey *event)
 	case GDK_KEY_Delete:
 	case GDK_KEY_KP_Delete:
 		if (grid->sel_start == grid->cursor_index) {
-			if (grid->sel_start == static_cast < int > (grid->row_data[new_row][new_col].length ()))
+			if (grid->sel_start == static_cast < int > (gcr_grid_get_text (grid, new_row, new_col).length ()))
 				return true;
-			char const *start =  grid->row_data[new_row][new_col].c_str () + grid->sel_start, *end;
+			char const *start =  gcr_grid_get_text (grid, new_row, new_col).c_str () + grid->sel_start, *end;
 			end = g_utf8_next_char (start);
 			grid->cursor_index = grid->sel_start + (end - start);
 		} else if (grid->sel_start > grid->cursor_index) {
@@ -861,14 +1043,14 @@ static gboolean gcr_grid_key_press_event (GtkWidget *widget, GdkEventKey *event)
 			grid->sel_start = grid->cursor_index;
 			grid->cursor_index = buf;
 		}
-		grid->row_data[new_row][new_col].erase (grid->sel_start, grid->cursor_index - grid->sel_start);
+		gcr_grid_get_text (grid, new_row, new_col).erase (grid->sel_start, grid->cursor_index - grid->sel_start);
 		new_index = grid->sel_start;
 		break;
 	case GDK_KEY_BackSpace:
 		if (grid->sel_start == grid->cursor_index) {
 			if (grid->sel_start == 0)
 				return true;
-			char const *start =  grid->row_data[new_row][new_col].c_str () + grid->sel_start, *end;
+			char const *start =  gcr_grid_get_text (grid, new_row, new_col).c_str () + grid->sel_start, *end;
 			end = g_utf8_prev_char (start);
 			grid->sel_start = grid->cursor_index - (start - end);
 		} else if (grid->sel_start > grid->cursor_index) {
@@ -876,12 +1058,12 @@ static gboolean gcr_grid_key_press_event (GtkWidget *widget, GdkEventKey *event)
 			grid->sel_start = grid->cursor_index;
 			grid->cursor_index = buf;
 		}
-		grid->row_data[new_row][new_col].erase (grid->sel_start, grid->cursor_index - grid->sel_start);
+		gcr_grid_get_text (grid, new_row, new_col).erase (grid->sel_start, grid->cursor_index - grid->sel_start);
 		new_index = grid->sel_start;
 		break;
 	case GDK_KEY_period: {
 		int pos, start, end;
-		char const *sep;
+		char const *sep, *text;
 		if (new_index < grid->sel_start) {
 			start = new_index;
 			end = grid->sel_start;
@@ -891,8 +1073,8 @@ static gboolean gcr_grid_key_press_event (GtkWidget *widget, GdkEventKey *event)
 		}
 		if (grid->types[new_col] != G_TYPE_DOUBLE ||
 		    strcmp (go_locale_get_decimal ()->str, ".") ||
-		    ((sep = strchr (grid->row_data[new_row][new_col].c_str (), '.')) != NULL &&
-		    (pos = sep - grid->row_data[new_row][new_col].c_str (),
+		    ((sep = strchr (text = gcr_grid_get_text (grid, new_row, new_col).c_str (), '.')) != NULL &&
+		    (pos = sep - text,
 		     pos < start || pos > end)))
 			return true;
 		new_char = '.';
@@ -900,7 +1082,7 @@ static gboolean gcr_grid_key_press_event (GtkWidget *widget, GdkEventKey *event)
 	}
 	case GDK_KEY_comma: {
 		int pos, start, end;
-		char const *sep;
+		char const *sep, *text;
 		if (new_index < grid->sel_start) {
 			start = new_index;
 			end = grid->sel_start;
@@ -910,8 +1092,8 @@ static gboolean gcr_grid_key_press_event (GtkWidget *widget, GdkEventKey *event)
 		}
 		if (grid->types[new_col] != G_TYPE_DOUBLE ||
 		    strcmp (go_locale_get_decimal ()->str, ",") ||
-		    ((sep = strchr (grid->row_data[new_row][new_col].c_str (), ',')) != NULL &&
-		    (pos = sep - grid->row_data[new_row][new_col].c_str (),
+		    ((sep = strchr (text = gcr_grid_get_text (grid, new_row, new_col).c_str (), ',')) != NULL &&
+		    (pos = sep - text,
 		     pos < start || pos > end)))
 			return true;
 		new_char = ',';
@@ -919,7 +1101,7 @@ static gboolean gcr_grid_key_press_event (GtkWidget *widget, GdkEventKey *event)
 	}
 	case GDK_KEY_KP_Decimal: {
 		int pos, start, end;
-		char const *sep;
+		char const *sep, *text;
 		if (new_index < grid->sel_start) {
 			start = new_index;
 			end = grid->sel_start;
@@ -928,12 +1110,12 @@ static gboolean gcr_grid_key_press_event (GtkWidget *widget, GdkEventKey *event)
 			end = new_index;
 		}
 		if (grid->types[new_col] != G_TYPE_DOUBLE ||
-		    ((sep = strstr (grid->row_data[new_row][new_col].c_str (), go_locale_get_decimal ()->str)) != NULL &&
-		    (pos = sep - grid->row_data[new_row][new_col].c_str (),
+		    ((sep = strstr (text = gcr_grid_get_text (grid, new_row, new_col).c_str (), go_locale_get_decimal ()->str)) != NULL &&
+		    (pos = sep - text,
 		     pos < start || pos > end)))
 			return true;
 		// don't add anything before the minus sign
-		if (new_index == 0 && grid->sel_start == 0 && !grid->row_data[new_row][new_col].compare (0, strlen ("−"), "−"))
+		if (new_index == 0 && grid->sel_start == 0 && !gcr_grid_get_text (grid, new_row, new_col).compare (0, strlen ("−"), "−"))
 			return true;
 		// first delete the selected chars if any
 		if (new_index != grid->sel_start) {
@@ -944,12 +1126,12 @@ static gboolean gcr_grid_key_press_event (GtkWidget *widget, GdkEventKey *event)
 				length = new_index - grid->sel_start;
 				new_index = grid->sel_start;
 			}
-			grid->row_data[new_row][new_col].erase (new_index, length);
+			gcr_grid_get_text (grid, new_row, new_col).erase (new_index, length);
 		}
-		if (grid->cursor_index == 0 && !strncmp (grid->row_data[new_row][new_col].c_str (), "−", strlen ("−")))
+		if (grid->cursor_index == 0 && !strncmp (gcr_grid_get_text (grid, new_row, new_col).c_str (), "−", strlen ("−")))
 		    return true;	// do not insert a figure before the minus sign
 		// insert the new char(s)
-		grid->row_data[new_row][new_col].insert (new_index, go_locale_get_decimal ()->str);
+		gcr_grid_get_text (grid, new_row, new_col).insert (new_index, go_locale_get_decimal ()->str);
 		new_index += go_locale_get_decimal ()->len;
 		grid->sel_start = new_index;
 		break;
@@ -957,7 +1139,8 @@ static gboolean gcr_grid_key_press_event (GtkWidget *widget, GdkEventKey *event)
 	case GDK_KEY_space:
 		if (grid->types[new_col] != G_TYPE_BOOLEAN)
 			return true;
-		grid->row_data[new_row][new_col] = (grid->row_data[new_row][new_col] == "t")? "f": "t";
+		grid->columns[new_col].ints[new_row] = !grid->columns[new_col].ints[new_row];
+		gcr_grid_invalidate_row (grid, new_row);
 		g_signal_emit (grid, gcr_grid_signals[VALUE_CHANGED], 0, new_row, new_col);
 		break;
 	default:
@@ -965,7 +1148,7 @@ static gboolean gcr_grid_key_press_event (GtkWidget *widget, GdkEventKey *event)
 	}
 	if (new_char > 0) {
 		// don't add aanything before the minus sign
-		if (new_index == 0 && grid->sel_start == 0 && !grid->row_data[new_row][new_col].compare (0, strlen ("−"), "−"))
+		if (new_index == 0 && grid->sel_start == 0 && !gcr_grid_get_text (grid, new_row, new_col).compare (0, strlen ("−"), "−"))
 			return true;
 		// first delete the selected chars if any
 		if (new_index != grid->sel_start) {
@@ -976,12 +1159,12 @@ static gboolean gcr_grid_key_press_event (GtkWidget *widget, GdkEventKey *event)
 				length = new_index - grid->sel_start;
 				new_index = grid->sel_start;
 			}
-			grid->row_data[new_row][new_col].erase (new_index, length);
+			gcr_grid_get_text (grid, new_row, new_col).erase (new_index, length);
 		}
 		// insert the new char
-		if (grid->cursor_index == 0 && !strncmp (grid->row_data[new_row][new_col].c_str (), "−", strlen ("−")))
+		if (grid->cursor_index == 0 && !strncmp (gcr_grid_get_text (grid, new_row, new_col).c_str (), "−", strlen ("−")))
 		    return true;	// do not insert a figure before the minus sign
-		grid->row_data[new_row][new_col].insert (new_index, 1, new_char);
+		gcr_grid_get_text (grid, new_row, new_col).insert (new_index, 1, new_char);
 		new_index++;
 		grid->sel_start = new_index;
 	}
@@ -993,7 +1176,7 @@ static gboolean gcr_grid_key_press_event (GtkWidget *widget, GdkEventKey *event)
 		if (new_col >= 0 && grid->editable[new_col]) {
 			grid->row = new_row;
 			grid->col = new_col;
-			*grid->orig_string = grid->row_data[new_row][new_col];
+			*grid->orig_string = gcr_grid_get_text (grid, new_row, new_col);
 			int l = grid->orig_string->length ();
 			if (new_index > l)
 				new_index = grid->sel_start = l;
@@ -1015,6 +1198,15 @@ static gboolean gcr_grid_key_press_event (GtkWidget *widget, GdkEventKey *event)
 	return true;
 }
 
+static void gcr_grid_style_updated (GtkWidget *w)
+{
+	GcrGrid *grid = GCR_GRID (w);
+	// the cached layouts use the old font
+	if (grid->layouts)
+		gcr_grid_clear_layouts (grid);
+	parent_class->style_updated (w);
+}
+
 static void gcr_grid_class_init (GtkWidgetClass *klass)
 {
 	parent_class = reinterpret_cast < GtkWidgetClass * > (g_type_class_peek_parent (klass));
@@ -1031,6 +1223,7 @@ static void gcr_grid_class_init (GtkWidgetClass *klass)
 	klass->get_preferred_height = gcr_grid_get_preferred_height;
 	klass->get_preferred_width = gcr_grid_get_preferred_width;
 	klass->unrealize = gcr_grid_unrealize;
+	klass->style_updated = gcr_grid_style_updated;
 	gcr_grid_signals[VALUE_CHANGED] = g_signal_new ("value-changed",
 	                                                G_TYPE_FROM_CLASS(klass),
 				                                    G_SIGNAL_RUN_LAST,
@@ -1194,85 +1387,81 @@ GtkWidget *gcr_grid_new (G_GNUC_UNUSED char const *col_title, GType col_type, ..
 	// add signals
 	g_signal_connect (grid->vadj, "value-changed", G_CALLBACK (gcr_grid_adjustment_changed), grid);
 	grid->orig_string = new std::string ();
+	grid->columns = new GcrGridColumn[grid->cols];
+	grid->text = new std::string ();
+	grid->scratch = new std::string ();
+	grid->text_row = grid->text_col = -1;
+	grid->layouts = new std::vector < GcrGridRowLayouts > ();
 	return reinterpret_cast <GtkWidget *> (grid);
 }
 
 int gcr_grid_get_int (GcrGrid *grid, unsigned row, unsigned column)
 {
 	g_return_val_if_fail (GCR_IS_GRID (grid) && row < grid->rows && column < grid->cols && grid->types[column] == G_TYPE_INT, 0);
-	return grid->row_data[row][column].compare (0, strlen ("−"), "−")?
-		atoi (grid->row_data[row][column].c_str ()):
-		-atoi (grid->row_data[row][column].c_str () + strlen ("−"));
+	return grid->columns[column].ints[row];
 }
 
 unsigned gcr_grid_get_uint (GcrGrid *grid, unsigned row, unsigned column)
 {
 	g_return_val_if_fail (GCR_IS_GRID (grid) && row < grid->rows && column < grid->cols && grid->types[column] == G_TYPE_UINT, 0);
-	return strtoul (grid->row_data[row][column].c_str (), NULL, 10);
+	return grid->columns[column].uints[row];
 }
 
 double gcr_grid_get_double (GcrGrid *grid, unsigned row, unsigned column)
 {
 	g_return_val_if_fail (GCR_IS_GRID (grid) && row < grid->rows && column < grid->cols && grid->types[column] == G_TYPE_DOUBLE, go_nan);
-	return grid->row_data[row][column].compare (0, strlen ("−"), "−")?
-		atof (grid->row_data[row][column].c_str ()):
-		-atof (grid->row_data[row][column].c_str ());
+	return grid->columns[column].doubles[row];
 }
 
 char const *gcr_grid_get_string (GcrGrid *grid, unsigned row, unsigned column)
 {
 	g_return_val_if_fail (GCR_IS_GRID (grid) && row < grid->rows && column < grid->cols && grid->types[column] == G_TYPE_STRING, NULL);
-	return grid->row_data[row][column].c_str ();
+	return grid->columns[column].strings[row].c_str ();
 }
 
 bool gcr_grid_get_boolean (GcrGrid *grid, unsigned row, unsigned column)
 {
 	g_return_val_if_fail (GCR_IS_GRID (grid) && row < grid->rows && column < grid->cols && grid->types[column] == G_TYPE_BOOLEAN, false);
-	return grid->row_data[row][column] == "t";
+	return grid->columns[column].ints[row];
 }
 
 void gcr_grid_set_int (GcrGrid *grid, unsigned row, unsigned column, int value)
 {
 	g_return_if_fail (GCR_IS_GRID (grid) && row < grid->rows && column < grid->cols && grid->types[column] == G_TYPE_INT);
-	char *buf;
-	if (value >= 0)
-		buf = g_strdup_printf ("%d", value);
-	else
-		buf = g_strdup_printf ("−%d", -value);
-	grid->row_data[row][column] = buf;
-	g_free (buf);
+	grid->columns[column].ints[row] = value;
+	gcr_grid_invalidate_row (grid, row);
 	gtk_widget_queue_draw (GTK_WIDGET (grid));
 }
 
 void gcr_grid_set_uint (GcrGrid *grid, unsigned row, unsigned column, unsigned value)
 {
 	g_return_if_fail (GCR_IS_GRID (grid) && row < grid->rows && column < grid->cols && grid->types[column] == G_TYPE_UINT);
-	char *buf = g_strdup_printf ("%u", value);
-	grid->row_data[row][column] = buf;
-	g_free (buf);
+	grid->columns[column].uints[row] = value;
+	gcr_grid_invalidate_row (grid, row);
 	gtk_widget_queue_draw (GTK_WIDGET (grid));
 }
 
 void gcr_grid_set_double (GcrGrid *grid, unsigned row, unsigned column, double value)
 {
 	g_return_if_fail (GCR_IS_GRID (grid) && row < grid->rows && column < grid->cols && grid->types[column] == G_TYPE_DOUBLE);
-	char *buf = g_strdup_printf ("%g", value);
-	grid->row_data[row][column] = buf;
-	g_free (buf);
+	grid->columns[column].doubles[row] = value;
+	gcr_grid_invalidate_row (grid, row);
 	gtk_widget_queue_draw (GTK_WIDGET (grid));
 }
 
 void gcr_grid_set_string (GcrGrid *grid, unsigned row, unsigned column, char const *value)
 {
 	g_return_if_fail (GCR_IS_GRID (grid) && row < grid->rows && column < grid->cols && grid->types[column] == G_TYPE_STRING);
-	grid->row_data[row][column] = value;
+	grid->columns[column].strings[row] = value;
+	gcr_grid_invalidate_row (grid, row);
 	gtk_widget_queue_draw (GTK_WIDGET (grid));
 }
 
 void gcr_grid_set_boolean (GcrGrid *grid, unsigned row, unsigned column, bool value)
 {
 	g_return_if_fail (GCR_IS_GRID (grid) && row < grid->rows && column < grid->cols && grid->types[column] == G_TYPE_BOOLEAN);
-	grid->row_data[row][column] = value? "t": "f";
+	grid->columns[column].ints[row] = value;
+	gcr_grid_invalidate_row (grid, row);
 	gtk_widget_queue_draw (GTK_WIDGET (grid));
 }
 
@@ -1280,39 +1469,25 @@ unsigned gcr_grid_append_row (GcrGrid *grid,...)
 {
 	g_return_val_if_fail (GCR_IS_GRID (grid) && grid->cols > 0, 0);
 	unsigned row = grid->rows++, col;
-	char *buf;
-	if (grid->row_data.capacity () < grid->rows)
-		grid->row_data.resize (grid->row_data.capacity () + 5);
-	grid->row_data[row] = new std::string[grid->cols];
+	gcr_grid_resize_columns (grid, grid->rows);
 	va_list args;
 	va_start (args, grid);
 	for (col = 0; col < grid->cols; col++) {
 		switch (grid->types[col]) {
-		case G_TYPE_INT: {
-			int value = va_arg (args, int);
-			if (value >= 0)
-				buf = g_strdup_printf ("%d", value);
-			else
-				buf = g_strdup_printf ("−%d", -value);
-			grid->row_data[row][col] = buf;
-			g_free (buf);
+		case G_TYPE_INT:
+			grid->columns[col].ints[row] = va_arg (args, int);
 			break;
-		}
 		case G_TYPE_UINT:
-			buf = g_strdup_printf ("%u", va_arg (args, unsigned));
-			grid->row_data[row][col] = buf;
-			g_free (buf);
+			grid->columns[col].uints[row] = va_arg (args, unsigned);
 			break;
 		case G_TYPE_DOUBLE:
-			buf = g_strdup_printf ("%f", va_arg (args, double));
-			grid->row_data[row][col] = buf;
-			g_free (buf);
+			grid->columns[col].doubles[row] = va_arg (args, double);
 			break;
 		case G_TYPE_STRING:
-			grid->row_data[row][col] = va_arg (args, char const*);
+			grid->columns[col].strings[row] = va_arg (args, char const*);
 			break;
 		case G_TYPE_BOOLEAN:
-			grid->row_data[row][col] = (va_arg (args, gboolean))? "t": "f";
+			grid->columns[col].ints[row] = (va_arg (args, gboolean))? 1: 0;
 			break;
 		default:
 			// do nothing, unsupported type
@@ -1320,24 +1495,81 @@ unsigned gcr_grid_append_row (GcrGrid *grid,...)
 		}
 	}
 	va_end (args);
-	gtk_adjustment_set_page_size (grid->vadj, static_cast < double > (grid->nb_visible) / grid->rows);
-	gtk_adjustment_set_upper (grid->vadj, (grid->nb_visible < grid->rows)? grid->rows - grid->nb_visible: .1);
-	if (grid->rows < grid->nb_visible + grid->first_visible) {
-		grid->first_visible = (grid->nb_visible < grid->rows)? grid->rows - grid->nb_visible: 0;
-		gtk_adjustment_set_value (grid->vadj, grid->first_visible);
+	gcr_grid_rows_changed (grid);
+	return row;
+}
+
+unsigned gcr_grid_append_rows (GcrGrid *grid, unsigned n)
+{
+	g_return_val_if_fail (GCR_IS_GRID (grid) && grid->cols > 0, 0);
+	unsigned row = grid->rows;
+	grid->rows += n;
+	gcr_grid_resize_columns (grid, grid->rows);
+	gcr_grid_rows_changed (grid);
+	return row;
+}
+
+void gcr_grid_set_column (GcrGrid *grid, unsigned column, unsigned first, unsigned n, void const *values)
+{
+	g_return_if_fail (GCR_IS_GRID (grid) && column < grid->cols && first + n <= grid->rows && (n == 0 || values != NULL));
+	GcrGridColumn &col = grid->columns[column];
+	unsigned i;
+	switch (grid->types[column]) {
+	case G_TYPE_INT:
+		std::copy (static_cast < int const * > (values), static_cast < int const * > (values) + n, col.ints.begin () + first);
+		break;
+	case G_TYPE_UINT:
+		std::copy (static_cast < unsigned const * > (values), static_cast < unsigned const * > (values) + n, col.uints.begin () + first);
+		break;
+	case G_TYPE_DOUBLE:
+		std::copy (static_cast < double const * > (values), static_cast < double const * > (values) + n, col.doubles.begin () + first);
+		break;
+	case G_TYPE_STRING: {
+		char const * const *strings = static_cast < char const * const * > (values);
+		for (i = 0; i < n; i++)
+			col.strings[first + i] = strings[i];
+		break;
+	}
+	case G_TYPE_BOOLEAN: {
+		bool const *booleans = static_cast < bool const * > (values);
+		for (i = 0; i < n; i++)
+			col.ints[first + i] = booleans[i];
+		break;
+	}
+	default:
+		return;
 	}
+	for (i = first; i < first + n; i++)
+		gcr_grid_invalidate_row (grid, i);
 	gtk_widget_queue_draw (GTK_WIDGET (grid));
-	return row;
 }
 
 void gcr_grid_delete_row (GcrGrid *grid, unsigned row)
 {
 	g_return_if_fail (GCR_IS_GRID (grid) && grid->rows > row);
-	delete [] grid->row_data[row];
 	g_signal_emit (grid, gcr_grid_signals[ROW_DELETED], 0, row);
-	for (unsigned n = row + 1 ; n < grid->rows; n++)
-		grid->row_data[n - 1] = grid->row_data[n];
+	for (unsigned n = 0; n < grid->cols; n++) {
+		GcrGridColumn &col = grid->columns[n];
+		switch (grid->types[n]) {
+		case G_TYPE_INT:
+		case G_TYPE_BOOLEAN:
+			col.ints.erase (col.ints.begin () + row);
+			break;
+		case G_TYPE_UINT:
+			col.uints.erase (col.uints.begin () + row);
+			break;
+		case G_TYPE_DOUBLE:
+			col.doubles.erase (col.doubles.begin () + row);
+			break;
+		case G_TYPE_STRING:
+			col.strings.erase (col.strings.begin () + row);
+			break;
+		default:
+			break;
+		}
+	}
 	grid->rows--;
+	gcr_grid_invalidate_rows (grid);
 	std::set < int > decreased;
 	std::set < int >::iterator i, end = grid->selected_rows->end ();
 	for (i = grid->selected_rows->begin (); i != end; i++)
@@ -1355,7 +1587,7 @@ void gcr_grid_delete_row (GcrGrid *grid, unsigned row)
 	}
 	if (!grid->selection_locked)
 		grid->selected_rows->clear ();
-	gtk_widget_queue_draw (GTK_WIDGET (grid));
+	gcr_grid_rows_changed (grid);
 }
 
 void gcr_grid_delete_selected_rows (GcrGrid *grid)
@@ -1383,14 +1615,19 @@ void gcr_grid_delete_selected_rows (GcrGrid *grid)
 void gcr_grid_delete_all (GcrGrid *grid)
 {
 	g_return_if_fail (GCR_IS_GRID (grid));
-	for (unsigned i = 0; i < grid->rows; i++)
-		delete [] grid->row_data[i];
+	for (unsigned i = 0; i < grid->cols; i++) {
+		grid->columns[i].ints.clear ();
+		grid->columns[i].uints.clear ();
+		grid->columns[i].doubles.clear ();
+		grid->columns[i].strings.clear ();
+	}
 	grid->rows = 0;
+	gcr_grid_invalidate_rows (grid);
 	if (grid->row >= 0) {
 		grid->row = -1;
 		g_signal_emit (grid, gcr_grid_signals[ROW_SELECTED], 0, -1);
 	}
-	gtk_widget_queue_draw (GTK_WIDGET (grid));
+	gcr_grid_rows_changed (grid);
 }
 
 void gcr_grid_customize_column (GcrGrid *grid, unsigned column, unsigned chars, bool editable)
@@ -190,6 +190,30 @@ inside the cells.
 */
 unsigned gcr_grid_append_row (GcrGrid *grid,...);
 
+/*!
+@param grid a GcrGrid.
+@param n the number of rows to add.
+
+Adds \a n rows to the grid, with cells set to zero, empty strings or FALSE.
+The values should then be set using gcr_grid_set_column(), which is much
+faster than appending the rows one by one for large data sets.
+@return the index of the first new row.
+*/
+unsigned gcr_grid_append_rows (GcrGrid *grid, unsigned n);
+
+/*!
+@param grid a GcrGrid.
+@param column the column.
+@param first the first row to set.
+@param n the number of rows to set.
+@param values the new values.
+
+Sets the values of \a n consecutive cells in a column. \a values must point to
+an array of \a n int, unsigned, double, char const* or bool according to the
+column type.
+*/
+void gcr_grid_set_column (GcrGrid *grid, unsigned column, unsigned first, unsigned n, void const *values);
+
 /*!
 @param grid a GcrGrid.
 @param row the row.
@@ -0,0 +1,218 @@
+// -*- C++ -*-
+
+/*
+ * Gnome Chemistry Utils
+ * gcr/images.cc
+ *
+ * Copyright (C) 2026 Jean Bréfort <jean.brefort@normalesup.org>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301
+ * USA
+ */
+
+#include "config.h"
+#include "images.h"
+#include "atom.h"
+#include "line.h"
+
+namespace gcr
+{
+
+bool InBox (double const *box, double x, double y, double z)
+{
+	return x >= box[0] - 1e-7 && x <= box[1] + 1e-7
+		&& y >= box[2] - 1e-7 && y <= box[3] + 1e-7
+		&& z >= box[4] - 1e-7 && z <= box[5] + 1e-7;
+}
+
+AtomImages::AtomImages ()
+{
+}
+
+AtomImages::~AtomImages ()
+{
+}
+
+void AtomImages::Clear ()
+{
+	x.clear ();
+	y.clear ();
+	z.clear ();
+	def.clear ();
+	cleaved.clear ();
+	colors.clear ();
+	radii.clear ();
+	drawn_radii.clear ();
+}
+
+void AtomImages::Reserve (unsigned n)
+{
+	x.reserve (n);
+	y.reserve (n);
+	z.reserve (n);
+	def.reserve (n);
+	cleaved.reserve (n);
+}
+
+void AtomImages::Add (double X, double Y, double Z, unsigned Def)
+{
+	x.push_back (X);
+	y.push_back (Y);
+	z.push_back (Z);
+	def.push_back (Def);
+	cleaved.push_back (0);
+}
+
+void AtomImages::Filter (std::vector <int> const &remap, double const *box)
+{
+	unsigned i, j = 0, max = x.size ();
+	for (i = 0; i < max; i++) {
+		int n = remap[def[i]];
+		if (n < 0 || (box && !InBox (box, x[i], y[i], z[i])))
+			continue;
+		x[j] = x[i];
+		y[j] = y[i];
+		z[j] = z[i];
+		def[j] = n;
+		cleaved[j] = cleaved[i];
+		j++;
+	}
+	x.resize (j);
+	y.resize (j);
+	z.resize (j);
+	def.resize (j);
+	cleaved.resize (j);
+}
+
+void AtomImages::SetDefinitionsNumber (unsigned n)
+{
+	colors.resize (4 * n);
+	radii.resize (n);
+	drawn_radii.resize (n);
+}
+
+void AtomImages::SetDefinition (unsigned Def, Atom &atom)
+{
+	double red, green, blue, alpha;
+	atom.GetColor (&red, &green, &blue, &alpha);
+	colors[4 * Def] = red;
+	colors[4 * Def + 1] = green;
+	colors[4 * Def + 2] = blue;
+	colors[4 * Def + 3] = alpha;
+	radii[Def] = atom.r ();
+	drawn_radii[Def] = atom.r () * atom.GetEffectiveRadiusRatio ();
+}
+
+void AtomImages::Uncleave ()
+{
+	cleaved.assign (cleaved.size (), 0);
+}
+
+LineImages::LineImages ()
+{
+}
+
+LineImages::~LineImages ()
+{
+}
+
+void LineImages::Clear ()
+{
+	x1.clear ();
+	y1.clear ();
+	z1.clear ();
+	x2.clear ();
+	y2.clear ();
+	z2.clear ();
+	def.clear ();
+	cleaved.clear ();
+	colors.clear ();
+	radii.clear ();
+}
+
+void LineImages::Reserve (unsigned n)
+{
+	x1.reserve (n);
+	y1.reserve (n);
+	z1.reserve (n);
+	x2.reserve (n);
+	y2.reserve (n);
+	z2.reserve (n);
+	def.reserve (n);
+	cleaved.reserve (n);
+}
+
+void LineImages::Add (double X1, double Y1, double Z1, double X2, double Y2, double Z2, unsigned Def)
+{
+	x1.push_back (X1);
+	y1.push_back (Y1);
+	z1.push_back (Z1);
+	x2.push_back (X2);
+	y2.push_back (Y2);
+	z2.push_back (Z2);
+	def.push_back (Def);
+	cleaved.push_back (0);
+}
+
+void LineImages::Filter (std::vector <int> const &remap, double const *box)
+{
+	unsigned i, j = 0, max = x1.size ();
+	for (i = 0; i < max; i++) {
+		int n = remap[def[i]];
+		if (n < 0 || (box && !(InBox (box, x1[i], y1[i], z1[i]) && InBox (box, x2[i], y2[i], z2[i]))))
+			continue;
+		x1[j] = x1[i];
+		y1[j] = y1[i];
+		z1[j] = z1[i];
+		x2[j] = x2[i];
+		y2[j] = y2[i];
+		z2[j] = z2[i];
+		def[j] = n;
+		cleaved[j] = cleaved[i];
+		j++;
+	}
+	x1.resize (j);
+	y1.resize (j);
+	z1.resize (j);
+	x2.resize (j);
+	y2.resize (j);
+	z2.resize (j);
+	def.resize (j);
+	cleaved.resize (j);
+}
+
+void LineImages::SetDefinitionsNumber (unsigned n)
+{
+	colors.resize (4 * n);
+	radii.resize (n);
+}
+
+void LineImages::SetDefinition (unsigned Def, Line &line)
+{
+	double red, green, blue, alpha;
+	line.GetColor (&red, &green, &blue, &alpha);
+	colors[4 * Def] = red;
+	colors[4 * Def + 1] = green;
+	colors[4 * Def + 2] = blue;
+	colors[4 * Def + 3] = alpha;
+	radii[Def] = line.GetRadius ();
+}
+
+void LineImages::Uncleave ()
+{
+	cleaved.assign (cleaved.size (), 0);
+}
+
+}	//	namespace gcr
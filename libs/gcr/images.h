@@ -0,0 +1,262 @@
+// -*- C++ -*-
+
+/*
+ * Gnome Chemistry Utils
+ * gcr/images.h
+ *
+ * Copyright (C) 2026 Jean Bréfort <jean.brefort@normalesup.org>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301
+ * USA
+ */
+
+#ifndef GCR_IMAGES_H
+#define GCR_IMAGES_H
+
+#include <vector>
+
+/*!\file*/
+namespace gcr
+{
+
+class Atom;
+class Line;
+
+/*!\class AtomImages gcr/images.h
+Compact storage for the atoms displayed in a crystal. Each image of an atom
+definition is stored as its net coordinates, the index of its definition and
+a cleaved flag, in separate arrays, so that drawing, cleaving or exporting the
+crystal just iterates over them. The color and the radius are stored only once
+for each definition.
+*/
+class AtomImages
+{
+public:
+/*!
+The default constructor.
+*/
+	AtomImages ();
+/*!
+The destructor.
+*/
+	~AtomImages ();
+
+/*!
+Removes all images and definitions.
+*/
+	void Clear ();
+/*!
+@return the number of images.
+*/
+	unsigned GetCount () const {return x.size ();}
+/*!
+@param n the expected number of images.
+
+Allocates the arrays for \a n images.
+*/
+	void Reserve (unsigned n);
+/*!
+@param X the net x coordinate.
+@param Y the net y coordinate.
+@param Z the net z coordinate.
+@param Def the index of the atom definition.
+
+Adds a new image.
+*/
+	void Add (double X, double Y, double Z, unsigned Def);
+/*!
+@param remap the new definition index for each current one, or -1.
+@param box if not NULL, the box outside of which images are removed, as
+{xmin, xmax, ymin, ymax, zmin, zmax}.
+
+Removes the images whose definition is mapped to -1 and the images outside
+\a box, and renumbers the definitions of the others, preserving their order.
+*/
+	void Filter (std::vector <int> const &remap, double const *box);
+/*!
+@param n the number of definitions.
+
+Resizes the definitions table.
+*/
+	void SetDefinitionsNumber (unsigned n);
+/*!
+@param Def the index of the definition.
+@param atom the atom definition.
+
+Copies the color and radius of \a atom for the definition \a Def.
+*/
+	void SetDefinition (unsigned Def, Atom &atom);
+/*!
+Clears all cleaved flags.
+*/
+	void Uncleave ();
+
+/*!
+The net x coordinates of the images.
+*/
+	std::vector <double> x;
+/*!
+The net y coordinates of the images.
+*/
+	std::vector <double> y;
+/*!
+The net z coordinates of the images.
+*/
+	std::vector <double> z;
+/*!
+The definition index of each image.
+*/
+	std::vector <unsigned> def;
+/*!
+Non zero for cleaved images.
+*/
+	std::vector <unsigned char> cleaved;
+/*!
+The colors of the definitions, four floats per definition.
+*/
+	std::vector <float> colors;
+/*!
+The atomic radii of the definitions.
+*/
+	std::vector <double> radii;
+/*!
+The radii used to draw each definition, the atomic radius multiplied by the
+effective radius ratio.
+*/
+	std::vector <double> drawn_radii;
+};
+
+/*!\class LineImages gcr/images.h
+Compact storage for the lines displayed in a crystal, working like AtomImages.
+The ends of each line are stored as net coordinates.
+*/
+class LineImages
+{
+public:
+/*!
+The default constructor.
+*/
+	LineImages ();
+/*!
+The destructor.
+*/
+	~LineImages ();
+
+/*!
+Removes all images and definitions.
+*/
+	void Clear ();
+/*!
+@return the number of images.
+*/
+	unsigned GetCount () const {return x1.size ();}
+/*!
+@param n the expected number of images.
+
+Allocates the arrays for \a n images.
+*/
+	void Reserve (unsigned n);
+/*!
+@param X1 the net x coordinate of the first end.
+@param Y1 the net y coordinate of the first end.
+@param Z1 the net z coordinate of the first end.
+@param X2 the net x coordinate of the second end.
+@param Y2 the net y coordinate of the second end.
+@param Z2 the net z coordinate of the second end.
+@param Def the index of the line definition.
+
+Adds a new image.
+*/
+	void Add (double X1, double Y1, double Z1, double X2, double Y2, double Z2, unsigned Def);
+/*!
+@param remap the new definition index for each current one, or -1.
+@param box if not NULL, the box outside of which images are removed.
+
+Same as AtomImages::Filter, a line is kept only if both ends are inside \a box.
+*/
+	void Filter (std::vector <int> const &remap, double const *box);
+/*!
+@param n the number of definitions.
+
+Resizes the definitions table.
+*/
+	void SetDefinitionsNumber (unsigned n);
+/*!
+@param Def the index of the definition.
+@param line the line definition.
+
+Copies the color and radius of \a line for the definition \a Def.
+*/
+	void SetDefinition (unsigned Def, Line &line);
+/*!
+Clears all cleaved flags.
+*/
+	void Uncleave ();
+
+/*!
+The net x coordinates of the first ends.
+*/
+	std::vector <double> x1;
+/*!
+The net y coordinates of the first ends.
+*/
+	std::vector <double> y1;
+/*!
+The net z coordinates of the first ends.
+*/
+	std::vector <double> z1;
+/*!
+The net x coordinates of the second ends.
+*/
+	std::vector <double> x2;
+/*!
+The net y coordinates of the second ends.
+*/
+	std::vector <double> y2;
+/*!
+The net z coordinates of the second ends.
+*/
+	std::vector <double> z2;
+/*!
+The definition index of each image.
+*/
+	std::vector <unsigned> def;
+/*!
+Non zero for cleaved images.
+*/
+	std::vector <unsigned char> cleaved;
+/*!
+The colors of the definitions, four floats per definition.
+*/
+	std::vector <float> colors;
+/*!
+The radii of the definitions.
+*/
+	std::vector <double> radii;
+};
+
+/*!
+@param box a box as {xmin, xmax, ymin, ymax, zmin, zmax}.
+@param x a net x coordinate.
+@param y a net y coordinate.
+@param z a net z coordinate.
+@return true if the point is inside \a box, using the same tolerance as when
+duplicating atoms and lines in the crystal.
+*/
+bool InBox (double const *box, double x, double y, double z);
+
+}	//	namespace gcr
+
+#endif	//	GCR_IMAGES_H
@@ -88,7 +88,7 @@ void LinesDlgPrivate::AddRow (LinesDlg *pBox)
 		pBox->m_Lines.resize (max_row + 10);
 	pBox->m_Lines[new_row] = new_line;
 	pBox->m_pDoc->GetLineList ()->push_back (new_line);
-	pBox->m_pDoc->Update ();
+	pBox->m_pDoc->QueueUpdate ();
 	pBox->m_pDoc->SetDirty (true);
 	gtk_widget_set_sensitive (pBox->DeleteAllBtn, true);
 }
@@ -105,7 +105,7 @@ void LinesDlgPrivate::DeleteAll (LinesDlg *pBox)
 		delete pBox->m_Lines[i];
 	pBox->m_Lines.clear ();
 	pBox->m_pDoc->GetLineList ()->clear ();
-	pBox->m_pDoc->Update ();
+	pBox->m_pDoc->QueueUpdate ();
 	pBox->m_pDoc->SetDirty (true);
 	gtk_widget_set_sensitive (pBox->DeleteAllBtn, false);
 }
@@ -141,7 +141,7 @@ void LinesDlgPrivate::ValueChanged (LinesDlg *pBox, unsigned row, unsigned colum
 	case COLUMN_SINGLE:
 		line->Type () = gcr_grid_get_boolean (pBox->m_Grid, row, column)? unique: normal;
 	}
-	pBox->m_pDoc->Update ();
+	pBox->m_pDoc->QueueUpdate ();
 	pBox->m_pDoc->SetDirty (true);
 }
 
@@ -166,7 +166,7 @@ void LinesDlgPrivate::RowDeleted (LinesDlg *pBox, int row)
 	pBox->m_pDoc->GetLineList ()->remove (pBox->m_Lines[row]);
 	delete pBox->m_Lines[row];
 	pBox->m_Lines.erase (pBox->m_Lines.begin () + row);
-	pBox->m_pDoc->Update ();
+	pBox->m_pDoc->QueueUpdate ();
 	pBox->m_pDoc->SetDirty (true);
 	gtk_widget_set_sensitive (pBox->DeleteAllBtn, !pBox->m_pDoc->GetLineList ()->empty ());
 }
@@ -188,7 +188,7 @@ void LinesDlgPrivate::EdgesToggled (GtkToggleButton *btn, LinesDlg *pBox)
 		delete pBox->Edges;
 		pBox->Edges = NULL;
 	}
-	pBox->m_pDoc->Update ();
+	pBox->m_pDoc->QueueUpdate ();
 	pBox->m_pDoc->SetDirty (true);
 }
 
@@ -209,7 +209,7 @@ void LinesDlgPrivate::DiagonalsToggled (GtkToggleButton *btn, LinesDlg *pBox)
 		delete pBox->Diagonals;
 		pBox->Diagonals = NULL;
 	}
-	pBox->m_pDoc->Update ();
+	pBox->m_pDoc->QueueUpdate ();
 	pBox->m_pDoc->SetDirty (true);
 }
 
@@ -230,7 +230,7 @@ void LinesDlgPrivate::MediansToggled (GtkToggleButton *btn, LinesDlg *pBox)
 		delete pBox->Medians;
 		pBox->Medians = NULL;
 	}
-	pBox->m_pDoc->Update ();
+	pBox->m_pDoc->QueueUpdate ();
 	pBox->m_pDoc->SetDirty (true);
 }
 
@@ -240,7 +240,7 @@ bool LinesDlgPrivate::EdgesRadiusEdited (LinesDlg *pBox)
 	double r;
 	if (pBox->GetNumber (pBox->EdgesR, &r, gcugtk::Min, 0)) {
 		pBox->Edges->SetRadius (r);
-		pBox->m_pDoc->Update ();
+		pBox->m_pDoc->QueueUpdate ();
 		pBox->m_pDoc->SetDirty (true);
 	}
 	g_signal_handler_unblock (pBox->EdgesR, pBox->m_EdgesFocusOutSignalID);
@@ -253,7 +253,7 @@ bool LinesDlgPrivate::DiagsRadiusEdited (LinesDlg *pBox)
 	double r;
 	if (pBox->GetNumber (pBox->DiagsR, &r, gcugtk::Min, 0)) {
 		pBox->Diagonals->SetRadius (r);
-		pBox->m_pDoc->Update ();
+		pBox->m_pDoc->QueueUpdate ();
 		pBox->m_pDoc->SetDirty (true);
 	}
 	g_signal_handler_unblock (pBox->DiagsR, pBox->m_DiagsFocusOutSignalID);
@@ -266,7 +266,7 @@ bool LinesDlgPrivate::MediansRadiusEdited (LinesDlg *pBox)
 	double r;
 	if (pBox->GetNumber (pBox->MediansR, &r, gcugtk::Min, 0)) {
 		pBox->Medians->SetRadius (r);
-		pBox->m_pDoc->Update ();
+		pBox->m_pDoc->QueueUpdate ();
 		pBox->m_pDoc->SetDirty (true);
 	}
 	g_signal_handler_unblock (pBox->MediansR, pBox->m_MediansFocusOutSignalID);
@@ -278,7 +278,7 @@ void LinesDlgPrivate::EdgesColorSet (GtkColorChooser *btn, LinesDlg *pBox)
 	GdkRGBA rgba;
 	gtk_color_chooser_get_rgba (btn, &rgba);
 	pBox->Edges->SetColor (rgba);
-	pBox->m_pDoc->Update ();
+	pBox->m_pDoc->QueueUpdate ();
 	pBox->m_pDoc->SetDirty (true);
 }
 
@@ -287,7 +287,7 @@ void LinesDlgPrivate::DiagsColorSet (GtkColorChooser *btn, LinesDlg *pBox)
 	GdkRGBA rgba;
 	gtk_color_chooser_get_rgba (btn, &rgba);
 	pBox->Diagonals->SetColor (rgba);
-	pBox->m_pDoc->Update ();
+	pBox->m_pDoc->QueueUpdate ();
 	pBox->m_pDoc->SetDirty (true);
 }
 
@@ -296,7 +296,7 @@ void LinesDlgPrivate::MediansColorSet (GtkColorChooser *btn, LinesDlg *pBox)
 	GdkRGBA rgba;
 	gtk_color_chooser_get_rgba (btn, &rgba);
 	pBox->Medians->SetColor (rgba);
-	pBox->m_pDoc->Update ();
+	pBox->m_pDoc->QueueUpdate ();
 	pBox->m_pDoc->SetDirty (true);
 }
 
@@ -310,7 +310,7 @@ bool LinesDlgPrivate::RadiusEdited (LinesDlg *pBox)
 	g_signal_handler_block (pBox->LineR, pBox->m_LineFocusOutSignalID);
 	if (pBox->m_LineSelected >= 0 && pBox->GetNumber (pBox->LineR, &pBox->m_Radius, gcugtk::Min, 0)) {
 		gcr_grid_for_each_selected (pBox->m_Grid, reinterpret_cast < GridCb > (SetRadius), pBox);
-		pBox->m_pDoc->Update ();
+		pBox->m_pDoc->QueueUpdate ();
 		pBox->m_pDoc->SetDirty (true);
 	}
 	g_signal_handler_unblock (pBox->LineR, pBox->m_LineFocusOutSignalID);
@@ -327,7 +327,7 @@ void LinesDlgPrivate::ColorSet (GtkColorChooser *btn, LinesDlg *pBox)
 	if (pBox->m_LineSelected >= 0) {
 		gtk_color_chooser_get_rgba (btn, &pBox->m_rgba);
 		gcr_grid_for_each_selected (pBox->m_Grid, reinterpret_cast < GridCb > (SetColor), pBox);
-		pBox->m_pDoc->Update ();
+		pBox->m_pDoc->QueueUpdate ();
 		pBox->m_pDoc->SetDirty (true);
 	}
 }
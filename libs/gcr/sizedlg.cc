@@ -47,7 +47,7 @@ bool SizeDlgPrivate::MinXEdited (SizeDlg *pBox)
 	pBox->m_pDoc->GetSize (&xmin, &xmax, &ymin, &ymax, &zmin, &zmax);
 	if (pBox->GetNumber (pBox->MinX, &value, gcugtk::Max, 0, xmax) && xmin != value) {
 		pBox->m_pDoc->SetSize (value, xmax, ymin, ymax, zmin, zmax);
-		pBox->m_pDoc->Update ();
+		pBox->m_pDoc->QueueUpdate ();
 		pBox->m_pDoc->SetDirty (true);
 	}
 	g_signal_handler_unblock (pBox->MinX, pBox->m_MinXFocusOutSignalID);
@@ -61,7 +61,7 @@ bool SizeDlgPrivate::MaxXEdited (SizeDlg *pBox)
 	pBox->m_pDoc->GetSize (&xmin, &xmax, &ymin, &ymax, &zmin, &zmax);
 	if (pBox->GetNumber (pBox->MaxX, &value, gcugtk::Min, xmin) && xmin != value) {
 		pBox->m_pDoc->SetSize (xmin, value, ymin, ymax, zmin, zmax);
-		pBox->m_pDoc->Update ();
+		pBox->m_pDoc->QueueUpdate ();
 		pBox->m_pDoc->SetDirty (true);
 	}
 	g_signal_handler_unblock (pBox->MaxX, pBox->m_MaxXFocusOutSignalID);
@@ -75,7 +75,7 @@ bool SizeDlgPrivate::MinYEdited (SizeDlg *pBox)
 	pBox->m_pDoc->GetSize (&xmin, &xmax, &ymin, &ymax, &zmin, &zmax);
 	if (pBox->GetNumber (pBox->MinY, &value, gcugtk::Max, 0, ymax) && ymin != value) {
 		pBox->m_pDoc->SetSize (xmin, xmax, value, ymax, zmin, zmax);
-		pBox->m_pDoc->Update ();
+		pBox->m_pDoc->QueueUpdate ();
 		pBox->m_pDoc->SetDirty (true);
 	}
 	g_signal_handler_unblock (pBox->MinY, pBox->m_MinYFocusOutSignalID);
@@ -89,7 +89,7 @@ bool SizeDlgPrivate::MaxYEdited (SizeDlg *pBox)
 	pBox->m_pDoc->GetSize (&xmin, &xmax, &ymin, &ymax, &zmin, &zmax);
 	if (pBox->GetNumber (pBox->MaxY, &value, gcugtk::Min, ymin) && ymax != value) {
 		pBox->m_pDoc->SetSize (xmin, xmax, ymin, value, zmin, zmax);
-		pBox->m_pDoc->Update ();
+		pBox->m_pDoc->QueueUpdate ();
 		pBox->m_pDoc->SetDirty (true);
 	}
 	g_signal_handler_unblock (pBox->MaxY, pBox->m_MaxYFocusOutSignalID);
@@ -103,7 +103,7 @@ bool SizeDlgPrivate::MinZEdited (SizeDlg *pBox)
 	pBox->m_pDoc->GetSize (&xmin, &xmax, &ymin, &ymax, &zmin, &zmax);
 	if (pBox->GetNumber (pBox->MinZ, &value, gcugtk::Max, 0, zmax) && zmin != value) {
 		pBox->m_pDoc->SetSize (xmin, xmax, ymin, ymax, value, zmax);
-		pBox->m_pDoc->Update ();
+		pBox->m_pDoc->QueueUpdate ();
 		pBox->m_pDoc->SetDirty (true);
 	}
 	g_signal_handler_unblock (pBox->MinZ, pBox->m_MinZFocusOutSignalID);
@@ -117,7 +117,7 @@ bool SizeDlgPrivate::MaxZEdited (SizeDlg *pBox)
 	pBox->m_pDoc->GetSize (&xmin, &xmax, &ymin, &ymax, &zmin, &zmax);
 	if (pBox->GetNumber (pBox->MaxZ, &value, gcugtk::Min, zmin) && zmax != value) {
 		pBox->m_pDoc->SetSize (xmin, xmax, ymin, ymax, zmin, value);
-		pBox->m_pDoc->Update ();
+		pBox->m_pDoc->QueueUpdate ();
 		pBox->m_pDoc->SetDirty (true);
 	}
 	g_signal_handler_unblock (pBox->MaxZ, pBox->m_MaxZFocusOutSignalID);
@@ -0,0 +1,301 @@
+// -*- C++ -*-
+
+/*
+ * Gnome Chemistry Utils
+ * gcr/symmetry.cc
+ *
+ * Copyright (C) 2026 Jean Bréfort <jean.brefort@normalesup.org>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301
+ * USA
+ */
+
+#include "config.h"
+#include "symmetry.h"
+#include "atom.h"
+#include <gcu/spacegroup.h>
+#include <gcu/transform3d.h>
+#include <gcu/vector.h>
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <map>
+#include <string>
+
+// the cells must be larger than the tolerance so that only neighbour cells need to be searched
+#define CELL_SIZE (2. * PREC)
+// the minimum number of position images needed to test the operations in parallel
+#define PARALLEL_MIN 0x10000
+
+namespace gcr
+{
+
+struct SymmetryFinder::Task {
+	SymmetryFinder const *finder;
+	std::vector <Operation> const *operations;
+	std::vector <signed char> *valid;
+};
+
+static bool same_kind (Atom *a0, Atom *a1)
+{
+	// same as Atom::operator== without the coordinates
+	if (a0->GetZ () != a1->GetZ () || a0->GetCharge () != a1->GetCharge ())
+		return false;
+	if (a0->GetZ () > 0)
+		return true;
+	double r0, g0, b0, al0, r1, g1, b1, al1;
+	a0->GetColor (&r0, &g0, &b0, &al0);
+	a1->GetColor (&r1, &g1, &b1, &al1);
+	return r0 == r1 && g0 == g1 && b0 == b1 && al0 == al1 && a0->GetSize () == a1->GetSize ();
+}
+
+SymmetryFinder::SymmetryFinder ():
+	m_Mask (0),
+	m_Indexed (false)
+{
+}
+
+SymmetryFinder::~SymmetryFinder ()
+{
+}
+
+void SymmetryFinder::AddAtom (Atom &atom, double x, double y, double z)
+{
+	unsigned kind, max = m_KindAtoms.size ();
+	for (kind = 0; kind < max; kind++)
+		if (same_kind (m_KindAtoms[kind], &atom))
+			break;
+	if (kind == max)
+		m_KindAtoms.push_back (&atom);
+	m_x.push_back (x);
+	m_y.push_back (y);
+	m_z.push_back (z);
+	m_Kinds.push_back (kind);
+	m_Indexed = false;
+}
+
+unsigned SymmetryFinder::Bucket (int x, int y, int z) const
+{
+	return (static_cast <unsigned> (x) * 73856093u ^ static_cast <unsigned> (y) * 19349663u ^ static_cast <unsigned> (z) * 83492791u) & m_Mask;
+}
+
+void SymmetryFinder::Index ()
+{
+	if (m_Indexed)
+		return;
+	unsigned i, n = m_x.size (), size = 16;
+	while (size < 2 * n)
+		size <<= 1;
+	m_Mask = size - 1;
+	m_Heads.assign (size, -1);
+	m_Next.resize (n);
+	// insert in reverse order so that the chains are sorted by increasing index
+	for (i = n; i-- > 0; ) {
+		unsigned b = Bucket (static_cast <int> (floor (m_x[i] / CELL_SIZE)),
+		                     static_cast <int> (floor (m_y[i] / CELL_SIZE)),
+		                     static_cast <int> (floor (m_z[i] / CELL_SIZE)));
+		m_Next[i] = m_Heads[b];
+		m_Heads[b] = i;
+	}
+	m_Indexed = true;
+}
+
+void SymmetryFinder::Find (double x, double y, double z, int kind, std::vector <unsigned> &matches) const
+{
+	int x0 = floor ((x - PREC) / CELL_SIZE), x1 = floor ((x + PREC) / CELL_SIZE),
+		y0 = floor ((y - PREC) / CELL_SIZE), y1 = floor ((y + PREC) / CELL_SIZE),
+		z0 = floor ((z - PREC) / CELL_SIZE), z1 = floor ((z + PREC) / CELL_SIZE),
+		i, j, k, n;
+	unsigned buckets[8], nb = 0, b, l;
+	for (i = x0; i <= x1; i++)
+		for (j = y0; j <= y1; j++)
+			for (k = z0; k <= z1; k++) {
+				b = Bucket (i, j, k);
+				// several cells might share the same bucket
+				for (l = 0; l < nb; l++)
+					if (buckets[l] == b)
+						break;
+				if (l < nb)
+					continue;
+				buckets[nb++] = b;
+				for (n = m_Heads[b]; n >= 0; n = m_Next[n])
+					if (m_Kinds[n] == kind && fabs (m_x[n] - x) < PREC &&
+					    fabs (m_y[n] - y) < PREC && fabs (m_z[n] - z) < PREC)
+						matches.push_back (n);
+			}
+}
+
+void SymmetryFinder::GetOperation (gcu::Transform3d const *t, Operation &op)
+{
+	// the images of the origin and of the unit vectors give the coefficients
+	gcu::Vector o = *t * gcu::Vector (0., 0., 0.),
+		u[3] = {*t * gcu::Vector (1., 0., 0.), *t * gcu::Vector (0., 1., 0.), *t * gcu::Vector (0., 0., 1.)};
+	for (unsigned j = 0; j < 3; j++) {
+		op.m[0][j] = u[j].GetX () - o.GetX ();
+		op.m[1][j] = u[j].GetY () - o.GetY ();
+		op.m[2][j] = u[j].GetZ () - o.GetZ ();
+	}
+	op.t[0] = o.GetX ();
+	op.t[1] = o.GetY ();
+	op.t[2] = o.GetZ ();
+}
+
+static inline double normalize (double x)
+{
+	// same as gcu::SpaceGroup::Transform, then bring values close to 1 to 0
+	if (x < 0.)
+		x += 1.;
+	else if (x >= 1.)
+		x -= 1.;
+	while (x > 1. - PREC)
+		x -= 1.;
+	return x;
+}
+
+void SymmetryFinder::Apply (Operation const &op, double &x, double &y, double &z)
+{
+	double x1 = op.m[0][0] * x + op.m[0][1] * y + op.m[0][2] * z + op.t[0],
+		y1 = op.m[1][0] * x + op.m[1][1] * y + op.m[1][2] * z + op.t[1],
+		z1 = op.m[2][0] * x + op.m[2][1] * y + op.m[2][2] * z + op.t[2];
+	x = normalize (x1);
+	y = normalize (y1);
+	z = normalize (z1);
+}
+
+bool SymmetryFinder::Test (Operation const &op) const
+{
+	unsigned i, n = m_x.size ();
+	double x, y, z;
+	std::vector <unsigned> matches;
+	for (i = 0; i < n; i++) {
+		x = m_x[i];
+		y = m_y[i];
+		z = m_z[i];
+		Apply (op, x, y, z);
+		matches.clear ();
+		Find (x, y, z, m_Kinds[i], matches);
+		if (matches.empty ())
+			return false;
+	}
+	return true;
+}
+
+void SymmetryFinder::TestThread (gpointer data, gpointer user_data)
+{
+	Task *task = reinterpret_cast <Task *> (user_data);
+	unsigned i = GPOINTER_TO_UINT (data) - 1;
+	// each thread writes its own element, and the vector is not resized
+	(*task->valid)[i] = task->finder->Test ((*task->operations)[i])? 1: 0;
+}
+
+gcu::SpaceGroup const *SymmetryFinder::FindSpaceGroup (unsigned first, unsigned last)
+{
+	if (m_x.empty ())
+		return NULL;
+	Index ();
+	// collect the distinct operations, most of them are shared by many groups
+	std::vector <Operation> operations;
+	std::map <std::string, unsigned> known;
+	std::vector <gcu::SpaceGroup const *> groups;
+	std::vector < std::vector <unsigned> > group_operations;
+	std::list <gcu::Transform3d*>::const_iterator t;
+	Operation op;
+	unsigned id, i, j;
+	for (id = last; id >= first && id > 0; id--) {
+		std::list <gcu::SpaceGroup const *> &l = gcu::SpaceGroup::GetSpaceGroups (id);
+		std::list <gcu::SpaceGroup const *>::iterator g, gend = l.end ();
+		for (g = l.begin (); g != gend; g++) {
+			groups.push_back (*g);
+			group_operations.push_back (std::vector <unsigned> ());
+			std::vector <unsigned> &indices = group_operations.back ();
+			for (gcu::Transform3d const *tr = (*g)->GetFirstTransform (t); tr; tr = (*g)->GetNextTransform (t)) {
+				GetOperation (tr, op);
+				std::string key (reinterpret_cast <char const *> (&op), sizeof (Operation));
+				std::map <std::string, unsigned>::iterator k = known.find (key);
+				if (k == known.end ()) {
+					k = known.insert (std::make_pair (key, operations.size ())).first;
+					operations.push_back (op);
+				}
+				indices.push_back ((*k).second);
+			}
+		}
+	}
+	std::vector <signed char> valid (operations.size (), -1);
+	if (m_x.size () * operations.size () >= PARALLEL_MIN) {
+		Task task = {this, &operations, &valid};
+		GThreadPool *pool = g_thread_pool_new (TestThread, &task, g_get_num_processors (), true, NULL);
+		for (i = 0; i < operations.size (); i++)
+			g_thread_pool_push (pool, GUINT_TO_POINTER (i + 1), NULL);
+		g_thread_pool_free (pool, false, true);
+	}
+	// a group is rejected as soon as one of its operations failed
+	for (i = 0; i < groups.size (); i++) {
+		std::vector <unsigned> &indices = group_operations[i];
+		for (j = 0; j < indices.size (); j++) {
+			signed char &v = valid[indices[j]];
+			if (v < 0)
+				v = Test (operations[indices[j]])? 1: 0;
+			if (!v)
+				break;
+		}
+		if (j == indices.size ())
+			return groups[i];
+	}
+	return NULL;
+}
+
+void SymmetryFinder::FindDuplicates (gcu::SpaceGroup const *group, std::vector <bool> &duplicates)
+{
+	unsigned i, j, n = m_x.size ();
+	duplicates.assign (n, false);
+	if (!group)
+		return;
+	Index ();
+	std::vector <Operation> operations;
+	std::list <gcu::Transform3d*>::const_iterator t;
+	Operation op;
+	for (gcu::Transform3d const *tr = group->GetFirstTransform (t); tr; tr = group->GetNextTransform (t)) {
+		GetOperation (tr, op);
+		operations.push_back (op);
+	}
+	std::vector <unsigned> matches;
+	double x, y, z;
+	for (i = 0; i < n; i++) {
+		if (duplicates[i])
+			continue;
+		std::vector <Operation>::iterator o, oend = operations.end ();
+		for (o = operations.begin (); o != oend && !duplicates[i]; o++) {
+			x = m_x[i];
+			y = m_y[i];
+			z = m_z[i];
+			Apply (*o, x, y, z);
+			matches.clear ();
+			Find (x, y, z, m_Kinds[i], matches);
+			std::sort (matches.begin (), matches.end ());
+			for (j = 0; j < matches.size (); j++) {
+				unsigned k = matches[j];
+				if (k <= i || duplicates[k])
+					continue;
+				if (m_x[k] < m_x[i] || m_y[k] < m_y[i] || m_z[k] < m_z[i]) {
+					duplicates[i] = true;
+					break;
+				}
+				duplicates[k] = true;
+			}
+		}
+	}
+}
+
+}	//	namespace gcr
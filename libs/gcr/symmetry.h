@@ -0,0 +1,123 @@
+// -*- C++ -*-
+
+/*
+ * Gnome Chemistry Utils
+ * gcr/symmetry.h
+ *
+ * Copyright (C) 2026 Jean Bréfort <jean.brefort@normalesup.org>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301
+ * USA
+ */
+
+#ifndef GCR_SYMMETRY_H
+#define GCR_SYMMETRY_H
+
+#include <glib.h>
+#include <vector>
+
+/*!\file*/
+namespace gcu
+{
+class SpaceGroup;
+class Transform3d;
+}
+
+namespace gcr
+{
+
+class Atom;
+
+/*!\class SymmetryFinder gcr/symmetry.h
+Finds the space groups compatible with a set of atoms given by their net
+coordinates. The positions are hashed on a grid which cells are a bit larger
+than the tolerance used to compare coordinates, so that the atom at the image
+of a position is found in constant time. Each distinct symmetry operation is
+tested only once, even if it belongs to many space groups, and the tests are
+run in parallel for large structures.
+
+Two atoms match if their coordinates differ by less than PREC and if they are
+of the same kind, as defined by Atom::operator==.
+*/
+class SymmetryFinder
+{
+public:
+/*!
+The default constructor.
+*/
+	SymmetryFinder ();
+/*!
+The destructor.
+*/
+	~SymmetryFinder ();
+
+/*!
+@param atom an atom definition.
+@param x the net x coordinate.
+@param y the net y coordinate.
+@param z the net z coordinate.
+
+Adds a position occupied by an atom of the same kind as \a atom, which must
+stay alive as long as the finder. Positions are numbered in the order they are
+added.
+*/
+	void AddAtom (Atom &atom, double x, double y, double z);
+/*!
+@param first the lowest space group number to test.
+@param last the highest space group number to test.
+
+Tests the space groups from \a last down to \a first, and, for each number, in
+the order returned by gcu::SpaceGroup::GetSpaceGroups().
+@return the first space group transforming all positions into positions
+occupied by the same kind of atom, or NULL.
+*/
+	gcu::SpaceGroup const *FindSpaceGroup (unsigned first, unsigned last);
+/*!
+@param group a space group.
+@param duplicates where to store the flags.
+
+Flags the positions which are symmetry equivalents of a previous position.
+When a position is equivalent to a later position with lower coordinates, the
+position itself is flagged instead.
+*/
+	void FindDuplicates (gcu::SpaceGroup const *group, std::vector <bool> &duplicates);
+
+private:
+	struct Operation {
+		double m[3][3], t[3];
+	};
+	struct Task;
+
+	void Index ();
+	bool Test (Operation const &op) const;
+	void Find (double x, double y, double z, int kind, std::vector <unsigned> &matches) const;
+	unsigned Bucket (int x, int y, int z) const;
+	static void Apply (Operation const &op, double &x, double &y, double &z);
+	static void GetOperation (gcu::Transform3d const *t, Operation &op);
+	static void TestThread (gpointer data, gpointer user_data);
+
+private:
+	std::vector <double> m_x, m_y, m_z;
+	std::vector <int> m_Kinds;
+	std::vector <Atom *> m_KindAtoms;	// one atom of each kind
+	// hash table of the positions, chained through m_Next
+	std::vector <int> m_Heads, m_Next;
+	unsigned m_Mask;
+	bool m_Indexed;
+};
+
+}	//	namespace gcr
+
+#endif	//	GCR_SYMMETRY_H
@@ -24,8 +24,10 @@
 
 #include "config.h"
 #include "application.h"
+#include "babelclient.h"
 #include "cmd-context.h"
 #include "document.h"
+#include "input.h"
 #include "loader.h"
 #include "ui-manager.h"
 #include <gsf/gsf-input-gio.h>
@@ -33,15 +35,10 @@
 #include <gsf/gsf-input-memory.h>
 #include <gsf/gsf-output-memory.h>
 #include <glib/gi18n-lib.h>
-#include <sys/stat.h>
 #include <cmath>
 #include <cstdlib>
 #include <cstring>
 #include <clocale>
-#include <netinet/in.h>
-#include <sys/socket.h>
-#include <sys/un.h>
-#include <unistd.h>
 #include <set>
 #include <sstream>
 
@@ -62,6 +59,7 @@ Application::Application (string name, string datadir, char const *help_name, ch
 		m_ConfDir = go_conf_get_node (NULL, GCU_CONF_DIR);
 	}
 	m_CmdContext = cc;
+	m_BabelClient = NULL;
 	if (m_CmdContext)
 		m_CmdContext->m_App = this;
 	Apps[name] = this;
@@ -120,6 +118,7 @@ Application::~Application ()
 	Apps.erase (Name);
 	if (m_CmdContext)
 		delete m_CmdContext;
+	delete m_BabelClient;
 	if (Apps.empty ()) {
 		ClearDialogs (); // needed to cleanly stop goffice
 		go_conf_free_node (m_ConfDir);
@@ -209,7 +208,7 @@ ContentType Application::Load (std::string const &uri, char const *mime_type, Do
 		mime_type = "chemical/x-cml";
 	} else {
 		GError *error = NULL;
-		input = gsf_input_gio_new_for_uri (uri.c_str (), &error);
+		input = OpenInput (uri.c_str (), l->UsesMappedInput (), &error);
 		if (error) {
 			g_error_free (error);
 			return ContentTypeUnknown;
@@ -527,44 +526,11 @@ char const *Application::MimeToBabelType (char const *mime_type)
 	return (it == m_BabelTypes.end ())? mime_type: (*it).second.c_str ();
 }
 
-#define MAX_ATTEMPTS 10
-int Application::OpenBabelSocket ()
+BabelClient *Application::GetBabelClient ()
 {
-	struct stat statbuf;
-	static std::string socket_path = "/tmp/babelsocket-";
-	unsigned n = 0;
-	if (socket_path.length () == 17)
-		socket_path += getenv ("USER");
-	if (stat (socket_path.c_str (), &statbuf)) {
-		char *args[] = {const_cast <char *> (LIBEXECDIR"/babelserver"), NULL};
-		GError *error = NULL;
-		g_spawn_async (NULL, (char **) args, NULL, static_cast <GSpawnFlags> (0), NULL, NULL, NULL, &error);
-		if (error) {
-			g_error_free (error);
-			error = NULL;
-			return -1;
-		}
-		time_t endtime = time (NULL) + 15; // hoping the server will have started within 15 seconds
-		while (stat (socket_path.c_str (), &statbuf))
-			if (time (NULL) > endtime)
-				return -1; // timeout
-	}
-	int res = socket (AF_UNIX, SOCK_STREAM, 0);
-	if (res == -1) {
-		perror ("Could not create the socket");
-		return -1;
-	}
-	struct sockaddr_un adr_serv;
-	adr_serv.sun_family = AF_UNIX;
-	strcpy (adr_serv.sun_path, socket_path.c_str ());
-	while (connect (res, (const struct sockaddr*) &adr_serv, sizeof (struct sockaddr_un)) == -1) {
-		perror (_("Connection failed"));
-		n++;
-		if (n == MAX_ATTEMPTS)
-			return -1;
-		sleep (1);
-	}
-	return res;
+	if (!m_BabelClient)
+		m_BabelClient = new BabelClient ();
+	return m_BabelClient;
 }
 
 /*!
@@ -577,112 +543,40 @@ This method converts the source to CML.
 */
 char* Application::ConvertToCML (std::string const &uri, const char *mime_type, const char *options)
 {
-	int sock = OpenBabelSocket ();
-	if (sock <= 0)
-		return NULL;
 	GVfs *vfs = g_vfs_get_default ();
 	GFile *file = g_vfs_get_file_for_uri (vfs, uri.c_str ());
 	char *path = g_file_get_path (file);
-	std::string buf = "-i ";
-	buf += MimeToBabelType (mime_type);
-	if (path) {
-		buf += " ";
-		buf += path;
-		buf += " -o cml";
-		if (options) {
-			buf += " ";
-			buf += options;
-		}
-		buf += " -D";
-		write (sock, buf.c_str (), buf.length ());
-		g_free (path);
-	} else {
-		buf += " -o cml";
-		if (options) {
-			buf += " ";
-			buf += options;
-		}
-		// load the data in memory and write them to the socket
+	g_object_unref (file);
+	if (!path) {
+		// load the data in memory and send them to the server
 		GError *error = NULL;
-		GFileInfo *info = g_file_query_info (file,
-											 ((mime_type)? G_FILE_ATTRIBUTE_STANDARD_SIZE:
-											 G_FILE_ATTRIBUTE_STANDARD_CONTENT_TYPE "," G_FILE_ATTRIBUTE_STANDARD_SIZE),
-											 G_FILE_QUERY_INFO_NONE,
-											 NULL, &error);
-		if (error) {
-			g_message ("GIO querry failed: %s", error->message);
+		GsfInput *input = OpenInput (uri.c_str (), false, &error);
+		if (!input) {
+			g_message ("GIO could not open the file: %s", error->message);
 			g_error_free (error);
-			g_object_unref (file);
-			return NULL;
-		}
-		gsize size = g_file_info_get_size (info);
-		g_object_unref (info);
-		GInputStream *input = G_INPUT_STREAM (g_file_read (file, NULL, &error));
-		if (error) {
-			g_message ("GIO could not create the stream: %s", error->message);
-			g_error_free (error);
-			g_object_unref (file);
-			return NULL;
-		}
-		char *szbuf = new char[size];
-		gsize n = g_input_stream_read (input, szbuf, size, NULL, &error);
-		if (error) {
-			g_message ("GIO could not read the file: %s", error->message);
-			g_error_free (error);
-			delete [] szbuf;
 			return NULL;
 		}
+		char *cml = ConvertToCML (input, mime_type, options);
 		g_object_unref (input);
-		g_object_unref (file);
-		if (n != size) {
-			delete [] szbuf;
-			return NULL;
-		}
-		char *szsize = g_strdup_printf (" -l %lu -D", size);
-		buf += szsize;
-		g_free (szsize);
-		write (sock, buf.c_str (), buf.length ());
-		write (sock, szbuf, size);
-		delete [] szbuf;
+		return cml;
 	}
-	time_t timeout = time (NULL) + 60;
-	char inbuf[256], *start = inbuf, *end;
-	unsigned cur, index = 0, length = 0;
-	while (time (NULL) < timeout) {
-		if ((cur = read (sock, start + index, ((length)? length: 255) - index))) {
-			index += cur;
-			start[index] = 0;
-			if (start == inbuf) {
-				if ((end = strchr (inbuf, ' '))) {
-					length = strtoul (inbuf, NULL, 10);
-					start = reinterpret_cast <char *> (g_malloc (length + 1));
-					if (!start)
-						break;
-					strcpy (start, end + 1);
-					index = strlen (start);
-				}
-			}
-			if (index == length)
-				goto ok_exit;
-		} else
-			break;
+	std::string buf = "-i ";
+	buf += MimeToBabelType (mime_type);
+	buf += " ";
+	buf += path;
+	buf += " -o cml";
+	if (options) {
+		buf += " ";
+		buf += options;
 	}
-	if (start != inbuf)
-		g_free (start);
-	start = NULL;
-ok_exit:
-	g_object_unref (file);
-	close (sock);
-	return start;
+	g_free (path);
+	BabelClient *client = GetBabelClient ();
+	unsigned id = client->Send (buf, NULL, 0, true);
+	return (id)? client->Wait (id): NULL;
 }
 
 char* Application::ConvertToCML (GsfInput *input, const char *mime_type, const char *options)
 {
-	int sock = OpenBabelSocket ();
-	if (sock <= 0)
-		return NULL;
-	size_t n = gsf_input_size (input);
-	char const *outbuf = reinterpret_cast <char const *> (gsf_input_read (input, n, NULL));
 	std::string buf = "-i ";
 	buf += MimeToBabelType (mime_type);
 	buf += " -o cml";
@@ -690,136 +584,52 @@ char* Application::ConvertToCML (GsfInput *input, const char *mime_type, const c
 		buf += " ";
 		buf += options;
 	}
-	char *szsize = g_strdup_printf (" -l %lu -D", n);
-	buf += szsize;
-	g_free (szsize);
-	write (sock, buf.c_str (), buf.length ());
-	write (sock, outbuf, n);
-	time_t timeout = time (NULL) + 60;
-	char inbuf[256], *start = inbuf, *end;
-	unsigned cur, index = 0, length = 0;
-	while (time (NULL) < timeout) {
-		if ((cur = read (sock, start + index, ((length)? length: 255) - index))) {
-			index += cur;
-			start[index] = 0;
-			if (start == inbuf) {
-				if ((end = strchr (inbuf, ' '))) {
-					length = strtoul (inbuf, NULL, 10);
-					start = reinterpret_cast <char *> (g_malloc (length + 1));
-					if (!start)
-						break;
-					strcpy (start, end + 1);
-					index = strlen (start);
-				}
-			}
-			if (index == length)
-				goto ok_exit;
-		} else
-			break;
-	}
-	if (start != inbuf)
-		g_free (start);
-	start = NULL;
-ok_exit:
-	close (sock);
-	return start;
+	BabelClient *client = GetBabelClient ();
+	unsigned id = client->SendInput (buf, input, true);
+	return (id)? client->Wait (id): NULL;
 }
 
 void Application::ConvertFromCML (char const *cml, std::string const &uri, const char *mime_type, const char *options)
 {
-	int sock = OpenBabelSocket ();
-	if (sock <= 0)
-		return;
 	GVfs *vfs = g_vfs_get_default ();
 	GFile *file = g_vfs_get_file_for_uri (vfs, uri.c_str ());
 	char *path = g_file_get_path (file);
-	std::ostringstream os;
-	size_t l = strlen (cml);
-	os << "-i cml -o ";
-	os << MimeToBabelType (mime_type);
-	if (path) {
-		os << " " << path;
-		if (options)
-			os << " " << options;
-		os << " -l" << l << " -D";
-		write (sock, os.str ().c_str (), os.str ().length ());
-		write (sock, cml, l);
-		g_free (path);
-		g_object_unref (file);
-		return; // no need to wait, direct output
-	}
-	// if we are there, this means that we have a distant file to write
-	os << "" -l << l << " -D";
-	write (sock, os.str ().c_str (), os.str ().length ());
-	write (sock, cml, l);
-	time_t timeout = time (NULL) + 60;
-	char inbuf[256], *start = inbuf, *end;
-	unsigned cur, index = 0, length = 0;
-	while (time (NULL) < timeout) {
-		if ((cur = read (sock, start + index, ((length)? length: 255) - index))) {
-			index += cur;
-			start[index] = 0;
-			if (start == inbuf) {
-				if ((end = strchr (inbuf, ' '))) {
-					length = strtoul (inbuf, NULL, 10);
-					start = reinterpret_cast <char *> (g_malloc (length + 1));
-					if (!start)
-						break;
-					strcpy (start, end + 1);
-					index = strlen (start);
-				}
-			}
-			if (index == length)
-				break;
-		} else // something failed, we should post an error message
-			goto exit_point;
-	}
-	// save to distant file
-exit_point:
-	if (start != inbuf)
-		g_free (start);
 	g_object_unref (file);
-	close (sock);
+	if (!path) {
+		// if we are there, this means that we have a distant file to write
+		GError *error = NULL;
+		GsfOutput *output = gsf_output_gio_new_for_uri (uri.c_str (), &error);
+		if (!output) {
+			g_message ("GIO could not create the file: %s", error->message);
+			g_error_free (error);
+			return;
+		}
+		ConvertFromCML (cml, output, mime_type, options);
+		gsf_output_close (output);
+		g_object_unref (output);
+		return;
+	}
+	std::ostringstream os;
+	os << "-i cml -o " << MimeToBabelType (mime_type) << " " << path;
+	if (options)
+		os << " " << options;
+	g_free (path);
+	BabelClient *client = GetBabelClient ();
+	unsigned id = client->Send (os.str (), cml, strlen (cml));
+	if (id)
+		client->Forget (id); // no need to wait, direct output
 }
 
 void Application::ConvertFromCML (char const *cml, GsfOutput *output, const char *mime_type, const char *options)
 {
-	int sock = OpenBabelSocket ();
-	if (sock <= 0)
-		return;
 	std::ostringstream os;
-	size_t l = strlen (cml);
-	os << "-i cml -o ";
-	os << MimeToBabelType (mime_type);
+	os << "-i cml -o " << MimeToBabelType (mime_type);
 	if (options)
 		os << " " << options;
-	os << " -l " << l << " -D";
-	write (sock, os.str ().c_str (), os.str ().length ());
-	write (sock, cml, l);
-	time_t timeout = time (NULL) + 60;
-	char inbuf[256], *start = inbuf, *end;
-	int cur, index = 0, length = 0;
-	while (time (NULL) < timeout) {
-		if ((cur = read (sock, start + index, ((length)? length: 255) - index)) > 0) {
-			index += cur;
-			start[index] = 0;
-			if (start == inbuf) {
-				if ((end = strchr (inbuf, ' '))) {
-					length = strtoul (inbuf, NULL, 10);
-					start = reinterpret_cast <char *> (g_malloc (length + 1));
-					if (!start)
-						break;
-					strcpy (start, end + 1);
-					index = strlen (start);
-				}
-			}
-			if (index == length) {
-				gsf_output_write (output, length, reinterpret_cast <guint8 *> (start));
-				break;
-			}
-		} else // something failed, we should post an error message
-			break;
-	}
+	BabelClient *client = GetBabelClient ();
+	unsigned id = client->Send (os.str (), cml, strlen (cml), true);
+	if (id)
+		client->Wait (id, output);
 }
 
 }	//	namespace gcu
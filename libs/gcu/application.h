@@ -43,6 +43,7 @@ struct option_data;
 class TypeDesc;
 class CmdContext;
 class UIManager;
+class BabelClient;
 
 typedef struct {
 	std::string name;
@@ -403,6 +404,13 @@ This method converts CML to a target.
 */
 	void ConvertFromCML (const char *cml, GsfOutput *output, const char *mime_type, const char *options = NULL);
 
+/*!
+@return the persistent connection to the OpenBabel server used by the
+conversion methods. Callers converting many documents might send several
+requests through it before waiting for the answers.
+*/
+	BabelClient *GetBabelClient ();
+
 /*!
 @param classname the name of a class such as "Molecule".
 @return the list of the databases available for the given classname.
@@ -450,7 +458,6 @@ The CmdContext used to display messages, might be NULL.
 private:
 	void AddDocument (Document *Doc) {m_Docs.insert (Doc);}
 	void RemoveDocument (Document *Doc);
-	int OpenBabelSocket ();
 	char const *MimeToBabelType (char const *mime_type);
 
 private:
@@ -464,6 +471,7 @@ private:
 	std::list <option_data> m_Options;
 	std::map <TypeId, TypeDesc> m_Types;
 	std::map <std::string, std::string> m_BabelTypes;
+	BabelClient *m_BabelClient;
 	std::map < std::string, std::list <Database> >m_Databases;
 
 /*!\var m_Docs
@@ -103,9 +103,10 @@ Retrieves the coordinates of this Atom.
 @param y the new y coordinate of the Atom.
 @param z the new z coordinate of the Atom.
 
-Changes the position of this Atom.
+Changes the position of this Atom. Derived classes overriding this method must
+call it.
 */
-	void SetCoords (double x, double y, double z = 0) {m_x = x; m_y = y; m_z = z;}
+	virtual void SetCoords (double x, double y, double z = 0) {m_x = x; m_y = y; m_z = z;}
 /*!
 @return the atomic number of the atom.
 */
@@ -245,6 +246,14 @@ and return its result.
 @return true if the atoms match, false otherwise.
 */
 	virtual bool Match (Atom *atom, AtomMatchState &state);
+/*!
+Used to hash molecules, see CanonicalLabeling. The returned value must depend
+only on the properties compared by Match(), except for the number of bonds, so
+derived classes overriding Match() should override this method too.
+@return the invariant of the atom, or a negative value if the atom can't be
+matched.
+*/
+	virtual int GetMatchInvariant () const {return m_Z;}
 
 /*!
 @return the localized object generic name.
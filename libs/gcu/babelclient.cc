@@ -0,0 +1,440 @@
+// -*- C++ -*-
+
+/*
+ * Gnome Chemistry Utils
+ * gcu/babelclient.cc
+ *
+ * Copyright (C) 2026 Jean Bréfort <jean.brefort@normalesup.org>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301
+ * USA
+ */
+
+
+#include "config.h"
+#include "babelclient.h"
+#include "input.h"
+#include <glib.h>
+#include <glib/gstdio.h>
+#include <glib/gi18n-lib.h>
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <poll.h>
+#include <sstream>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#define BUF_SIZE 0x10000
+#define FD_THRESHOLD 0x100000 // inputs larger than 1 MiB are passed as files
+#define TIMEOUT 60000 // 60 s without anything received is considered a failure
+
+#ifndef MSG_NOSIGNAL
+#	define MSG_NOSIGNAL 0
+#endif
+
+namespace gcu
+{
+
+static int connect_server (std::string const &path)
+{
+	int res = socket (AF_UNIX, SOCK_STREAM, 0);
+	if (res == -1)
+		return -1;
+	struct sockaddr_un adr_serv;
+	adr_serv.sun_family = AF_UNIX;
+	strcpy (adr_serv.sun_path, path.c_str ());
+	if (connect (res, (const struct sockaddr*) &adr_serv, sizeof (struct sockaddr_un)) == -1) {
+		close (res);
+		return -1;
+	}
+	return res;
+}
+
+static bool wait_for_input (int fd)
+{
+	struct pollfd pfd;
+	pfd.fd = fd;
+	pfd.events = POLLIN;
+	int res;
+	do {
+		pfd.revents = 0;
+		res = poll (&pfd, 1, TIMEOUT);
+	} while (res == -1 && errno == EINTR);
+	return res > 0;
+}
+
+static int create_anonymous_file ()
+{
+	int fd;
+#ifdef MFD_CLOEXEC
+	if ((fd = memfd_create ("gcu-babel", MFD_CLOEXEC)) >= 0)
+		return fd;
+#endif
+	char *name = g_build_filename (g_get_tmp_dir (), "gcu-babel-XXXXXX", NULL);
+	if ((fd = g_mkstemp (name)) >= 0)
+		g_unlink (name);
+	g_free (name);
+	return fd;
+}
+
+BabelClient::BabelClient ():
+	m_Socket (-1),
+	m_NextId (0),
+	m_Start (0),
+	m_End (0),
+	m_Output (NULL),
+	m_OutputId (0)
+{
+	m_Buf = new char[BUF_SIZE];
+}
+
+BabelClient::~BabelClient ()
+{
+	Close ();
+	std::map <unsigned, Answer>::iterator i, end = m_Answers.end ();
+	for (i = m_Answers.begin (); i != end; i++)
+		g_free ((*i).second.data);
+	delete [] m_Buf;
+}
+
+bool BabelClient::Connect ()
+{
+	char const *user = getenv ("USER");
+	std::string path = "/tmp/babelsocket-";
+	if (user)
+		path += user;
+	if (path.length () >= 107) //WARNING: don't know if this is portable
+		return false;
+	m_Socket = connect_server (path);
+	if (m_Socket < 0) {
+		/* start the server, the spawned process exits once the server is
+		 listening. The server keeps its results cache in the user cache
+		 directory when exiting. */
+		char *dir = g_build_filename (g_get_user_cache_dir (), "gchemutils", NULL);
+		g_mkdir_with_parents (dir, 0700);
+		char *cache = g_build_filename (dir, "babelserver.cache", NULL);
+		g_free (dir);
+		char *args[] = {const_cast <char *> (LIBEXECDIR"/babelserver"), const_cast <char *> ("-p"), cache, NULL};
+		GError *error = NULL;
+		int status;
+		bool spawned = g_spawn_sync (NULL, args, NULL, static_cast <GSpawnFlags> (0), NULL, NULL, NULL, NULL, &status, &error);
+		g_free (cache);
+		if (!spawned) {
+			g_message ("Could not start the OpenBabel server: %s", error->message);
+			g_error_free (error);
+			return false;
+		}
+		m_Socket = connect_server (path);
+		if (m_Socket < 0) {
+			perror (_("Connection failed"));
+			return false;
+		}
+	}
+	m_Start = m_End = 0;
+	return true;
+}
+
+void BabelClient::Close ()
+{
+	if (m_Socket >= 0)
+		close (m_Socket);
+	m_Socket = -1;
+	// the answers to these requests will never arrive
+	m_Pending.clear ();
+	m_Forgotten.clear ();
+	m_Streamed.clear ();
+	m_Failed.clear ();
+	m_Start = m_End = 0;
+}
+
+bool BabelClient::Write (char const *data, size_t size, int fd)
+{
+	struct pollfd pfd;
+	pfd.fd = m_Socket;
+	pfd.events = POLLIN | POLLOUT;
+	while (size > 0) {
+		pfd.revents = 0;
+		int res = poll (&pfd, 1, TIMEOUT);
+		if (res == -1 && errno == EINTR)
+			continue;
+		if (res <= 0)
+			return false;
+		if (pfd.revents & POLLIN) {
+			/* read the answers while writing, otherwise the server might be
+			 blocked when sending them, and would stop reading */
+			if (!ReadAnswer ())
+				return false;
+			continue;
+		}
+		if (pfd.revents & (POLLERR | POLLHUP))
+			return false;
+		ssize_t n;
+		if (fd >= 0) {
+			// attach the file descriptor to the first bytes sent
+			struct iovec iov;
+			iov.iov_base = const_cast <char *> (data);
+			iov.iov_len = size;
+			char control[CMSG_SPACE (sizeof (int))];
+			memset (control, 0, sizeof (control));
+			struct msghdr msg;
+			memset (&msg, 0, sizeof (msg));
+			msg.msg_iov = &iov;
+			msg.msg_iovlen = 1;
+			msg.msg_control = control;
+			msg.msg_controllen = sizeof (control);
+			struct cmsghdr *cmsg = CMSG_FIRSTHDR (&msg);
+			cmsg->cmsg_level = SOL_SOCKET;
+			cmsg->cmsg_type = SCM_RIGHTS;
+			cmsg->cmsg_len = CMSG_LEN (sizeof (int));
+			memcpy (CMSG_DATA (cmsg), &fd, sizeof (int));
+			if ((n = sendmsg (m_Socket, &msg, MSG_DONTWAIT | MSG_NOSIGNAL)) > 0)
+				fd = -1;
+		} else
+			n = send (m_Socket, data, size, MSG_DONTWAIT | MSG_NOSIGNAL);
+		if (n < 0) {
+			if (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR)
+				continue;
+			return false;
+		}
+		data += n;
+		size -= n;
+	}
+	return true;
+}
+
+bool BabelClient::Fill ()
+{
+	if (m_Start > 0) {
+		memmove (m_Buf, m_Buf + m_Start, m_End - m_Start);
+		m_End -= m_Start;
+		m_Start = 0;
+	}
+	if (m_End == BUF_SIZE || !wait_for_input (m_Socket))
+		return false;
+	ssize_t n = read (m_Socket, m_Buf + m_End, BUF_SIZE - m_End);
+	if (n <= 0)
+		return false;
+	m_End += n;
+	return true;
+}
+
+bool BabelClient::ReadAnswer ()
+{
+	/* the answer, or each chunk of a streamed answer, starts with "<id> <length> ",
+	 a length of -1 ending an answer which the server could not complete */
+	char *id_end = NULL, *size_end = NULL;
+	while (!(id_end = reinterpret_cast <char *> (memchr (m_Buf + m_Start, ' ', m_End - m_Start))) ||
+		   !(size_end = reinterpret_cast <char *> (memchr (id_end + 1, ' ', m_Buf + m_End - id_end - 1))))
+		if (!Fill ())
+			return false;
+	unsigned id = strtoul (m_Buf + m_Start, NULL, 10);
+	long value = strtol (id_end + 1, NULL, 10);
+	size_t length = (value > 0)? value: 0, n;
+	m_Start = size_end + 1 - m_Buf;
+	// a streamed answer ends with an empty chunk
+	bool last = m_Streamed.find (id) == m_Streamed.end () || value <= 0;
+	bool keep = m_Forgotten.find (id) == m_Forgotten.end ();
+	if (value < 0 && keep)
+		m_Failed.insert (id);
+	Answer *answer = NULL;
+	if (keep && id != m_OutputId) {
+		answer = &m_Answers[id];
+		if (answer->length + length + 1 > answer->size) {
+			size_t size = MAX (2 * answer->size, answer->length + length + 1);
+			char *data = reinterpret_cast <char *> (g_try_realloc (answer->data, size));
+			if (!data)
+				return false;
+			answer->data = data;
+			answer->size = size;
+		}
+	}
+	while (length > 0) {
+		if (m_Start < m_End) {
+			n = MIN (length, m_End - m_Start);
+			if (answer) {
+				memcpy (answer->data + answer->length, m_Buf + m_Start, n);
+				answer->length += n;
+			} else if (keep)
+				gsf_output_write (m_Output, n, reinterpret_cast <guint8 *> (m_Buf + m_Start));
+			m_Start += n;
+		} else if (answer) {
+			// read what remains directly to its final place
+			ssize_t res = (wait_for_input (m_Socket))? read (m_Socket, answer->data + answer->length, length): -1;
+			if (res <= 0)
+				return false;
+			n = res;
+			answer->length += n;
+		} else if (Fill ())
+			continue;
+		else
+			return false;
+		length -= n;
+	}
+	if (answer)
+		answer->data[answer->length] = 0;
+	if (last) {
+		m_Pending.erase (id);
+		m_Streamed.erase (id);
+		m_Forgotten.erase (id);
+	}
+	return true;
+}
+
+unsigned BabelClient::SendRequest (std::string const &request, char const *data, size_t size, int fd, bool stream)
+{
+	if (++m_NextId == 0)
+		m_NextId = 1;
+	std::ostringstream header;
+	header << "--id " << m_NextId << " ";
+	if (stream)
+		header << "--stream ";
+	if (fd >= 0)
+		header << "--fd ";
+	header << request;
+	if (data)
+		header << " -l " << size;
+	header << " -D";
+	std::string const &str = header.str ();
+	// try a new connection if the previous one failed, e.g. if the server exited
+	for (int attempt = 0; attempt < 2; attempt++) {
+		if (m_Socket < 0 && !Connect ())
+			return 0;
+		if (Write (str.c_str (), str.length (), fd) && (!data || Write (data, size))) {
+			m_Pending.insert (m_NextId);
+			if (stream)
+				m_Streamed.insert (m_NextId);
+			return m_NextId;
+		}
+		Close ();
+		if (fd >= 0)
+			lseek (fd, 0, SEEK_SET);
+	}
+	return 0;
+}
+
+unsigned BabelClient::Send (std::string const &request, char const *data, size_t size, bool stream)
+{
+	return SendRequest (request, data, size, -1, stream);
+}
+
+unsigned BabelClient::SendFile (std::string const &request, int fd, bool stream)
+{
+	return (fd >= 0)? SendRequest (request, NULL, 0, fd, stream): 0;
+}
+
+unsigned BabelClient::SendInput (std::string const &request, GsfInput *input, bool stream)
+{
+	gsf_off_t size = gsf_input_remaining (input);
+	int fd = (size > FD_THRESHOLD)? create_anonymous_file (): -1;
+	if (fd < 0) {
+		char const *data = GetInputData (input, size);
+		return Send (request, (data)? data: "", size, stream);
+	}
+	// copy the data by chunks, so that they are never all in memory
+	guint8 const *data;
+	while (size > 0) {
+		size_t n = MIN (size, BUF_SIZE);
+		if (!(data = gsf_input_read (input, n, NULL))) {
+			close (fd);
+			return 0;
+		}
+		while (n > 0) {
+			ssize_t res = write (fd, data, n);
+			if (res < 0 && errno == EINTR)
+				continue;
+			if (res <= 0) {
+				close (fd);
+				return 0;
+			}
+			data += res;
+			n -= res;
+			size -= res;
+		}
+	}
+	lseek (fd, 0, SEEK_SET);
+	unsigned id = SendFile (request, fd, stream);
+	close (fd);
+	return id;
+}
+
+char *BabelClient::Wait (unsigned id, size_t *length)
+{
+	bool failed = false;
+	while (m_Pending.find (id) != m_Pending.end ())
+		if (!ReadAnswer ()) {
+			Close ();
+			failed = true;
+			break;
+		}
+	if (m_Failed.erase (id))
+		failed = true;
+	std::map <unsigned, Answer>::iterator it = m_Answers.find (id);
+	if (it == m_Answers.end ())
+		return NULL;
+	char *res = (*it).second.data;
+	if (failed) {
+		// the answer is incomplete
+		g_free (res);
+		res = NULL;
+	} else if (length)
+		*length = (*it).second.length;
+	m_Answers.erase (it);
+	return res;
+}
+
+bool BabelClient::Wait (unsigned id, GsfOutput *output)
+{
+	std::map <unsigned, Answer>::iterator it = m_Answers.find (id);
+	bool pending = m_Pending.find (id) != m_Pending.end ();
+	if (it == m_Answers.end () && !pending)
+		return false;
+	// first write what has already been received
+	if (it != m_Answers.end ()) {
+		gsf_output_write (output, (*it).second.length, reinterpret_cast <guint8 *> ((*it).second.data));
+		g_free ((*it).second.data);
+		m_Answers.erase (it);
+	}
+	bool res = true;
+	m_Output = output;
+	m_OutputId = id;
+	while (m_Pending.find (id) != m_Pending.end ())
+		if (!ReadAnswer ()) {
+			Close ();
+			res = false;
+			break;
+		}
+	m_Output = NULL;
+	m_OutputId = 0;
+	// chunks might have been written before the server failed
+	return m_Failed.erase (id)? false: res;
+}
+
+void BabelClient::Forget (unsigned id)
+{
+	std::map <unsigned, Answer>::iterator it = m_Answers.find (id);
+	if (it != m_Answers.end ()) {
+		g_free ((*it).second.data);
+		m_Answers.erase (it);
+	}
+	m_Failed.erase (id);
+	if (m_Pending.find (id) != m_Pending.end ())
+		m_Forgotten.insert (id);
+}
+
+}	//	namespace gcu
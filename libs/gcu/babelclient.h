@@ -0,0 +1,161 @@
+// -*- C++ -*-
+
+/*
+ * Gnome Chemistry Utils
+ * gcu/babelclient.h
+ *
+ * Copyright (C) 2026 Jean Bréfort <jean.brefort@normalesup.org>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301
+ * USA
+ */
+
+
+#ifndef GCU_BABEL_CLIENT_H
+#define GCU_BABEL_CLIENT_H
+
+#include <gsf/gsf-input.h>
+#include <gsf/gsf-output.h>
+#include <cstddef>
+#include <map>
+#include <set>
+#include <string>
+
+/*!\file*/
+namespace gcu
+{
+
+/*!\class BabelClient gcu/babelclient.h
+A persistent connection to the OpenBabel server. Each request is given an
+identifier, so that several requests can be sent before waiting for the first
+answer, and the answers, which might come in any order, are kept until they
+are asked for. The server is started if needed, and the connection is opened
+again after a failure. Each Application owns a BabelClient, see
+Application::GetBabelClient().
+
+A typical use, converting several files at once, would be:
+\code
+std::vector <unsigned> ids;
+for (i = 0; i < n; i++)
+	ids.push_back (client->Send (requests[i], NULL, 0));
+for (i = 0; i < n; i++) {
+	char *cml = client->Wait (ids[i]);
+	...
+	g_free (cml);
+}
+\endcode
+*/
+class BabelClient
+{
+public:
+/*!
+The constructor. The connection is only opened when the first request is sent.
+*/
+	BabelClient ();
+/*!
+The destructor. Closes the connection.
+*/
+	~BabelClient ();
+
+/*!
+@param request the request options, such as "-i xyz -o cml".
+@param data the data to convert, or NULL if the input is a file given in
+\a request.
+@param size the data size.
+@param stream whether the server should send the answer by chunks as soon as
+they are available instead of all at once.
+
+Sends a request to the server, without waiting for the answer.
+@return the request identifier, or 0 on error.
+*/
+	unsigned Send (std::string const &request, char const *data, size_t size, bool stream = false);
+/*!
+@param request the request options, such as "-i xyz -o cml".
+@param fd an open file descriptor.
+@param stream whether the answer should be streamed, see Send().
+
+Sends a request to the server, passing \a fd through the socket, so that the
+server reads the data directly from it. The caller keeps its own descriptor
+and should close it.
+@return the request identifier, or 0 on error.
+*/
+	unsigned SendFile (std::string const &request, int fd, bool stream = false);
+/*!
+@param request the request options, such as "-i xyz -o cml".
+@param input the data to convert.
+@param stream whether the answer should be streamed, see Send().
+
+Sends the remaining contents of \a input. Small inputs are sent through the
+socket, while large ones are copied to an anonymous file passed to the server
+with SendFile(), avoiding copies of the whole data in both processes.
+@return the request identifier, or 0 on error.
+*/
+	unsigned SendInput (std::string const &request, GsfInput *input, bool stream = false);
+/*!
+@param id a request identifier returned by Send().
+@param length where to store the answer length, might be NULL.
+
+Waits for the answer to a request. Answers to other requests received in the
+meantime are kept for later calls.
+@return the answer as a newly allocated string which must be freed using
+g_free(), or NULL on error, including when the server could not send the whole
+answer.
+*/
+	char *Wait (unsigned id, size_t *length = NULL);
+/*!
+@param id a request identifier returned by Send().
+@param output where to write the answer.
+
+Waits for the answer to a request, writing it to \a output. When the answer is
+streamed, each chunk is written when received.
+@return true on success, false if the answer is incomplete, even if some
+chunks were already written.
+*/
+	bool Wait (unsigned id, GsfOutput *output);
+/*!
+@param id a request identifier returned by Send().
+
+Tells that the answer to a request is not needed, typically because the
+output is a file. The answer will be discarded when received.
+*/
+	void Forget (unsigned id);
+
+private:
+	bool Connect ();
+	void Close ();
+	unsigned SendRequest (std::string const &request, char const *data, size_t size, int fd, bool stream);
+	bool Write (char const *data, size_t size, int fd = -1);
+	bool Fill ();
+	bool ReadAnswer ();
+
+private:
+	struct Answer {
+		Answer (): data (NULL), length (0), size (0) {}
+		char *data;
+		size_t length, size;
+	};
+	int m_Socket;
+	unsigned m_NextId;
+	std::set <unsigned> m_Pending, m_Forgotten, m_Streamed, m_Failed;
+	std::map <unsigned, Answer> m_Answers;
+	char *m_Buf;
+	size_t m_Start, m_End;
+	GsfOutput *m_Output;
+	unsigned m_OutputId;
+};
+
+}	//	namespace gcu
+
+#endif	//	GCU_BABEL_CLIENT_H
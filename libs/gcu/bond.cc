@@ -281,7 +281,7 @@ Cycle* Bond::GetFirstCycle (std::list<Cycle*>::iterator& i, Cycle * pCycle)
 
 Cycle* Bond::GetNextCycle (std::list<Cycle*>::iterator& i, Cycle * pCycle)
 {
-	if (*i == pCycle)
+	if (i != m_Cycles.end () && *i == pCycle)
 		i++;
 	if (i == m_Cycles.end ())
 		return NULL;
@@ -0,0 +1,240 @@
+// -*- C++ -*-
+
+/*
+ * Gnome Chemistry Utils
+ * gcu/canonical.cc
+ *
+ * Copyright (C) 2026 Jean Bréfort <jean.brefort@normalesup.org>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301
+ * USA
+ */
+
+
+#include "config.h"
+#include "canonical.h"
+#include "atom.h"
+#include "molecule.h"
+#include <algorithm>
+#include <map>
+
+namespace gcu
+{
+
+static guint64 mix (guint64 hash, guint64 value)
+{
+	hash = (hash ^ value) * G_GUINT64_CONSTANT (0x100000001b3);
+	return hash ^ (hash >> 29);
+}
+
+CanonicalLabeling::CanonicalLabeling (Molecule const *molecule):
+	m_Cells (0),
+	m_Bonds (0),
+	m_Matchable (true)
+{
+	std::map <Atom const *, unsigned> index;
+	std::map <Atom const *, unsigned>::iterator k;
+	std::list <Atom *>::const_iterator i;
+	std::map <Bondable *, Bond *>::const_iterator j;
+	Atom const *atom;
+	for (atom = molecule->GetFirstAtom (i); atom; atom = molecule->GetNextAtom (i)) {
+		index[atom] = m_Atoms.size ();
+		m_Atoms.push_back (const_cast <Atom *> (atom));
+	}
+	unsigned n = m_Atoms.size (), a, p;
+	// initial classes
+	std::vector < std::pair < std::pair <int, int>, unsigned > > keys (n);
+	m_AdjStart.push_back (0);
+	for (a = 0; a < n; a++) {
+		atom = m_Atoms[a];
+		for (Bond const *bond = atom->GetFirstBond (j); bond; bond = atom->GetNextBond (j))
+			if ((k = index.find (dynamic_cast <Atom const *> ((*j).first))) != index.end ())
+				m_Adj.push_back ((*k).second);
+		m_AdjStart.push_back (m_Adj.size ());
+		m_Invariants.push_back (atom->GetMatchInvariant ());
+		if (m_Invariants[a] < 0)
+			m_Matchable = false;
+		keys[a].first.first = m_Invariants[a];
+		keys[a].first.second = atom->GetBondsNumber ();
+		keys[a].second = a;
+	}
+	m_Bonds = m_Adj.size () / 2;
+	std::sort (keys.begin (), keys.end ());
+	m_Order.resize (n);
+	m_Pos.resize (n);
+	m_Cell.resize (n);
+	m_CellEnd.resize (n);
+	m_Queued.assign (n, false);
+	m_Count.assign (n, 0);
+	m_Hash = mix (mix (0, n), m_Bonds);
+	unsigned start = 0;
+	for (p = 0; p < n; p++) {
+		a = keys[p].second;
+		m_Order[p] = a;
+		m_Pos[a] = p;
+		if (p > 0 && keys[p].first != keys[p - 1].first) {
+			m_CellEnd[start] = p;
+			start = p;
+		}
+		if (p == start) {
+			m_Cells++;
+			m_Queue.push_back (start);
+			m_Queued[start] = true;
+			m_Hash = mix (mix (m_Hash, keys[p].first.first), keys[p].first.second);
+		}
+		m_Cell[a] = start;
+	}
+	if (n > 0)
+		m_CellEnd[start] = n;
+	Refine ();
+	// only the refinement is canonical, distinguishing atoms is not
+	guint64 hash = m_Hash;
+	while (m_Cells < n)
+		Individualize ();
+	m_Hash = hash;
+}
+
+CanonicalLabeling::~CanonicalLabeling ()
+{
+}
+
+void CanonicalLabeling::Refine ()
+{
+	typedef std::pair < std::pair <unsigned, unsigned>, unsigned > Touched;
+	std::vector < Touched > touched;
+	unsigned q, p, j, a, b, t, cur, next;
+	for (q = 0; q < m_Queue.size (); q++) {
+		unsigned splitter = m_Queue[q];
+		m_Queued[splitter] = false;
+		// count the neighbors of each atom in the splitting cell
+		m_Touched.clear ();
+		for (p = splitter; p < m_CellEnd[splitter]; p++) {
+			a = m_Order[p];
+			for (j = m_AdjStart[a]; j < m_AdjStart[a + 1]; j++)
+				if (m_Count[b = m_Adj[j]]++ == 0)
+					m_Touched.push_back (b);
+		}
+		// sort the touched atoms by cell and count, so that the result does not
+		// depend on the atoms order
+		touched.clear ();
+		for (t = 0; t < m_Touched.size (); t++) {
+			b = m_Touched[t];
+			touched.push_back (Touched (std::pair <unsigned, unsigned> (m_Cell[b], m_Count[b]), b));
+			m_Count[b] = 0;
+		}
+		std::sort (touched.begin (), touched.end ());
+		for (cur = 0; cur < touched.size (); cur = next) {
+			unsigned cell = touched[cur].first.first, end = m_CellEnd[cell];
+			for (next = cur + 1; next < touched.size () && touched[next].first.first == cell; next++);
+			if (next - cur == end - cell && touched[cur].first.second == touched[next - 1].first.second)
+				continue; // all atoms have the same count
+			// move the touched atoms to the end of the cell, by increasing count
+			unsigned first = end - (next - cur);
+			for (t = cur; t < next; t++) {
+				unsigned target = first + t - cur, other = m_Order[target];
+				a = touched[t].second;
+				p = m_Pos[a];
+				m_Order[p] = other;
+				m_Pos[other] = p;
+				m_Order[target] = a;
+				m_Pos[a] = target;
+				m_Count[a] = touched[t].first.second;
+			}
+			Split (cell, first);
+			for (t = cur; t < next; t++)
+				m_Count[touched[t].second] = 0;
+		}
+	}
+	m_Queue.clear ();
+}
+
+void CanonicalLabeling::Split (unsigned cell, unsigned first)
+{
+	// the atoms before first are not bonded to the splitter, the other ones
+	// are sorted by their count, stored in m_Count
+	unsigned end = m_CellEnd[cell], start, p, largest = cell, size = 0;
+	bool queued = m_Queued[cell];
+	std::vector <unsigned> starts;
+	if (first > cell)
+		starts.push_back (cell);
+	for (p = first; p < end; p++)
+		if (p == first || m_Count[m_Order[p]] != m_Count[m_Order[p - 1]])
+			starts.push_back (p);
+	starts.push_back (end);
+	for (unsigned i = 0; i + 1 < starts.size (); i++) {
+		start = starts[i];
+		m_CellEnd[start] = starts[i + 1];
+		if (start != cell)
+			for (p = start; p < starts[i + 1]; p++)
+				m_Cell[m_Order[p]] = start;
+		m_Hash = mix (mix (mix (m_Hash, cell), m_Count[m_Order[start]]), starts[i + 1] - start);
+		if (starts[i + 1] - start > size) {
+			size = starts[i + 1] - start;
+			largest = start;
+		}
+	}
+	m_Cells += starts.size () - 2;
+	// the largest new cell is not needed to split the others unless the whole
+	// cell was already waiting
+	for (unsigned i = 0; i + 1 < starts.size (); i++) {
+		start = starts[i];
+		if (m_Queued[start] || (start == largest && !queued))
+			continue;
+		m_Queue.push_back (start);
+		m_Queued[start] = true;
+	}
+}
+
+void CanonicalLabeling::Individualize ()
+{
+	// the last atom of the first cell with several atoms gets its own cell
+	unsigned cell = 0, end;
+	while (m_CellEnd[cell] - cell == 1)
+		cell = m_CellEnd[cell];
+	end = m_CellEnd[cell];
+	m_CellEnd[cell] = end - 1;
+	m_CellEnd[end - 1] = end;
+	m_Cell[m_Order[end - 1]] = end - 1;
+	m_Cells++;
+	m_Queue.push_back (end - 1);
+	m_Queued[end - 1] = true;
+	Refine ();
+}
+
+bool CanonicalLabeling::IsEquivalent (CanonicalLabeling const &labeling) const
+{
+	unsigned n = m_Atoms.size (), p, j;
+	if (m_Hash != labeling.m_Hash || n != labeling.m_Atoms.size () || m_Bonds != labeling.m_Bonds || !m_Matchable || !labeling.m_Matchable)
+		return false;
+	std::vector <unsigned> neighbors1, neighbors2;
+	for (p = 0; p < n; p++) {
+		unsigned a = m_Order[p], b = labeling.m_Order[p];
+		if (m_Invariants[a] != labeling.m_Invariants[b] || m_Atoms[a]->GetBondsNumber () != labeling.m_Atoms[b]->GetBondsNumber ())
+			return false;
+		neighbors1.clear ();
+		for (j = m_AdjStart[a]; j < m_AdjStart[a + 1]; j++)
+			neighbors1.push_back (m_Pos[m_Adj[j]]);
+		neighbors2.clear ();
+		for (j = labeling.m_AdjStart[b]; j < labeling.m_AdjStart[b + 1]; j++)
+			neighbors2.push_back (labeling.m_Pos[labeling.m_Adj[j]]);
+		std::sort (neighbors1.begin (), neighbors1.end ());
+		std::sort (neighbors2.begin (), neighbors2.end ());
+		if (neighbors1 != neighbors2)
+			return false;
+	}
+	return true;
+}
+
+}	//	namespace gcu
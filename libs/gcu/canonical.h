@@ -0,0 +1,119 @@
+// -*- C++ -*-
+
+/*
+ * Gnome Chemistry Utils
+ * gcu/canonical.h
+ *
+ * Copyright (C) 2026 Jean Bréfort <jean.brefort@normalesup.org>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301
+ * USA
+ */
+
+
+#ifndef GCU_CANONICAL_H
+#define GCU_CANONICAL_H
+
+#include <glib.h>
+#include <vector>
+
+/*!\file*/
+namespace gcu
+{
+
+class Atom;
+class Molecule;
+
+/*!\class CanonicalLabeling gcu/canonical.h
+Evaluates a canonical order and a hash for the atoms of a molecule. The atoms
+are first classified using their Z, their number of bonds and the value
+returned by Atom::GetMatchInvariant(), then the classes are refined using the
+classes of the neighbors until no more class can be split (the classes are
+then those found by the Morgan or Weisfeiler-Lehman algorithms). The hash
+depends only on the refinement steps, so that two identical molecules always
+give the same hash. Atoms which still share a class are then distinguished one
+by one to get a canonical order.
+
+The refinement moves only the atoms bonded to the class used to split the
+others, so that the time needed is nearly linear even for long chains.
+*/
+class CanonicalLabeling
+{
+public:
+/*!
+@param molecule the molecule to label.
+
+Builds the labeling. The molecule must not be modified while the labeling is
+used.
+*/
+	CanonicalLabeling (Molecule const *molecule);
+/*!
+The destructor.
+*/
+	~CanonicalLabeling ();
+
+/*!
+@return the hash of the molecule.
+*/
+	guint64 GetHash () const {return m_Hash;}
+/*!
+@return the number of atoms in the molecule.
+*/
+	unsigned GetAtomsNumber () const {return m_Atoms.size ();}
+/*!
+@param i an index.
+@return the atom at position \a i in the canonical order.
+*/
+	Atom *GetAtom (unsigned i) const {return m_Atoms[m_Order[i]];}
+/*!
+@return whether the molecule includes atoms which can't be matched.
+*/
+	bool IsMatchable () const {return m_Matchable;}
+/*!
+@param labeling the labeling of another molecule.
+
+Checks that the atoms at the same position in both canonical orders are
+equivalent and bonded the same way. This might fail for some highly
+symmetrical but different molecules with identical hashes, in which case
+Molecule::operator== tries all possible matches.
+@return true if the canonical orders match.
+*/
+	bool IsEquivalent (CanonicalLabeling const &labeling) const;
+
+private:
+	void Refine ();
+	void Split (unsigned cell, unsigned first);
+	void Individualize ();
+
+private:
+	std::vector <Atom *> m_Atoms;
+	std::vector <int> m_Invariants;
+	// the neighbors of each atom
+	std::vector <unsigned> m_AdjStart, m_Adj;
+	// the partition: atoms in cell order, their positions, their cells, each
+	// cell being identified by its first position
+	std::vector <unsigned> m_Order, m_Pos, m_Cell, m_CellEnd;
+	// the cells which must be used to split the others
+	std::vector <unsigned> m_Queue;
+	std::vector <bool> m_Queued;
+	std::vector <unsigned> m_Count, m_Touched;
+	unsigned m_Cells, m_Bonds;
+	guint64 m_Hash;
+	bool m_Matchable;
+};
+
+}	//	namespace gcu
+
+#endif	//	GCU_CANONICAL_H
@@ -29,6 +29,7 @@
 #include "cycle.h"
 #include "molecule.h"
 #include "document.h"
+#include "rings.h"
 #include <glib/gi18n-lib.h>
 
 using namespace std;
@@ -57,26 +58,13 @@ Chain::Chain (Molecule* molecule, Atom* pAtom, TypeId Type): Object (Type)
 }
 
 /*
-* Add a bond in an existing molecule and update cycles
-* Implementation might have to be changed
+* Add or remove a bond in an existing molecule and update cycles
 */
 Chain::Chain (Molecule* molecule, Bond* pBond, TypeId Type): Object (Type)
 {
 	m_Molecule = molecule;
-	if (pBond) {
-		Atom *pAtom0, *pAtom;
-		pAtom0 = (Atom*) pBond->GetAtom (0);
-		m_Bonds[pAtom0].fwd = pBond;
-		pAtom = (Atom*) pBond->GetAtom (1);
-		m_Bonds[pAtom].rev = pBond;
-		map < gcu::Bondable *, gcu::Bond * >::iterator i;
-		Bond* pBond0 = (Bond*) pAtom->GetFirstBond (i);
-		while (pBond0) {
-			if ((pBond0 != pBond) && FindCycle (pAtom, pBond0))
-				break;
-			pBond0 = (Bond*) pAtom->GetNextBond (i);
-		}
-	}
+	if (pBond)
+		FindCycles (pBond);
 }
 
 Chain::~Chain ()
@@ -84,84 +72,98 @@ Chain::~Chain ()
 	m_Bonds.clear ();
 }
 
-bool Chain::FindCycle (Atom* pAtom, Bond* pBond)
+void Chain::Explore (RingFinder &finder, Atom* pAtom, bool add)
+{
+	// depth first exploration with an explicit stack, atoms are added to the
+	// molecule in the same order as a recursive exploration would do
+	std::vector < std::pair < Atom *, map < gcu::Bondable *, gcu::Bond * >::iterator > > stack;
+	Atom *pAtom0;
+	Bond *pBond;
+	Molecule *mol;
+	if (!finder.AddAtom (pAtom))
+		return;
+	stack.push_back (std::make_pair (pAtom, map < gcu::Bondable *, gcu::Bond * >::iterator ()));
+	pBond = (Bond*) pAtom->GetFirstBond (stack.back ().second);
+	while (!stack.empty ()) {
+		pAtom = stack.back ().first;
+		if (pBond == NULL) {
+			stack.pop_back ();
+			if (!stack.empty ())
+				pBond = (Bond*) stack.back ().first->GetNextBond (stack.back ().second);
+			continue;
+		}
+		pAtom0 = (Atom*) pBond->GetAtom (pAtom);
+		if (add && (mol = static_cast < Molecule * > (pBond->GetMolecule ())) != m_Molecule) {
+			if (mol)
+				mol->ClearCycles ();
+			m_Molecule->AddChild (pBond);
+		}
+		if (add && pAtom0->GetMolecule () != m_Molecule)
+			m_Molecule->AddChild (pAtom0);
+		if (finder.AddAtom (pAtom0)) {
+			finder.AddBond (pBond);
+			stack.push_back (std::make_pair (pAtom0, map < gcu::Bondable *, gcu::Bond * >::iterator ()));
+			pBond = (Bond*) pAtom0->GetFirstBond (stack.back ().second);
+		} else {
+			finder.AddBond (pBond);
+			pBond = (Bond*) pAtom->GetNextBond (stack.back ().second);
+		}
+	}
+}
+
+void Chain::AddCycles (RingFinder &finder)
 {
-	Atom* pAtom1 = (Atom*) pBond->GetAtom (pAtom);
-	if (m_Bonds[pAtom1].fwd != NULL) {
-		if (m_Bonds[pAtom1].rev != NULL)
-			return false;
+	unsigned i, j, n, max = finder.GetRings ();
+	for (i = 0; i < max; i++) {
 		Cycle* pCycle = new Cycle (m_Molecule);
-		pCycle->m_Bonds[pAtom1].rev = pBond;
-		pCycle->m_Bonds[pAtom1].fwd = m_Bonds[pAtom1].fwd;
-		pCycle->m_Bonds[pAtom].fwd = pBond;
-		pCycle->m_Bonds[pAtom].rev= m_Bonds[pAtom].rev;
-		m_Bonds[pAtom].rev->AddCycle (pCycle);
-		pBond->AddCycle (pCycle);
-		while (pBond = pCycle->m_Bonds[pAtom1].fwd, pAtom1 = (Atom*) pBond->GetAtom (pAtom1), pAtom != pAtom1) {
-			pCycle->m_Bonds[pAtom1].rev = pBond;
-			pCycle->m_Bonds[pAtom1].fwd = m_Bonds[pAtom1].fwd;
+		n = finder.GetRingSize (i);
+		for (j = 0; j < n; j++) {
+			Bond *pBond = finder.GetRingBond (i, j);
+			pCycle->m_Bonds[finder.GetRingAtom (i, j)].fwd = pBond;
+			pCycle->m_Bonds[finder.GetRingAtom (i, (j + 1) % n)].rev = pBond;
 			pBond->AddCycle (pCycle);
 		}
-		pCycle->Simplify ();	//to reduce size of fused cycles
 		m_Molecule->m_Cycles.push_back (pCycle);
-		return true;
-	}
-	m_Bonds[pAtom].fwd = pBond;
-	m_Bonds[pAtom1].rev = pBond;
-	map < gcu::Bondable *, gcu::Bond * >::iterator i;
-	Bond* pBond1 = (Bond*) pAtom1->GetFirstBond (i);
-	while (pBond1) {
-		if ((pBond1 != pBond) && FindCycle (pAtom1, pBond1))
-			return true;
-		pBond1 = (Bond*) pAtom1->GetNextBond (i);
 	}
-	m_Bonds[pAtom].fwd = NULL;
-	m_Bonds.erase (pAtom1);
-	return false;
 }
 
 void Chain::FindCycles (Atom* pAtom)
 {
-	map < gcu::Bondable *, gcu::Bond * >::iterator i;
-	Bond* pBond = (Bond*) pAtom->GetFirstBond (i);
-	Atom* pAtom0;
-	Molecule *mol;
-	while (pBond != NULL) {
-		m_Bonds[pAtom].fwd = pBond;
-		pAtom0 = (Atom*) pBond->GetAtom (pAtom);
-		if ((mol = static_cast < Molecule * > (pBond->GetMolecule ())) != m_Molecule) {
-			if (mol)
-				mol->ClearCycles ();
-			m_Molecule->AddChild (pBond);
-		}
-		if ((pAtom0)->GetMolecule () != m_Molecule) {
-			if (pAtom0->GetMolecule () != m_Molecule)
-				m_Molecule->AddChild (pAtom0);
-			FindCycles (pAtom0);
-		} else {
-			if (m_Bonds[pAtom0].fwd != NULL) {
-				Bond* pBond0 = m_Bonds[pAtom0].fwd;
-				if (pAtom != pBond0->GetAtom (pAtom0)) {
-					//Cycle found
-					Cycle* pCycle = new Cycle (m_Molecule);
-					pCycle->m_Bonds[pAtom0].rev = pBond;
-					pCycle->m_Bonds[pAtom0].fwd = pBond0;
-					pBond0->AddCycle (pCycle);
-					while (pAtom != pAtom0) {
-						pAtom0 = (Atom*) pBond0->GetAtom (pAtom0);
-						pCycle->m_Bonds[pAtom0].rev = pBond0;
-						pBond0 = m_Bonds[pAtom0].fwd;
-						pCycle->m_Bonds[pAtom0].fwd = pBond0;
-						pBond0->AddCycle (pCycle);
-					}
-					pCycle->Simplify ();	//to reduce size of fused cycles
-					m_Molecule->m_Cycles.push_back (pCycle);
-				}
-			}
+	RingFinder finder;
+	Explore (finder, pAtom, true);
+	finder.Perceive ();
+	AddCycles (finder);
+}
+
+void Chain::FindCycles (Bond* pBond)
+{
+	Atom *pAtom0 = (Atom*) pBond->GetAtom (0), *pAtom1 = (Atom*) pBond->GetAtom (1);
+	RingFinder finder;
+	// if the bond has been removed, its atoms might now be disconnected
+	Explore (finder, pAtom0, false);
+	Explore (finder, pAtom1, false);
+	finder.Restrict (pAtom0);
+	finder.Restrict (pAtom1);
+	finder.Perceive ();
+	// remove the cycles of the ring systems which have been searched again
+	list < Cycle * >::iterator i = m_Molecule->m_Cycles.begin (), end = m_Molecule->m_Cycles.end ();
+	map < Atom *, ChainElt >::iterator j, jend;
+	while (i != end) {
+		Cycle *pCycle = *i;
+		jend = pCycle->m_Bonds.end ();
+		for (j = pCycle->m_Bonds.begin (); j != jend; j++)
+			if ((*j).second.fwd == pBond || finder.IsPerceived ((*j).second.fwd))
+				break;
+		if (j == jend) {
+			i++;
+			continue;
 		}
-		pBond = (Bond*) pAtom->GetNextBond (i);
+		for (j = pCycle->m_Bonds.begin (); j != jend; j++)
+			(*j).second.fwd->RemoveCycle (pCycle);
+		delete pCycle;
+		i = m_Molecule->m_Cycles.erase (i);
 	}
-	m_Bonds.erase (pAtom);
+	AddCycles (finder);
 }
 
 void Chain::Reverse ()
@@ -34,6 +34,7 @@ namespace gcu {
 class Atom;
 class Bond;
 class Molecule;
+class RingFinder;
 
 /*!\struct ChainElt gcu/chain.h
 This structure stores the two bonds of sharing one atom in a chain. One
@@ -96,20 +97,18 @@ The destructor.
 /*!
 @param pAtom an atom.
 
-Searches all cycles in a molecule starting from Atom pAtom. Found cycles are
-added to the molecule cycles list.
+Searches all cycles in a molecule starting from Atom pAtom. All atoms and
+bonds connected to \a pAtom are added to the molecule, and the smallest set
+of smallest rings is added to the molecule cycles list.
 */
 	void FindCycles (Atom* pAtom);
 /*!
-@param pAtom an atom.
-@param pBond a bond.
+@param pBond a bond which has just been added to or removed from the molecule.
 
-Searches for a cycle containing the atom pAtom and the bond pBond. pAtom must
-be one of the ends of pBond. If a cycle is found, it is added to the molecule
-cycles list.
-@return true on success, false otherwise.
+Searches again the cycles of the ring systems including the atoms of
+\a pBond, the other cycles of the molecule being kept.
 */
-	bool FindCycle (Atom* pAtom, Bond* pBond);
+	void FindCycles (Bond* pBond);
 /*!
 @param pAtom1 an atom in the source chain.
 @param pAtom2 an atom in the source chain.
@@ -198,6 +197,10 @@ found or at the chain end.
 */
 	unsigned BuildLength (unsigned *cycle_size = NULL, unsigned *cycle_pos = NULL);
 
+private:
+	void Explore (RingFinder &finder, Atom* pAtom, bool add);
+	void AddCycles (RingFinder &finder);
+
 protected:
 /*!
 	 The gcu::ChainElt elements in the chain indexed by their common atom.
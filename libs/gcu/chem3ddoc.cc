@@ -28,6 +28,8 @@
 #include "application.h"
 #include "bond.h"
 #include "cylinder.h"
+#include "geometry-cache.h"
+#include "glbatch.h"
 #include "glview.h"
 #include "loader.h"
 #include "objprops.h"
@@ -458,7 +460,7 @@ void Chem3dDoc::Draw (Matrix const &m) const
 	map<Atom const *, Vector> atomPos;
 	const double* color;
 	Vector v, normal (0., 0., 1.);
-	Sphere sp (10);
+	GeometryCache cache;
 	GcuAtomicRadius rad;
 	rad.type = GCU_VAN_DER_WAALS;
 	rad.charge = 0;
@@ -473,6 +475,14 @@ void Chem3dDoc::Draw (Matrix const &m) const
 		float light_ambient[] = {.0, .0, .0, 1.0};
 		glLightfv (GL_LIGHT0, GL_AMBIENT, light_ambient);
 	}
+	if (GetBatchRendering () && m_Display3D != WIREFRAME) {
+		if (!m_Batch->IsValid (cache)) {
+			m_Batch->SetProjection (cache);
+			BuildBatch ();
+		}
+		m_Batch->Draw (m);
+		return;
+	}
 	while (atom) {
 		atomPos[atom] = v = m.glmult (atom->GetVector ());
 		Z = atom->GetZ ();
@@ -491,20 +501,19 @@ void Chem3dDoc::Draw (Matrix const &m) const
 			color = gcu_element_get_default_color (Z);
 			if (m_Display3D != WIREFRAME) {
 				glColor3d (color[0], color[1], color[2]);
-				sp.draw (v, R);
+				cache.GetSphere (v, R).draw (v, R);
 			}
 		}
 		atom = m_Mol->GetNextAtom (i);
 	}
 	if (m_Display3D != SPACEFILL) {
-		Cylinder cyl (10);
 		std::list <Bond *>::const_iterator j;
 		Bond const *bond = m_Mol->GetFirstBond (j);
 		Vector v, v0, v1;
 		double R1;
 		unsigned int Z1;
 		if (m_Display3D == WIREFRAME)
-			sp.draw (v, 0.); // weird, this initializes something needed to see colors but what?
+			GeometryCache::GetSphere (10).draw (v, 0.); // weird, this initializes something needed to see colors but what?
 		else
 			glEnable (GL_NORMALIZE);
 		while (bond) {
@@ -537,10 +546,10 @@ void Chem3dDoc::Draw (Matrix const &m) const
 				glVertex3d (v0.GetX (), v0.GetY (), v0.GetZ ());
 				glEnd ();
 			} else if (m_Display3D == BALL_AND_STICK && bond->GetOrder () > 1)
-				cyl.drawMulti (v, v0, ((bond->GetOrder () > 2)? 7.: 10.),
+				cache.GetCylinder (v, v0, 12.).drawMulti (v, v0, ((bond->GetOrder () > 2)? 7.: 10.),
 							   static_cast <int> (bond->GetOrder ()), 15., normal);
 			else
-				cyl.draw (v, v0, 12.);
+				cache.GetCylinder (v, v0, 12.).draw (v, v0, 12.);
 			color = gcu_element_get_default_color (Z1);
 			glColor3d (color[0], color[1], color[2]);
 			if (m_Display3D == WIREFRAME) {
@@ -549,23 +558,93 @@ void Chem3dDoc::Draw (Matrix const &m) const
 				glVertex3d (v1.GetX (), v1.GetY (), v1.GetZ ());
 				glEnd ();
 			} else if (m_Display3D == BALL_AND_STICK && bond->GetOrder () > 1)
-				cyl.drawMulti (v0, v1, ((bond->GetOrder () > 2)? 7.: 10.),
+				cache.GetCylinder (v0, v1, 12.).drawMulti (v0, v1, ((bond->GetOrder () > 2)? 7.: 10.),
 							   static_cast <int> (bond->GetOrder ()), 15., normal);
 			else
-				cyl.draw (v0, v1, 12.);
+				cache.GetCylinder (v0, v1, 12.).draw (v0, v1, 12.);
 			bond = m_Mol->GetNextBond (j);
 		}
 	}
 }
 
+void Chem3dDoc::BuildBatch () const
+{
+	std::list <Atom *>::const_iterator i;
+	std::list <Bond *>::const_iterator j;
+	Atom const *atom;
+	Bond const *bond;
+	unsigned int Z, Z1;
+	double R, R1;
+	const double* color;
+	Vector v, v0, v1, normal (0., 0., 1.);
+	GcuAtomicRadius rad;
+	rad.type = GCU_VAN_DER_WAALS;
+	rad.charge = 0;
+	rad.cn = -1;
+	rad.spin = GCU_N_A_SPIN;
+	rad.scale = NULL;
+	m_Batch->Clear ();
+	m_Batch->Reserve (m_Mol->GetAtomsNumber (), (m_Display3D == SPACEFILL)? 0: 2 * m_Mol->GetBondsNumber ());
+	for (atom = m_Mol->GetFirstAtom (i); atom; atom = m_Mol->GetNextAtom (i)) {
+		Z = atom->GetZ ();
+		if (Z == 0)
+			continue;
+		if (m_Display3D == CYLINDERS)
+			R = 12.;
+		else {
+			rad.Z = Z;
+			Element::GetElement (Z)->GetRadius (&rad);
+			R = rad.value.value;
+			if (m_Display3D == BALL_AND_STICK)
+				R *= 0.2;
+		}
+		color = gcu_element_get_default_color (Z);
+		m_Batch->AddSphere (atom->GetVector (), R, color[0], color[1], color[2]);
+	}
+	if (m_Display3D == SPACEFILL)
+		return;
+	for (bond = m_Mol->GetFirstBond (j); bond; bond = m_Mol->GetNextBond (j)) {
+		atom = bond->GetAtom (0);
+		Z = atom->GetZ ();
+		v = atom->GetVector ();
+		atom = bond->GetAtom (1);
+		Z1 = atom->GetZ ();
+		if (Z == 0 || Z1 == 0)
+			continue;
+		v1 = atom->GetVector ();
+		rad.Z = Z;
+		Element::GetElement (Z)->GetRadius (&rad);
+		R = rad.value.value;
+		rad.Z = Z1;
+		Element::GetElement (Z1)->GetRadius (&rad);
+		R1 = rad.value.value;
+		v0 = v + (v1 - v) * (R / (R + R1));
+		if (m_Display3D == BALL_AND_STICK && bond->GetOrder () > 1) {
+			double r = (bond->GetOrder () > 2)? 7.: 10.;
+			int order = static_cast <int> (bond->GetOrder ());
+			color = gcu_element_get_default_color (Z);
+			m_Batch->AddCylinders (v, v0, r, order, 15., normal, color[0], color[1], color[2]);
+			color = gcu_element_get_default_color (Z1);
+			m_Batch->AddCylinders (v0, v1, r, order, 15., normal, color[0], color[1], color[2]);
+		} else {
+			color = gcu_element_get_default_color (Z);
+			m_Batch->AddCylinder (v, v0, 12., color[0], color[1], color[2]);
+			color = gcu_element_get_default_color (Z1);
+			m_Batch->AddCylinder (v0, v1, 12., color[0], color[1], color[2]);
+		}
+	}
+}
+
 void Chem3dDoc::Clear ()
 {
 	Object::Clear ();
 	m_Mol = NULL;
+	m_Batch->Clear ();
 }
 
 void Chem3dDoc::ChangedDisplay3D ()
 {
+	m_Batch->Clear ();
 	if (!m_Mol)
 		return;
 	std::list <Atom *>::const_iterator i;
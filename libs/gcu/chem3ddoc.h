@@ -164,6 +164,9 @@ GCU_PROP_EX (Display3DMode, Display3D)
 */
 GCU_RO_PROP (Molecule *, Mol)
 
+private:
+	void BuildBatch () const;
+
 private:
 	/* cell parameters to support molecule loaded from a crystal structure */
 	double m_a, m_b, m_c, m_alpha, m_beta, m_gamma;
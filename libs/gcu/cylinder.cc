@@ -145,6 +145,12 @@ void Cylinder::initialize()
 	d->isValid = true;
 }
 
+void Cylinder::detach ()
+{
+	d->displayList = 0;
+	d->isValid = false;
+}
+
 void Cylinder::draw (const Vector &end1, const Vector &end2, double radius) const
 {
 	// the "axis vector" of the cylinder
@@ -92,6 +92,9 @@ namespace gcu {
       void drawMulti (const Vector &end1, const Vector &end2,
           double radius, int order, double shift,
           const Vector &planeNormalVector) const;
+      /** forgets the display list without deleting it. This is used
+       * when the GL context owning the list has been destroyed. */
+      void detach ();
 
     private:
       CylinderPrivate * const d;
@@ -0,0 +1,51 @@
+// -*- C++ -*-
+
+/*
+ * Gnome Chemistry Utils
+ * gcu/dbcompile.cc
+ *
+ * Copyright (C) 2026 Jean Bréfort <jean.brefort@normalesup.org>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301
+ * USA
+ */
+
+#include "config.h"
+#include "dbimage.h"
+#include <goffice/goffice.h>
+#include <cstdio>
+
+/*!\file
+Builds the binary database image from the XML databases. This program is run
+when the package is built and is not installed.
+*/
+
+int main (int argc, char *argv[])
+{
+	if (argc != 3) {
+		fprintf (stderr, "Usage: %s DATADIR OUTPUT\n", argv[0]);
+		return 1;
+	}
+	libgoffice_init ();
+	GError *error = NULL;
+	bool result = gcu::DatabaseImage::Compile (argv[1], argv[2], &error);
+	if (!result) {
+		fprintf (stderr, "Could not write %s: %s\n", argv[2], (error)? error->message: "unknown error");
+		if (error)
+			g_error_free (error);
+	}
+	libgoffice_shutdown ();
+	return (result)? 0: 1;
+}
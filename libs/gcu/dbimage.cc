@@ -0,0 +1,244 @@
+// -*- C++ -*-
+
+/*
+ * Gnome Chemistry Utils
+ * gcu/dbimage.cc
+ *
+ * Copyright (C) 2026 Jean Bréfort <jean.brefort@normalesup.org>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301
+ * USA
+ */
+
+#include "config.h"
+#include "dbimage.h"
+#include "element.h"
+#include "spacegroup.h"
+#include <glib/gstdio.h>
+#include <cstring>
+
+#define DB_IMAGE_MAGIC "GCUDBIMG"
+#define DB_BYTE_ORDER 0x01020304
+#define DB_BODR_FILE BODR_PKGDATADIR"/elements.xml"
+
+namespace gcu
+{
+
+static guint32 const record_sizes[DB_SECTION_MAX] = {
+	1,
+	sizeof (DbElement),
+	sizeof (DbName),
+	sizeof (DbRadius),
+	sizeof (DbValue),
+	sizeof (DbValue),
+	sizeof (DbValue),
+	sizeof (DbIsotope),
+	sizeof (DbProperty),
+	sizeof (DbSpaceGroup),
+	sizeof (DbSpaceGroupName),
+	sizeof (DbOperation)
+};
+
+static DatabaseImage image;
+static bool image_loaded = false, image_disabled = false, compiling = false;
+static std::string data_dir = PKGDATADIR;
+
+////////////////////////////////////////////////////////////////////////////////
+// DatabaseImage implementation
+
+DatabaseImage::DatabaseImage ():
+	m_File (NULL),
+	m_Data (NULL),
+	m_Header (NULL),
+	m_BODR (false)
+{
+}
+
+DatabaseImage::~DatabaseImage ()
+{
+	if (m_File)
+		g_mapped_file_unref (m_File);
+}
+
+bool DatabaseImage::Load (char const *filename)
+{
+	g_return_val_if_fail (m_File == NULL, false);
+	m_File = g_mapped_file_new (filename, false, NULL);
+	if (!m_File)
+		return false;
+	gsize size = g_mapped_file_get_length (m_File);
+	char const *data = g_mapped_file_get_contents (m_File);
+	DbHeader const *header = reinterpret_cast <DbHeader const *> (data);
+	bool valid = size >= sizeof (DbHeader) && !memcmp (header->magic, DB_IMAGE_MAGIC, 8) &&
+	             header->version == GCU_DB_IMAGE_VERSION && header->byte_order == DB_BYTE_ORDER &&
+	             header->size == size;
+	for (unsigned i = 0; valid && i < DB_SECTION_MAX; i++) {
+		DbRange const &section = header->sections[i];
+		valid = header->record_sizes[i] == record_sizes[i] && section.first % 8 == 0 &&
+		        section.first >= sizeof (DbHeader) && section.first <= size &&
+		        section.count <= (size - section.first) / record_sizes[i];
+	}
+	// the last string must be null terminated
+	if (valid) {
+		DbRange const &strings = header->sections[DB_SECTION_STRINGS];
+		valid = strings.count > 0 && data[strings.first + strings.count - 1] == 0;
+	}
+	if (!valid) {
+		g_warning ("Invalid database image %s.", filename);
+		g_mapped_file_unref (m_File);
+		m_File = NULL;
+		return false;
+	}
+	m_Data = data;
+	m_Header = header;
+	// the BODR properties are only used if the BODR file did not change
+	GStatBuf st;
+	if (g_stat (DB_BODR_FILE, &st))
+		m_BODR = header->bodr_size == 0;
+	else
+		m_BODR = header->bodr_size == static_cast < guint32 > (st.st_size) &&
+		         header->bodr_mtime == static_cast < gint64 > (st.st_mtime);
+	return true;
+}
+
+char const *DatabaseImage::GetString (guint32 offset) const
+{
+	return (offset < m_Header->sections[DB_SECTION_STRINGS].count)?
+		m_Data + m_Header->sections[DB_SECTION_STRINGS].first + offset: NULL;
+}
+
+DatabaseImage const *DatabaseImage::Get ()
+{
+	if (!image_loaded && !image_disabled) {
+		image_loaded = true;
+		if (!image.Load (GetDataFile (GCU_DB_IMAGE_FILE).c_str ()))
+			image_disabled = true;
+	}
+	return (image_disabled)? NULL: &image;
+}
+
+void DatabaseImage::Disable ()
+{
+	image_disabled = true;
+}
+
+bool DatabaseImage::Use (char const *filename)
+{
+	g_return_val_if_fail (!image_loaded && !image_disabled, false);
+	image_loaded = true;
+	if (!image.Load (filename))
+		image_disabled = true;
+	return !image_disabled;
+}
+
+std::string DatabaseImage::GetDataFile (char const *name)
+{
+	return data_dir + G_DIR_SEPARATOR_S + name;
+}
+
+bool DatabaseImage::Compile (char const *datadir, char const *filename, GError **error)
+{
+	image_disabled = true;
+	compiling = true;
+	data_dir = datadir;
+	Element::LoadAllData ();
+	DatabaseImageWriter writer;
+	writer.SetBODRStamp (DB_BODR_FILE);
+	Element::SaveImage (writer);
+	SpaceGroup::SaveImage (writer);
+	compiling = false;
+	return writer.Save (filename, error);
+}
+
+bool DatabaseImage::IsCompiling ()
+{
+	return compiling;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// DatabaseImageWriter implementation
+
+DatabaseImageWriter::DatabaseImageWriter ():
+	m_BODRSize (0),
+	m_BODRMTime (0)
+{
+	// offset 0 is the empty string, this also ensures the strings section is not empty
+	AddString ("");
+}
+
+DatabaseImageWriter::~DatabaseImageWriter ()
+{
+}
+
+guint32 DatabaseImageWriter::AddString (char const *str)
+{
+	if (!str)
+		return DB_NO_STRING;
+	std::map <std::string, guint32>::iterator i = m_Strings.find (str);
+	if (i != m_Strings.end ())
+		return (*i).second;
+	std::vector <char> &strings = m_Sections[DB_SECTION_STRINGS];
+	guint32 offset = strings.size ();
+	strings.insert (strings.end (), str, str + strlen (str) + 1);
+	m_Strings[str] = offset;
+	return offset;
+}
+
+guint32 DatabaseImageWriter::GetCount (DbSection section) const
+{
+	return m_Sections[section].size () / record_sizes[section];
+}
+
+void DatabaseImageWriter::SetBODRStamp (char const *filename)
+{
+	GStatBuf st;
+	if (g_stat (filename, &st)) {
+		m_BODRSize = 0;
+		m_BODRMTime = 0;
+	} else {
+		m_BODRSize = st.st_size;
+		m_BODRMTime = st.st_mtime;
+	}
+}
+
+bool DatabaseImageWriter::Save (char const *filename, GError **error) const
+{
+	DbHeader header;
+	memset (&header, 0, sizeof (DbHeader));
+	memcpy (header.magic, DB_IMAGE_MAGIC, 8);
+	header.version = GCU_DB_IMAGE_VERSION;
+	header.byte_order = DB_BYTE_ORDER;
+	header.bodr_size = m_BODRSize;
+	header.bodr_mtime = m_BODRMTime;
+	guint32 offset = sizeof (DbHeader);
+	unsigned i;
+	for (i = 0; i < DB_SECTION_MAX; i++) {
+		// align all sections on 8 bytes
+		offset = (offset + 7) & ~7;
+		header.record_sizes[i] = record_sizes[i];
+		header.sections[i].first = offset;
+		header.sections[i].count = GetCount (static_cast < DbSection > (i));
+		offset += m_Sections[i].size ();
+	}
+	header.size = offset;
+	std::vector <char> data (offset, 0);
+	memcpy (&data[0], &header, sizeof (DbHeader));
+	for (i = 0; i < DB_SECTION_MAX; i++)
+		if (!m_Sections[i].empty ())
+			memcpy (&data[header.sections[i].first], &m_Sections[i][0], m_Sections[i].size ());
+	return g_file_set_contents (filename, &data[0], data.size (), error);
+}
+
+}	//	namespace gcu
@@ -0,0 +1,673 @@
+// -*- C++ -*-
+
+/*
+ * Gnome Chemistry Utils
+ * gcu/dbimage.h
+ *
+ * Copyright (C) 2026 Jean Bréfort <jean.brefort@normalesup.org>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301
+ * USA
+ */
+
+#ifndef GCU_DBIMAGE_H
+#define GCU_DBIMAGE_H
+
+#include <glib.h>
+#include <map>
+#include <string>
+#include <vector>
+
+/*!\file
+The binary image of the elements, isotopes and space groups databases. The
+image is built from the XML files when the package is built, and memory mapped
+at run time, so that programs do not need to parse the XML files on startup.
+The records are only read when the corresponding objects are needed.
+
+The image starts with a DbHeader, followed by sections of fixed size records.
+Strings are stored once in the strings section, and records reference them
+using their offset in that section. The image uses the native byte order and
+alignment, and is rejected if they do not match those of the reader.
+*/
+
+/*!\def GCU_DB_IMAGE_VERSION
+The version of the image format. Images with another version are ignored.
+*/
+#define GCU_DB_IMAGE_VERSION 1
+
+/*!\def GCU_DB_IMAGE_FILE
+The name of the image file, installed with the XML databases.
+*/
+#define GCU_DB_IMAGE_FILE "gcu-data.bin"
+
+/*!\def DB_NO_STRING
+The string offset used for NULL strings.
+*/
+#define DB_NO_STRING G_MAXUINT32
+
+namespace gcu
+{
+
+/*!\enum DbSection gcu/dbimage.h
+The sections of a database image.
+*/
+typedef enum {
+/*!
+The strings, each one being followed by a null byte.
+*/
+	DB_SECTION_STRINGS,
+/*!
+The elements as DbElement records, ordered by atomic number.
+*/
+	DB_SECTION_ELEMENTS,
+/*!
+The localized element names as DbName records.
+*/
+	DB_SECTION_NAMES,
+/*!
+The atomic radii as DbRadius records.
+*/
+	DB_SECTION_RADII,
+/*!
+The electronegativities as DbValue records, the text being the scale.
+*/
+	DB_SECTION_ELECTRONEGATIVITIES,
+/*!
+The ionization energies as DbValue records, the text being the unit.
+*/
+	DB_SECTION_IONIZATIONS,
+/*!
+The electron affinities as DbValue records, the text being the unit.
+*/
+	DB_SECTION_AFFINITIES,
+/*!
+The isotopes as DbIsotope records.
+*/
+	DB_SECTION_ISOTOPES,
+/*!
+The Blue Obelisk Data Repository properties as DbProperty records.
+*/
+	DB_SECTION_PROPERTIES,
+/*!
+The space groups as DbSpaceGroup records.
+*/
+	DB_SECTION_SPACE_GROUPS,
+/*!
+The names used to find space groups as DbSpaceGroupName records.
+*/
+	DB_SECTION_SPACE_GROUP_NAMES,
+/*!
+The space groups operations as DbOperation records.
+*/
+	DB_SECTION_OPERATIONS,
+/*!
+The number of sections.
+*/
+	DB_SECTION_MAX
+} DbSection;
+
+/*!\enum DbData gcu/dbimage.h
+The element data sets, which are loaded independently.
+*/
+typedef enum {
+/*!
+The Blue Obelisk Data Repository properties, see Element::LoadBODR().
+*/
+	DB_DATA_BODR = 1 << 0,
+/*!
+The atomic radii, see Element::LoadRadii().
+*/
+	DB_DATA_RADII = 1 << 1,
+/*!
+The electronic properties, see Element::LoadElectronicProps().
+*/
+	DB_DATA_ELECTRONIC = 1 << 2,
+/*!
+The isotopes, see Element::LoadIsotopes().
+*/
+	DB_DATA_ISOTOPES = 1 << 3
+} DbData;
+
+/*!\enum DbPropertyType gcu/dbimage.h
+The types of the DbProperty records.
+*/
+typedef enum {
+/*!
+An adimensional value.
+*/
+	DB_PROPERTY_SIMPLE,
+/*!
+A value with a unit.
+*/
+	DB_PROPERTY_DIMENSIONAL,
+/*!
+A string.
+*/
+	DB_PROPERTY_STRING,
+/*!
+An integer.
+*/
+	DB_PROPERTY_INTEGER
+} DbPropertyType;
+
+/*!
+A range of records in a section.
+*/
+typedef struct {
+/*!
+The first record, or the offset of the section from the start of the image.
+*/
+	guint32 first;
+/*!
+The number of records.
+*/
+	guint32 count;
+} DbRange;
+
+/*!
+The image header.
+*/
+typedef struct {
+/*!
+"GCUDBIMG"
+*/
+	char magic[8];
+/*!
+GCU_DB_IMAGE_VERSION.
+*/
+	guint32 version;
+/*!
+0x01020304 in the byte order of the writer.
+*/
+	guint32 byte_order;
+/*!
+The image size in bytes.
+*/
+	guint32 size;
+/*!
+The size of the Blue Obelisk Data Repository elements file, 0 if it was
+missing when the image was built.
+*/
+	guint32 bodr_size;
+/*!
+The modification time of the Blue Obelisk Data Repository elements file. The
+properties are not used if the file changed since the image was built.
+*/
+	gint64 bodr_mtime;
+/*!
+The size of the records of each section.
+*/
+	guint32 record_sizes[DB_SECTION_MAX];
+/*!
+The offset and the number of records of each section.
+*/
+	DbRange sections[DB_SECTION_MAX];
+} DbHeader;
+
+/*!
+An element.
+*/
+typedef struct {
+/*!
+The default color.
+*/
+	double color[3];
+/*!
+The atomic number.
+*/
+	guint32 Z;
+/*!
+The symbol.
+*/
+	char symbol[4];
+/*!
+The maximum number of bonds.
+*/
+	gint32 max_bonds;
+/*!
+The default valence, -1 if none.
+*/
+	gint32 valence;
+/*!
+The electronic configuration.
+*/
+	guint32 config;
+/*!
+The data sets which end their lists with a NULL pointer, see DbData.
+*/
+	guint32 terminated;
+/*!
+Whether the element has at least one stable isotope.
+*/
+	guint32 stable;
+/*!
+The lowest nucleons number of the natural isotopic pattern, 0 if none.
+*/
+	gint32 min_A;
+/*!
+The highest nucleons number of the natural isotopic pattern.
+*/
+	gint32 max_A;
+/*!
+Unused, for alignment.
+*/
+	guint32 reserved;
+/*!
+The localized names.
+*/
+	DbRange names;
+/*!
+The atomic radii.
+*/
+	DbRange radii;
+/*!
+The electronegativities.
+*/
+	DbRange electronegativities;
+/*!
+The ionization energies.
+*/
+	DbRange ionizations;
+/*!
+The electron affinities.
+*/
+	DbRange affinities;
+/*!
+The isotopes.
+*/
+	DbRange isotopes;
+/*!
+The Blue Obelisk Data Repository properties.
+*/
+	DbRange properties;
+} DbElement;
+
+/*!
+A localized element name.
+*/
+typedef struct {
+/*!
+The language code, DB_NO_STRING for the untranslated name.
+*/
+	guint32 lang;
+/*!
+The name.
+*/
+	guint32 name;
+} DbName;
+
+/*!
+An atomic radius, the unit is always pm.
+*/
+typedef struct {
+/*!
+The value.
+*/
+	double value;
+/*!
+The precision.
+*/
+	gint32 prec;
+/*!
+The standard error.
+*/
+	gint32 delta;
+/*!
+The radius type.
+*/
+	gint32 type;
+/*!
+The charge.
+*/
+	gint32 charge;
+/*!
+The coordination number.
+*/
+	gint32 cn;
+/*!
+The spin state.
+*/
+	gint32 spin;
+/*!
+The scale.
+*/
+	guint32 scale;
+/*!
+Unused, for alignment.
+*/
+	guint32 reserved;
+} DbRadius;
+
+/*!
+A value with a scale or a unit.
+*/
+typedef struct {
+/*!
+The value.
+*/
+	double value;
+/*!
+The precision.
+*/
+	gint32 prec;
+/*!
+The standard error.
+*/
+	gint32 delta;
+/*!
+The scale or the unit.
+*/
+	guint32 text;
+/*!
+Unused, for alignment.
+*/
+	guint32 reserved;
+} DbValue;
+
+/*!
+An isotope.
+*/
+typedef struct {
+/*!
+The mass.
+*/
+	double mass;
+/*!
+The terrestrial abundance.
+*/
+	double abundance;
+/*!
+The precision of the mass.
+*/
+	gint32 mass_prec;
+/*!
+The standard error of the mass.
+*/
+	gint32 mass_delta;
+/*!
+The precision of the abundance.
+*/
+	gint32 abundance_prec;
+/*!
+The standard error of the abundance.
+*/
+	gint32 abundance_delta;
+/*!
+The nucleons number.
+*/
+	guint32 A;
+/*!
+Unused, for alignment.
+*/
+	guint32 reserved;
+} DbIsotope;
+
+/*!
+A Blue Obelisk Data Repository property.
+*/
+typedef struct {
+/*!
+The value of numeric properties.
+*/
+	double value;
+/*!
+The precision.
+*/
+	gint32 prec;
+/*!
+The standard error.
+*/
+	gint32 delta;
+/*!
+The property name.
+*/
+	guint32 name;
+/*!
+The DbPropertyType.
+*/
+	guint32 type;
+/*!
+The unit of dimensional values or the string.
+*/
+	guint32 text;
+/*!
+The value of integer properties.
+*/
+	gint32 integer;
+} DbProperty;
+
+/*!
+A space group.
+*/
+typedef struct {
+/*!
+The space group number.
+*/
+	guint32 id;
+/*!
+The coordinate alternative.
+*/
+	guint32 alternative;
+/*!
+The Hermann-Mauguin name.
+*/
+	guint32 hm;
+/*!
+The Hall name.
+*/
+	guint32 hall;
+/*!
+The operations.
+*/
+	DbRange operations;
+} DbSpaceGroup;
+
+/*!
+A name used to find a space group.
+*/
+typedef struct {
+/*!
+The name.
+*/
+	guint32 name;
+/*!
+The index of the space group.
+*/
+	guint32 group;
+} DbSpaceGroupName;
+
+/*!
+A space group operation, as a 3x4 matrix, the last column being the
+translation.
+*/
+typedef struct {
+/*!
+The matrix, row by row.
+*/
+	double values[12];
+} DbOperation;
+
+/*!\class DatabaseImage gcu/dbimage.h
+A memory mapped database image. The image used by the library is opened
+the first time it is needed and is kept until the program exits.
+*/
+class DatabaseImage
+{
+public:
+/*!
+The constructor.
+*/
+	DatabaseImage ();
+/*!
+The destructor.
+*/
+	~DatabaseImage ();
+
+/*!
+@param filename the image file.
+
+Maps the image and checks its header.
+@return true if the image can be used.
+*/
+	bool Load (char const *filename);
+/*!
+@param section a section.
+@param count where to store the number of records.
+@return the records of the section.
+*/
+	template <class T> T const *GetRecords (DbSection section, unsigned &count) const
+	{
+		count = m_Header->sections[section].count;
+		return reinterpret_cast <T const *> (m_Data + m_Header->sections[section].first);
+	}
+/*!
+@param section a section.
+@param range a range of records in the section.
+@return the first record in the range, or NULL if the range is empty or
+invalid.
+*/
+	template <class T> T const *GetRecords (DbSection section, DbRange const &range) const
+	{
+		if (range.count == 0 || range.first > m_Header->sections[section].count ||
+		    range.count > m_Header->sections[section].count - range.first)
+			return NULL;
+		return reinterpret_cast <T const *> (m_Data + m_Header->sections[section].first) + range.first;
+	}
+/*!
+@param offset an offset in the strings section.
+@return the string or NULL.
+*/
+	char const *GetString (guint32 offset) const;
+/*!
+@return whether the image properties from the Blue Obelisk Data Repository are
+up to date.
+*/
+	bool HasBODR () const {return m_BODR;}
+
+/*!
+@return the image used by the library, or NULL if it is missing, invalid, or
+disabled.
+*/
+	static DatabaseImage const *Get ();
+/*!
+Disables the image, so that the XML files are used. This must be called before
+any database is loaded.
+*/
+	static void Disable ();
+/*!
+@param filename an image file.
+
+Uses \a filename instead of the installed image. This must be called before
+any database is loaded.
+@return true if the image is valid, otherwise the XML files are used.
+*/
+	static bool Use (char const *filename);
+/*!
+@param name the name of a database file.
+@return the path of the database file.
+*/
+	static std::string GetDataFile (char const *name);
+/*!
+@param datadir the directory containing the XML databases.
+@param filename the image file to write.
+@param error where to store the error if any.
+
+Loads all databases from the XML files in \a datadir, and writes them to
+\a filename. The image is disabled for the rest of the process.
+@return true on success.
+*/
+	static bool Compile (char const *datadir, char const *filename, GError **error);
+/*!
+@return true while Compile() runs, so that the loaders keep the data which
+are only needed to write the image.
+*/
+	static bool IsCompiling ();
+
+private:
+	GMappedFile *m_File;
+	char const *m_Data;
+	DbHeader const *m_Header;
+	bool m_BODR;
+};
+
+/*!\class DatabaseImageWriter gcu/dbimage.h
+Builds a database image.
+*/
+class DatabaseImageWriter
+{
+public:
+/*!
+The constructor.
+*/
+	DatabaseImageWriter ();
+/*!
+The destructor.
+*/
+	~DatabaseImageWriter ();
+
+/*!
+@param str a string or NULL.
+
+Adds a string to the strings section, unless it is already there.
+@return the offset of the string.
+*/
+	guint32 AddString (char const *str);
+/*!
+@param str a string.
+
+Adds a string to the strings section, unless it is already there.
+@return the offset of the string.
+*/
+	guint32 AddString (std::string const &str) {return AddString (str.c_str ());}
+/*!
+@param section a section.
+@param record the record to add.
+@return the index of the new record in the section.
+*/
+	template <class T> guint32 AddRecord (DbSection section, T const &record)
+	{
+		guint32 index = GetCount (section);
+		char const *data = reinterpret_cast <char const *> (&record);
+		m_Sections[section].insert (m_Sections[section].end (), data, data + sizeof (T));
+		return index;
+	}
+/*!
+@param section a section.
+@return the number of records in the section.
+*/
+	guint32 GetCount (DbSection section) const;
+/*!
+@param filename the Blue Obelisk Data Repository elements file.
+
+Stores the size and modification time of \a filename in the header.
+*/
+	void SetBODRStamp (char const *filename);
+/*!
+@param filename the image file.
+@param error where to store the error if any.
+@return true on success.
+*/
+	bool Save (char const *filename, GError **error) const;
+
+private:
+	std::vector <char> m_Sections[DB_SECTION_MAX];
+	std::map <std::string, guint32> m_Strings;
+	guint32 m_BODRSize;
+	gint64 m_BODRMTime;
+};
+
+}	//	namespace gcu
+
+#endif	//	GCU_DBIMAGE_H
@@ -25,6 +25,7 @@
 #include "config.h"
 #include "document.h"
 #include "application.h"
+#include "molecule.h"
 #include "residue.h"
 #include "dialog.h"
 #include <glib/gi18n-lib.h>
@@ -68,8 +69,13 @@ char* Document::GetNewId (char const *id, bool Cache)
 	if (s.size ())
 		j = atoi (s.c_str ());
 	char* key = g_strdup (buf);
+	// numbers below the hint have already been used, no need to test them again
+	unsigned &next = m_NextIds[key];
+	if (static_cast < unsigned > (j) < next)
+		j = next;
 	while (snprintf (buf + i, 16, "%d", j), GetDescendant (buf) != NULL)
 		j++;
+	next = j + 1;
 	Id = g_strdup_printf ("%d", j);
 	Object *obj = GetDescendant (id);
 	if (obj && (k > 1 || m_NewObjects.find (obj) == m_NewObjects.end ()))
@@ -178,6 +184,68 @@ std::string Document::Name ()
 	return _("Document");
 }
 
+static void collect_molecules (Object *obj, std::vector < Molecule * > &molecules)
+{
+	std::map < std::string, Object * >::iterator i;
+	for (Object *child = obj->GetFirstChild (i); child; child = obj->GetNextChild (i))
+		if (child->GetType () == MoleculeType)
+			molecules.push_back (static_cast < Molecule * > (child));
+		else
+			collect_molecules (child, molecules);
+}
+
+void Document::GroupIdenticalMolecules (std::vector < std::vector < Molecule * > > &groups)
+{
+	std::vector < Molecule * > molecules;
+	collect_molecules (this, molecules);
+	Molecule::GroupIdentical (molecules, groups);
+}
+
+void Document::IndexObject (Object *obj)
+{
+	if (!obj->GetId ())
+		return;
+	std::pair < std::unordered_map < std::string, Object * >::iterator, bool > res = m_Ids.insert (std::pair < std::string, Object * > (obj->GetId (), obj));
+	if (res.second || (*res.first).second == obj)
+		return;
+	// keep the duplicate, it will take the entry if the indexed object goes away
+	std::pair < std::multimap < std::string, Object * >::iterator, std::multimap < std::string, Object * >::iterator > range = m_DuplicateIds.equal_range (obj->GetId ());
+	for (std::multimap < std::string, Object * >::iterator i = range.first; i != range.second; i++)
+		if ((*i).second == obj)
+			return;
+	m_DuplicateIds.insert (std::pair < std::string, Object * > (obj->GetId (), obj));
+}
+
+void Document::UnindexObject (Object *obj)
+{
+	if (!obj->GetId ())
+		return;
+	std::unordered_map < std::string, Object * >::iterator i = m_Ids.find (obj->GetId ());
+	if (i == m_Ids.end ())
+		return;
+	std::pair < std::multimap < std::string, Object * >::iterator, std::multimap < std::string, Object * >::iterator > range = m_DuplicateIds.equal_range (obj->GetId ());
+	if ((*i).second == obj) {
+		if (range.first == range.second)
+			m_Ids.erase (i);
+		else {
+			(*i).second = (*range.first).second;
+			m_DuplicateIds.erase (range.first);
+		}
+		return;
+	}
+	for (std::multimap < std::string, Object * >::iterator j = range.first; j != range.second; j++)
+		if ((*j).second == obj) {
+			m_DuplicateIds.erase (j);
+			break;
+		}
+}
+
+Object *Document::GetIndexedObject (char const *id) const
+{
+	std::unordered_map < std::string, Object * >::const_iterator i = m_Ids.find (id);
+	return (i != m_Ids.end ())? (*i).second: NULL;
+}
+
 std::string& Document::GetTranslatedId (const char* id)
 {
 	static std::string empty_string ("");
@@ -30,8 +30,11 @@
 #include <gcu/dialog-owner.h>
 #include <gcu/macros.h>
 #include <gcu/loader-error.h>
+#include <map>
 #include <string>
 #include <set>
+#include <unordered_map>
+#include <vector>
 
 /*!\file*/
 namespace gcu
@@ -224,6 +227,22 @@ always returns NULL.
 */
 	virtual Window *GetWindow () {return NULL;}
 
+/*!
+@param groups where to store the groups of identical molecules.
+
+Sorts all the molecules in the document, including those inside other
+objects such as reactions, into groups of identical molecules, using
+Molecule::GroupIdentical(). The first molecule of each group might be used as
+the representative of the group.
+*/
+	void GroupIdenticalMolecules (std::vector < std::vector < Molecule * > > &groups);
+
+/*!
+@return true if several objects in the document share an Id. The Id index is
+not used while this is true.
+*/
+	bool HasDuplicateIds () const {return !m_DuplicateIds.empty ();}
+
 private:
 
 /*!
@@ -233,11 +252,37 @@ private:
 When pasting, objects added to the document might have the same Id as objects already existing. In such cases, the document
 maintains a table to update links using Ids as identifiers. If Cache is set to true GetId adds a new entry in
 the table.
-GetNewId returns the translated id
+GetNewId returns the translated id. As for automatic Ids, the numbers used for a given prefix grow, and
+are not reused once the corresponding object has been removed.
 */
 	char* GetNewId (char const *id, bool Cache = true);
 
+/*!
+@param obj an object which just got an Id inside the document.
+
+Adds \a obj to the Id index used to speed up searches in the document tree.
+*/
+	void IndexObject (Object *obj);
+
+/*!
+@param obj an object leaving the document or changing its Id.
+
+Removes \a obj from the Id index. If other objects were indexed with the same
+Id, one of them takes the entry.
+*/
+	void UnindexObject (Object *obj);
+
+/*!
+@param id the Id to search.
+
+@return the indexed object whose Id is \a id, or NULL.
+*/
+	Object *GetIndexedObject (char const *id) const;
+
 private:
+	std::unordered_map <std::string, Object *> m_Ids; // index of all objects in the document tree
+	std::map <std::string, unsigned> m_NextIds; // first number to try when building a new Id with a given prefix
+	std::multimap <std::string, Object *> m_DuplicateIds; // objects sharing the Id of an indexed object, the index can't be trusted if not empty
 	std::map <std::string, std::string> m_TranslationTable;//used when Ids translations are necessary (on pasting...)
 	std::map <std::string, std::list <PendingTarget> > m_PendingTable;//used to set pointers to objects when loading does not occur in the ideal order
 	std::set<Object*> m_NewObjects;
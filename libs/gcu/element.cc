@@ -22,6 +22,7 @@
 
 #include "config.h"
 #include "element.h"
+#include "dbimage.h"
 #include "xml-utils.h"
 #include <goffice/goffice.h>
 #include <libxml/parser.h>
@@ -60,6 +61,16 @@ static void ReadDimensionalValue (char const *source, GcuDimensionalValue &value
 	value.delta = (*buf == '(')? strtol (buf + 1, NULL, 10): 0;
 }
 
+static char const *GetStaticUnit (char const *unit)
+{
+	if (!unit)
+		return NULL;
+	set<string>::iterator it = units.find (unit);
+	if (it == units.end ())
+		it = units.insert (unit).first;
+	return (*it).c_str ();
+}
+
 namespace gcu
 {
 
@@ -74,32 +85,61 @@ public:
 
 	void AddElement(Element* Elt);
 	void Init ();
+	void AddName (Element *Elt, char const *lang, char const *name);
+	bool HasImage () const {return Image != NULL;}
+	void LoadData (unsigned data);
+	void SaveImage (DatabaseImageWriter &writer);
 
 private:
+	void Load ();
+	Element *LoadElement (unsigned index);
+
 	vector<Element*> Elements;
 	map <string, Element*> EltsMap;
+	map <string, string> Langs;
+	char const *Lang;
+	// when the image is used, elements are only created when first needed,
+	// each one behind its own init-once guard, and found by symbol through a
+	// map filled once
+	DatabaseImage const *Image;
+	vector<unsigned> Records;
+	vector<gsize> Created;
+	map <string, int> Symbols;
+	unsigned LoadedData;
+	// the untranslated names, only kept while compiling the image
+	map <int, vector < pair <string, string> > > RawNames;
 };
 
 EltTable Table;
+// serializes the creation of elements from the image and the loading of data
+// sets into them, lookups of existing elements don't lock
+static GRecMutex TableMutex;
 
-EltTable::EltTable()
+EltTable::EltTable():
+	Lang (NULL),
+	Image (NULL),
+	LoadedData (0)
 {
 }
 
 void EltTable::Init ()
 {
-	static bool inited = false;
-	if (inited)
-		return;
+	static gsize inited = 0;
+	if (g_once_init_enter (&inited)) {
+		Load ();
+		g_once_init_leave (&inited, 1);
+	}
+}
+
+void EltTable::Load ()
+{
 	textdomain (GETTEXT_PACKAGE);
 	bindtextdomain (GETTEXT_PACKAGE, LOCALEDIR);
-	inited = true;
 	xmlDocPtr xml;
 	char* DefaultName;
-	char *lang = getenv ("LANG");
 	char *buf, *num;
 	unsigned char Z;
-	map <string, string> Langs;
+	Lang = getenv ("LANG");
 	Langs["de"] = _("German");
 	Langs["el"] = _("Greek");
 	Langs["es"] = _("Spanisch");
@@ -110,7 +150,25 @@ void EltTable::Init ()
 	Langs["pt_BR"] = _("Brazilian");
 	Langs["ru"] = _("Russian");
 	Langs["zh_TW"] = _("Chinese (TW)");
-	if (!(xml = xmlParseFile (PKGDATADIR"/elements.xml"))) {
+	Image = DatabaseImage::Get ();
+	if (Image) {
+		unsigned i, n;
+		char symbol[5];
+		DbElement const *records = Image->GetRecords <DbElement> (DB_SECTION_ELEMENTS, n);
+		for (i = 0; i < n; i++) {
+			if (records[i].Z >= Elements.size ()) {
+				Elements.resize (records[i].Z + 1, NULL);
+				Records.resize (records[i].Z + 1, n);
+			}
+			Records[records[i].Z] = i;
+			strncpy (symbol, records[i].symbol, 4);
+			symbol[4] = 0;
+			Symbols[symbol] = records[i].Z;
+		}
+		Created.resize (Elements.size (), 0);
+		return;
+	}
+	if (!(xml = xmlParseFile (DatabaseImage::GetDataFile ("elements.xml").c_str ()))) {
 		g_error (_("Can't find and read elements.xml"));
 	}
 	xmlNode* node = xml->children, *child;
@@ -150,17 +208,14 @@ void EltTable::Init ()
 				}
 				if (!strcmp((const char*)child->name, "name")) {
 					buf = (char*) xmlNodeGetLang (child);
-					if ((buf) && (lang)){
-						string Lang = Langs[buf];
-						char *Name = (char*) xmlNodeGetContent (child);
-						if (Lang.length ())
-							Elt->names[Lang] = Name;
-						if (!strncmp (lang, buf, 2))
-							Elt->name = Name;
+					char *Name = (char*) xmlNodeGetContent (child);
+					AddName (Elt, buf, Name);
+					if (buf)
 						xmlFree (Name);
-					} else if (!buf) {
-						DefaultName = (char*) xmlNodeGetContent (child);
-						Elt->names[_("English")] = DefaultName;
+					else {
+						if (DefaultName)
+							xmlFree (DefaultName);
+						DefaultName = Name;
 					}
 					xmlFree (buf);
 				} else if (!strcmp ((const char*) child->name, "color")) {
@@ -191,23 +246,243 @@ void EltTable::Init ()
 	xmlFreeDoc (xml);
 }
 
+void EltTable::AddName (Element *Elt, char const *lang, char const *name)
+{
+	if (DatabaseImage::IsCompiling ())
+		RawNames[Elt->GetZ ()].push_back (pair <string, string> ((lang)? lang: "", name));
+	if (!lang)
+		Elt->names[_("English")] = name;
+	else if (Lang) {
+		string const &Language = Langs[lang];
+		if (Language.length ())
+			Elt->names[Language] = name;
+		if (!strncmp (Lang, lang, 2))
+			Elt->name = name;
+	}
+}
+
+Element *EltTable::LoadElement (unsigned index)
+{
+	unsigned i, n;
+	DbElement const &record = Image->GetRecords <DbElement> (DB_SECTION_ELEMENTS, n)[index];
+	Element *Elt = new Element (record.Z, record.symbol);
+	Elt->m_MaxBonds = record.max_bonds;
+	Elt->m_DefaultValence = record.valence;
+	for (i = 0; i < 3; i++)
+		Elt->m_DefaultColor[i] = record.color[i];
+	DbName const *names = Image->GetRecords <DbName> (DB_SECTION_NAMES, record.names);
+	char const *DefaultName = NULL;
+	for (i = 0; names && i < record.names.count; i++) {
+		char const *name = Image->GetString (names[i].name);
+		if (!name)
+			continue;
+		if (names[i].lang == DB_NO_STRING)
+			DefaultName = name;
+		AddName (Elt, Image->GetString (names[i].lang), name);
+	}
+	if ((Elt->name.length () == 0) && DefaultName) Elt->name = DefaultName;
+	AddElement (Elt);
+	Elt->LoadImage (*Image, index, LoadedData);
+	return Elt;
+}
+
+void EltTable::LoadData (unsigned data)
+{
+	g_rec_mutex_lock (&TableMutex);
+	LoadedData |= data;
+	for (unsigned Z = 0; Z < Elements.size (); Z++)
+		if (Elements[Z])
+			Elements[Z]->LoadImage (*Image, Records[Z], data);
+	g_rec_mutex_unlock (&TableMutex);
+}
+
+void EltTable::SaveImage (DatabaseImageWriter &writer)
+{
+	unsigned Z, i;
+	for (Z = 0; Z < Elements.size (); Z++) {
+		Element *Elt = Elements[Z];
+		if (!Elt)
+			continue;
+		DbElement record;
+		memset (&record, 0, sizeof (DbElement));
+		for (i = 0; i < 3; i++)
+			record.color[i] = Elt->m_DefaultColor[i];
+		record.Z = Z;
+		strncpy (record.symbol, Elt->m_Symbol, 4);
+		record.max_bonds = Elt->m_MaxBonds;
+		record.valence = Elt->m_DefaultValence;
+		record.config = writer.AddString (Elt->ElecConfig);
+		// names
+		vector < pair <string, string> > const &names = RawNames[Z];
+		record.names.first = writer.GetCount (DB_SECTION_NAMES);
+		record.names.count = names.size ();
+		for (i = 0; i < names.size (); i++) {
+			DbName name;
+			name.lang = writer.AddString ((names[i].first.length ())? names[i].first.c_str (): NULL);
+			name.name = writer.AddString (names[i].second);
+			writer.AddRecord (DB_SECTION_NAMES, name);
+		}
+		// radii, those derived from the BODR properties are added when loading them
+		record.radii.first = writer.GetCount (DB_SECTION_RADII);
+		for (i = 0; i < Elt->m_radii.size (); i++) {
+			GcuAtomicRadius const *radius = Elt->m_radii[i];
+			if (!radius || radius->type == GCU_VAN_DER_WAALS || radius->type == GCU_COVALENT)
+				continue;
+			DbRadius r;
+			r.value = radius->value.value;
+			r.prec = radius->value.prec;
+			r.delta = radius->value.delta;
+			r.type = radius->type;
+			r.charge = radius->charge;
+			r.cn = radius->cn;
+			r.spin = radius->spin;
+			r.scale = writer.AddString (radius->scale);
+			r.reserved = 0;
+			writer.AddRecord (DB_SECTION_RADII, r);
+		}
+		record.radii.count = writer.GetCount (DB_SECTION_RADII) - record.radii.first;
+		if (!Elt->m_radii.empty () && Elt->m_radii.back () == NULL)
+			record.terminated |= DB_DATA_RADII;
+		// electronic properties
+		DbValue v;
+		v.reserved = 0;
+		record.electronegativities.first = writer.GetCount (DB_SECTION_ELECTRONEGATIVITIES);
+		for (i = 0; i < Elt->m_en.size (); i++) {
+			GcuElectronegativity const *en = Elt->m_en[i];
+			if (!en)
+				continue;
+			v.value = en->value.value;
+			v.prec = en->value.prec;
+			v.delta = en->value.delta;
+			v.text = writer.AddString (en->scale);
+			writer.AddRecord (DB_SECTION_ELECTRONEGATIVITIES, v);
+		}
+		record.electronegativities.count = writer.GetCount (DB_SECTION_ELECTRONEGATIVITIES) - record.electronegativities.first;
+		if (!Elt->m_en.empty ())
+			record.terminated |= DB_DATA_ELECTRONIC;
+		record.ionizations.first = writer.GetCount (DB_SECTION_IONIZATIONS);
+		record.ionizations.count = Elt->m_ei.size ();
+		for (i = 0; i < Elt->m_ei.size (); i++) {
+			v.value = Elt->m_ei[i].value;
+			v.prec = Elt->m_ei[i].prec;
+			v.delta = Elt->m_ei[i].delta;
+			v.text = writer.AddString (Elt->m_ei[i].unit);
+			writer.AddRecord (DB_SECTION_IONIZATIONS, v);
+		}
+		record.affinities.first = writer.GetCount (DB_SECTION_AFFINITIES);
+		record.affinities.count = Elt->m_ae.size ();
+		for (i = 0; i < Elt->m_ae.size (); i++) {
+			v.value = Elt->m_ae[i].value;
+			v.prec = Elt->m_ae[i].prec;
+			v.delta = Elt->m_ae[i].delta;
+			v.text = writer.AddString (Elt->m_ae[i].unit);
+			writer.AddRecord (DB_SECTION_AFFINITIES, v);
+		}
+		// isotopes
+		record.isotopes.first = writer.GetCount (DB_SECTION_ISOTOPES);
+		record.isotopes.count = Elt->m_isotopes.size ();
+		for (i = 0; i < Elt->m_isotopes.size (); i++) {
+			Isotope const *Is = Elt->m_isotopes[i];
+			DbIsotope iso;
+			iso.mass = Is->mass.value;
+			iso.abundance = Is->abundance.value;
+			iso.mass_prec = Is->mass.prec;
+			iso.mass_delta = Is->mass.delta;
+			iso.abundance_prec = Is->abundance.prec;
+			iso.abundance_delta = Is->abundance.delta;
+			iso.A = Is->A;
+			iso.reserved = 0;
+			writer.AddRecord (DB_SECTION_ISOTOPES, iso);
+		}
+		record.stable = Elt->m_Stability;
+		if (!Elt->m_patterns.empty ()) {
+			double *values;
+			record.min_A = Elt->m_patterns[0]->GetMinMass ();
+			record.max_A = record.min_A + Elt->m_patterns[0]->GetValues (&values) - 1;
+			delete [] values;
+		}
+		// Blue Obelisk Data Repository properties
+		record.properties.first = writer.GetCount (DB_SECTION_PROPERTIES);
+		DbProperty prop;
+		map <string, Value*>::iterator j, jend = Elt->props.end ();
+		for (j = Elt->props.begin (); j != jend; j++) {
+			memset (&prop, 0, sizeof (DbProperty));
+			prop.name = writer.AddString ((*j).first);
+			DimensionalValue *dv = dynamic_cast <DimensionalValue *> ((*j).second);
+			SimpleValue *sv = dynamic_cast <SimpleValue *> ((*j).second);
+			if (dv) {
+				GcuDimensionalValue const val = dv->GetValue ();
+				prop.type = DB_PROPERTY_DIMENSIONAL;
+				prop.value = val.value;
+				prop.prec = val.prec;
+				prop.delta = val.delta;
+				prop.text = writer.AddString (val.unit);
+			} else if (sv) {
+				GcuValue const val = sv->GetValue ();
+				prop.type = DB_PROPERTY_SIMPLE;
+				prop.value = val.value;
+				prop.prec = val.prec;
+				prop.delta = val.delta;
+				prop.text = DB_NO_STRING;
+			} else
+				continue;
+			writer.AddRecord (DB_SECTION_PROPERTIES, prop);
+		}
+		map <string, string>::iterator k, kend = Elt->sprops.end ();
+		for (k = Elt->sprops.begin (); k != kend; k++) {
+			memset (&prop, 0, sizeof (DbProperty));
+			prop.name = writer.AddString ((*k).first);
+			prop.type = DB_PROPERTY_STRING;
+			prop.text = writer.AddString ((*k).second);
+			writer.AddRecord (DB_SECTION_PROPERTIES, prop);
+		}
+		map <string, int>::iterator l, lend = Elt->iprops.end ();
+		for (l = Elt->iprops.begin (); l != lend; l++) {
+			memset (&prop, 0, sizeof (DbProperty));
+			prop.name = writer.AddString ((*l).first);
+			prop.type = DB_PROPERTY_INTEGER;
+			prop.text = DB_NO_STRING;
+			prop.integer = (*l).second;
+			writer.AddRecord (DB_SECTION_PROPERTIES, prop);
+		}
+		record.properties.count = writer.GetCount (DB_SECTION_PROPERTIES) - record.properties.first;
+		writer.AddRecord (DB_SECTION_ELEMENTS, record);
+	}
+}
+
 EltTable::~EltTable()
 {
-	map<string, Element*>::iterator i;
-	for (i = EltsMap.begin(); i != EltsMap.end(); i++)
-		if ((*i).second) delete (*i).second;
+	for (unsigned Z = 0; Z < Elements.size (); Z++)
+		delete Elements[Z];
 	EltsMap.clear();
 	Elements.clear();
 }
 
 Element* EltTable::operator[](int Z)
 {
-	return ((unsigned) Z < Elements.size ())? Elements[Z]: NULL;
+	if ((unsigned) Z >= Elements.size ())
+		return NULL;
+	// the table does not change anymore once an element exists
+	if (Image && g_once_init_enter (&Created[Z])) {
+		unsigned n;
+		Image->GetRecords <DbElement> (DB_SECTION_ELEMENTS, n);
+		g_rec_mutex_lock (&TableMutex);
+		if (Records[Z] < n)
+			LoadElement (Records[Z]);
+		g_rec_mutex_unlock (&TableMutex);
+		g_once_init_leave (&Created[Z], 1);
+	}
+	return Elements[Z];
 }
 
 Element* EltTable::operator[](string Symbol)
 {
-	return EltsMap[Symbol];
+	if (Image) {
+		map <string, int>::iterator i = Symbols.find (Symbol);
+		return (i != Symbols.end ())? (*this)[(*i).second]: NULL;
+	}
+	map <string, Element*>::iterator i = EltsMap.find (Symbol);
+	return (i != EltsMap.end ())? (*i).second: NULL;
 }
 
 void EltTable::AddElement(Element* Elt)
@@ -219,7 +494,9 @@ void EltTable::AddElement(Element* Elt)
 			Elements[i] = NULL;
 	}
 	Elements[Elt->GetZ ()] = Elt;
-	EltsMap[Elt->GetSymbol ()] = Elt;
+	// with the image, lookups by symbol use Symbols, which never changes
+	if (!Image)
+		EltsMap[Elt->GetSymbol ()] = Elt;
 }
 
 Element::Element(int Z, const char* Symbol):
@@ -419,7 +696,12 @@ void Element::LoadRadii ()
 	if (loaded)
 		return;
 	LoadBODR ();
-	if (!(xml = xmlParseFile (PKGDATADIR"/radii.xml"))) {
+	if (Table.HasImage ()) {
+		Table.LoadData (DB_DATA_RADII);
+		loaded = true;
+		return;
+	}
+	if (!(xml = xmlParseFile (DatabaseImage::GetDataFile ("radii.xml").c_str ()))) {
 		g_error (_("Can't find and read radii.xml"));
 	}
 	xmlNode* node = xml->children, *child;
@@ -525,7 +807,12 @@ void Element::LoadElectronicProps ()
 	if (loaded)
 		return;
 	Table.Init ();
-	if (!(xml = xmlParseFile (PKGDATADIR"/elecprops.xml"))) {
+	if (Table.HasImage ()) {
+		Table.LoadData (DB_DATA_ELECTRONIC);
+		loaded = true;
+		return;
+	}
+	if (!(xml = xmlParseFile (DatabaseImage::GetDataFile ("elecprops.xml").c_str ()))) {
 		g_error (_("Can't find and read elecprops.xml"));
 	}
 	xmlNode* node = xml->children, *child;
@@ -684,7 +971,12 @@ void Element::LoadIsotopes ()
 	if (loaded)
 		return;
 	Table.Init ();
-	if (!(xml = xmlParseFile (PKGDATADIR"/isotopes.xml"))) {
+	if (Table.HasImage ()) {
+		Table.LoadData (DB_DATA_ISOTOPES);
+		loaded = true;
+		return;
+	}
+	if (!(xml = xmlParseFile (DatabaseImage::GetDataFile ("isotopes.xml").c_str ()))) {
 		g_error (_("Can't find and read isotopes.xml"));
 	}
 	xmlNode* node = xml->children, *child;
@@ -743,21 +1035,8 @@ void Element::LoadIsotopes ()
 				}
 				child = child->next;
 			}
-			if (minA > 0) {
-				IsotopicPattern *pattern = new IsotopicPattern (minA, maxA);
-				vector<Isotope*>::iterator i, iend = Elt->m_isotopes.end ();
-				for (i = Elt->m_isotopes.begin (); i != iend; i++) {
-					if ((*i)->abundance.value != 0.)
-						pattern->SetValue ((*i)->A, (*i)->abundance.value);
-				}
-				pattern->Normalize ();
-				niso = pattern->GetMonoNuclNb ();
-				i = Elt->m_isotopes.begin ();
-				while ((*i)->A != niso)
-					i++;
-				pattern->SetMonoMass (SimpleValue ((*i)->mass));
-				Elt->m_patterns.push_back (pattern);
-			}
+			if (minA > 0)
+				Elt->AddIsotopicPattern (minA, maxA);
 		}
 		node = node->next;
 	}
@@ -765,6 +1044,23 @@ void Element::LoadIsotopes ()
 	loaded = true;
 }
 
+void Element::AddIsotopicPattern (int minA, int maxA)
+{
+	IsotopicPattern *pattern = new IsotopicPattern (minA, maxA);
+	vector<Isotope*>::iterator i, iend = m_isotopes.end ();
+	for (i = m_isotopes.begin (); i != iend; i++) {
+		if ((*i)->abundance.value != 0.)
+			pattern->SetValue ((*i)->A, (*i)->abundance.value);
+	}
+	pattern->Normalize ();
+	int mono = pattern->GetMonoNuclNb ();
+	i = m_isotopes.begin ();
+	while ((*i)->A != mono)
+		i++;
+	pattern->SetMonoMass (SimpleValue ((*i)->mass));
+	m_patterns.push_back (pattern);
+}
+
 void Element::LoadAllData ()
 {
 	LoadRadii ();
@@ -835,14 +1131,13 @@ void Element::LoadBODR ()
 		return;
 	Table.Init ();
 	loaded = true;
+	if (Table.HasImage () && DatabaseImage::Get ()->HasBODR ()) {
+		Table.LoadData (DB_DATA_BODR);
+		return;
+	}
 	xmlDocPtr xml = xmlParseFile (BODR_PKGDATADIR"/elements.xml");
 	if (!xml)
 		return;
-	set<string>::iterator it = units.find ("pm");
-	if (it == units.end ()) {
-		units.insert ("pm");
-		it = units.find ("pm");
-	}
 	xmlNodePtr node = xml->children, child;
 	char *buf = NULL, *unit;
 	Element *elt;
@@ -947,59 +1242,8 @@ void Element::LoadBODR ()
 					}
 					child = child->next;
 				}
-				if (elt) {
-					DimensionalValue const *v = dynamic_cast <DimensionalValue const *> (elt->GetProperty ("radiusVDW"));
-					double r;
-					if (v) {
-						r = v->GetAsDouble ();
-						GcuDimensionalValue const val = v->GetValue ();
-						int prec = val.prec;
-						if (!strcmp (val.unit, "Å")) {
-							r *= 100.;
-							prec = (prec > 2)? prec - 2: 0;
-						} else if (!strcmp (val.unit, "pm"))
-							r = -1.; // FIXME: allow other units if needed
-						if (r > 0.) {
-							GcuAtomicRadius* radius = new GcuAtomicRadius;
-							radius->value.value = r;
-							radius->value.prec = prec;
-							radius->value.delta = val.delta;
-							radius->value.unit = "pm";
-							radius->Z = elt->GetZ ();
-							radius->type = GCU_VAN_DER_WAALS;
-							radius->charge = 0;
-							radius->scale = NULL;
-							radius->cn = -1;
-							radius->spin = GCU_N_A_SPIN;
-							elt->m_radii.push_back (radius);
-						}
-					}
-					v = dynamic_cast <DimensionalValue const *> (elt->GetProperty ("radiusCovalent"));
-					if (v) {
-						r = v->GetAsDouble ();
-						GcuDimensionalValue const val = v->GetValue ();
-						int prec = val.prec;
-						if (!strcmp (val.unit, "Å")) {
-							r *= 100.;
-							prec = (prec > 2)? prec - 2: 0;
-						} else if (!strcmp (val.unit, "pm"))
-							r = -1.; // FIXME: allow other units if needed
-						if (r > 0.) {
-							GcuAtomicRadius* radius = new GcuAtomicRadius;
-							radius->value.value = r;
-							radius->value.prec = prec;
-							radius->value.delta = val.delta;
-							radius->value.unit = "pm";
-							radius->Z = elt->GetZ ();
-							radius->type = GCU_COVALENT;
-							radius->charge = 0;
-							radius->scale = NULL;
-							radius->cn = -1;
-							radius->spin = GCU_N_A_SPIN;
-							elt->m_radii.push_back (radius);
-						}
-					}
-				}
+				if (elt)
+					elt->AddBODRRadii ();
 			}
 			node = node->next;
 		}
@@ -1007,6 +1251,179 @@ void Element::LoadBODR ()
 	xmlFreeDoc (xml);
 }
 
+void Element::AddBODRRadii ()
+{
+	DimensionalValue const *v = dynamic_cast <DimensionalValue const *> (GetProperty ("radiusVDW"));
+	double r;
+	if (v) {
+		r = v->GetAsDouble ();
+		GcuDimensionalValue const val = v->GetValue ();
+		int prec = val.prec;
+		if (!strcmp (val.unit, "Å")) {
+			r *= 100.;
+			prec = (prec > 2)? prec - 2: 0;
+		} else if (!strcmp (val.unit, "pm"))
+			r = -1.; // FIXME: allow other units if needed
+		if (r > 0.) {
+			GcuAtomicRadius* radius = new GcuAtomicRadius;
+			radius->value.value = r;
+			radius->value.prec = prec;
+			radius->value.delta = val.delta;
+			radius->value.unit = "pm";
+			radius->Z = m_Z;
+			radius->type = GCU_VAN_DER_WAALS;
+			radius->charge = 0;
+			radius->scale = NULL;
+			radius->cn = -1;
+			radius->spin = GCU_N_A_SPIN;
+			m_radii.push_back (radius);
+		}
+	}
+	v = dynamic_cast <DimensionalValue const *> (GetProperty ("radiusCovalent"));
+	if (v) {
+		r = v->GetAsDouble ();
+		GcuDimensionalValue const val = v->GetValue ();
+		int prec = val.prec;
+		if (!strcmp (val.unit, "Å")) {
+			r *= 100.;
+			prec = (prec > 2)? prec - 2: 0;
+		} else if (!strcmp (val.unit, "pm"))
+			r = -1.; // FIXME: allow other units if needed
+		if (r > 0.) {
+			GcuAtomicRadius* radius = new GcuAtomicRadius;
+			radius->value.value = r;
+			radius->value.prec = prec;
+			radius->value.delta = val.delta;
+			radius->value.unit = "pm";
+			radius->Z = m_Z;
+			radius->type = GCU_COVALENT;
+			radius->charge = 0;
+			radius->scale = NULL;
+			radius->cn = -1;
+			radius->spin = GCU_N_A_SPIN;
+			m_radii.push_back (radius);
+		}
+	}
+}
+
+void Element::LoadImage (DatabaseImage const &image, unsigned index, unsigned data)
+{
+	unsigned i, n;
+	DbElement const &record = image.GetRecords <DbElement> (DB_SECTION_ELEMENTS, n)[index];
+	if (data & DB_DATA_BODR) {
+		DbProperty const *properties = image.GetRecords <DbProperty> (DB_SECTION_PROPERTIES, record.properties);
+		for (i = 0; properties && i < record.properties.count; i++) {
+			DbProperty const &prop = properties[i];
+			char const *key = image.GetString (prop.name), *text = image.GetString (prop.text);
+			if (!key)
+				continue;
+			switch (prop.type) {
+			case DB_PROPERTY_SIMPLE: {
+				SimpleValue *v = new SimpleValue ();
+				v->val.value = prop.value;
+				v->val.prec = prop.prec;
+				v->val.delta = prop.delta;
+				props[key] = v;
+				break;
+			}
+			case DB_PROPERTY_DIMENSIONAL: {
+				DimensionalValue *v = new DimensionalValue ();
+				v->val.value = prop.value;
+				v->val.prec = prop.prec;
+				v->val.delta = prop.delta;
+				v->val.unit = (text)? GetStaticUnit (text): "";
+				props[key] = v;
+				break;
+			}
+			case DB_PROPERTY_STRING:
+				sprops[key] = (text)? text: "";
+				break;
+			case DB_PROPERTY_INTEGER:
+				iprops[key] = prop.integer;
+				break;
+			}
+		}
+		AddBODRRadii ();
+	}
+	if (data & DB_DATA_RADII) {
+		DbRadius const *radii = image.GetRecords <DbRadius> (DB_SECTION_RADII, record.radii);
+		char const *unit = GetStaticUnit ("pm");
+		for (i = 0; radii && i < record.radii.count; i++) {
+			GcuAtomicRadius* radius = new GcuAtomicRadius;
+			radius->Z = m_Z;
+			radius->type = static_cast <gcu_radius_type> (radii[i].type);
+			radius->value.value = radii[i].value;
+			radius->value.prec = radii[i].prec;
+			radius->value.delta = radii[i].delta;
+			radius->value.unit = unit;
+			radius->charge = radii[i].charge;
+			radius->cn = radii[i].cn;
+			radius->spin = static_cast <gcu_spin_state> (radii[i].spin);
+			char const *scale = image.GetString (radii[i].scale);
+			radius->scale = (scale)? g_strdup (scale): NULL;
+			m_radii.push_back (radius);
+		}
+		if (record.terminated & DB_DATA_RADII)
+			m_radii.push_back (NULL);
+	}
+	if (data & DB_DATA_ELECTRONIC) {
+		DbValue const *values = image.GetRecords <DbValue> (DB_SECTION_ELECTRONEGATIVITIES, record.electronegativities);
+		for (i = 0; values && i < record.electronegativities.count; i++) {
+			GcuElectronegativity* en = new GcuElectronegativity;
+			en->Z = m_Z;
+			char const *scale = image.GetString (values[i].text);
+			en->scale = (scale)? GetStaticScale (const_cast <char *> (scale)): NULL;
+			en->value.value = values[i].value;
+			en->value.prec = values[i].prec;
+			en->value.delta = values[i].delta;
+			m_en.push_back (en);
+		}
+		if (record.terminated & DB_DATA_ELECTRONIC)
+			m_en.push_back (NULL);
+		char const *config = image.GetString (record.config);
+		if (config)
+			ElecConfig = config;
+		values = image.GetRecords <DbValue> (DB_SECTION_IONIZATIONS, record.ionizations);
+		m_ei.resize ((values)? record.ionizations.count: 0);
+		for (i = 0; i < m_ei.size (); i++) {
+			m_ei[i].value = values[i].value;
+			m_ei[i].prec = values[i].prec;
+			m_ei[i].delta = values[i].delta;
+			m_ei[i].unit = GetStaticUnit (image.GetString (values[i].text));
+		}
+		values = image.GetRecords <DbValue> (DB_SECTION_AFFINITIES, record.affinities);
+		m_ae.resize ((values)? record.affinities.count: 0);
+		for (i = 0; i < m_ae.size (); i++) {
+			m_ae[i].value = values[i].value;
+			m_ae[i].prec = values[i].prec;
+			m_ae[i].delta = values[i].delta;
+			m_ae[i].unit = GetStaticUnit (image.GetString (values[i].text));
+		}
+	}
+	if (data & DB_DATA_ISOTOPES) {
+		DbIsotope const *isotopes = image.GetRecords <DbIsotope> (DB_SECTION_ISOTOPES, record.isotopes);
+		for (i = 0; isotopes && i < record.isotopes.count; i++) {
+			Isotope *Is = new Isotope ();
+			Is->A = isotopes[i].A;
+			Is->mass.value = isotopes[i].mass;
+			Is->mass.prec = isotopes[i].mass_prec;
+			Is->mass.delta = isotopes[i].mass_delta;
+			Is->abundance.value = isotopes[i].abundance;
+			Is->abundance.prec = isotopes[i].abundance_prec;
+			Is->abundance.delta = isotopes[i].abundance_delta;
+			m_isotopes.push_back (Is);
+		}
+		m_Stability = record.stable;
+		if (record.min_A > 0 && !m_isotopes.empty ())
+			AddIsotopicPattern (record.min_A, record.max_A);
+	}
+}
+
+void Element::SaveImage (DatabaseImageWriter &writer)
+{
+	Table.SaveImage (writer);
+}
+
 Value const *Element::GetProperty (char const *property_name)
 {
 	map<string, Value*>::iterator i = props.find (property_name);
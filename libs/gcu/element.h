@@ -48,6 +48,8 @@ namespace gcu
 {
 
 class EltTable;
+class DatabaseImage;
+class DatabaseImageWriter;
 
 /*!\class Element gcu/element.h
 @brief Chemical element.
@@ -60,6 +62,7 @@ a user cannot create a new element.
 class Element
 {
 friend class EltTable;
+friend class DatabaseImage;
 private:
 /*!
 \param Z: the atomic number corresponding to the element
@@ -94,11 +97,17 @@ public:
 	static int Z (char const *symbol);
 	/*!
 	@param Z: the atomic number of a chemical element.
+
+	When the database image is used, the element is created the first time it
+	is looked up. Lookups are serialized, so that this method can be called from
+	several threads once the databases are initialized.
 	@return a pointer to the Element whose atomic number is Z or NULL if the element is unknown.
 	*/
 	static Element* GetElement (int Z);
 	/*!
 	@param symbol: the symbol of a chemical element.
+
+	Same as GetElement(int), this method can be called from several threads.
 	@return a pointer to the Element whose symbol is used as parameter or NULL if the element is unknown.
 	*/
 	static Element* GetElement (char const *symbol);
@@ -289,6 +298,11 @@ public:
 	bool IsMetallic ();
 
 private:
+	static void SaveImage (DatabaseImageWriter &writer);
+	void LoadImage (DatabaseImage const &image, unsigned index, unsigned data);
+	void AddBODRRadii ();
+	void AddIsotopicPattern (int minA, int maxA);
+
 	unsigned char m_Z, m_nve, m_tve, m_maxve;
 	char m_Symbol[4];
 	DimensionalValue const *m_AtomicWeight;
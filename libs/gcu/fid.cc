@@ -0,0 +1,403 @@
+// -*- C++ -*-
+
+/*
+ * Gnome Chemistry Utils
+ * gcu/fid.cc
+ *
+ * Copyright (C) 2026 Jean Bréfort <jean.brefort@normalesup.org>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301
+ * USA
+ */
+
+#include "config.h"
+#include "fid.h"
+#include <cmath>
+
+namespace gcu
+{
+
+////////////////////////////////////////////////////////////////////////////////
+// FFTPlan implementation
+
+FFTPlan::FFTPlan (unsigned n):
+	m_Size (n),
+	m_Reverse (n),
+	m_Cos (n / 2),
+	m_Sin (n / 2)
+{
+	unsigned i, j, bits = 0;
+	while ((1u << bits) < n)
+		bits++;
+	for (i = 0; i < n; i++) {
+		unsigned r = 0;
+		for (j = 0; j < bits; j++)
+			if (i & (1u << j))
+				r |= 1u << (bits - 1 - j);
+		m_Reverse[i] = r;
+	}
+	for (i = 0; i < n / 2; i++) {
+		m_Cos[i] = cos (2. * M_PI * i / n);
+		m_Sin[i] = -sin (2. * M_PI * i / n);
+	}
+}
+
+FFTPlan::~FFTPlan ()
+{
+}
+
+void FFTPlan::Execute (double *re, double *im) const
+{
+	unsigned i, j, k, size, half, step, start;
+	double tr, ti, wr, wi;
+	for (i = 0; i < m_Size; i++) {
+		j = m_Reverse[i];
+		if (j > i) {
+			tr = re[i];
+			re[i] = re[j];
+			re[j] = tr;
+			ti = im[i];
+			im[i] = im[j];
+			im[j] = ti;
+		}
+	}
+	for (size = 2; size <= m_Size; size <<= 1) {
+		half = size / 2;
+		step = m_Size / size;
+		for (start = 0; start < m_Size; start += size)
+			for (j = 0, k = 0; j < half; j++, k += step) {
+				unsigned a = start + j, b = a + half;
+				wr = m_Cos[k];
+				wi = m_Sin[k];
+				tr = re[b] * wr - im[b] * wi;
+				ti = re[b] * wi + im[b] * wr;
+				re[b] = re[a] - tr;
+				im[b] = im[a] - ti;
+				re[a] += tr;
+				im[a] += ti;
+			}
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// FidProcessor implementation
+
+FidProcessor::FidProcessor ():
+	m_Dwell (1.),
+	m_Window (FID_WINDOW_NONE),
+	m_WindowParameter (0.),
+	m_ZeroFill (1),
+	m_Phase0 (0.),
+	m_Phase1 (0.),
+	m_Plan (NULL),
+	m_Transformed (false),
+	m_Phased (false)
+{
+}
+
+FidProcessor::~FidProcessor ()
+{
+	delete m_Plan;
+}
+
+void FidProcessor::SetFID (double const *re, double const *im, unsigned npoints, double dwell)
+{
+	m_FidRe.assign (re, re + npoints);
+	m_FidIm.assign (im, im + npoints);
+	m_Dwell = dwell;
+	m_Transformed = m_Phased = false;
+}
+
+void FidProcessor::SetWindow (FidWindow window, double parameter)
+{
+	if (window == m_Window && parameter == m_WindowParameter)
+		return;
+	m_Window = window;
+	m_WindowParameter = parameter;
+	m_Transformed = m_Phased = false;
+}
+
+void FidProcessor::SetZeroFill (unsigned factor)
+{
+	if (factor == 0)
+		factor = 1;
+	if (factor == m_ZeroFill)
+		return;
+	m_ZeroFill = factor;
+	m_Transformed = m_Phased = false;
+}
+
+void FidProcessor::SetPhase (double phase0, double phase1)
+{
+	// keep the zero order phase in ]-pi, pi]
+	phase0 = fmod (phase0, 2. * M_PI);
+	if (phase0 > M_PI)
+		phase0 -= 2. * M_PI;
+	else if (phase0 <= -M_PI)
+		phase0 += 2. * M_PI;
+	m_Phase0 = phase0;
+	m_Phase1 = phase1;
+	m_Phased = false;
+}
+
+unsigned FidProcessor::GetSize ()
+{
+	if (!m_Transformed)
+		Transform ();
+	return m_Re.size ();
+}
+
+void FidProcessor::GetFrequencies (double offset, double *x)
+{
+	unsigned i, n = GetSize (), npoints = m_FidRe.size ();
+	double step = (npoints > 1)? 1. / ((npoints - 1) * m_Dwell): 0.;
+	double shift = offset - step * (npoints - 1) / 2.;
+	for (i = 0; i < n; i++)
+		x[i] = i * step + shift;
+}
+
+double const *FidProcessor::GetReal ()
+{
+	if (!m_Transformed)
+		Transform ();
+	return &m_Re[0];
+}
+
+double const *FidProcessor::GetImaginary ()
+{
+	if (!m_Transformed)
+		Transform ();
+	return &m_Im[0];
+}
+
+double const *FidProcessor::GetPhasedReal ()
+{
+	if (!m_Phased)
+		Phase ();
+	return &m_PhasedRe[0];
+}
+
+double const *FidProcessor::GetPhasedImaginary ()
+{
+	if (!m_Phased)
+		Phase ();
+	return &m_PhasedIm[0];
+}
+
+static double window_value (FidWindow window, double parameter, double t, double tmax)
+{
+	double x;
+	switch (window) {
+	case FID_WINDOW_EXPONENTIAL:
+		return exp (-M_PI * parameter * t);
+	case FID_WINDOW_GAUSSIAN:
+		x = M_PI * parameter * t;
+		return exp (-x * x / (4. * M_LN2));
+	case FID_WINDOW_SINE_BELL:
+		return sin (parameter + (M_PI - parameter) * t / tmax);
+	case FID_WINDOW_SQUARED_SINE_BELL:
+		x = sin (parameter + (M_PI - parameter) * t / tmax);
+		return x * x;
+	default:
+		return 1.;
+	}
+}
+
+void FidProcessor::Transform ()
+{
+	unsigned npoints = m_FidRe.size (), n = 2, i, j;
+	while (n < npoints * m_ZeroFill)
+		n <<= 1;
+	if (!m_Plan || m_Plan->GetSize () != n) {
+		delete m_Plan;
+		m_Plan = new FFTPlan (n);
+	}
+	// the phased arrays are used as work space, they are invalid anyway
+	m_PhasedRe.assign (n, 0.);
+	m_PhasedIm.assign (n, 0.);
+	double *re = &m_PhasedRe[0], *im = &m_PhasedIm[0];
+	double tmax = (npoints > 1)? (npoints - 1) * m_Dwell: 1.;
+	for (i = 0; i < npoints; i++) {
+		double w = window_value (m_Window, m_WindowParameter, i * m_Dwell, tmax);
+		re[i] = m_FidRe[i] * w;
+		im[i] = m_FidIm[i] * w;
+	}
+	m_Plan->Execute (re, im);
+	// reorder from the highest to the lowest frequency
+	m_Re.resize (n);
+	m_Im.resize (n);
+	unsigned n2 = n / 2 - 1;
+	for (i = 0, j = n2; i < n2; i++, j--) {
+		m_Re[i] = re[j];
+		m_Im[i] = im[j];
+	}
+	// the value at 0 must be skipped, doing a linear interpolation
+	m_Re[i] = (re[1] + re[n - 1]) / 2.;
+	m_Im[i++] = (im[1] + im[n - 1]) / 2.;
+	for (j = n - 1; i < n; i++, j--) {
+		m_Re[i] = re[j];
+		m_Im[i] = im[j];
+	}
+	m_Transformed = true;
+	m_Phased = false;
+}
+
+void FidProcessor::Phase ()
+{
+	if (!m_Transformed)
+		Transform ();
+	unsigned i, n = m_Re.size ();
+	m_PhasedRe.resize (n);
+	m_PhasedIm.resize (n);
+	double step = m_Phase1 / n, phase, c, s;
+	for (i = 0; i < n; i++) {
+		phase = m_Phase0 + step * i;
+		c = cos (phase);
+		s = sin (phase);
+		m_PhasedRe[i] = m_Re[i] * c - m_Im[i] * s;
+		m_PhasedIm[i] = m_Re[i] * s + m_Im[i] * c;
+	}
+	m_Phased = true;
+}
+
+double FidProcessor::Score (double phi, double tau) const
+{
+	unsigned i, k, max = m_Restricted.size (), n = m_Re.size ();
+	double c = 0., p;
+	for (k = 0; k < max; k++) {
+		i = m_Restricted[k];
+		p = phi - 2. * M_PI * tau * (n - 1 - i) / n;
+		c += m_Weights[k] * (m_Re[i] * cos (p) - m_Im[i] * sin (p));
+	}
+	return c;
+}
+
+double FidProcessor::BestPhase (double tau, double &phi) const
+{
+	double best = 0., c, p, start;
+	phi = 0.;
+	for (p = 0.; p < 2. * M_PI; p += 10. / 180. * M_PI) {
+		c = Score (p, tau);
+		if (c > best) {
+			best = c;
+			phi = p;
+		}
+	}
+	// refine with a step of 1°
+	start = phi;
+	for (p = start - 9. / 180. * M_PI; p < start + 10. / 180. * M_PI; p += 1. / 180. * M_PI) {
+		c = Score (p, tau);
+		if (c > best) {
+			best = c;
+			phi = p;
+		}
+	}
+	return best;
+}
+
+void FidProcessor::AutoPhase ()
+{
+	if (!m_Transformed)
+		Transform ();
+	unsigned i, k, n = m_Re.size ();
+	std::vector <double> z (n);
+	double maxz = 0.;
+	for (i = 0; i < n; i++) {
+		z[i] = sqrt (m_Re[i] * m_Re[i] + m_Im[i] * m_Im[i]);
+		if (z[i] > maxz)
+			maxz = z[i];
+	}
+	if (maxz == 0.) {
+		SetPhase (0., 0.);
+		return;
+	}
+	// normalize the z values
+	for (i = 0; i < n; i++)
+		z[i] /= maxz;
+	double c = 0.1;
+	unsigned nmax, nmin;
+	while (c > 0.) {
+		nmin = n, nmax = 0;
+		for (i = 0; i < n; i++)
+			if (z[i] > c) {
+				nmin = i;
+				break;
+			}
+		for (i = n - 1; i > 0; i--)
+			if (z[i] > c) {
+				nmax = i;
+				break;
+			}
+		if ((nmax - nmin) > n / 10) // 10 is arbitrary, but should be not too large
+			break;
+		c /= 2.;
+	}
+	// only use the points with z greater than c, and evaluate their weights once
+	m_Restricted.clear ();
+	m_Weights.clear ();
+	for (i = 0; i < n; i++)
+		if (z[i] > c) {
+			m_Restricted.push_back (i);
+			m_Weights.push_back (z[i] * z[i] * exp (-fabs (4. * i / n - 2)));
+		}
+	// coarse search
+	double maxc = 0., phi, tau, phiopt = 0., tauopt = 0.;
+	for (k = 0; k < 41; k++) {
+		tau = -1. + k * .1;
+		for (phi = 0; phi < 2 * M_PI; phi += 10. / 180. * M_PI) {
+			c = Score (phi, tau);
+			if (c > maxc) {
+				maxc = c;
+				tauopt = tau;
+				phiopt = phi;
+			}
+		}
+	}
+	// let's search more finely around the maximum, first with a step of 1° for phi
+	double phase = phiopt;
+	for (phi = phase - 9. / 180. * M_PI; phi < phase + 10. / 180. * M_PI; phi += 1. / 180. * M_PI) {
+		c = Score (phi, tauopt);
+		if (c > maxc) {
+			maxc = c;
+			phiopt = phi;
+		}
+	}
+	// then with lower values of tau
+	for (k = 1; k < 10; k++) {
+		tau = tauopt - 0.01 * k;
+		c = BestPhase (tau, phi);
+		if (c < maxc)
+			break;
+		maxc = c;
+		phiopt = phi;
+		tauopt = tau;
+	}
+	if (k == 1)
+		// and with higher values
+		for (k = 1; k < 10; k++) {
+			tau = tauopt + 0.01 * k;
+			c = BestPhase (tau, phi);
+			if (c < maxc)
+				break;
+			maxc = c;
+			phiopt = phi;
+			tauopt = tau;
+		}
+	m_Restricted.clear ();
+	m_Weights.clear ();
+	SetPhase (phiopt - 2. * M_PI * tauopt * (n - 1) / n, 2. * M_PI * tauopt);
+}
+
+}	//	namespace gcu
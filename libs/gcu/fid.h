@@ -0,0 +1,238 @@
+// -*- C++ -*-
+
+/*
+ * Gnome Chemistry Utils
+ * gcu/fid.h
+ *
+ * Copyright (C) 2026 Jean Bréfort <jean.brefort@normalesup.org>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301
+ * USA
+ */
+
+#ifndef GCU_FID_H
+#define GCU_FID_H
+
+#include <vector>
+
+/*!\file*/
+namespace gcu
+{
+
+/*!\enum FidWindow gcu/fid.h
+The apodization functions supported by FidProcessor. t is the time of the
+point, and tmax the time of the last point.
+*/
+typedef enum {
+/*!
+No apodization.
+*/
+	FID_WINDOW_NONE,
+/*!
+Exponential multiplication, exp(-pi*lb*t), where the parameter lb is the line
+broadening in Hz.
+*/
+	FID_WINDOW_EXPONENTIAL,
+/*!
+Gaussian multiplication, exp(-(pi*lb*t)^2/(4 ln 2)), where the parameter lb is
+the line broadening in Hz.
+*/
+	FID_WINDOW_GAUSSIAN,
+/*!
+Sine bell, sin(shift+(pi-shift)*t/tmax), where the parameter is the shift in
+radians.
+*/
+	FID_WINDOW_SINE_BELL,
+/*!
+Squared sine bell, the square of FID_WINDOW_SINE_BELL.
+*/
+	FID_WINDOW_SQUARED_SINE_BELL,
+/*!
+The number of supported windows.
+*/
+	FID_WINDOW_MAX
+} FidWindow;
+
+/*!\class FFTPlan gcu/fid.h
+A radix 2 forward fast Fourier transform for a given size. The bit reversal
+permutation and the twiddle factors are evaluated once when the plan is
+created, so that a plan can be used for any number of transforms of the same
+size.
+*/
+class FFTPlan
+{
+public:
+/*!
+@param n the transform size, which must be a power of two.
+*/
+	FFTPlan (unsigned n);
+/*!
+The destructor.
+*/
+	~FFTPlan ();
+
+/*!
+@param re the real parts.
+@param im the imaginary parts.
+
+Transforms the data in place, using the same sign convention as
+go_fourier_fft, and without any normalization.
+*/
+	void Execute (double *re, double *im) const;
+/*!
+@return the transform size.
+*/
+	unsigned GetSize () const {return m_Size;}
+
+private:
+	unsigned m_Size;
+	std::vector <unsigned> m_Reverse;
+	std::vector <double> m_Cos, m_Sin;
+};
+
+/*!\class FidProcessor gcu/fid.h
+Transforms a free induction decay to a NMR spectrum: apodization, zero
+filling, Fourier transform and phase correction. Each stage is evaluated only
+when needed, so that changing the phase does not repeat the transform, and the
+FFT plan is kept as long as the size does not change. This class does not use
+any user interface and might be used to process series of files.
+
+The transformed data are ordered as displayed, from the highest to the lowest
+frequency. The phase applied to point i of n is phase0 + phase1 * i / n.
+*/
+class FidProcessor
+{
+public:
+/*!
+The constructor.
+*/
+	FidProcessor ();
+/*!
+The destructor.
+*/
+	~FidProcessor ();
+
+/*!
+@param re the real parts of the FID.
+@param im the imaginary parts of the FID.
+@param npoints the number of points.
+@param dwell the time between two points in seconds.
+
+Sets the data to process. The arrays are copied.
+*/
+	void SetFID (double const *re, double const *im, unsigned npoints, double dwell);
+/*!
+@param window the apodization function.
+@param parameter the function parameter, see FidWindow.
+*/
+	void SetWindow (FidWindow window, double parameter);
+/*!
+@param factor the zero filling factor.
+
+The FID is padded with zeros up to the power of two immediately greater or
+equal to the number of points multiplied by \a factor. The default is 1.
+*/
+	void SetZeroFill (unsigned factor);
+/*!
+@param phase0 the zero order phase correction in radians.
+@param phase1 the first order phase correction in radians.
+
+Only the phase correction stage will be evaluated again. \a phase0 is reduced
+to the ]-pi, pi] interval.
+*/
+	void SetPhase (double phase0, double phase1);
+/*!
+Estimates the phase corrections maximizing the absorption signal (see
+http://www.ebyte.it/stan/Poster_EDISPA.html) and sets them.
+*/
+	void AutoPhase ();
+
+/*!
+@return the apodization function.
+*/
+	FidWindow GetWindow () const {return m_Window;}
+/*!
+@return the apodization function parameter.
+*/
+	double GetWindowParameter () const {return m_WindowParameter;}
+/*!
+@return the zero filling factor.
+*/
+	unsigned GetZeroFill () const {return m_ZeroFill;}
+/*!
+@return the zero order phase correction, in the ]-pi, pi] interval.
+*/
+	double GetPhase0 () const {return m_Phase0;}
+/*!
+@return the first order phase correction.
+*/
+	double GetPhase1 () const {return m_Phase1;}
+
+/*!
+@return the number of points in the transformed data.
+*/
+	unsigned GetSize ();
+/*!
+@param offset the abscissa of the point of index (n - 1) / 2, n being the
+number of points of the FID, usually the $OFFSET label value.
+@param x where to store the abscissas, must be able to hold GetSize() values.
+
+Evaluates the abscissas of the transformed data in Hz, the step being the
+inverse of the acquisition time. gspectrum and the batch processor use the
+same abscissas.
+*/
+	void GetFrequencies (double offset, double *x);
+/*!
+@return the real part of the unphased spectrum.
+*/
+	double const *GetReal ();
+/*!
+@return the imaginary part of the unphased spectrum.
+*/
+	double const *GetImaginary ();
+/*!
+@return the real part of the phased spectrum.
+*/
+	double const *GetPhasedReal ();
+/*!
+@return the imaginary part of the phased spectrum.
+*/
+	double const *GetPhasedImaginary ();
+
+private:
+	void Transform ();
+	void Phase ();
+	double Score (double phi, double tau) const;
+	double BestPhase (double tau, double &phi) const;
+
+private:
+	std::vector <double> m_FidRe, m_FidIm;
+	double m_Dwell;
+	FidWindow m_Window;
+	double m_WindowParameter;
+	unsigned m_ZeroFill;
+	double m_Phase0, m_Phase1;
+	FFTPlan *m_Plan;
+	bool m_Transformed, m_Phased;
+	// transformed data, ordered for display
+	std::vector <double> m_Re, m_Im, m_PhasedRe, m_PhasedIm;
+	// data used by AutoPhase
+	std::vector <unsigned> m_Restricted;
+	std::vector <double> m_Weights;
+};
+
+}	//	namespace gcu
+
+#endif	//	GCU_FID_H
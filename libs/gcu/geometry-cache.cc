@@ -0,0 +1,181 @@
+// -*- C++ -*-
+
+/*
+ * Gnome Chemistry Utils
+ * libs/gcu/geometry-cache.cc
+ *
+ * Copyright (C) 2026 Jean Bréfort <jean.brefort@normalesup.org>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301
+ * USA
+ */
+
+#include "config.h"
+#include "geometry-cache.h"
+#include "cylinder.h"
+#include "glbatch.h"
+#include "sphere.h"
+#include "vector.h"
+#include <GL/gl.h>
+#include <GL/glx.h>
+#include <glib.h>
+#include <cmath>
+#include <map>
+
+namespace gcu
+{
+
+typedef std::pair < void const *, int > GeometryKey;
+
+static void const *CurrentContext = NULL;	// the last context set for non GLX contexts
+static std::map < GeometryKey, Sphere * > Spheres;
+static std::map < GeometryKey, Cylinder * > Cylinders;
+
+// projected radii in pixels below which a cheaper mesh is used
+static double const SphereThresholds[] = {3., 10., 30.};
+static int const SphereDetails[] = {1, 3, 6, 10};
+static double const CylinderThresholds[] = {2., 6.};
+static int const CylinderFaces[] = {4, 6, 10};
+
+unsigned const GeometryCache::SphereLevels;
+unsigned const GeometryCache::CylinderLevels;
+
+GeometryCache::GeometryCache ()
+{
+	GLint viewport[4];
+	glGetDoublev (GL_MODELVIEW_MATRIX, m_ModelView);
+	glGetDoublev (GL_PROJECTION_MATRIX, m_Projection);
+	glGetIntegerv (GL_VIEWPORT, viewport);
+	// the model view matrix might include a global scaling
+	m_ModelScale = sqrt (m_ModelView[0] * m_ModelView[0] + m_ModelView[1] * m_ModelView[1] + m_ModelView[2] * m_ModelView[2]);
+	m_Scale = m_Projection[5] * viewport[3] / 2. * m_ModelScale;
+}
+
+GeometryCache::~GeometryCache ()
+{
+}
+
+double GeometryCache::ProjectedSize (Vector const &v, double size, bool any_orientation) const
+{
+	if (m_Scale <= 0.)
+		return HUGE_VAL;
+	double z = (any_orientation)?
+		// the eye looks towards negative z, so the nearest position is the highest z
+		m_ModelView[14] + v.GetLength () * m_ModelScale:
+		m_ModelView[2] * v.GetX () + m_ModelView[6] * v.GetY () + m_ModelView[10] * v.GetZ () + m_ModelView[14];
+	double w = m_Projection[11] * z + m_Projection[15];
+	return (w > 0.)? size * m_Scale / w: HUGE_VAL;
+}
+
+double GeometryCache::OriginDepth () const
+{
+	return m_Projection[11] * m_ModelView[14] + m_Projection[15];
+}
+
+unsigned GeometryCache::GetSphereLevel (Vector const &center, double radius, bool any_orientation) const
+{
+	double size = ProjectedSize (center, radius, any_orientation);
+	unsigned i = 0;
+	while (i < G_N_ELEMENTS (SphereThresholds) && size >= SphereThresholds[i])
+		i++;
+	return i;
+}
+
+unsigned GeometryCache::GetCylinderLevel (Vector const &end1, Vector const &end2, double radius, bool any_orientation) const
+{
+	Vector center = (end1 + end2) / 2.;
+	if (any_orientation && end1.GetLength () > center.GetLength ())
+		center = end1;
+	if (any_orientation && end2.GetLength () > center.GetLength ())
+		center = end2;
+	double size = ProjectedSize (center, radius, any_orientation);
+	unsigned i = 0;
+	while (i < G_N_ELEMENTS (CylinderThresholds) && size >= CylinderThresholds[i])
+		i++;
+	return i;
+}
+
+bool GeometryCache::IsCloseTo (GeometryCache const &cache) const
+{
+	if (m_Scale <= 0. || cache.m_Scale <= 0.)
+		return m_Scale <= 0. && cache.m_Scale <= 0.;
+	double w = OriginDepth (), w1 = cache.OriginDepth ();
+	if (w <= 0. || w1 <= 0.)
+		return false;
+	// compare the pixels per unit at the origin depth
+	double ratio = (m_Scale / w) / (cache.m_Scale / w1);
+	return ratio > .95 && ratio < 1.05;
+}
+
+Sphere const &GeometryCache::GetSphere (Vector const &center, double radius) const
+{
+	return GetSphere (SphereDetails[GetSphereLevel (center, radius)]);
+}
+
+Cylinder const &GeometryCache::GetCylinder (Vector const &end1, Vector const &end2, double radius) const
+{
+	return GetCylinder (CylinderFaces[GetCylinderLevel (end1, end2, radius)]);
+}
+
+Sphere const &GeometryCache::GetSphere (int detail)
+{
+	Sphere *&sp = Spheres[GeometryKey (GetCurrentContext (), detail)];
+	if (sp == NULL)
+		sp = new Sphere (detail);
+	return *sp;
+}
+
+Cylinder const &GeometryCache::GetCylinder (int faces)
+{
+	Cylinder *&cyl = Cylinders[GeometryKey (GetCurrentContext (), faces)];
+	if (cyl == NULL)
+		cyl = new Cylinder (faces);
+	return *cyl;
+}
+
+void GeometryCache::SetCurrentContext (void const *context)
+{
+	CurrentContext = context;
+}
+
+void const *GeometryCache::GetCurrentContext ()
+{
+	// each GLX context is its own key, even if nobody told us it became current
+	GLXContext context = glXGetCurrentContext ();
+	return (context)? context: CurrentContext;
+}
+
+void GeometryCache::ReleaseContext (void const *context, bool current)
+{
+	GLBatch::ReleaseContext (context, current);
+	std::map < GeometryKey, Sphere * >::iterator i = Spheres.lower_bound (GeometryKey (context, 0));
+	while (i != Spheres.end () && (*i).first.first == context) {
+		if (!current)
+			(*i).second->detach ();
+		delete (*i).second;
+		Spheres.erase (i++);
+	}
+	std::map < GeometryKey, Cylinder * >::iterator j = Cylinders.lower_bound (GeometryKey (context, 0));
+	while (j != Cylinders.end () && (*j).first.first == context) {
+		if (!current)
+			(*j).second->detach ();
+		delete (*j).second;
+		Cylinders.erase (j++);
+	}
+	if (CurrentContext == context)
+		CurrentContext = NULL;
+}
+
+}	//	namespace gcu
@@ -0,0 +1,155 @@
+// -*- C++ -*-
+
+/*
+ * Gnome Chemistry Utils
+ * gcu/geometry-cache.h
+ *
+ * Copyright (C) 2026 Jean Bréfort <jean.brefort@normalesup.org>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301
+ * USA
+ */
+
+#ifndef GCU_GEOMETRY_CACHE_H
+#define GCU_GEOMETRY_CACHE_H
+
+/*!\file*/
+namespace gcu
+{
+
+class Cylinder;
+class Sphere;
+class Vector;
+
+/*!\class GeometryCache gcu/geometry-cache.h
+Gives access to Sphere and Cylinder instances shared by all documents
+and views using the same GL context, so that display lists are compiled only
+once. The objects are associated with the current GLX context, so that each
+context has its own ones from its creation. Code using other kinds of GL
+contexts, such as OSMesa ones, must call SetCurrentContext() each time it makes
+a context current. ReleaseContext() must be called before destroying any
+context.
+
+An instance is meant to be created on the stack each time a frame is drawn. It
+reads the current projection and uses it to select a cheaper mesh for objects
+which appear small on screen. GLBatch keeps a copy of the instance used when
+the batch was built, and selects its meshes through the same levels.
+*/
+class GeometryCache
+{
+public:
+/*!
+Reads the current GL matrices and viewport. The GL context must be current.
+*/
+	GeometryCache ();
+/*!
+The destructor.
+*/
+	~GeometryCache ();
+
+/*!
+@param center the center of the sphere as passed to Sphere::draw().
+@param radius the radius of the sphere.
+@return a shared sphere with a level of detail adapted to the projected size.
+*/
+	Sphere const &GetSphere (Vector const &center, double radius) const;
+/*!
+@param end1 the first end of the cylinder.
+@param end2 the second end of the cylinder.
+@param radius the radius of the cylinder.
+@return a shared cylinder with a number of faces adapted to the projected size.
+*/
+	Cylinder const &GetCylinder (Vector const &end1, Vector const &end2, double radius) const;
+/*!
+@param center the center of the sphere.
+@param radius the radius of the sphere.
+@param any_orientation whether the model might be rotated around the origin
+before \a center is drawn.
+@return the level of detail adapted to the projected size, from 0 for the
+coarsest mesh to SphereLevels - 1 for the finest. When \a any_orientation is
+true, the nearest position the sphere can reach is used.
+*/
+	unsigned GetSphereLevel (Vector const &center, double radius, bool any_orientation = false) const;
+/*!
+@param end1 the first end of the cylinder.
+@param end2 the second end of the cylinder.
+@param radius the radius of the cylinder.
+@param any_orientation whether the model might be rotated around the origin
+before the cylinder is drawn.
+@return the level of detail adapted to the projected size, from 0 for the
+coarsest mesh to CylinderLevels - 1 for the finest.
+*/
+	unsigned GetCylinderLevel (Vector const &end1, Vector const &end2, double radius, bool any_orientation = false) const;
+/*!
+@param cache another instance.
+@return true if both instances give the same projected sizes within a few
+percents, so that a batch built for one of them can be used with the other.
+*/
+	bool IsCloseTo (GeometryCache const &cache) const;
+
+/*!
+The number of levels of detail used for spheres.
+*/
+	static unsigned const SphereLevels = 4;
+/*!
+The number of levels of detail used for cylinders.
+*/
+	static unsigned const CylinderLevels = 3;
+
+/*!
+@param detail the level of detail, see Sphere::setup().
+@return the shared sphere for the current context.
+*/
+	static Sphere const &GetSphere (int detail);
+/*!
+@param faces the number of faces, see Cylinder::setup().
+@return the shared cylinder for the current context.
+*/
+	static Cylinder const &GetCylinder (int faces);
+/*!
+@param context an opaque pointer identifying the GL context which just became
+current. This is needed only for contexts which are not GLX contexts.
+*/
+	static void SetCurrentContext (void const *context);
+/*!
+@return the current GLX context if any, or the context set by the last call to
+SetCurrentContext().
+*/
+	static void const *GetCurrentContext ();
+/*!
+@param context a GL context about to be destroyed.
+@param current whether \a context is the current GL context.
+
+Deletes all cached objects associated with \a context, including the buffers
+used by GLBatch instances. This must be called just before destroying the
+context, while it is still current. If it could not be made current, the GL
+objects are just forgotten and will be freed with the context.
+*/
+	static void ReleaseContext (void const *context, bool current = true);
+
+private:
+	double ProjectedSize (Vector const &v, double size, bool any_orientation) const;
+	double OriginDepth () const;
+
+private:
+	double m_ModelView[16];
+	double m_Projection[16];
+	double m_ModelScale; // global scaling included in the model view matrix
+	double m_Scale; // pixels per unit at unit depth, <= 0 if unknown
+};
+
+}	//	namespace gcu
+
+#endif	//	GCU_GEOMETRY_CACHE_H
@@ -0,0 +1,365 @@
+// -*- C++ -*-
+
+/*
+ * Gnome Chemistry Utils
+ * libs/gcu/glbatch.cc
+ *
+ * Copyright (C) 2026 Jean Bréfort <jean.brefort@normalesup.org>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301
+ * USA
+ */
+
+#include "config.h"
+#define GL_GLEXT_PROTOTYPES
+#include "glbatch.h"
+#include "geometry-cache.h"
+#include "matrix.h"
+#include "vector.h"
+#include <GL/gl.h>
+#include <GL/glext.h>
+#include <glib.h>
+#include <cmath>
+#include <cstdio>
+#include <set>
+
+namespace gcu
+{
+
+static std::set < GLBatch * > Batches;
+// buffer objects of destroyed batches, deleted when their context is current
+static std::map < void const *, std::vector < GLuint > > Orphans;
+
+// meshes for each level of detail, from the coarsest to the finest, see
+// GeometryCache::GetSphereLevel() and GeometryCache::GetCylinderLevel()
+static unsigned const SphereStacks[GeometryCache::SphereLevels] = {4, 6, 10, 16};
+static unsigned const SphereSlices[GeometryCache::SphereLevels] = {6, 10, 16, 24};
+static unsigned const CylinderFaces[GeometryCache::CylinderLevels] = {4, 6, 12};
+// number of objects above which the finest levels are not used anymore
+static unsigned const SphereLimits[GeometryCache::SphereLevels - 1] = {30000, 10000, 5000};
+static unsigned const CylinderLimits[GeometryCache::CylinderLevels - 1] = {60000, 20000};
+
+class UnitSphere
+{
+public:
+	UnitSphere (unsigned stacks, unsigned slices);
+
+	std::vector < float > vertices; // x, y, z for each vertex
+	std::vector < unsigned > indices;
+};
+
+UnitSphere::UnitSphere (unsigned stacks, unsigned slices)
+{
+	unsigned j, k;
+	for (j = 0; j <= stacks; j++) {
+		double theta = M_PI * j / stacks;
+		for (k = 0; k <= slices; k++) {
+			double phi = 2. * M_PI * k / slices;
+			vertices.push_back (sin (theta) * cos (phi));
+			vertices.push_back (sin (theta) * sin (phi));
+			vertices.push_back (cos (theta));
+		}
+	}
+	// counterclockwise triangles when seen from outside
+	for (j = 0; j < stacks; j++)
+		for (k = 0; k < slices; k++) {
+			unsigned tl = j * (slices + 1) + k, bl = tl + slices + 1;
+			indices.push_back (tl);
+			indices.push_back (bl);
+			indices.push_back (bl + 1);
+			indices.push_back (tl);
+			indices.push_back (bl + 1);
+			indices.push_back (tl + 1);
+		}
+}
+
+static UnitSphere const &GetUnitSphere (unsigned level)
+{
+	static UnitSphere const *spheres[GeometryCache::SphereLevels] = {NULL};
+	if (!spheres[level])
+		spheres[level] = new UnitSphere (SphereStacks[level], SphereSlices[level]);
+	return *spheres[level];
+}
+
+GLBatch::GLBatch ():
+	m_Projection (NULL),
+	m_Generation (1)
+{
+	Batches.insert (this);
+	Reserve (0, 0);
+}
+
+GLBatch::~GLBatch ()
+{
+	// the contexts might not be current, so delete the buffers later
+	std::map < void const *, Buffers >::iterator i, end = m_Buffers.end ();
+	for (i = m_Buffers.begin (); i != end; i++)
+		if ((*i).second.vertices) {
+			std::vector < GLuint > &ids = Orphans[(*i).first];
+			ids.push_back ((*i).second.vertices);
+			ids.push_back ((*i).second.colors);
+			ids.push_back ((*i).second.indices);
+		}
+	Batches.erase (this);
+	delete m_Projection;
+}
+
+void GLBatch::Clear ()
+{
+	m_Vertices.clear ();
+	m_Colors.clear ();
+	m_Indices.clear ();
+	m_Generation++;
+}
+
+void GLBatch::Reserve (unsigned spheres, unsigned cylinders)
+{
+	m_MaxSphereLevel = GeometryCache::SphereLevels - 1;
+	while (m_MaxSphereLevel > 0 && spheres > SphereLimits[m_MaxSphereLevel - 1])
+		m_MaxSphereLevel--;
+	m_MaxCylinderLevel = GeometryCache::CylinderLevels - 1;
+	while (m_MaxCylinderLevel > 0 && cylinders > CylinderLimits[m_MaxCylinderLevel - 1])
+		m_MaxCylinderLevel--;
+	// reserve for the finest mesh allowed, this is an upper bound
+	UnitSphere const &sphere = GetUnitSphere (m_MaxSphereLevel);
+	unsigned faces = CylinderFaces[m_MaxCylinderLevel];
+	unsigned nb = spheres * sphere.vertices.size () / 3 + cylinders * 2 * (faces + 1);
+	m_Vertices.reserve (6 * nb);
+	m_Colors.reserve (4 * nb);
+	m_Indices.reserve (spheres * sphere.indices.size () + cylinders * 6 * faces);
+}
+
+void GLBatch::SetProjection (GeometryCache const &cache)
+{
+	delete m_Projection;
+	m_Projection = new GeometryCache (cache);
+}
+
+bool GLBatch::IsValid (GeometryCache const &cache) const
+{
+	return !m_Indices.empty () && m_Projection && m_Projection->IsCloseTo (cache);
+}
+
+void GLBatch::AddColor (unsigned char *color, double red, double green, double blue, double alpha)
+{
+	color[0] = static_cast < unsigned char > (CLAMP (red, 0., 1.) * 255. + .5);
+	color[1] = static_cast < unsigned char > (CLAMP (green, 0., 1.) * 255. + .5);
+	color[2] = static_cast < unsigned char > (CLAMP (blue, 0., 1.) * 255. + .5);
+	color[3] = static_cast < unsigned char > (CLAMP (alpha, 0., 1.) * 255. + .5);
+}
+
+void GLBatch::AddVertex (Vector const &v, Vector const &n, unsigned char const *color)
+{
+	m_Vertices.push_back (v.GetX ());
+	m_Vertices.push_back (v.GetY ());
+	m_Vertices.push_back (v.GetZ ());
+	m_Vertices.push_back (n.GetX ());
+	m_Vertices.push_back (n.GetY ());
+	m_Vertices.push_back (n.GetZ ());
+	m_Colors.insert (m_Colors.end (), color, color + 4);
+}
+
+void GLBatch::AddSphere (Vector const &center, double radius, double red, double green, double blue, double alpha)
+{
+	unsigned char color[4];
+	AddColor (color, red, green, blue, alpha);
+	unsigned level = m_MaxSphereLevel;
+	if (m_Projection)
+		level = MIN (level, m_Projection->GetSphereLevel (center, radius, true));
+	UnitSphere const &sphere = GetUnitSphere (level);
+	unsigned first = m_Vertices.size () / 6, i, max = sphere.vertices.size ();
+	for (i = 0; i < max; i += 3) {
+		Vector n (sphere.vertices[i], sphere.vertices[i + 1], sphere.vertices[i + 2]);
+		AddVertex (center + n * radius, n, color);
+	}
+	max = sphere.indices.size ();
+	for (i = 0; i < max; i++)
+		m_Indices.push_back (first + sphere.indices[i]);
+	m_Generation++;
+}
+
+void GLBatch::AddCylinder (Vector const &end1, Vector const &end2, double radius, double red, double green, double blue, double alpha)
+{
+	unsigned char color[4];
+	AddColor (color, red, green, blue, alpha);
+	unsigned level = m_MaxCylinderLevel;
+	if (m_Projection)
+		level = MIN (level, m_Projection->GetCylinderLevel (end1, end2, radius, true));
+	AddCylinder (end1, end2, radius, level, color);
+}
+
+void GLBatch::AddCylinder (Vector const &end1, Vector const &end2, double radius, unsigned level, unsigned char const *color)
+{
+	Vector axis = end2 - end1;
+	double length = axis.GetLength ();
+	if (length == 0.)
+		return;
+	axis /= length;
+	Vector ortho1 = axis.CreateOrthogonal ();
+	ortho1 /= ortho1.GetLength ();
+	Vector ortho2 = axis.Cross (ortho1);
+	unsigned faces = CylinderFaces[level], first = m_Vertices.size () / 6, i;
+	for (i = 0; i <= faces; i++) {
+		double angle = 2. * M_PI * i / faces;
+		Vector n = ortho1 * cos (angle) + ortho2 * sin (angle);
+		AddVertex (end1 + n * radius, n, color);
+		AddVertex (end2 + n * radius, n, color);
+	}
+	// counterclockwise triangles when seen from outside
+	for (i = 0; i < faces; i++) {
+		unsigned bottom = first + 2 * i, top = bottom + 1;
+		m_Indices.push_back (top);
+		m_Indices.push_back (bottom);
+		m_Indices.push_back (bottom + 2);
+		m_Indices.push_back (top);
+		m_Indices.push_back (bottom + 2);
+		m_Indices.push_back (top + 2);
+	}
+	m_Generation++;
+}
+
+void GLBatch::AddCylinders (Vector const &end1, Vector const &end2, double radius, int order, double shift, Vector const &normal, double red, double green, double blue, double alpha)
+{
+	if (order <= 1) {
+		AddCylinder (end1, end2, radius, red, green, blue, alpha);
+		return;
+	}
+	// use the same geometry as Cylinder::drawMulti()
+	Vector axis = end2 - end1;
+	double length = axis.GetLength ();
+	if (length == 0.)
+		return;
+	axis /= length;
+	Vector ortho1 = axis.Cross (normal);
+	double norm = ortho1.GetLength ();
+	if (norm > 0.001)
+		ortho1 /= norm;
+	else {
+		ortho1 = axis.CreateOrthogonal ();
+		ortho1 /= ortho1.GetLength ();
+	}
+	Vector ortho2 = axis.Cross (ortho1);
+	unsigned char color[4];
+	AddColor (color, red, green, blue, alpha);
+	unsigned level = m_MaxCylinderLevel;
+	if (m_Projection)
+		level = MIN (level, m_Projection->GetCylinderLevel (end1, end2, radius, true));
+	double angleOffset = (order == 3)? M_PI / 2.: ((order > 3)? M_PI / 8.: 0.);
+	for (int i = 0; i < order; i++) {
+		double angle = angleOffset + 2. * M_PI * i / order;
+		Vector offset = (ortho1 * cos (angle) + ortho2 * sin (angle)) * shift;
+		AddCylinder (end1 + offset, end2 + offset, radius, level, color);
+	}
+}
+
+void GLBatch::Draw (Matrix const &m)
+{
+	if (m_Indices.empty ())
+		return;
+	// the GL matrix equivalent to Matrix::glmult()
+	GLdouble gm[16];
+	Vector e[3] = {Vector (1., 0., 0.), Vector (0., 1., 0.), Vector (0., 0., 1.)};
+	for (unsigned i = 0; i < 3; i++) {
+		Vector c = m.glmult (e[i]);
+		gm[4 * i] = c.GetX ();
+		gm[4 * i + 1] = c.GetY ();
+		gm[4 * i + 2] = c.GetZ ();
+		gm[4 * i + 3] = 0.;
+	}
+	gm[12] = gm[13] = gm[14] = 0.;
+	gm[15] = 1.;
+
+	void const *context = GeometryCache::GetCurrentContext ();
+	std::map < void const *, std::vector < GLuint > >::iterator orphans = Orphans.find (context);
+	if (orphans != Orphans.end ()) {
+		glDeleteBuffers ((*orphans).second.size (), &(*orphans).second[0]);
+		Orphans.erase (orphans);
+	}
+	Buffers &buffers = m_Buffers[context];
+	if (!buffers.checked) {
+		int major = 1, minor = 0;
+		char const *version = reinterpret_cast < char const * > (glGetString (GL_VERSION));
+		if (version)
+			sscanf (version, "%d.%d", &major, &minor);
+		buffers.use_buffers = major > 1 || minor >= 5;
+		buffers.checked = true;
+	}
+
+	glPushMatrix ();
+	glMultMatrixd (gm);
+	glEnableClientState (GL_VERTEX_ARRAY);
+	glEnableClientState (GL_NORMAL_ARRAY);
+	glEnableClientState (GL_COLOR_ARRAY);
+	if (buffers.use_buffers) {
+		if (!buffers.vertices) {
+			GLuint ids[3];
+			glGenBuffers (3, ids);
+			buffers.vertices = ids[0];
+			buffers.colors = ids[1];
+			buffers.indices = ids[2];
+		}
+		glBindBuffer (GL_ARRAY_BUFFER, buffers.vertices);
+		if (buffers.generation != m_Generation)
+			glBufferData (GL_ARRAY_BUFFER, m_Vertices.size () * sizeof (float), &m_Vertices[0], GL_STATIC_DRAW);
+		glVertexPointer (3, GL_FLOAT, 6 * sizeof (float), NULL);
+		glNormalPointer (GL_FLOAT, 6 * sizeof (float), reinterpret_cast < GLvoid const * > (3 * sizeof (float)));
+		glBindBuffer (GL_ARRAY_BUFFER, buffers.colors);
+		if (buffers.generation != m_Generation)
+			glBufferData (GL_ARRAY_BUFFER, m_Colors.size (), &m_Colors[0], GL_STATIC_DRAW);
+		glColorPointer (4, GL_UNSIGNED_BYTE, 0, NULL);
+		glBindBuffer (GL_ELEMENT_ARRAY_BUFFER, buffers.indices);
+		if (buffers.generation != m_Generation)
+			glBufferData (GL_ELEMENT_ARRAY_BUFFER, m_Indices.size () * sizeof (unsigned), &m_Indices[0], GL_STATIC_DRAW);
+		buffers.generation = m_Generation;
+		glDrawElements (GL_TRIANGLES, m_Indices.size (), GL_UNSIGNED_INT, NULL);
+		glBindBuffer (GL_ELEMENT_ARRAY_BUFFER, 0);
+		glBindBuffer (GL_ARRAY_BUFFER, 0);
+	} else {
+		glVertexPointer (3, GL_FLOAT, 6 * sizeof (float), &m_Vertices[0]);
+		glNormalPointer (GL_FLOAT, 6 * sizeof (float), &m_Vertices[3]);
+		glColorPointer (4, GL_UNSIGNED_BYTE, 0, &m_Colors[0]);
+		glDrawElements (GL_TRIANGLES, m_Indices.size (), GL_UNSIGNED_INT, &m_Indices[0]);
+	}
+	glDisableClientState (GL_COLOR_ARRAY);
+	glDisableClientState (GL_NORMAL_ARRAY);
+	glDisableClientState (GL_VERTEX_ARRAY);
+	glPopMatrix ();
+}
+
+void GLBatch::ReleaseContext (void const *context, bool current)
+{
+	std::vector < GLuint > ids;
+	std::map < void const *, std::vector < GLuint > >::iterator orphans = Orphans.find (context);
+	if (orphans != Orphans.end ()) {
+		ids.swap ((*orphans).second);
+		Orphans.erase (orphans);
+	}
+	std::set < GLBatch * >::iterator i, end = Batches.end ();
+	for (i = Batches.begin (); i != end; i++) {
+		std::map < void const *, Buffers >::iterator j = (*i)->m_Buffers.find (context);
+		if (j == (*i)->m_Buffers.end ())
+			continue;
+		if ((*j).second.vertices) {
+			ids.push_back ((*j).second.vertices);
+			ids.push_back ((*j).second.colors);
+			ids.push_back ((*j).second.indices);
+		}
+		(*i)->m_Buffers.erase (j);
+	}
+	if (current && !ids.empty ())
+		glDeleteBuffers (ids.size (), &ids[0]);
+}
+
+}	//	namespace gcu
@@ -0,0 +1,180 @@
+// -*- C++ -*-
+
+/*
+ * Gnome Chemistry Utils
+ * gcu/glbatch.h
+ *
+ * Copyright (C) 2026 Jean Bréfort <jean.brefort@normalesup.org>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301
+ * USA
+ */
+
+#ifndef GCU_GL_BATCH_H
+#define GCU_GL_BATCH_H
+
+#include <map>
+#include <vector>
+
+/*!\file*/
+namespace gcu
+{
+
+class GeometryCache;
+class Matrix;
+class Vector;
+
+/*!\class GLBatch gcu/glbatch.h
+Packs the spheres and cylinders representing a whole model into a single set
+of vertex, normal, color and index arrays, which are uploaded once to vertex
+buffer objects for each GL context and drawn with a single glDrawElements()
+call. Rotating the model only changes the model view matrix, so the arrays
+need to be rebuilt only when the model itself or the projection changes.
+
+The mesh used for each object is selected through the levels of detail of
+the GeometryCache passed to SetProjection(), so that objects which appear small
+on screen use a cheaper mesh, as when they are drawn one by one. Large models
+also get a coarser maximum resolution to keep the arrays size reasonable.
+
+When vertex buffer objects are not available (OpenGL older than 1.5), the
+arrays are used as client side vertex arrays.
+*/
+class GLBatch
+{
+public:
+/*!
+The default constructor.
+*/
+	GLBatch ();
+/*!
+The destructor.
+*/
+	~GLBatch ();
+
+/*!
+Removes all geometry from the batch.
+*/
+	void Clear ();
+/*!
+@return true if the batch does not contain anything.
+*/
+	bool IsEmpty () const {return m_Indices.empty ();}
+/*!
+@param spheres the number of spheres which will be added.
+@param cylinders the number of cylinders which will be added.
+
+Reserves memory and selects the maximum mesh resolution so that the arrays
+size stay reasonable for large models. Should be called after Clear() and
+before adding anything.
+*/
+	void Reserve (unsigned spheres, unsigned cylinders);
+/*!
+@param cache the GeometryCache for the frame being drawn.
+
+Sets the projection used to select the level of detail of the objects added
+afterwards. The model might be rotated without rebuilding the batch, so the
+largest size an object can have on screen is used.
+*/
+	void SetProjection (GeometryCache const &cache);
+/*!
+@param cache the GeometryCache for the frame being drawn.
+@return true if the batch is not empty and has been built for a projection
+close enough to the one of \a cache.
+*/
+	bool IsValid (GeometryCache const &cache) const;
+/*!
+@param center the center of the sphere.
+@param radius the radius of the sphere.
+@param red the red component of the sphere color.
+@param green the green component of the sphere color.
+@param blue the blue component of the sphere color.
+@param alpha the alpha component of the sphere color.
+
+Adds a sphere to the batch. Coordinates are given as they would be before
+Matrix::glmult() is applied.
+*/
+	void AddSphere (Vector const &center, double radius, double red, double green, double blue, double alpha = 1.);
+/*!
+@param end1 the center of the first end of the cylinder.
+@param end2 the center of the second end of the cylinder.
+@param radius the radius of the cylinder.
+@param red the red component of the cylinder color.
+@param green the green component of the cylinder color.
+@param blue the blue component of the cylinder color.
+@param alpha the alpha component of the cylinder color.
+
+Adds a cylinder to the batch.
+*/
+	void AddCylinder (Vector const &end1, Vector const &end2, double radius, double red, double green, double blue, double alpha = 1.);
+/*!
+@param end1 the center of the first end of the cylinders.
+@param end2 the center of the second end of the cylinders.
+@param radius the radius of each cylinder.
+@param order the number of cylinders.
+@param shift the distance between each cylinder axis and the (end1, end2) axis.
+@param normal the normal to the plane in which the cylinders should lie.
+@param red the red component of the cylinders color.
+@param green the green component of the cylinders color.
+@param blue the blue component of the cylinders color.
+@param alpha the alpha component of the cylinders color.
+
+Adds \a order parallel cylinders, as Cylinder::drawMulti() does.
+*/
+	void AddCylinders (Vector const &end1, Vector const &end2, double radius, int order, double shift, Vector const &normal, double red, double green, double blue, double alpha = 1.);
+/*!
+@param m the Matrix giving the current model orientation.
+
+Draws the batch using the current GL context, uploading the arrays first if
+needed.
+*/
+	void Draw (Matrix const &m);
+
+/*!
+@param context a GL context about to be destroyed.
+@param current whether \a context is the current GL context.
+
+Deletes the buffer objects allocated for \a context by all batches, including
+destroyed ones, or just forgets them if \a context is not current. This is
+called by GeometryCache::ReleaseContext().
+*/
+	static void ReleaseContext (void const *context, bool current);
+
+private:
+	void AddVertex (Vector const &v, Vector const &n, unsigned char const *color);
+	void AddColor (unsigned char *color, double red, double green, double blue, double alpha);
+	void AddCylinder (Vector const &end1, Vector const &end2, double radius, unsigned level, unsigned char const *color);
+
+private:
+	class Buffers
+	{
+	public:
+		Buffers (): vertices (0), colors (0), indices (0), generation (0), checked (false), use_buffers (false) {}
+		unsigned vertices, colors, indices;
+		unsigned generation;
+		bool checked, use_buffers;
+	};
+
+	std::vector < float > m_Vertices; // x, y, z, nx, ny, nz for each vertex
+	std::vector < unsigned char > m_Colors; // r, g, b, a for each vertex
+	std::vector < unsigned > m_Indices;
+	unsigned m_MaxSphereLevel, m_MaxCylinderLevel;
+	GeometryCache *m_Projection;
+	unsigned m_Generation;
+	std::map < void const *, Buffers > m_Buffers;
+};
+
+}	//	namespace gcu
+
+#endif	//	GCU_GL_BATCH_H
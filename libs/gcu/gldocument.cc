@@ -24,6 +24,7 @@
 
 #include "config.h"
 #include <gcu/gldocument.h>
+#include <gcu/glbatch.h>
 
 namespace gcu
 {
@@ -31,10 +32,13 @@ namespace gcu
 GLDocument::GLDocument (Application *App): Document (App)
 {
 	m_MaxDist = 0;
+	m_Batch = new GLBatch ();
+	m_BatchRendering = true;
 }
 
 GLDocument::~GLDocument ()
 {
+	delete m_Batch;
 }
 
 }	//	namespace gcu
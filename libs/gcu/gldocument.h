@@ -32,6 +32,7 @@
 namespace gcu
 {
 
+class GLBatch;
 class GLView;
 class Matrix;
 
@@ -60,6 +61,14 @@ Called by GLView::Update to render the model.
 */
 	virtual void Draw (Matrix const &m) const = 0;
 
+protected:
+/*!
+The GLBatch used to render the document when batch rendering is enabled.
+Derived classes must fill it when it is empty and clear it each time the
+rendered content changes.
+*/
+	GLBatch *m_Batch;
+
 // Properties
 /*!\var m_MaxDist
 The longest distance between any object and the center of the model.
@@ -75,6 +84,18 @@ The associated GLView instance.
 @return the associated GLView instance.
 */
 GCU_PROT_PROP (GLView*, View);
+/*!\fn SetBatchRendering(bool batch)
+@param batch whether to use a GLBatch to render the document.
+
+Enables or disables batch rendering, default is enabled.
+*/
+/*!\fn GetBatchRendering()
+@return true if the document uses a GLBatch for rendering.
+*/
+/*!\fn GetRefBatchRendering()
+@return the current batch rendering mode as a reference.
+*/
+GCU_PROP (bool, BatchRendering)
 };
 
 };	//	namespace gcu
@@ -0,0 +1,138 @@
+// -*- C++ -*-
+
+/*
+ * Gnome Chemistry Utils
+ * gcu/input.cc
+ *
+ * Copyright (C) 2026 Jean Bréfort <jean.brefort@normalesup.org>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301
+ * USA
+ */
+
+#include "config.h"
+#include "input.h"
+#include <gsf/gsf-input-gio.h>
+#include <gsf/gsf-input-memory.h>
+#include <glib.h>
+#include <cstring>
+
+#define CHUNK_SIZE 0x10000
+
+namespace gcu {
+
+GsfInput *OpenInput (char const *uri, bool map, GError **error)
+{
+	if (map) {
+		char *filename = g_filename_from_uri (uri, NULL, NULL);
+		if (filename) {
+			// gsf_input_mmap_new falls back to reading the file if mmap is not available
+			GsfInput *input = gsf_input_mmap_new (filename, NULL);
+			g_free (filename);
+			if (input)
+				return input;
+		}
+	}
+	return gsf_input_gio_new_for_uri (uri, error);
+}
+
+char const *GetInputData (GsfInput *input, gsf_off_t &size)
+{
+	size = gsf_input_remaining (input);
+	if (size <= 0) {
+		size = 0;
+		return NULL;
+	}
+	return reinterpret_cast <char const *> (gsf_input_read (input, size, NULL));
+}
+
+LineReader::LineReader (GsfInput *input):
+	m_Input (input),
+	m_Cur (NULL),
+	m_End (NULL),
+	m_Line (NULL),
+	m_Length (0),
+	m_Size (0),
+	m_LineNumber (0),
+	m_SkipLF (false)
+{
+}
+
+LineReader::~LineReader ()
+{
+	g_free (m_Line);
+}
+
+bool LineReader::Fill ()
+{
+	gsf_off_t remaining = gsf_input_remaining (m_Input);
+	if (remaining <= 0)
+		return false;
+	// memory based inputs do not copy anything, so take everything at once
+	size_t n = (GSF_IS_INPUT_MEMORY (m_Input) || remaining < CHUNK_SIZE)? remaining: CHUNK_SIZE;
+	m_Cur = reinterpret_cast <char const *> (gsf_input_read (m_Input, n, NULL));
+	if (!m_Cur) {
+		m_End = NULL;
+		return false;
+	}
+	m_End = m_Cur + n;
+	return true;
+}
+
+void LineReader::Append (char const *data, size_t length)
+{
+	if (m_Length + length + 1 > m_Size) {
+		m_Size = MAX (MAX (2 * m_Size, m_Length + length + 1), 256);
+		m_Line = reinterpret_cast <char *> (g_realloc (m_Line, m_Size));
+	}
+	memcpy (m_Line + m_Length, data, length);
+	m_Length += length;
+	m_Line[m_Length] = 0;
+}
+
+char *LineReader::GetLine ()
+{
+	bool found = false;
+	m_Length = 0;
+	while (m_Cur < m_End || Fill ()) {
+		if (m_SkipLF) {
+			// the previous line ended with "\r", skip the "\n" if any
+			m_SkipLF = false;
+			if (*m_Cur == '\n') {
+				m_Cur++;
+				continue;
+			}
+		}
+		found = true;
+		char const *eol = m_Cur;
+		while (eol < m_End && *eol != '\n' && *eol != '\r')
+			eol++;
+		Append (m_Cur, eol - m_Cur);
+		if (eol < m_End) {
+			m_SkipLF = *eol == '\r';
+			m_Cur = eol + 1;
+			m_LineNumber++;
+			return m_Line;
+		}
+		// the line continues in the next chunk
+		m_Cur = m_End;
+	}
+	if (!found)
+		return NULL;
+	m_LineNumber++;
+	return m_Line;
+}
+
+}	//	namespace gcu
@@ -0,0 +1,107 @@
+// -*- C++ -*-
+
+/*
+ * Gnome Chemistry Utils
+ * gcu/input.h
+ *
+ * Copyright (C) 2026 Jean Bréfort <jean.brefort@normalesup.org>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301
+ * USA
+ */
+
+#ifndef GCU_INPUT_H
+#define GCU_INPUT_H
+
+#include <gsf/gsf-input.h>
+#include <cstddef>
+
+namespace gcu {
+
+/*!\file
+Some helper functions to read files through GsfInput without copying them.
+*/
+
+/*!
+@param uri the uri of the file to open.
+@param map whether local files should be memory mapped.
+@param error where to store the error if any.
+
+Opens a file for reading. When \a map is true and \a uri is a local file, the
+file is memory mapped and the returned GsfInput is memory based, so that
+GetInputData() and LineReader can access its contents without any copy. Other
+files are opened through GIO.
+@return the new GsfInput or NULL on error.
+*/
+GsfInput *OpenInput (char const *uri, bool map, GError **error);
+
+/*!
+@param input a GsfInput.
+@param size where to store the data size.
+
+Gets the remaining contents of \a input as a contiguous read-only buffer. When
+\a input is memory based, as those returned by OpenInput() for local files,
+the buffer is the mapped file itself, otherwise the data are read into an
+internal buffer of \a input. The buffer is owned by \a input, remains valid
+until the next read, and is not null terminated.
+@return the data or NULL if there is nothing to read.
+*/
+char const *GetInputData (GsfInput *input, gsf_off_t &size);
+
+/*!\class LineReader gcu/input.h
+Reads a GsfInput line by line. Memory based inputs are scanned in place, and
+other inputs are read by chunks, so that only the current line is ever copied.
+Lines might end with "\n", "\r\n" or "\r".
+*/
+class LineReader
+{
+public:
+/*!
+@param input the GsfInput to read, which must stay alive as long as the reader.
+*/
+	LineReader (GsfInput *input);
+/*!
+The destructor.
+*/
+	~LineReader ();
+
+/*!
+Reads the next line.
+@return the line, without its end of line characters, or NULL at the end of
+the input. The returned buffer is owned by the reader and is overwritten by
+the next call, but callers may modify it.
+*/
+	char *GetLine ();
+/*!
+@return the number of lines read so far.
+*/
+	unsigned GetLineNumber () const {return m_LineNumber;}
+
+private:
+	bool Fill ();
+	void Append (char const *data, size_t length);
+
+private:
+	GsfInput *m_Input;
+	char const *m_Cur, *m_End;
+	char *m_Line;
+	size_t m_Length, m_Size;
+	unsigned m_LineNumber;
+	bool m_SkipLF;
+};
+
+}	//	namespace gcu
+
+#endif	//	GCU_INPUT_H
@@ -0,0 +1,550 @@
+// -*- C++ -*-
+
+/*
+ * Gnome Chemistry Utils
+ * gcu/jcamp.cc
+ *
+ * Copyright (C) 2026 Jean Bréfort <jean.brefort@normalesup.org>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301
+ * USA
+ */
+
+#include "config.h"
+#include "jcamp.h"
+#include <goffice/goffice.h>
+#include <glib/gi18n-lib.h>
+#include <glib.h>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+
+#define JCAMP_PREC 1e-2 // fully arbitrary
+
+namespace gcu
+{
+
+static double const powers_of_ten[] = {
+	1., 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+	1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+};
+
+// mantissa holds the digits already read, as for SQZ and DIF forms
+static double parse_number (char const *&s, char const *end, guint64 mantissa)
+{
+	int digits = 0, decimals = -1, scale = 0;
+	for (; s < end; s++) {
+		if (*s >= '0' && *s <= '9') {
+			if (digits < 18) {
+				mantissa = mantissa * 10 + (*s - '0');
+				digits++;
+				if (decimals >= 0)
+					decimals++;
+			} else if (decimals < 0)
+				scale++;	// too many digits, just keep the magnitude
+		} else if (*s == '.' && decimals < 0)
+			decimals = 0;
+		else
+			break;
+	}
+	double res = mantissa;
+	if (scale > 0)
+		res *= (scale < 23)? powers_of_ten[scale]: pow (10., scale);
+	if (decimals > 0)
+		res /= powers_of_ten[decimals];
+	return res;
+}
+
+double JcampDecoder::ParseNumber (char const *&s, char const *end)
+{
+	return parse_number (s, end, 0);
+}
+
+JcampDecoder::JcampDecoder (double *x, double *y, unsigned npoints, double firstx, double lastx, double deltax, double xfactor, double yfactor, double firsty):
+	m_X (x), m_Y (y), m_NPoints (npoints), m_Read (0),
+	m_FirstX (firstx), m_LastX (lastx), m_DeltaX (deltax), m_XFactor (xfactor), m_YFactor (yfactor), m_FirstY (firsty),
+	m_Index (0), m_Previous (0), m_PreviousX (firstx), m_Check (false), m_Overflow (false),
+	m_Value (0.), m_Diff (0.), m_IsDiff (false)
+{
+}
+
+JcampDecoder::~JcampDecoder ()
+{
+}
+
+char const *JcampDecoder::Decode (char const *data, char const *end)
+{
+	char const *cur = data, *start;
+	char c;
+	bool pos;
+	while (cur < end) {
+		start = cur;
+		while (cur < end && (*cur == ' ' || *cur == '\t'))
+			cur++;
+		if (cur + 1 < end && cur[0] == '#' && cur[1] == '#')
+			return start;
+		// compressed sequences do not span several lines
+		m_Index = 0;
+		m_Check = false;
+		m_Value = m_Diff = 0.;
+		m_IsDiff = false;
+		pos = true;
+		while (cur < end && (c = *cur) != '\n') {
+			switch (c) {
+			case '$':
+				if (cur + 1 < end && cur[1] == '$') {
+					// a comment, skip to the end of the line
+					while (cur < end && *cur != '\n')
+						cur++;
+					continue;
+				}
+				g_warning (_("Invalid character in data block"));
+				cur++;
+				continue;
+			case '-':
+				pos = false;
+			case '+':
+				cur++;
+				continue;
+			case '.':
+			case '0':
+			case '1':
+			case '2':
+			case '3':
+			case '4':
+			case '5':
+			case '6':
+			case '7':
+			case '8':
+			case '9':
+				m_Value = ParseNumber (cur, end);
+				if (!pos)
+					m_Value = -m_Value;
+				m_IsDiff = false;
+				AddValue (m_Value);
+				pos = true;
+				continue;
+			case '@':
+			case 'A':
+			case 'B':
+			case 'C':
+			case 'D':
+			case 'E':
+			case 'F':
+			case 'G':
+			case 'H':
+			case 'I':
+				m_Value = parse_number (++cur, end, c - '@');
+				m_IsDiff = false;
+				AddValue (m_Value);
+				continue;
+			case 'a':
+			case 'b':
+			case 'c':
+			case 'd':
+			case 'e':
+			case 'f':
+			case 'g':
+			case 'h':
+			case 'i':
+				m_Value = - parse_number (++cur, end, c - 'a' + 1);
+				m_IsDiff = false;
+				AddValue (m_Value);
+				continue;
+			case '%':
+			case 'J':
+			case 'K':
+			case 'L':
+			case 'M':
+			case 'N':
+			case 'O':
+			case 'P':
+			case 'Q':
+			case 'R':
+				m_Diff = parse_number (++cur, end, (c == '%')? 0: c - 'I');
+				m_Value += m_Diff;
+				m_IsDiff = true;
+				AddValue (m_Value);
+				continue;
+			case 'j':
+			case 'k':
+			case 'l':
+			case 'm':
+			case 'n':
+			case 'o':
+			case 'p':
+			case 'q':
+			case 'r':
+				m_Diff = - parse_number (++cur, end, c - 'i');
+				m_Value += m_Diff;
+				m_IsDiff = true;
+				AddValue (m_Value);
+				continue;
+			case 'S':
+			case 'T':
+			case 'U':
+			case 'V':
+			case 'W':
+			case 'X':
+			case 'Y':
+			case 'Z':
+			case 's': {
+				// the count includes the value already stored
+				unsigned n = (unsigned) parse_number (++cur, end, (c == 's')? 9: c - 'R');
+				if (n > 1)
+					AddRepeats (n - 1);
+				continue;
+			}
+			case '?':
+				m_IsDiff = false;
+				m_Value = go_nan;
+				m_Diff = 0.;
+				AddValue (go_nan);
+				cur++;
+				continue;
+			case ',':
+				cur++;
+				continue;
+			default:
+				if (c > ' ')
+					g_warning (_("Invalid character in data block"));
+				cur++;
+				continue;
+			}
+		}
+		if (cur < end)
+			cur++;
+	}
+	return cur;
+}
+
+void JcampDecoder::AddRepeats (unsigned n)
+{
+	while (n--) {
+		if (m_IsDiff)
+			m_Value += m_Diff;
+		AddValue (m_Value);
+	}
+}
+
+void JcampDecoder::AddValue (double val)
+{
+	if (m_Index++ == 0) {
+		// this is the abscissa, check it
+		double x = val * m_XFactor;
+		if (m_Read == 0) {
+			if (!m_NPoints)
+				return;
+			m_X[0] = x;
+			if (fabs (x - m_FirstX) > fabs (m_DeltaX * JCAMP_PREC)) {
+				m_XFactor = m_FirstX / val;
+				m_DeltaX = (m_LastX - m_FirstX) / (m_NPoints - 1);
+				g_warning (_("Data check failed: FIRSTX!"));
+			}
+			return;
+		}
+		int n = m_Read - m_Previous - (int) round ((x - m_PreviousX) / m_DeltaX);
+		m_Previous = m_Read;
+		m_PreviousX = x;
+		if (n == 1) {
+			// the first ordinate is the last one of the previous line
+			m_Check = true;
+			m_Previous--;
+		} else if (n < 0) {
+			// missing values
+			for (; n < 0 && m_Read < m_NPoints; n++) {
+				m_X[m_Read] = m_FirstX + m_DeltaX * m_Read;
+				m_Y[m_Read++] = go_nan;
+			}
+			m_Previous = m_Read;
+		}
+		// FIXME: n > 1 means duplicate values, we should throw an exception
+		return;
+	}
+	if (m_Check) {
+		double y0 = val * m_YFactor;
+		m_Check = false;
+		if (fabs (y0 - m_Y[m_Read - 1]) > fmax (fabs (y0), fabs (m_Y[m_Read - 1])) * JCAMP_PREC)
+			g_warning (_("Data check failed!"));
+		return;
+	}
+	if (m_Read >= m_NPoints) {
+		if (!m_Overflow)
+			g_warning (_("Found too many data"));
+		m_Overflow = true;
+		return;
+	}
+	if (m_Read > 0)
+		m_X[m_Read] = m_FirstX + m_DeltaX * m_Read;
+	m_Y[m_Read] = val * m_YFactor;
+	if (m_Read == 0 && fabs (m_FirstY - m_Y[0]) > fmax (fabs (m_FirstY), fabs (m_Y[0])) * JCAMP_PREC)
+		g_warning (_("Data check failed: FIRSTY!"));
+	m_Read++;
+}
+
+JcampReader::JcampReader ():
+	m_NTuples (false)
+{
+}
+
+JcampReader::~JcampReader ()
+{
+}
+
+std::string JcampReader::NormalizeLabel (char const *label, char const *end)
+{
+	std::string res;
+	for (; label < end; label++)
+		switch (*label) {
+		case ' ':
+		case '\t':
+		case '-':
+		case '/':
+		case '_':
+			break;
+		default:
+			res += g_ascii_toupper (*label);
+		}
+	return res;
+}
+
+bool JcampReader::ReadLabel (char const *&cur, char const *end, std::string &label, std::string &value)
+{
+	char const *line, *eol, *eq, *start, *last;
+	while (cur < end) {
+		line = cur;
+		eol = reinterpret_cast <char const *> (memchr (cur, '\n', end - cur));
+		if (!eol)
+			eol = end;
+		cur = (eol < end)? eol + 1: end;
+		while (line < eol && g_ascii_isspace (*line))
+			line++;
+		if (eol - line < 2 || line[0] != '#' || line[1] != '#' ||
+		    !(eq = reinterpret_cast <char const *> (memchr (line + 2, '=', eol - line - 2))))
+			continue;
+		label = NormalizeLabel (line + 2, eq);
+		if (label.empty () || !label.compare (0, 2, "$$"))
+			continue;	// a comment
+		// the value ends at the end of the line or at a comment
+		start = eq + 1;
+		last = start;
+		while (last < eol && !(last[0] == '$' && last + 1 < eol && last[1] == '$'))
+			last++;
+		while (start < last && g_ascii_isspace (*start))
+			start++;
+		while (last > start && g_ascii_isspace (last[-1]))
+			last--;
+		value.assign (start, last);
+		return true;
+	}
+	return false;
+}
+
+std::string const &JcampReader::GetLabel (char const *label) const
+{
+	static std::string empty;
+	std::map <std::string, std::string>::const_iterator i = m_Labels.find (label);
+	return (i == m_Labels.end ())? empty: (*i).second;
+}
+
+double JcampReader::GetNumber (char const *label, double default_value) const
+{
+	std::string const &value = GetLabel (label);
+	if (value.empty ())
+		return default_value;
+	char *end;
+	double res = g_ascii_strtod (value.c_str (), &end);
+	return (end == value.c_str ())? default_value: res;
+}
+
+std::string JcampReader::GetTupleField (char const *label, int index) const
+{
+	std::string const &value = GetLabel (label);
+	size_t start = 0, next;
+	for (; index > 0 && start != std::string::npos; index--) {
+		next = value.find (',', start);
+		start = (next == std::string::npos)? next: next + 1;
+	}
+	if (index < 0 || start == std::string::npos)
+		return std::string ();
+	next = value.find (',', start);
+	std::string res = value.substr (start, (next == std::string::npos)? next: next - start);
+	size_t first = res.find_first_not_of (" \t"), last = res.find_last_not_of (" \t");
+	return (first == std::string::npos)? std::string (): res.substr (first, last - first + 1);
+}
+
+int JcampReader::GetTupleIndex (char symbol) const
+{
+	std::string const &symbols = GetLabel ("SYMBOL");
+	int index = 0;
+	for (size_t i = 0; i < symbols.length (); i++) {
+		if (symbols[i] == ',')
+			index++;
+		else if (g_ascii_toupper (symbols[i]) == symbol)
+			return index;
+	}
+	return -1;
+}
+
+std::string JcampReader::GetUnit (char symbol) const
+{
+	if (m_NTuples) {
+		int index = GetTupleIndex (symbol);
+		if (index >= 0)
+			return GetTupleField ("UNITS", index);
+	}
+	if (symbol == 'X')
+		return GetLabel ("XUNITS");
+	if (symbol == 'Y')
+		return GetLabel ("YUNITS");
+	return std::string ();
+}
+
+bool JcampReader::Load (char const *data, size_t length)
+{
+	char const *cur = data, *end = data + length;
+	std::string label, value;
+	m_Labels.clear ();
+	m_Values.clear ();
+	m_NTuples = false;
+	bool found = false;
+	while (ReadLabel (cur, end, label, value)) {
+		if (label == "END")
+			break;	// only the first block is read
+		if (label == "NTUPLES")
+			m_NTuples = true;
+		m_Labels[label] = value;
+		if (m_NTuples) {
+			if (label == "DATATABLE")
+				cur = ReadPage (cur, end, value, found);
+			continue;
+		}
+		if (found || cur >= end)
+			continue;
+		if (label == "XYDATA") {
+			if (value.find ("X++(Y..Y)") != std::string::npos) {
+				cur = ReadTable (cur, end, 'X', 'Y', GetNumber ("NPOINTS", 0.), GetNumber ("FIRSTX", go_nan),
+				                 GetNumber ("LASTX", go_nan), GetNumber ("XFACTOR", 1.), GetNumber ("YFACTOR", 1.),
+				                 GetNumber ("FIRSTY", go_nan));
+				found = true;
+			} else if (value.find ("XY..XY") != std::string::npos) {
+				cur = ReadPoints (cur, end, 2, GetNumber ("XFACTOR", 1.), GetNumber ("YFACTOR", 1.), GetX (), GetY ());
+				found = true;
+			}
+		} else if (label == "XYPOINTS" || label == "PEAKTABLE") {
+			// peak tables might have a width or a kernel after each pair
+			unsigned group = (value.find ("XYW") != std::string::npos || value.find ("XYM") != std::string::npos)? 3: 2;
+			cur = ReadPoints (cur, end, group, GetNumber ("XFACTOR", 1.), GetNumber ("YFACTOR", 1.), GetX (), GetY ());
+			found = true;
+		}
+	}
+	return found;
+}
+
+char const *JcampReader::ReadPage (char const *data, char const *end, std::string const &description, bool &found)
+{
+	// the description is something like "(X++(R..R)), XYDATA" or "(XY..XY), PEAKS"
+	size_t open = description.find ('(');
+	if (open == std::string::npos || open + 2 >= description.length ())
+		return data;
+	char xsymbol = g_ascii_toupper (description[open + 1]), ysymbol;
+	bool table = !description.compare (open + 2, 3, "++(");
+	if (table) {
+		if (open + 5 >= description.length ())
+			return data;
+		ysymbol = g_ascii_toupper (description[open + 5]);
+	} else
+		ysymbol = g_ascii_toupper (description[open + 2]);
+	int xindex = GetTupleIndex (xsymbol), yindex = GetTupleIndex (ysymbol);
+	if (xindex < 0 || yindex < 0 || xindex == yindex) {
+		g_warning (_("Invalid data table"));
+		return data;
+	}
+	double xfactor = g_ascii_strtod (GetTupleField ("FACTOR", xindex).c_str (), NULL);
+	double yfactor = g_ascii_strtod (GetTupleField ("FACTOR", yindex).c_str (), NULL);
+	if (xfactor == 0.)
+		xfactor = 1.;
+	if (yfactor == 0.)
+		yfactor = 1.;
+	if (!table) {
+		std::vector <double> &x = m_Values[xsymbol], &y = m_Values[ysymbol];
+		x.clear ();
+		y.clear ();
+		data = ReadPoints (data, end, 2, xfactor, yfactor, x, y);
+		found = found || !y.empty ();
+		return data;
+	}
+	std::string first = GetTupleField ("FIRST", yindex);
+	data = ReadTable (data, end, xsymbol, ysymbol, strtoul (GetTupleField ("VARDIM", yindex).c_str (), NULL, 10),
+	                  g_ascii_strtod (GetTupleField ("FIRST", xindex).c_str (), NULL),
+	                  g_ascii_strtod (GetTupleField ("LAST", xindex).c_str (), NULL),
+	                  xfactor, yfactor, first.empty ()? go_nan: g_ascii_strtod (first.c_str (), NULL));
+	found = found || !m_Values[ysymbol].empty ();
+	return data;
+}
+
+char const *JcampReader::ReadTable (char const *data, char const *end, char xsymbol, char ysymbol, unsigned npoints, double firstx, double lastx, double xfactor, double yfactor, double firsty)
+{
+	if (npoints < 2 || !go_finite (firstx) || !go_finite (lastx)) {
+		g_warning (_("Invalid data table"));
+		return data;
+	}
+	std::vector <double> &x = m_Values[xsymbol], &y = m_Values[ysymbol];
+	x.resize (npoints);
+	y.resize (npoints);
+	JcampDecoder decoder (&x[0], &y[0], npoints, firstx, lastx, (lastx - firstx) / (npoints - 1), xfactor, yfactor, firsty);
+	char const *next = decoder.Decode (data, end);
+	unsigned read = decoder.GetRead ();
+	if (read < npoints) {
+		x.resize (read);
+		y.resize (read);
+	}
+	return next;
+}
+
+char const *JcampReader::ReadPoints (char const *data, char const *end, unsigned group, double xfactor, double yfactor, std::vector <double> &x, std::vector <double> &y)
+{
+	unsigned index = 0;
+	char const *cur = data;
+	std::string number;
+	while (cur < end) {
+		if (cur[0] == '#' && cur + 1 < end && cur[1] == '#')
+			break;
+		if (cur[0] == '$' && cur + 1 < end && cur[1] == '$') {
+			while (cur < end && *cur != '\n')
+				cur++;
+			continue;
+		}
+		if (*cur == '+' || *cur == '-' || *cur == '.' || g_ascii_isdigit (*cur)) {
+			// copy the number since the text is not null terminated
+			number.clear ();
+			while (cur < end && (g_ascii_isalnum (*cur) || *cur == '+' || *cur == '-' || *cur == '.'))
+				number += *cur++;
+			double val = g_ascii_strtod (number.c_str (), NULL);
+			if (index % group == 0)
+				x.push_back (val * xfactor);
+			else if (index % group == 1)
+				y.push_back (val * yfactor);
+			index++;
+			continue;
+		}
+		cur++;
+	}
+	if (y.size () < x.size ())
+		x.resize (y.size ());
+	return cur;
+}
+
+}	//	namespace gcu
@@ -0,0 +1,249 @@
+// -*- C++ -*-
+
+/*
+ * Gnome Chemistry Utils
+ * gcu/jcamp.h
+ *
+ * Copyright (C) 2026 Jean Bréfort <jean.brefort@normalesup.org>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301
+ * USA
+ */
+
+#ifndef GCU_JCAMP_H
+#define GCU_JCAMP_H
+
+#include <cstddef>
+#include <map>
+#include <string>
+#include <vector>
+
+/*!\file*/
+namespace gcu
+{
+
+/*!\class JcampDecoder gcu/jcamp.h
+Decodes the (X++(Y..Y)) data tables of JCAMP-DX files, in AFFN or in any of
+the ASDF compressed forms (SQZ, DIF and DUP). The text is read in place, and
+the values are written directly to arrays allocated by the caller, usually
+sized from the NPOINTS label. Each line starts with an abscissa; when it
+shows that the first ordinate repeats the last one of the previous line, as
+happens with DIF data, that ordinate is compared to the stored value and
+discarded.
+*/
+class JcampDecoder
+{
+public:
+/*!
+@param x the array where abscissas will be stored.
+@param y the array where ordinates will be stored.
+@param npoints the size of both arrays.
+@param firstx the FIRSTX label value.
+@param lastx the LASTX label value.
+@param deltax the abscissa increment.
+@param xfactor the XFACTOR label value.
+@param yfactor the YFACTOR label value.
+@param firsty the FIRSTY label value.
+*/
+	JcampDecoder (double *x, double *y, unsigned npoints, double firstx, double lastx, double deltax, double xfactor, double yfactor, double firsty);
+/*!
+The destructor.
+*/
+	~JcampDecoder ();
+
+/*!
+@param data the text following the data table label.
+@param end the end of the text, which does not need to be null terminated.
+
+Decodes lines until the next label line, that is a line starting with "##",
+or the end of the text.
+@return a pointer to the start of the next label line or to the end of the
+text.
+*/
+	char const *Decode (char const *data, char const *end);
+
+/*!
+@return the number of points read so far.
+*/
+	unsigned GetRead () const {return m_Read;}
+/*!
+@return the abscissa increment, which might have been fixed if the first
+abscissa did not match FIRSTX.
+*/
+	double GetDeltaX () const {return m_DeltaX;}
+/*!
+@return the abscissa factor, which might have been fixed if the first
+abscissa did not match FIRSTX.
+*/
+	double GetXFactor () const {return m_XFactor;}
+/*!
+@return true if the data table had more values than the arrays size.
+*/
+	bool GetOverflow () const {return m_Overflow;}
+
+/*!
+@param s a pointer to the start of an AFFN number, updated to the first
+character after it.
+@param end the end of the text.
+
+Parses an unsigned decimal number made of digits and an optional decimal
+point without any locale or exponent handling.
+@return the parsed value.
+*/
+	static double ParseNumber (char const *&s, char const *end);
+
+private:
+	void AddValue (double val);
+	void AddRepeats (unsigned n);
+
+private:
+	double *m_X, *m_Y;
+	unsigned m_NPoints, m_Read;
+	double m_FirstX, m_LastX, m_DeltaX, m_XFactor, m_YFactor, m_FirstY;
+	// line state: 0 for the abscissa, then the number of ordinates
+	unsigned m_Index;
+	// the first read index and abscissa of the previous line
+	unsigned m_Previous;
+	double m_PreviousX;
+	// whether the next value is a Y check value
+	bool m_Check;
+	bool m_Overflow;
+	// last decoded value and difference, needed by DIF and DUP
+	double m_Value, m_Diff;
+	bool m_IsDiff;
+};
+
+/*!\class JcampReader gcu/jcamp.h
+A JCAMP-DX reader which does not need any user interface, used to process
+files in batch. It reads the labels of the first block and either its
+XYDATA, XYPOINTS or PEAK TABLE data table, or the pages of its NTUPLES.
+The values of each variable are stored by symbol, 'X' and 'Y' for simple
+files, and for example 'X', 'R' and 'I' for a NMR FID.
+
+The static methods are also used by gcugtk::SpectrumDocument, so that labels
+and data tables are parsed the same way everywhere.
+*/
+class JcampReader
+{
+public:
+/*!
+The constructor.
+*/
+	JcampReader ();
+/*!
+The destructor.
+*/
+	~JcampReader ();
+
+/*!
+@param data the file contents.
+@param length the contents length.
+
+Reads the labels and the data. The text does not need to be null terminated.
+@return true if a data table has been read.
+*/
+	bool Load (char const *data, size_t length);
+
+/*!
+@param label a label name.
+
+Label names are normalized as in the JCAMP-DX specification: spaces, dashes,
+slashes and underscores are removed and letters are upper cased, so that
+"##.OBSERVE FREQUENCY=" is stored as ".OBSERVEFREQUENCY".
+@return the label value with comments and surrounding spaces removed, or an
+empty string if the label was not found.
+*/
+	std::string const &GetLabel (char const *label) const;
+/*!
+@param label a label name.
+@param default_value the value returned if the label was not found.
+@return the label value as a number.
+*/
+	double GetNumber (char const *label, double default_value) const;
+/*!
+@return true if the data were read from NTUPLES pages.
+*/
+	bool HasNTuples () const {return m_NTuples;}
+/*!
+@param symbol a variable symbol as used in the data table descriptions.
+@return the values of the variable, or an empty vector if it was not read.
+*/
+	std::vector <double> &GetValues (char symbol) {return m_Values[symbol];}
+/*!
+@param symbol a variable symbol.
+@return the variable unit, from the UNITS label of NTUPLES or from the XUNITS
+and YUNITS labels.
+*/
+	std::string GetUnit (char symbol) const;
+/*!
+@return the abscissas.
+*/
+	std::vector <double> &GetX () {return m_Values['X'];}
+/*!
+@return the ordinates.
+*/
+	std::vector <double> &GetY () {return m_Values['Y'];}
+
+/*!
+@param label the start of a label name as found in a file.
+@param end the end of the label name.
+@return the normalized label.
+*/
+	static std::string NormalizeLabel (char const *label, char const *end);
+/*!
+@param cur the position where the search starts, updated to the start of the
+line following the label.
+@param end the end of the text.
+@param label where to store the normalized label name.
+@param value where to store the label value, with comments and surrounding
+spaces removed.
+
+Finds the next labelled data record. Other lines, such as data lines, and
+comment labels are skipped.
+@return true if a label was found, false at the end of the text.
+*/
+	static bool ReadLabel (char const *&cur, char const *end, std::string &label, std::string &value);
+/*!
+@param data the text following the data table label.
+@param end the end of the text.
+@param group the number of values for each point, 2 for (XY..XY), 3 for
+(XYW..XYW) or (XYM..XYM).
+@param xfactor the abscissas factor.
+@param yfactor the ordinates factor.
+@param x where to append the abscissas.
+@param y where to append the ordinates.
+
+Reads (XY..XY) data, as found in XYPOINTS and PEAK TABLE records, until the
+next label.
+@return a pointer to the start of the next label line or to the end of the
+text.
+*/
+	static char const *ReadPoints (char const *data, char const *end, unsigned group, double xfactor, double yfactor, std::vector <double> &x, std::vector <double> &y);
+
+private:
+	char const *ReadTable (char const *data, char const *end, char xsymbol, char ysymbol, unsigned npoints, double firstx, double lastx, double xfactor, double yfactor, double firsty);
+	char const *ReadPage (char const *data, char const *end, std::string const &description, bool &found);
+	std::string GetTupleField (char const *label, int index) const;
+	int GetTupleIndex (char symbol) const;
+
+private:
+	std::map <std::string, std::string> m_Labels;
+	std::map <char, std::vector <double> > m_Values;
+	bool m_NTuples;
+};
+
+}	//	namespace gcu
+
+#endif	//	GCU_JCAMP_H
@@ -121,7 +121,8 @@ GSF_CLASS (PluginServiceChemicalLoader, plugin_service_chemical_loader,
            plugin_service_chemical_loader_class_init, plugin_service_chemical_loader_init,
            GO_TYPE_PLUGIN_SERVICE_SIMPLE)
 
-Loader::Loader ()
+Loader::Loader ():
+	m_MappedInput (false)
 {
 }
 
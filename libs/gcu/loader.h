@@ -217,6 +217,12 @@ implementation just return false.
 */
 	virtual bool Write (Object const *obj, GsfOutput *out, char const *mime_type, GOIOContext *io, ContentType type = ContentTypeMisc);
 
+/*!
+@return true if local files should be memory mapped before being passed to
+Loader::Read. See gcu::OpenInput.
+*/
+	bool UsesMappedInput () const {return m_MappedInput;}
+
 protected:
 /*!
 @param mime_type a mime type.
@@ -239,6 +245,13 @@ protected:
 The list of supported mime types.
 */
 	std::list<std::string> MimeTypes;
+/*!
+Whether Application::Load should memory map local files for this loader.
+Loaders which read their input sequentially or as a whole, and do not keep
+references to the data after Loader::Read returns, should set it to true in
+their constructor. The default is false.
+*/
+	bool m_MappedInput;
 };
 
 }
@@ -27,6 +27,7 @@
 #include "application.h"
 #include "atom.h"
 #include "bond.h"
+#include "canonical.h"
 #include "chain.h"
 #include "cycle.h"
 #include "document.h"
@@ -125,7 +126,7 @@ void Molecule::Remove (gcu::Object* pObject)
 }
 
 
-void Molecule::UpdateCycles (Bond* pBond)	//FIXME: function not totally implemented
+void Molecule::UpdateCycles (Bond* pBond)
 {
 	Chain* pChain = new Chain (this, pBond); //will find the cycles
 	delete pChain;
@@ -167,44 +168,77 @@ void Molecule::UpdateCycles ()
 
 bool Molecule::operator== (Molecule const& molecule) const
 {
-	// first examine each atom of each molecule and sort by Z.
-	map<int, set<Atom*> > atoms1, atoms2;
-	list<Atom*>::const_iterator ia, enda = m_Atoms.end ();
-	for (ia = m_Atoms.begin ();  ia != enda; ia++)
-		atoms1[(*ia)->GetZ ()].insert (*ia);
-	enda = molecule.m_Atoms.end ();
-	for (ia = molecule.m_Atoms.begin ();  ia != enda; ia++){
-		atoms2[(*ia)->GetZ ()].insert (*ia);
-	}
-	if (atoms1.size () != atoms2.size ())
-		return false;
-	map<int, set<Atom*> >::iterator ib, endb = atoms1.end (), ic, endc = atoms2.end ();
-	unsigned n = m_Atoms.size (), m;
-	int z = 200;
-	for (ib = atoms1.begin (); ib != endb; ib++) {
-		if ((ic = atoms2.find ((*ib).first)) == endc)
-			return false;
-		if ((m = (*ib).second.size ()) != (*ib).second.size ())
-			return false;
-		if (m < n)
-			n = m;
-		if (m == n && (*ib).first < z)
-			z = (*ib).first;
-	}
-	AtomMatchState state;
-	state.atoms.reserve (GetAtomsNumber ());
-	if (z == 200) {
+	if (m_Atoms.size () != molecule.m_Atoms.size () || m_Atoms.empty ())
 		return false; // should do something more meaningful the molecule contains no normal atoms, only groups, probably
-	}
-	Atom *atom = *atoms1[z].begin (); // take the firts atom, and try to match it with the other molecule atoms of same Z.
-	set<Atom*> &starters = atoms2[z];
-	set<Atom*>::iterator j, jend = starters.end ();
-	for (j = starters.begin (); j != jend; j++)
-		if (atom->Match (*j, state))
+	CanonicalLabeling labeling1 (this), labeling2 (&molecule);
+	return Match (labeling1, labeling2);
+}
+
+bool Molecule::Match (CanonicalLabeling const &labeling1, CanonicalLabeling const &labeling2)
+{
+	if (labeling1.GetHash () != labeling2.GetHash () || !labeling1.IsMatchable () || !labeling2.IsMatchable ())
+		return false;
+	if (labeling1.IsEquivalent (labeling2))
+		return true;
+	// either the hashes collide or the canonical orders differ for symmetry
+	// reasons, so try to match the first atom with each atom of the other molecule
+	unsigned i, n = labeling1.GetAtomsNumber ();
+	Atom *atom = labeling1.GetAtom (0);
+	for (i = 0; i < n; i++) {
+		AtomMatchState state;
+		state.atoms.resize (n, AtomPair (NULL, NULL));
+		if (atom->Match (labeling2.GetAtom (i), state) && state.mol1.size () == n)
 			return true;
+	}
 	return false;
 }
 
+struct MoleculeHash {
+	Molecule *molecule;
+	CanonicalLabeling *labeling;
+};
+
+static void hash_molecule (gpointer data, G_GNUC_UNUSED gpointer user_data)
+{
+	MoleculeHash *hash = static_cast < MoleculeHash * > (data);
+	hash->labeling = new CanonicalLabeling (hash->molecule);
+}
+
+void Molecule::GroupIdentical (std::vector < Molecule * > const &molecules, std::vector < std::vector < Molecule * > > &groups)
+{
+	unsigned i, j, n = molecules.size ();
+	std::vector < MoleculeHash > hashes (n);
+	GThreadPool *pool = g_thread_pool_new (hash_molecule, NULL, g_get_num_processors (), true, NULL);
+	for (i = 0; i < n; i++) {
+		hashes[i].molecule = molecules[i];
+		g_thread_pool_push (pool, &hashes[i], NULL);
+	}
+	// wait for all molecules to be hashed
+	g_thread_pool_free (pool, false, true);
+	// only compare molecules with the same hash
+	std::map < guint64, std::vector < unsigned > > buckets;
+	std::vector < unsigned > firsts; // the first molecule of each group
+	groups.clear ();
+	for (i = 0; i < n; i++) {
+		CanonicalLabeling *labeling = hashes[i].labeling;
+		std::vector < unsigned > &bucket = buckets[labeling->GetHash ()];
+		for (j = 0; j < bucket.size (); j++) {
+			Molecule *first = hashes[firsts[bucket[j]]].molecule;
+			if (first->m_Atoms.size () == hashes[i].molecule->m_Atoms.size () && !first->m_Atoms.empty () &&
+			    Match (*hashes[firsts[bucket[j]]].labeling, *labeling))
+				break;
+		}
+		if (j == bucket.size ()) {
+			bucket.push_back (groups.size ());
+			firsts.push_back (i);
+			groups.push_back (std::vector < Molecule * > ());
+		}
+		groups[bucket[j]].push_back (hashes[i].molecule);
+	}
+	for (i = 0; i < n; i++)
+		delete hashes[i].labeling;
+}
+
 Molecule *Molecule::MoleculeFromFormula (Document *Doc, Formula const &formula, bool add_pseudo)
 {
 	Application *app = Doc->GetApp ();
@@ -27,12 +27,14 @@
 
 #include "object.h"
 #include "structs.h"
+#include <vector>
 
 /*!\file*/
 namespace gcu {
 
 class Atom;
 class Bond;
+class CanonicalLabeling;
 class Chain;
 class Cycle;
 class Formula;
@@ -92,9 +94,10 @@ Removes an atom or a bond from a molecule.
 */
 	virtual void Remove (gcu::Object* pObject);
 /*!
-@param pBond a bond in the molecule.
+@param pBond a bond just added to or removed from the molecule.
 
-Updates the cycles list after a change, starting the exploration from \a pBond.
+Updates the cycles list after a change. Only the ring systems including the
+atoms of \a pBond are searched again.
 */
 	void UpdateCycles (Bond* pBond);
 /*!
@@ -103,15 +106,37 @@ Updates the cycles list after a change.
 	void UpdateCycles ();
 /*!
 @param molecule a molecule.
+
+The hashes of the molecules are compared first, and the atoms are matched
+only when they are identical, see CanonicalLabeling.
 @return true if the molecules have identical atoms and the connection
 framework between the atoms.
 */
 	bool operator== (Molecule const& molecule) const;
 /*!
+@param molecules the molecules to compare.
+@param groups where to store the groups of identical molecules.
+
+Sorts molecules into groups of identical molecules. The molecules are hashed
+in parallel threads, and only molecules with the same hash are compared. Each
+molecule belongs to exactly one group, and the groups, as well as the
+molecules inside each group, are in the order of \a molecules. The molecules
+must not be modified during the call.
+*/
+	static void GroupIdentical (std::vector < Molecule * > const &molecules, std::vector < std::vector < Molecule * > > &groups);
+/*!
 @return the number of atoms in the molecule.
 */
 	virtual unsigned GetAtomsNumber () const {return m_Atoms.size ();}
 /*!
+@return the number of bonds in the molecule.
+*/
+	unsigned GetBondsNumber () const {return m_Bonds.size ();}
+/*!
+@return the number of cycles in the molecule.
+*/
+	unsigned GetCyclesNumber () const {return m_Cycles.size ();}
+/*!
 @param Doc a document.
 @param formula a formula
 @param add_pseudo tells if a pseudo atom (with Z = 0) has to be added (used when
@@ -227,6 +252,9 @@ The bonds in the molecule.
 */
 	std::list<Bond*> m_Bonds;
 
+private:
+	static bool Match (CanonicalLabeling const &labeling1, CanonicalLabeling const &labeling2);
+
 private:
 	std::map <std::string, std::string> m_Names;
 	std::string m_CML;
@@ -63,8 +63,10 @@ Object::~Object ()
 	if (m_Id) {
 		if (m_Parent) {
 			Document *doc = GetDocument ();
-			if (doc)
+			if (doc) {
 				doc->m_DirtyObjects.erase (this);
+				doc->UnindexObject (this);
+			}
 			m_Parent->m_Children.erase (m_Id);
 		}
 		g_free (m_Id);
@@ -88,9 +90,12 @@ Object::~Object ()
 
 void Object::Clear ()
 {
+	Document *doc = GetDocument ();
 	map<string, Object*>::iterator i;
 	while (!m_Children.empty ()) {
 		i = m_Children.begin ();
+		if (doc)
+			(*i).second->UnregisterIds (doc);
 		(*i).second->m_Parent = NULL;
 		delete (*i).second;
 		m_Children.erase ((*i).first);
@@ -104,8 +109,12 @@ void Object::SetId (char const *Id)
 	if (m_Id) {
 		if (!strcmp (Id, m_Id))
 			return;
-		if (m_Parent)
+		if (m_Parent) {
+			Document *doc = GetDocument ();
+			if (doc)
+				doc->UnindexObject (this);
 			m_Parent->m_Children.erase (m_Id);
+		}
 		g_free(m_Id);
 	}
 	m_Id = g_strdup (Id);
@@ -169,12 +178,26 @@ void Object::AddChild (Object* object)
 	if (this == object->m_Parent)
 		return;
 	Document* pDoc = GetDocument ();
-	if (!pDoc)
-		cerr << "Cannot add an object outside a document" << endl;
+	if (!pDoc) {
+		if (object->m_Parent == &temp) {
+			// SetId() inside a tree without document, Ids can't be checked
+			object->m_Parent = this;
+			m_Children[object->m_Id] = object;
+		} else
+			cerr << "Cannot add an object outside a document" << endl;
+		return;
+	}
+	// when called from SetId(), the object stays in the same document
+	Document *oldDoc = (object->m_Parent == &temp)? pDoc: object->GetDocument ();
+	if (oldDoc && oldDoc != pDoc)
+		object->UnregisterIds (oldDoc);
 	if (object->m_Id == NULL) {
-		int i = 1;
+		// numbers freed by removed objects are not used again, see the documentation
+		unsigned &i = pDoc->m_NextIds["o"];
 		char szId[16];
-		while (snprintf (szId, sizeof(szId), "o%d", i++), pDoc->GetDescendant (szId) != NULL) ;
+		if (i == 0)
+			i = 1;
+		while (snprintf (szId, sizeof(szId), "o%u", i++), pDoc->GetDescendant (szId) != NULL) ;
 		object->m_Id = g_strdup (szId);
 	} else {
 		Object* o = pDoc->RealGetDescendant (object->m_Id);
@@ -200,6 +223,10 @@ void Object::AddChild (Object* object)
 	}
 	object->m_Parent = this;
 	m_Children[object->m_Id] = object;
+	if (oldDoc != pDoc)
+		object->RegisterIds (pDoc);
+	else
+		pDoc->IndexObject (object);
 	if (object->m_TypeDesc == NULL) {
 		Application *App = pDoc->GetApp ();
 		if (App)
@@ -215,8 +242,10 @@ void Object::SetParent (Object* Parent)
 	else {
 		if (m_Parent) {
 			Document *doc = GetDocument ();
-			if (doc)
+			if (doc) {
 				doc->m_DirtyObjects.erase (this);
+				UnregisterIds (doc);
+			}
 			m_Parent->m_Children.erase (m_Id);
 		}
 		m_Parent = NULL;
@@ -251,6 +280,15 @@ Object* Object::RealGetDescendant (char const *Id) const
 {
 	map<string, Object*>::const_iterator i;
 	Object *object = NULL;
+	Document *doc = GetDocument ();
+	if (doc && !doc->HasDuplicateIds ()) {
+		// all Ids are unique and indexed, just check that the object is a descendant
+		object = doc->GetIndexedObject (Id);
+		Object const *ancestor = (object)? object->m_Parent: NULL;
+		while (ancestor && ancestor != this)
+			ancestor = ancestor->m_Parent;
+		return (ancestor)? object: NULL;
+	}
 	i = m_Children.find (Id);
 	if (i == m_Children.end ()) {
 		map<string, Object*>::const_iterator i, end = m_Children.end ();
@@ -262,6 +300,22 @@ Object* Object::RealGetDescendant (char const *Id) const
 	return object;
 }
 
+void Object::RegisterIds (Document *doc)
+{
+	doc->IndexObject (this);
+	map<string, Object*>::iterator i, end = m_Children.end ();
+	for (i = m_Children.begin (); i != end; i++)
+		(*i).second->RegisterIds (doc);
+}
+
+void Object::UnregisterIds (Document *doc)
+{
+	doc->UnindexObject (this);
+	map<string, Object*>::iterator i, end = m_Children.end ();
+	for (i = m_Children.begin (); i != end; i++)
+		(*i).second->UnregisterIds (doc);
+}
+
 Object *Object::GetFirstChild (map<string, Object*>::iterator& i)
 {
 	i = m_Children.begin ();
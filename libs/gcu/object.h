@@ -187,7 +187,12 @@ the Object::AddType method.
 	@param object the Object instance to add as a child.
 
 	Each Object instance maintains a list of its children. If object has already a parent, it will be removed from its
-	parent children list. The new parent Object must have a Document ancestor to ensure that Ids are unique.
+	parent children list. The new parent Object must have a Document ancestor to ensure that Ids are unique,
+	otherwise an error is printed and nothing is done.
+
+	An object without Id gets an automatic "o" followed by a number. The numbers grow for each new Id in the
+	document, so that the Id of a removed object is not given to a new one, while previous versions always
+	used the lowest free number.
 */
 	virtual void AddChild (Object* object);
 /*!
@@ -735,6 +740,8 @@ protected:
 
 private:
 	Object* RealGetDescendant (char const *Id) const;
+	void RegisterIds (Document *doc);
+	void UnregisterIds (Document *doc);
 
 private:
 	char* m_Id;
@@ -0,0 +1,391 @@
+// -*- C++ -*-
+
+/*
+ * Gnome Chemistry Utils
+ * gcu/rings.cc
+ *
+ * Copyright (C) 2026 Jean Bréfort <jean.brefort@normalesup.org>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301
+ * USA
+ */
+
+#include "config.h"
+#include "rings.h"
+#include "atom.h"
+#include "bond.h"
+#include <glib.h>
+#include <algorithm>
+#include <iterator>
+#include <set>
+
+#define NONE G_MAXUINT
+
+namespace gcu
+{
+
+RingFinder::RingFinder ():
+	m_CurStamp (0)
+{
+	m_RingStart.push_back (0);
+}
+
+RingFinder::~RingFinder ()
+{
+}
+
+bool RingFinder::AddAtom (Atom *atom)
+{
+	if (m_AtomIndex.find (atom) != m_AtomIndex.end ())
+		return false;
+	m_AtomIndex[atom] = m_Atoms.size ();
+	m_Atoms.push_back (atom);
+	return true;
+}
+
+bool RingFinder::AddBond (Bond *bond)
+{
+	if (m_BondIndex.find (bond) != m_BondIndex.end ())
+		return false;
+	std::map <Atom *, unsigned>::iterator a0 = m_AtomIndex.find (bond->GetAtom (0)),
+										  a1 = m_AtomIndex.find (bond->GetAtom (1));
+	if (a0 == m_AtomIndex.end () || a1 == m_AtomIndex.end ())
+		return false;
+	m_BondIndex[bond] = m_Bonds.size ();
+	m_Bonds.push_back (bond);
+	m_Ends.push_back ((*a0).second);
+	m_Ends.push_back ((*a1).second);
+	return true;
+}
+
+void RingFinder::Restrict (Atom *atom)
+{
+	std::map <Atom *, unsigned>::iterator i = m_AtomIndex.find (atom);
+	if (i != m_AtomIndex.end ())
+		m_Restricted.push_back ((*i).second);
+}
+
+bool RingFinder::IsPerceived (Bond *bond) const
+{
+	std::map <Bond *, unsigned>::const_iterator i = m_BondIndex.find (bond);
+	if (i == m_BondIndex.end () || (*i).second >= m_BondSystem.size ())
+		return false;
+	unsigned system = m_BondSystem[(*i).second];
+	return system != NONE && m_Wanted[system];
+}
+
+void RingFinder::FindRingBonds ()
+{
+	// Tarjan's bridge search with an explicit stack: a bond is in a ring unless
+	// it is a tree edge whose lower end can't reach anything above it
+	unsigned natoms = m_Atoms.size (), root, counter = 0;
+	std::vector <unsigned> order (natoms, NONE), low (natoms);
+	// each frame holds an atom, the bond used to reach it and the next adjacency position
+	std::vector <unsigned> frames;
+	m_BondSystem.assign (m_Bonds.size (), NONE);
+	for (root = 0; root < natoms; root++) {
+		if (order[root] != NONE)
+			continue;
+		order[root] = low[root] = counter++;
+		frames.push_back (root);
+		frames.push_back (NONE);
+		frames.push_back (m_AdjStart[root]);
+		while (!frames.empty ()) {
+			unsigned top = frames.size () - 3, atom = frames[top], edge = frames[top + 1];
+			if (frames[top + 2] < m_AdjStart[atom + 1]) {
+				unsigned bond = m_Adj[frames[top + 2]++];
+				if (bond == edge)
+					continue;
+				unsigned other = GetOther (bond, atom);
+				if (order[other] == NONE) {
+					order[other] = low[other] = counter++;
+					frames.push_back (other);
+					frames.push_back (bond);
+					frames.push_back (m_AdjStart[other]);
+				} else {
+					// a back edge always closes a ring, 0 is used as a mark here
+					m_BondSystem[bond] = 0;
+					if (order[other] < low[atom])
+						low[atom] = order[other];
+				}
+			} else {
+				frames.resize (top);
+				if (!frames.empty ()) {
+					unsigned parent = frames[top - 3];
+					if (low[atom] < low[parent])
+						low[parent] = low[atom];
+					if (low[atom] <= order[parent])
+						m_BondSystem[edge] = 0;
+				}
+			}
+		}
+	}
+}
+
+void RingFinder::FindSystems ()
+{
+	unsigned natoms = m_Atoms.size (), nsystems = 0, i, j, atom, bonds;
+	m_AtomSystem.assign (natoms, NONE);
+	m_SystemSize.clear ();
+	for (i = 0; i < natoms; i++) {
+		if (m_AtomSystem[i] != NONE)
+			continue;
+		for (j = m_AdjStart[i]; j < m_AdjStart[i + 1]; j++)
+			if (m_BondSystem[m_Adj[j]] != NONE)
+				break;
+		if (j == m_AdjStart[i + 1])
+			continue; // not in a ring
+		// flood the ring system and evaluate its cyclomatic number
+		unsigned natoms_in = 0;
+		bonds = 0;
+		m_Queue.clear ();
+		m_Queue.push_back (i);
+		m_AtomSystem[i] = nsystems;
+		while (!m_Queue.empty ()) {
+			atom = m_Queue.back ();
+			m_Queue.pop_back ();
+			natoms_in++;
+			for (j = m_AdjStart[atom]; j < m_AdjStart[atom + 1]; j++) {
+				unsigned bond = m_Adj[j];
+				if (m_BondSystem[bond] == NONE)
+					continue;
+				unsigned other = GetOther (bond, atom);
+				if (other > atom)
+					bonds++; // each bond is seen from both ends
+				m_BondSystem[bond] = nsystems;
+				if (m_AtomSystem[other] == NONE) {
+					m_AtomSystem[other] = nsystems;
+					m_Queue.push_back (other);
+				}
+			}
+		}
+		m_SystemSize.push_back (bonds - natoms_in + 1);
+		nsystems++;
+	}
+	m_Wanted.assign (nsystems, m_Restricted.empty ());
+	std::vector <unsigned>::iterator it, end = m_Restricted.end ();
+	for (it = m_Restricted.begin (); it != end; it++)
+		if (m_AtomSystem[*it] != NONE)
+			m_Wanted[m_AtomSystem[*it]] = true;
+}
+
+void RingFinder::AddCandidate (std::vector <unsigned> &atoms, std::vector <unsigned> &bonds, unsigned system)
+{
+	m_Candidates.push_back (Candidate ());
+	Candidate &candidate = m_Candidates.back ();
+	candidate.atoms.swap (atoms);
+	candidate.bonds.swap (bonds);
+	candidate.sorted = candidate.bonds;
+	std::sort (candidate.sorted.begin (), candidate.sorted.end ());
+	candidate.system = system;
+}
+
+void RingFinder::FindShortestRing (unsigned bond)
+{
+	// breadth first search from one end of the bond to the other without using it
+	unsigned start = m_Ends[2 * bond], target = m_Ends[2 * bond + 1], system = m_BondSystem[bond], i, j;
+	m_CurStamp++;
+	m_Queue.clear ();
+	m_Queue.push_back (start);
+	m_Stamp[start] = m_CurStamp;
+	m_Parent[start] = NONE;
+	for (i = 0; i < m_Queue.size () && m_Stamp[target] != m_CurStamp; i++) {
+		unsigned atom = m_Queue[i];
+		for (j = m_AdjStart[atom]; j < m_AdjStart[atom + 1]; j++) {
+			unsigned b = m_Adj[j];
+			if (b == bond || m_BondSystem[b] != system)
+				continue;
+			unsigned other = GetOther (b, atom);
+			if (m_Stamp[other] == m_CurStamp)
+				continue;
+			m_Stamp[other] = m_CurStamp;
+			m_Parent[other] = b;
+			if (other == target)
+				break;
+			m_Queue.push_back (other);
+		}
+	}
+	if (m_Stamp[target] != m_CurStamp)
+		return; // should not happen for a ring bond
+	std::vector <unsigned> atoms, bonds;
+	for (i = target; i != start; i = GetOther (m_Parent[i], i)) {
+		atoms.push_back (i);
+		bonds.push_back (m_Parent[i]);
+	}
+	atoms.push_back (start);
+	// the path is reversed, so that atoms go from start to target, and bond closes the ring
+	std::reverse (atoms.begin (), atoms.end ());
+	std::reverse (bonds.begin (), bonds.end ());
+	bonds.push_back (bond);
+	AddCandidate (atoms, bonds, system);
+}
+
+void RingFinder::FindHortonRings (unsigned system)
+{
+	// for each atom r and each bond (x, y) not in the shortest paths tree from r,
+	// the ring made of the paths from r to x and y and of the bond is a candidate
+	unsigned natoms = m_Atoms.size (), nbonds = m_Bonds.size (), r, i, j, a, markid = 0;
+	std::vector <unsigned> mark (natoms, 0);
+	for (r = 0; r < natoms; r++) {
+		if (m_AtomSystem[r] != system)
+			continue;
+		m_CurStamp++;
+		m_Queue.clear ();
+		m_Queue.push_back (r);
+		m_Stamp[r] = m_CurStamp;
+		m_Parent[r] = NONE;
+		m_Depth[r] = 0;
+		for (i = 0; i < m_Queue.size (); i++) {
+			unsigned atom = m_Queue[i];
+			for (j = m_AdjStart[atom]; j < m_AdjStart[atom + 1]; j++) {
+				unsigned b = m_Adj[j], other;
+				if (m_BondSystem[b] != system || m_Stamp[other = GetOther (b, atom)] == m_CurStamp)
+					continue;
+				m_Stamp[other] = m_CurStamp;
+				m_Parent[other] = b;
+				m_Depth[other] = m_Depth[atom] + 1;
+				m_Queue.push_back (other);
+			}
+		}
+		for (i = 0; i < nbonds; i++) {
+			if (m_BondSystem[i] != system)
+				continue;
+			unsigned x = m_Ends[2 * i], y = m_Ends[2 * i + 1];
+			if (m_Parent[x] == i || m_Parent[y] == i)
+				continue;
+			// the two paths must only share r
+			markid++;
+			for (a = x; a != r; a = GetOther (m_Parent[a], a))
+				mark[a] = markid;
+			for (a = y; a != r && mark[a] != markid; a = GetOther (m_Parent[a], a));
+			if (a != r)
+				continue;
+			std::vector <unsigned> atoms, bonds;
+			for (a = x; a != r; a = GetOther (m_Parent[a], a)) {
+				atoms.push_back (a);
+				bonds.push_back (m_Parent[a]);
+			}
+			atoms.push_back (r);
+			std::reverse (atoms.begin (), atoms.end ());
+			std::reverse (bonds.begin (), bonds.end ());
+			bonds.push_back (i);
+			for (a = y; a != r; a = GetOther (m_Parent[a], a)) {
+				atoms.push_back (a);
+				bonds.push_back (m_Parent[a]);
+			}
+			AddCandidate (atoms, bonds, system);
+		}
+	}
+}
+
+static bool candidate_less (std::pair <unsigned, unsigned> const &a, std::pair <unsigned, unsigned> const &b)
+{
+	return a.first < b.first || (a.first == b.first && a.second < b.second);
+}
+
+unsigned RingFinder::SelectRings (unsigned system)
+{
+	// sort the candidates by size and remove duplicates
+	std::vector < std::pair <unsigned, unsigned> > order;
+	unsigned i, max = m_Candidates.size (), needed = m_SystemSize[system], found = 0;
+	for (i = 0; i < max; i++)
+		if (m_Candidates[i].system == system)
+			order.push_back (std::pair <unsigned, unsigned> (m_Candidates[i].bonds.size (), i));
+	std::sort (order.begin (), order.end (), candidate_less);
+	std::set < std::vector <unsigned> > seen;
+	// Gaussian elimination over GF(2), each basis vector being indexed by its
+	// largest bond index
+	std::vector < std::vector <unsigned> > basis;
+	std::map <unsigned, unsigned> pivots;
+	std::map <unsigned, unsigned>::iterator pivot;
+	std::vector <unsigned> cur, tmp;
+	std::vector < std::pair <unsigned, unsigned> >::iterator it, end = order.end ();
+	for (it = order.begin (); it != end && found < needed; it++) {
+		Candidate &candidate = m_Candidates[(*it).second];
+		if (!seen.insert (candidate.sorted).second)
+			continue;
+		cur = candidate.sorted;
+		while (!cur.empty () && (pivot = pivots.find (cur.back ())) != pivots.end ()) {
+			std::vector <unsigned> &v = basis[(*pivot).second];
+			tmp.clear ();
+			std::set_symmetric_difference (cur.begin (), cur.end (), v.begin (), v.end (), std::back_inserter (tmp));
+			cur.swap (tmp);
+		}
+		if (cur.empty ())
+			continue; // not independent
+		pivots[cur.back ()] = basis.size ();
+		basis.push_back (cur);
+		found++;
+		m_RingAtoms.insert (m_RingAtoms.end (), candidate.atoms.begin (), candidate.atoms.end ());
+		m_RingBonds.insert (m_RingBonds.end (), candidate.bonds.begin (), candidate.bonds.end ());
+		m_RingStart.push_back (m_RingAtoms.size ());
+	}
+	return found;
+}
+
+unsigned RingFinder::Perceive ()
+{
+	unsigned natoms = m_Atoms.size (), nbonds = m_Bonds.size (), i;
+	m_RingStart.resize (1);
+	m_RingAtoms.clear ();
+	m_RingBonds.clear ();
+	m_Candidates.clear ();
+	// build the adjacency array
+	m_AdjStart.assign (natoms + 1, 0);
+	for (i = 0; i < 2 * nbonds; i++)
+		m_AdjStart[m_Ends[i] + 1]++;
+	for (i = 0; i < natoms; i++)
+		m_AdjStart[i + 1] += m_AdjStart[i];
+	m_Adj.resize (2 * nbonds);
+	std::vector <unsigned> pos (m_AdjStart.begin (), m_AdjStart.end () - 1);
+	for (i = 0; i < nbonds; i++) {
+		m_Adj[pos[m_Ends[2 * i]]++] = i;
+		m_Adj[pos[m_Ends[2 * i + 1]]++] = i;
+	}
+	FindRingBonds ();
+	FindSystems ();
+	m_Stamp.assign (natoms, 0);
+	m_Parent.resize (natoms);
+	m_Depth.resize (natoms);
+	m_CurStamp = 0;
+	unsigned nsystems = m_SystemSize.size ();
+	// a system with a single ring is entirely found from any of its bonds
+	std::vector <bool> found (nsystems, false);
+	for (i = 0; i < nbonds; i++) {
+		unsigned system = m_BondSystem[i];
+		if (system == NONE || !m_Wanted[system] || found[system])
+			continue;
+		if (m_SystemSize[system] == 1)
+			found[system] = true;
+		FindShortestRing (i);
+	}
+	for (i = 0; i < nsystems; i++) {
+		if (!m_Wanted[i])
+			continue;
+		unsigned start = m_RingStart.size ();
+		if (SelectRings (i) < m_SystemSize[i]) {
+			// drop the rings found so far and try again with more candidates
+			m_RingStart.resize (start);
+			m_RingAtoms.resize (m_RingStart.back ());
+			m_RingBonds.resize (m_RingStart.back ());
+			FindHortonRings (i);
+			SelectRings (i);
+		}
+	}
+	m_Candidates.clear ();
+	return GetRings ();
+}
+
+}	//	namespace gcu
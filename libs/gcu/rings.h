@@ -0,0 +1,156 @@
+// -*- C++ -*-
+
+/*
+ * Gnome Chemistry Utils
+ * gcu/rings.h
+ *
+ * Copyright (C) 2026 Jean Bréfort <jean.brefort@normalesup.org>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301
+ * USA
+ */
+
+#ifndef GCU_RINGS_H
+#define GCU_RINGS_H
+
+#include <map>
+#include <vector>
+
+/*!\file*/
+namespace gcu
+{
+
+class Atom;
+class Bond;
+
+/*!\class RingFinder gcu/rings.h
+Perceives the smallest set of smallest rings (SSSR) of a molecular graph
+without any recursion, so that large polymers can not exhaust the stack.
+
+Atoms and bonds are stored as a compact adjacency array. Bonds which are not
+in any ring are first eliminated by an iterative bridge search, and the
+remaining bonds are grouped into ring systems. The shortest ring through
+each ring bond is then found by a breadth first search, which rarely goes
+beyond the neighbourhood of the bond, and rings are accepted by increasing
+size while they are independent of those already accepted, until each ring
+system has as many rings as its cyclomatic number. For the few systems, such
+as fullerenes, where these rings are not enough, a Horton candidates set is
+used.
+*/
+class RingFinder
+{
+public:
+/*!
+The constructor.
+*/
+	RingFinder ();
+/*!
+The destructor.
+*/
+	~RingFinder ();
+
+/*!
+@param atom an atom.
+
+Adds an atom to the graph.
+@return false if the atom was already there.
+*/
+	bool AddAtom (Atom *atom);
+/*!
+@param bond a bond.
+
+Adds a bond to the graph, its atoms must have been added before.
+@return false if the bond was already there or if an atom is missing.
+*/
+	bool AddBond (Bond *bond);
+/*!
+@param atom an atom in the graph.
+
+Restricts the perception to the ring systems including \a atom. This might be
+called several times, and all ring systems are searched if it is not called.
+*/
+	void Restrict (Atom *atom);
+/*!
+Perceives the rings.
+@return the number of rings found.
+*/
+	unsigned Perceive ();
+
+/*!
+@return the number of rings found.
+*/
+	unsigned GetRings () const {return m_RingStart.size () - 1;}
+/*!
+@param i a ring index.
+@return the number of atoms, or bonds, of the ring.
+*/
+	unsigned GetRingSize (unsigned i) const {return m_RingStart[i + 1] - m_RingStart[i];}
+/*!
+@param i a ring index.
+@param j an index in the ring.
+@return the j-th atom of the ring.
+*/
+	Atom *GetRingAtom (unsigned i, unsigned j) const {return m_Atoms[m_RingAtoms[m_RingStart[i] + j]];}
+/*!
+@param i a ring index.
+@param j an index in the ring.
+@return the bond between the j-th and the next atom of the ring, the last
+bond closing the ring.
+*/
+	Bond *GetRingBond (unsigned i, unsigned j) const {return m_Bonds[m_RingBonds[m_RingStart[i] + j]];}
+/*!
+@param bond a bond.
+@return true if \a bond belongs to a ring system which has been searched by
+the last call to Perceive().
+*/
+	bool IsPerceived (Bond *bond) const;
+
+private:
+	// a candidate ring, bonds[i] links atoms[i] to the next atom, and sorted
+	// holds the same bonds ordered by index
+	struct Candidate {
+		std::vector <unsigned> atoms, bonds, sorted;
+		unsigned system;
+	};
+	unsigned GetOther (unsigned bond, unsigned atom) const {return (m_Ends[2 * bond] == atom)? m_Ends[2 * bond + 1]: m_Ends[2 * bond];}
+	void FindRingBonds ();
+	void FindSystems ();
+	void FindShortestRing (unsigned bond);
+	void FindHortonRings (unsigned system);
+	void AddCandidate (std::vector <unsigned> &atoms, std::vector <unsigned> &bonds, unsigned system);
+	unsigned SelectRings (unsigned system);
+
+private:
+	std::map <Atom *, unsigned> m_AtomIndex;
+	std::map <Bond *, unsigned> m_BondIndex;
+	std::vector <Atom *> m_Atoms;
+	std::vector <Bond *> m_Bonds;
+	std::vector <unsigned> m_Restricted;
+	// the two atoms of each bond, then the bonds of each atom
+	std::vector <unsigned> m_Ends, m_AdjStart, m_Adj;
+	// ring systems, NONE for bonds which are not in a ring
+	std::vector <unsigned> m_BondSystem, m_AtomSystem, m_SystemSize;
+	std::vector <bool> m_Wanted;
+	// breadth first search work space
+	std::vector <unsigned> m_Stamp, m_Parent, m_Depth, m_Queue;
+	unsigned m_CurStamp;
+	std::vector <Candidate> m_Candidates;
+	// selected rings
+	std::vector <unsigned> m_RingStart, m_RingAtoms, m_RingBonds;
+};
+
+}	//	namespace gcu
+
+#endif	//	GCU_RINGS_H
@@ -0,0 +1,381 @@
+// -*- C++ -*-
+
+/*
+ * Gnome Chemistry Utils
+ * gcu/sdfile.cc
+ *
+ * Copyright (C) 2026 Jean Bréfort <jean.brefort@normalesup.org>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301
+ * USA
+ */
+
+#include "config.h"
+#include "sdfile.h"
+#include "input.h"
+#include <glib.h>
+#include <cstring>
+
+namespace gcu
+{
+
+static bool is_rd_record_start (char const *line)
+{
+	return line[0] == '$' && (!strncmp (line + 1, "MFMT", 4) || !strncmp (line + 1, "RFMT", 4) ||
+	                          !strncmp (line + 1, "MIREG", 5) || !strncmp (line + 1, "RIREG", 5) ||
+	                          !strncmp (line + 1, "MEREG", 5) || !strncmp (line + 1, "REREG", 5));
+}
+
+static char const *skip_spaces (char const *s)
+{
+	while (*s == ' ' || *s == '\t')
+		s++;
+	return s;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// SDReader implementation
+
+SDReader::SDReader (GsfInput *input):
+	m_Input (new LineReader (input)),
+	m_RDfile (false),
+	m_Started (false),
+	m_Pending (false),
+	m_Type (SD_RECORD_NONE),
+	m_Record (0),
+	m_FirstLine (0)
+{
+}
+
+SDReader::~SDReader ()
+{
+	delete m_Input;
+}
+
+bool SDReader::Next ()
+{
+	m_Buffer.clear ();
+	m_Lines.clear ();
+	m_Data.clear ();
+	m_RegNo.clear ();
+	m_Type = SD_RECORD_NONE;
+	if (!m_Started) {
+		m_Started = true;
+		char const *line = m_Input->GetLine ();
+		if (!line)
+			return false;
+		if (!strncmp (line, "$RDFILE", 7))
+			m_RDfile = true;
+		else {
+			// this is the first line of the first record
+			m_Pending = true;
+			m_PendingLine = line;
+		}
+	}
+	if (!(m_RDfile? ReadRDRecord (): ReadSDRecord ()))
+		return false;
+	m_Record++;
+	return true;
+}
+
+unsigned SDReader::ForEach (SDRecordCallback cb, void *data)
+{
+	unsigned n = 0;
+	while (Next ()) {
+		n++;
+		if (!cb (this, data))
+			break;
+	}
+	return n;
+}
+
+char const *SDReader::GetTitle () const
+{
+	char const *title = GetLine ((m_Type == SD_RECORD_REACTION)? 1: 0);
+	return (title)? title: "";
+}
+
+char const *SDReader::GetData (char const *name) const
+{
+	std::vector < std::pair <std::string, std::string> >::const_iterator i, end = m_Data.end ();
+	for (i = m_Data.begin (); i != end; i++)
+		if ((*i).first == name)
+			return (*i).second.c_str ();
+	return NULL;
+}
+
+char const *SDReader::ReadLine ()
+{
+	if (m_Pending) {
+		// the pending line is always the last one read, so that the line number is right
+		m_Pending = false;
+		return m_PendingLine.c_str ();
+	}
+	return m_Input->GetLine ();
+}
+
+void SDReader::AddLine (char const *line)
+{
+	m_Lines.push_back (m_Buffer.size ());
+	m_Buffer.insert (m_Buffer.end (), line, line + strlen (line) + 1);
+}
+
+bool SDReader::ReadSDRecord ()
+{
+	char const *line;
+	bool block = true, blank = true, started = false, item_lines = false;
+	int item = -1;
+	while ((line = ReadLine ())) {
+		if (!started) {
+			started = true;
+			m_FirstLine = m_Input->GetLineNumber ();
+		}
+		if (!strncmp (line, "$$$$", 4)) {
+			if (!blank)
+				return true;
+			// skip empty records
+			m_Buffer.clear ();
+			m_Lines.clear ();
+			m_Data.clear ();
+			block = true;
+			started = false;
+			item = -1;
+			continue;
+		}
+		if (block) {
+			if (m_Lines.empty ())
+				m_Type = (!strncmp (line, "$RXN", 4))? SD_RECORD_REACTION: SD_RECORD_MOLECULE;
+			if (*line)
+				blank = false;
+			AddLine (line);
+			// RXN and RGroup files include several molfiles and do not have data items
+			if (!strncmp (line, "M  END", 6) && *GetLine (0) != '$')
+				block = false;
+			continue;
+		}
+		if (*line == '>') {
+			// the name, if any, is between angle brackets
+			char const *start = strchr (line, '<'), *end = (start)? strchr (start + 1, '>'): NULL;
+			m_Data.push_back (std::pair <std::string, std::string> ((end)? std::string (start + 1, end - start - 1): std::string (), std::string ()));
+			item = m_Data.size () - 1;
+			item_lines = false;
+		} else if (item >= 0) {
+			if (!*line) {
+				item = -1; // a blank line ends the data item
+				continue;
+			}
+			std::string &value = m_Data[item].second;
+			if (item_lines)
+				value += '\n';
+			// SDWriter adds a space to the lines made only of spaces
+			value += (line[strspn (line, " ")])? line: line + 1;
+			item_lines = true;
+		}
+	}
+	// the last record might not be followed by "$$$$"
+	return !blank;
+}
+
+void SDReader::StartRDRecord (char const *line)
+{
+	if (!strncmp (line + 2, "FMT", 3))
+		m_Type = (line[1] == 'R')? SD_RECORD_REACTION: SD_RECORD_MOLECULE;
+	char const *regno = strstr (line, "IREG");
+	if (!regno)
+		regno = strstr (line, "EREG");
+	if (regno)
+		m_RegNo = skip_spaces (regno + 4);
+}
+
+bool SDReader::ReadRDRecord ()
+{
+	char const *line;
+	// skip the header lines up to the first record
+	while (!m_Pending) {
+		line = m_Input->GetLine ();
+		if (!line)
+			return false;
+		if (is_rd_record_start (line)) {
+			m_Pending = true;
+			m_PendingLine = line;
+		}
+	}
+	m_Pending = false;
+	m_FirstLine = m_Input->GetLineNumber ();
+	StartRDRecord (m_PendingLine.c_str ());
+	int item = -1;
+	bool datum = false;
+	while ((line = m_Input->GetLine ())) {
+		if (*line == '$') {
+			if (is_rd_record_start (line)) {
+				// keep the line for the next record
+				m_Pending = true;
+				m_PendingLine = line;
+				return true;
+			}
+			if (!strncmp (line, "$DTYPE", 6)) {
+				m_Data.push_back (std::pair <std::string, std::string> (skip_spaces (line + 6), std::string ()));
+				item = m_Data.size () - 1;
+				datum = false;
+				continue;
+			}
+			if (!strncmp (line, "$DATUM", 6)) {
+				if (item >= 0) {
+					m_Data[item].second = (line[6] == ' ')? line + 7: line + 6;
+					datum = true;
+				}
+				continue;
+			}
+			// other lines starting with '$' are part of RXN files
+		}
+		if (datum) {
+			// values longer than 80 characters continue on the next lines
+			m_Data[item].second += '\n';
+			m_Data[item].second += line;
+		}
+		else if (item < 0)
+			AddLine (line);
+	}
+	return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// SDWriter implementation
+
+SDWriter::SDWriter (GsfOutput *output, bool rdfile):
+	m_Output (output),
+	m_RDfile (rdfile),
+	m_InRecord (false),
+	m_HeaderWritten (false),
+	m_Records (0)
+{
+}
+
+SDWriter::~SDWriter ()
+{
+	if (m_InRecord)
+		EndRecord ();
+}
+
+bool SDWriter::Write (char const *data, size_t length)
+{
+	return gsf_output_write (m_Output, length, reinterpret_cast <guint8 const *> (data));
+}
+
+bool SDWriter::WriteHeader ()
+{
+	m_HeaderWritten = true;
+	GDateTime *now = g_date_time_new_now_local ();
+	char *date = g_date_time_format (now, "%m/%d/%y %H:%M");
+	bool res = gsf_output_printf (m_Output, "$RDFILE 1\n$DATM    %s\n", date);
+	g_free (date);
+	g_date_time_unref (now);
+	return res;
+}
+
+bool SDWriter::BeginRecord (SDRecordType type, char const *regno)
+{
+	if (m_InRecord && !EndRecord ())
+		return false;
+	if (!m_RDfile) {
+		// SDfiles only support molecules
+		if (type != SD_RECORD_MOLECULE)
+			return false;
+		m_InRecord = true;
+		return true;
+	}
+	if (!m_HeaderWritten && !WriteHeader ())
+		return false;
+	m_InRecord = true;
+	bool has_regno = regno && *regno;
+	switch (type) {
+	case SD_RECORD_MOLECULE:
+		return (has_regno)? gsf_output_printf (m_Output, "$MFMT $MIREG %s\n", regno): Write ("$MFMT\n", 6);
+	case SD_RECORD_REACTION:
+		return (has_regno)? gsf_output_printf (m_Output, "$RFMT $RIREG %s\n", regno): Write ("$RFMT\n", 6);
+	default:
+		// a record without structure needs a registry number
+		return has_regno && gsf_output_printf (m_Output, "$MIREG %s\n", regno);
+	}
+}
+
+bool SDWriter::WriteBlock (char const *text, gssize length)
+{
+	if (length < 0)
+		length = strlen (text);
+	if (length == 0)
+		return true;
+	return Write (text, length) && (text[length - 1] == '\n' || Write ("\n", 1));
+}
+
+bool SDWriter::WriteData (char const *name, char const *value)
+{
+	if (m_RDfile)
+		return gsf_output_printf (m_Output, "$DTYPE %s\n$DATUM %s\n", name, value);
+	if (!gsf_output_printf (m_Output, "> <%s>\n", name))
+		return false;
+	char const *end;
+	if (*value)
+		for (;;) {
+			end = strchr (value, '\n');
+			if (!end)
+				end = value + strlen (value);
+			// an empty line would end the item, so add a space to the lines
+			// made only of spaces, SDReader removes it
+			if (value + strspn (value, " ") == end && !Write (" ", 1))
+				return false;
+			if (end > value && !Write (value, end - value))
+				return false;
+			if (!Write ("\n", 1))
+				return false;
+			if (!*end)
+				break;
+			value = end + 1;
+		}
+	return Write ("\n", 1);
+}
+
+bool SDWriter::EndRecord ()
+{
+	if (!m_InRecord)
+		return false;
+	m_InRecord = false;
+	m_Records++;
+	return m_RDfile || Write ("$$$$\n", 5);
+}
+
+bool SDWriter::WriteRecord (SDReader const &reader)
+{
+	SDRecordType type = reader.GetType ();
+	if (!m_RDfile && type == SD_RECORD_NONE)
+		type = SD_RECORD_MOLECULE;
+	if (!BeginRecord (type, reader.GetRegistryNumber ().c_str ()))
+		return false;
+	unsigned i, max = reader.GetLines ();
+	char const *line;
+	for (i = 0; i < max; i++) {
+		// lines might be empty, so don't use WriteBlock ()
+		line = reader.GetLine (i);
+		if (!Write (line, strlen (line)) || !Write ("\n", 1))
+			return false;
+	}
+	max = reader.GetDataCount ();
+	for (i = 0; i < max; i++)
+		if (!WriteData (reader.GetDataName (i).c_str (), reader.GetDataValue (i).c_str ()))
+			return false;
+	return EndRecord ();
+}
+
+}	//	namespace gcu
@@ -0,0 +1,265 @@
+// -*- C++ -*-
+
+/*
+ * Gnome Chemistry Utils
+ * gcu/sdfile.h
+ *
+ * Copyright (C) 2026 Jean Bréfort <jean.brefort@normalesup.org>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301
+ * USA
+ */
+
+#ifndef GCU_SDFILE_H
+#define GCU_SDFILE_H
+
+#include <gsf/gsf-input.h>
+#include <gsf/gsf-output.h>
+#include <string>
+#include <utility>
+#include <vector>
+
+/*!\file*/
+namespace gcu
+{
+
+class LineReader;
+
+/*!\enum SDRecordType gcu/sdfile.h
+The type of the structure stored in a SDfile or RDfile record.
+*/
+typedef enum {
+/*!
+The record does not have any structure, as RDfile records only giving a
+registry number.
+*/
+	SD_RECORD_NONE,
+/*!
+The record structure is a molfile.
+*/
+	SD_RECORD_MOLECULE,
+/*!
+The record structure is a RXN file.
+*/
+	SD_RECORD_REACTION
+} SDRecordType;
+
+class SDReader;
+
+/*!
+@param reader the SDReader.
+@param data the user data passed to SDReader::ForEach().
+
+The type of the callbacks used by SDReader::ForEach().
+@return false to stop reading.
+*/
+typedef bool (*SDRecordCallback) (SDReader *reader, void *data);
+
+/*!\class SDReader gcu/sdfile.h
+Reads SDfiles and RDfiles one record at a time, so that files with millions of
+records can be processed with a memory use bounded by the largest record. The
+file type is detected from its first line. Single molfiles and RXN files are
+read as files with only one record.
+
+For each record, the lines of the structure block (the molfile up to and
+including "M  END", or the RXN file) are available through GetLine(), and the
+data items ("> <NAME>" fields of SDfiles, or $DTYPE/$DATUM pairs of RDfiles)
+through GetDataName() and GetDataValue(). Multiple lines values are joined
+with "\n", and the space SDWriter adds to SDfile value lines made only of
+spaces is removed.
+*/
+class SDReader
+{
+public:
+/*!
+@param input the GsfInput to read, which must stay alive as long as the reader.
+*/
+	SDReader (GsfInput *input);
+/*!
+The destructor.
+*/
+	~SDReader ();
+
+/*!
+Reads the next record. The data of the previous record are lost.
+@return false at the end of the input.
+*/
+	bool Next ();
+/*!
+@param cb the function to call for each record.
+@param data user data to pass to \a cb.
+
+Reads the remaining records and calls \a cb for each of them until it returns
+false.
+@return the number of records read.
+*/
+	unsigned ForEach (SDRecordCallback cb, void *data);
+
+/*!
+@return true if the input is a RDfile.
+*/
+	bool IsRDfile () const {return m_RDfile;}
+/*!
+@return the current record type.
+*/
+	SDRecordType GetType () const {return m_Type;}
+/*!
+@return the current record number, starting from 1.
+*/
+	unsigned GetRecord () const {return m_Record;}
+/*!
+@return the number of the input line where the current record starts.
+*/
+	unsigned GetFirstLine () const {return m_FirstLine;}
+/*!
+@return the registry number of the current RDfile record given by $MIREG or
+$RIREG, or an empty string.
+*/
+	std::string const &GetRegistryNumber () const {return m_RegNo;}
+/*!
+@return the number of lines in the structure block of the current record.
+*/
+	unsigned GetLines () const {return m_Lines.size ();}
+/*!
+@param i a line index.
+@return the line or NULL if \a i is out of range. The line is owned by the
+reader and remains valid until the next call to Next().
+*/
+	char const *GetLine (unsigned i) const {return (i < m_Lines.size ())? &m_Buffer[m_Lines[i]]: NULL;}
+/*!
+@return the structure title, that is the first line of a molfile, or the
+second one of a RXN file.
+*/
+	char const *GetTitle () const;
+/*!
+@return the number of data items in the current record.
+*/
+	unsigned GetDataCount () const {return m_Data.size ();}
+/*!
+@param i a data item index.
+@return the data item name.
+*/
+	std::string const &GetDataName (unsigned i) const {return m_Data[i].first;}
+/*!
+@param i a data item index.
+@return the data item value.
+*/
+	std::string const &GetDataValue (unsigned i) const {return m_Data[i].second;}
+/*!
+@param name a data item name.
+@return the value of the first data item named \a name, or NULL.
+*/
+	char const *GetData (char const *name) const;
+
+private:
+	char const *ReadLine ();
+	void AddLine (char const *line);
+	bool ReadSDRecord ();
+	bool ReadRDRecord ();
+	void StartRDRecord (char const *line);
+
+private:
+	LineReader *m_Input;
+	bool m_RDfile, m_Started;
+	// a RDfile record start line read with the previous record
+	bool m_Pending;
+	std::string m_PendingLine;
+	SDRecordType m_Type;
+	unsigned m_Record, m_FirstLine;
+	std::string m_RegNo;
+	// the structure block lines, null terminated, are stored contiguously
+	std::vector <char> m_Buffer;
+	std::vector <size_t> m_Lines;
+	std::vector < std::pair <std::string, std::string> > m_Data;
+};
+
+/*!\class SDWriter gcu/sdfile.h
+Writes SDfiles or RDfiles one record at a time. A record is started with
+BeginRecord(), followed by its structure block and its data items, and ended
+with EndRecord(). Nothing is kept in memory between records.
+*/
+class SDWriter
+{
+public:
+/*!
+@param output the GsfOutput to write to, which must stay alive as long as the
+writer.
+@param rdfile whether to write a RDfile instead of a SDfile.
+*/
+	SDWriter (GsfOutput *output, bool rdfile = false);
+/*!
+The destructor.
+*/
+	~SDWriter ();
+
+/*!
+@param type the structure type, only meaningful for RDfiles, since SDfiles
+only contain molecules.
+@param regno an optional RDfile registry number.
+
+Starts a new record, ending the previous one if needed.
+@return false on error.
+*/
+	bool BeginRecord (SDRecordType type = SD_RECORD_MOLECULE, char const *regno = NULL);
+/*!
+@param text the structure block, a molfile or a RXN file.
+@param length the text length, or -1 if \a text is null terminated.
+
+Writes the structure block. A missing final new line is added.
+@return false on error.
+*/
+	bool WriteBlock (char const *text, gssize length = -1);
+/*!
+@param name the data item name.
+@param value the data item value, lines being separated by "\n".
+
+Writes a data item. Since a blank line ends a SDfile data item, a space is
+added to the lines made only of spaces, including empty lines, and SDReader
+removes it when reading them back.
+@return false on error.
+*/
+	bool WriteData (char const *name, char const *value);
+/*!
+Ends the current record.
+@return false on error.
+*/
+	bool EndRecord ();
+/*!
+@param reader a SDReader.
+
+Copies the current record of \a reader, so that records can be filtered or
+converted between SDfiles and RDfiles without parsing their structures.
+@return false on error.
+*/
+	bool WriteRecord (SDReader const &reader);
+
+/*!
+@return the number of records written so far.
+*/
+	unsigned GetRecords () const {return m_Records;}
+
+private:
+	bool Write (char const *data, size_t length);
+	bool WriteHeader ();
+
+private:
+	GsfOutput *m_Output;
+	bool m_RDfile, m_InRecord, m_HeaderWritten;
+	unsigned m_Records;
+};
+
+}	//	namespace gcu
+
+#endif	//	GCU_SDFILE_H
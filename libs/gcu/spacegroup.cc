@@ -23,6 +23,7 @@
 #include "config.h"
 
 #include "spacegroup.h"
+#include "dbimage.h"
 #include "transform3d.h"
 
 #include <gsf/gsf-input-gio.h>
@@ -36,6 +37,7 @@
 #include <vector>
 #include <locale>
 
+#include <cmath>
 #include <cstdarg>
 #include <cstdlib>
 
@@ -159,9 +161,49 @@ GSF_XML_IN_NODE_END
 
 void SpaceGroups::Init ()
 {
+	DatabaseImage const *image = DatabaseImage::Get ();
+	if (image) {
+		// all groups are needed as soon as one is looked for, so build them at once
+		unsigned i, j, k, n, nnames;
+		DbSpaceGroup const *records = image->GetRecords <DbSpaceGroup> (DB_SECTION_SPACE_GROUPS, n);
+		vector <SpaceGroup *> groups (n);
+		for (i = 0; i < n; i++) {
+			SpaceGroup *group = groups[i] = new SpaceGroup ();
+			sgs.insert (group);
+			group->m_Id = records[i].id;
+			group->m_CoordinateAlternative = records[i].alternative;
+			char const *name = image->GetString (records[i].hm);
+			if (name)
+				group->m_HMName = name;
+			name = image->GetString (records[i].hall);
+			if (name)
+				group->m_HallName = name;
+			if (group->m_Id > 0 && group->m_Id <= 230)
+				sgbi[group->m_Id - 1].push_back (group);
+			DbOperation const *ops = image->GetRecords <DbOperation> (DB_SECTION_OPERATIONS, records[i].operations);
+			for (j = 0; ops && j < records[i].operations.count; j++) {
+				double m[3][3], t[3];
+				for (k = 0; k < 3; k++) {
+					m[k][0] = ops[j].values[4 * k];
+					m[k][1] = ops[j].values[4 * k + 1];
+					m[k][2] = ops[j].values[4 * k + 2];
+					t[k] = ops[j].values[4 * k + 3];
+				}
+				group->AddTransform (new Transform3d (m, t));
+			}
+		}
+		DbSpaceGroupName const *names = image->GetRecords <DbSpaceGroupName> (DB_SECTION_SPACE_GROUP_NAMES, nnames);
+		for (i = 0; i < nnames; i++) {
+			char const *name = image->GetString (names[i].name);
+			if (name && names[i].group < n)
+				sgbn[name] = groups[names[i].group];
+		}
+		m_Init = true;
+		return;
+	}
 	GError *error = NULL;
 	// do not use BODR space groups database for now until it is fully verified and fixed
-	GsfInput *in = gsf_input_gio_new_for_path (PKGDATADIR"/space-groups.xml", &error);
+	GsfInput *in = gsf_input_gio_new_for_path (DatabaseImage::GetDataFile ("space-groups.xml").c_str (), &error);
 	if (error) {
 		cerr << _("Could not find space groups definitions in ") << BODR_PKGDATADIR"/space-groups.xml" << endl;
 		cerr << _("Error is: ") << error->message << endl;
@@ -295,44 +337,90 @@ void SpaceGroup::AddTransform(const string &s)
 		v.GetRefZ () += 1.;
 	else if (v.GetZ () >= 1.)
 		v.GetRefZ () -= 1.;
-	m_Transforms.push_back (new Transform3d (m, v));
+	AddTransform (new Transform3d (m, v));
+}
+
+void SpaceGroup::AddTransform (Transform3d *t)
+{
+	m_Transforms.push_back (t);
+	// the constructor normalizes the translation, so get it back from the transform
+	Vector o = *t * Vector (0., 0., 0.),
+		u[3] = {*t * Vector (1., 0., 0.), *t * Vector (0., 1., 0.), *t * Vector (0., 0., 1.)};
+	for (unsigned i = 0; i < 3; i++) {
+		m_Operations.push_back (u[0][i] - o[i]);
+		m_Operations.push_back (u[1][i] - o[i]);
+		m_Operations.push_back (u[2][i] - o[i]);
+		m_Operations.push_back (o[i]);
+	}
 }
 
 /*!
 */
 list<Vector> SpaceGroup::Transform (const Vector &v) const
 {
-	static double prec = 2e-5;
 	list<Vector> res;
-	list <Transform3d*>::const_iterator i, iend = m_Transforms.end ();
-	for (i = m_Transforms.begin (); i!= iend; i++) {
-		Vector t;
-		t = *(*i) * v;
-		if (t.GetX () < 0.)
-			t.GetRefX () += 1.;
-		else if (t.GetX () >= 1.)
-			t.GetRefX () -= 1.;
-		if (t.GetY () < 0.)
-			t.GetRefY () += 1.;
-		else if (t.GetY () >= 1.)
-			t.GetRefY () -= 1.;
-		if (t.GetZ () < 0.)
-			t.GetRefZ () += 1.;
-		else if (t.GetZ () >= 1.)
-			t.GetRefZ () -= 1.;
-		list <Vector>::iterator j, jend = res.end ();
-		bool duplicate = false;
-		for (j = res.begin (); j != jend; j++)
-			if (fabs(t.GetX () - (*j).GetX ()) < prec &&
-				fabs(t.GetY () - (*j).GetY ()) < prec &&
-				fabs(t.GetZ () - (*j).GetZ ()) < prec) {
-				duplicate = true;
-				break;
+	double position[3] = {v.GetX (), v.GetY (), v.GetZ ()};
+	vector <double> images (3 * m_Transforms.size ());
+	unsigned i, n = Expand (position, 1, images.empty ()? NULL: &images[0], NULL);
+	for (i = 0; i < n; i++)
+		res.push_back (Vector (images[3 * i], images[3 * i + 1], images[3 * i + 2]));
+	return res;
+}
+
+/*!
+*/
+unsigned SpaceGroup::Expand (double const *positions, unsigned n, double *images, unsigned *counts) const
+{
+	static double prec = 2e-5;
+	unsigned nops = m_Transforms.size (), i, k, l, total = 0, first;
+	// first evaluate the images operation by operation, so that the inner loop
+	// only uses constant coefficients and has no branch
+	for (k = 0; k < nops; k++) {
+		double const *op = &m_Operations[12 * k];
+		double m00 = op[0], m01 = op[1], m02 = op[2], t0 = op[3],
+		       m10 = op[4], m11 = op[5], m12 = op[6], t1 = op[7],
+		       m20 = op[8], m21 = op[9], m22 = op[10], t2 = op[11], x, y, z;
+		double const *p = positions;
+		double *out = images + 3 * k;
+		for (i = 0; i < n; i++, p += 3, out += 3 * nops) {
+			x = m00 * p[0] + m01 * p[1] + m02 * p[2] + t0;
+			y = m10 * p[0] + m11 * p[1] + m12 * p[2] + t1;
+			z = m20 * p[0] + m21 * p[1] + m22 * p[2] + t2;
+			x += (x < 0.)? 1.: 0.;
+			x -= (x >= 1.)? 1.: 0.;
+			y += (y < 0.)? 1.: 0.;
+			y -= (y >= 1.)? 1.: 0.;
+			z += (z < 0.)? 1.: 0.;
+			z -= (z >= 1.)? 1.: 0.;
+			out[0] = x;
+			out[1] = y;
+			out[2] = z;
+		}
+	}
+	// then eliminate the duplicates, moving the images to their final place,
+	// which is never after their current place
+	for (i = 0; i < n; i++) {
+		first = total;
+		for (k = 0; k < nops; k++) {
+			double const *p = images + 3 * (i * nops + k);
+			for (l = first; l < total; l++) {
+				double const *q = images + 3 * l;
+				if (fabs (p[0] - q[0]) < prec && fabs (p[1] - q[1]) < prec && fabs (p[2] - q[2]) < prec)
+					break;
 			}
-		if (!duplicate)
-			res.push_back (t);
+			if (l < total)
+				continue;
+			double *q = images + 3 * total++;
+			if (q != p) {
+				q[0] = p[0];
+				q[1] = p[1];
+				q[2] = p[2];
+			}
+		}
+		if (counts)
+			counts[i] = total - first;
 	}
-	return res;
+	return total;
 }
 
 /*!
@@ -509,6 +597,59 @@ find_by_id:
 	return NULL;
 }
 
+void SpaceGroup::SaveImage (DatabaseImageWriter &writer)
+{
+	if (!_SpaceGroups.Inited ())
+		_SpaceGroups.Init ();
+	// the groups are saved by identifier, so that sgbi lists keep their order
+	vector <SpaceGroup const *> groups;
+	map <SpaceGroup const *, unsigned> indices;
+	unsigned i, j, k;
+	for (i = 0; i < 230; i++) {
+		list <SpaceGroup const *>::const_iterator l, lend = _SpaceGroups.sgbi[i].end ();
+		for (l = _SpaceGroups.sgbi[i].begin (); l != lend; l++)
+			if (indices.find (*l) == indices.end ()) {
+				indices[*l] = groups.size ();
+				groups.push_back (*l);
+			}
+	}
+	set <SpaceGroup *>::iterator s, send = _SpaceGroups.sgs.end ();
+	for (s = _SpaceGroups.sgs.begin (); s != send; s++)
+		if (indices.find (*s) == indices.end ()) {
+			indices[*s] = groups.size ();
+			groups.push_back (*s);
+		}
+	for (i = 0; i < groups.size (); i++) {
+		SpaceGroup const *group = groups[i];
+		DbSpaceGroup record;
+		record.id = group->m_Id;
+		record.alternative = group->m_CoordinateAlternative;
+		record.hm = writer.AddString (group->m_HMName);
+		record.hall = writer.AddString (group->m_HallName);
+		record.operations.first = writer.GetCount (DB_SECTION_OPERATIONS);
+		record.operations.count = group->m_Transforms.size ();
+		for (j = 0; j < record.operations.count; j++) {
+			DbOperation op;
+			for (k = 0; k < 12; k++) {
+				double x = group->m_Operations[12 * j + k];
+				// remove the rounding errors of the matrix coefficients
+				op.values[k] = (k % 4 != 3 && fabs (x - floor (x + .5)) < 1e-10)? floor (x + .5): x;
+			}
+			writer.AddRecord (DB_SECTION_OPERATIONS, op);
+		}
+		writer.AddRecord (DB_SECTION_SPACE_GROUPS, record);
+	}
+	map <string, SpaceGroup const *>::iterator n, nend = _SpaceGroups.sgbn.end ();
+	for (n = _SpaceGroups.sgbn.begin (); n != nend; n++) {
+		if (!(*n).second)
+			continue;
+		DbSpaceGroupName name;
+		name.name = writer.AddString ((*n).first);
+		name.group = indices[(*n).second];
+		writer.AddRecord (DB_SECTION_SPACE_GROUP_NAMES, name);
+	}
+}
+
 std::list <SpaceGroup const *> &SpaceGroup::GetSpaceGroups (unsigned id)
 {
 	if (!_SpaceGroups.Inited ())
@@ -26,12 +26,14 @@
 #include "macros.h"
 #include <string>
 #include <list>
+#include <vector>
 
 namespace gcu
 {
 
 class Transform3d;
 class Vector;
+class DatabaseImageWriter;
 
 /*!\class SpaceGroup spacegroup.h <openbabel/math/spacegroup.h>
 @brief Handle crystallographic space group symmetry
@@ -41,6 +43,8 @@ class Vector;
 class SpaceGroup
 {
 friend class SpaceGroupPrivate;
+friend class SpaceGroups;
+friend class DatabaseImage;
 public:
 /*!
 Constructs a new empty, and then invalid, SpaceGroup.
@@ -68,6 +72,21 @@ eliminates duplicates.
 @return the list of the images of \a v.
 */
 	std::list<Vector> Transform (Vector const &v) const;
+/*!
+@param positions the net coordinates of the positions to expand, as x, y, z
+triplets.
+@param n the number of positions.
+@param images where to store the images.
+@param counts where to store the number of images of each position, might be
+NULL.
+
+Evaluates the images of all positions at once, without any allocation. The
+images of each position are stored consecutively, in the same order and with
+the same duplicates elimination as Transform(). \a images must have room for
+3 * \a n * GetTransformsNumber() values.
+@return the total number of images.
+*/
+	unsigned Expand (double const *positions, unsigned n, double *images, unsigned *counts) const;
 
 /*!
 @param i an uninitialized iterator.
@@ -155,7 +174,12 @@ Inequality operator.
 	unsigned GetTransformsNumber () const {return m_Transforms.size ();}
 
 private:
+	void AddTransform (Transform3d *t);
+	static void SaveImage (DatabaseImageWriter &writer);
+
 	std::list<Transform3d*> m_Transforms;
+	// the transforms as 3x4 matrices, the last column being the translation
+	std::vector <double> m_Operations;
 
 /*!\fn SetHMName(std::string name)
 @param name the Hermann-Maugin name.
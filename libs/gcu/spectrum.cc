@@ -0,0 +1,167 @@
+// -*- C++ -*-
+
+/*
+ * Gnome Chemistry Utils
+ * gcu/spectrum.cc
+ *
+ * Copyright (C) 2026 Jean Bréfort <jean.brefort@normalesup.org>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301
+ * USA
+ */
+
+
+#include "config.h"
+#include "spectrum.h"
+#include <goffice/goffice.h>
+#include <glib.h>
+#include <cmath>
+
+namespace gcu {
+
+bool IntegrateSpectrum (double const *x, double const *y, unsigned n, double *integral)
+{
+	if (n < 2)
+		return false;
+	double *xn[5], *yb, cur, acc, max, delta;
+	unsigned i, used = 0;
+	for (i = 0; i < 5; i++)
+		xn[i] = new double[n];
+	yb = new double[n];
+	go_range_max (y, n, &max);
+	max *= 0.005;
+	integral[0] = 0.;
+	for (i = 1; i < n; i++) {
+		delta = 0.5 * (y[i - 1] + y[i]);
+		integral[i] = integral[i - 1] + delta;
+		if (delta < max) {
+			// use this point to evaluate the baseline
+			cur = xn[0][used] = x[i];
+			acc = xn[1][used] = cur * cur;
+			xn[2][used] = (acc *= cur);
+			xn[3][used] = (acc *= cur);
+			xn[4][used] = acc * cur;
+			yb[used] = (used > 0)? yb[used - 1] + delta: delta;
+			used++;
+		}
+	}
+	go_regression_stat_t reg;
+	double res[6];
+	bool corrected = used > 6 && go_linear_regression (xn, 5, yb, used, true, res, &reg) == GO_REG_ok;
+	if (corrected) {
+		for (i = 0; i < n; i++) {
+			cur = x[i];
+			acc = cur * cur;
+			integral[i] -= res[0] + res[1] * cur + res[2] * acc;
+			integral[i] -= res[3] * (acc *= cur);
+			integral[i] -= res[4] * (acc *= cur);
+			integral[i] -= res[5] * cur * acc;
+		}
+		g_free (reg.se);
+		g_free (reg.t);
+		g_free (reg.xbar);
+	}
+	if (x[1] > x[0])
+		for (i = 0; i < n; i++)
+			integral[i] = -integral[i];
+	for (i = 0; i < 5; i++)
+		delete [] xn[i];
+	delete [] yb;
+	return corrected;
+}
+
+static bool is_unit (char const *unit, char const *name, char const *alias = NULL)
+{
+	return !g_ascii_strcasecmp (unit, name) || (alias && !g_ascii_strcasecmp (unit, alias));
+}
+
+static double mult (double val, double f, double offset)
+{
+	return val * f + offset;
+}
+
+static double inv (double val, double f, double offset)
+{
+	return f / val + offset;
+}
+
+static double logm (double val, double f, double offset)
+{
+	return -log10 (val * f + offset);
+}
+
+static double expm (double val, double f, double offset)
+{
+	return pow (10., -val) * f + offset;
+}
+
+SpectrumUnitConversion GetSpectrumUnitConversion (char const *from, char const *to, double freq, double &factor, double &offset)
+{
+	factor = 1.;
+	offset = 0.;
+	if (!g_ascii_strcasecmp (from, to))
+		return NULL;
+	if (is_unit (from, "1/CM")) {
+		if (is_unit (to, "NANOMETERS", "NM"))
+			factor = 1.e7;
+		else if (is_unit (to, "MICROMETERS"))
+			factor = 1.e4;
+		else
+			return NULL;
+		return inv;
+	}
+	if (is_unit (from, "NANOMETERS", "NM") || is_unit (from, "MICROMETERS")) {
+		bool nm = is_unit (from, "NANOMETERS", "NM");
+		if (is_unit (to, "1/CM")) {
+			factor = nm? 1.e7: 1.e4;
+			return inv;
+		}
+		if (nm && is_unit (to, "MICROMETERS"))
+			factor = 1.e-3;
+		else if (!nm && is_unit (to, "NANOMETERS", "NM"))
+			factor = 1.e3;
+		else
+			return NULL;
+		return mult;
+	}
+	if (is_unit (from, "TRANSMITTANCE"))
+		return is_unit (to, "ABSORBANCE")? logm: NULL;
+	if (is_unit (from, "ABSORBANCE"))
+		return is_unit (to, "TRANSMITTANCE")? expm: NULL;
+	if (!go_finite (freq) || freq == 0.)
+		return NULL;
+	if (is_unit (from, "PPM") && is_unit (to, "HZ"))
+		factor = freq;
+	else if (is_unit (from, "HZ") && is_unit (to, "PPM"))
+		factor = 1. / freq;
+	else
+		return NULL;
+	return mult;
+}
+
+bool ConvertSpectrumUnit (char const *from, char const *to, double freq, double *values, unsigned n)
+{
+	if (!g_ascii_strcasecmp (from, to))
+		return true;
+	double factor, offset;
+	SpectrumUnitConversion conv = GetSpectrumUnitConversion (from, to, freq, factor, offset);
+	if (!conv)
+		return false;
+	for (unsigned i = 0; i < n; i++)
+		values[i] = conv (values[i], factor, offset);
+	return true;
+}
+
+}	//	namespace gcu
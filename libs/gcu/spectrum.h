@@ -0,0 +1,89 @@
+// -*- C++ -*-
+
+/*
+ * Gnome Chemistry Utils
+ * gcu/spectrum.h
+ *
+ * Copyright (C) 2026 Jean Bréfort <jean.brefort@normalesup.org>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301
+ * USA
+ */
+
+
+#ifndef GCU_SPECTRUM_H
+#define GCU_SPECTRUM_H
+
+namespace gcu {
+
+/*!\file
+Spectra processing functions which do not need any user interface.
+*/
+
+/*!
+@param x the abscissas.
+@param y the ordinates.
+@param n the number of points.
+@param integral where to store the integral, must be able to hold \a n values.
+
+Evaluates the cumulative integral of a spectrum, and subtracts a fifth order
+polynomial baseline fitted on the regions where the signal is lower than 0.5%
+of its maximum. The integral is positive when the abscissas decrease, as for
+chemical shifts.
+@return true if the baseline could be evaluated, false if the integral has not
+been corrected.
+*/
+bool IntegrateSpectrum (double const *x, double const *y, unsigned n, double *integral);
+
+/*!
+A function converting a value to another unit, given the factor and offset
+returned by GetSpectrumUnitConversion().
+*/
+typedef double (*SpectrumUnitConversion) (double value, double factor, double offset);
+
+/*!
+@param from the unit of the values, as used in the XUNITS and YUNITS labels of
+JCAMP-DX files.
+@param to the new unit.
+@param freq the observe frequency in MHz, only needed to convert between HZ
+and PPM.
+@param factor where to store the factor to pass to the returned function.
+@param offset where to store the offset to pass to the returned function.
+
+Supported units are 1/CM, NANOMETERS (or NM) and MICROMETERS for abscissas of
+optical spectra, HZ and PPM for NMR spectra, and TRANSMITTANCE and ABSORBANCE
+for ordinates.
+@return the conversion function, or NULL if the conversion is not supported or
+if both units are the same.
+*/
+SpectrumUnitConversion GetSpectrumUnitConversion (char const *from, char const *to, double freq, double &factor, double &offset);
+
+/*!
+@param from the unit of the values, as used in the XUNITS and YUNITS labels of
+JCAMP-DX files.
+@param to the new unit.
+@param freq the observe frequency in MHz, only needed to convert between HZ
+and PPM.
+@param values the values to convert.
+@param n the number of values.
+
+Converts values in place using GetSpectrumUnitConversion().
+@return true on success, false if the conversion is not supported.
+*/
+bool ConvertSpectrumUnit (char const *from, char const *to, double freq, double *values, unsigned n);
+
+}	//	namespace gcu
+
+#endif	//	GCU_SPECTRUM_H
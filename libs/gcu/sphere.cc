@@ -88,6 +88,12 @@ void Sphere::draw (Vector const &center, double radius) const
 	glPopMatrix ();
 }
 
+void Sphere::detach ()
+{
+	d->displayList = 0;
+	d->isValid = false;
+}
+
 #define USE_OCTAHEDRON_VERTEX(i) glNormal3fv(octahedronVertices[i]); \
                                  glVertex3fv(octahedronVertices[i]);
 
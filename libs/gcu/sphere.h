@@ -78,6 +78,10 @@ public:
 	/** draws the sphere at specified position and with
 	* specified radius */
 	void draw (Vector const &center, double radius) const;
+
+	/** forgets the display list without deleting it. This is used
+	* when the GL context owning the list has been destroyed. */
+	void detach ();
 };
 
 }
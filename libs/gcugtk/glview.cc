@@ -25,6 +25,7 @@
 #include "config.h"
 #include "glapplication.h"
 #include "glview.h"
+#include <gcu/geometry-cache.h>
 #include <gcu/gldocument.h>
 #include <GL/gl.h>
 #include <GL/glx.h>
@@ -41,6 +42,7 @@ class GLViewPrivate
 {
 public:
 	static bool OnInit (GLView* View);
+	static void OnUnrealize (GLView* View);
 	static bool OnReshape (GLView* View, GdkEventConfigure *event);
 	static bool OnDraw (GLView* View, cairo_t *cr);
 	static bool OnMotion (G_GNUC_UNUSED GtkWidget *widget, GdkEventMotion *event, GLView* View);
@@ -85,6 +87,19 @@ bool GLViewPrivate::OnInit (GLView* View)
 	return true;
 }
 
+void GLViewPrivate::OnUnrealize (GLView* View)
+{
+	if (!View->m_Window)
+		return;
+	// delete the display lists and buffers while the window still exists
+	gcu::GeometryCache::ReleaseContext (View->m_Context, View->GLBegin ());
+	glXMakeCurrent (GDK_WINDOW_XDISPLAY (View->m_Window), None, NULL);
+	glXDestroyContext (GDK_WINDOW_XDISPLAY (View->m_Window), View->m_Context);
+	XFree (View->m_VisualInfo);
+	View->m_Window = NULL;
+	View->m_bInit = false;
+}
+
 bool GLViewPrivate::OnReshape (GLView* View, GdkEventConfigure *event)
 {
 	View->Reshape (event->width, event->height);
@@ -175,6 +190,9 @@ GLView::GLView (gcu::GLDocument* pDoc) throw (std::runtime_error): gcu::GLView (
 	// Do initialization when widget has been realized.
 	g_signal_connect_swapped (G_OBJECT (m_Widget), "realize",
 				G_CALLBACK (GLViewPrivate::OnInit), this);
+	// Free the GL objects before the window is destroyed.
+	g_signal_connect_swapped (G_OBJECT (m_Widget), "unrealize",
+				G_CALLBACK (GLViewPrivate::OnUnrealize), this);
 	// When window is resized viewport needs to be resized also.
 	g_signal_connect_swapped (G_OBJECT (m_Widget), "configure_event",
 				G_CALLBACK (GLViewPrivate::OnReshape), this);
@@ -198,10 +216,7 @@ GLView::GLView (gcu::GLDocument* pDoc) throw (std::runtime_error): gcu::GLView (
 
 GLView::~GLView ()
 {
-	if (m_Window) {
-		glXDestroyContext (GDK_WINDOW_XDISPLAY (m_Window), m_Context);
-		XFree (m_VisualInfo);
-	}
+	GLViewPrivate::OnUnrealize (this);
 }
 
 void GLView::Update()
@@ -373,6 +388,7 @@ GdkPixbuf *GLView::BuildPixbuf (unsigned width, unsigned height, bool use_bg) co
 		GetDoc ()->Draw(m_Euler);
 		glDisable (GL_BLEND);
 		glFlush ();
+		gcu::GeometryCache::ReleaseContext (ctxt);
 	}
 	// get the pixels and copy to a GdkPixbuf
 	XImage *image = XGetImage (GDK_WINDOW_XDISPLAY (window), pixmap, 0, 0, width, height, AllPlanes, ZPixmap);
@@ -24,6 +24,10 @@
 #include "application.h"
 #include "spectrumdoc.h"
 #include "spectrumview.h"
+#include <gcu/fid.h>
+#include <gcu/input.h>
+#include <gcu/jcamp.h>
+#include <gcu/spectrum.h>
 #include <gcu/objprops.h>
 #include <glib/gi18n-lib.h>
 #include <cstring>
@@ -43,6 +47,9 @@ SpectrumDocument::SpectrumDocument ():
 	gcu::Document (NULL),
 	Printable (),
 	m_XAxisInvertBtn (NULL),
+	m_Phase0Btn (NULL),
+	m_Phase1Btn (NULL),
+	m_Fid (NULL),
 	m_Empty (true)
 {
 	m_View = new SpectrumView (this);
@@ -63,6 +70,9 @@ SpectrumDocument::SpectrumDocument (Application *App, SpectrumView *View):
 	Document (App),
 	Printable (),
 	m_XAxisInvertBtn (NULL),
+	m_Phase0Btn (NULL),
+	m_Phase1Btn (NULL),
+	m_Fid (NULL),
 	m_Empty (true)
 {
 	m_View = (View)? View: new SpectrumView (this);
@@ -90,6 +100,7 @@ SpectrumDocument::~SpectrumDocument ()
 			delete [] variables[i].Values;
 	if (m_View)
 		delete m_View;
+	delete m_Fid;
 }
 
 void SpectrumDocument::Load (char const *uri, char const *mime_type)
@@ -98,51 +109,23 @@ void SpectrumDocument::Load (char const *uri, char const *mime_type)
 	if (!mime_type || strcmp (mime_type, "chemical/x-jcamp-dx")) {
 		return;
 	}
-	GVfs *vfs = g_vfs_get_default ();
-	GFile *file = g_vfs_get_file_for_uri (vfs, uri);
 	GError *error = NULL;
-	GFileInfo *info = g_file_query_info (file,
-										 G_FILE_ATTRIBUTE_STANDARD_SIZE,
-										 G_FILE_QUERY_INFO_NONE,
-										 NULL, &error);
-	if (error) {
-		g_message ("GIO querry failed: %s", error->message);
-		g_error_free (error);
-		g_object_unref (file);
-		return;
-	}
-	gsize size = g_file_info_get_size (info);
-	g_object_unref (info);
-	GInputStream *input = G_INPUT_STREAM (g_file_read (file, NULL, &error));
+	GsfInput *input = gcu::OpenInput (uri, true, &error);
 	if (error) {
 		g_message ("GIO could not create the stream: %s", error->message);
 		g_error_free (error);
-		g_object_unref (file);
 		return;
 	}
-	char *buf = new char[size + 1];
-	gsize n = size;
-	while (n) {
-		n -= g_input_stream_read (input, buf, size, NULL, &error);
-		if (error) {
-			g_message ("GIO could not read the file: %s", error->message);
-			g_error_free (error);
-			delete [] buf;
-			g_object_unref (input);
-			g_object_unref (file);
-			return;
-		}
-	}
-	buf[size] = 0;
-	LoadJcampDx (buf);
+	gsf_off_t size;
+	char const *data = gcu::GetInputData (input, size);
+	if (data)
+		LoadJcampDx (data, size);
 	if (m_App) {
 		char *dirname = g_path_get_dirname (uri);
 		m_App->SetCurDir (dirname);
 		g_free (dirname);
 	}
-	delete [] buf;
-	g_object_unref (file);
-
+	g_object_unref (input);
 }
 
 struct data_type_struct {
@@ -540,70 +523,17 @@ enum {
 	JCAMP_MAX_VALID
 };
 
-#define KEY_LENGTH 80
 #define VALUE_LENGTH 128
-static int ReadField (char const *s, char *key, char *buf)
+static int get_key (std::string const &label)
 {
-	char const *data = s, *eq;
-	int i = 0;
-	while (*data != 0 && *data < '#')
-		data++;
-	if (*data == 0)
-		return JCAMP_INVALID;
-	if (!strncmp (data, "$$", 2)) {
-		// This is a comment, just skip
-		return JCAMP_INVALID;
-	}
-/*	if (!strncmp (data, "##$", 3)) {
-		// This is a vendor specific tag, just skip for now
-		return JCAMP_INVALID;
-	}*/
-	if (!strncmp (data, "##", 2)) {
-		// found a field
-		data += 2;
-		eq = strchr (data, '=');
-		i = 0;
-		if (*data == '$' && strncmp (data, "$$", 2)) {
-			key[i++] = '$';
-			data++;
-		}
-		while (data < eq) {
-			if (*data >= 'A' && *data <= 'Z')
-				key[i++] = *data;
-			else if (*data >= 'a' && *data <= 'z')
-				key[i++] = *data - 0x20;
-			data++;
-		}
-		key[i] = 0;
-		if (i == 0)
-			// This is a comment, just skip
-			return JCAMP_INVALID;
-		data = eq + 1;
-		while (*data != 0 && *data < '$')
-			data++;
-		eq = strstr (data, "$$");
-		if (eq && *eq) {
-			strncpy (buf, data, MIN (eq - data, VALUE_LENGTH));
-			buf[MIN (eq - data, VALUE_LENGTH - 1)] = 0;
-		}
-		else {
-			strncpy (buf, data, VALUE_LENGTH);
-			buf[VALUE_LENGTH - 1] = 0;
-		}
-		// strip trailing white spaces:
-		i = strlen (buf) - 1;
-		if (i < 0)
-			return JCAMP_UNKNOWN;
-		while (buf[i] <= ' ' || buf[i] == '"')
-			buf[i--] = 0;
-
-		// Now, get the key value
-		i = JCAMP_TITLE;
-		while (i < JCAMP_MAX_VALID && strcmp (key, Keys[i]))
-			i++;
-		return i;
-	}
-	return JCAMP_UNKNOWN;
+	// NMR specific labels start with a dot
+	char const *key = label.c_str ();
+	if (*key == '.')
+		key++;
+	int i = JCAMP_TITLE;
+	while (i < JCAMP_MAX_VALID && strcmp (key, Keys[i]))
+		i++;
+	return i;
 }
 
 static void on_xunit_changed (GtkComboBox *box, SpectrumDocument *doc)
@@ -621,6 +551,11 @@ static void on_xaxis_invert (GtkToggleButton *btn, SpectrumDocument *doc)
 	doc->OnXAxisInvert (gtk_toggle_button_get_active (btn));
 }
 
+static void on_phase_changed (G_GNUC_UNUSED GtkSpinButton *btn, SpectrumDocument *doc)
+{
+	doc->OnPhaseChanged ();
+}
+
 static void on_show_integral (GtkButton *btn, SpectrumDocument *doc)
 {
 	gtk_button_set_label (btn, (doc->GetIntegralVisible ()?
@@ -649,14 +584,13 @@ static SpectrumType get_spectrum_type_from_string (char const *buf)
 
 #define JCAMP_PREC 1e-2 // fully arbitrary
 
-void SpectrumDocument::LoadJcampDx (char const *data)
+void SpectrumDocument::LoadJcampDx (char const *data, size_t length)
 {
-	char key[KEY_LENGTH];
 	char buf[VALUE_LENGTH];
-	char line[300]; // should be enough
+	char const *cur = data, *end = data + length;
+	std::string label, value;
 	int n;
 	deltax = 0.;
-	istringstream s(data);
 	JdxVar var;
 	var.NbValues = 0;
 	var.Symbol = 0;
@@ -666,10 +600,11 @@ void SpectrumDocument::LoadJcampDx (char const *data)
 	var.First = var.Last = var.Min = var.Max = var.Factor = 0.;
 	var.Values = NULL;
 	GString *utf8_str = NULL;
-	while (!s.eof ()) {
-		s.getline (line, 300);
-parse_line:
-		n = ReadField (line, key, buf);
+	while (gcu::JcampReader::ReadLabel (cur, end, label, value)) {
+		n = get_key (label);
+		if (value.empty () && n != JCAMP_END)
+			continue;
+		g_strlcpy (buf, value.c_str (), VALUE_LENGTH);
 		switch (n) {
 		case JCAMP_TITLE:
 			go_guess_encoding (buf, strlen (buf), "ASCII", &utf8_str, NULL);
@@ -724,42 +659,32 @@ parse_line:
 			}
 			// FIXME: we should implement a real parser for this value
 			if (!strncmp (buf, "(X++(Y..Y))",strlen ("(X++(Y..Y))")))
-				ReadDataTable (s, x, y);
-			else if (!strncmp (buf, "(XY..XY)",strlen ("(XY..XY)"))) {
-				char *cur;
-				while (1) {
-					if (s.eof ())
-						break;	// this should not occur, but a corrupted or bad file is always possible
-					s.getline (line, 300);
-					if (strstr (line, "##")) {
-						if (read > npoints) {
-							g_warning (_("Found too many data!"));
-							// FIXME: throw an exception
-						} else
-							npoints = read;
-						if (!go_finite (minx))
-							go_range_min (x, read, &minx);
-						if (!go_finite (maxx))
-							go_range_max (x, read, &maxx);
-						if (!go_finite (miny))
-							go_range_min (y, read, &miny);
-						if (!go_finite (maxy))
-							go_range_max (y, read, &maxy);
-						goto parse_line;
-					}
-					cur = line;
-					while (*cur) {
-						while (*cur && (*cur < '0' || *cur > '9') && *cur != '-' && *cur !='+')
-							cur++;
-						if (*cur == 0)
-							break;
-						x[read] = g_ascii_strtod (cur, &cur);
-						while (*cur && (*cur < '0' || *cur > '9') && *cur != '-' && *cur !='+')
-							cur++;
-						y[read] = g_ascii_strtod (cur, &cur);
-						read++;
-					}
+				cur = ReadDataTable (cur, end, x, y);
+			else if (!strncmp (buf, "(XY..XY)", strlen ("(XY..XY)")) ||
+			         !strncmp (buf, "(XYW..XYW)", strlen ("(XYW..XYW)")) ||
+			         !strncmp (buf, "(XYM..XYM)", strlen ("(XYM..XYM)"))) {
+				std::vector <double> px, py;
+				cur = gcu::JcampReader::ReadPoints (cur, end, (buf[3] == '.')? 2: 3, xfactor, yfactor, px, py);
+				unsigned read = px.size ();
+				if (read > npoints) {
+					delete [] x;
+					x = new double[read];
+					delete [] y;
+					y = new double[read];
+				}
+				npoints = read;
+				if (read > 0) {
+					memcpy (x, &px[0], read * sizeof (double));
+					memcpy (y, &py[0], read * sizeof (double));
 				}
+				if (!go_finite (minx))
+					go_range_min (x, read, &minx);
+				if (!go_finite (maxx))
+					go_range_max (x, read, &maxx);
+				if (!go_finite (miny))
+					go_range_min (y, read, &miny);
+				if (!go_finite (maxy))
+					go_range_max (y, read, &maxy);
 			}
 			break;
 		}
@@ -1097,7 +1022,8 @@ parse_line:
 			break;
 		}
 		case JCAMP_PAGE: {
-			unsigned num = atoi (strchr (buf, '=') + 1);
+			char const *eq = strchr (buf, '=');
+			unsigned num = (eq)? atoi (eq + 1): 0;
 			if (num == 1) {
 				unsigned max = 0;
 				for (unsigned i = 0; i < variables.size (); i++) {
@@ -1182,7 +1108,7 @@ parse_line:
 						variables[second].Values = new double[variables[second].NbValues];
 						yfactor = variables[second].Factor;
 						firsty = variables[second].First;
-						ReadDataTable (s, variables[first].Values, variables[second].Values);
+						cur = ReadDataTable (cur, end, variables[first].Values, variables[second].Values);
 					}
 				}
 			} //what should be done for PROFILE, PEAKS and COUTOUR?
@@ -1277,157 +1203,6 @@ out:
 	Loaded ();
 }
 
-void SpectrumDocument::ReadDataLine (char const *data, list<double> &l)
-{
-	int i = 1, j;
-	char buf[32], c = data[0];
-	double val = 0., newval = 0.;
-	bool pos, diff = false;
-	char *eq = strstr (const_cast <char *> (data), "$$");
-	if (eq)
-		*eq = 0;
-	pos = true;
-	while (c) {
-		switch (c) {
-		case ' ':
-			c = data[i++];
-			continue;
-		case '-':
-			pos = false;
-		case '+':
-			c = data[i++];
-			if ((c < '0' || c > '9') && c != '.') // FIXME: throw an exception
-				{;}
-			continue;
-		case '.':
-		case '0':
-		case '1':
-		case '2':
-		case '3':
-		case '4':
-		case '5':
-		case '6':
-		case '7':
-		case '8':
-		case '9':
-			buf[0] = c;
-			diff = false;
-			break;
-		case '@':
-		case 'A':
-		case 'B':
-		case 'C':
-		case 'D':
-		case 'E':
-		case 'F':
-		case 'G':
-		case 'H':
-		case 'I':
-			buf[0] = c - 0x10;
-			diff = false;
-			break;
-		case 'a':
-		case 'b':
-		case 'c':
-		case 'd':
-		case 'e':
-		case 'f':
-		case 'g':
-		case 'h':
-		case 'i':
-			pos = false;
-			diff = false;
-			buf[0] = c - 0x30;
-			break;
-		case '%':
-			c = 'I';
-		case 'J':
-		case 'K':
-		case 'L':
-		case 'M':
-		case 'N':
-		case 'O':
-		case 'P':
-		case 'Q':
-		case 'R':
-			diff = true;
-			buf[0] = c - 0x19;
-			break;
-		case 'j':
-		case 'k':
-		case 'l':
-		case 'm':
-		case 'n':
-		case 'o':
-		case 'p':
-		case 'q':
-		case 'r':
-			pos = false;
-			diff = true;
-			buf[0] = c - 0x39;
-			break;
-		case 's':
-			c = '[';
-		case 'S':
-		case 'T':
-		case 'U':
-		case 'V':
-		case 'W':
-		case 'X':
-		case 'Y':
-		case 'Z': {
-			buf[0] = c - 0x22;
-			j = 1;
-			while (c = data[i++], (c >= '0' && c <= '9')) {
-				if (j == 31) {
-					g_warning (_("Constant too long"));
-					break;
-				}
-				buf[j++] = c;
-			}
-			buf[j] = 0;
-			int m, n = atoi (buf);
-			for (m = 1; m < n; m++) {
-				if (diff)
-					val += newval;
-				l.push_back (val);
-			}
-			continue;
-		}
-		case '?':
-			diff = false;
-			val = go_nan;
-			newval = 0.;
-			l.push_back (go_nan);
-			c = data[i++];
-			continue;
-		default:
-			if (c > ' ')
-				g_warning (_("Invalid character in data block"));
-			c = data[i++];
-			continue;
-		}
-		j = 1;
-		while (c = data[i++], (c >= '0' && c <= '9') || c == '.') {
-			if (j == 31) {
-				g_warning (_("Constant too long"));
-				break;
-			}
-			buf[j++] = c;
-		}
-		buf[j] = 0;
-		newval = g_ascii_strtod (buf, NULL);
-		if (!pos)
-			newval = - newval;
-		if (diff)
-			val += newval;
-		else
-			val = newval;
-		l.push_back (val);
-		pos = true;
-	}
-}
-
 void SpectrumDocument::DoPrint (G_GNUC_UNUSED GtkPrintOperation *print, GtkPrintContext *context, G_GNUC_UNUSED int page) const
 {
 	cairo_t *cr;
@@ -1470,76 +1245,16 @@ GtkWindow *SpectrumDocument::GetGtkWindow ()
 	return (GtkWindow*) ((w)? gtk_widget_get_toplevel (m_View->GetWidget ()): NULL);
 }
 
-void SpectrumDocument::ReadDataTable (istream &s, double *x, double *y)
+char const *SpectrumDocument::ReadDataTable (char const *data, char const *end, double *x, double *y)
 {
-	char line[300]; // should be enough
-	unsigned read = 0;
-	list<double> l;
-	int previous = 0;
-	double previousx = firstx;
-	while (1) {
-		if (s.eof ())
-			break;	// this should not occur, but a corrupted or bad file is always possible
-		s.getline (line, 300);
-		if (strstr (line, "##")) {
-			s.seekg (-strlen (line) -1, s.cur);
-			if (read > npoints) {
-				g_warning (_("Found too many data!"));
-				// FIXME: throw an exception
-			} else
-				npoints = read;
-			break;
-		}
-		ReadDataLine (line, l);
-		if (l.empty ())
-			continue;
-		list<double>::iterator i = l.begin (), end = l.end ();
-		if (read > 0) {
-			double x1 = (*i) * xfactor;
-			int n = read - previous - (int)round((x1-previousx)/deltax);
-			previous = read;
-			previousx = x1;
-			if (n == 0) {
-				// values are the same, no y reminder, and nothing to do
-			} else if (n == 1) {
-				i++;
-				previous--;
-				double y0 = (*i) * yfactor;
-				if (fabs (y0 - y[read - 1]) > fmax (fabs (y0), fabs (y[read - 1])) * JCAMP_PREC)
-					g_warning (_("Data check failed!"));
-			} else if (previousx - x1 < 0.) {
-				unsigned missing = (unsigned) round ((x1 - previousx) / deltax), n;
-				for (n = 0; n < missing; n++) {
-					if (read > npoints) // FIXME: Throw an exception
-						break;
-					x[read] = firstx + deltax * read;
-					y[read++] = go_nan;
-				}
-			} else {
-				// FIXME: duplicate values, throw an exception
-			}
-		} else {
-			x[read] = (*i) * xfactor;
-			if (fabs (x[0] - firstx) > fabs (deltax * JCAMP_PREC)) {
-				xfactor = firstx / (*i);
-				deltax = (lastx - firstx) / (npoints - 1);
-				g_warning (_("Data check failed: FIRSTX!"));
-			}
-			i++;
-			y[read++] = (*i) * yfactor;
-			if (fabs (firsty - y[0]) > fmax (fabs (firsty), fabs (y[0])) * JCAMP_PREC)
-				g_warning (_("Data check failed: FIRSTY!"));
-		}
-		for (i++; i !=	end; i++) {
-			if (read >= npoints) { // FIXME: Throw an exception
-				g_warning (_("Found too many data"));
-				break;
-			}
-			x[read] = firstx + deltax * read;
-			y[read++] = (*i) * yfactor;
-		}
-		l.clear ();
-	}
+	// decode in place from the loaded text
+	gcu::JcampDecoder decoder (x, y, npoints, firstx, lastx, deltax, xfactor, yfactor, firsty);
+	char const *next = decoder.Decode (data, end);
+	unsigned read = decoder.GetRead ();
+	xfactor = decoder.GetXFactor ();
+	deltax = decoder.GetDeltaX ();
+	if (next < end && !decoder.GetOverflow ())
+		npoints = read;
 	if (!go_finite (minx))
 		go_range_min (x, read, &minx);
 	if (!go_finite (maxx))
@@ -1557,6 +1272,7 @@ void SpectrumDocument::ReadDataTable (istream &s, double *x, double *y)
 		maxx = MAX (firstx, lastx);
 		minx = MIN (firstx, lastx);
 	}
+	return next;
 }
 
 void SpectrumDocument::OnXUnitChanged (int i)
@@ -1760,85 +1476,11 @@ void SpectrumDocument::OnYUnitChanged (int i)
 	}
 }
 
-static double mult (double val, double f, double offset)
-{
-	return val * f + offset;
-}
-
-static double inv (double val, double f, double offset)
-{
-	return f / val + offset;
-}
-
-static double logm (double val, double f, double offset)
-{
-	return -log10 (val * f + offset);
-}
-
-static double expm (double val, double f, double offset)
-{
-	return exp10 (-val) * f + offset;
-}
-
 double (*SpectrumDocument::GetConversionFunction (SpectrumUnitType oldu, SpectrumUnitType newu, double &factor, double &shift)) (double, double, double)
 {
-	switch (oldu) {
-	case GCU_SPECTRUM_UNIT_CM_1:
-		if (newu == GCU_SPECTRUM_UNIT_NANOMETERS) {
-			factor = 1.e7;
-			shift = 0;
-			return inv;
-		}
-		if (newu == GCU_SPECTRUM_UNIT_MICROMETERS) {
-			factor = 1.e4;
-			shift = 0;
-			return inv;
-		}
-		break;
-	case GCU_SPECTRUM_UNIT_TRANSMITTANCE:
-		if (newu == GCU_SPECTRUM_UNIT_ABSORBANCE) {
-			factor = 1.;
-			shift = 0.;
-			return logm;
-		}
-		break;
-	case GCU_SPECTRUM_UNIT_ABSORBANCE:
-		if (newu == GCU_SPECTRUM_UNIT_TRANSMITTANCE) {
-			factor = 1.;
-			shift = 0.;
-			return expm;
-		}
-		break;
-	case GCU_SPECTRUM_UNIT_PPM:
-		if (go_finite (freq) && newu == GCU_SPECTRUM_UNIT_HZ) {
-			factor = freq;
-			shift = 0;
-			return mult;
-		}
-		break;
-	case GCU_SPECTRUM_UNIT_NANOMETERS:
-		if (newu == GCU_SPECTRUM_UNIT_CM_1) {
-			factor = 1.e7;
-			shift = 0;
-			return inv;
-		}
-		break;
-	case GCU_SPECTRUM_UNIT_MICROMETERS:
-		if (newu == GCU_SPECTRUM_UNIT_CM_1) {
-			factor = 1.e4;
-			shift = 0;
-			return inv;
-		}
-		break;
-	case GCU_SPECTRUM_UNIT_HZ:
-		if (go_finite (freq) && newu == GCU_SPECTRUM_UNIT_PPM)
-			factor = 1. / freq;
-		shift = 0.;
-		return mult;
-	default:
-		break;
-	}
-	return NULL;
+	if (oldu >= GCU_SPECTRUM_UNIT_MAX || newu >= GCU_SPECTRUM_UNIT_MAX)
+		return NULL;
+	return gcu::GetSpectrumUnitConversion (Units[oldu], Units[newu], freq, factor, shift);
 }
 
 void SpectrumDocument::OnShowIntegral ()
@@ -1849,7 +1491,7 @@ void SpectrumDocument::OnShowIntegral ()
 		if (integral < 0) {
 			integral = variables.size ();
 			JdxVar v;
-			double *xo, *xn[5], *yb, cur, acc;
+			double *xo;
 			v.Name = _("Integral");
 			v.Symbol = 'i';
 			v.Type = GCU_SPECTRUM_TYPE_DEPENDENT;
@@ -1857,15 +1499,8 @@ void SpectrumDocument::OnShowIntegral ()
 			v.Format = GCU_SPECTRUM_FORMAT_MAX;
 			v.Factor = 1.;
 			v.NbValues = (X >= 0)? variables[X].NbValues: npoints;
-			xn[0] = new double[v.NbValues];
-			xn[1] = new double[v.NbValues];
-			xn[2] = new double[v.NbValues];
-			xn[3] = new double[v.NbValues];
-			xn[4] = new double[v.NbValues];
-			yb = new double[v.NbValues];
 			v.First = 0.;
 			v.Values = new double[v.NbValues];
-			unsigned i;
 			double *z;
 			if (Rp >= 0)
 				z = variables[Rp].Values;
@@ -1876,41 +1511,7 @@ void SpectrumDocument::OnShowIntegral ()
 			else
 				z = y;
 			xo = (X >= 0 && variables[X].Values != NULL)? variables[X].Values: x;
-			double max, delta;
-			unsigned used = 0;
-			go_range_max (z, v.NbValues, &max);
-			max *= 0.005;
-			v.Values[0] = 0.;
-			for (i = 1; i < v.NbValues; i++) {
-				delta = 0.5 * (z[i - 1] + z[i]);
-				v.Values[i] = v.Values[i - 1] + delta;
-				if (delta < max) {
-					cur = xn[0][used] = xo[i];
-					acc = xn[1][used] = cur * cur;
-					xn[2][used] = (acc *= cur);
-					xn[3][used] = (acc *= cur);
-					xn[4][used] = acc * cur;
-					yb[used] = (used > 0)? yb[used - 1] + delta: delta;
-					used++;
-				}
-			}
-			go_regression_stat_t reg;
-			double res[6];
-			go_linear_regression (xn, 5, yb, used, true, res, &reg);
-			for (i = 0; i < v.NbValues; i++) {
-				cur = xo[i];
-				acc = cur * cur;
-				v.Values[i] -= res[0] + res[1] * cur + res[2] * acc;
-				v.Values[i] -= res[3] * (acc *= cur);
-				v.Values[i] -= res[4] * (acc *= cur);
-				v.Values[i] -= res[5] * cur * acc;
-			}
-			if (xo[1] > xo[0])
-				for (i = 0; i < v.NbValues; i++)
-					v.Values[i] = -v.Values[i];
-			g_free (reg.se);
-			g_free (reg.t);
-			g_free (reg.xbar);
+			gcu::IntegrateSpectrum (xo, z, v.NbValues, v.Values);
 			v.Last = v.Max = v.Values[v.NbValues - 1];
 			v.Min = 0.;
 			v.Series = m_View->NewSeries (true);
@@ -1932,12 +1533,6 @@ void SpectrumDocument::OnShowIntegral ()
 			style->line.auto_color = false;
 			style->line.color = GO_COLOR_RED;
 			variables.push_back (v);
-			delete [] xn[0];
-			delete [] xn[1];
-			delete [] xn[2];
-			delete [] xn[3];
-			delete [] xn[4];
-			delete [] yb;
 		} else
 			style = go_styled_object_get_style (GO_STYLED_OBJECT (variables[integral].Series));
 		// show the series
@@ -1954,23 +1549,15 @@ void SpectrumDocument::OnShowIntegral ()
 void SpectrumDocument::OnTransformFID (G_GNUC_UNUSED GtkButton *btn)
 {
 	double *re = variables[R].Values, *im = variables[I].Values;
-	unsigned n = 2;
-	while (n < npoints)
-		n <<= 1;
-	go_complex *fid = new go_complex[n], *sp;
-	unsigned i;
-	for (i = 0; i < npoints; i++) {
-		// assuming we have as many real, imaginary and time values
-		fid[i].re = re[i];
-		fid[i].im = im[i];
-	}
-	for (; i < n; i++) {
-		// fill with zeros
-		fid[i].re =  fid[i].im = 0.;
-	}
-	//we make no apodization at the moment
-	go_fourier_fft (fid, n, 1, &sp, false);
-	delete [] fid;
+	double dwell = (X >= 0 && variables[X].Values != NULL)?
+						(variables[X].Last - variables[X].First) / (npoints - 1):
+						(lastx - firstx) / (npoints - 1);
+	if (!m_Fid)
+		m_Fid = new gcu::FidProcessor ();
+	// assuming we have as many real, imaginary and time values
+	m_Fid->SetFID (re, im, npoints, dwell);
+	m_Fid->AutoPhase ();
+	unsigned n = m_Fid->GetSize ();
 	// copy the unphased data to Rt and It (t for transformed)
 	JdxVar vr, vi, rp, xt;
 	vr.Name = _("Real transformed data");
@@ -1981,6 +1568,7 @@ void SpectrumDocument::OnTransformFID (G_GNUC_UNUSED GtkButton *btn)
 	vr.Factor = 1.;
 	vr.NbValues = n;
 	vr.Values = new double[n];
+	memcpy (vr.Values, m_Fid->GetReal (), n * sizeof (double));
 	vi.Name = _("Imaginary transformed data");
 	vi.Symbol = 'u';
 	vi.Type = GCU_SPECTRUM_TYPE_DEPENDENT;
@@ -1989,18 +1577,7 @@ void SpectrumDocument::OnTransformFID (G_GNUC_UNUSED GtkButton *btn)
 	vi.Factor = 1.;
 	vi.NbValues = n;
 	vi.Values = new double[n];
-	unsigned n2 = n / 2 - 1, j;
-	for (i = 0, j = n2; i < n2; i++, j--) {
-		vr.Values[i] = sp[j].re;
-		vi.Values[i] = sp[j].im;
-	}
-	// the value at 0 must be skipped, doing a linear interpolation
-	vr.Values[i] = (sp[1].re + sp[n - 1].re) / 2.;
-	vi.Values[i++] = (sp[1].im + sp[n - 1].im) / 2.;
-	for (j = n - 1; i < n; i++, j--) {
-		vr.Values[i] = sp[j].re;
-		vi.Values[i] = sp[j].im;
-	}
+	memcpy (vi.Values, m_Fid->GetImaginary (), n * sizeof (double));
 	vr.First = vr.Values[0];
 	vr.Last = vr.Values[n - 1];
 	go_range_min (vr.Values, n, &vr.Min);
@@ -2015,186 +1592,34 @@ void SpectrumDocument::OnTransformFID (G_GNUC_UNUSED GtkButton *btn)
 	vi.Series = NULL;
 	It = variables.size ();
 	variables.push_back (vi);
-	// Now we need to adjust the phase (see http://www.ebyte.it/stan/Poster_EDISPA.html)
-	double phi = 0., tau = 0., *z, maxz = 0., phiopt = 0., tauopt = 0.;
-	z = new double[n];
-	for (i = 0; i < n; i++) {
-		// copy reordered data to sp
-		sp[i].re = vr.Values[i];
-		sp[i].im = vi.Values[i];
-		z[i] = go_complex_mod (sp + i);
-		if (z[i] > maxz)
-			maxz = z[i];
-	}
-	// normalize the z values
-	for (i = 0; i < n; i++)
-		z[i] /= maxz;
-	double c = 0.1;
-	unsigned nmax, nmin;
-	while (c > 0.) {
-		nmin = n, nmax = 0;
-		for (i = 0; i < n; i++)
-			if (z[i] > c) {
-				nmin = i;
-				break;
-			}
-		for (i = n - 1; i > 0; i--)
-			if (z[i] > c) {
-				nmax = i;
-				break;
-			}
-		if ((nmax - nmin) > n / 10) // 10 is arbitrary, but should be not too large
-			break;
-		c /= 2.;
-	}
-	// make a list of indices with z greater than c
-	std::list <unsigned> restricted;
-	for (i = 0; i < n; i++)
-		if (z[i] > c)
-			restricted.push_back (i);
-	// evaluate the predictor in c, since the value is not used anymore
-	double maxc = 0., maxk = 0., p, phis[41];
-	unsigned k;
-	std::list <unsigned>::iterator it, itend = restricted.end ();
-	for (k = 0; k < 41; k++) {
-		tau = -1. + k * .1;
-		maxk = 0.;
-		for (phi = 0; phi <  2 * M_PI; phi += 10. / 180. * M_PI) {
-			c = 0.;
-			for (it = restricted.begin (); it != itend; it++) {
-				i = *it;
-				p = phi - 2. * M_PI * tau * (n - 1 - i) / n;
-				c += z[i] * z[i] * (sp[i].re * cos (p) - sp[i].im * sin (p)) * exp (-fabs (4. * i / n -2));
-			}
-			if (c > maxk) {
-				if (c > maxc) {
-					maxc = c;
-					tauopt = tau;
-					phiopt = phi;
-				}
-				maxk = c;
-				phis[k] = phi;
-			}
-		}
-	}
-	// let's search more finely around the maximum
-	// using the fact that phis[k] is a(n almost) linear function of tau
-	// first, reevaluate the optimum phi for tauopt and previous value and next value with a step of 1°
-	double phase = phiopt;
-	for (phi = phase - 9. / 180. * M_PI; phi < phase + 10. / 180. * M_PI; phi += 1. / 180. * M_PI) {
-			c = 0.;
-			for (it = restricted.begin (); it != itend; it++) {
-				i = *it;
-				p = phi - 2. * M_PI * tauopt * (n - 1 - i) / n;
-				c += z[i] * z[i] * (sp[i].re * cos (p) - sp[i].im * sin (p)) * exp (-fabs (4. * i / n -2));
-			}
-			if (c > maxc) {
-				maxc = c;
-				phiopt = phi;
-			}
-	}
-	for (k = 1; k < 10; k++) {
-		// search with lower values of tau
-		tau = tauopt - 0.01 * k;
-		for (phi = 0; phi <  2 * M_PI; phi += 10. / 180. * M_PI) {
-			c = 0.;
-			maxk = 0;
-			for (it = restricted.begin (); it != itend; it++) {
-				i = *it;
-				p = phi - 2. * M_PI * tau * (n - 1 - i) / n;
-				c += z[i] * z[i] * (sp[i].re * cos (p) - sp[i].im * sin (p)) * exp (-fabs (4. * i / n -2));
-			}
-			if (c > maxk) {
-				phis[0] = phi;
-				maxk = c;
-			}
-		}
-		phase = phis[0];
-		for (phi = phase - 9. / 180. * M_PI; phi < phase + 10. / 180. * M_PI; phi += 1. / 180. * M_PI) {
-				c = 0.;
-				for (it = restricted.begin (); it != itend; it++) {
-					i = *it;
-					p = phi - 2. * M_PI * tau * (n - 1 - i) / n;
-					c += z[i] * z[i] * (sp[i].re * cos (p) - sp[i].im * sin (p)) * exp (-fabs (4. * i / n -2));
-				}
-				if (c > maxk) {
-					maxk = c;
-					phis[0] = phi;
-				}
-		}
-		if (maxk < maxc)
-			break;
-		maxc = maxk;
-		phiopt = phis[0];
-		tauopt = tau;
-	}
-	if (k == 1) {
-		for (k = 1; k < 10; k++) {
-			// search with higher values of tau
-			tau = tauopt + 0.01 * k;
-			for (phi = 0; phi <  2 * M_PI; phi += 10. / 180. * M_PI) {
-				c = 0.;
-				maxk = 0;
-				for (it = restricted.begin (); it != itend; it++) {
-					i = *it;
-					p = phi - 2. * M_PI * tau * (n - 1 - i) / n;
-					c += z[i] * z[i] * (sp[i].re * cos (p) - sp[i].im * sin (p)) * exp (-fabs (4. * i / n -2));
-				}
-				if (c > maxk) {
-					phis[0] = phi;
-					maxk = c;
-				}
-			}
-			phase = phis[0];
-			for (phi = phase - 9. / 180. * M_PI; phi < phase + 10. / 180. * M_PI; phi += 1. / 180. * M_PI) {
-					c = 0.;
-					for (it = restricted.begin (); it != itend; it++) {
-						i = *it;
-						p = phi - 2. * M_PI * tau * (n - 1 - i) / n;
-						c += z[i] * z[i] * (sp[i].re * cos (p) - sp[i].im * sin (p)) * exp (-fabs (4. * i / n -2));
-					}
-					if (c > maxk) {
-						maxk = c;
-						phis[0] = phi;
-					}
-			}
-			if (maxk < maxc)
-				break;
-			maxc = maxk;
-			phiopt = phis[0];
-			tauopt = tau;
-		}
-	}
-	g_free (sp);
-	// set the phase real values
-	// free what needs to be freed
-	delete [] z;
-	// set the corrected values
+	// set the phased real values
+	rp.Name = _("Phased real data");
+	rp.Symbol = 'r';
+	rp.Type = GCU_SPECTRUM_TYPE_DEPENDENT;
+	rp.Unit = GCU_SPECTRUM_UNIT_MAX;
+	rp.Format = GCU_SPECTRUM_FORMAT_MAX;
+	rp.Factor = 1.;
+	rp.NbValues = n;
 	rp.Values = new double[n];
-	//store phi and tau as first and last, respectively
-	double step = M_PI * 2. * tauopt / n;
-	phase = phiopt - M_PI * 2. * tauopt;
-	rp.First = phase + step;
-	rp.Last = phiopt + n * step;
-	for (i = 0; i < n; i++) {
-		phase += step;
-		rp.Values[i] = vr.Values[i] * cos (phase) - vi.Values[i] * sin (phase);
-	}
+	memcpy (rp.Values, m_Fid->GetPhasedReal (), n * sizeof (double));
+	//store the zero and first order phases as first and last, respectively
+	rp.First = m_Fid->GetPhase0 ();
+	rp.Last = m_Fid->GetPhase1 ();
 	go_range_min (rp.Values, n, &rp.Min);
 	go_range_max (rp.Values, n, &rp.Max);
+	rp.Series = NULL;
 	Rp = variables.size ();
 	variables.push_back (rp);
 	// add Hz and ppm variables (0 for last point, user will have to choose a reference peak)
 	// first Hz
 	// if we are there, we have R and I values, we should have also X, but let's check
-	double freq, shift;
+	double freq;
 	if (X >= 0 && variables[X].Values != NULL)
 		freq = 1 / (variables[X].Last - variables[X].First);
 	else
 		freq = 1 / (lastx - firstx);
 	if (!go_finite (offset))
 		offset = 0.;
-	shift = offset - freq * (npoints - 1) / 2.;
 	//now display the spectrum
 	variables[R].Series = NULL;
 	rp.Series = m_View->GetSeries ();
@@ -2210,8 +1635,7 @@ void SpectrumDocument::OnTransformFID (G_GNUC_UNUSED GtkButton *btn)
 		xt.Factor = 1.;
 		xt.NbValues = n;
 		xt.Values = new double[n];
-		for (i = 0; i < n; i++)
-			xt.Values[i] = i * freq + shift;
+		m_Fid->GetFrequencies (offset, xt.Values);
 		xt.Min = xt.First = xt.Values[0];
 		xt.Max = xt.Last = xt.Values[n - 1];
 		xt.Series = NULL;
@@ -2243,6 +1667,19 @@ void SpectrumDocument::OnTransformFID (G_GNUC_UNUSED GtkButton *btn)
 		g_signal_connect (w, "changed", G_CALLBACK (on_xunit_changed), this);
 		gtk_container_add (GTK_CONTAINER (grid), w);
 	}
+	w = gtk_label_new (_("Phase:"));
+	gtk_container_add (GTK_CONTAINER (grid), w);
+	m_Phase0Btn = gtk_spin_button_new_with_range (-180., 180., 1.);
+	gtk_spin_button_set_wrap (GTK_SPIN_BUTTON (m_Phase0Btn), true);
+	gtk_spin_button_set_value (GTK_SPIN_BUTTON (m_Phase0Btn), m_Fid->GetPhase0 () * 180. / M_PI);
+	g_signal_connect (m_Phase0Btn, "value-changed", G_CALLBACK (on_phase_changed), this);
+	gtk_container_add (GTK_CONTAINER (grid), m_Phase0Btn);
+	w = gtk_label_new (_("First order:"));
+	gtk_container_add (GTK_CONTAINER (grid), w);
+	m_Phase1Btn = gtk_spin_button_new_with_range (-3600., 3600., 1.);
+	gtk_spin_button_set_value (GTK_SPIN_BUTTON (m_Phase1Btn), m_Fid->GetPhase1 () * 180. / M_PI);
+	g_signal_connect (m_Phase1Btn, "value-changed", G_CALLBACK (on_phase_changed), this);
+	gtk_container_add (GTK_CONTAINER (grid), m_Phase1Btn);
 	w = gtk_button_new_with_label (_("Show integral"));
 	g_signal_connect (w, "clicked", G_CALLBACK (on_show_integral), this);
 	gtk_container_add (GTK_CONTAINER (grid), w);
@@ -2250,6 +1687,37 @@ void SpectrumDocument::OnTransformFID (G_GNUC_UNUSED GtkButton *btn)
 	m_View->AddToOptionBox (grid);
 }
 
+void SpectrumDocument::SetPhase (double phase0, double phase1)
+{
+	if (!m_Fid || Rp < 0)
+		return;
+	// only the phase correction is evaluated again
+	m_Fid->SetPhase (phase0, phase1);
+	JdxVar &rp = variables[Rp];
+	memcpy (rp.Values, m_Fid->GetPhasedReal (), rp.NbValues * sizeof (double));
+	rp.First = m_Fid->GetPhase0 ();
+	rp.Last = phase1;
+	go_range_min (rp.Values, rp.NbValues, &rp.Min);
+	go_range_max (rp.Values, rp.NbValues, &rp.Max);
+	GOData *godata = go_data_vector_val_new (rp.Values, rp.NbValues, NULL);
+	gog_series_set_dim (m_View->GetSeries (), 1, godata, NULL);
+	m_View->SetAxisBounds (GOG_AXIS_Y, rp.Min, rp.Max, false);
+	if (integral >= 0) {
+		// the integral is not valid anymore
+		JdxVar &v = variables[integral];
+		gcu::IntegrateSpectrum ((X >= 0 && variables[X].Values != NULL)? variables[X].Values: x, rp.Values, v.NbValues, v.Values);
+		v.Last = v.Max = v.Values[v.NbValues - 1];
+		godata = go_data_vector_val_new (v.Values, v.NbValues, NULL);
+		gog_series_set_dim (v.Series, 1, godata, NULL);
+	}
+}
+
+void SpectrumDocument::OnPhaseChanged ()
+{
+	SetPhase (gtk_spin_button_get_value (GTK_SPIN_BUTTON (m_Phase0Btn)) * M_PI / 180.,
+	          gtk_spin_button_get_value (GTK_SPIN_BUTTON (m_Phase1Btn)) * M_PI / 180.);
+}
+
 void SpectrumDocument::OnXAxisInvert (bool inverted)
 {
 	m_View->InvertAxis (GOG_AXIS_X, inverted);
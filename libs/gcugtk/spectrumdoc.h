@@ -29,6 +29,10 @@
 #include <string>
 #include <vector>
 
+namespace gcu {
+	class FidProcessor;
+}
+
 /*!\file*/
 namespace gcugtk
 {
@@ -335,6 +339,19 @@ might be changed.
 */
 	void OnTransformFID (GtkButton *btn);
 /*!
+Called by the framework when one of the phase correction buttons of a
+transformed NMR spectrum changed.
+*/
+	void OnPhaseChanged ();
+/*!
+@param phase0 the zero order phase correction in radians.
+@param phase1 the first order phase correction in radians.
+
+Changes the phase correction of a transformed NMR spectrum without evaluating
+the Fourier transform again.
+*/
+	void SetPhase (double phase0, double phase1);
+/*!
 @param property the property id as defined in objprops.h
 @param value the property value as a string
 
@@ -348,11 +365,10 @@ Called by the application when the document has been loaded.
 	bool Loaded () throw (gcu::LoaderError);
 
 private:
-	void LoadJcampDx (char const *data);
-	void ReadDataLine (char const *data, std::list<double> &l);
+	void LoadJcampDx (char const *data, size_t length);
 	void DoPrint (GtkPrintOperation *print, GtkPrintContext *context, int page) const;
 	GtkWindow *GetGtkWindow ();
-	void ReadDataTable (std::istream &s, double *x, double *y);
+	char const *ReadDataTable (char const *data, char const *end, double *x, double *y);
 	double (*GetConversionFunction (SpectrumUnitType oldu, SpectrumUnitType newu, double &factor, double &offset)) (double, double, double);
 
 private:
@@ -367,6 +383,8 @@ private:
 	double offset, refpoint;
 	GtkWidget *m_XAxisInvertBtn;
 	unsigned m_XAxisInvertSgn;
+	GtkWidget *m_Phase0Btn, *m_Phase1Btn;
+	gcu::FidProcessor *m_Fid;
 
 /*!\var m_View
 The SpectrumView instance associated with the document.
@@ -24,6 +24,8 @@
 
 #include "config.h"
 #include "socket.h"
+#include "cache.h"
+#include "queue.h"
 #include <cerrno>
 #include <clocale>
 #include <netinet/in.h>
@@ -31,21 +33,69 @@
 #include <cstdio>
 #include <sys/un.h>
 #include <ctime>
+#include <csignal>
 #include <cstdlib>
+#include <fcntl.h>
 #include <unistd.h>
 #include <map>
-#include <set>
 #include <vector>
 
+#ifdef POLLRDHUP
+#	define POLL_CLOSED (POLLRDHUP | POLLHUP | POLLERR)
+#else
+#	define POLL_CLOSED (POLLHUP | POLLERR)
+#endif
+
 int listening_socket;
 time_t timeout = 1800;
 time_t endtime;
-unsigned max_socket = 10;
+unsigned jobs_per_worker = 4;
+size_t cache_size = 32; // in MiB
+char const *cache_file = NULL;
+unsigned workers = 0; // one per processor by default
 std::map <int, BabelSocket *> sockets;
+static volatile sig_atomic_t terminated = 0;
+
+// SIGTERM stops the server at once, but the cache is still saved
+static void on_terminate (int)
+{
+	terminated = 1;
+}
+
+/* the parent process only exits when the server is ready to accept
+ connections, so that clients can wait for it without polling */
+static void server_ready (int ready)
+{
+	char c = 0;
+	if (write (ready, &c, 1) < 0)
+		perror ("write");
+	close (ready);
+}
 
 int main (int argc, char *argv[])
 {
-	int port;
+	int port, ready[2], opt;
+	/* -c sets the cache size in MiB, 0 disabling the cache, -p the file used to
+	 keep it between runs, and -w the number of worker processes */
+	while ((opt = getopt (argc, argv, "c:p:w:")) != -1)
+		switch (opt) {
+		case 'c':
+			cache_size = strtoul (optarg, NULL, 10);
+			break;
+		case 'p':
+			cache_file = optarg;
+			break;
+		case 'w':
+			workers = strtoul (optarg, NULL, 10);
+			break;
+		default:
+			fprintf (stderr, "Usage: %s [-c cache size in MiB] [-p cache file] [-w workers]\n", argv[0]);
+			return -1;
+		}
+	if (pipe (ready) == -1) {
+		perror ("pipe");
+		return -1;
+	}
 	port = fork();
 	if (port != 0)
 	{
@@ -53,8 +103,14 @@ int main (int argc, char *argv[])
 			perror("fork");
 			return port;
 		}
-		return 0;
+		char c;
+		close (ready[1]);
+		// if the server failed, the pipe is closed without anything written
+		return (read (ready[0], &c, 1) == 1)? 0: -1;
 	}
+	close (ready[0]);
+	signal (SIGPIPE, SIG_IGN); // clients might disconnect before getting their answer
+	signal (SIGTERM, on_terminate);
 	if ((listening_socket = socket (AF_UNIX, SOCK_STREAM, 0)) == -1) {
 		perror("socket creation failed");
 		return -1;
@@ -74,7 +130,22 @@ int main (int argc, char *argv[])
 	free (path);
 
 	/* bind the socket */
-	if (bind (listening_socket, (struct sockaddr*) &address, sizeof(address)) == -1) {
+	int bound = bind (listening_socket, (struct sockaddr*) &address, sizeof(address));
+	if (bound == -1 && errno == EADDRINUSE) {
+		// either another server is running, or the previous one did not exit cleanly
+		int probe = socket (AF_UNIX, SOCK_STREAM, 0);
+		if (probe != -1 && connect (probe, (struct sockaddr*) &address, sizeof(address)) == 0) {
+			close (probe);
+			close (listening_socket);
+			server_ready (ready[1]);
+			return 0;
+		}
+		if (probe != -1)
+			close (probe);
+		unlink (address.sun_path);
+		bound = bind (listening_socket, (struct sockaddr*) &address, sizeof(address));
+	}
+	if (bound == -1) {
 		perror ("socket attachment failed");
 		close (listening_socket);
 		unlink (address.sun_path);
@@ -87,71 +158,116 @@ int main (int argc, char *argv[])
 		unlink (address.sun_path);
 		return -4;
 	}
+	server_ready (ready[1]);
+
+	// load the plugins before the worker processes are forked
+	OpenBabel::OBConversion conv;
+	conv.FindFormat ("cml");
+
+	if (workers == 0) {
+		long nprocs = sysconf (_SC_NPROCESSORS_ONLN);
+		workers = (nprocs > 0)? nprocs: 1;
+	}
+	BabelQueue *queue = new BabelQueue (workers, workers * jobs_per_worker);
+	BabelCache *cache = (cache_size > 0)? new BabelCache (cache_size << 20): NULL;
+	if (cache && cache_file)
+		cache->Load (cache_file);
 
 	endtime = time (NULL) + timeout;
 	std::vector <struct pollfd> fds;
 	struct pollfd _fds;
-	fds.reserve (max_socket); // should be large enough
-	fds.resize (1);
-	fds[0].fd = listening_socket;
-	fds[0].events = POLLIN;
-	fds[0].revents = 0;
-	std::set <int> deleted;
+	std::map <int, BabelSocket *>::iterator it;
 	static struct sockaddr_in fromend;
 	static unsigned lng_address;
 	int service_socket;
 
-	while (time (NULL) < endtime) {
-		if (poll (&fds[0], fds.size (), 1000) > 0) {
-			if (fds[0].revents == POLLIN) {
-				service_socket = accept (listening_socket, (struct sockaddr*) &fromend, &lng_address);
-				if (service_socket == -1 && errno == EINTR)	// a signal was received
-					continue ;
-				if (service_socket == -1) {	// fatal error
-					perror ("accept") ;
-					return -5;
-				}
-				_fds.fd = service_socket;
+	// don't exit while a conversion is running or waiting
+	while (!terminated && (time (NULL) < endtime || queue->IsBusy ())) {
+		/* when the queue is full, new connections stay in the listen backlog
+		 and clients are not read anymore, so that they are blocked when writing
+		 until a worker becomes available */
+		bool full = queue->IsFull ();
+		fds.resize (1);
+		fds[0].fd = listening_socket;
+		fds[0].events = full? 0: POLLIN;
+		fds[0].revents = 0;
+		queue->AddPollFds (fds);
+		unsigned first = fds.size ();
+		for (it = sockets.begin (); it != sockets.end (); it++) {
+			BabelSocket *client = (*it).second;
+			_fds.fd = (*it).first;
+			_fds.events = client->HasOutput ()? POLLOUT: 0;
+			if (!full && !client->IsPending () && !client->IsFinished () && !client->IsFull ()) {
+				_fds.events |= POLLIN;
 #ifdef POLLRDHUP
-				_fds.events = POLLIN | POLLRDHUP;
-#else
-				_fds.events = POLLIN;
+				_fds.events |= POLLRDHUP;
 #endif
-				_fds.revents = 0;
-				fds.push_back (_fds);
-				sockets[service_socket] = new BabelSocket (service_socket);
 			}
-			for (unsigned i = 1; i < fds.size (); i++) {
-				if (fds[i].revents & POLLIN) {
-					int res;
-					while ((res = sockets[fds[i].fd]->Read ()) > 0);
-					if (res == -1) {
-						delete sockets[fds[i].fd];
-						sockets.erase (fds[i].fd);
-						deleted.insert (i);
-					}
-				}
-#ifdef POLLRDHUP
-				if (fds[i].revents & POLLRDHUP) {
-					delete sockets[fds[i].fd];
-					sockets.erase (fds[i].fd);
-					deleted.insert (i);
-				}
-#endif
-				fds[i].revents = 0;
+			_fds.revents = 0;
+			fds.push_back (_fds);
+		}
+		if (poll (&fds[0], fds.size (), 1000) <= 0)
+			continue;
+		// read the results and start the waiting jobs
+		queue->Process (&fds[1]);
+		if (fds[0].revents & POLLIN) {
+			service_socket = accept (listening_socket, (struct sockaddr*) &fromend, &lng_address);
+			if (service_socket == -1 && errno == EINTR)	// a signal was received
+				continue ;
+			if (service_socket == -1) {	// fatal error
+				perror ("accept") ;
+				delete queue;
+				return -5;
+			}
+			fcntl (service_socket, F_SETFL, O_NONBLOCK);
+			sockets[service_socket] = new BabelSocket (service_socket, queue, cache);
+		}
+		for (unsigned i = first; i < fds.size (); i++) {
+			BabelSocket *client = sockets[fds[i].fd];
+			int res = 0;
+			// make room first, requests already received might be waiting for it
+			bool lost = client->Flush () < 0;
+			if (fds[i].revents & (POLLIN | POLLOUT | POLL_CLOSED)) {
+				// the requests sent before the client closed its side are still run
+				while ((res = client->Read ()) > 0);
+				if (res < 0)
+					client->Finish ();
+				// answers queued by Read () are sent at once
+				lost = client->Flush () < 0 || lost;
 			}
-			// remove closed sockets
-			if (deleted.size () > 0) {
-				std::set <int>::iterator it, end = deleted.end ();
-				for (it = deleted.begin (); it != end; it++)
-						fds.erase (fds.begin () + *it);
-				deleted.clear ();
+			if (lost || (fds[i].revents & (POLLHUP | POLLERR)) || client->IsDone ()) {
+				delete client;
+				sockets.erase (fds[i].fd);
 			}
-			endtime = time (NULL) + timeout; // restart time counter from now
 		}
+		// submit the requests waiting for a free slot in the queue
+		for (it = sockets.begin (); it != sockets.end () && !queue->IsFull (); ) {
+			BabelSocket *client = (*it).second;
+			int res = 0;
+			if (client->IsPending () && (res = client->Submit ()) > 0)
+				// parse the next requests from the same client
+				while ((res = client->Read ()) > 0);
+			if (res < 0)
+				client->Finish ();
+			if (client->IsDone ()) {
+				delete client;
+				sockets.erase (it++);
+			} else
+				it++;
+		}
+		endtime = time (NULL) + timeout; // restart time counter from now
 	}
 
+	delete queue;
+	for (it = sockets.begin (); it != sockets.end (); it++)
+		delete (*it).second;
 	close (listening_socket);
 	unlink (address.sun_path);
+	if (cache) {
+		// keep the results for the next server instance
+		if (cache_file)
+			cache->Save (cache_file);
+		delete cache;
+	}
 	return 0;
 }
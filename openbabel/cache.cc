@@ -0,0 +1,200 @@
+// -*- C++ -*-
+
+/*
+ * OpenBabel server
+ * babel-cache.cc
+ *
+ * Copyright (C) 2026 Jean Bréfort <jean.brefort@normalesup.org>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301
+ * USA
+ */
+
+
+#include "config.h"
+#include "cache.h"
+#include <openbabel/babelconfig.h>
+#include <cstdio>
+#include <cstring>
+
+#define ENTRY_OVERHEAD 128 // approximate memory used by an entry besides its strings
+
+#ifdef BABEL_VERSION
+#	define CACHE_MAGIC "GCU babelserver cache 1 " BABEL_VERSION "\n"
+#else
+#	define CACHE_MAGIC "GCU babelserver cache 1\n"
+#endif
+
+BabelCache::BabelCache (size_t max_size):
+m_MaxSize (max_size),
+m_Size (0),
+m_Hits (0),
+m_Misses (0)
+{
+}
+
+BabelCache::~BabelCache ()
+{
+}
+
+// 64 bits FNV-1a
+uint64_t BabelCache::Hash (std::string const &key, char const *data, size_t size)
+{
+	uint64_t hash = 14695981039346656037ULL;
+	size_t i, max = key.length ();
+	for (i = 0; i < max; i++) {
+		hash ^= static_cast <unsigned char> (key[i]);
+		hash *= 1099511628211ULL;
+	}
+	// separate the key from the data
+	hash ^= 0xff;
+	hash *= 1099511628211ULL;
+	for (i = 0; i < size; i++) {
+		hash ^= static_cast <unsigned char> (data[i]);
+		hash *= 1099511628211ULL;
+	}
+	return hash;
+}
+
+BabelCache::EntryList::iterator BabelCache::Find (uint64_t hash, std::string const &key, char const *data, size_t size)
+{
+	std::pair <std::multimap <uint64_t, EntryList::iterator>::iterator, std::multimap <uint64_t, EntryList::iterator>::iterator> range = m_Index.equal_range (hash);
+	for (; range.first != range.second; range.first++) {
+		Entry &entry = *(*range.first).second;
+		if (entry.key == key && entry.input.length () == size && !memcmp (entry.input.data (), data, size))
+			return (*range.first).second;
+	}
+	return m_Entries.end ();
+}
+
+bool BabelCache::Lookup (std::string const &key, char const *data, size_t size, std::string &result)
+{
+	uint64_t hash = Hash (key, data, size);
+	EntryList::iterator it = Find (hash, key, data, size);
+	bool found = it != m_Entries.end ();
+	if (found) {
+		// move the entry to the front, iterators stay valid
+		m_Entries.splice (m_Entries.begin (), m_Entries, it);
+		result = (*it).result;
+		m_Hits++;
+	} else
+		m_Misses++;
+	return found;
+}
+
+void BabelCache::Add (uint64_t hash, std::string const &key, char const *data, size_t size, std::string const &result)
+{
+	size_t entry_size = key.length () + size + result.length () + ENTRY_OVERHEAD;
+	// don't let a single entry evict a large part of the cache
+	if (entry_size > m_MaxSize / 8 || Find (hash, key, data, size) != m_Entries.end ())
+		return;
+	m_Entries.push_front (Entry ());
+	Entry &entry = m_Entries.front ();
+	entry.hash = hash;
+	entry.key = key;
+	entry.input.assign (data, size);
+	entry.result = result;
+	m_Index.insert (std::make_pair (hash, m_Entries.begin ()));
+	m_Size += entry_size;
+	Evict ();
+}
+
+void BabelCache::Insert (std::string const &key, char const *data, size_t size, std::string const &result)
+{
+	uint64_t hash = Hash (key, data, size);
+	Add (hash, key, data, size, result);
+}
+
+void BabelCache::Evict ()
+{
+	while (m_Size > m_MaxSize && !m_Entries.empty ()) {
+		EntryList::iterator last = m_Entries.end ();
+		last--;
+		std::pair <std::multimap <uint64_t, EntryList::iterator>::iterator, std::multimap <uint64_t, EntryList::iterator>::iterator> range = m_Index.equal_range ((*last).hash);
+		for (; range.first != range.second; range.first++)
+			if ((*range.first).second == last) {
+				m_Index.erase (range.first);
+				break;
+			}
+		m_Size -= (*last).key.length () + (*last).input.length () + (*last).result.length () + ENTRY_OVERHEAD;
+		m_Entries.erase (last);
+	}
+}
+
+void BabelCache::GetStatus (unsigned &entries, size_t &size, unsigned long &hits, unsigned long &misses)
+{
+	entries = m_Entries.size ();
+	size = m_Size;
+	hits = m_Hits;
+	misses = m_Misses;
+}
+
+static bool write_string (FILE *f, std::string const &str)
+{
+	uint32_t length = str.length ();
+	return fwrite (&length, sizeof (length), 1, f) == 1 && (length == 0 || fwrite (str.data (), length, 1, f) == 1);
+}
+
+static bool read_string (FILE *f, std::string &str)
+{
+	uint32_t length;
+	if (fread (&length, sizeof (length), 1, f) != 1)
+		return false;
+	str.resize (length);
+	return length == 0 || fread (&str[0], length, 1, f) == 1;
+}
+
+/*
+ * The file starts with CACHE_MAGIC, followed by the entries, the least recently
+ * used first, each entry being its key, input and result, as a 32 bits length
+ * in host order followed by the bytes. The file is only meant to be read by
+ * the same server on the same machine.
+ */
+bool BabelCache::Save (char const *filename)
+{
+	std::string tmpname = std::string (filename) + ".tmp";
+	FILE *f = fopen (tmpname.c_str (), "wb");
+	if (!f)
+		return false;
+	bool res = fputs (CACHE_MAGIC, f) >= 0;
+	EntryList::reverse_iterator i, end = m_Entries.rend ();
+	for (i = m_Entries.rbegin (); res && i != end; i++)
+		res = write_string (f, (*i).key) && write_string (f, (*i).input) && write_string (f, (*i).result);
+	res = (fclose (f) == 0) && res;
+	// replace the previous file only when everything has been written
+	if (res)
+		res = rename (tmpname.c_str (), filename) == 0;
+	if (!res)
+		remove (tmpname.c_str ());
+	return res;
+}
+
+bool BabelCache::Load (char const *filename)
+{
+	FILE *f = fopen (filename, "rb");
+	if (!f)
+		return false;
+	char magic[sizeof (CACHE_MAGIC)];
+	if (!fgets (magic, sizeof (magic), f) || strcmp (magic, CACHE_MAGIC)) {
+		// another version, OpenBabel might give different results
+		fclose (f);
+		return false;
+	}
+	std::string key, input, result;
+	while (read_string (f, key) && read_string (f, input) && read_string (f, result))
+		Add (Hash (key, input.data (), input.length ()), key, input.data (), input.length (), result);
+	fclose (f);
+	return true;
+}
@@ -0,0 +1,73 @@
+// -*- C++ -*-
+
+/*
+ * OpenBabel server
+ * cache.h
+ *
+ * Copyright (C) 2026 Jean Bréfort <jean.brefort@normalesup.org>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301
+ * USA
+ */
+
+
+#ifndef GCU_BABEL_CACHE_H
+#define GCU_BABEL_CACHE_H
+
+#include <stdint.h>
+#include <list>
+#include <map>
+#include <string>
+
+/*
+ * A bounded cache of conversion results. Entries are keyed by the request
+ * options (formats and conversion options) and the input data, and looked up
+ * through a hash of both; the input is kept too, so that a hash collision
+ * can't return a wrong result. When the cache size exceeds its maximum, the
+ * least recently used entries are removed. The cache might be saved to a
+ * file and loaded again when the server starts.
+ */
+class BabelCache
+{
+public:
+	BabelCache (size_t max_size);
+	~BabelCache ();
+
+	bool Lookup (std::string const &key, char const *data, size_t size, std::string &result);
+	void Insert (std::string const &key, char const *data, size_t size, std::string const &result);
+	bool Load (char const *filename);
+	bool Save (char const *filename);
+	void GetStatus (unsigned &entries, size_t &size, unsigned long &hits, unsigned long &misses);
+
+private:
+	struct Entry {
+		uint64_t hash;
+		std::string key, input, result;
+	};
+	typedef std::list <Entry> EntryList;
+
+	static uint64_t Hash (std::string const &key, char const *data, size_t size);
+	EntryList::iterator Find (uint64_t hash, std::string const &key, char const *data, size_t size);
+	void Add (uint64_t hash, std::string const &key, char const *data, size_t size, std::string const &result);
+	void Evict ();
+
+private:
+	EntryList m_Entries; // the most recently used first
+	std::multimap <uint64_t, EntryList::iterator> m_Index;
+	size_t m_MaxSize, m_Size;
+	unsigned long m_Hits, m_Misses;
+};
+
+#endif	//	GCU_BABEL_CACHE_H
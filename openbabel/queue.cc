@@ -0,0 +1,724 @@
+// -*- C++ -*-
+
+/*
+ * OpenBabel server
+ * babel-queue.cc
+ *
+ * Copyright (C) 2026 Jean Bréfort <jean.brefort@normalesup.org>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301
+ * USA
+ */
+
+
+#include "config.h"
+#include "queue.h"
+#include "cache.h"
+#include <openbabel/obconversion.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include <cerrno>
+#include <csignal>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <fstream>
+#include <sstream>
+#include <stdint.h>
+#include <unistd.h>
+
+#define CHUNK_SIZE 0x10000
+#define MAX_CACHED 0x100000 // larger streamed answers are not cached
+#define MAX_OUTPUT 0x400000 // output waiting for a client before pausing it
+
+enum {
+	JOB_STREAM = 1,
+	JOB_FD = 2
+};
+
+// sent to a worker, followed by the options, the file names and the data
+struct JobHeader {
+	uint32_t flags, options, input, output;
+	uint64_t size;
+};
+
+enum {
+	RESULT_DATA,
+	RESULT_END
+};
+
+// sent by a worker before each chunk of the answer
+struct ResultHeader {
+	uint32_t type, converted;
+	uint64_t size;
+};
+
+/******************************************************************************
+ * Worker process side, everything is blocking there.
+ ******************************************************************************/
+
+static bool write_all (int fd, void const *buf, size_t size)
+{
+	char const *data = static_cast <char const *> (buf);
+	while (size > 0) {
+		ssize_t res = write (fd, data, size);
+		if (res < 0) {
+			if (errno == EINTR)
+				continue;
+			return false;
+		}
+		data += res;
+		size -= res;
+	}
+	return true;
+}
+
+static bool read_all (int fd, void *buf, size_t size)
+{
+	char *data = static_cast <char *> (buf);
+	while (size > 0) {
+		ssize_t res = read (fd, data, size);
+		if (res < 0) {
+			if (errno == EINTR)
+				continue;
+			return false;
+		}
+		if (res == 0)
+			return false;
+		data += res;
+		size -= res;
+	}
+	return true;
+}
+
+static bool read_string (int fd, std::string &str, size_t length)
+{
+	str.resize (length);
+	return length == 0 || read_all (fd, &str[0], length);
+}
+
+static bool send_result (int channel, unsigned type, bool converted, char const *data, size_t size)
+{
+	ResultHeader header;
+	header.type = type;
+	header.converted = converted;
+	header.size = size;
+	return write_all (channel, &header, sizeof (header)) && (size == 0 || write_all (channel, data, size));
+}
+
+// reads the input directly from a file descriptor passed by the client
+class FdBuf: public std::streambuf
+{
+public:
+	FdBuf (int fd): m_Fd (fd) {}
+
+protected:
+	int_type underflow ();
+
+private:
+	int m_Fd;
+	char m_Buf[CHUNK_SIZE];
+};
+
+std::streambuf::int_type FdBuf::underflow ()
+{
+	if (gptr () < egptr ())
+		return traits_type::to_int_type (*gptr ());
+	ssize_t n;
+	while ((n = read (m_Fd, m_Buf, CHUNK_SIZE)) < 0 && errno == EINTR);
+	if (n <= 0)
+		return traits_type::eof ();
+	setg (m_Buf, m_Buf, m_Buf + n);
+	return traits_type::to_int_type (*gptr ());
+}
+
+// sends the output to the main process as soon as a chunk is full
+class ChunkBuf: public std::streambuf
+{
+public:
+	ChunkBuf (int channel);
+
+protected:
+	int_type overflow (int_type c);
+	int sync ();
+
+private:
+	int m_Channel;
+	char m_Buf[CHUNK_SIZE];
+};
+
+ChunkBuf::ChunkBuf (int channel):
+m_Channel (channel)
+{
+	setp (m_Buf, m_Buf + CHUNK_SIZE);
+}
+
+std::streambuf::int_type ChunkBuf::overflow (int_type c)
+{
+	if (sync () < 0)
+		return traits_type::eof ();
+	if (!traits_type::eq_int_type (c, traits_type::eof ())) {
+		*pptr () = traits_type::to_char_type (c);
+		pbump (1);
+	}
+	return traits_type::not_eof (c);
+}
+
+int ChunkBuf::sync ()
+{
+	size_t n = pptr () - pbase ();
+	if (n == 0)
+		return 0;
+	setp (m_Buf, m_Buf + CHUNK_SIZE);
+	return send_result (m_Channel, RESULT_DATA, false, m_Buf, n)? 0: -1;
+}
+
+// the options are those parsed by BabelSocket, in the same syntax
+static OpenBabel::OBConversion *new_conversion (std::string const &options)
+{
+	OpenBabel::OBConversion *conv = new OpenBabel::OBConversion ();
+	std::istringstream in (options);
+	std::string option, value;
+	while (in >> option) {
+		if (option == "-i" || option == "-o") {
+			OpenBabel::OBFormat *format = NULL;
+			if (in >> value && !(format = conv->FindFormat (value.c_str ())))
+				format = conv->FormatFromMIME (value.c_str ());
+			if (!format) {
+				delete conv;
+				return NULL;
+			}
+			if (option[1] == 'i')
+				conv->SetInFormat (format);
+			else
+				conv->SetOutFormat (format);
+		} else if (option == "-a" || option == "-x") {
+			if (in >> value)
+				conv->SetOptions (value.c_str (), (option[1] == 'a')? OpenBabel::OBConversion::INOPTIONS: OpenBabel::OBConversion::OUTOPTIONS);
+		} else if (!option.compare (0, 2, "--"))
+			conv->AddOption (option.c_str () + 2, OpenBabel::OBConversion::GENOPTIONS);
+		else if (option[0] == '-')
+			conv->SetOptions (option.c_str () + 1, OpenBabel::OBConversion::GENOPTIONS);
+	}
+	return conv;
+}
+
+static void run_job (int channel, JobHeader const &header, std::string const &options, std::string const &input, std::string const &output, std::string const &data, int fd)
+{
+	OpenBabel::OBConversion *conv = new_conversion (options);
+	bool converted = false;
+	if (conv && (fd >= 0 || !(header.flags & JOB_FD))) {
+		std::istream *is;
+		FdBuf *inbuf = NULL;
+		if (fd >= 0) {
+			inbuf = new FdBuf (fd);
+			is = new std::istream (inbuf);
+		} else if (input.length ())
+			is = new std::ifstream (input.c_str ());
+		else
+			is = new std::istringstream (data);
+		std::ostream *os;
+		ChunkBuf *outbuf = NULL;
+		if (output.length ())
+			os = new std::ofstream (output.c_str ());
+		else if (header.flags & JOB_STREAM) {
+			outbuf = new ChunkBuf (channel);
+			os = new std::ostream (outbuf);
+		} else
+			os = new std::ostringstream ();
+		converted = conv->Convert (is, os) > 0;
+		if (outbuf)
+			os->flush ();
+		else if (output.length () == 0) {
+			std::string const &result = static_cast <std::ostringstream *> (os)->str ();
+			if (result.length ())
+				send_result (channel, RESULT_DATA, false, result.data (), result.length ());
+		}
+		delete is;
+		delete os; // closes the output file before the answer is sent
+		delete inbuf;
+		delete outbuf;
+	}
+	delete conv;
+	if (fd >= 0)
+		close (fd);
+	send_result (channel, RESULT_END, converted, NULL, 0);
+}
+
+static void run_worker (int channel)
+{
+	JobHeader header;
+	while (true) {
+		// the input file descriptor, if any, comes with the first byte
+		struct iovec iov;
+		iov.iov_base = &header;
+		iov.iov_len = sizeof (header);
+		char control[CMSG_SPACE (sizeof (int))];
+		struct msghdr msg;
+		memset (&msg, 0, sizeof (msg));
+		msg.msg_iov = &iov;
+		msg.msg_iovlen = 1;
+		msg.msg_control = control;
+		msg.msg_controllen = sizeof (control);
+		ssize_t n;
+		while ((n = recvmsg (channel, &msg, 0)) < 0 && errno == EINTR);
+		if (n <= 0)
+			break; // the server exited
+		int fd = -1;
+		for (struct cmsghdr *cmsg = CMSG_FIRSTHDR (&msg); cmsg; cmsg = CMSG_NXTHDR (&msg, cmsg))
+			if (cmsg->cmsg_level == SOL_SOCKET && cmsg->cmsg_type == SCM_RIGHTS)
+				memcpy (&fd, CMSG_DATA (cmsg), sizeof (int));
+		std::string options, input, output, data;
+		if (!read_all (channel, reinterpret_cast <char *> (&header) + n, sizeof (header) - n) ||
+		    !read_string (channel, options, header.options) || !read_string (channel, input, header.input) ||
+		    !read_string (channel, output, header.output) || !read_string (channel, data, header.size))
+			break;
+		run_job (channel, header, options, input, output, data, fd);
+	}
+	_exit (0);
+}
+
+/******************************************************************************
+ * Main process side, everything is non blocking there.
+ ******************************************************************************/
+
+BabelReply::BabelReply (int socket):
+m_Socket (socket),
+m_RefCount (1),
+m_Sent (0),
+m_Closed (false)
+{
+}
+
+BabelReply::~BabelReply ()
+{
+	close (m_Socket);
+}
+
+void BabelReply::Ref ()
+{
+	m_RefCount++;
+}
+
+void BabelReply::Unref ()
+{
+	if (--m_RefCount == 0)
+		delete this;
+}
+
+void BabelReply::Send (std::string const &id, char const *data, size_t size)
+{
+	if (m_Closed)
+		return;
+	std::ostringstream header;
+	if (id.length ())
+		header << id << " ";
+	header << size << " ";
+	m_Out += header.str ();
+	if (size)
+		m_Out.append (data, size);
+}
+
+void BabelReply::Stream (std::string const &id, char const *data, size_t size)
+{
+	for (size_t sent = 0; sent < size; sent += CHUNK_SIZE)
+		Send (id, data + sent, (size - sent > CHUNK_SIZE)? CHUNK_SIZE: size - sent);
+	Send (id, NULL, 0); // end of the answer
+}
+
+void BabelReply::Fail (std::string const &id)
+{
+	if (m_Closed)
+		return;
+	m_Out += id;
+	m_Out += " -1 ";
+}
+
+int BabelReply::Flush ()
+{
+	while (HasOutput ()) {
+		ssize_t n = write (m_Socket, m_Out.data () + m_Sent, m_Out.length () - m_Sent);
+		if (n < 0) {
+			if (errno == EINTR)
+				continue;
+			if (errno != EAGAIN && errno != EWOULDBLOCK) {
+				Close ();
+				return -1;
+			}
+			// wait until the socket is writable again
+			if (m_Sent > CHUNK_SIZE && 2 * m_Sent > m_Out.length ()) {
+				m_Out.erase (0, m_Sent);
+				m_Sent = 0;
+			}
+			return 0;
+		}
+		m_Sent += n;
+	}
+	m_Out.clear ();
+	m_Sent = 0;
+	return 0;
+}
+
+void BabelReply::Close ()
+{
+	m_Closed = true;
+	std::string ().swap (m_Out);
+	m_Sent = 0;
+}
+
+bool BabelReply::IsFull () const
+{
+	return m_Out.length () - m_Sent > MAX_OUTPUT;
+}
+
+BabelJob::BabelJob (BabelReply *reply, std::string const &id, std::string const &options, std::string const &input, std::string const &output, char *data, size_t size, int fd, bool stream):
+m_Reply (reply),
+m_Id (id),
+m_Options (options),
+m_Input (input),
+m_Output (output),
+m_Data (data),
+m_Size (size),
+m_Fd (fd),
+m_Stream (stream && id.length () > 0 && output.length () == 0),
+m_Keep (false),
+m_Cache (NULL)
+{
+	m_Reply->Ref ();
+}
+
+BabelJob::~BabelJob ()
+{
+	m_Reply->Unref ();
+	delete [] m_Data;
+	if (m_Fd >= 0)
+		close (m_Fd);
+}
+
+void BabelJob::SetCache (BabelCache *cache, std::string const &key)
+{
+	m_Cache = cache;
+	m_Key = key;
+	m_Keep = true;
+}
+
+void BabelJob::AddResult (char const *data, size_t size)
+{
+	if (!m_Stream) {
+		m_Result.append (data, size);
+		return;
+	}
+	m_Reply->Send (m_Id, data, size);
+	if (m_Keep) {
+		// keep what is sent, for the cache
+		m_Keep = m_Result.length () + size <= MAX_CACHED;
+		if (m_Keep)
+			m_Result.append (data, size);
+		else
+			std::string ().swap (m_Result);
+	}
+}
+
+void BabelJob::Finish (bool converted)
+{
+	if (m_Output.length ()) {
+		if (m_Id.length ())
+			m_Reply->Send (m_Id, NULL, 0);
+		return;
+	}
+	if (m_Stream)
+		m_Reply->Send (m_Id, NULL, 0); // end of the answer
+	else
+		m_Reply->Send (m_Id, m_Result.data (), m_Result.length ());
+	// failures are not cached
+	if (m_Cache && m_Keep && converted)
+		m_Cache->Insert (m_Key, m_Data, m_Size, m_Result);
+}
+
+void BabelJob::Abort ()
+{
+	if (m_Id.length ())
+		m_Reply->Fail (m_Id);
+	else if (m_Output.length () == 0)
+		m_Reply->Send (m_Id, NULL, 0); // the legacy answer to a failed conversion
+}
+
+BabelQueue::BabelQueue (unsigned workers, unsigned max_jobs):
+m_MaxJobs (max_jobs),
+m_Running (0)
+{
+	if (workers == 0)
+		workers = 1;
+	m_Workers.resize (workers);
+	bool spawned = false;
+	for (unsigned i = 0; i < workers; i++)
+		spawned = Spawn (m_Workers[i]) || spawned;
+	if (!spawned)
+		abort (); // we can't do anything without workers
+}
+
+BabelQueue::~BabelQueue ()
+{
+	// jobs still in the queue are just dropped, closing their socket
+	while (!m_Jobs.empty ()) {
+		delete m_Jobs.front ();
+		m_Jobs.pop_front ();
+	}
+	std::vector <Worker>::iterator i, end = m_Workers.end ();
+	// closing the channels first lets the workers exit together
+	for (i = m_Workers.begin (); i != end; i++) {
+		// nobody will read the result of a running conversion
+		if ((*i).job && (*i).pid > 0)
+			kill ((*i).pid, SIGKILL);
+		delete (*i).job;
+		(*i).job = NULL;
+		if ((*i).channel >= 0)
+			close ((*i).channel);
+		(*i).channel = -1;
+	}
+	for (i = m_Workers.begin (); i != end; i++)
+		Stop (*i);
+}
+
+bool BabelQueue::Spawn (Worker &worker)
+{
+	worker.pid = -1;
+	worker.channel = worker.fd = -1;
+	worker.job = NULL;
+	int fds[2];
+	if (socketpair (AF_UNIX, SOCK_STREAM, 0, fds) == -1)
+		return false;
+	pid_t pid = fork ();
+	if (pid < 0) {
+		close (fds[0]);
+		close (fds[1]);
+		return false;
+	}
+	if (pid == 0) {
+		// only the server handles SIGTERM, see babelserv.cc
+		signal (SIGTERM, SIG_DFL);
+		// the worker must not keep the clients and the other workers connected
+		long max = sysconf (_SC_OPEN_MAX);
+		if (max < 0 || max > 0x10000)
+			max = 0x10000;
+		for (int fd = 3; fd < max; fd++)
+			if (fd != fds[1])
+				close (fd);
+		run_worker (fds[1]);
+	}
+	close (fds[1]);
+	fcntl (fds[0], F_SETFL, O_NONBLOCK);
+	worker.pid = pid;
+	worker.channel = fds[0];
+	return true;
+}
+
+void BabelQueue::Stop (Worker &worker)
+{
+	if (worker.channel >= 0)
+		close (worker.channel);
+	if (worker.fd >= 0)
+		close (worker.fd);
+	if (worker.pid > 0)
+		while (waitpid (worker.pid, NULL, 0) < 0 && errno == EINTR);
+	worker.pid = -1;
+	worker.channel = worker.fd = -1;
+}
+
+bool BabelQueue::Push (BabelJob *job)
+{
+	if (m_Jobs.size () >= m_MaxJobs)
+		return false;
+	m_Jobs.push_back (job);
+	// start it at once if a worker is available
+	Process (NULL);
+	return true;
+}
+
+void BabelQueue::GetStatus (unsigned &running, unsigned &queued) const
+{
+	running = m_Running;
+	queued = m_Jobs.size ();
+}
+
+void BabelQueue::Start (Worker &worker, BabelJob *job)
+{
+	JobHeader header;
+	memset (&header, 0, sizeof (header));
+	header.flags = (job->m_Stream? JOB_STREAM: 0) | ((job->m_Fd >= 0)? JOB_FD: 0);
+	header.options = job->m_Options.length ();
+	header.input = job->m_Input.length ();
+	header.output = job->m_Output.length ();
+	// the data buffer is only meaningful when the input was sent inline
+	header.size = (job->m_Fd >= 0 || job->m_Input.length ())? 0: job->m_Size;
+	worker.out.assign (reinterpret_cast <char const *> (&header), sizeof (header));
+	worker.out += job->m_Options;
+	worker.out += job->m_Input;
+	worker.out += job->m_Output;
+	worker.in.clear ();
+	worker.data = job->m_Data;
+	worker.size = header.size;
+	worker.sent = 0;
+	worker.fd = job->m_Fd;
+	job->m_Fd = -1;
+	worker.job = job;
+	m_Running++;
+	// a failure means that the worker died, which the next poll will show
+	Write (worker);
+}
+
+bool BabelQueue::Write (Worker &worker)
+{
+	size_t total = worker.out.length () + worker.size;
+	while (worker.sent < total) {
+		char const *buf;
+		size_t length;
+		if (worker.sent < worker.out.length ()) {
+			buf = worker.out.data () + worker.sent;
+			length = worker.out.length () - worker.sent;
+		} else {
+			buf = worker.data + worker.sent - worker.out.length ();
+			length = total - worker.sent;
+		}
+		ssize_t n;
+		if (worker.fd >= 0) {
+			// the input file descriptor goes with the first byte
+			struct iovec iov;
+			iov.iov_base = const_cast <char *> (buf);
+			iov.iov_len = length;
+			char control[CMSG_SPACE (sizeof (int))];
+			memset (control, 0, sizeof (control));
+			struct msghdr msg;
+			memset (&msg, 0, sizeof (msg));
+			msg.msg_iov = &iov;
+			msg.msg_iovlen = 1;
+			msg.msg_control = control;
+			msg.msg_controllen = sizeof (control);
+			struct cmsghdr *cmsg = CMSG_FIRSTHDR (&msg);
+			cmsg->cmsg_level = SOL_SOCKET;
+			cmsg->cmsg_type = SCM_RIGHTS;
+			cmsg->cmsg_len = CMSG_LEN (sizeof (int));
+			memcpy (CMSG_DATA (cmsg), &worker.fd, sizeof (int));
+			n = sendmsg (worker.channel, &msg, 0);
+			if (n > 0) {
+				close (worker.fd);
+				worker.fd = -1;
+			}
+		} else
+			n = write (worker.channel, buf, length);
+		if (n < 0) {
+			if (errno == EINTR)
+				continue;
+			return errno == EAGAIN || errno == EWOULDBLOCK;
+		}
+		worker.sent += n;
+	}
+	return true;
+}
+
+bool BabelQueue::Receive (Worker &worker, bool hangup)
+{
+	char buf[CHUNK_SIZE];
+	while (true) {
+		// handle all the complete messages
+		size_t pos = 0;
+		ResultHeader header;
+		while (worker.job && worker.in.length () - pos >= sizeof (header)) {
+			memcpy (&header, worker.in.data () + pos, sizeof (header));
+			if (worker.in.length () - pos - sizeof (header) < header.size)
+				break;
+			char const *data = worker.in.data () + pos + sizeof (header);
+			pos += sizeof (header) + header.size;
+			if (header.type == RESULT_DATA)
+				worker.job->AddResult (data, header.size);
+			else {
+				worker.job->Finish (header.converted);
+				delete worker.job;
+				worker.job = NULL;
+				m_Running--;
+			}
+		}
+		worker.in.erase (0, pos);
+		// don't read more than the client can accept, unless the worker is gone
+		if (!hangup && worker.job && worker.job->m_Reply->IsFull ())
+			return true;
+		ssize_t n = read (worker.channel, buf, CHUNK_SIZE);
+		if (n == 0)
+			return false;
+		if (n < 0) {
+			if (errno == EINTR)
+				continue;
+			return errno == EAGAIN || errno == EWOULDBLOCK;
+		}
+		worker.in.append (buf, n);
+	}
+}
+
+void BabelQueue::AddPollFds (std::vector <struct pollfd> &fds)
+{
+	struct pollfd pfd;
+	std::vector <Worker>::iterator i, end = m_Workers.end ();
+	for (i = m_Workers.begin (); i != end; i++) {
+		pfd.fd = (*i).channel;
+		pfd.events = 0;
+		pfd.revents = 0;
+		if ((*i).job) {
+			if ((*i).sent < (*i).out.length () + (*i).size)
+				pfd.events |= POLLOUT;
+			if (!(*i).job->m_Reply->IsFull ())
+				pfd.events |= POLLIN;
+		}
+		fds.push_back (pfd);
+	}
+}
+
+void BabelQueue::Process (struct pollfd const *fds)
+{
+	unsigned i, nb = m_Workers.size ();
+	for (i = 0; fds && i < nb; i++) {
+		Worker &worker = m_Workers[i];
+		bool alive = true, hangup = fds[i].revents & (POLLHUP | POLLERR);
+		if (fds[i].revents & POLLOUT)
+			alive = Write (worker);
+		if (alive && (hangup || (fds[i].revents & POLLIN)))
+			alive = Receive (worker, hangup);
+		if (!alive) {
+			// the worker died or can't be reached, the conversion failed
+			if (worker.pid > 0)
+				kill (worker.pid, SIGKILL);
+			if (worker.job) {
+				worker.job->Abort ();
+				delete worker.job;
+				worker.job = NULL;
+				m_Running--;
+			}
+			Stop (worker);
+		}
+	}
+	// give the waiting jobs to the available workers
+	for (i = 0; i < nb && !m_Jobs.empty (); i++) {
+		Worker &worker = m_Workers[i];
+		if (worker.job || (worker.channel < 0 && !Spawn (worker)))
+			continue;
+		while (!worker.job && !m_Jobs.empty ()) {
+			BabelJob *job = m_Jobs.front ();
+			m_Jobs.pop_front ();
+			if (job->m_Reply->IsClosed ())
+				delete job; // nobody is waiting for the answer
+			else
+				Start (worker, job);
+		}
+	}
+}
@@ -0,0 +1,167 @@
+// -*- C++ -*-
+
+/*
+ * OpenBabel server
+ * queue.h
+ *
+ * Copyright (C) 2026 Jean Bréfort <jean.brefort@normalesup.org>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301
+ * USA
+ */
+
+
+#ifndef GCU_BABEL_QUEUE_H
+#define GCU_BABEL_QUEUE_H
+
+#include <poll.h>
+#include <sys/types.h>
+#include <list>
+#include <string>
+#include <vector>
+
+class BabelCache;
+
+/*
+ * The client side of a connection, shared by the socket parsing the requests
+ * and the jobs still waiting for their answer. Everything runs in the main
+ * loop: Send() only appends the answer to the output buffer, which the loop
+ * writes with Flush() when the socket is writable, so that a slow client never
+ * blocks the server. The socket is closed when the last reference is dropped.
+ */
+class BabelReply
+{
+public:
+	BabelReply (int socket);
+
+	void Ref ();
+	void Unref ();
+	void Send (std::string const &id, char const *data, size_t size);
+	// sends a whole streamed answer, by chunks as a worker would do
+	void Stream (std::string const &id, char const *data, size_t size);
+	// tells the client that the answer to the request is incomplete
+	void Fail (std::string const &id);
+	// writes as much as possible, returns -1 if the client can't be reached
+	int Flush ();
+	// drops the output, the connection is lost
+	void Close ();
+	bool HasOutput () const {return m_Out.length () > m_Sent;}
+	// true when enough output is waiting for the client to stop producing more
+	bool IsFull () const;
+	// true when nothing is waiting to be sent or computed
+	bool IsIdle () const {return m_RefCount == 1 && !HasOutput ();}
+	bool IsClosed () const {return m_Closed;}
+
+private:
+	~BabelReply ();
+
+private:
+	int m_Socket;
+	unsigned m_RefCount;
+	std::string m_Out;
+	size_t m_Sent;
+	bool m_Closed;
+};
+
+/*
+ * A fully parsed conversion request. The job owns the input data or file
+ * descriptor until they are sent to a worker, and builds the answer from what
+ * the worker returns. Requests sent without an identifier get the legacy
+ * "<length> <data>" answer, and nothing when the output is a file, while
+ * requests with an identifier are always answered with "<id> <length> <data>",
+ * so that several requests can be sent on the same connection. Streamed
+ * answers are sent as a series of such chunks while the conversion runs, the
+ * last one being empty. When the worker dies, the answer to a request with an
+ * identifier ends with "<id> -1 " instead, since what was sent might be
+ * truncated.
+ */
+class BabelJob
+{
+friend class BabelQueue;
+public:
+	BabelJob (BabelReply *reply, std::string const &id, std::string const &options, std::string const &input, std::string const &output, char *data, size_t size, int fd, bool stream);
+	~BabelJob ();
+
+	// the result will be added to the cache with the given key
+	void SetCache (BabelCache *cache, std::string const &key);
+
+private:
+	void AddResult (char const *data, size_t size);
+	void Finish (bool converted);
+	// the worker died
+	void Abort ();
+
+private:
+	BabelReply *m_Reply;
+	std::string m_Id, m_Options;
+	std::string m_Input, m_Output;
+	char *m_Data;
+	size_t m_Size;
+	int m_Fd;
+	bool m_Stream, m_Keep;
+	BabelCache *m_Cache;
+	std::string m_Key, m_Result;
+};
+
+/*
+ * A fixed set of worker processes fed by a bounded job queue. OpenBabel is not
+ * thread safe, so each conversion runs in a single threaded process forked
+ * once the plugins have been loaded. A worker receives one job at a time
+ * through a socket pair, with the input file descriptor passed as SCM_RIGHTS,
+ * and sends back the result by chunks; a worker which dies is replaced and its
+ * job answered as a failed conversion. Everything on the server side runs in
+ * the main loop, which polls the descriptors added by AddPollFds() and calls
+ * Process() with the results, so that a successful IsFull() test guarantees
+ * that the next Push() will succeed.
+ */
+class BabelQueue
+{
+public:
+	BabelQueue (unsigned workers, unsigned max_jobs);
+	~BabelQueue ();
+
+	bool Push (BabelJob *job);
+	bool IsFull () const {return m_Jobs.size () >= m_MaxJobs;}
+	bool IsBusy () const {return m_Running > 0 || !m_Jobs.empty ();}
+	void GetStatus (unsigned &running, unsigned &queued) const;
+	unsigned GetWorkers () const {return m_Workers.size ();}
+	unsigned GetMaxJobs () const {return m_MaxJobs;}
+	void AddPollFds (std::vector <struct pollfd> &fds);
+	// fds points to the first descriptor added by AddPollFds()
+	void Process (struct pollfd const *fds);
+
+private:
+	struct Worker {
+		pid_t pid;
+		int channel;
+		BabelJob *job;
+		std::string out, in; // the job description, and what has been received
+		char const *data; // the input data, sent after the description
+		size_t size, sent;
+		int fd; // sent with the first byte of the job
+	};
+	bool Spawn (Worker &worker);
+	void Stop (Worker &worker);
+	void Start (Worker &worker, BabelJob *job);
+	bool Write (Worker &worker);
+	bool Receive (Worker &worker, bool hangup);
+
+private:
+	std::list <BabelJob *> m_Jobs;
+	std::vector <Worker> m_Workers;
+	unsigned m_MaxJobs, m_Running;
+};
+
+#endif	//	GCU_BABEL_QUEUE_H
@@ -24,11 +24,16 @@
 
 #include "config.h"
 #include "socket.h"
+#include "queue.h"
+#include "cache.h"
 #include <unistd.h>
+#include <cerrno>
 #include <cstring>
 #include <cstdlib>
+#include <sstream>
 
 #define bufsize 128 // should be large enough
+#define MAX_FDS 16 // maximum number of file descriptors received at once
 
 enum {
 	STEP_INIT,
@@ -42,34 +47,120 @@ enum {
 	STEP_FORMAT_IN_OPTIONS,
 	STEP_FORMAT_OUT_OPTIONS,
 	STEP_GEN_OPTIONS,
-	STEP_LONG_OPTION
+	STEP_LONG_OPTION,
+	STEP_ID
 };
 
-BabelSocket::BabelSocket (int socket):
+BabelSocket::BabelSocket (int socket, BabelQueue *queue, BabelCache *cache):
 m_Socket (socket),
-m_Index (0),
-m_Cur (0),
-m_Start (0),
-m_Size (bufsize),
-m_WaitSpace (false),
-m_Step (STEP_INIT)
+m_InputFd (-1),
+m_InBuf (NULL),
+m_Pending (false),
+m_Finished (false),
+m_Eof (false),
+m_Conv (NULL),
+m_Queue (queue),
+m_Cache (cache)
 {
-	m_InBuf = new char[m_Size + 1];
+	m_Reply = new BabelReply (socket);
+	Reset (NULL, 0);
 }
 
 BabelSocket::~BabelSocket ()
 {
-	if (m_Socket)
-		close (m_Socket);
-	delete m_InBuf;
+	// the socket is closed when the running jobs do not need it anymore
+	m_Reply->Close ();
+	m_Reply->Unref ();
+	delete [] m_InBuf;
+	delete m_Conv;
+	if (m_InputFd >= 0)
+		close (m_InputFd);
+	std::list <int>::iterator i, end = m_Fds.end ();
+	for (i = m_Fds.begin (); i != end; i++)
+		close (*i);
 }
 
-size_t BabelSocket::Read ()
+void BabelSocket::Reset (char const *data, size_t length)
 {
-	size_t res = read (m_Socket, m_InBuf + m_Index, m_Size - m_Index);
-	if (res != -1) {
-		m_Index += res;
-		m_InBuf[m_Index] = 0;
+	char *buf = new char[((length > bufsize)? length: bufsize) + 1];
+	if (length)
+		memcpy (buf, data, length);
+	buf[length] = 0;
+	delete [] m_InBuf;
+	m_InBuf = buf;
+	m_Index = length;
+	m_Cur = m_Start = 0;
+	m_Size = (length > bufsize)? length: bufsize;
+	m_WaitSpace = m_SizeSet = m_Stream = false;
+	m_Step = STEP_INIT;
+	if (m_InputFd >= 0)
+		close (m_InputFd);
+	m_InputFd = -1;
+	m_Id.clear ();
+	m_Key.clear ();
+	m_Input.clear ();
+	m_Output.clear ();
+	if (!m_Conv)
+		m_Conv = new OpenBabel::OBConversion ();
+}
+
+int BabelSocket::Read ()
+{
+	if (m_Finished)
+		return -1;
+	if (m_Pending)
+		return 0; // wait until the queue accepts the request
+	// cache hits and status requests are answered at once, so stop parsing
+	// until the client reads what is waiting
+	if (m_Reply->IsFull ())
+		return 0;
+	int res = Parse ();
+	// requests received before the client closed its side are still parsed
+	return (res == 0 && m_Eof && !m_Pending)? -1: res;
+}
+
+int BabelSocket::Parse ()
+{
+	int res = 0;
+	if (m_Index == m_Size && !m_SizeSet) {
+		// the options are longer than expected
+		char *new_buf = new char[2 * m_Size + 1];
+		memcpy (new_buf, m_InBuf, m_Index + 1);
+		delete [] m_InBuf;
+		m_InBuf = new_buf;
+		m_Size *= 2;
+	}
+	if (m_Index < m_Size && !m_Eof) {
+		// file descriptors might be passed along with the data
+		struct iovec iov;
+		iov.iov_base = m_InBuf + m_Index;
+		iov.iov_len = m_Size - m_Index;
+		char control[CMSG_SPACE (MAX_FDS * sizeof (int))];
+		struct msghdr msg;
+		memset (&msg, 0, sizeof (msg));
+		msg.msg_iov = &iov;
+		msg.msg_iovlen = 1;
+		msg.msg_control = control;
+		msg.msg_controllen = sizeof (control);
+		ssize_t n = recvmsg (m_Socket, &msg, 0);
+		if (n > 0)
+			for (struct cmsghdr *cmsg = CMSG_FIRSTHDR (&msg); cmsg; cmsg = CMSG_NXTHDR (&msg, cmsg))
+				if (cmsg->cmsg_level == SOL_SOCKET && cmsg->cmsg_type == SCM_RIGHTS) {
+					int *fds = reinterpret_cast <int *> (CMSG_DATA (cmsg));
+					size_t nb = (cmsg->cmsg_len - CMSG_LEN (0)) / sizeof (int);
+					for (size_t i = 0; i < nb; i++)
+						m_Fds.push_back (fds[i]);
+				}
+		if (n == 0)
+			m_Eof = true; // the client closed its side of the connection
+		if (n < 0) {
+			if (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR)
+				return -1;
+		} else {
+			m_Index += n;
+			m_InBuf[m_Index] = 0;
+			res = 1;
+		}
 	}
 	while (m_Cur < m_Index) {
 		if (!m_WaitSpace && m_Step != STEP_DATA) {
@@ -101,7 +192,7 @@ size_t BabelSocket::Read ()
 				break;
 			case 'D':
 				m_Step = STEP_DATA;
-				if (m_Input.length () == 0) {
+				if (m_Input.length () == 0 && m_InputFd < 0) {
 					memmove (m_InBuf, m_InBuf + 2, m_Index + 1);
 					m_Index -= 2;
 				} else
@@ -132,13 +223,14 @@ size_t BabelSocket::Read ()
 				m_Cur++;
 			if (m_InBuf[m_Cur] == ' ') {
 				m_InBuf[m_Cur] = 0;
-				OpenBabel::OBFormat *format = m_Conv.FindFormat (m_InBuf + m_Start);
+				OpenBabel::OBFormat *format = m_Conv->FindFormat (m_InBuf + m_Start);
 				if (!format)
-					format = m_Conv.FormatFromMIME (m_InBuf + m_Start);
+					format = m_Conv->FormatFromMIME (m_InBuf + m_Start);
 				if (format)
-					m_Conv.SetInFormat (format);
+					m_Conv->SetInFormat (format);
 				else
 					return -1;
+				m_Key += std::string (" -i ") + (m_InBuf + m_Start);
 				FinishOption (STEP_INPUT);
 			}
 			break;
@@ -160,13 +252,14 @@ size_t BabelSocket::Read ()
 				m_Cur++;
 			if (m_InBuf[m_Cur] == ' ') {
 				m_InBuf[m_Cur] = 0;
-				OpenBabel::OBFormat *format = m_Conv.FindFormat (m_InBuf + m_Start);
+				OpenBabel::OBFormat *format = m_Conv->FindFormat (m_InBuf + m_Start);
 				if (!format)
-					format = m_Conv.FormatFromMIME (m_InBuf + m_Start);
+					format = m_Conv->FormatFromMIME (m_InBuf + m_Start);
 				if (format)
-					m_Conv.SetOutFormat (format);
+					m_Conv->SetOutFormat (format);
 				else
 					return -1;
+				m_Key += std::string (" -o ") + (m_InBuf + m_Start);
 				FinishOption (STEP_OUTPUT);
 			}
 			break;
@@ -193,40 +286,22 @@ size_t BabelSocket::Read ()
 				if (end && *end)
 					return -1; // invalid size
 				FinishOption (STEP_INIT);
+				m_SizeSet = true;
 				if (m_Size > bufsize) {
-					char *new_buf = new char[m_Size + 3]; // we need a bit more, at least because of the "-D"
+					// we need a bit more, at least because of the "-D"
+					char *new_buf = new char[((m_Size > m_Index)? m_Size: m_Index) + 3];
 					memcpy (new_buf, m_InBuf, m_Index);
 					delete [] m_InBuf;
 					m_InBuf = new_buf;
 					m_InBuf[m_Index] = 0;
 				}
-				return res; // force more read
+				return 1; // force more read
 			}
 			break;
 		case STEP_DATA:
-			if (m_Input.length () > 0 || m_Index == m_Size) {
-				std::istream *is;
-				if (m_Input.length ())
-					is = new std::ifstream (m_Input.c_str ());
-				else
-					is = new std::istringstream (m_InBuf);
-				std::ostream *os;
-				if (m_Output.length ())
-					os = new std::ofstream (m_Output.c_str ());
-				else
-					os = new std::ostringstream ();
-				m_Conv.Convert (is, os);
-				if (m_Output.length () == 0) {
-					std::ostringstream *oss = static_cast <std::ostringstream *> (os), l;
-					l << oss->str ().length () << " ";
-					write (m_Socket, l.str ().c_str (), l.str ().length ());
-					write (m_Socket, oss->str ().c_str (), oss->str ().length ());
-				} else
-					static_cast <std::ofstream *> (os)->close ();
-				delete is;
-				delete os;
-				return -1;
-			} else
+			if (m_Input.length () > 0 || m_InputFd >= 0 || m_Index >= m_Size)
+				return Submit ();
+			else
 				return res;
 		case STEP_FORMAT_IN_OPTIONS:
 			if (!m_Cur && m_InBuf[0] == '-') {
@@ -237,7 +312,7 @@ size_t BabelSocket::Read ()
 				m_Cur++;
 			if (m_InBuf[m_Cur] == ' ') {
 				m_InBuf[m_Cur] = 0;
-				m_Conv.SetOptions (m_InBuf + m_Start, OpenBabel::OBConversion::INOPTIONS);
+				m_Key += std::string (" -a ") + (m_InBuf + m_Start);
 				FinishOption (STEP_INIT);
 			}
 			break;
@@ -250,7 +325,7 @@ size_t BabelSocket::Read ()
 				m_Cur++;
 			if (m_InBuf[m_Cur] == ' ') {
 				m_InBuf[m_Cur] = 0;
-				m_Conv.SetOptions (m_InBuf + m_Start, OpenBabel::OBConversion::OUTOPTIONS);
+				m_Key += std::string (" -x ") + (m_InBuf + m_Start);
 				FinishOption (STEP_INIT);
 			}
 			break;
@@ -259,7 +334,7 @@ size_t BabelSocket::Read ()
 				m_Cur++;
 			if (m_InBuf[m_Cur] == ' ') {
 				m_InBuf[m_Cur] = 0;
-				m_Conv.SetOptions (m_InBuf + m_Start, OpenBabel::OBConversion::GENOPTIONS);
+				m_Key += std::string (" -") + (m_InBuf + m_Start);
 				FinishOption (STEP_INIT);
 			}
 			break;
@@ -268,13 +343,46 @@ size_t BabelSocket::Read ()
 				m_Cur++;
 			if (m_InBuf[m_Cur] == ' ') {
 				m_InBuf[m_Cur] = 0;
-				m_Conv.AddOption (m_InBuf + m_Start, OpenBabel::OBConversion::GENOPTIONS);
+				if (!strcmp (m_InBuf + m_Start, "status"))
+					return SendStatus ();
+				if (!strcmp (m_InBuf + m_Start, "id")) {
+					FinishOption (STEP_ID);
+					break;
+				}
+				if (!strcmp (m_InBuf + m_Start, "fd")) {
+					// the input is the first file descriptor not used yet
+					if (m_Fds.empty () || m_InputFd >= 0)
+						return -1;
+					m_InputFd = m_Fds.front ();
+					m_Fds.pop_front ();
+					FinishOption (STEP_INIT);
+					break;
+				}
+				if (!strcmp (m_InBuf + m_Start, "stream")) {
+					m_Stream = true;
+					FinishOption (STEP_INIT);
+					break;
+				}
+				m_Key += std::string (" --") + (m_InBuf + m_Start);
 				FinishOption (STEP_INIT);
 			}
+			break;
+		case STEP_ID:
+			while (m_InBuf[m_Cur] != ' ' && m_Cur < m_Index)
+				m_Cur++;
+			if (m_InBuf[m_Cur] == ' ') {
+				m_InBuf[m_Cur] = 0;
+				m_Id = m_InBuf + m_Start;
+				FinishOption (STEP_INIT);
+			}
+			break;
 		default:
 			break;
 		}
 	}
+	// the data might be empty or have been read with the options
+	if (m_Step == STEP_DATA && m_Index >= m_Size)
+		return Submit ();
 	return res;
 }
 
@@ -288,3 +396,100 @@ void BabelSocket::FinishOption (unsigned step)
 	m_Cur = m_Start = 0;
 	m_Step = step;
 }
+
+int BabelSocket::Submit ()
+{
+	// only conversions of data sent through the socket are cached
+	bool cacheable = m_Cache && m_Input.length () == 0 && m_InputFd < 0 && m_Output.length () == 0;
+	std::string result;
+	// when the request is pending, it has already been looked for
+	if (cacheable && !m_Pending && m_Cache->Lookup (m_Key, m_InBuf, m_Size, result)) {
+		// answer at once without using a worker
+		if (m_Stream && m_Id.length ())
+			m_Reply->Stream (m_Id, result.data (), result.length ());
+		else
+			m_Reply->Send (m_Id, result.data (), result.length ());
+		return Next (m_InBuf + m_Size);
+	}
+	if (m_Queue->IsFull ()) {
+		// the socket will not be polled until the queue accepts the request
+		m_Pending = true;
+		return 0;
+	}
+	m_Pending = false;
+	// keep what follows the request, it is the start of the next one
+	char const *next;
+	if (m_Input.length () || m_InputFd >= 0)
+		next = m_InBuf + 2; // just after "-D"
+	else
+		next = m_InBuf + m_Size;
+	std::string left (next, m_Index - (next - m_InBuf));
+	m_InBuf[next - m_InBuf] = 0;
+	// the job now owns the buffer and the file descriptor, and the worker
+	// process gets the formats and options parsed here
+	BabelJob *job = new BabelJob (m_Reply, m_Id, m_Key, m_Input, m_Output, m_InBuf, m_Size, m_InputFd, m_Stream);
+	if (cacheable)
+		job->SetCache (m_Cache, m_Key);
+	bool persistent = m_Id.length () > 0;
+	m_InBuf = NULL;
+	m_InputFd = -1;
+	if (!m_Queue->Push (job)) {
+		// should not happen since only the main loop pushes jobs
+		delete job;
+		return -1;
+	}
+	if (!persistent)
+		return -1;
+	Reset (left.c_str (), left.length ());
+	return 1;
+}
+
+int BabelSocket::Next (char const *next)
+{
+	if (!m_Id.length ())
+		return -1;
+	std::string left (next, m_Index - (next - m_InBuf));
+	Reset (left.c_str (), left.length ());
+	return 1;
+}
+
+int BabelSocket::SendStatus ()
+{
+	unsigned running, queued;
+	m_Queue->GetStatus (running, queued);
+	std::ostringstream status;
+	status << "workers=" << m_Queue->GetWorkers () << " running=" << running << " queued=" << queued << " max_queued=" << m_Queue->GetMaxJobs ();
+	if (m_Cache) {
+		unsigned entries;
+		size_t size;
+		unsigned long hits, misses;
+		m_Cache->GetStatus (entries, size, hits, misses);
+		status << " cache_entries=" << entries << " cache_size=" << size << " cache_hits=" << hits << " cache_misses=" << misses;
+	}
+	m_Reply->Send (m_Id, status.str ().c_str (), status.str ().length ());
+	// skip the space following the option, and "-D" if any, as for other requests
+	size_t next = m_Cur + 1;
+	if (m_Index >= next + 2 && !strncmp (m_InBuf + next, "-D", 2))
+		next += 2;
+	return Next (m_InBuf + next);
+}
+
+bool BabelSocket::IsDone () const
+{
+	return m_Finished && !m_Pending && m_Reply->IsIdle ();
+}
+
+bool BabelSocket::IsFull () const
+{
+	return m_Reply->IsFull ();
+}
+
+bool BabelSocket::HasOutput () const
+{
+	return m_Reply->HasOutput ();
+}
+
+int BabelSocket::Flush ()
+{
+	return m_Reply->Flush ();
+}
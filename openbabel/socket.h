@@ -27,27 +27,64 @@
 
 #include <sys/socket.h>
 #include <openbabel/obconversion.h>
+#include <list>
 #include <string>
 
+class BabelCache;
+class BabelQueue;
+class BabelReply;
+
+/*
+ * Parses the requests sent by a client. Read() returns a positive value if
+ * more data might be available, 0 if the socket must be polled again, and -1
+ * if no more requests must be read, which occurs after the first request unless
+ * it was given an identifier with "--id". In that case, the connection stays
+ * open and the following requests are parsed as soon as the previous one has
+ * been submitted. Once finished, the socket is kept until all the answers have
+ * been written. Instead of a file name or data, the input might be a file
+ * descriptor sent with the request (SCM_RIGHTS) and selected by "--fd", and
+ * "--stream" asks for the answer to be sent by chunks. Answers to requests
+ * found in the cache are sent at once, without using a worker.
+ */
 class BabelSocket
 {
 public:
-	BabelSocket (int socket);
+	BabelSocket (int socket, BabelQueue *queue, BabelCache *cache);
 	~BabelSocket ();
 
-	size_t Read ();
+	int Read ();
+	int Submit ();
+	bool IsPending () const {return m_Pending;}
+	// stops reading requests
+	void Finish () {m_Finished = true;}
+	bool IsFinished () const {return m_Finished;}
+	// true when the socket can be closed
+	bool IsDone () const;
+	bool HasOutput () const;
+	// true when too many answers are waiting for the client to read more requests
+	bool IsFull () const;
+	int Flush ();
 
 private:
+	int Parse ();
 	void FinishOption (unsigned step);
+	int SendStatus ();
+	int Next (char const *next);
+	void Reset (char const *data, size_t length);
 
 private:
-	int m_Socket;
+	int m_Socket, m_InputFd;
+	std::list <int> m_Fds; // received, but not yet used, file descriptors
+	BabelReply *m_Reply;
+	std::string m_Id, m_Key;
 	char *m_InBuf;
 	size_t m_Index, m_Cur, m_Start, m_Size;
-	bool m_WaitSpace;
+	bool m_WaitSpace, m_Pending, m_SizeSet, m_Stream, m_Finished, m_Eof;
 	unsigned m_Step;
 	std::string m_Input, m_Output;
-	OpenBabel::OBConversion m_Conv;
+	OpenBabel::OBConversion *m_Conv; // only checks the formats, conversions run in workers
+	BabelQueue *m_Queue;
+	BabelCache *m_Cache;
 };
 
 #endif	//	GCU_BABEL_SOCKET_H
@@ -27,11 +27,11 @@
 #include <gcu/document.h>
 #include <gcu/loader.h>
 #include <gcu/element.h>
+#include <gcu/input.h>
 #include <gcu/objprops.h>
 #include <gcu/spacegroup.h>
 #include <gcu/transform3d.h>
 #include <goffice/app/module-plugin-defs.h>
-#include <gsf/gsf-input-textline.h>
 #include <glib/gi18n-lib.h>
 #include <map>
 #include <stack>
@@ -64,6 +64,7 @@ enum { // local only properties
 CIFLoader::CIFLoader ()
 {
 	AddMimeType ("chemical/x-cif");
+	m_MappedInput = true;
 
 	KnownProps["_publ_contact_author_name"] = GCU_PROP_DOC_CREATOR;
 	KnownProps["_publ_author_name"] = GCU_PROP_DOC_CREATOR;
@@ -119,7 +120,7 @@ ContentType CIFLoader::Read  (Document *doc, GsfInput *in, G_GNUC_UNUSED char co
 {
 	ContentType type = ContentTypeCrystal;
 	Application *app = doc->GetApplication ();
-	GsfInputTextline *input = reinterpret_cast <GsfInputTextline *> (gsf_input_textline_new (in));
+	LineReader input (in);
 	char *buf;
 	bool in_string = false, in_loop = false, waiting_value = false, empty = true;
 	string key, value;
@@ -136,7 +137,7 @@ ContentType CIFLoader::Read  (Document *doc, GsfInput *in, G_GNUC_UNUSED char co
 	SpaceGroup *group = new SpaceGroup ();
 	bool author_found = false;
 	doc->SetScale (100.); // lentghs and positions pus be converted to pm
-	while ((buf = reinterpret_cast <char *> (gsf_input_textline_utf8_gets (input)))) {
+	while ((buf = input.GetLine ())) {
 		char *cur = buf, *next;
 		size = strlen (buf);
 		// check for new data bloc
@@ -481,7 +482,6 @@ ContentType CIFLoader::Read  (Document *doc, GsfInput *in, G_GNUC_UNUSED char co
 read_exit:
 	if (group)
 		delete group;
-	g_object_unref (input);
 	return type;
 }
 
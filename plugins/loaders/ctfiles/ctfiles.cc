@@ -28,11 +28,15 @@
 #include <gcu/loader.h>
 #include <gcu/molecule.h>
 #include <gcu/objprops.h>
+#include <gcu/sdfile.h>
 #include <goffice/app/module-plugin-defs.h>
-#include <gsf/gsf-input-textline.h>
+#include <gsf/gsf-input.h>
 #include <gsf/gsf-output.h>
 #include <glib/gi18n-lib.h>
+#include <cmath>
+#include <list>
 #include <map>
+#include <set>
 #include <sstream>
 #include <stack>
 #include <string>
@@ -50,23 +54,34 @@ typedef struct {
 	gcu::Document *doc;
 	gcu::Application *app;
 	GOIOContext *context;
-	GsfInputTextline *input;
+	gcu::SDReader *input;
+	unsigned line; // the next line of the current record
 	std::stack < gcu::Object * > cur;
 	gcu::ContentType type;
 	bool v3000;
+	bool first; // whether the document title has not been read yet
 	unsigned na, nb, nsg, n3d;
 	bool chiral;
 	CTfileType cttype;
 	std::vector < gcu::Object * > atoms;
+	gcu::Object *molecule; // the last molecule read
+	std::vector < double > coords; // the atoms coordinates as read, x, y and z for each atom
+	double length; // the sum of the bond lengths of the current molecule
+	bool layout; // whether the molecules are reaction components laid out from left to right
+	double x, bond; // where the next component starts, and the last mean bond length
 } CTReadState;
 
+// the space between reaction components and the arrow length, in bond lengths
+#define CT_REACTION_SPACE 2.
+#define CT_REACTION_ARROW 4.
+
 class CTfilesLoader;
 typedef struct {
 	CTfilesLoader *loader;
 	GsfOutput *out;
 	GOIOContext *io;
 	gcu::ContentType type;
-	std::map < gcu::Object const * , unsigned> indices;
+	std::map < std::string, unsigned > indices;
 	unsigned cur;
 } CTWriteState;
 
@@ -89,8 +104,12 @@ private:
 	bool ReadHeader (CTReadState *state);
 	bool ReadCounts (CTReadState *state, char const *source);
 	bool ReadMolecule (CTReadState *state);
+	bool ReadReaction (CTReadState *state);
 	bool ReadAtom (CTReadState *state, unsigned i);
 	bool ReadBond (CTReadState *state);
+	gcu::Object *CreateAtom (CTReadState *state, char const *symbol);
+	bool WriteMolfile (CTWriteState *state, gcu::Object const *molecule);
+	bool WriteRxnfile (CTWriteState *state, gcu::Object const *reaction);
 };
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -98,31 +117,56 @@ private:
 
 bool ct_write_atom (CTWriteState *state, gcu::Object const *object)
 {
-	return true;
+	double x = 0., y = 0., z = 0.;
+	std::string prop = object->GetProperty ((state->type == gcu::ContentType3D)? GCU_PROP_POS3D: GCU_PROP_POS2D);
+	if (prop.length ()) {
+		std::istringstream in (prop);
+		in >> x >> y;
+		if (state->type == gcu::ContentType3D)
+			in >> z;
+	}
+	char bx[G_ASCII_DTOSTR_BUF_SIZE], by[G_ASCII_DTOSTR_BUF_SIZE], bz[G_ASCII_DTOSTR_BUF_SIZE];
+	g_ascii_formatd (bx, G_ASCII_DTOSTR_BUF_SIZE, "%.4f", x);
+	g_ascii_formatd (by, G_ASCII_DTOSTR_BUF_SIZE, "%.4f", -y); // reverse y order
+	g_ascii_formatd (bz, G_ASCII_DTOSTR_BUF_SIZE, "%.4f", z);
+	prop = object->GetProperty (GCU_PROP_ATOM_SYMBOL);
+	gsf_output_printf (state->out, "M  V30 %u %s %s %s %s 0", state->indices[object->GetId ()], prop.c_str (), bx, by, bz);
+	int charge = atoi (object->GetProperty (GCU_PROP_ATOM_CHARGE).c_str ());
+	if (charge)
+		gsf_output_printf (state->out, " CHG=%d", charge);
+	return gsf_output_write (state->out, 1, reinterpret_cast < guint8 const * > ("\n"));
 }
 
-bool ct_write_fragment (CTWriteState *state, gcu::Object const *object)
+bool ct_write_fragment (G_GNUC_UNUSED CTWriteState *state, G_GNUC_UNUSED gcu::Object const *object)
 {
+	// fragments are not supported for now
 	return true;
 }
 
 bool ct_write_bond (CTWriteState *state, gcu::Object const *object)
 {
-	return true;
+	unsigned begin = state->indices[object->GetProperty (GCU_PROP_BOND_BEGIN)],
+			 end = state->indices[object->GetProperty (GCU_PROP_BOND_END)];
+	gsf_output_printf (state->out, "M  V30 %u %s %u %u", ++state->cur, object->GetProperty (GCU_PROP_BOND_ORDER).c_str (), begin, end);
+	std::string type = object->GetProperty (GCU_PROP_BOND_TYPE);
+	if (type == "wedge")
+		gsf_output_printf (state->out, " CFG=1");
+	else if (type == "hash")
+		gsf_output_printf (state->out, " CFG=3");
+	return gsf_output_write (state->out, 1, reinterpret_cast < guint8 const * > ("\n"));
 }
 
 bool ct_write_molecule (CTWriteState *state, gcu::Object const *object)
 {
 	std::map < std::string, gcu::Object * >::const_iterator i;
 	gcu::Object const *child = object->GetFirstChild (i);
-	std::list < gcu::Object const * > bonds, fragments;
+	std::list < gcu::Object const * > atoms, bonds;
+	// the counts must be known before saving anything, so first number the atoms
 	while (child) {
 		switch (child->GetType ()) {
-		case gcu::FragmentType:
-			fragments.push_back (child); 
 		case gcu::AtomType:
-			state->loader->WriteObject (state, child);
-			state->indices[child] = ++state->cur;
+			atoms.push_back (child);
+			state->indices[child->GetId ()] = atoms.size ();
 			break;
 		case gcu::BondType:
 			bonds.push_back (child);
@@ -132,12 +176,28 @@ bool ct_write_molecule (CTWriteState *state, gcu::Object const *object)
 		}
 		child = object->GetNextChild (i);
 	}
+	// drop bonds to unsupported objects such as fragments
+	std::list < gcu::Object const * >::iterator it = bonds.begin (), end;
+	while (it != bonds.end ())
+		if (state->indices.find ((*it)->GetProperty (GCU_PROP_BOND_BEGIN)) == state->indices.end () ||
+		    state->indices.find ((*it)->GetProperty (GCU_PROP_BOND_END)) == state->indices.end ())
+			it = bonds.erase (it);
+		else
+			++it;
+	gsf_output_printf (state->out, "M  V30 BEGIN CTAB\nM  V30 COUNTS %u %u 0 0 0\nM  V30 BEGIN ATOM\n",
+	                   static_cast < unsigned > (atoms.size ()), static_cast < unsigned > (bonds.size ()));
+	for (it = atoms.begin (), end = atoms.end (); it != end; ++it)
+		state->loader->WriteObject (state, *it);
+	gsf_output_printf (state->out, "M  V30 END ATOM\n");
 	// now save bonds
 	if (bonds.size () > 0) {
-		std::list < gcu::Object const * >::iterator it, end = bonds.end ();
-		for (it = bonds.begin (); it != end; ++it)
+		state->cur = 0;
+		gsf_output_printf (state->out, "M  V30 BEGIN BOND\n");
+		for (it = bonds.begin (), end = bonds.end (); it != end; ++it)
 			state->loader->WriteObject (state, *it);
+		gsf_output_printf (state->out, "M  V30 END BOND\n");
 	}
+	gsf_output_printf (state->out, "M  V30 END CTAB\n");
 	state->cur = 0;
 	state->indices.clear ();
 	return true;
@@ -149,65 +209,89 @@ bool ct_write_molecule (CTWriteState *state, gcu::Object const *object)
 CTfilesLoader::CTfilesLoader ()
 {
 	AddMimeType ("chemical/x-mdl-molfile");
+	AddMimeType ("chemical/x-mdl-sdfile");
+	AddMimeType ("chemical/x-mdl-rdfile");
+	AddMimeType ("chemical/x-mdl-rxnfile");
+	m_MappedInput = true;
 	m_WriteCallbacks["molecule"] = ct_write_molecule;
-	m_WriteCallbacks["atom"] = ct_write_molecule;
-	m_WriteCallbacks["fragment"] = ct_write_molecule;
-	m_WriteCallbacks["bond"] = ct_write_molecule;
+	m_WriteCallbacks["atom"] = ct_write_atom;
+	m_WriteCallbacks["fragment"] = ct_write_fragment;
+	m_WriteCallbacks["bond"] = ct_write_bond;
 }
 
 CTfilesLoader::~CTfilesLoader ()
 {
 	RemoveMimeType ("chemical/x-mdl-molfile");
+	RemoveMimeType ("chemical/x-mdl-sdfile");
+	RemoveMimeType ("chemical/x-mdl-rdfile");
+	RemoveMimeType ("chemical/x-mdl-rxnfile");
 }
 
 ////////////////////////////////////////////////////////////////////////////////
 // Reading code
 
+static char const *ct_get_line (CTReadState *state)
+{
+	return state->input->GetLine (state->line++);
+}
+
+static bool ct_check_line (CTReadState *state, char const *text)
+{
+	char const *buf = ct_get_line (state);
+	return buf && !strncmp (buf, text, strlen (text));
+}
+
 bool CTfilesLoader::ReadHeader (CTReadState *state)
 {
-	char *buf = reinterpret_cast <char *> (gsf_input_textline_utf8_gets (state->input));
-	if (!strncmp (buf, "$RDFILE", 6)) {
-		// RDfile
-		state->cttype = RDfile;
-	} else if (!strncmp (buf, "$RXN", 4)) {
-		// RXN file
-		state->cttype = RXNfile;
-	} else if (!strncmp (buf, "$MDL", 4)) {
+	char const *buf = ct_get_line (state);
+	if (!buf)
+		return false;
+	if (!strncmp (buf, "$MDL", 4)) {
 		// V2000 RGroup
 		state->cttype = RGfile;
-	} else {
-		// either MOL SDfile or RGroup
-		state->cttype = MOLfile;
-		state->doc->SetTitle (buf); // note that this is wrong if we have more than one molecule
-		// line 2
-		buf = reinterpret_cast <char *> (gsf_input_textline_utf8_gets (state->input));
-		state->type = (strncmp (buf + 20, "3D", 2))? gcu::ContentType2D: gcu::ContentType3D;
-		// FIXME, we might retrieve author initials and date from there if available
-		// line 3
-		buf = reinterpret_cast <char *> (gsf_input_textline_utf8_gets (state->input));
+		return false;
+	}
+	if (state->first)
+		state->doc->SetTitle (buf);
+	// line 2
+	buf = ct_get_line (state);
+	if (!buf)
+		return false;
+	if (strlen (buf) >= 22 && !strncmp (buf + 20, "3D", 2))
+		state->type = gcu::ContentType3D;
+	else if (state->type == gcu::ContentTypeUnknown)
+		state->type = gcu::ContentType2D;
+	// FIXME, we might retrieve author initials and date from there if available
+	// line 3
+	buf = ct_get_line (state);
+	if (!buf)
+		return false;
+	if (state->first) {
 		state->doc->SetComment (buf);
-		// line 4
-		buf = reinterpret_cast <char *> (gsf_input_textline_utf8_gets (state->input));
-		if (strlen (buf) < 37) {
-			// FIXME: send an error message
-			return false;
-		}
-		char *ver = buf + 33;
-		while (*ver == ' ')
-			ver++;
-		if (!strncmp (ver, "V3000", 5))
-			state->v3000 = true;
-		else if (strncmp (ver, "V2000", 5)) {
-			// unknown version
+		state->first = false;
+	}
+	// line 4
+	buf = ct_get_line (state);
+	if (!buf || strlen (buf) < 37) {
+		// FIXME: send an error message
+		return false;
+	}
+	char const *ver = buf + 33;
+	while (*ver == ' ')
+		ver++;
+	state->v3000 = false;
+	if (!strncmp (ver, "V3000", 5))
+		state->v3000 = true;
+	else if (strncmp (ver, "V2000", 5)) {
+		// unknown version
+		// FIXME: send an error message
+		return false;
+	}
+	if (!state->v3000)
+		if (!ReadCounts (state, buf)) { // we know that we have enough characters in the buffer
 			// FIXME: send an error message
 			return false;
 		}
-		if (!state->v3000)
-			if (!ReadCounts (state, buf)) { // we know that we have enough characters in the buffer
-				// FIXME: send an error message
-				return false;
-			}
-	}
 	return true;
 }
 
@@ -244,19 +328,19 @@ bool CTfilesLoader::ReadCounts (CTReadState *state, char const *source)
 
 bool CTfilesLoader::ReadMolecule (CTReadState *state)
 {
-	char *buf;
+	char const *buf;
 	unsigned i;
 	// first if V3000, we need to read some extra lines
 	if (state->v3000) {
-		buf = reinterpret_cast <char *> (gsf_input_textline_utf8_gets (state->input));
-		if (strncmp (buf, "M  V30 BEGIN CTAB", 17)) {
+		buf = ct_get_line (state);
+		if (!buf || strncmp (buf, "M  V30 BEGIN CTAB", 17)) {
 			// FIXME: send an error message
 			return false;
 		}
 		// FIXME: what should we do with the name if any?
 		// counts line
-		buf = reinterpret_cast <char *> (gsf_input_textline_utf8_gets (state->input));
-		if (strncmp (buf, "M  V30 COUNTS", 13)) {
+		buf = ct_get_line (state);
+		if (!buf || strncmp (buf, "M  V30 COUNTS", 13)) {
 			// FIXME: send an error message
 			return false;
 		}
@@ -270,178 +354,391 @@ bool CTfilesLoader::ReadMolecule (CTReadState *state)
 	// we can now create the molecule and push it on the stack
 	gcu::Object *molecule = state->app->CreateObject ("molecule", state->cur.top ());
 	state->cur.push (molecule);
+	state->molecule = molecule;
+	state->atoms.clear ();
 	state->atoms.resize (state->na, NULL);
+	state->coords.assign (3 * state->na, 0.);
+	state->length = 0.;
 	// now read atoms
+	if (state->v3000 && !ct_check_line (state, "M  V30 BEGIN ATOM"))
+		return false;
 	for (i = 0; i < state->na; i++)
 		if (!ReadAtom (state, i))
 			return false;
+	if (state->v3000 && !ct_check_line (state, "M  V30 END ATOM"))
+		return false;
 	state->doc->EmptyTranslationTable();
+	if (state->v3000 && state->nb > 0 && !ct_check_line (state, "M  V30 BEGIN BOND"))
+		return false;
 	for (i = 0; i < state->nb; i++)
 		if (!ReadBond (state))
 			return false;
+	// reaction components are centered on the arrow line, after the previous one
+	double dx = 0., dy = 0.;
+	if (state->layout && state->na > 0) {
+		double xmin = state->coords[0], xmax = xmin, ymin = state->coords[1], ymax = ymin;
+		for (i = 1; i < state->na; i++) {
+			double x = state->coords[3 * i], y = state->coords[3 * i + 1];
+			if (x < xmin)
+				xmin = x;
+			else if (x > xmax)
+				xmax = x;
+			if (y < ymin)
+				ymin = y;
+			else if (y > ymax)
+				ymax = y;
+		}
+		if (state->nb > 0 && state->length > 0.)
+			state->bond = state->length / state->nb;
+		dx = state->x - xmin;
+		dy = -(ymin + ymax) / 2.;
+		state->x = xmax + dx + CT_REACTION_SPACE * state->bond;
+	}
+	std::ostringstream res;
+	res.precision (12);
+	for (i = 0; i < state->na; i++) {
+		res.str ("");
+		res << state->coords[3 * i] + dx;
+		state->atoms[i]->SetProperty (GCU_PROP_X, res.str ().c_str ());
+		res.str ("");
+		res << -(state->coords[3 * i + 1] + dy); // reverse y order
+		state->atoms[i]->SetProperty (GCU_PROP_Y, res.str ().c_str ());
+		if (state->coords[3 * i + 2] != 0.) {
+			state->type = gcu::ContentType3D;
+			res.str ("");
+			res << state->coords[3 * i + 2];
+			state->atoms[i]->SetProperty (GCU_PROP_Z, res.str ().c_str ());
+		}
+	}
 	// and now properties if any
 	state->cur.pop ();
 	return true;
 }
 
+bool CTfilesLoader::ReadReaction (CTReadState *state)
+{
+	char const *buf = ct_get_line (state);
+	if (!buf || strncmp (buf, "$RXN", 4))
+		return false;
+	if (strstr (buf, "V3000")) {
+		go_io_warning (state->context, _("V3000 reactions are not supported for now"));
+		return false;
+	}
+	// the reaction name, the program and comment lines
+	buf = ct_get_line (state);
+	if (!buf)
+		return false;
+	if (state->first)
+		state->doc->SetTitle (buf);
+	ct_get_line (state);
+	buf = ct_get_line (state);
+	if (!buf)
+		return false;
+	if (state->first) {
+		state->doc->SetComment (buf);
+		state->first = false;
+	}
+	// counts line
+	buf = ct_get_line (state);
+	if (!buf || strlen (buf) < 6)
+		return false;
+	char field[4];
+	field[3] = 0;
+	strncpy (field, buf, 3);
+	unsigned nr = strtoul (field, NULL, 10), n = nr;
+	strncpy (field, buf + 3, 3);
+	n += strtoul (field, NULL, 10);
+	// the components are laid out from left to right, with the arrow between
+	// the reactants and the products
+	gcu::Object *reaction = state->app->CreateObject ("reaction", state->cur.top ()),
+				*arrow = (reaction)? state->app->CreateObject ("reaction-arrow", reaction): NULL;
+	if (!arrow) {
+		delete reaction;
+		if (state->context)
+			go_io_error_string (state->context, _("This application does not support reactions"));
+		return false;
+	}
+	state->layout = true;
+	state->x = 0.;
+	state->bond = 1.;
+	std::vector < gcu::Object * > molecules;
+	std::ostringstream coords;
+	coords.precision (12);
+	for (unsigned i = 0; i <= n; i++) {
+		if (i == nr) {
+			// the reactants are all there, so this is where the arrow starts
+			coords << state->x << " 0 ";
+			state->x += CT_REACTION_ARROW * state->bond;
+			coords << state->x << " 0";
+			arrow->SetProperty (GCU_PROP_ARROW_COORDS, coords.str ().c_str ());
+			state->x += CT_REACTION_SPACE * state->bond;
+		}
+		if (i == n)
+			break;
+		do
+			buf = ct_get_line (state);
+		while (buf && strncmp (buf, "$MOL", 4));
+		if (!buf || !ReadHeader (state) || !ReadMolecule (state)) {
+			state->layout = false;
+			return false;
+		}
+		molecules.push_back (state->molecule);
+	}
+	state->layout = false;
+	// now, build the two steps and move the molecules inside
+	for (unsigned side = 0; side < 2; side++) {
+		unsigned first = (side)? nr: 0, last = (side)? n: nr;
+		if (first == last)
+			continue;
+		gcu::Object *step = state->app->CreateObject ("reaction-step", reaction);
+		if (!step)
+			return false;
+		arrow->SetProperty ((side)? GCU_PROP_ARROW_END_ID: GCU_PROP_ARROW_START_ID, step->GetId ());
+		for (unsigned i = first; i < last; i++) {
+			gcu::Object *reactant = state->app->CreateObject ("reactant", step);
+			if (!reactant)
+				return false;
+			reactant->SetProperty (GCU_PROP_MOLECULE, molecules[i]->GetId ());
+		}
+		step->OnLoaded ();
+	}
+	return true;
+}
+
+gcu::Object *CTfilesLoader::CreateAtom (CTReadState *state, char const *symbol)
+{
+	gcu::Object *atom = NULL;
+	if (!strcmp (symbol, "R#")) {
+		// Create an R group
+		atom = state->app->CreateObject ("fragment", state->cur.top ());
+		atom->SetProperty (GCU_PROP_TEXT_TEXT, "R"); // FIXME
+		atom->SetProperty (GCU_PROP_FRAGMENT_ATOM_START, "0");
+	} else if (!strcmp (symbol, "L")) {
+		// ??
+	} else if (!strcmp (symbol, "A")) {
+		// ??
+	} else if (!strcmp (symbol, "Q")) {
+		// ??
+	} else if (!strcmp (symbol, "*")) {
+		// ??
+	} else if (!strcmp (symbol, "LP")) {
+		// ??
+	} else {
+		atom = state->app->CreateObject ("atom", state->cur.top ());
+		atom->SetProperty (GCU_PROP_ATOM_SYMBOL, symbol);
+	}
+	return atom;
+}
+
 bool CTfilesLoader::ReadAtom (CTReadState *state, unsigned i)
 {
-	char *buf = reinterpret_cast <char *> (gsf_input_textline_utf8_gets (state->input));
+	char const *buf = ct_get_line (state);
 	gcu::Object *atom = NULL;
+	double x, y, z;
+	char *end;
+	if (!buf)
+		return false;
 	if (state->v3000) {
+		// "M  V30 index type x y z aamap [properties]"
+		if (strncmp (buf, "M  V30 ", 7))
+			return false;
+		strtoul (buf + 7, &end, 10);
+		char const *symbol = end;
+		while (*symbol == ' ')
+			symbol++;
+		char const *symbol_end = strchr (symbol, ' ');
+		if (!symbol_end)
+			return false;
+		atom = CreateAtom (state, std::string (symbol, symbol_end - symbol).c_str ());
+		if (!atom)
+			return false;
+		x = g_ascii_strtod (symbol_end, &end);
+		y = g_ascii_strtod (end, &end);
+		z = g_ascii_strtod (end, &end);
+		char const *charge = strstr (end, "CHG=");
+		if (charge)
+			atom->SetProperty (GCU_PROP_ATOM_CHARGE, std::string (charge + 4, strcspn (charge + 4, " ")).c_str ());
 	} else {
-		char coord[11], *end;
+		char coord[11];
 		coord[10] = 0;
-		double x;
 		if (strlen (buf) < 69) {
 			// FIXME: send an error message
 			return false;
 		}
-		// first the atom symbo
+		// first the atom symbol
 		strncpy (coord, buf + 31, 3);
 		coord[3] = 0;
 		if (coord[1] == ' ')
 			coord[1] = 0;
 		else if (coord[2] == ' ')
 			coord[2] = 0;
-		if (!strcmp (coord, "R#")) {
-			// Create an R group
-			atom = state->app->CreateObject ("fragment", state->cur.top ());
-			atom->SetProperty (GCU_PROP_TEXT_TEXT, "R"); // FIXME
-			atom->SetProperty (GCU_PROP_FRAGMENT_ATOM_START, "0");
-		} else if (!strcmp (coord, "L")) {
-			// ??
-			return false;
-		} else if (!strcmp (coord, "A")) {
-			// ??
+		atom = CreateAtom (state, coord);
+		if (!atom)
 			return false;
-		} else if (!strcmp (coord, "Q")) {
-			// ??
-			return false;
-		} else if (!strcmp (coord, "*")) {
-			// ??
-			return false;
-		} else if (!strcmp (coord, "LP")) {
-			// ??
-			return false;
-		} else {
-			atom = state->app->CreateObject ("atom", state->cur.top ());
-			atom->SetProperty (GCU_PROP_ATOM_SYMBOL, coord);
-		}
 		strncpy (coord, buf, 10);
 		x = g_ascii_strtod (coord, &end);
 		if (*end != ' ' && *end != 0) {
 			// FIXME: send an error message
 			return false;
 		}
-		atom->SetProperty (GCU_PROP_X, coord);
 		strncpy (coord, buf + 10, 10);
-		x = -g_ascii_strtod (coord, &end);
+		y = g_ascii_strtod (coord, &end);
 		if (*end != ' ' && *end != 0) {
 			// FIXME: send an error message
 			return false;
 		}
-		std::ostringstream res;
-		res << x;
-		atom->SetProperty (GCU_PROP_Y, res.str ().c_str ());
 		strncpy (coord, buf + 20, 10);
-		x = g_ascii_strtod (coord, &end);
+		z = g_ascii_strtod (coord, &end);
 		if (*end != ' ' && *end != 0) {
 			// FIXME: send an error message
 			return false;
 		}
-		if (x != 0.) {
-			state->type = gcu::ContentType3D;
-			atom->SetProperty (GCU_PROP_Z, coord);
-		}
 	}
+	// the position is set once the whole molecule is known
+	state->coords[3 * i] = x;
+	state->coords[3 * i + 1] = y;
+	state->coords[3 * i + 2] = z;
 	state->atoms[i] = atom;
 	return true;
 }
 
+static void ct_set_bond_atom (gcu::Object *bond, unsigned property, gcu::Object *atom)
+{
+	std::string id = atom->GetProperty (GCU_PROP_FRAGMENT_ATOM_ID);
+	if (id.length () == 0)
+		id = atom->GetProperty (GCU_PROP_ID);
+	bond->SetProperty (property, id.c_str ());
+}
+
 bool CTfilesLoader::ReadBond (CTReadState *state)
 {
-	char *buf = reinterpret_cast <char *> (gsf_input_textline_utf8_gets (state->input));
-	gcu::Object *bond = state->app->CreateObject ("bond", state->cur.top ());
-	unsigned i;
-	std::string id;
+	char const *buf = ct_get_line (state);
+	unsigned begin, end, order, stereo;
+	char *stop;
+	if (!buf)
+		return false;
 	if (state->v3000) {
-		return false; // FIXME
+		// "M  V30 index type atom1 atom2 [properties]"
+		if (strncmp (buf, "M  V30 ", 7))
+			return false;
+		strtoul (buf + 7, &stop, 10);
+		order = strtoul (stop, &stop, 10);
+		begin = strtoul (stop, &stop, 10);
+		end = strtoul (stop, &stop, 10);
+		// convert the configuration to the V2000 stereo value
+		char const *cfg = strstr (stop, "CFG=");
+		switch ((cfg)? atoi (cfg + 4): 0) {
+		case 1:
+			stereo = 1;
+			break;
+		case 2:
+			stereo = 4;
+			break;
+		case 3:
+			stereo = 6;
+			break;
+		default:
+			stereo = 0;
+			break;
+		}
 	} else {
-		char field[4], *end;
+		char field[4];
 		field[3] = 0;
+		if (strlen (buf) < 12)
+			return false;
 		// first atom
 		strncpy (field, buf, 3);
-		i = strtoul (field, &end, 10) - 1;
-		if (*end != 0) {
+		begin = strtoul (field, &stop, 10);
+		if (*stop != 0)
 			return false;
-		}
-		id = state->atoms[i]->GetProperty (GCU_PROP_FRAGMENT_ATOM_ID);
-		if (id.length () == 0)
-			id = state->atoms[i]->GetProperty (GCU_PROP_ID);
-		bond->SetProperty (GCU_PROP_BOND_BEGIN, id.c_str ());
-		// first atom
+		// second atom
 		strncpy (field, buf + 3, 3);
-		i = strtoul (field, &end, 10) - 1;
-		if (*end != 0) {
+		end = strtoul (field, &stop, 10);
+		if (*stop != 0)
 			return false;
-		}
-		id = state->atoms[i]->GetProperty (GCU_PROP_FRAGMENT_ATOM_ID);
-		if (id.length () == 0)
-			id = state->atoms[i]->GetProperty (GCU_PROP_ID);
-		bond->SetProperty (GCU_PROP_BOND_END, id.c_str ());
 		strncpy (field, buf + 6, 3);
-		bond->SetProperty (GCU_PROP_BOND_ORDER, field);
+		order = strtoul (field, &stop, 10);
 		strncpy (field, buf + 9, 3);
-		i = strtoul (field, &end, 10) - 1;
-		if (*end != 0) {
+		stereo = strtoul (field, &stop, 10);
+		if (*stop != 0)
 			return false;
-		}
-		switch (i) {
-		default:
-		case 0:
-			bond->SetProperty (GCU_PROP_BOND_TYPE, "normal");
-			break;
-		case 1:
-			bond->SetProperty (GCU_PROP_BOND_TYPE, "wedge");
-			break;
-		case 4:
-			bond->SetProperty (GCU_PROP_BOND_TYPE, "unkown");
-			break;
-		case 6:
-			bond->SetProperty (GCU_PROP_BOND_TYPE, "hash");
-			break;
-		}
+	}
+	if (begin == 0 || begin > state->na || end == 0 || end > state->na ||
+	    !state->atoms[begin - 1] || !state->atoms[end - 1])
+		return false;
+	double const *a = &state->coords[3 * (begin - 1)], *b = &state->coords[3 * (end - 1)];
+	state->length += sqrt ((b[0] - a[0]) * (b[0] - a[0]) + (b[1] - a[1]) * (b[1] - a[1]) + (b[2] - a[2]) * (b[2] - a[2]));
+	gcu::Object *bond = state->app->CreateObject ("bond", state->cur.top ());
+	ct_set_bond_atom (bond, GCU_PROP_BOND_BEGIN, state->atoms[begin - 1]);
+	ct_set_bond_atom (bond, GCU_PROP_BOND_END, state->atoms[end - 1]);
+	std::ostringstream res;
+	res << order;
+	bond->SetProperty (GCU_PROP_BOND_ORDER, res.str ().c_str ());
+	switch (stereo) {
+	default:
+	case 0:
+		bond->SetProperty (GCU_PROP_BOND_TYPE, "normal");
+		break;
+	case 1:
+		bond->SetProperty (GCU_PROP_BOND_TYPE, "wedge");
+		break;
+	case 4:
+		bond->SetProperty (GCU_PROP_BOND_TYPE, "unkown");
+		break;
+	case 6:
+		bond->SetProperty (GCU_PROP_BOND_TYPE, "hash");
+		break;
 	}
 	return true;
 }
 
-gcu::ContentType CTfilesLoader::Read  (G_GNUC_UNUSED gcu::Document *doc, G_GNUC_UNUSED GsfInput *in, G_GNUC_UNUSED char const *mime_type, G_GNUC_UNUSED GOIOContext *io)
+// a SDfile is recognized from its MIME type, or from its name when the MIME type is not given
+static bool IsSDfile (char const *mime_type, GsfInput *in)
+{
+	if (mime_type)
+		return !strcmp (mime_type, "chemical/x-mdl-sdfile");
+	char const *name = gsf_input_name (in), *ext = (name)? strrchr (name, '.'): NULL;
+	return ext && (!g_ascii_strcasecmp (ext, ".sdf") || !g_ascii_strcasecmp (ext, ".sd"));
+}
+
+gcu::ContentType CTfilesLoader::Read  (gcu::Document *doc, GsfInput *in, char const *mime_type, GOIOContext *io)
 {
 	CTReadState state;
-	state.input = reinterpret_cast <GsfInputTextline *> (gsf_input_textline_new (in));
+	gcu::SDReader input (in);
+	state.input = &input;
 	doc->SetScale (100.);
-	// read the first line
 	// initialize the state
 	state.doc = doc;
 	state.app = doc->GetApplication ();
 	state.context = io;
 	state.cur.push (doc);
 	state.v3000 = false;
+	state.first = true;
+	state.layout = false;
 	state.type = gcu::ContentTypeUnknown; // may be 2D
-	if (!ReadHeader (&state))
-		return gcu::ContentTypeUnknown;
-	switch (state.cttype) {
-	case MOLfile:
-	case RGfile:
-	case SDfile:
-		if (!ReadMolecule (&state))
-			return gcu::ContentTypeUnknown;
-		break;
-	case RXNfile:
-		break;
-	case RDfile:
-		break;
+	CTfileType filetype = (IsSDfile (mime_type, in))? SDfile: MOLfile;
+	// SDfiles and RDfiles are read one record at a time, so that only the
+	// current record is kept in memory, a molfile being a one record SDfile
+	while (input.Next ()) {
+		state.line = 0;
+		if (input.IsRDfile ())
+			state.cttype = RDfile;
+		else
+			state.cttype = filetype;
+		switch (input.GetType ()) {
+		case gcu::SD_RECORD_MOLECULE:
+			if (!ReadHeader (&state) || !ReadMolecule (&state))
+				return gcu::ContentTypeUnknown;
+			break;
+		case gcu::SD_RECORD_REACTION:
+			state.cttype = RXNfile;
+			if (!ReadReaction (&state))
+				return gcu::ContentTypeUnknown;
+			break;
+		default:
+			// RDfiles records might only have a registry number
+			break;
+		}
 	}
 	return state.type;
 }
@@ -467,32 +764,109 @@ bool CTfilesLoader::WriteObject (CTWriteState *state, gcu::Object const *object)
 					either in this code or in the cml schema */
 }
 
-bool CTfilesLoader::Write  (gcu::Object const *obj, GsfOutput *out, char const *, GOIOContext *ctxt, gcu::ContentType type)
+bool CTfilesLoader::WriteMolfile (CTWriteState *state, gcu::Object const *molecule)
 {
-	if (NULL != out) {
-		gcu::Document const *doc = dynamic_cast <gcu::Document const *> (obj);
-		CTWriteState state;
-		state.loader = this;
-		state.out = out;
-		state.io = ctxt;
-		state.type = type;
-		state.cur = 0;
-		if (!doc)
-			doc = obj->GetDocument ();
-		if (obj->GetType () == gcu::MoleculeType) {
-			gcu::Molecule const *mol = static_cast < gcu::Molecule const * > (obj);
-			// we don't use the three first lines at least for now
-			gsf_output_write (out, 3, reinterpret_cast < guint8 const * > ("\n\n\n"));
-			// only support V3000 on export
-			char buf[] = "  0  0  0     0  0           999 V3000\n";
-			gsf_output_write (out, strlen (buf), reinterpret_cast < guint8 const * > (buf));
-			WriteObject (&state, obj);
-			gsf_output_write (out, 6, reinterpret_cast < guint8 const * > ("M END\n"));
-		} else
+	// we don't use the title and comment lines at least for now
+	gsf_output_printf (state->out, "\n  GChemUtl          %s\n\n", (state->type == gcu::ContentType3D)? "3D": "2D");
+	// only support V3000 on export
+	char buf[] = "  0  0  0     0  0            999 V3000\n";
+	gsf_output_write (state->out, strlen (buf), reinterpret_cast < guint8 const * > (buf));
+	if (!WriteObject (state, molecule))
+		return false;
+	return gsf_output_write (state->out, 7, reinterpret_cast < guint8 const * > ("M  END\n"));
+}
+
+// collects the molecules, and the reactions if \a reactions is true, in which
+// case the reaction components are not collected as molecules
+static void ct_get_records (gcu::Object const *object, std::list < gcu::Object const * > &records, bool reactions)
+{
+	if (object->GetType () == gcu::MoleculeType || (reactions && object->GetType () == gcu::ReactionType)) {
+		records.push_back (object);
+		return;
+	}
+	std::map <std::string, gcu::Object *>::const_iterator i;
+	gcu::Object const *child = object->GetFirstChild (i);
+	while (child) {
+		ct_get_records (child, records, reactions);
+		child = object->GetNextChild (i);
+	}
+}
+
+bool CTfilesLoader::WriteRxnfile (CTWriteState *state, gcu::Object const *reaction)
+{
+	// the reactants are the steps no arrow ends to, and the products those no
+	// arrow starts from, so that a multistep reaction is written as a whole
+	std::set < std::string > starts, ends;
+	std::map <std::string, gcu::Object *>::const_iterator i;
+	gcu::Object const *child;
+	for (child = reaction->GetFirstChild (i); child; child = reaction->GetNextChild (i))
+		if (child->GetType () == gcu::ReactionArrowType) {
+			std::string id = child->GetProperty (GCU_PROP_ARROW_START_ID);
+			if (id.length ())
+				starts.insert (id);
+			id = child->GetProperty (GCU_PROP_ARROW_END_ID);
+			if (id.length ())
+				ends.insert (id);
+		}
+	std::list < gcu::Object const * > reactants, products;
+	std::set < std::string >::iterator j;
+	for (j = starts.begin (); j != starts.end (); j++)
+		if (ends.find (*j) == ends.end () && (child = reaction->GetChild ((*j).c_str ())))
+			ct_get_records (child, reactants, false);
+	for (j = ends.begin (); j != ends.end (); j++)
+		if (starts.find (*j) == starts.end () && (child = reaction->GetChild ((*j).c_str ())))
+			ct_get_records (child, products, false);
+	if (reactants.empty () && products.empty ())
+		return false;
+	gsf_output_printf (state->out, "$RXN\n\n  GChemUtl\n\n%3u%3u\n",
+	                   static_cast < unsigned > (reactants.size ()), static_cast < unsigned > (products.size ()));
+	reactants.splice (reactants.end (), products);
+	std::list < gcu::Object const * >::iterator k, end = reactants.end ();
+	for (k = reactants.begin (); k != end; ++k)
+		if (!gsf_output_write (state->out, 5, reinterpret_cast < guint8 const * > ("$MOL\n")) || !WriteMolfile (state, *k))
 			return false;
-		return true;
+	return true;
+}
+
+bool CTfilesLoader::Write  (gcu::Object const *obj, GsfOutput *out, char const *mime_type, GOIOContext *ctxt, gcu::ContentType type)
+{
+	if (NULL == out)
+		return false;
+	CTWriteState state;
+	state.loader = this;
+	state.out = out;
+	state.io = ctxt;
+	state.type = type;
+	state.cur = 0;
+	// only RXN files and RDfiles can store reactions
+	bool rxnfile = mime_type && !strcmp (mime_type, "chemical/x-mdl-rxnfile"),
+		 rdfile = mime_type && !strcmp (mime_type, "chemical/x-mdl-rdfile");
+	std::list < gcu::Object const * > records;
+	ct_get_records (obj, records, rxnfile || rdfile);
+	std::list < gcu::Object const * >::iterator i, end = records.end ();
+	if (rxnfile) {
+		// a RXN file can only store one reaction
+		for (i = records.begin (); i != end; ++i)
+			if ((*i)->GetType () == gcu::ReactionType)
+				return WriteRxnfile (&state, *i);
+		if (ctxt)
+			go_io_error_string (ctxt, _("There is no reaction to save"));
+		return false;
 	}
-	return false;
+	if (records.empty ())
+		return false;
+	if (!mime_type || !strcmp (mime_type, "chemical/x-mdl-molfile"))
+		// a molfile can only store one molecule
+		return WriteMolfile (&state, records.front ());
+	// SDfiles and RDfiles, each molecule or reaction is written as a new record
+	gcu::SDWriter writer (out, rdfile);
+	for (i = records.begin (); i != end; ++i) {
+		bool reaction = (*i)->GetType () == gcu::ReactionType;
+		if (!writer.BeginRecord ((reaction)? gcu::SD_RECORD_REACTION: gcu::SD_RECORD_MOLECULE) ||
+		    !((reaction)? WriteRxnfile (&state, *i): WriteMolfile (&state, *i)) || !writer.EndRecord ())
+			return false;
+	}
+	return true;
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -29,10 +29,12 @@
 #include <gcp/bond.h>
 #include <gcp/document.h>
 #include <gcp/molecule.h>
+#include <gcp/operation.h>
 #include <gcp/settings.h>
 #include <gcp/theme.h>
 #include <gcp/view.h>
 #include <gcu/element.h>
+#include <gcu/objprops.h>
 #include <gccv/text.h>
 #include <cmath>
 #include <cstring>
@@ -97,12 +99,12 @@ void gcpElementTool::OnRelease ()
 		if (m_pObject)
 		{
 			gcp ::Molecule* pMol = (gcp::Molecule*) m_pObject->GetMolecule ();
-			gcp::Operation* pOp = pDoc-> GetNewOperation (gcp::GCP_MODIFY_OPERATION);
-			Object *pObj = m_pObject->GetGroup ();
-			pOp->AddObject (pObj, 0);
 			Object* parent = m_pObject->GetParent ();
 			if (m_nState & GDK_CONTROL_MASK && (parent->GetType () == FragmentType)) {
 				//If m_pObject points to an atom inside a fragment, replace the whole fragment.
+				gcp::Operation* pOp = pDoc-> GetNewOperation (gcp::GCP_MODIFY_OPERATION);
+				Object *pObj = m_pObject->GetGroup ();
+				pOp->AddObject (pObj, 0);
 				gcp::Atom* pAtom = ((gcp::Fragment*) parent)->GetAtom ();
 				map < Bondable *, Bond * >::iterator i;
 				gcp::Bond *pBond = (gcp::Bond*) pAtom->GetFirstBond (i);
@@ -123,8 +125,20 @@ void gcpElementTool::OnRelease ()
 				pNewAtom->Update ();
 				m_pView->AddObject (pNewAtom);
 				delete parent;
+				pOp->AddObject (pObj, 1);
 			} else {
 				gcp::Atom* pAtom = static_cast <gcp::Atom *> (m_pObject);
+				gcp::Operation* pOp;
+				Object *pObj = NULL;
+				if (parent->GetType () == MoleculeType) {
+					// only the element changes, no need to save the whole molecule
+					pOp = pDoc-> GetNewOperation (gcp::GCP_PROPERTY_OPERATION);
+					static_cast < gcp::PropertyOperation * > (pOp)->AddProperty (pAtom, GCU_PROP_ATOM_Z);
+				} else {
+					pOp = pDoc-> GetNewOperation (gcp::GCP_MODIFY_OPERATION);
+					pObj = m_pObject->GetGroup ();
+					pOp->AddObject (pObj, 0);
+				}
 				pAtom->SetZ (CurZ);
 				m_pView->Update ((gcp::Atom*) m_pObject);
 				map < Bondable *, Bond * >::iterator i;
@@ -134,8 +148,9 @@ void gcpElementTool::OnRelease ()
 					m_pView->Update (pBond);
 					pBond = (gcp::Bond*) pAtom->GetNextBond (i);
 				}
+				if (pObj)
+					pOp->AddObject (pObj, 1);
 			}
-			pOp->AddObject (pObj, 1);
 		} else {
 			gcp::Atom* pAtom = new gcp::Atom (CurZ, m_x0 / m_dZoomFactor, m_y0 / m_dZoomFactor, 0);
 			gcp::Operation* pOp = pDoc-> GetNewOperation (gcp::GCP_ADD_OPERATION);
@@ -59,16 +59,9 @@ bool gcpLassoTool::OnClicked ()
 		// save the current coordinates
 		std::set < gcu::Object * >::iterator i, end = m_pData->SelectedObjects.end ();
 		gcp::Document *pDoc = m_pView->GetDoc ();
-		m_pOp = pDoc->GetNewOperation (gcp::GCP_MODIFY_OPERATION);
-		std::set <gcu::Object *> groups;
-		gcu::Object *group;
-		for (i = m_pData->SelectedObjects.begin (); i != end; i++) {
-			group = (*i)->GetGroup ();
-			groups.insert ((group)? group: *i);
-		}
-		std::set <gcu::Object *>::iterator j, jend = groups.end ();
-		for (j = groups.begin (); j != jend; j++)
-			m_pOp->AddObject (*j, 0);
+		m_pOp = pDoc->GetNewOperation (gcp::GCP_TRANSFORM_OPERATION);
+		for (i = m_pData->SelectedObjects.begin (); i != end; i++)
+			m_pOp->AddObject (*i);
 		if (m_Rotate) {
 			// Try to use the object coordinates
 			if (m_pObject && m_pObject->GetCoords (&m_cx, &m_cy)) {
@@ -218,6 +211,7 @@ void gcpLassoTool::OnDrag ()
 		// Translate the selection
 		std::set < gcu::Object * >::iterator i, end = m_pData->SelectedObjects.end ();
 		std::set < gcu::Object * > dirty;
+		static_cast < gcp::TransformOperation * > (m_pOp)->Translate ((m_x - m_x0) / m_dZoomFactor, (m_y - m_y0) / m_dZoomFactor);
 		for (i = m_pData->SelectedObjects.begin (); i != end; i++) {
 			(*i)->Move ((m_x - m_x0) / m_dZoomFactor, (m_y - m_y0) / m_dZoomFactor);
 			if ((*i)->GetParent ()->GetType () == gcu::MoleculeType) {
@@ -249,18 +243,11 @@ void gcpLassoTool::OnRelease ()
 		m_pData->SimplifySelection ();
 		AddSelection (m_pData);
 	} else {
-		std::set < gcu::Object * > groups;
-		std::set < gcu::Object * >::iterator j, jend;
 		std::set < gcu::Object * >::iterator i, end = m_pData->SelectedObjects.end ();
-		gcu::Object *group;
-		for (i = m_pData->SelectedObjects.begin (); i != end; i++) {
-			group = (*i)->GetGroup ();
-			groups.insert ((group)? group: *i);
+		for (i = m_pData->SelectedObjects.begin (); i != end; i++)
 			(*i)->EmitSignal (gcp::OnChangedSignal);
-		}
-		jend = groups.end ();
-		for (j = groups.begin (); j != jend; j++)
-			m_pOp->AddObject (*j, 1);
+		if (m_Rotate)
+			static_cast < gcp::TransformOperation * > (m_pOp)->SetRotation (m_dAngle, m_cx / m_dZoomFactor, m_cy / m_dZoomFactor);
 		m_pView->GetDoc ()->FinishOperation ();
 	}
 }
@@ -333,15 +320,13 @@ void gcpLassoTool::OnFlip (bool horizontal)
 	gcu::Matrix2D m (m_x, 0., 0., -m_x);
 	std::set < gcu::Object * >::iterator i, end = m_pData->SelectedObjects.end ();
 	gcp::Document* pDoc = m_pView->GetDoc ();
-	m_pOp = pDoc-> GetNewOperation (gcp::GCP_MODIFY_OPERATION);
+	m_pOp = pDoc-> GetNewOperation (gcp::GCP_TRANSFORM_OPERATION);
 	std::set <gcu::Object *> dirty;
 	for (i = m_pData->SelectedObjects.begin (); i != end; i++) {
 		gcu::Object *group = (*i)->GetGroup ();
+		m_pOp->AddObject (*i);
 		if (group) {
-			if (dirty.find (group) == dirty.end ()) {
-				m_pOp->AddObject (group, 0);
-				dirty.insert (group);
-			}
+			dirty.insert (group);
 			if ((*i)->GetType () == gcu::AtomType) {
 				gcp::Atom *atom = static_cast <gcp::Atom *> (*i);
 				std::map < gcu::Bondable *, gcu::Bond * >::const_iterator i;
@@ -351,21 +336,18 @@ void gcpLassoTool::OnFlip (bool horizontal)
 					bond = static_cast <gcp::Bond const *> (atom->GetNextBond (i));
 				}
 			}
-		} else
-			m_pOp->AddObject (*i, 0);
+		}
 		(*i)->Transform2D (m, m_cx / m_dZoomFactor, m_cy / m_dZoomFactor);
-		if (!group) {
+		if (!group)
 			m_pView->Update (*i);
-			m_pOp->AddObject (*i, 1);
-		}
 	}
 	std::set <gcu::Object *>::iterator j;
 	while (!dirty.empty ()) {
 		j = dirty.begin ();
-		m_pOp->AddObject (*j, 1);
 		m_pView->Update (*j);
 		dirty.erase (j);
 	}
+	static_cast < gcp::TransformOperation * > (m_pOp)->SetTransform (m_x, 0., 0., -m_x, m_cx / m_dZoomFactor, m_cy / m_dZoomFactor);
 	pDoc->FinishOperation ();
 }
 
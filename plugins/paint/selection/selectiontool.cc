@@ -118,9 +118,9 @@ bool gcpSelectionTool::OnClicked ()
 		if (m_x0 < 0) m_dAngleInit += 180.;
 		std::set < Object * >::iterator i, end = m_pData->SelectedObjects.end ();
 		gcp::Document* pDoc = m_pView->GetDoc ();
-		m_pOp = pDoc-> GetNewOperation (gcp::GCP_MODIFY_OPERATION);
+		m_pOp = pDoc-> GetNewOperation (gcp::GCP_TRANSFORM_OPERATION);
 		for (i = m_pData->SelectedObjects.begin (); i != end; i++)
-			m_pOp->AddObject (*i,0);
+			m_pOp->AddObject (*i);
 	}
 	return true;
 }
@@ -178,10 +178,9 @@ void gcpSelectionTool::OnRelease ()
 	m_pApp->ClearStatus ();
 	if (m_pObject) {
 		if (m_bRotate) {
-			std::set < Object * >::iterator i, end = m_pData->SelectedObjects.end ();
 			gcp::Document* pDoc = m_pView->GetDoc ();
-			for (i = m_pData->SelectedObjects.begin (); i != end; i++)
-				m_pOp->AddObject (*i,1);
+			double zoom = pDoc->GetTheme ()->GetZoomFactor ();
+			static_cast < gcp::TransformOperation * > (m_pOp)->SetRotation (m_dAngle, m_cx / zoom, m_cy / zoom);
 			pDoc->FinishOperation ();
 		} else {
 			double dx = m_x1 - m_x0, dy = m_y1 - m_y0;
@@ -308,13 +307,13 @@ void gcpSelectionTool::OnFlip (bool horizontal)
 	std::set < Object * >::iterator i, end = m_pData->SelectedObjects.end ();
 	gcp::Document* pDoc = m_pView->GetDoc ();
 	gcp::Theme *pTheme = pDoc->GetTheme ();
-	m_pOp = pDoc-> GetNewOperation (gcp::GCP_MODIFY_OPERATION);
+	m_pOp = pDoc-> GetNewOperation (gcp::GCP_TRANSFORM_OPERATION);
 	for (i = m_pData->SelectedObjects.begin (); i != end; i++) {
-		m_pOp->AddObject (*i,0);
+		m_pOp->AddObject (*i);
 		(*i)->Transform2D (m, m_cx / pTheme->GetZoomFactor (), m_cy / pTheme->GetZoomFactor ());
 		m_pView->Update (*i);
-		m_pOp->AddObject (*i,1);
 	}
+	static_cast < gcp::TransformOperation * > (m_pOp)->SetTransform (m_x, 0., 0., -m_x, m_cx / pTheme->GetZoomFactor (), m_cy / pTheme->GetZoomFactor ());
 	pDoc->FinishOperation ();
 }
 
@@ -0,0 +1,400 @@
+// -*- C++ -*-
+
+/*
+ * Gnome Chemistry Utils
+ * programs/spectra/batch.cc
+ *
+ * Copyright (C) 2026 Jean Bréfort <jean.brefort@normalesup.org>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301
+ * USA
+ */
+
+
+#include "config.h"
+#include <gcu/fid.h>
+#include <gcu/input.h>
+#include <gcu/jcamp.h>
+#include <gcu/spectrum.h>
+#include <goffice/goffice.h>
+#include <gsf/gsf-input-memory.h>
+#include <glib.h>
+#include <glib/gi18n.h>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+/*!\file
+A command line tool to process JCAMP-DX spectra without any user interface.
+Files are loaded in parallel, NMR FIDs are transformed and phased with the
+same gcu::FidProcessor as in gspectrum, abscissas and ordinates might be
+converted to other units, and integrals evaluated with the same baseline
+correction as in gspectrum. Results are written as CSV or JSON.
+*/
+
+typedef struct {
+	std::string path, title, type, xunit, yunit, error;
+	unsigned npoints;
+	double minx, maxx, miny, maxy, integral;
+	std::vector <double> ranges;
+} SpectrumResult;
+
+static int jobs = 0;
+static char *xunit = NULL, *yunit = NULL, *format = NULL, *output = NULL;
+static gboolean integrate = false;
+static char **range_strings = NULL;
+static std::vector <double> ranges;
+
+static gboolean cb_print_version (G_GNUC_UNUSED char const *option_name, G_GNUC_UNUSED char const *value, G_GNUC_UNUSED gpointer data, G_GNUC_UNUSED GError **error)
+{
+	char *version = g_strconcat (_("GSpectrum batch processor version: "), VERSION, NULL);
+	puts (version);
+	g_free (version);
+	exit (0);
+	return TRUE;
+}
+
+static GOptionEntry options[] =
+{
+	{ "version", 'v', G_OPTION_FLAG_NO_ARG, G_OPTION_ARG_CALLBACK, (void*) cb_print_version, N_("Prints the program version"), NULL },
+	{ "jobs", 'j', 0, G_OPTION_ARG_INT, &jobs, N_("Number of parallel threads, defaults to the number of processors"), "N" },
+	{ "x-unit", 'x', 0, G_OPTION_ARG_STRING, &xunit, N_("Converts abscissas to this unit (1/CM, NANOMETERS, MICROMETERS, HZ or PPM)"), "UNIT" },
+	{ "y-unit", 'y', 0, G_OPTION_ARG_STRING, &yunit, N_("Converts ordinates to this unit (ABSORBANCE or TRANSMITTANCE)"), "UNIT" },
+	{ "integrate", 'i', 0, G_OPTION_ARG_NONE, &integrate, N_("Evaluates the baseline corrected integral of each spectrum"), NULL },
+	{ "range", 'r', 0, G_OPTION_ARG_STRING_ARRAY, &range_strings, N_("Evaluates the integral between two abscissas, might be repeated"), "FROM:TO" },
+	{ "format", 'f', 0, G_OPTION_ARG_STRING, &format, N_("Output format: csv (default) or json"), "FORMAT" },
+	{ "output", 'o', 0, G_OPTION_ARG_FILENAME, &output, N_("Output file, defaults to the standard output"), "FILE" },
+	{ NULL, 0, 0, G_OPTION_ARG_NONE, NULL, NULL, NULL }
+};
+
+// linear interpolation of values at pos, abscissas being sorted in any order
+static double value_at (double const *x, double const *values, unsigned n, double pos)
+{
+	bool increasing = x[n - 1] > x[0];
+	unsigned low = 0, high = n - 1, mid;
+	if ((increasing && pos <= x[0]) || (!increasing && pos >= x[0]))
+		return values[0];
+	if ((increasing && pos >= x[n - 1]) || (!increasing && pos <= x[n - 1]))
+		return values[n - 1];
+	while (high - low > 1) {
+		mid = (low + high) / 2;
+		if ((x[mid] < pos) == increasing)
+			low = mid;
+		else
+			high = mid;
+	}
+	return values[low] + (values[high] - values[low]) * (pos - x[low]) / (x[high] - x[low]);
+}
+
+static void process_file (gpointer data, G_GNUC_UNUSED gpointer user_data)
+{
+	SpectrumResult *result = reinterpret_cast <SpectrumResult *> (data);
+	GError *error = NULL;
+	GsfInput *input = gsf_input_mmap_new (result->path.c_str (), &error);
+	if (!input) {
+		result->error = error->message;
+		g_error_free (error);
+		return;
+	}
+	gcu::JcampReader reader;
+	gsf_off_t size;
+	char const *contents = gcu::GetInputData (input, size);
+	bool loaded = contents && reader.Load (contents, size);
+	g_object_unref (input);
+	std::vector <double> &x = reader.GetX (), &y = reader.GetY ();
+	result->title = reader.GetLabel ("TITLE");
+	result->type = reader.GetLabel ("DATATYPE");
+	result->xunit = reader.GetUnit ('X');
+	result->yunit = reader.GetUnit ('Y');
+	std::vector <double> &re = reader.GetValues ('R'), &im = reader.GetValues ('I');
+	if (loaded && y.empty () && !re.empty ()) {
+		// NTUPLES with real and imaginary pages
+		result->yunit = reader.GetUnit ('R');
+		unsigned npoints = MIN (x.size (), MIN (re.size (), im.size ()));
+		if (result->type.find ("FID") != std::string::npos && npoints > 1) {
+			// transform and phase the FID as gspectrum does
+			gcu::FidProcessor fid;
+			fid.SetFID (&re[0], &im[0], npoints, (x[npoints - 1] - x[0]) / (npoints - 1));
+			fid.AutoPhase ();
+			unsigned n = fid.GetSize ();
+			x.resize (n);
+			fid.GetFrequencies (reader.GetNumber ("$OFFSET", 0.), &x[0]);
+			y.assign (fid.GetPhasedReal (), fid.GetPhasedReal () + n);
+			result->xunit = "HZ";
+		} else
+			y = re;
+	}
+	unsigned n = MIN (x.size (), y.size ());
+	if (!loaded || n < 2) {
+		result->error = _("No supported data table found");
+		return;
+	}
+	result->npoints = n;
+	double freq = reader.GetNumber (".OBSERVEFREQUENCY", go_nan);
+	if (xunit) {
+		if (!gcu::ConvertSpectrumUnit (result->xunit.c_str (), xunit, freq, &x[0], n)) {
+			result->error = _("Unsupported abscissa unit conversion");
+			return;
+		}
+		result->xunit = xunit;
+	}
+	if (yunit) {
+		if (!gcu::ConvertSpectrumUnit (result->yunit.c_str (), yunit, freq, &y[0], n)) {
+			result->error = _("Unsupported ordinate unit conversion");
+			return;
+		}
+		result->yunit = yunit;
+	}
+	go_range_min (&x[0], n, &result->minx);
+	go_range_max (&x[0], n, &result->maxx);
+	go_range_min (&y[0], n, &result->miny);
+	go_range_max (&y[0], n, &result->maxy);
+	if (integrate || ranges.size () > 0) {
+		std::vector <double> integral (n);
+		gcu::IntegrateSpectrum (&x[0], &y[0], n, &integral[0]);
+		result->integral = integral[n - 1] - integral[0];
+		for (unsigned i = 0; i < ranges.size (); i += 2)
+			result->ranges.push_back (fabs (value_at (&x[0], &integral[0], n, ranges[i + 1]) - value_at (&x[0], &integral[0], n, ranges[i])));
+	}
+}
+
+static bool is_jcamp_file (char const *name)
+{
+	char const *ext = strrchr (name, '.');
+	return ext && (!g_ascii_strcasecmp (ext, ".jdx") || !g_ascii_strcasecmp (ext, ".dx") ||
+	               !g_ascii_strcasecmp (ext, ".jcm") || !g_ascii_strcasecmp (ext, ".jcamp"));
+}
+
+static void add_path (char const *path, std::vector <SpectrumResult> &results, bool explicit_file)
+{
+	if (g_file_test (path, G_FILE_TEST_IS_DIR)) {
+		GDir *dir = g_dir_open (path, 0, NULL);
+		if (!dir)
+			return;
+		char const *name;
+		while ((name = g_dir_read_name (dir))) {
+			char *child = g_build_filename (path, name, NULL);
+			add_path (child, results, false);
+			g_free (child);
+		}
+		g_dir_close (dir);
+	} else if (explicit_file || is_jcamp_file (path)) {
+		SpectrumResult result;
+		result.path = path;
+		result.npoints = 0;
+		result.minx = result.maxx = result.miny = result.maxy = result.integral = go_nan;
+		results.push_back (result);
+	}
+}
+
+static void write_number (FILE *out, double value, bool json)
+{
+	char buf[G_ASCII_DTOSTR_BUF_SIZE];
+	if (go_finite (value))
+		fputs (g_ascii_formatd (buf, sizeof (buf), "%.10g", value), out);
+	else if (json)
+		fputs ("null", out);
+}
+
+static void write_string (FILE *out, std::string const &str, bool json)
+{
+	char const *s = str.c_str ();
+	fputc ('"', out);
+	for (; *s; s++) {
+		if (*s == '"')
+			fputs (json? "\\\"": "\"\"", out);
+		else if (json && *s == '\\')
+			fputs ("\\\\", out);
+		else if (json && static_cast <unsigned char> (*s) < 0x20)
+			fprintf (out, "\\u%04x", *s);
+		else
+			fputc (*s, out);
+	}
+	fputc ('"', out);
+}
+
+static void write_csv (FILE *out, std::vector <SpectrumResult> const &results)
+{
+	unsigned i, j;
+	fputs ("file,title,type,npoints,xunits,yunits,minx,maxx,miny,maxy", out);
+	if (integrate)
+		fputs (",integral", out);
+	for (j = 0; j < ranges.size (); j += 2)
+		fprintf (out, ",%s", range_strings[j / 2]);
+	fputs (",error\n", out);
+	for (i = 0; i < results.size (); i++) {
+		SpectrumResult const &r = results[i];
+		write_string (out, r.path, false);
+		fputc (',', out);
+		write_string (out, r.title, false);
+		fputc (',', out);
+		write_string (out, r.type, false);
+		fprintf (out, ",%u,", r.npoints);
+		write_string (out, r.xunit, false);
+		fputc (',', out);
+		write_string (out, r.yunit, false);
+		fputc (',', out);
+		write_number (out, r.minx, false);
+		fputc (',', out);
+		write_number (out, r.maxx, false);
+		fputc (',', out);
+		write_number (out, r.miny, false);
+		fputc (',', out);
+		write_number (out, r.maxy, false);
+		if (integrate) {
+			fputc (',', out);
+			write_number (out, r.integral, false);
+		}
+		for (j = 0; j < ranges.size () / 2; j++) {
+			fputc (',', out);
+			if (j < r.ranges.size ())
+				write_number (out, r.ranges[j], false);
+		}
+		fputc (',', out);
+		write_string (out, r.error, false);
+		fputc ('\n', out);
+	}
+}
+
+static void write_json (FILE *out, std::vector <SpectrumResult> const &results)
+{
+	unsigned i, j;
+	fputs ("[\n", out);
+	for (i = 0; i < results.size (); i++) {
+		SpectrumResult const &r = results[i];
+		fputs ("  {\"file\": ", out);
+		write_string (out, r.path, true);
+		if (r.error.length () > 0) {
+			fputs (", \"error\": ", out);
+			write_string (out, r.error, true);
+		} else {
+			fputs (", \"title\": ", out);
+			write_string (out, r.title, true);
+			fputs (", \"type\": ", out);
+			write_string (out, r.type, true);
+			fprintf (out, ", \"npoints\": %u, \"xunits\": ", r.npoints);
+			write_string (out, r.xunit, true);
+			fputs (", \"yunits\": ", out);
+			write_string (out, r.yunit, true);
+			fputs (", \"minx\": ", out);
+			write_number (out, r.minx, true);
+			fputs (", \"maxx\": ", out);
+			write_number (out, r.maxx, true);
+			fputs (", \"miny\": ", out);
+			write_number (out, r.miny, true);
+			fputs (", \"maxy\": ", out);
+			write_number (out, r.maxy, true);
+			if (integrate) {
+				fputs (", \"integral\": ", out);
+				write_number (out, r.integral, true);
+			}
+			if (r.ranges.size () > 0) {
+				fputs (", \"ranges\": [", out);
+				for (j = 0; j < r.ranges.size (); j++) {
+					if (j > 0)
+						fputs (", ", out);
+					fprintf (out, "{\"from\": ");
+					write_number (out, ranges[2 * j], true);
+					fputs (", \"to\": ", out);
+					write_number (out, ranges[2 * j + 1], true);
+					fputs (", \"integral\": ", out);
+					write_number (out, r.ranges[j], true);
+					fputc ('}', out);
+				}
+				fputc (']', out);
+			}
+		}
+		fputs ((i + 1 < results.size ())? "},\n": "}\n", out);
+	}
+	fputs ("]\n", out);
+}
+
+int main (int argc, char *argv[])
+{
+	GError *error = NULL;
+	GOptionContext *context;
+	unsigned i;
+
+	textdomain (GETTEXT_PACKAGE);
+	bindtextdomain (GETTEXT_PACKAGE, LOCALEDIR);
+	context = g_option_context_new (_(" file|directory..."));
+	g_option_context_add_main_entries (context, options, GETTEXT_PACKAGE);
+	g_option_context_set_help_enabled (context, TRUE);
+	g_option_context_parse (context, &argc, &argv, &error);
+	g_option_context_free (context);
+	if (error) {
+		puts (error->message);
+		g_error_free (error);
+		return -1;
+	}
+	bool json = false;
+	if (format) {
+		if (!strcmp (format, "json"))
+			json = true;
+		else if (strcmp (format, "csv")) {
+			printf (_("Unknown output format: %s\n"), format);
+			return -1;
+		}
+	}
+	if (range_strings)
+		for (i = 0; range_strings[i]; i++) {
+			char *end;
+			double from = g_ascii_strtod (range_strings[i], &end), to;
+			if (*end != ':' || (to = g_ascii_strtod (end + 1, &end), *end)) {
+				printf (_("Invalid range: %s\n"), range_strings[i]);
+				return -1;
+			}
+			ranges.push_back (from);
+			ranges.push_back (to);
+		}
+	if (argc < 2) {
+		printf (_("For usage see: %s [-?|--help]\n"), argv[0]);
+		return -1;
+	}
+
+	libgoffice_init ();
+	std::vector <SpectrumResult> results;
+	for (i = 1; i < static_cast <unsigned> (argc); i++)
+		add_path (argv[i], results, true);
+	if (jobs <= 0)
+		jobs = g_get_num_processors ();
+	GThreadPool *pool = g_thread_pool_new (process_file, NULL, jobs, true, NULL);
+	for (i = 0; i < results.size (); i++)
+		g_thread_pool_push (pool, &results[i], NULL);
+	// wait for all files to be processed
+	g_thread_pool_free (pool, false, true);
+
+	FILE *out = (output)? fopen (output, "w"): stdout;
+	if (!out) {
+		printf (_("Could not open %s\n"), output);
+		libgoffice_shutdown ();
+		return -1;
+	}
+	if (json)
+		write_json (out, results);
+	else
+		write_csv (out, results);
+	if (out != stdout)
+		fclose (out);
+	int ret = 0;
+	for (i = 0; i < results.size (); i++)
+		if (results[i].error.length () > 0)
+			ret = 1;
+	libgoffice_shutdown ();
+	return ret;
+}
@@ -0,0 +1,40 @@
+/*
+ * Gnome Chemisty Utils
+ * tests/check.h
+ *
+ * Copyright (C) 2026 Jean Bréfort <jean.brefort@normalesup.org>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301
+ * USA
+ */
+
+#ifndef GCU_TESTS_CHECK_H
+#define GCU_TESTS_CHECK_H
+
+#include <stdio.h>
+
+/*!\file
+The assertion shared by the self checking tests: when \a cond is false, the
+failed condition and its location are printed and the enclosing function
+returns 1, which makes the test fail when returned by main.
+*/
+
+#define CHECK(cond) \
+	if (!(cond)) { \
+		fprintf (stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #cond); \
+		return 1; \
+	}
+
+#endif	// GCU_TESTS_CHECK_H
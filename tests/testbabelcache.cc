@@ -0,0 +1,136 @@
+/*
+ * Gnome Chemisty Utils
+ * tests/testbabelcache.cc
+ *
+ * Copyright (C) 2026 Jean Bréfort <jean.brefort@normalesup.org>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301
+ * USA
+ */
+
+// the cache is only used by babelserver, build it in
+#include "../openbabel/cache.cc"
+#include "check.h"
+#include <cstdio>
+#include <cstdlib>
+#include <unistd.h>
+
+/*!\file
+Tests the babelserver cache of results: lookups, eviction of the least recently
+used entries, rejection of entries too large, and saving and loading a file.
+*/
+
+// each entry uses 128 bytes besides its strings, so that 8 of these fill 2 KiB
+#define ENTRY "0123456789abcdef0123456789abcdef0123456789abcdef0123456789ab"
+#define ENTRY_SIZE (4 + 2 * (sizeof (ENTRY) - 1) + 128)
+
+static bool has (BabelCache &cache, char const *key, char const *input)
+{
+	std::string result;
+	return cache.Lookup (key, input, strlen (input), result) && result == input;
+}
+
+static void add (BabelCache &cache, char const *key, char const *input)
+{
+	cache.Insert (key, input, strlen (input), input);
+}
+
+int main ()
+{
+	BabelCache cache (2048);
+	unsigned entries;
+	size_t size;
+	unsigned long hits, misses;
+	std::string result;
+	char key[8];
+	unsigned i;
+	// the options are part of the key
+	add (cache, "-smi", ENTRY);
+	CHECK (has (cache, "-smi", ENTRY));
+	CHECK (!cache.Lookup ("-can", ENTRY, strlen (ENTRY), result));
+	CHECK (!cache.Lookup ("-smi", ENTRY, strlen (ENTRY) - 1, result));
+	cache.GetStatus (entries, size, hits, misses);
+	CHECK (entries == 1 && size == ENTRY_SIZE && hits == 1 && misses == 2);
+	// a second insertion is ignored
+	cache.Insert ("-smi", ENTRY, strlen (ENTRY), "other");
+	CHECK (has (cache, "-smi", ENTRY));
+	cache.GetStatus (entries, size, hits, misses);
+	CHECK (entries == 1 && size == ENTRY_SIZE);
+
+	// fill the cache, then use the first entry so that the next one is evicted
+	for (i = 1; i < 8; i++) {
+		snprintf (key, sizeof (key), "-k%02u", i);
+		add (cache, key, ENTRY);
+	}
+	cache.GetStatus (entries, size, hits, misses);
+	CHECK (entries == 8 && size == 8 * ENTRY_SIZE);
+	CHECK (has (cache, "-smi", ENTRY));
+	add (cache, "-new", ENTRY);
+	cache.GetStatus (entries, size, hits, misses);
+	CHECK (entries == 8 && size <= 2048);
+	CHECK (!has (cache, "-k01", ENTRY));
+	CHECK (has (cache, "-smi", ENTRY));
+	CHECK (has (cache, "-k02", ENTRY));
+	CHECK (has (cache, "-new", ENTRY));
+
+	// an entry larger than an eighth of the cache is not kept
+	std::string large (2048 / 8, 'x');
+	cache.Insert ("-big", large.c_str (), large.length (), large);
+	CHECK (!cache.Lookup ("-big", large.c_str (), large.length (), result));
+	cache.GetStatus (entries, size, hits, misses);
+	CHECK (entries == 8);
+
+	// save and load in a larger cache, the order of use is kept
+	char filename[] = "/tmp/gcu-test-cache-XXXXXX";
+	int fd = mkstemp (filename);
+	CHECK (fd >= 0);
+	close (fd);
+	CHECK (cache.Save (filename));
+	BabelCache loaded (4096);
+	CHECK (loaded.Load (filename));
+	loaded.GetStatus (entries, size, hits, misses);
+	CHECK (entries == 8 && size == 8 * ENTRY_SIZE && hits == 0 && misses == 0);
+	for (i = 2; i < 8; i++) {
+		snprintf (key, sizeof (key), "-k%02u", i);
+		CHECK (has (loaded, key, ENTRY));
+	}
+	CHECK (has (loaded, "-new", ENTRY));
+	CHECK (has (loaded, "-smi", ENTRY));
+	// a smaller cache keeps the most recently used entries
+	for (i = 10; i < 18; i++) {
+		snprintf (key, sizeof (key), "-k%02u", i);
+		add (loaded, key, ENTRY);
+	}
+	CHECK (loaded.Save (filename));
+	BabelCache small (2048);
+	CHECK (small.Load (filename));
+	small.GetStatus (entries, size, hits, misses);
+	CHECK (entries == 8);
+	CHECK (has (small, "-k10", ENTRY));
+	CHECK (has (small, "-k17", ENTRY));
+	CHECK (!has (small, "-smi", ENTRY));
+
+	// a file from another version is ignored
+	FILE *f = fopen (filename, "wb");
+	CHECK (f != NULL);
+	fputs ("GCU babelserver cache 0\n", f);
+	fclose (f);
+	BabelCache other (2048);
+	CHECK (!other.Load (filename));
+	other.GetStatus (entries, size, hits, misses);
+	CHECK (entries == 0);
+	unlink (filename);
+	return 0;
+}
@@ -20,76 +20,546 @@
  * USA
  */
 
+#ifndef _GNU_SOURCE
+#	define _GNU_SOURCE // for SO_PEERCRED
+#endif
 #include "config.h"
+#include "check.h"
 #include <glib.h>
-#include <netinet/in.h>
+#include <errno.h>
+#include <poll.h>
+#include <signal.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
 #include <sys/stat.h>
 #include <sys/un.h>
+#include <sys/wait.h>
 #include <unistd.h>
 
-int main ()
+/*!\file
+Starts a private babelserver, with its own socket, and drives it through the
+protocol used by gcu::BabelClient: one shot requests, requests pipelined on a
+persistent connection with "--id", the answers coming back in the order the
+conversions end, inputs passed as file descriptors with "--fd", and answers
+sent by chunks with "--stream". A second server checks the cache of results,
+its status counters and its persistence across restarts.
+*/
+
+#define TIMEOUT 30000 // in ms, so that a broken server can't hang the test
+
+static char const *methane = "5\n\nC       0       0       0\nH       0       1.093   0\nH       1.030490282     -0.364333333    0\nH       -0.515245141    -0.364333333    0.892430763\nH       -0.515245141    -0.364333333    -0.892430763\n";
+static char socket_path[sizeof (((struct sockaddr_un *) NULL)->sun_path)];
+
+// the server socket name is built from the USER variable, use a private one
+static int start_server (char const *const *options)
+{
+	char *args[16];
+	unsigned i = 0;
+	args[i++] = (char *) BABELSERVER;
+	while (*options && i < 15)
+		args[i++] = (char *) *options++;
+	args[i] = NULL;
+	GError *error = NULL;
+	int status;
+	/* the spawned process exits once the server is listening */
+	g_spawn_sync (NULL, args, NULL, 0, NULL, NULL, NULL, NULL, &status, &error);
+	if (error) {
+		fprintf (stderr, "could not start %s: %s\n", BABELSERVER, error->message);
+		g_error_free (error);
+		return -1;
+	}
+	return (WIFEXITED (status) && WEXITSTATUS (status) == 0)? 0: -1;
+}
+
+static int connect_server (void)
 {
-	struct stat statbuf;
-	char inbuf[256], *start = NULL;
-	int index, cur, length;
-	char *usr = getenv ("USER");
-	char *path = malloc (strlen ("/tmp/babelsocket-") + strlen (usr) + 1);
-	strcpy (path, "/tmp/babelsocket-");
-	strcat (path, usr);
-	if (strlen (path) >= 107) { //WARNING: don't know if this is portable
-		puts ("path too long");
+	int fd = socket (AF_UNIX, SOCK_STREAM, 0);
+	if (fd == -1)
+		return -1;
+	struct sockaddr_un address;
+	memset (&address, 0, sizeof (address));
+	address.sun_family = AF_UNIX;
+	strcpy (address.sun_path, socket_path);
+	if (connect (fd, (struct sockaddr const *) &address, sizeof (address)) == -1) {
+		close (fd);
 		return -1;
 	}
-	if (stat (path, &statbuf)) {
-		char *args[] = {LIBEXECDIR"/babelserver", NULL};
-		GError *error = NULL;
-		g_spawn_async (NULL, (char **) args, NULL, 0, NULL, NULL, NULL, &error);
-		if (error) {
-			g_error_free (error);
-			error = NULL;
-			free (path);
+	return fd;
+}
+
+// stops the server, which then saves its cache if it has a file
+static int stop_server (void)
+{
+	int fd = connect_server ();
+	if (fd < 0)
+		return -1;
+	struct ucred cred;
+	socklen_t length = sizeof (cred);
+	int res = getsockopt (fd, SOL_SOCKET, SO_PEERCRED, &cred, &length);
+	close (fd);
+	if (res < 0 || kill (cred.pid, SIGTERM) < 0)
+		return -1;
+	// wait until it is gone
+	unsigned i;
+	for (i = 0; i < TIMEOUT / 10 && kill (cred.pid, 0) == 0; i++)
+		g_usleep (10000);
+	unlink (socket_path);
+	return (i < TIMEOUT / 10)? 0: -1;
+}
+
+static int send_all (int fd, char const *data, size_t size)
+{
+	while (size > 0) {
+		ssize_t n = write (fd, data, size);
+		if (n < 0) {
+			if (errno == EINTR)
+				continue;
 			return -1;
 		}
-		while (stat (path, &statbuf));
+		data += n;
+		size -= n;
 	}
-	int babelsocket = socket (AF_UNIX, SOCK_STREAM, 0);
-	if (babelsocket == -1) {
-		perror ("Could not create the socket");
-		free (path);
-		return -1;
+	return 0;
+}
+
+// sends the options, then the data with its length
+static int send_request (int fd, char const *options, char const *data)
+{
+	char *request = g_strdup_printf ("%s-l %u -D", options, (unsigned) strlen (data));
+	int res = send_all (fd, request, strlen (request));
+	g_free (request);
+	return (res < 0)? res: send_all (fd, data, strlen (data));
+}
+
+// sends the options, and the input file descriptor with them
+static int send_fd_request (int fd, char const *options, int input)
+{
+	struct iovec iov;
+	iov.iov_base = (void *) options;
+	iov.iov_len = strlen (options);
+	char control[CMSG_SPACE (sizeof (int))];
+	memset (control, 0, sizeof (control));
+	struct msghdr msg;
+	memset (&msg, 0, sizeof (msg));
+	msg.msg_iov = &iov;
+	msg.msg_iovlen = 1;
+	msg.msg_control = control;
+	msg.msg_controllen = sizeof (control);
+	struct cmsghdr *cmsg = CMSG_FIRSTHDR (&msg);
+	cmsg->cmsg_level = SOL_SOCKET;
+	cmsg->cmsg_type = SCM_RIGHTS;
+	cmsg->cmsg_len = CMSG_LEN (sizeof (int));
+	memcpy (CMSG_DATA (cmsg), &input, sizeof (int));
+	return (sendmsg (fd, &msg, 0) == (ssize_t) iov.iov_len)? 0: -1;
+}
+
+// reads exactly size bytes, returns 0 on success, 1 if the connection was closed first
+static int read_all (int fd, char *buf, size_t size)
+{
+	while (size > 0) {
+		struct pollfd pfd;
+		pfd.fd = fd;
+		pfd.events = POLLIN;
+		if (poll (&pfd, 1, TIMEOUT) <= 0)
+			return -1;
+		ssize_t n = read (fd, buf, size);
+		if (n < 0 && errno == EINTR)
+			continue;
+		// the connection is reset if the server closed it without reading everything
+		if (n < 0)
+			return (errno == ECONNRESET)? 1: -1;
+		if (n == 0)
+			return 1;
+		buf += n;
+		size -= n;
 	}
-	struct sockaddr_un adr_serv;
-	adr_serv.sun_family = AF_UNIX;
-	strcpy (adr_serv.sun_path, path);
-	free (path);
-	if (connect (babelsocket, (const struct sockaddr*) &adr_serv, sizeof (struct sockaddr_un)) == -1) {
-		perror ("Connexion failed");
-		return -1;
+	return 0;
+}
+
+// reads a space terminated word
+static int read_word (int fd, char *word, size_t max)
+{
+	size_t i;
+	for (i = 0; i < max - 1; i++) {
+		int res = read_all (fd, word + i, 1);
+		if (res)
+			return res;
+		if (word[i] == ' ')
+			break;
 	}
-	char const *buf = "-i xyz -o inchi ";
-	write (babelsocket, buf, strlen (buf));
-	buf = "5\n\nC       0       0       0\nH       0       1.093   0\nH       1.030490282     -0.364333333    0\nH       -0.515245141    -0.364333333    0.892430763\nH       -0.515245141    -0.364333333    -0.892430763";
-	char *size = g_strdup_printf ("-l %u -D", strlen (buf));
-	write (babelsocket, size, strlen (size));
-	write (babelsocket, buf, strlen (buf));
-	while (1) {
-		if ((cur = read (babelsocket, inbuf + index, 255 - index))) {
-			index += cur;
-			inbuf[index] = 0;
-			if (start == NULL) {
-				if ((start = strchr (inbuf, ' '))) {
-					length = strtol (inbuf, NULL, 10);
-					start++;
-				}
-			}
-			if (index - (start - inbuf) == length) {
-				printf ("answer is: %s\n", start);
-				break;
-			}
+	word[i] = 0;
+	return (i < max - 1)? 0: -1;
+}
+
+/* reads an "<id> <length> <data>" answer, or a legacy "<length> <data>" one
+ if id is NULL; the answer is null terminated */
+static char *read_answer (int fd, char *id, size_t *length)
+{
+	char word[32];
+	if ((id && read_word (fd, id, 32)) || read_word (fd, word, 32))
+		return NULL;
+	*length = strtoul (word, NULL, 10);
+	char *answer = g_malloc (*length + 1);
+	if (read_all (fd, answer, *length)) {
+		g_free (answer);
+		return NULL;
+	}
+	answer[*length] = 0;
+	return answer;
+}
+
+// the server closes the connection once everything has been answered
+static gboolean is_closed (int fd)
+{
+	char c;
+	return read_all (fd, &c, 1) == 1;
+}
+
+static gboolean is_methane (char const *smiles)
+{
+	return smiles && smiles[0] == 'C' && (smiles[1] == 0 || g_ascii_isspace (smiles[1]));
+}
+
+static int test_one_shot (void)
+{
+	int fd = connect_server ();
+	CHECK (fd >= 0);
+	CHECK (send_request (fd, "-i xyz -o smi ", methane) == 0);
+	size_t length;
+	char *answer = read_answer (fd, NULL, &length);
+	CHECK (is_methane (answer));
+	g_free (answer);
+	CHECK (is_closed (fd));
+	close (fd);
+	return 0;
+}
+
+static int test_pipelining (void)
+{
+	int fd = connect_server ();
+	CHECK (fd >= 0);
+	/* the first input comes from a pipe which stays empty until the second
+	 answer has been read, so the answers must come back in the reverse order */
+	int input[2];
+	CHECK (pipe (input) == 0);
+	CHECK (send_fd_request (fd, "--id first --fd -i xyz -o smi -D", input[0]) == 0);
+	close (input[0]);
+	// several requests written at once
+	char *requests = g_strdup_printf ("--id second -i xyz -o smi -l %u -D%s--id third -i xyz -o can -l %u -D%s",
+	                                  (unsigned) strlen (methane), methane, (unsigned) strlen (methane), methane);
+	CHECK (send_all (fd, requests, strlen (requests)) == 0);
+	g_free (requests);
+	char id[32], *answer;
+	size_t length;
+	gboolean second = FALSE, third = FALSE;
+	unsigned i;
+	for (i = 0; i < 2; i++) {
+		answer = read_answer (fd, id, &length);
+		CHECK (is_methane (answer));
+		g_free (answer);
+		if (!strcmp (id, "second"))
+			second = TRUE;
+		else if (!strcmp (id, "third"))
+			third = TRUE;
+	}
+	CHECK (second && third);
+	CHECK (send_all (input[1], methane, strlen (methane)) == 0);
+	close (input[1]);
+	answer = read_answer (fd, id, &length);
+	CHECK (!strcmp (id, "first") && is_methane (answer));
+	g_free (answer);
+	// an invalid format is an error, the connection is closed
+	CHECK (send_request (fd, "--id bad -i nonexistent -o smi ", methane) == 0);
+	CHECK (is_closed (fd));
+	close (fd);
+	return 0;
+}
+
+// the input is an anonymous file, as BabelClient does for large inputs
+static int test_fd (void)
+{
+	int input;
+#ifdef MFD_CLOEXEC
+	input = memfd_create ("testbabelserver", MFD_CLOEXEC);
+#else
+	input = -1;
+#endif
+	FILE *tmp = NULL;
+	if (input < 0) {
+		tmp = tmpfile ();
+		CHECK (tmp != NULL);
+		input = fileno (tmp);
+	}
+	CHECK (send_all (input, methane, strlen (methane)) == 0);
+	// the server reads from the current position
+	CHECK (lseek (input, 0, SEEK_SET) == 0);
+	int fd = connect_server ();
+	CHECK (fd >= 0);
+	CHECK (send_fd_request (fd, "--id 1 --fd -i xyz -o smi -D", input) == 0);
+	if (tmp)
+		fclose (tmp);
+	else
+		close (input);
+	char id[32];
+	size_t length;
+	char *answer = read_answer (fd, id, &length);
+	CHECK (!strcmp (id, "1") && is_methane (answer));
+	g_free (answer);
+	// a request using --fd without a file descriptor is an error
+	char const *request = "--id 2 --fd -i xyz -o smi -D";
+	CHECK (send_all (fd, request, strlen (request)) == 0);
+	CHECK (is_closed (fd));
+	close (fd);
+	return 0;
+}
+
+// streamed answers are chunks of at most 64 KiB ended by an empty one
+static int test_stream (void)
+{
+	unsigned i, nb = 400, chunks = 0;
+	GString *input = g_string_new (NULL);
+	for (i = 0; i < nb; i++)
+		g_string_append (input, methane);
+	int fd = connect_server ();
+	CHECK (fd >= 0);
+	CHECK (send_request (fd, "--id whole -i xyz -o cml ", input->str) == 0);
+	CHECK (send_request (fd, "--id 0 --stream -i xyz -o cml ", input->str) == 0);
+	char id[32], *answer, *whole = NULL;
+	size_t length, whole_length = 0;
+	GString *streamed = g_string_new (NULL);
+	gboolean ended = FALSE;
+	while (!ended) {
+		answer = read_answer (fd, id, &length);
+		CHECK (answer != NULL);
+		if (!strcmp (id, "whole")) {
+			whole = answer;
+			whole_length = length;
+			continue;
 		}
+		CHECK (!strcmp (id, "0") && length <= 0x10000);
+		if (length > 0) {
+			g_string_append_len (streamed, answer, length);
+			chunks++;
+		} else
+			ended = TRUE;
+		g_free (answer);
+	}
+	if (!whole)
+		whole = read_answer (fd, id, &whole_length);
+	CHECK (whole != NULL && whole_length > 0);
+	CHECK (streamed->len == whole_length && !memcmp (streamed->str, whole, whole_length));
+	CHECK (chunks == (whole_length + 0xffff) / 0x10000);
+	g_free (whole);
+	g_string_free (streamed, TRUE);
+	g_string_free (input, TRUE);
+	close (fd);
+	return 0;
+}
+
+// empty and one byte inline data don't stall the connection
+static int test_short_data (void)
+{
+	int fd = connect_server ();
+	CHECK (fd >= 0);
+	char const *requests = "--id empty -i xyz -o smi -l 0 -D--id byte -i xyz -o smi -l 1 -DC";
+	CHECK (send_all (fd, requests, strlen (requests)) == 0);
+	CHECK (send_request (fd, "--id methane -i xyz -o smi ", methane) == 0);
+	char id[32], *answer;
+	size_t length;
+	unsigned i, found = 0;
+	for (i = 0; i < 3; i++) {
+		answer = read_answer (fd, id, &length);
+		CHECK (answer != NULL);
+		if (!strcmp (id, "methane")) {
+			CHECK (is_methane (answer));
+			found |= 1;
+		} else if (!strcmp (id, "empty")) {
+			CHECK (length == 0);
+			found |= 2;
+		} else if (!strcmp (id, "byte"))
+			found |= 4;
+		g_free (answer);
+	}
+	CHECK (found == 7);
+	close (fd);
+	return 0;
+}
+
+// reads the value of a "name=value" field of a status answer
+static long status_value (char const *status, char const *name)
+{
+	size_t length = strlen (name);
+	char const *cur = status;
+	while ((cur = strstr (cur, name))) {
+		if ((cur == status || cur[-1] == ' ') && cur[length] == '=')
+			return strtol (cur + length + 1, NULL, 10);
+		cur += length;
+	}
+	return -1;
+}
+
+static char *get_status (int fd)
+{
+	char const *request = "--id status --status ";
+	if (send_all (fd, request, strlen (request)))
+		return NULL;
+	char id[32];
+	size_t length;
+	char *answer = read_answer (fd, id, &length);
+	if (answer && strcmp (id, "status")) {
+		g_free (answer);
+		return NULL;
 	}
-	close (babelsocket);
+	return answer;
+}
+
+/* the same request twice and a failing one twice: only the second
+ identical request is a hit, failures are not kept */
+static int test_cache (char const *filename)
+{
+	int fd = connect_server ();
+	CHECK (fd >= 0);
+	char id[32], *answer, *first = NULL;
+	size_t length;
+	unsigned i;
+	for (i = 0; i < 2; i++) {
+		CHECK (send_request (fd, "--id cached -i xyz -o cml ", methane) == 0);
+		answer = read_answer (fd, id, &length);
+		CHECK (answer != NULL && !strcmp (id, "cached") && length > 0);
+		if (first) {
+			CHECK (!strcmp (answer, first));
+			g_free (answer);
+		} else
+			first = answer;
+		CHECK (send_request (fd, "--id failed -i xyz -o cml ", "") == 0);
+		answer = read_answer (fd, id, &length);
+		CHECK (answer != NULL && !strcmp (id, "failed") && length == 0);
+		g_free (answer);
+	}
+	answer = get_status (fd);
+	CHECK (answer != NULL);
+	CHECK (status_value (answer, "workers") == 2);
+	CHECK (status_value (answer, "max_queued") == 8);
+	CHECK (status_value (answer, "running") == 0);
+	CHECK (status_value (answer, "queued") == 0);
+	CHECK (status_value (answer, "cache_entries") == 1);
+	CHECK (status_value (answer, "cache_size") > 0);
+	CHECK (status_value (answer, "cache_hits") == 1);
+	CHECK (status_value (answer, "cache_misses") == 3);
+	g_free (answer);
+	close (fd);
+
+	// the cache is saved when the server stops, and loaded by the next one
+	CHECK (stop_server () == 0);
+	CHECK (g_file_test (filename, G_FILE_TEST_IS_REGULAR));
+	char const *options[] = {"-w", "2", "-c", "4", "-p", filename, NULL};
+	CHECK (start_server (options) == 0);
+	fd = connect_server ();
+	CHECK (fd >= 0);
+	CHECK (send_request (fd, "--id cached -i xyz -o cml ", methane) == 0);
+	answer = read_answer (fd, id, &length);
+	CHECK (answer != NULL && !strcmp (answer, first));
+	g_free (answer);
+	g_free (first);
+	answer = get_status (fd);
+	CHECK (answer != NULL);
+	CHECK (status_value (answer, "cache_entries") == 1);
+	CHECK (status_value (answer, "cache_hits") == 1);
+	CHECK (status_value (answer, "cache_misses") == 0);
+	g_free (answer);
+	close (fd);
 	return 0;
 }
+
+/* a cached streamed answer comes by chunks of at most 64 KiB too, the entry
+ being small enough to be kept but its result larger than one chunk */
+static int test_cached_stream (void)
+{
+	unsigned i, nb = 400, chunks;
+	GString *input = g_string_new (NULL), *streamed[2];
+	for (i = 0; i < nb; i++)
+		g_string_append (input, methane);
+	int fd = connect_server ();
+	CHECK (fd >= 0);
+	char id[32], *answer = get_status (fd);
+	CHECK (answer != NULL);
+	long hits = status_value (answer, "cache_hits");
+	g_free (answer);
+	size_t length;
+	for (i = 0; i < 2; i++) {
+		CHECK (send_request (fd, "--id 0 --stream -i xyz -o cml ", input->str) == 0);
+		streamed[i] = g_string_new (NULL);
+		chunks = 0;
+		do {
+			answer = read_answer (fd, id, &length);
+			CHECK (answer != NULL && !strcmp (id, "0") && length <= 0x10000);
+			g_string_append_len (streamed[i], answer, length);
+			g_free (answer);
+			chunks++;
+		} while (length > 0);
+		CHECK (streamed[i]->len > 0x10000);
+		CHECK (chunks == (streamed[i]->len + 0xffff) / 0x10000 + 1);
+	}
+	CHECK (streamed[0]->len == streamed[1]->len && !memcmp (streamed[0]->str, streamed[1]->str, streamed[0]->len));
+	answer = get_status (fd);
+	CHECK (answer != NULL);
+	CHECK (status_value (answer, "cache_hits") == hits + 1);
+	g_free (answer);
+	for (i = 0; i < 2; i++)
+		g_string_free (streamed[i], TRUE);
+	g_string_free (input, TRUE);
+	close (fd);
+	return 0;
+}
+
+int main ()
+{
+	char *usr = g_strdup_printf ("gcu-test-%u", (unsigned) getpid ());
+	g_setenv ("USER", usr, TRUE);
+	snprintf (socket_path, sizeof (socket_path), "/tmp/babelsocket-%s", usr);
+	g_free (usr);
+	// two workers are needed to get answers out of order
+	char const *options[] = {"-w", "2", "-c", "0", NULL};
+	if (start_server (options)) {
+		fprintf (stderr, "could not start the server, skipping\n");
+		return 77;
+	}
+	int res = test_one_shot ();
+	if (!res)
+		res = test_pipelining ();
+	if (!res)
+		res = test_fd ();
+	if (!res)
+		res = test_stream ();
+	if (!res)
+		res = test_short_data ();
+	if (stop_server ())
+		res = 1;
+	if (res)
+		return res;
+
+	/* a small cache saved in a private directory, each entry being limited
+	 to an eighth of its size */
+	char *dir = g_dir_make_tmp ("gcu-test-XXXXXX", NULL);
+	if (!dir)
+		return 1;
+	char *filename = g_build_filename (dir, "cache", NULL);
+	char const *cache_options[] = {"-w", "2", "-c", "4", "-p", filename, NULL};
+	if (start_server (cache_options))
+		res = 1;
+	else {
+		res = test_cache (filename);
+		if (!res)
+			res = test_cached_stream ();
+		if (stop_server ())
+			res = 1;
+	}
+	unlink (filename);
+	rmdir (dir);
+	g_free (filename);
+	g_free (dir);
+	return res;
+}
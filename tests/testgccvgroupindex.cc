@@ -0,0 +1,251 @@
+/*
+ * Gnome Chemisty Utils
+ * tests/testgccvgroupindex.cc
+ *
+ * Copyright (C) 2026 Jean Bréfort <jean.brefort@normalesup.org>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301
+ * USA
+ */
+
+#include "config.h"
+#include "check.h"
+#include <gccv/group-index.h>
+#include <gccv/item.h>
+#include <glib.h>
+#include <cmath>
+#include <cstdio>
+#include <list>
+#include <vector>
+
+/*!\file
+Compares the nearest child and the children overlapping a region found by
+gccv::GroupIndex with those found by scanning the children in display order,
+as gccv::Group does without an index. Random rectangles are used, some of them
+sharing the same bounds so that distances are equal, and the children are
+added, removed, restacked and moved between the checks, so that the index is
+used both with children out of the tree and after rebuilding it.
+*/
+
+#define ITEMS 300
+#define ROUNDS 12
+#define CHANGES 40	// more than the children kept out of the tree
+#define POINTS 200
+#define REGIONS 50
+#define SIZE 1000.
+
+// a rectangle without a canvas
+class Rect: public gccv::Item
+{
+public:
+	Rect (double x0, double y0, double x1, double y1);
+	~Rect ();
+
+	void Set (double x0, double y0, double x1, double y1);
+	double Distance (double x, double y, gccv::Item **item) const;
+
+protected:
+	void UpdateBounds ();
+
+private:
+	double m_X0, m_Y0, m_X1, m_Y1;
+};
+
+Rect::Rect (double x0, double y0, double x1, double y1):
+	gccv::Item (static_cast < gccv::Group * > (NULL))
+{
+	Set (x0, y0, x1, y1);
+}
+
+Rect::~Rect ()
+{
+	// there is no canvas to invalidate
+	BoundsChanged ();
+}
+
+void Rect::Set (double x0, double y0, double x1, double y1)
+{
+	m_X0 = x0;
+	m_Y0 = y0;
+	m_X1 = x1;
+	m_Y1 = y1;
+	BoundsChanged ();
+}
+
+double Rect::Distance (double x, double y, gccv::Item **item) const
+{
+	double dx = MAX (MAX (m_X0 - x, x - m_X1), 0.),
+	       dy = MAX (MAX (m_Y0 - y, y - m_Y1), 0.);
+	if (item)
+		*item = const_cast < Rect * > (this);
+	return sqrt (dx * dx + dy * dy);
+}
+
+void Rect::UpdateBounds ()
+{
+	m_x0 = m_X0;
+	m_y0 = m_Y0;
+	m_x1 = m_X1;
+	m_y1 = m_Y1;
+	Item::UpdateBounds ();
+}
+
+static GRand *rnd;
+
+// one rectangle out of eight gets the bounds of an existing one
+static void random_bounds (std::list < gccv::Item * > const &children, double *bounds)
+{
+	if (!children.empty () && g_rand_int_range (rnd, 0, 8) == 0) {
+		std::list < gccv::Item * >::const_iterator i = children.begin ();
+		for (int n = g_rand_int_range (rnd, 0, children.size ()); n > 0; n--)
+			i++;
+		(*i)->GetBounds (bounds[0], bounds[1], bounds[2], bounds[3]);
+		return;
+	}
+	bounds[0] = g_rand_double_range (rnd, 0., SIZE);
+	bounds[1] = g_rand_double_range (rnd, 0., SIZE);
+	bounds[2] = bounds[0] + g_rand_double_range (rnd, 1., 30.);
+	bounds[3] = bounds[1] + g_rand_double_range (rnd, 1., 30.);
+}
+
+static gccv::Item *random_child (std::list < gccv::Item * > const &children)
+{
+	std::list < gccv::Item * >::const_iterator i = children.begin ();
+	for (int n = g_rand_int_range (rnd, 0, children.size ()); n > 0; n--)
+		i++;
+	return *i;
+}
+
+// the first child displayed wins on equal distances
+static double linear_distance (std::list < gccv::Item * > const &children, double x, double y, gccv::Item **item)
+{
+	double d = G_MAXDOUBLE, di;
+	gccv::Item *cur;
+	*item = NULL;
+	std::list < gccv::Item * >::const_iterator i, end = children.end ();
+	for (i = children.begin (); i != end; i++) {
+		cur = NULL;
+		di = (*i)->Distance (x, y, &cur);
+		if (di < d) {
+			d = di;
+			*item = cur? cur: *i;
+		}
+	}
+	return d;
+}
+
+static void linear_items (std::list < gccv::Item * > const &children, double x0, double y0, double x1, double y1, std::vector < gccv::Item * > &items)
+{
+	double x, y, x_, y_;
+	items.clear ();
+	std::list < gccv::Item * >::const_iterator i, end = children.end ();
+	for (i = children.begin (); i != end; i++) {
+		(*i)->GetBounds (x, y, x_, y_);
+		if (x <= x1 && x_ >= x0 && y <= y1 && y_ >= y0)
+			items.push_back (*i);
+	}
+}
+
+static int check_index (gccv::GroupIndex &index, std::list < gccv::Item * > const &children)
+{
+	int i;
+	double x, y, w, h;
+	gccv::Item *found, *expected;
+	std::vector < gccv::Item * > items, expected_items;
+	for (i = 0; i < POINTS; i++) {
+		// some points inside a child, where identical children are at the same distance
+		if (i % 4 == 0) {
+			random_child (children)->GetBounds (x, y, w, h);
+			x = (x + w) / 2.;
+			y = (y + h) / 2.;
+		} else {
+			x = g_rand_double_range (rnd, -50., SIZE + 50.);
+			y = g_rand_double_range (rnd, -50., SIZE + 50.);
+		}
+		CHECK (index.Distance (x, y, &found) == linear_distance (children, x, y, &expected));
+		CHECK (found == expected);
+	}
+	for (i = 0; i < REGIONS; i++) {
+		x = g_rand_double_range (rnd, 0., SIZE);
+		y = g_rand_double_range (rnd, 0., SIZE);
+		w = g_rand_double_range (rnd, 0., SIZE / 4.);
+		h = g_rand_double_range (rnd, 0., SIZE / 4.);
+		index.GetItems (x, y, x + w, y + h, items);
+		linear_items (children, x, y, x + w, y + h, expected_items);
+		CHECK (items == expected_items);
+	}
+	return 0;
+}
+
+int main ()
+{
+	rnd = g_rand_new_with_seed (1);
+	std::list < gccv::Item * > children;
+	double bounds[4];
+	int i, round;
+	for (i = 0; i < ITEMS; i++) {
+		random_bounds (children, bounds);
+		children.push_back (new Rect (bounds[0], bounds[1], bounds[2], bounds[3]));
+	}
+	gccv::GroupIndex index (children);
+	CHECK (check_index (index, children) == 0);
+
+	for (round = 0; round < ROUNDS; round++) {
+		for (i = 0; i < CHANGES; i++) {
+			gccv::Item *item = random_child (children);
+			bool front = g_rand_boolean (rnd);
+			switch (g_rand_int_range (rnd, 0, 4)) {
+			case 0:
+				random_bounds (children, bounds);
+				item = new Rect (bounds[0], bounds[1], bounds[2], bounds[3]);
+				if (front)
+					children.push_front (item);
+				else
+					children.push_back (item);
+				index.AddItem (item, front);
+				break;
+			case 1:
+				if (children.size () < ITEMS / 2)
+					break;
+				children.remove (item);
+				index.RemoveItem (item);
+				delete item;
+				break;
+			case 2:
+				children.remove (item);
+				if (front)
+					children.push_front (item);
+				else
+					children.push_back (item);
+				index.Restack (item, front);
+				break;
+			default:
+				random_bounds (children, bounds);
+				static_cast < Rect * > (item)->Set (bounds[0], bounds[1], bounds[2], bounds[3]);
+				index.ItemChanged (item);
+				break;
+			}
+		}
+		if (check_index (index, children))
+			return 1;
+	}
+
+	while (!children.empty ()) {
+		delete children.front ();
+		children.pop_front ();
+	}
+	g_rand_free (rnd);
+	return 0;
+}
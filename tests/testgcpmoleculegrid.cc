@@ -0,0 +1,177 @@
+/*
+ * Gnome Chemisty Utils
+ * tests/testgcpmoleculegrid.cc
+ *
+ * Copyright (C) 2026 Jean Bréfort <jean.brefort@normalesup.org>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301
+ * USA
+ */
+
+#include "config.h"
+#include "check.h"
+#include <gcp/atom.h>
+#include <gcp/bond.h>
+#include <gcp/molecule.h>
+#include <gcp/molecule-grid.h>
+#include <gcu/document.h>
+#include <gcu/objprops.h>
+#include <cstdio>
+#include <vector>
+
+/*!\file
+Tests the queries of gcp::MoleculeGrid, and that gcp::Molecule keeps its grid
+current when atoms are moved or bonds removed.
+*/
+
+// the cells size, and the size used by gcp::Molecule outside of a gcp::Document
+#define SIZE 140.
+// the tolerance used by gcp::Molecule::GetAtomAt()
+#define TOLERANCE 10.
+
+static int test_grid ()
+{
+	gcp::MoleculeGrid grid (SIZE);
+	std::vector < gcp::Bond * > bonds;
+	gcp::Atom *a0 = new gcp::Atom (6, 0., 0., 0.), *a1 = new gcp::Atom (6, SIZE, 0., 0.),
+		*a2 = new gcp::Atom (6, 2. * SIZE, 0., 0.), *a3 = new gcp::Atom (6, 10. * SIZE, 0., 0.),
+		*a4 = new gcp::Atom (6, 11. * SIZE, 0., 0.), *a5 = new gcp::Atom (6, SIZE + 10., 3., 0.),
+		*a6 = new gcp::Atom (6, SIZE + 10., SIZE + 3., 0.), *a7 = new gcp::Atom (6, 0., 1000., 0.),
+		*a8 = new gcp::Atom (6, 20000., 1000., 0.), *p0 = new gcp::Atom (6, 10.5 * SIZE, -SIZE / 2., 0.),
+		*p1 = new gcp::Atom (6, 10.5 * SIZE, SIZE / 2., 0.);
+	gcp::Bond *b01 = new gcp::Bond (a0, a1, 1), *b12 = new gcp::Bond (a1, a2, 1),
+		*b34 = new gcp::Bond (a3, a4, 1), *b56 = new gcp::Bond (a5, a6, 1),
+		*b78 = new gcp::Bond (a7, a8, 1), *probe = new gcp::Bond (p0, p1, 1);
+	grid.AddBond (b01);
+	grid.AddBond (b12);
+	grid.AddBond (b34);
+	grid.AddBond (b56);
+	// too long to be indexed
+	grid.AddBond (b78);
+
+	// atoms are found within the tolerance, the nearest one first
+	CHECK (grid.GetAtomAt (1., 1., TOLERANCE) == a0);
+	CHECK (grid.GetAtomAt (SIZE - 1., 2., TOLERANCE) == a1);
+	CHECK (grid.GetAtomAt (SIZE + 6., 2., TOLERANCE) == a5);
+	CHECK (grid.GetAtomAt (SIZE / 2., 0., TOLERANCE) == NULL);
+	CHECK (grid.GetAtomAt (10. * SIZE + 20., 0., TOLERANCE) == NULL);
+	CHECK (grid.GetAtomAt (11. * SIZE - 5., -5., TOLERANCE) == a4);
+	// the atoms of bonds which are not indexed are still found
+	CHECK (grid.GetAtomAt (20000., 1001., TOLERANCE) == a8);
+
+	// bonds sharing a cell, plus the unindexed ones, in the order they were added
+	grid.GetBonds (b12, bonds);
+	CHECK (bonds.size () == 3 && bonds[0] == b01 && bonds[1] == b56 && bonds[2] == b78);
+	// a bond which is not in the grid can be used too
+	grid.GetBonds (probe, bonds);
+	CHECK (bonds.size () == 2 && bonds[0] == b34 && bonds[1] == b78);
+	// an unindexed bond might cross any other one
+	grid.GetBonds (b78, bonds);
+	CHECK (bonds.size () == 4 && bonds[0] == b01 && bonds[3] == b56);
+
+	// a0 goes away with its only bond, a1 is still used by b12
+	grid.RemoveBond (b01);
+	CHECK (grid.GetAtomAt (0., 0., TOLERANCE) == NULL);
+	CHECK (grid.GetAtomAt (SIZE, 0., TOLERANCE) == a1);
+	grid.GetBonds (b12, bonds);
+	CHECK (bonds.size () == 2 && bonds[0] == b56 && bonds[1] == b78);
+
+	// moved atoms are found at their new position, and their bonds follow
+	a3->SetCoords (20. * SIZE, 0.);
+	a4->SetCoords (21. * SIZE, 0.);
+	grid.MoveAtom (a3);
+	grid.MoveAtom (a4);
+	CHECK (grid.GetAtomAt (11. * SIZE, 0., TOLERANCE) == NULL);
+	CHECK (grid.GetAtomAt (21. * SIZE, 0., TOLERANCE) == a4);
+	grid.GetBonds (probe, bonds);
+	CHECK (bonds.size () == 1 && bonds[0] == b78);
+	// b12 now spans the cells from a2 to a1
+	a1->SetCoords (20.5 * SIZE, 1.);
+	grid.MoveAtom (a1);
+	grid.GetBonds (probe, bonds);
+	CHECK (bonds.size () == 2 && bonds[0] == b12 && bonds[1] == b78);
+	grid.GetBonds (b34, bonds);
+	CHECK (bonds.size () == 2 && bonds[0] == b12 && bonds[1] == b78);
+
+	delete b01;
+	delete b12;
+	delete b34;
+	delete b56;
+	delete b78;
+	delete probe;
+	delete a0;
+	delete a1;
+	delete a2;
+	delete a3;
+	delete a4;
+	delete a5;
+	delete a6;
+	delete a7;
+	delete a8;
+	delete p0;
+	delete p1;
+	return 0;
+}
+
+static int test_molecule ()
+{
+	gcu::Document *doc = new gcu::Document (NULL);
+	gcp::Molecule *mol = new gcp::Molecule ();
+	doc->AddChild (mol);
+	gcp::Atom *a0 = new gcp::Atom (6, 0., 0., 0.), *a1 = new gcp::Atom (6, SIZE, 0., 0.),
+		*a2 = new gcp::Atom (6, 2. * SIZE, 0., 0.);
+	mol->AddChild (a0);
+	mol->AddChild (a1);
+	mol->AddChild (a2);
+	gcp::Bond *b01 = new gcp::Bond (a0, a1, 1), *b12 = new gcp::Bond (a1, a2, 1);
+	mol->AddChild (b01);
+	mol->AddChild (b12);
+	CHECK (mol->GetAtomAt (SIZE + 5., 5.) == a1);
+
+	// Move () and SetCoords () update the grid
+	a2->Move (10. * SIZE, 0.);
+	CHECK (mol->GetAtomAt (2. * SIZE, 0.) == NULL);
+	CHECK (mol->GetAtomAt (12. * SIZE, 0.) == a2);
+	a1->SetCoords (5. * SIZE, 5. * SIZE);
+	CHECK (mol->GetAtomAt (SIZE, 0.) == NULL);
+	CHECK (mol->GetAtomAt (5. * SIZE, 5. * SIZE) == a1);
+	// and so does GCU_PROP_POS2D, the document scale being 1, loaders set it
+	// through gcu::Object
+	gcu::Object *obj = a1;
+	obj->SetProperty (GCU_PROP_POS2D, "700 -700");
+	CHECK (mol->GetAtomAt (5. * SIZE, 5. * SIZE) == NULL);
+	CHECK (mol->GetAtomAt (700., -700.) == a1);
+	obj->SetProperty (GCU_PROP_X, "-1400");
+	CHECK (mol->GetAtomAt (700., -700.) == NULL);
+	CHECK (mol->GetAtomAt (-1400., -700.) == a1);
+
+	// a removed bond is no longer in the grid
+	a1->RemoveBond (b12);
+	a2->RemoveBond (b12);
+	mol->Remove (b12);
+	CHECK (mol->GetBondsNumber () == 1);
+	CHECK (mol->GetAtomAt (12. * SIZE, 0.) == NULL);
+	CHECK (mol->GetAtomAt (0., 0.) == a0);
+	delete b12;
+	delete doc;
+	return 0;
+}
+
+int main ()
+{
+	if (test_grid () || test_molecule ())
+		return 1;
+	return 0;
+}
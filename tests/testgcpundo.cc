@@ -0,0 +1,228 @@
+/*
+ * Gnome Chemisty Utils
+ * tests/testgcpundo.cc
+ *
+ * Copyright (C) 2026 Jean Bréfort <jean.brefort@normalesup.org>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301
+ * USA
+ */
+
+#include "config.h"
+#include "check.h"
+#include <gcp/atom.h>
+#include <gcp/bond.h>
+#include <gcp/document.h>
+#include <gcp/molecule.h>
+#include <gcp/operation.h>
+#include <gcu/matrix2d.h>
+#include <gcu/objprops.h>
+#include <cstdio>
+#include <string>
+
+/*!\file
+Tests that undoing and redoing the gcp::Operation classes which do not use xml
+restore the document exactly: transforms, property changes, and atoms and bonds
+additions and deletions. Operations are undone and redone directly, since
+gcp::Document::OnUndo() needs an application.
+*/
+
+#define NATOMS 4
+
+static gcp::Atom *add_atom (gcp::Document *doc, int Z, double x, double y)
+{
+	gcp::Atom *atom = new gcp::Atom (Z, x, y, 0.);
+	doc->AddAtom (atom);
+	return atom;
+}
+
+static gcp::Bond *add_bond (gcp::Document *doc, gcp::Atom *begin, gcp::Atom *end, unsigned char order)
+{
+	gcp::Bond *bond = new gcp::Bond (begin, end, order);
+	doc->AddBond (bond);
+	return bond;
+}
+
+// a chain with coordinates which are not exactly representable after a rotation
+static void build_chain (gcp::Document *doc, gcp::Atom **atoms)
+{
+	atoms[0] = add_atom (doc, 6, 10.1, 20.3);
+	atoms[1] = add_atom (doc, 6, 131.7, 89.9);
+	atoms[2] = add_atom (doc, 8, 253.3, 20.7);
+	atoms[3] = add_atom (doc, 7, 374.9, 90.1);
+	for (unsigned i = 1; i < NATOMS; i++)
+		add_bond (doc, atoms[i - 1], atoms[i], 1);
+}
+
+static int test_transform (gcp::Document *doc)
+{
+	gcp::Atom *atoms[NATOMS];
+	double x0[NATOMS], y0[NATOMS], x1[NATOMS], y1[NATOMS], x, y;
+	unsigned i, n;
+	build_chain (doc, atoms);
+	gcp::Molecule *mol = static_cast < gcp::Molecule * > (atoms[0]->GetMolecule ());
+	CHECK (mol != NULL && atoms[NATOMS - 1]->GetMolecule () == mol);
+	for (i = 0; i < NATOMS; i++)
+		atoms[i]->GetCoords (x0 + i, y0 + i);
+
+	// rotate and move the molecule as the selection tool does
+	gcp::TransformOperation *op = new gcp::TransformOperation (doc, 1);
+	op->AddObject (mol);
+	gcu::Matrix2D m (33.);
+	mol->Transform2D (m, 17.5, 42.25);
+	op->SetRotation (33., 17.5, 42.25);
+	mol->Move (7.1, -3.3);
+	op->Translate (7.1, -3.3);
+	for (i = 0; i < NATOMS; i++) {
+		atoms[i]->GetCoords (x1 + i, y1 + i);
+		CHECK (x1[i] != x0[i] || y1[i] != y0[i]);
+	}
+
+	// positions must not drift, however many times the operation is undone
+	for (n = 0; n < 100; n++) {
+		op->Undo ();
+		for (i = 0; i < NATOMS; i++) {
+			atoms[i]->GetCoords (&x, &y);
+			CHECK (x == x0[i] && y == y0[i]);
+		}
+		op->Redo ();
+		for (i = 0; i < NATOMS; i++) {
+			atoms[i]->GetCoords (&x, &y);
+			CHECK (x == x1[i] && y == y1[i]);
+		}
+	}
+	// the molecule spatial index follows
+	op->Undo ();
+	CHECK (mol->GetAtomAt (x0[2], y0[2]) == atoms[2]);
+	op->Redo ();
+	CHECK (mol->GetAtomAt (x1[2], y1[2]) == atoms[2]);
+	CHECK (op->GetSize () > 0);
+	delete op;
+	return 0;
+}
+
+static int test_property (gcp::Document *doc)
+{
+	gcp::Atom *atoms[NATOMS];
+	build_chain (doc, atoms);
+	gcp::Bond *bond = static_cast < gcp::Bond * > (atoms[0]->GetBond (atoms[1]));
+	CHECK (bond != NULL);
+
+	// the element is changed twice, the undo must restore the first value
+	gcp::PropertyOperation *op = new gcp::PropertyOperation (doc, 2);
+	op->AddProperty (atoms[0], GCU_PROP_ATOM_Z);
+	atoms[0]->SetZ (7);
+	op->AddProperty (atoms[0], GCU_PROP_ATOM_Z);
+	op->AddProperty (atoms[0], GCU_PROP_ATOM_CHARGE);
+	atoms[0]->SetZ (8);
+	atoms[0]->SetCharge (1);
+	op->AddProperty (bond, GCU_PROP_BOND_ORDER);
+	bond->SetOrder (2);
+
+	for (unsigned n = 0; n < 3; n++) {
+		op->Undo ();
+		CHECK (atoms[0]->GetZ () == 6);
+		CHECK (atoms[0]->GetCharge () == 0);
+		CHECK (bond->GetOrder () == 1);
+		op->Redo ();
+		CHECK (atoms[0]->GetZ () == 8);
+		CHECK (atoms[0]->GetCharge () == 1);
+		CHECK (bond->GetOrder () == 2);
+	}
+	delete op;
+	return 0;
+}
+
+static int test_add_delete (gcp::Document *doc)
+{
+	double x, y;
+	// a new atom, as added by the element tool
+	gcp::Atom *atom = new gcp::Atom (8, 12.345678901, -3.25, 0.);
+	doc->AddAtom (atom);
+	atom->SetCharge (-1);
+	std::string id = atom->GetId (), mol_id = atom->GetParent ()->GetId ();
+	gcp::AddOperation *add = new gcp::AddOperation (doc, 3);
+	add->AddObject (atom);
+	for (unsigned n = 0; n < 3; n++) {
+		add->Undo ();
+		CHECK (doc->GetDescendant (id.c_str ()) == NULL);
+		CHECK (doc->GetDescendant (mol_id.c_str ()) == NULL);
+		add->Redo ();
+		atom = dynamic_cast < gcp::Atom * > (doc->GetDescendant (id.c_str ()));
+		CHECK (atom != NULL);
+		CHECK (mol_id == atom->GetParent ()->GetId ());
+		CHECK (atom->GetZ () == 8 && atom->GetCharge () == -1);
+		atom->GetCoords (&x, &y);
+		CHECK (x == 12.345678901 && y == -3.25);
+	}
+	delete add;
+
+	// a deleted bond joins its atoms again
+	gcp::Atom *atoms[NATOMS];
+	build_chain (doc, atoms);
+	gcp::Bond *bond = static_cast < gcp::Bond * > (atoms[1]->GetBond (atoms[2]));
+	bond->SetOrder (2);
+	bond->SetType (gcp::UpBondType);
+	std::string bond_id = bond->GetId ();
+	gcp::DeleteOperation *del = new gcp::DeleteOperation (doc, 4);
+	del->AddObject (bond);
+	doc->Remove (bond);
+	CHECK (atoms[1]->GetBond (atoms[2]) == NULL);
+	CHECK (atoms[1]->GetMolecule () != atoms[2]->GetMolecule ());
+	for (unsigned n = 0; n < 3; n++) {
+		del->Undo ();
+		bond = static_cast < gcp::Bond * > (atoms[1]->GetBond (atoms[2]));
+		CHECK (bond != NULL && bond_id == bond->GetId ());
+		CHECK (bond->GetAtom (0) == atoms[1] && bond->GetAtom (1) == atoms[2]);
+		CHECK (bond->GetOrder () == 2 && bond->GetType () == gcp::UpBondType);
+		CHECK (atoms[0]->GetMolecule () == atoms[NATOMS - 1]->GetMolecule ());
+		del->Redo ();
+		CHECK (atoms[1]->GetBond (atoms[2]) == NULL);
+		CHECK (doc->GetDescendant (bond_id.c_str ()) == NULL);
+	}
+	delete del;
+
+	// a deleted atom, the document records its bonds in the current operation
+	gcp::Operation *op = doc->GetNewOperation (gcp::GCP_DELETE_OPERATION);
+	id = atoms[2]->GetId ();
+	std::string next_bond = atoms[2]->GetBond (atoms[3])->GetId ();
+	op->AddObject (atoms[2]);
+	doc->Remove (atoms[2]);
+	doc->FinishOperation ();
+	CHECK (doc->GetDescendant (id.c_str ()) == NULL);
+	CHECK (doc->GetDescendant (next_bond.c_str ()) == NULL);
+	for (unsigned n = 0; n < 3; n++) {
+		op->Undo ();
+		atom = dynamic_cast < gcp::Atom * > (doc->GetDescendant (id.c_str ()));
+		CHECK (atom != NULL && atom->GetZ () == 8);
+		atom->GetCoords (&x, &y);
+		CHECK (x == 253.3 && y == 20.7);
+		CHECK (atom->GetBond (atoms[3]) != NULL && next_bond == atom->GetBond (atoms[3])->GetId ());
+		CHECK (atom->GetMolecule () == atoms[3]->GetMolecule ());
+		op->Redo ();
+		CHECK (doc->GetDescendant (id.c_str ()) == NULL);
+		CHECK (atoms[3]->GetBondsNumber () == 0);
+	}
+	// the document owns the finished operation
+	return 0;
+}
+
+int main ()
+{
+	gcp::Document *doc = new gcp::Document (NULL, true);
+	int res = test_transform (doc) || test_property (doc) || test_add_delete (doc);
+	delete doc;
+	return res;
+}
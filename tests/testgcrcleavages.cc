@@ -0,0 +1,280 @@
+// -*- C++ -*-
+
+/*
+ * Gnome Chemistry Utils
+ * tests/testgcrcleavages.cc
+ *
+ * Copyright (C) 2026 Jean Bréfort <jean.brefort@normalesup.org>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301
+ * USA
+ */
+
+#include "config.h"
+#include "check.h"
+#include <gcr/cleavage.h>
+#include <gcr/document.h>
+#include <gcu/chemistry.h>
+#include <glib.h>
+#include <libxml/parser.h>
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+/*!ile
+Tests the cleavages evaluation in gcr::Document::Update. The nickel crystal is
+grown to a few cells, with its cell edges, and the atoms and lines cleaved are
+compared with those found by the algorithm used before the scalar products
+were sorted, which inserted each product in a sorted list. Known planes are
+checked too: the counts of remaining atoms and lines, and the highest
+remaining positions.
+
+With --bench, times the update of a large crystal instead.
+*/
+
+#define SIZE 4
+#define THREADED_SIZE 10	// more than 4096 atoms, so that cleavages use threads
+
+// gives access to the images
+class TestDocument: public gcr::Document
+{
+public:
+	TestDocument (): gcr::Document (NULL) {}
+
+	gcr::AtomImages const &GetAtoms () const {return Atoms;}
+	gcr::LineImages const &GetLines () const {return Lines;}
+};
+
+static void add_cleavage (gcr::Document *doc, int h, int k, int l, unsigned planes)
+{
+	gcr::Cleavage *cleavage = new gcr::Cleavage ();
+	cleavage->h () = h;
+	cleavage->k () = k;
+	cleavage->l () = l;
+	cleavage->Planes () = planes;
+	doc->GetCleavageList ()->push_back (cleavage);
+}
+
+static void clear_cleavages (gcr::Document *doc)
+{
+	gcr::CleavageList *cleavages = doc->GetCleavageList ();
+	while (!cleavages->empty ()) {
+		delete cleavages->front ();
+		cleavages->pop_front ();
+	}
+}
+
+static TestDocument *load (char const *filename)
+{
+	xmlDocPtr xml = xmlParseFile (filename);
+	if (!xml || !xml->children) {
+		fprintf (stderr, "could not load %s\n", filename);
+		return NULL;
+	}
+	xmlNodePtr node, next;
+	// views need a window, drop them
+	for (node = xml->children->children; node; node = next) {
+		next = node->next;
+		if (!strcmp ((char const *) node->name, "view")) {
+			xmlUnlinkNode (node);
+			xmlFreeNode (node);
+		}
+	}
+	TestDocument *doc = new TestDocument ();
+	doc->ParseXMLTree (xml->children);
+	xmlFreeDoc (xml);
+	return doc;
+}
+
+/* the algorithm used before: the distinct scalar products are inserted in a
+ decreasing list, and everything above the last removed plane is cleaved;
+ a line is cleaved if one of its ends is */
+static void old_cleave (TestDocument const *doc, int h, int k, int l, unsigned planes,
+                        std::vector <unsigned char> &atoms_cleaved, std::vector <unsigned char> &lines_cleaved)
+{
+	gcr::AtomImages const &atoms = doc->GetAtoms ();
+	gcr::LineImages const &lines = doc->GetLines ();
+	unsigned i, na = atoms.GetCount (), nl = lines.GetCount ();
+	std::vector <double> products;
+	std::vector <double>::iterator m;
+	double x;
+	for (i = 0; i < na; i++) {
+		x = atoms.x[i] * h + atoms.y[i] * k + atoms.z[i] * l;
+		for (m = products.begin (); m != products.end () && *m > x + PREC; m++) ;
+		if (m == products.end () || fabs (*m - x) > PREC)
+			products.insert (m, x);
+	}
+	if (planes >= products.size ()) {
+		atoms_cleaved.assign (na, 1);
+		lines_cleaved.assign (nl, 1);
+		return;
+	}
+	x = products[planes - 1];
+	for (i = 0; i < na; i++)
+		if (x < atoms.x[i] * h + atoms.y[i] * k + atoms.z[i] * l + PREC)
+			atoms_cleaved[i] = 1;
+	for (i = 0; i < nl; i++)
+		if (x < std::max (lines.x1[i] * h + lines.y1[i] * k + lines.z1[i] * l,
+		                  lines.x2[i] * h + lines.y2[i] * k + lines.z2[i] * l) + PREC)
+			lines_cleaved[i] = 1;
+}
+
+static unsigned count_remaining (std::vector <unsigned char> const &cleaved)
+{
+	unsigned i, n = 0;
+	for (i = 0; i < cleaved.size (); i++)
+		if (!cleaved[i])
+			n++;
+	return n;
+}
+
+// the highest scalar product of the atoms which are not cleaved
+static double highest_remaining (TestDocument const *doc, int h, int k, int l)
+{
+	gcr::AtomImages const &atoms = doc->GetAtoms ();
+	double x, max = -G_MAXDOUBLE;
+	for (unsigned i = 0; i < atoms.GetCount (); i++)
+		if (!atoms.cleaved[i]) {
+			x = atoms.x[i] * h + atoms.y[i] * k + atoms.z[i] * l;
+			if (x > max)
+				max = x;
+		}
+	return max;
+}
+
+/* updates doc with its cleavages, and compares the cleaved flags with those of
+ the old algorithm */
+static int check_update (TestDocument *doc)
+{
+	doc->Update ();
+	gcr::AtomImages const &atoms = doc->GetAtoms ();
+	gcr::LineImages const &lines = doc->GetLines ();
+	std::vector <unsigned char> atoms_cleaved (atoms.GetCount (), 0), lines_cleaved (lines.GetCount (), 0);
+	gcr::CleavageList *cleavages = doc->GetCleavageList ();
+	gcr::CleavageList::iterator k;
+	for (k = cleavages->begin (); k != cleavages->end (); k++)
+		old_cleave (doc, (*k)->h (), (*k)->k (), (*k)->l (), (*k)->Planes (), atoms_cleaved, lines_cleaved);
+	CHECK (atoms.cleaved == atoms_cleaved);
+	CHECK (lines.cleaved == lines_cleaved);
+	return 0;
+}
+
+static int test_cleavages (char const *filename)
+{
+	TestDocument *doc = load (filename);
+	CHECK (doc != NULL);
+	// all the edges of the cells
+	doc->GetLineList ()->push_back (new gcr::Line (gcr::edges, 0., 0., 0., 0., 0., 0., 10., 0.f, 0.f, 0.f, 1.f));
+	doc->SetSize (0., SIZE, 0., SIZE, 0., SIZE);
+
+	// the corners and the centers of the faces of the cells, and their edges
+	CHECK (check_update (doc) == 0);
+	unsigned n = SIZE + 1, na = n * n * n + 3 * SIZE * SIZE * n, nl = 3 * SIZE * n * n;
+	CHECK (doc->GetAtoms ().GetCount () == na);
+	CHECK (doc->GetLines ().GetCount () == nl);
+	CHECK (count_remaining (doc->GetAtoms ().cleaved) == na);
+	CHECK (count_remaining (doc->GetLines ().cleaved) == nl);
+
+	// the x = SIZE face: corners and face centers, and the edges touching it
+	add_cleavage (doc, 1, 0, 0, 1);
+	CHECK (check_update (doc) == 0);
+	CHECK (count_remaining (doc->GetAtoms ().cleaved) == na - n * n - SIZE * SIZE);
+	CHECK (count_remaining (doc->GetLines ().cleaved) == nl - n * n - 2 * SIZE * n);
+	CHECK (fabs (highest_remaining (doc, 1, 0, 0) - (SIZE - .5)) < PREC);
+
+	// in the fcc lattice, x + y + z is an integer, one plane for each value
+	clear_cleavages (doc);
+	add_cleavage (doc, 1, 1, 1, 3);
+	CHECK (check_update (doc) == 0);
+	CHECK (fabs (highest_remaining (doc, 1, 1, 1) - (3 * SIZE - 3)) < PREC);
+
+	// several cleavages, some of them on the same planes
+	add_cleavage (doc, 1, 0, 0, 2);
+	add_cleavage (doc, 0, 1, 1, 1);
+	add_cleavage (doc, 2, 1, 0, 4);
+	add_cleavage (doc, 3, 2, 1, 5);
+	add_cleavage (doc, -1, 0, 0, 1);
+	CHECK (check_update (doc) == 0);
+	CHECK (count_remaining (doc->GetAtoms ().cleaved) > 0);
+
+	// the same cleavages evaluated in separate threads
+	doc->SetSize (0., THREADED_SIZE, 0., THREADED_SIZE, 0., THREADED_SIZE);
+	CHECK (check_update (doc) == 0);
+	CHECK (doc->GetAtoms ().GetCount () >= 4096);
+	CHECK (count_remaining (doc->GetAtoms ().cleaved) > 0);
+
+	// cleavages are not cumulated between updates
+	clear_cleavages (doc);
+	CHECK (check_update (doc) == 0);
+	CHECK (count_remaining (doc->GetAtoms ().cleaved) == doc->GetAtoms ().GetCount ());
+	delete doc;
+	return 0;
+}
+
+/* enlarges the displayed box to n cells in each direction, then times the
+ update of the crystal without cleavages and with three, four, and five
+ simultaneous cleavages */
+static int bench (int n, char const *filename)
+{
+	gcr::Document *doc = load (filename);
+	if (!doc)
+		return 1;
+	GTimer *timer = g_timer_new ();
+	doc->SetSize (0., n, 0., n, 0., n);
+	doc->Update ();
+	printf ("%d x %d x %d cells: %g s\n", n, n, n, g_timer_elapsed (timer, NULL));
+
+	g_timer_start (timer);
+	doc->Update ();
+	printf ("update without cleavages: %g s\n", g_timer_elapsed (timer, NULL));
+
+	add_cleavage (doc, 1, 0, 0, 2);
+	add_cleavage (doc, 1, 1, 1, 3);
+	add_cleavage (doc, 0, 1, 1, 1);
+	g_timer_start (timer);
+	doc->Update ();
+	printf ("update with 3 cleavages: %g s\n", g_timer_elapsed (timer, NULL));
+
+	add_cleavage (doc, 2, 1, 0, 4);
+	g_timer_start (timer);
+	doc->Update ();
+	printf ("update with 4 cleavages: %g s\n", g_timer_elapsed (timer, NULL));
+
+	add_cleavage (doc, 3, 2, 1, 5);
+	g_timer_start (timer);
+	doc->Update ();
+	printf ("update with 5 cleavages: %g s\n", g_timer_elapsed (timer, NULL));
+
+	g_timer_destroy (timer);
+	delete doc;
+	return 0;
+}
+
+/*!
+\a main function of the test. With --bench as first argument, it loads
+nickel.gcrystal (or the file given as third argument), enlarges the box to 40
+cells in each direction (or the number given as second argument), and times
+the updates.
+*/
+int main (int argc, char *argv[])
+{
+	gcu_element_load_databases ("radii", NULL);
+	if (argc > 1 && !strcmp (argv[1], "--bench"))
+		return bench ((argc > 2)? atoi (argv[2]): 40, (argc > 3)? argv[3]: SRCDIR"/nickel.gcrystal");
+	return test_cleavages (SRCDIR"/nickel.gcrystal");
+}
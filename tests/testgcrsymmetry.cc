@@ -0,0 +1,226 @@
+/*
+ * Gnome Chemisty Utils
+ * tests/testgcrsymmetry.cc
+ *
+ * Copyright (C) 2026 Jean Bréfort <jean.brefort@normalesup.org>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301
+ * USA
+ */
+
+#include "config.h"
+#include "check.h"
+#include <gcr/atom.h>
+#include <gcr/document.h>
+#include <gcu/chemistry.h>
+#include <gcu/element.h>
+#include <gcu/spacegroup.h>
+#include <gcu/vector.h>
+#include <libxml/parser.h>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <list>
+#include <string>
+#include <vector>
+
+/*!\file
+Tests the space group detection of gcr::Document::FindSpaceGroup() and the
+removal of the symmetry equivalent atoms, for a file and for a few structures
+built in memory, with primitive and centered lattices. The last structure is
+large enough for the operations to be tested in a thread pool.
+*/
+
+struct Position {
+	char const *element;
+	double x, y, z;
+};
+
+static gcr::Document *load (xmlDocPtr xml)
+{
+	xmlNodePtr node, next;
+	if (!xml || !xml->children)
+		return NULL;
+	// views need a window, drop them
+	for (node = xml->children->children; node; node = next) {
+		next = node->next;
+		if (!strcmp ((char const *) node->name, "view")) {
+			xmlUnlinkNode (node);
+			xmlFreeNode (node);
+		}
+	}
+	gcr::Document *doc = new gcr::Document (NULL);
+	doc->ParseXMLTree (xml->children);
+	xmlFreeDoc (xml);
+	return doc;
+}
+
+static gcr::Document *build (char const *lattice, Position const *positions, unsigned n)
+{
+	std::string str = "<?xml version=\"1.0\"?>\n<crystal>\n<lattice>";
+	char buf[256];
+	str += lattice;
+	str += "</lattice>\n<cell a=\"400\" b=\"500\" c=\"600\" alpha=\"90\" beta=\"90\" gamma=\"90\"/>\n";
+	for (unsigned i = 0; i < n; i++) {
+		snprintf (buf, sizeof (buf), "<atom element=\"%s\"><position x=\"%.12g\" y=\"%.12g\" z=\"%.12g\"/>"
+		          "<radius type=\"unknown\" value=\"100\"/></atom>\n",
+		          positions[i].element, positions[i].x, positions[i].y, positions[i].z);
+		str += buf;
+	}
+	str += "</crystal>\n";
+	return load (xmlParseMemory (str.c_str (), str.length ()));
+}
+
+static bool same_coordinate (double a, double b)
+{
+	double d = fabs (a - b);
+	d -= floor (d + .5);
+	return fabs (d) < PREC;
+}
+
+// evaluated with gcu::SpaceGroup::Transform(), independently of gcr::SymmetryFinder
+static bool equivalent (gcu::SpaceGroup const *group, gcr::Atom *a, gcr::Atom *b)
+{
+	if (a->GetZ () != b->GetZ ())
+		return false;
+	std::list <gcu::Vector> images = group->Transform (gcu::Vector (a->x (), a->y (), a->z ()));
+	std::list <gcu::Vector>::iterator i, iend = images.end ();
+	for (i = images.begin (); i != iend; i++)
+		if (same_coordinate ((*i).GetX (), b->x ()) && same_coordinate ((*i).GetY (), b->y ()) &&
+		    same_coordinate ((*i).GetZ (), b->z ()))
+			return true;
+	return false;
+}
+
+static bool has_atom (gcr::AtomList *atoms, int Z, double x, double y, double z)
+{
+	gcr::AtomList::iterator i, iend = atoms->end ();
+	for (i = atoms->begin (); i != iend; i++)
+		if ((*i)->GetZ () == Z && fabs ((*i)->x () - x) < PREC && fabs ((*i)->y () - y) < PREC &&
+		    fabs ((*i)->z () - z) < PREC)
+			return true;
+	return false;
+}
+
+/*
+Checks that the detected group is \a id with the Hermann-Mauguin symbol \a HM,
+that \a kept atoms are left, that each of the \a n original positions is
+equivalent to one of them, and that they are not equivalent to each other.
+*/
+static int check (gcr::Document *doc, unsigned id, char const *HM, Position const *positions, unsigned n, unsigned kept)
+{
+	CHECK (doc != NULL);
+	gcu::SpaceGroup const *group = doc->FindSpaceGroup ();
+	CHECK (group != NULL);
+	CHECK (group->GetId () == id);
+	CHECK (group->GetHMName () == HM);
+	gcr::AtomList *atoms = doc->GetAtomList ();
+	CHECK (atoms->size () == kept);
+	gcr::AtomList::iterator i, j, iend = atoms->end ();
+	for (unsigned k = 0; k < n; k++) {
+		int Z = gcu::Element::Z (positions[k].element);
+		gcr::Atom atom (Z, positions[k].x, positions[k].y, positions[k].z);
+		for (i = atoms->begin (); i != iend; i++)
+			if (equivalent (group, &atom, *i))
+				break;
+		CHECK (i != iend);
+	}
+	for (i = atoms->begin (); i != iend; i++)
+		for (j = atoms->begin (); j != i; j++)
+			CHECK (!equivalent (group, *j, *i));
+	// nothing changed, the same group is returned and no atom is removed
+	CHECK (doc->FindSpaceGroup () == group);
+	CHECK (atoms->size () == kept);
+	return 0;
+}
+
+static int test_nickel ()
+{
+	static Position const nickel[] = {{"Ni", 0., 0., 0.}};
+	gcr::Document *doc = load (xmlParseFile (SRCDIR"/nickel.gcrystal"));
+	int res = check (doc, 225, "F m -3 m", nickel, 1, 1);
+	delete doc;
+	return res;
+}
+
+static int test_body_centered ()
+{
+	// the second atom is the centering translation of the first one
+	static Position const iron[] = {{"Fe", 0., 0., 0.}, {"Fe", .5, .5, .5}};
+	gcr::Document *doc = build ("body-centered cubic", iron, 2);
+	int res = check (doc, 229, "I m -3 m", iron, 2, 1);
+	if (!res)
+		CHECK (has_atom (doc->GetAtomList (), 26, 0., 0., 0.));
+	delete doc;
+	return res;
+}
+
+static int test_face_centered ()
+{
+	static Position const salt[] = {
+		{"Na", 0., 0., 0.}, {"Cl", .5, 0., 0.}, {"Na", .5, .5, 0.},
+		{"Cl", 0., .5, 0.}, {"Cl", 0., 0., .5}, {"Cl", .5, .5, .5}
+	};
+	gcr::Document *doc = build ("face-centered cubic", salt, 6);
+	int res = check (doc, 225, "F m -3 m", salt, 6, 2);
+	if (!res) {
+		CHECK (has_atom (doc->GetAtomList (), 11, 0., 0., 0.));
+		CHECK (has_atom (doc->GetAtomList (), 17, 0., 0., .5));
+	}
+	delete doc;
+	return res;
+}
+
+static int test_base_centered ()
+{
+	static Position const carbon[] = {{"C", 0., 0., 0.}, {"C", .5, .5, 0.}};
+	gcr::Document *doc = build ("base-centered orthorhombic", carbon, 2);
+	int res = check (doc, 65, "C m m m", carbon, 2, 1);
+	if (!res)
+		CHECK (has_atom (doc->GetAtomList (), 6, 0., 0., 0.));
+	delete doc;
+	return res;
+}
+
+static int test_large ()
+{
+	/*
+	 125 positions, the cubic groups use 774 distinct operations, so that the
+	 operations are tested in a thread pool. The positions are equivalent when
+	 their coordinates are, up to a permutation, either equal or opposite, which
+	 gives 10 classes.
+	 */
+	std::vector <Position> grid;
+	unsigned i, j, k;
+	for (i = 0; i < 5; i++)
+		for (j = 0; j < 5; j++)
+			for (k = 0; k < 5; k++) {
+				Position p = {"Fe", i / 5., j / 5., k / 5.};
+				grid.push_back (p);
+			}
+	gcr::Document *doc = build ("simple cubic", &grid[0], grid.size ());
+	int res = check (doc, 221, "P m -3 m", &grid[0], grid.size (), 10);
+	delete doc;
+	return res;
+}
+
+int main ()
+{
+	gcu_element_load_databases ("radii", NULL);
+	if (test_nickel () || test_body_centered () || test_face_centered () ||
+	    test_base_centered () || test_large ())
+		return 1;
+	return 0;
+}
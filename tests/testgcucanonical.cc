@@ -0,0 +1,180 @@
+/*
+ * Gnome Chemisty Utils
+ * tests/testgcucanonical.cc
+ *
+ * Copyright (C) 2026 Jean Bréfort <jean.brefort@normalesup.org>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301
+ * USA
+ */
+
+#include "config.h"
+#include "check.h"
+#include <gcu/atom.h>
+#include <gcu/bond.h>
+#include <gcu/canonical.h>
+#include <gcu/document.h>
+#include <gcu/molecule.h>
+#include <glib.h>
+#include <cstdio>
+#include <cstdlib>
+#include <map>
+#include <set>
+#include <vector>
+
+/*!\file
+Tests the canonical labeling of gcu::Molecule, the molecules comparison, and
+the grouping of identical molecules.
+*/
+
+typedef std::vector < std::pair < int, int > > Edges;
+typedef std::set < std::pair < unsigned, unsigned > > CanonicalBonds;
+
+// builds a molecule with atoms and bonds created in a random order, atoms[i]
+// being the atom numbered i in edges
+static gcu::Molecule *build (gcu::Document *doc, int n, Edges const &edges, std::vector < gcu::Atom * > &atoms)
+{
+	std::vector < int > perm (n);
+	int i, j;
+	atoms.resize (n);
+	for (i = 0; i < n; i++)
+		perm[i] = i;
+	for (i = n - 1; i > 0; i--) {
+		j = g_random_int_range (0, i + 1);
+		std::swap (perm[i], perm[j]);
+	}
+	for (i = 0; i < n; i++) {
+		atoms[perm[i]] = new gcu::Atom (6, i * 1.5, 0., 0.);
+		doc->AddChild (atoms[perm[i]]);
+	}
+	for (i = edges.size () - 1; i >= 0; i--)
+		doc->AddChild (new gcu::Bond (atoms[edges[i].first], atoms[edges[i].second], 1));
+	return new gcu::Molecule (atoms[perm[0]]);
+}
+
+static void add_path (Edges &edges, int first, int last)
+{
+	for (int i = first; i < last; i++)
+		edges.push_back (std::make_pair (i, i + 1));
+}
+
+static std::map < gcu::Atom *, unsigned > get_positions (gcu::CanonicalLabeling const &labeling)
+{
+	std::map < gcu::Atom *, unsigned > positions;
+	for (unsigned i = 0; i < labeling.GetAtomsNumber (); i++)
+		positions[labeling.GetAtom (i)] = i;
+	return positions;
+}
+
+// the bonds given by the canonical positions of their atoms
+static CanonicalBonds get_bonds (gcu::CanonicalLabeling const &labeling, Edges const &edges, std::vector < gcu::Atom * > const &atoms)
+{
+	std::map < gcu::Atom *, unsigned > positions = get_positions (labeling);
+	CanonicalBonds bonds;
+	for (unsigned i = 0; i < edges.size (); i++) {
+		unsigned p0 = positions[atoms[edges[i].first]], p1 = positions[atoms[edges[i].second]];
+		bonds.insert ((p0 < p1)? std::make_pair (p0, p1): std::make_pair (p1, p0));
+	}
+	return bonds;
+}
+
+/*!
+Builds hexane, cyclohexane, 2-methylpentane and 3-methylpentane twice each,
+atoms being created in random orders, and checks that both copies get the same
+hash and the same canonical bonds, while the four molecules get different
+hashes. Atoms which are not exchanged by any symmetry of the molecule must get
+the same canonical position in both copies. Then does the same with two
+hexagonal sheets and a sheet missing a bond, and finally sorts 40 molecules
+into groups of identical molecules.
+*/
+int main ()
+{
+	int i, j, x, y;
+	gcu::Document *doc = new gcu::Document (NULL);
+	std::vector < gcu::Atom * > atoms1, atoms2, atoms3;
+
+	Edges edges[4];
+	add_path (edges[0], 0, 5);
+	add_path (edges[1], 0, 5);
+	edges[1].push_back (std::make_pair (5, 0));
+	add_path (edges[2], 0, 4);
+	edges[2].push_back (std::make_pair (1, 5));
+	add_path (edges[3], 0, 4);
+	edges[3].push_back (std::make_pair (2, 5));
+	// the atoms with no symmetric equivalent in each molecule, -1 terminated
+	int unique[4][5] = {{-1}, {-1}, {1, 2, 3, 4, -1}, {2, 5, -1}};
+	guint64 hashes[4];
+	for (i = 0; i < 4; i++) {
+		gcu::Molecule *mol1 = build (doc, 6, edges[i], atoms1), *mol2 = build (doc, 6, edges[i], atoms2);
+		gcu::CanonicalLabeling labeling1 (mol1), labeling2 (mol2);
+		CHECK (labeling1.GetAtomsNumber () == 6 && labeling1.IsMatchable ());
+		CHECK (labeling1.GetHash () == labeling2.GetHash ());
+		CHECK (labeling1.IsEquivalent (labeling2));
+		CHECK (get_bonds (labeling1, edges[i], atoms1) == get_bonds (labeling2, edges[i], atoms2));
+		std::map < gcu::Atom *, unsigned > positions1 = get_positions (labeling1), positions2 = get_positions (labeling2);
+		for (j = 0; unique[i][j] >= 0; j++)
+			CHECK (positions1[atoms1[unique[i][j]]] == positions2[atoms2[unique[i][j]]]);
+		for (j = 0; j < 6; j++)
+			CHECK (labeling1.GetAtom (j)->GetBondsNumber () == labeling2.GetAtom (j)->GetBondsNumber ());
+		CHECK (*mol1 == *mol2);
+		hashes[i] = labeling1.GetHash ();
+		for (j = 0; j < i; j++)
+			CHECK (hashes[i] != hashes[j]);
+	}
+	delete doc;
+
+	// 400 atoms sheets, the third one missing a bond
+	Edges sheet, broken;
+	for (y = 0; y < 20; y++)
+		for (x = 0; x < 20; x++) {
+			if (x < 19)
+				sheet.push_back (std::make_pair (y * 20 + x, y * 20 + x + 1));
+			if (y < 19 && (x + y) % 2 == 0)
+				sheet.push_back (std::make_pair (y * 20 + x, (y + 1) * 20 + x));
+		}
+	broken = sheet;
+	broken.erase (broken.begin () + broken.size () / 2);
+	doc = new gcu::Document (NULL);
+	gcu::Molecule *mol1 = build (doc, 400, sheet, atoms1), *mol2 = build (doc, 400, sheet, atoms2),
+				  *mol3 = build (doc, 400, broken, atoms3);
+	gcu::CanonicalLabeling labeling1 (mol1), labeling2 (mol2), labeling3 (mol3);
+	CHECK (labeling1.GetHash () == labeling2.GetHash ());
+	CHECK (get_bonds (labeling1, sheet, atoms1) == get_bonds (labeling2, sheet, atoms2));
+	CHECK (*mol1 == *mol2);
+	CHECK (labeling1.GetHash () != labeling3.GetHash ());
+	CHECK (!labeling1.IsEquivalent (labeling3));
+	CHECK (!(*mol1 == *mol3));
+	delete doc;
+
+	// the four molecules in turn
+	doc = new gcu::Document (NULL);
+	std::map < gcu::Molecule *, int > shapes;
+	for (i = 0; i < 40; i++)
+		shapes[build (doc, 6, edges[i % 4], atoms1)] = i % 4;
+	std::vector < std::vector < gcu::Molecule * > > groups;
+	doc->GroupIdenticalMolecules (groups);
+	CHECK (groups.size () == 4);
+	std::set < int > found;
+	for (i = 0; i < 4; i++) {
+		CHECK (groups[i].size () == 10);
+		int shape = shapes[groups[i][0]];
+		for (j = 1; j < 10; j++)
+			CHECK (shapes[groups[i][j]] == shape);
+		found.insert (shape);
+	}
+	CHECK (found.size () == 4);
+	delete doc;
+	return 0;
+}
@@ -0,0 +1,417 @@
+/*
+ * Gnome Chemisty Utils
+ * tests/testgcuctfiles.cc
+ *
+ * Copyright (C) 2026 Jean Bréfort <jean.brefort@normalesup.org>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301
+ * USA
+ */
+
+// the loader is a plugin which is not installed yet, build it in
+#include "../plugins/loaders/ctfiles/ctfiles.cc"
+#include "check.h"
+#include <gcu/atom.h>
+#include <gcu/bond.h>
+#include <gcu/element.h>
+#include <gsf/gsf-input-impl.h>
+#include <gsf/gsf-input-memory.h>
+#include <gsf/gsf-input-stdio.h>
+#include <gsf/gsf-output-memory.h>
+#include <cstdio>
+
+/*!\file
+Loads hand written V2000 and V3000 molfiles, a RXN file and a RDfile with the
+CTfiles loader, checks the molecules and the reaction built, and saves them
+back. The reaction objects are simple stand-ins for those of GChemPaint, which
+only record what the loader sets.
+*/
+
+static gcu::TypeId StepType;
+
+class TestArrow: public gcu::Object
+{
+public:
+	TestArrow (): gcu::Object (gcu::ReactionArrowType), x0 (0.), y0 (0.), x1 (0.), y1 (0.) {}
+
+	bool SetProperty (unsigned property, char const *value);
+	std::string GetProperty (unsigned property) const;
+
+	std::string Start, End;
+	double x0, y0, x1, y1;
+};
+
+bool TestArrow::SetProperty (unsigned property, char const *value)
+{
+	switch (property) {
+	case GCU_PROP_ARROW_COORDS: {
+		std::istringstream in (value);
+		in >> x0 >> y0 >> x1 >> y1;
+		break;
+	}
+	case GCU_PROP_ARROW_START_ID:
+		Start = value;
+		break;
+	case GCU_PROP_ARROW_END_ID:
+		End = value;
+		break;
+	default:
+		return gcu::Object::SetProperty (property, value);
+	}
+	return true;
+}
+
+std::string TestArrow::GetProperty (unsigned property) const
+{
+	switch (property) {
+	case GCU_PROP_ARROW_START_ID:
+		return Start;
+	case GCU_PROP_ARROW_END_ID:
+		return End;
+	default:
+		return gcu::Object::GetProperty (property);
+	}
+}
+
+// a reactant just takes the molecule as child
+class TestReactant: public gcu::Object
+{
+public:
+	TestReactant (): gcu::Object (gcu::ReactantType) {}
+
+	bool SetProperty (unsigned property, char const *value);
+};
+
+bool TestReactant::SetProperty (unsigned property, char const *value)
+{
+	if (property != GCU_PROP_MOLECULE)
+		return gcu::Object::SetProperty (property, value);
+	gcu::Object *molecule = GetDocument ()->GetDescendant (value);
+	if (!molecule)
+		return false;
+	AddChild (molecule);
+	return true;
+}
+
+static gcu::Object *create_atom () {return new gcu::Atom ();}
+static gcu::Object *create_bond () {return new gcu::Bond ();}
+static gcu::Object *create_molecule () {return new gcu::Molecule ();}
+static gcu::Object *create_reaction () {return new gcu::Object (gcu::ReactionType);}
+static gcu::Object *create_step () {return new gcu::Object (StepType);}
+static gcu::Object *create_reactant () {return new TestReactant ();}
+static gcu::Object *create_arrow () {return new TestArrow ();}
+
+static void add_types (gcu::Application *app, bool reactions)
+{
+	app->AddType ("atom", create_atom, gcu::AtomType);
+	app->AddType ("bond", create_bond, gcu::BondType);
+	app->AddType ("molecule", create_molecule, gcu::MoleculeType);
+	if (!reactions)
+		return;
+	app->AddType ("reaction", create_reaction, gcu::ReactionType);
+	StepType = app->AddType ("reaction-step", create_step);
+	app->AddType ("reactant", create_reactant, gcu::ReactantType);
+	app->AddType ("reaction-arrow", create_arrow, gcu::ReactionArrowType);
+}
+
+static gcu::ContentType load (gcu::Document *doc, char const *name, char const *mime_type)
+{
+	std::string filename = std::string (SRCDIR"/") + name;
+	GsfInput *in = gsf_input_stdio_new (filename.c_str (), NULL);
+	if (!in) {
+		fprintf (stderr, "could not open %s\n", filename.c_str ());
+		return gcu::ContentTypeUnknown;
+	}
+	gcu::ContentType res = loader.Read (doc, in, mime_type, NULL);
+	g_object_unref (in);
+	return res;
+}
+
+// saves the document and loads the result in a new document of the same application
+static gcu::Document *reload (gcu::Document *doc, char const *mime_type)
+{
+	GsfOutput *out = gsf_output_memory_new ();
+	bool saved = loader.Write (doc, out, mime_type, NULL, gcu::ContentType2D);
+	gsf_output_close (out);
+	gcu::Document *res = NULL;
+	if (saved) {
+		GsfInput *in = gsf_input_memory_new (gsf_output_memory_get_bytes (GSF_OUTPUT_MEMORY (out)), gsf_output_size (out), FALSE);
+		res = new gcu::Document (doc->GetApplication ());
+		if (loader.Read (res, in, mime_type, NULL) == gcu::ContentTypeUnknown) {
+			delete res;
+			res = NULL;
+		}
+		g_object_unref (in);
+	}
+	g_object_unref (out);
+	return res;
+}
+
+static void get_children (gcu::Object *object, gcu::TypeId type, std::vector < gcu::Object * > &children)
+{
+	std::map < std::string, gcu::Object * >::iterator i;
+	for (gcu::Object *child = object->GetFirstChild (i); child; child = object->GetNextChild (i))
+		if (child->GetType () == type)
+			children.push_back (child);
+		else
+			get_children (child, type, children);
+}
+
+static gcu::Molecule *get_molecule (gcu::Object *object)
+{
+	std::vector < gcu::Object * > molecules;
+	get_children (object, gcu::MoleculeType, molecules);
+	return (molecules.size () == 1)? static_cast < gcu::Molecule * > (molecules[0]): NULL;
+}
+
+// the atoms are in the molecule in the order of the file, but their ids might
+// have been changed to be unique in the document
+static gcu::Atom *get_atom (gcu::Molecule *molecule, unsigned n)
+{
+	std::list < gcu::Atom * >::iterator i;
+	gcu::Atom *atom = molecule->GetFirstAtom (i);
+	while (atom && n--)
+		atom = molecule->GetNextAtom (i);
+	return atom;
+}
+
+static bool check_molecule (gcu::Molecule *molecule, char const *symbols, unsigned bonds)
+{
+	if (!molecule || molecule->GetAtomsNumber () != strlen (symbols) || molecule->GetBondsNumber () != bonds)
+		return false;
+	for (unsigned i = 0; symbols[i]; i++) {
+		char symbol[2] = {symbols[i], 0};
+		if (get_atom (molecule, i)->GetZ () != gcu::Element::Z (symbol))
+			return false;
+	}
+	return true;
+}
+
+static bool check_position (gcu::Molecule *molecule, unsigned n, double x, double y)
+{
+	double ax, ay, scale = molecule->GetDocument ()->GetScale ();
+	gcu::Atom *atom = get_atom (molecule, n);
+	return atom && atom->GetCoords (&ax, &ay) && fabs (ax / scale - x) < 1e-6 && fabs (ay / scale - y) < 1e-6;
+}
+
+static gcu::Bond const *get_bond (gcu::Molecule const *molecule, unsigned n)
+{
+	std::list < gcu::Bond * >::const_iterator i;
+	gcu::Bond const *bond = molecule->GetFirstBond (i);
+	while (bond && n--)
+		bond = molecule->GetNextBond (i);
+	return bond;
+}
+
+static void get_bounds (gcu::Molecule *molecule, double &xmin, double &xmax, double &ymin, double &ymax)
+{
+	double x, y, scale = molecule->GetDocument ()->GetScale ();
+	std::list < gcu::Atom * >::iterator i;
+	xmin = ymin = 1e10;
+	xmax = ymax = -1e10;
+	for (gcu::Atom *atom = molecule->GetFirstAtom (i); atom; atom = molecule->GetNextAtom (i)) {
+		atom->GetCoords (&x, &y);
+		x /= scale;
+		y /= scale;
+		if (x < xmin)
+			xmin = x;
+		if (x > xmax)
+			xmax = x;
+		if (y < ymin)
+			ymin = y;
+		if (y > ymax)
+			ymax = y;
+	}
+}
+
+// checks the hydrogenation reaction and the layout of its components
+static int check_reaction (gcu::Object *object)
+{
+	std::vector < gcu::Object * > reactions, arrows, steps, molecules;
+	get_children (object, gcu::ReactionType, reactions);
+	CHECK (reactions.size () == 1);
+	gcu::Object *reaction = reactions[0];
+	get_children (reaction, gcu::ReactionArrowType, arrows);
+	CHECK (arrows.size () == 1);
+	TestArrow *arrow = static_cast < TestArrow * > (arrows[0]);
+	gcu::Object *reactants = reaction->GetChild (arrow->Start.c_str ()), *products = reaction->GetChild (arrow->End.c_str ());
+	CHECK (reactants && reactants->GetType () == StepType);
+	CHECK (products && products->GetType () == StepType);
+	get_children (reaction, StepType, steps);
+	CHECK (steps.size () == 2);
+	std::vector < gcu::Object * > left, right;
+	get_children (reactants, gcu::ReactantType, left);
+	get_children (products, gcu::ReactantType, right);
+	CHECK (left.size () == 2 && right.size () == 1);
+	gcu::Molecule *ethylene = get_molecule (left[0]), *hydrogen = get_molecule (left[1]), *ethane = get_molecule (right[0]);
+	CHECK (ethylene && hydrogen);
+	// the order of the reactants depends on their ids
+	if (get_atom (ethylene, 0)->GetZ () == 1) {
+		gcu::Molecule *molecule = ethylene;
+		ethylene = hydrogen;
+		hydrogen = molecule;
+	}
+	CHECK (check_molecule (ethylene, "CC", 1));
+	CHECK (get_bond (ethylene, 0)->GetOrder () == 2);
+	CHECK (check_molecule (hydrogen, "HH", 1));
+	CHECK (check_molecule (ethane, "CC", 1));
+	// no molecule is left outside of the reaction
+	get_children (object, gcu::MoleculeType, molecules);
+	CHECK (molecules.size () == 3);
+	// the components are centered on the arrow line, and do not overlap
+	CHECK (arrow->y0 == 0. && arrow->y1 == 0. && arrow->x1 > arrow->x0);
+	double xmin[3], xmax[3], ymin, ymax;
+	get_bounds (ethylene, xmin[0], xmax[0], ymin, ymax);
+	CHECK (fabs (ymin + ymax) < 1e-6 && xmax[0] < arrow->x0);
+	get_bounds (hydrogen, xmin[1], xmax[1], ymin, ymax);
+	CHECK (fabs (ymin + ymax) < 1e-6 && xmax[1] < arrow->x0);
+	CHECK (xmax[0] < xmin[1] || xmax[1] < xmin[0]);
+	get_bounds (ethane, xmin[2], xmax[2], ymin, ymax);
+	CHECK (fabs (ymin + ymax) < 1e-6 && xmin[2] > arrow->x1);
+	// the molecules shapes are kept
+	CHECK (fabs (xmax[2] - xmin[2] - 1.5) < 1e-6);
+	return 0;
+}
+
+int main ()
+{
+	gsf_init ();
+	gcu::Application *app = new gcu::Application ("testgcuctfiles");
+	add_types (app, true);
+	if (gcu::Element::Z ("C") != 6) {
+		fprintf (stderr, "the elements database is not available, skipping\n");
+		return 77;
+	}
+
+	// the file type comes from the MIME type, or from the file name
+	GsfInput *in = gsf_input_stdio_new (SRCDIR"/ethanol.mol", NULL);
+	CHECK (in != NULL);
+	CHECK (IsSDfile ("chemical/x-mdl-sdfile", in));
+	CHECK (!IsSDfile ("chemical/x-mdl-molfile", in));
+	CHECK (!IsSDfile (NULL, in));
+	g_object_unref (in);
+	in = gsf_input_memory_new (reinterpret_cast < guint8 const * > (""), 0, FALSE);
+	CHECK (!IsSDfile (NULL, in));
+	gsf_input_set_name (in, "library.SDF");
+	CHECK (IsSDfile (NULL, in));
+	CHECK (!IsSDfile ("chemical/x-mdl-molfile", in));
+	g_object_unref (in);
+
+	// V2000 molfile
+	gcu::Document *doc = new gcu::Document (app);
+	CHECK (load (doc, "ethanol.mol", "chemical/x-mdl-molfile") == gcu::ContentType2D);
+	CHECK (doc->GetTitle () == "ethanol");
+	CHECK (doc->GetComment () == "hand written V2000 molfile");
+	gcu::Molecule *molecule = get_molecule (doc);
+	CHECK (check_molecule (molecule, "CCO", 2));
+	// the y axis is reversed
+	CHECK (check_position (molecule, 1, 1.299, -.75));
+	CHECK (check_position (molecule, 2, 2.598, 0.));
+	// the second bond links the second and third atoms
+	gcu::Bond const *bond = get_bond (molecule, 1);
+	CHECK (bond && bond->GetOrder () == 1);
+	CHECK (bond->GetAtom (get_atom (molecule, 1)) == get_atom (molecule, 2));
+	// saved as V3000 and loaded again
+	gcu::Document *copy = reload (doc, "chemical/x-mdl-molfile");
+	CHECK (copy != NULL);
+	molecule = get_molecule (copy);
+	CHECK (check_molecule (molecule, "CCO", 2));
+	CHECK (check_position (molecule, 1, 1.299, -.75));
+	delete copy;
+	delete doc;
+
+	// V3000 molfile with a charge and a double bond
+	doc = new gcu::Document (app);
+	CHECK (load (doc, "acetate.mol", "chemical/x-mdl-molfile") == gcu::ContentType2D);
+	CHECK (doc->GetTitle () == "acetate");
+	molecule = get_molecule (doc);
+	CHECK (check_molecule (molecule, "CCOO", 3));
+	CHECK (get_atom (molecule, 3)->GetCharge () == -1);
+	CHECK (get_atom (molecule, 2)->GetCharge () == 0);
+	CHECK (check_position (molecule, 3, 1.299, -2.25));
+	bond = get_bond (molecule, 1);
+	CHECK (bond && bond->GetOrder () == 2);
+	copy = reload (doc, "chemical/x-mdl-sdfile");
+	CHECK (copy != NULL);
+	molecule = get_molecule (copy);
+	CHECK (check_molecule (molecule, "CCOO", 3));
+	CHECK (get_atom (molecule, 3)->GetCharge () == -1);
+	delete copy;
+	delete doc;
+
+	// RXN file
+	doc = new gcu::Document (app);
+	CHECK (load (doc, "hydrogenation.rxn", "chemical/x-mdl-rxnfile") == gcu::ContentType2D);
+	CHECK (doc->GetTitle () == "hydrogenation");
+	CHECK (doc->GetComment () == "hand written RXN file");
+	if (check_reaction (doc))
+		return 1;
+	copy = reload (doc, "chemical/x-mdl-rxnfile");
+	CHECK (copy != NULL);
+	if (check_reaction (copy))
+		return 1;
+	delete copy;
+	// a molfile only gets the first molecule, and a SDfile all of them
+	copy = reload (doc, "chemical/x-mdl-sdfile");
+	CHECK (copy != NULL);
+	std::vector < gcu::Object * > children;
+	get_children (copy, gcu::MoleculeType, children);
+	CHECK (children.size () == 3);
+	children.clear ();
+	get_children (copy, gcu::ReactionType, children);
+	CHECK (children.empty ());
+	delete copy;
+	delete doc;
+
+	// RDfile with two molecules, a record without structure, and a reaction
+	doc = new gcu::Document (app);
+	CHECK (load (doc, "library.rdf", "chemical/x-mdl-rdfile") == gcu::ContentType2D);
+	CHECK (doc->GetTitle () == "ethanol");
+	children.clear ();
+	get_children (doc, gcu::MoleculeType, children);
+	CHECK (children.size () == 5);
+	if (check_reaction (doc))
+		return 1;
+	copy = reload (doc, "chemical/x-mdl-rdfile");
+	CHECK (copy != NULL);
+	children.clear ();
+	get_children (copy, gcu::MoleculeType, children);
+	CHECK (children.size () == 5);
+	if (check_reaction (copy))
+		return 1;
+	delete copy;
+	delete doc;
+
+	// reactions are rejected by applications which don't support them
+	gcu::Application *plain = new gcu::Application ("testgcuctfiles-plain");
+	add_types (plain, false);
+	doc = new gcu::Document (plain);
+	CHECK (load (doc, "hydrogenation.rxn", "chemical/x-mdl-rxnfile") == gcu::ContentTypeUnknown);
+	delete doc;
+	doc = new gcu::Document (plain);
+	CHECK (load (doc, "library.rdf", "chemical/x-mdl-rdfile") == gcu::ContentTypeUnknown);
+	// and a document without reaction can't be saved as a RXN file
+	delete doc;
+	doc = new gcu::Document (plain);
+	CHECK (load (doc, "ethanol.mol", "chemical/x-mdl-molfile") == gcu::ContentType2D);
+	GsfOutput *out = gsf_output_memory_new ();
+	CHECK (!loader.Write (doc, out, "chemical/x-mdl-rxnfile", NULL, gcu::ContentType2D));
+	g_object_unref (out);
+	delete doc;
+	delete plain;
+	delete app;
+	gsf_shutdown ();
+	return 0;
+}
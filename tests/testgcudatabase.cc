@@ -0,0 +1,337 @@
+/*
+ * Gnome Chemisty Utils
+ * tests/testgcudatabase.cc
+ *
+ * Copyright (C) 2026 Jean Bréfort <jean.brefort@normalesup.org>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301
+ * USA
+ */
+
+#include "config.h"
+#include <gcu/dbimage.h>
+#include <gcu/element.h>
+#include <gcu/spacegroup.h>
+#include <gcu/transform3d.h>
+#include <gcu/vector.h>
+#include <goffice/goffice.h>
+#include <glib.h>
+#include <glib/gstdio.h>
+#include <libxml/parser.h>
+#include <cstdarg>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <list>
+#include <set>
+#include <string>
+#include <unistd.h>
+
+/*!\file
+Tests that the binary database image gives the same data as the XML databases.
+The image is compiled from the XML files of the build tree into a temporary
+file, and the data loaded while compiling are written to a string. The program
+then runs itself with the image, which writes the same data to its standard
+output, and both are compared: all elements with their names, radii,
+electronegativities, electronic properties, isotopic patterns and Blue Obelisk
+Data Repository properties, and all space groups with their operations.
+
+With --bench, compares instead the time needed to load the installed XML files
+and the installed image, as done when gchemtable or gchemcalc start.
+*/
+
+static void append (std::string &out, char const *format, ...)
+{
+	va_list args;
+	va_start (args, format);
+	char *str = g_strdup_vprintf (format, args);
+	va_end (args);
+	out += str;
+	g_free (str);
+}
+
+static char const *safe (char const *str)
+{
+	return (str)? str: "(null)";
+}
+
+// the names of the Blue Obelisk Data Repository properties, as used by gcu::Element
+static void get_bodr_names (std::set <std::string> &names)
+{
+	xmlDocPtr xml = xmlParseFile (BODR_PKGDATADIR"/elements.xml");
+	if (!xml)
+		return;
+	xmlNodePtr node, child;
+	for (node = xml->children->children; node; node = node->next)
+		for (child = node->children; child; child = child->next) {
+			if (strcmp ((char const *) child->name, "scalar"))
+				continue;
+			char *buf = (char *) xmlGetProp (child, (xmlChar const *) "dictRef");
+			if (buf) {
+				names.insert ((strncmp (buf, "bo:", 3))? buf: buf + 3);
+				xmlFree (buf);
+			}
+		}
+	xmlFreeDoc (xml);
+}
+
+static void dump_value (std::string &out, char const *name, gcu::Value const *value)
+{
+	if (value)
+		append (out, " %s=%s (%.17g)", name, safe (value->GetAsString ()), value->GetAsDouble ());
+}
+
+static void dump_element (std::string &out, gcu::Element *elt, std::set <std::string> const &bodr)
+{
+	unsigned i;
+	double *color = elt->GetDefaultColor ();
+	append (out, "element %d %s %s bonds=%u valence=%d side=%d color=%.17g,%.17g,%.17g ve=%u,%u,%u metallic=%d stable=%d config=%s\n",
+	        elt->GetZ (), elt->GetSymbol (), elt->GetName (), elt->GetMaxBonds (), elt->GetDefaultValence (),
+	        elt->GetBestSide (), color[0], color[1], color[2], elt->GetValenceElectrons (),
+	        elt->GetTotalValenceElectrons (), elt->GetMaxValenceElectrons (), elt->IsMetallic (),
+	        elt->GetStability (), elt->GetElectronicConfiguration ().c_str ());
+	std::map <std::string, std::string> const &names = elt->GetNames ();
+	std::map <std::string, std::string>::const_iterator n, nend = names.end ();
+	for (n = names.begin (); n != nend; n++)
+		append (out, " name %s=%s\n", (*n).first.c_str (), (*n).second.c_str ());
+	out += " weight";
+	dump_value (out, "", elt->GetWeight ());
+	out += '\n';
+	GcuAtomicRadius const **radii = elt->GetRadii ();
+	for (i = 0; radii && radii[i]; i++)
+		append (out, " radius type=%d %.17g prec=%d delta=%d unit=%s charge=%d cn=%d spin=%d scale=%s\n",
+		        radii[i]->type, radii[i]->value.value, radii[i]->value.prec, radii[i]->value.delta,
+		        safe (radii[i]->value.unit), radii[i]->charge, radii[i]->cn, radii[i]->spin,
+		        safe (radii[i]->scale));
+	GcuElectronegativity const **ens = elt->GetElectronegativities ();
+	for (i = 0; ens && ens[i]; i++)
+		append (out, " en %.17g prec=%d delta=%d scale=%s\n", ens[i]->value.value, ens[i]->value.prec,
+		        ens[i]->value.delta, safe (ens[i]->scale));
+	GcuDimensionalValue const *value;
+	for (i = 1; (value = elt->GetIonizationEnergy (i)); i++)
+		append (out, " ionization %u %.17g prec=%d delta=%d unit=%s\n", i, value->value, value->prec,
+		        value->delta, safe (value->unit));
+	for (i = 1; (value = elt->GetElectronAffinity (i)); i++)
+		append (out, " affinity %u %.17g prec=%d delta=%d unit=%s\n", i, value->value, value->prec,
+		        value->delta, safe (value->unit));
+	gcu::IsotopicPattern *pattern = elt->GetIsotopicPattern (1);
+	if (pattern) {
+		double *values;
+		int nb = pattern->GetValues (&values);
+		append (out, " isotopes min=%d mono=%d", pattern->GetMinMass (), pattern->GetMonoNuclNb ());
+		dump_value (out, "mass", &pattern->GetMonoMass ());
+		for (int j = 0; j < nb; j++)
+			append (out, " %.17g", values[j]);
+		out += '\n';
+		delete [] values;
+		pattern->Unref ();
+	}
+	std::set <std::string>::const_iterator p, pend = bodr.end ();
+	for (p = bodr.begin (); p != pend; p++) {
+		char const *name = (*p).c_str ();
+		gcu::Value const *prop = elt->GetProperty (name);
+		std::string const &str = elt->GetStringProperty (name);
+		int integer = elt->GetIntegerProperty (name);
+		if (!prop && str.empty () && integer == GCU_ERROR)
+			continue;
+		append (out, " bodr %s", name);
+		dump_value (out, "value", prop);
+		append (out, " string=%s integer=%d\n", str.c_str (), integer);
+	}
+}
+
+static void dump_group (std::string &out, gcu::SpaceGroup const *group)
+{
+	std::list <gcu::Transform3d*>::const_iterator t;
+	append (out, "group %u/%u %s %s %u\n", group->GetId (), group->GetCoordinateAlternative (),
+	        group->GetHMName ().c_str (), group->GetHallName ().c_str (), group->GetTransformsNumber ());
+	for (gcu::Transform3d const *tr = group->GetFirstTransform (t); tr; tr = group->GetNextTransform (t)) {
+		gcu::Vector o = *tr * gcu::Vector (0., 0., 0.),
+			x = *tr * gcu::Vector (1., 0., 0.), y = *tr * gcu::Vector (0., 1., 0.), z = *tr * gcu::Vector (0., 0., 1.);
+		append (out, " %.17g %.17g %.17g | %.17g %.17g %.17g | %.17g %.17g %.17g | %.17g %.17g %.17g\n",
+		        o.GetX (), o.GetY (), o.GetZ (), x.GetX (), x.GetY (), x.GetZ (),
+		        y.GetX (), y.GetY (), y.GetZ (), z.GetX (), z.GetY (), z.GetZ ());
+	}
+	// the names used to find the group
+	gcu::SpaceGroup const *found = gcu::SpaceGroup::GetSpaceGroup (group->GetHallName ());
+	append (out, " by Hall name: %s\n", (found)? found->GetHallName ().c_str (): "none");
+	found = gcu::SpaceGroup::GetSpaceGroup (group->GetHMName ());
+	append (out, " by HM name: %s\n", (found)? found->GetHallName ().c_str (): "none");
+}
+
+static void dump (std::string &out)
+{
+	std::set <std::string> bodr;
+	get_bodr_names (bodr);
+	gcu::Element::LoadAllData ();
+	for (int Z = 1; Z <= MAX_ELT; Z++) {
+		gcu::Element *elt = gcu::Element::GetElement (Z);
+		if (elt)
+			dump_element (out, elt, bodr);
+	}
+	for (unsigned id = 1; id <= 230; id++) {
+		std::list <gcu::SpaceGroup const *> &groups = gcu::SpaceGroup::GetSpaceGroups (id);
+		std::list <gcu::SpaceGroup const *>::iterator i, iend = groups.end ();
+		for (i = groups.begin (); i != iend; i++)
+			dump_group (out, *i);
+	}
+}
+
+// writes the data loaded from the image on the standard output
+static int dump_image (char const *filename)
+{
+	if (!gcu::DatabaseImage::Use (filename)) {
+		fprintf (stderr, "could not use %s\n", filename);
+		return 1;
+	}
+	std::string out;
+	dump (out);
+	fwrite (out.c_str (), 1, out.length (), stdout);
+	return 0;
+}
+
+static int compare (char const *program)
+{
+	GError *error = NULL;
+	char *filename;
+	int fd = g_file_open_tmp ("gcu-test-db-XXXXXX", &filename, &error);
+	if (fd < 0) {
+		fprintf (stderr, "could not create a temporary file: %s\n", error->message);
+		g_error_free (error);
+		return 1;
+	}
+	close (fd);
+	// the XML files of the build tree are loaded while compiling
+	if (!gcu::DatabaseImage::Compile (DATABASEDIR, filename, &error)) {
+		fprintf (stderr, "could not compile %s: %s\n", filename, (error)? error->message: "unknown error");
+		if (error)
+			g_error_free (error);
+		g_unlink (filename);
+		g_free (filename);
+		return 1;
+	}
+	std::string xml;
+	dump (xml);
+
+	char *argv[] = {const_cast <char *> (program), const_cast <char *> ("--image"), filename, NULL};
+	char *output = NULL;
+	int status = 0, res = 0;
+	if (xml.find ("element 6 C ") == std::string::npos || xml.find ("group 225/") == std::string::npos) {
+		fprintf (stderr, "the XML databases are incomplete\n");
+		res = 1;
+	} else if (!g_spawn_sync (NULL, argv, NULL, G_SPAWN_SEARCH_PATH, NULL, NULL, &output, NULL, &status, &error)) {
+		fprintf (stderr, "could not run %s: %s\n", program, error->message);
+		g_error_free (error);
+		res = 1;
+	} else if (!g_spawn_check_exit_status (status, NULL)) {
+		fprintf (stderr, "loading the image failed\n");
+		res = 1;
+	} else if (xml != output) {
+		// show the first difference
+		char const *a = xml.c_str (), *b = output;
+		unsigned line = 1;
+		while (*a && *a == *b) {
+			if (*a == '\n')
+				line++;
+			a++;
+			b++;
+		}
+		fprintf (stderr, "the image differs from the XML databases at line %u\n", line);
+		res = 1;
+	}
+	g_free (output);
+	g_unlink (filename);
+	g_free (filename);
+	return res;
+}
+
+// loads all data from the XML files or from the image, and prints the time used
+static int time_loading (bool xml)
+{
+	GTimer *timer = g_timer_new ();
+	if (xml)
+		gcu::DatabaseImage::Disable ();
+	else if (!gcu::DatabaseImage::Get ()) {
+		fprintf (stderr, "no database image is installed\n");
+		g_timer_destroy (timer);
+		return 1;
+	}
+	gcu::Element::LoadAllData ();
+	for (int Z = 1; Z <= MAX_ELT; Z++)
+		gcu::Element::GetElement (Z);
+	gcu::SpaceGroup::GetSpaceGroup ("F m -3 m");
+	char buf[G_ASCII_DTOSTR_BUF_SIZE];
+	printf ("%s\n", g_ascii_dtostr (buf, sizeof (buf), g_timer_elapsed (timer, NULL)));
+	g_timer_destroy (timer);
+	return 0;
+}
+
+/* runs the program several times for each source of data, each run loading
+ everything in a new process, and prints the best and mean times */
+static int bench (char const *program, int runs)
+{
+	char const *sources[] = {"xml", "image"};
+	double best[2], mean[2];
+	for (int s = 0; s < 2; s++) {
+		best[s] = G_MAXDOUBLE;
+		mean[s] = 0.;
+		for (int i = 0; i < runs; i++) {
+			char *argv[] = {const_cast <char *> (program), const_cast <char *> ("--time"), const_cast <char *> (sources[s]), NULL};
+			char *output = NULL;
+			int status = 0;
+			GError *error = NULL;
+			if (!g_spawn_sync (NULL, argv, NULL, G_SPAWN_SEARCH_PATH, NULL, NULL, &output, NULL, &status, &error)) {
+				fprintf (stderr, "could not run %s: %s\n", program, error->message);
+				g_error_free (error);
+				return 1;
+			}
+			if (!g_spawn_check_exit_status (status, NULL)) {
+				fprintf (stderr, "loading the %s data failed\n", sources[s]);
+				g_free (output);
+				return 1;
+			}
+			double t = g_ascii_strtod (output, NULL);
+			g_free (output);
+			if (t < best[s])
+				best[s] = t;
+			mean[s] += t / runs;
+		}
+		printf ("%s: best %g s, mean %g s over %d runs\n", sources[s], best[s], mean[s], runs);
+	}
+	if (best[1] > 0.)
+		printf ("the image loads %.1f times faster\n", best[0] / best[1]);
+	return 0;
+}
+
+/*!
+\a main function of the test. With --bench as first argument, it compares the
+loading times of the installed data, the number of runs for each source might
+be given as second argument.
+*/
+int main (int argc, char *argv[])
+{
+	int res;
+	libgoffice_init ();
+	if (argc == 3 && !strcmp (argv[1], "--image"))
+		res = dump_image (argv[2]);
+	else if (argc == 3 && !strcmp (argv[1], "--time"))
+		res = time_loading (!strcmp (argv[2], "xml"));
+	else if (argc > 1 && !strcmp (argv[1], "--bench"))
+		res = bench (argv[0], (argc > 2)? MAX (atoi (argv[2]), 1): 5);
+	else
+		res = compare (argv[0]);
+	libgoffice_shutdown ();
+	return res;
+}
@@ -0,0 +1,164 @@
+/*
+ * Gnome Chemisty Utils
+ * tests/testgcudocumentids.cc
+ *
+ * Copyright (C) 2026 Jean Bréfort <jean.brefort@normalesup.org>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301
+ * USA
+ */
+
+#include "config.h"
+#include "check.h"
+#include <gcu/atom.h>
+#include <gcu/bond.h>
+#include <gcu/document.h>
+#include <gcu/molecule.h>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+/*!\file
+Tests the Ids index of gcu::Document: lookups after adding, renaming,
+reparenting and removing objects, and after duplicate Ids were indexed. Also
+checks that automatic Ids are not reused and that objects can't be added outside
+a document.
+*/
+
+#define NB_ATOMS 1000
+
+static gcu::Object *find (gcu::Object *parent, char const *format, int n)
+{
+	char buf[32];
+	snprintf (buf, sizeof (buf), format, n);
+	return parent->GetDescendant (buf);
+}
+
+int main ()
+{
+	int i;
+	char buf[32];
+	gcu::Document *doc = new gcu::Document (NULL);
+	std::vector < gcu::Atom * > atoms (NB_ATOMS);
+
+	// explicit Ids, the way loaders add objects
+	for (i = 0; i < NB_ATOMS; i++) {
+		atoms[i] = new gcu::Atom (6, i * 1.5, 0., 0.);
+		snprintf (buf, sizeof (buf), "a%d", i + 1);
+		atoms[i]->SetId (buf);
+		doc->AddChild (atoms[i]);
+	}
+	// bonds only between atoms which are not moved or deleted below
+	for (i = NB_ATOMS / 2; i < NB_ATOMS; i++) {
+		gcu::Bond *bond = new gcu::Bond (atoms[i - 1], atoms[i], 1);
+		snprintf (buf, sizeof (buf), "b%d", i);
+		bond->SetId (buf);
+		doc->AddChild (bond);
+	}
+	for (i = 0; i < NB_ATOMS; i++)
+		CHECK (find (doc, "a%d", i + 1) == atoms[i]);
+	CHECK (find (doc, "b%d", NB_ATOMS - 1) != NULL);
+	CHECK (doc->GetDescendant ("a0") == NULL);
+
+	// automatic Ids must not reuse existing ones
+	gcu::Atom *h1 = new gcu::Atom (1, 0., 1., 0.), *h2 = new gcu::Atom (1, 0., 2., 0.);
+	doc->AddChild (h1);
+	doc->AddChild (h2);
+	CHECK (h1->GetId () && h2->GetId () && strcmp (h1->GetId (), h2->GetId ()));
+	CHECK (doc->GetDescendant (h1->GetId ()) == h1);
+	CHECK (doc->GetDescendant (h2->GetId ()) == h2);
+	// nor the Id of a removed object
+	std::string old_id = h2->GetId ();
+	delete h2;
+	h2 = new gcu::Atom (1, 0., 3., 0.);
+	doc->AddChild (h2);
+	CHECK (old_id != h2->GetId () && strcmp (h1->GetId (), h2->GetId ()));
+
+	// nothing can be added outside a document, but Ids might still change there
+	gcu::Object *lone = new gcu::Object ();
+	gcu::Atom *c = new gcu::Atom (6, 0., 4., 0.);
+	lone->AddChild (c);
+	CHECK (c->GetParent () == NULL && c->GetId () == NULL);
+	doc->AddChild (lone);
+	lone->AddChild (c);
+	lone->SetParent (NULL);
+	CHECK (doc->GetDescendant (c->GetId ()) == NULL);
+	c->SetId ("lone");
+	CHECK (c->GetParent () == lone && lone->GetChild ("lone") == c);
+	delete lone;
+
+	// rename
+	atoms[0]->SetId ("renamed");
+	CHECK (doc->GetDescendant ("a1") == NULL);
+	CHECK (doc->GetDescendant ("renamed") == atoms[0]);
+	atoms[0]->SetId ("a1");
+	CHECK (doc->GetDescendant ("renamed") == NULL);
+	CHECK (doc->GetDescendant ("a1") == atoms[0]);
+
+	// reparent inside the document, the atom is then only a descendant of its new parent
+	gcu::Molecule *mol = new gcu::Molecule ();
+	mol->SetId ("m1");
+	doc->AddChild (mol);
+	mol->AddChild (atoms[1]);
+	CHECK (doc->GetDescendant ("a2") == atoms[1]);
+	CHECK (mol->GetDescendant ("a2") == atoms[1]);
+	CHECK (mol->GetDescendant ("a3") == NULL);
+	CHECK (atoms[1]->GetParent () == mol);
+
+	// move to another document
+	gcu::Document *doc2 = new gcu::Document (NULL);
+	doc2->AddChild (atoms[2]);
+	CHECK (doc->GetDescendant ("a3") == NULL);
+	CHECK (doc2->GetDescendant ("a3") == atoms[2]);
+	CHECK (!doc->HasDuplicateIds () && !doc2->HasDuplicateIds ());
+
+	// remove
+	delete atoms[3];
+	CHECK (doc->GetDescendant ("a4") == NULL);
+	CHECK (doc->GetDescendant ("a5") == atoms[4]);
+
+	// a subtree moved from another document might bring duplicate Ids
+	gcu::Molecule *mol2 = new gcu::Molecule ();
+	mol2->SetId ("m2");
+	doc2->AddChild (mol2);
+	gcu::Atom *dup = new gcu::Atom (8, 0., 0., 1.);
+	dup->SetId ("a5");
+	mol2->AddChild (dup);
+	doc->AddChild (mol2);
+	CHECK (doc->HasDuplicateIds ());
+	CHECK (doc->GetDescendant ("a5") != NULL);
+	CHECK (mol2->GetDescendant ("a5") == dup);
+	// once the duplicate is gone, the index must be used again
+	delete mol2;
+	CHECK (!doc->HasDuplicateIds ());
+	CHECK (doc->GetDescendant ("a5") == atoms[4]);
+	// the same when the first indexed object is the one removed
+	mol2 = new gcu::Molecule ();
+	mol2->SetId ("m3");
+	doc2->AddChild (mol2);
+	dup = new gcu::Atom (8, 0., 0., 1.);
+	dup->SetId ("a6");
+	mol2->AddChild (dup);
+	doc->AddChild (mol2);
+	CHECK (doc->HasDuplicateIds ());
+	delete atoms[5];
+	CHECK (!doc->HasDuplicateIds ());
+	CHECK (doc->GetDescendant ("a6") == dup);
+
+	delete doc2;
+	delete doc;
+	return 0;
+}
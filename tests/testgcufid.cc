@@ -0,0 +1,178 @@
+/*
+ * Gnome Chemisty Utils
+ * tests/testgcufid.cc
+ *
+ * Copyright (C) 2026 Jean Bréfort <jean.brefort@normalesup.org>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301
+ * USA
+ */
+
+#include "config.h"
+#include "check.h"
+#include <gcu/fid.h>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+/*!\file
+Tests gcu::FFTPlan against a direct Fourier transform, and gcu::FidProcessor
+on a synthetic FID with two lines at known frequencies and phase.
+*/
+
+#define NPOINTS 1024
+#define DWELL 1e-3
+// frequencies falling exactly on points of the transform, in Hz
+#define FREQ1 125.
+#define FREQ2 -62.5
+#define PHASE (30. * M_PI / 180.)
+
+// the index of a frequency in the transformed data, ordered from the highest
+// to the lowest frequency
+static unsigned index_of (double freq, unsigned n)
+{
+	int k = static_cast < int > (floor (freq * n * DWELL + .5));
+	return n / 2 - 1 - k;
+}
+
+static unsigned max_index (double const *values, unsigned n)
+{
+	unsigned i, res = 0;
+	for (i = 1; i < n; i++)
+		if (fabs (values[i]) > fabs (values[res]))
+			res = i;
+	return res;
+}
+
+static int test_fft ()
+{
+	unsigned i, k, n = 16;
+	std::vector < double > re (n), im (n), dre (n), dim (n);
+	for (i = 0; i < n; i++) {
+		re[i] = static_cast < double > (rand ()) / RAND_MAX - .5;
+		im[i] = static_cast < double > (rand ()) / RAND_MAX - .5;
+	}
+	// direct transform with the same sign convention
+	for (k = 0; k < n; k++) {
+		dre[k] = dim[k] = 0.;
+		for (i = 0; i < n; i++) {
+			double a = -2. * M_PI * i * k / n;
+			dre[k] += re[i] * cos (a) - im[i] * sin (a);
+			dim[k] += re[i] * sin (a) + im[i] * cos (a);
+		}
+	}
+	gcu::FFTPlan plan (n);
+	CHECK (plan.GetSize () == n);
+	plan.Execute (&re[0], &im[0]);
+	for (k = 0; k < n; k++) {
+		CHECK (fabs (re[k] - dre[k]) < 1e-10);
+		CHECK (fabs (im[k] - dim[k]) < 1e-10);
+	}
+	// the same plan used again: a unit impulse gives a flat spectrum
+	re.assign (n, 0.);
+	im.assign (n, 0.);
+	re[0] = 1.;
+	plan.Execute (&re[0], &im[0]);
+	for (k = 0; k < n; k++)
+		CHECK (fabs (re[k] - 1.) < 1e-12 && fabs (im[k]) < 1e-12);
+	return 0;
+}
+
+int main ()
+{
+	if (test_fft ())
+		return 1;
+
+	// two lines with the same phase, and a smaller amplitude for the second
+	std::vector < double > re (NPOINTS), im (NPOINTS);
+	unsigned i;
+	for (i = 0; i < NPOINTS; i++) {
+		double t = i * DWELL;
+		double a1 = 2. * M_PI * FREQ1 * t + PHASE, a2 = 2. * M_PI * FREQ2 * t + PHASE;
+		re[i] = cos (a1) + .5 * cos (a2);
+		im[i] = sin (a1) + .5 * sin (a2);
+	}
+	gcu::FidProcessor fid;
+	fid.SetFID (&re[0], &im[0], NPOINTS, DWELL);
+	CHECK (fid.GetSize () == NPOINTS);
+	unsigned i1 = index_of (FREQ1, NPOINTS), i2 = index_of (FREQ2, NPOINTS);
+	// the unphased spectrum: the lines have the expected positions and phase
+	double const *sre = fid.GetReal (), *sim = fid.GetImaginary ();
+	std::vector < double > modulus (NPOINTS);
+	for (i = 0; i < NPOINTS; i++)
+		modulus[i] = sqrt (sre[i] * sre[i] + sim[i] * sim[i]);
+	CHECK (max_index (&modulus[0], NPOINTS) == i1);
+	CHECK (fabs (modulus[i1] - NPOINTS) < 1e-6 * NPOINTS);
+	CHECK (fabs (modulus[i2] - NPOINTS / 2) < 1e-6 * NPOINTS);
+	CHECK (fabs (atan2 (sim[i1], sre[i1]) - PHASE) < 1e-6);
+	CHECK (fabs (atan2 (sim[i2], sre[i2]) - PHASE) < 1e-6);
+
+	// removing the phase gives pure absorption lines
+	fid.SetPhase (-PHASE, 0.);
+	double const *pre = fid.GetPhasedReal (), *pim = fid.GetPhasedImaginary ();
+	CHECK (fabs (pre[i1] - NPOINTS) < 1e-6 * NPOINTS && fabs (pim[i1]) < 1e-6 * NPOINTS);
+	CHECK (fabs (pre[i2] - NPOINTS / 2) < 1e-6 * NPOINTS && fabs (pim[i2]) < 1e-6 * NPOINTS);
+	// changing the phase does not transform again
+	CHECK (fid.GetReal () == sre);
+
+	// the zero order phase is reduced to ]-pi, pi]
+	fid.SetPhase (2. * M_PI - PHASE, 0.);
+	CHECK (fabs (fid.GetPhase0 () + PHASE) < 1e-12);
+	CHECK (fabs (fid.GetPhasedReal ()[i1] - NPOINTS) < 1e-6 * NPOINTS);
+	fid.SetPhase (-M_PI, 0.);
+	CHECK (fabs (fid.GetPhase0 () - M_PI) < 1e-12);
+	fid.SetPhase (7. * M_PI / 2., 1.);
+	CHECK (fabs (fid.GetPhase0 () + M_PI / 2.) < 1e-12);
+	CHECK (fid.GetPhase1 () == 1.);
+
+	// the automatic phase finds the phase of the lines
+	fid.AutoPhase ();
+	CHECK (fid.GetPhase0 () > -M_PI && fid.GetPhase0 () <= M_PI);
+	CHECK (fabs (fid.GetPhase0 () + PHASE) < 2. * M_PI / 180.);
+	CHECK (fabs (fid.GetPhase1 ()) < 2. * M_PI / 180.);
+	pre = fid.GetPhasedReal ();
+	CHECK (pre[i1] > .99 * NPOINTS && pre[i2] > .99 * NPOINTS / 2);
+
+	// zero filling doubles the size and moves the lines accordingly
+	fid.SetZeroFill (2);
+	CHECK (fid.GetSize () == 2 * NPOINTS);
+	i1 = index_of (FREQ1, 2 * NPOINTS);
+	i2 = index_of (FREQ2, 2 * NPOINTS);
+	sre = fid.GetReal ();
+	sim = fid.GetImaginary ();
+	modulus.resize (2 * NPOINTS);
+	for (i = 0; i < 2 * NPOINTS; i++)
+		modulus[i] = sqrt (sre[i] * sre[i] + sim[i] * sim[i]);
+	CHECK (max_index (&modulus[0], 2 * NPOINTS) == i1);
+	CHECK (fabs (modulus[i1] - NPOINTS) < 1e-6 * NPOINTS);
+	CHECK (fabs (modulus[i2] - NPOINTS / 2) < 1e-6 * NPOINTS);
+
+	// an exponential window lowers the lines but does not move them
+	fid.SetZeroFill (1);
+	fid.SetWindow (gcu::FID_WINDOW_EXPONENTIAL, 1.);
+	i1 = index_of (FREQ1, NPOINTS);
+	sre = fid.GetReal ();
+	sim = fid.GetImaginary ();
+	for (i = 0; i < NPOINTS; i++)
+		modulus[i] = sqrt (sre[i] * sre[i] + sim[i] * sim[i]);
+	CHECK (max_index (&modulus[0], NPOINTS) == i1);
+	double expected = 0.;
+	for (i = 0; i < NPOINTS; i++)
+		expected += exp (-M_PI * i * DWELL);
+	// the second line only adds a small tail
+	CHECK (fabs (modulus[i1] - expected) < .01 * expected);
+	return 0;
+}
@@ -0,0 +1,170 @@
+/*
+ * Gnome Chemisty Utils
+ * tests/testgcuglbatch.cc
+ *
+ * Copyright (C) 2026 Jean Bréfort <jean.brefort@normalesup.org>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301
+ * USA
+ */
+
+#include "config.h"
+#include "check.h"
+#define GL_GLEXT_PROTOTYPES
+#include <gcu/geometry-cache.h>
+#include <gcu/glbatch.h>
+#include <gcu/matrix.h>
+#include <gcu/vector.h>
+#include <GL/osmesa.h>
+#include <GL/gl.h>
+#include <GL/glext.h>
+#include <cstdio>
+#include <vector>
+
+/*!\file
+Renders a gcu::GLBatch into an off screen OSMesa buffer, and checks the levels
+of detail selected by gcu::GeometryCache and the release of the buffer objects.
+*/
+
+#define SIZE 64
+
+static unsigned count_buffers ()
+{
+	unsigned n = 0;
+	for (GLuint id = 1; id < 64; id++)
+		if (glIsBuffer (id))
+			n++;
+	return n;
+}
+
+static void read_pixel (int x, int y, unsigned char *rgba)
+{
+	glReadPixels (x, y, 1, 1, GL_RGBA, GL_UNSIGNED_BYTE, rgba);
+}
+
+int main ()
+{
+	std::vector < unsigned char > pixels (4 * SIZE * SIZE);
+	OSMesaContext ctxt = OSMesaCreateContextExt (OSMESA_RGBA, 16, 0, 0, NULL);
+	if (!ctxt || !OSMesaMakeCurrent (ctxt, &pixels[0], GL_UNSIGNED_BYTE, SIZE, SIZE)) {
+		fprintf (stderr, "could not create an OSMesa context, skipping\n");
+		return 77;
+	}
+	gcu::GeometryCache::SetCurrentContext (ctxt);
+	int major = 1, minor = 0;
+	char const *version = reinterpret_cast < char const * > (glGetString (GL_VERSION));
+	if (version)
+		sscanf (version, "%d.%d", &major, &minor);
+	bool buffers = major > 1 || minor >= 5;
+
+	// levels of detail with an orthographic projection, 3.2 pixels per unit
+	glViewport (0, 0, SIZE, SIZE);
+	glMatrixMode (GL_PROJECTION);
+	glLoadIdentity ();
+	glOrtho (-10., 10., -10., 10., -100., 100.);
+	glMatrixMode (GL_MODELVIEW);
+	glLoadIdentity ();
+	gcu::Vector origin (0., 0., 0.), end (5., 0., 0.);
+	{
+		gcu::GeometryCache cache;
+		CHECK (cache.GetSphereLevel (origin, .5) == 0);
+		CHECK (cache.GetSphereLevel (origin, 2.) == 1);
+		CHECK (cache.GetSphereLevel (origin, 5.) == 2);
+		CHECK (cache.GetSphereLevel (origin, 20.) == gcu::GeometryCache::SphereLevels - 1);
+		CHECK (cache.GetCylinderLevel (origin, end, .5) == 0);
+		CHECK (cache.GetCylinderLevel (origin, end, 5.) == gcu::GeometryCache::CylinderLevels - 1);
+		gcu::GeometryCache same;
+		CHECK (cache.IsCloseTo (same));
+		glViewport (0, 0, 2 * SIZE, 2 * SIZE);
+		gcu::GeometryCache larger;
+		CHECK (!cache.IsCloseTo (larger));
+		CHECK (larger.GetSphereLevel (origin, .5) == 1);
+		glViewport (0, 0, SIZE, SIZE);
+	}
+
+	// with a perspective, a batch must use the nearest position a rotation can give
+	glMatrixMode (GL_PROJECTION);
+	glLoadIdentity ();
+	glFrustum (-1., 1., -1., 1., 1., 100.);
+	glMatrixMode (GL_MODELVIEW);
+	glLoadIdentity ();
+	glTranslated (0., 0., -50.);
+	{
+		gcu::GeometryCache cache;
+		gcu::Vector far (0., 0., -40.);
+		CHECK (cache.GetSphereLevel (far, 1.) == 0);
+		CHECK (cache.GetSphereLevel (far, 1., true) == 1);
+	}
+
+	// render a red sphere and a green cylinder
+	glMatrixMode (GL_PROJECTION);
+	glLoadIdentity ();
+	glOrtho (-10., 10., -10., 10., -100., 100.);
+	glMatrixMode (GL_MODELVIEW);
+	glLoadIdentity ();
+	glDisable (GL_LIGHTING);
+	glEnable (GL_DEPTH_TEST);
+	glClearColor (0., 0., 0., 1.);
+	glClear (GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+	gcu::GeometryCache cache;
+	gcu::GLBatch *batch = new gcu::GLBatch ();
+	CHECK (!batch->IsValid (cache));
+	batch->Reserve (1, 1);
+	batch->SetProjection (cache);
+	batch->AddSphere (origin, 5., 1., 0., 0.);
+	batch->AddCylinder (gcu::Vector (-8., 7., 0.), gcu::Vector (8., 7., 0.), 1., 0., 1., 0.);
+	CHECK (batch->IsValid (cache));
+	batch->Draw (gcu::Matrix (1.));
+	glFinish ();
+	unsigned char rgba[4];
+	read_pixel (SIZE / 2, SIZE / 2, rgba);
+	CHECK (rgba[0] > 200 && rgba[1] < 50 && rgba[2] < 50);
+	read_pixel (SIZE / 2, (7 + 10) * SIZE / 20, rgba);
+	CHECK (rgba[0] < 50 && rgba[1] > 200 && rgba[2] < 50);
+	read_pixel (2, 2, rgba);
+	CHECK (rgba[0] < 50 && rgba[1] < 50 && rgba[2] < 50);
+
+	// a rotation only changes the matrix, the sphere stays at the center
+	glClear (GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+	batch->Draw (gcu::Matrix (0., 1.5707963267948966, 0., gcu::euler));
+	glFinish ();
+	read_pixel (SIZE / 2, SIZE / 2, rgba);
+	CHECK (rgba[0] > 200 && rgba[1] < 50);
+	batch->Clear ();
+	CHECK (!batch->IsValid (cache));
+
+	if (buffers) {
+		batch->AddSphere (origin, 5., 1., 0., 0.);
+		batch->Draw (gcu::Matrix (1.));
+		unsigned n = count_buffers ();
+		CHECK (n >= 3);
+		// buffers of a destroyed batch are deleted the next time a batch is drawn
+		gcu::GLBatch *other = new gcu::GLBatch ();
+		other->AddSphere (origin, 1., 0., 0., 1.);
+		other->Draw (gcu::Matrix (1.));
+		CHECK (count_buffers () == n + 3);
+		delete other;
+		batch->Draw (gcu::Matrix (1.));
+		CHECK (count_buffers () == n);
+		// releasing the context deletes everything
+		gcu::GeometryCache::ReleaseContext (ctxt);
+		CHECK (count_buffers () == 0);
+	} else
+		gcu::GeometryCache::ReleaseContext (ctxt);
+
+	delete batch;
+	OSMesaDestroyContext (ctxt);
+	return 0;
+}
@@ -0,0 +1,389 @@
+/*
+ * Gnome Chemisty Utils
+ * tests/testgcurings.cc
+ *
+ * Copyright (C) 2026 Jean Bréfort <jean.brefort@normalesup.org>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301
+ * USA
+ */
+
+#include "config.h"
+#include "check.h"
+#include <gcu/atom.h>
+#include <gcu/bond.h>
+#include <gcu/cycle.h>
+#include <gcu/document.h>
+#include <gcu/molecule.h>
+#include <glib.h>
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <list>
+#include <map>
+#include <set>
+#include <vector>
+
+/*!\file
+Tests the cycles perception in gcu::Molecule, and the update of the cycles
+when a bond is removed or added.
+
+With --bench, times the perception instead.
+*/
+
+#define SHEET_SIZE 20
+
+static std::vector < gcu::Atom * > atoms;
+static std::vector < gcu::Bond * > bonds;
+
+static void add_atoms (gcu::Document *doc, int n)
+{
+	char buf[32];
+	atoms.resize (n);
+	for (int i = 0; i < n; i++) {
+		atoms[i] = new gcu::Atom (6, i * 1.5, 0., 0.);
+		snprintf (buf, sizeof (buf), "a%d", i + 1);
+		atoms[i]->SetId (buf);
+		doc->AddChild (atoms[i]);
+	}
+	bonds.clear ();
+}
+
+static gcu::Bond *new_bond (int i, int j)
+{
+	char buf[32];
+	gcu::Bond *bond = new gcu::Bond (atoms[i], atoms[j], 1);
+	snprintf (buf, sizeof (buf), "b%u", static_cast < unsigned > (bonds.size () + 1));
+	bond->SetId (buf);
+	bonds.push_back (bond);
+	return bond;
+}
+
+static void add_bond (gcu::Document *doc, int i, int j)
+{
+	doc->AddChild (new_bond (i, j));
+}
+
+// the cycles of the molecule, found through their bonds
+static std::set < gcu::Cycle * > get_cycles ()
+{
+	std::set < gcu::Cycle * > cycles;
+	std::list < gcu::Cycle * >::iterator j;
+	for (unsigned i = 0; i < bonds.size (); i++) {
+		if (!bonds[i]->IsCyclic ())
+			continue;
+		for (gcu::Cycle *cycle = bonds[i]->GetFirstCycle (j, NULL); cycle; cycle = bonds[i]->GetNextCycle (j, NULL))
+			cycles.insert (cycle);
+	}
+	return cycles;
+}
+
+// checks that the cycles are closed rings of bonded atoms, and that there are
+// sizes[n] cycles of n atoms
+static bool check_cycles (gcu::Molecule *mol, std::map < unsigned, unsigned > const &sizes)
+{
+	std::set < gcu::Cycle * > cycles = get_cycles ();
+	std::set < gcu::Cycle * >::iterator i;
+	std::map < unsigned, unsigned > found;
+	if (cycles.size () != mol->GetCyclesNumber ()) {
+		fprintf (stderr, "%u cycles in the molecule, %u found through the bonds\n", mol->GetCyclesNumber (), static_cast < unsigned > (cycles.size ()));
+		return false;
+	}
+	for (i = cycles.begin (); i != cycles.end (); i++) {
+		gcu::Cycle *cycle = *i;
+		unsigned j, length = cycle->GetLength ();
+		gcu::Atom *first = cycle->GetFirstAtom (), *atom = first, *next;
+		for (j = 0; j < length; j++) {
+			next = cycle->GetNextAtom (atom);
+			gcu::Bond *bond = atom->GetBond (next);
+			if (!bond || !bond->IsInCycle (cycle) || (j + 1 < length && next == first)) {
+				fprintf (stderr, "a cycle of %u atoms is not a closed ring\n", length);
+				return false;
+			}
+			atom = next;
+		}
+		if (atom != first) {
+			fprintf (stderr, "a cycle of %u atoms is not a closed ring\n", length);
+			return false;
+		}
+		found[length]++;
+	}
+	if (found != sizes) {
+		std::map < unsigned, unsigned >::iterator k;
+		fprintf (stderr, "cycles found:");
+		for (k = found.begin (); k != found.end (); k++)
+			fprintf (stderr, " %u of %u atoms", (*k).second, (*k).first);
+		fprintf (stderr, "\n");
+		return false;
+	}
+	return true;
+}
+
+// the truncated icosahedron atoms are the oriented edges of an icosahedron
+static void build_fullerene (gcu::Document *doc)
+{
+	double p = (1. + sqrt (5.)) / 2., v[12][3] = {
+		{0., 1., p}, {0., -1., p}, {0., 1., -p}, {0., -1., -p},
+		{1., p, 0.}, {-1., p, 0.}, {1., -p, 0.}, {-1., -p, 0.},
+		{p, 0., 1.}, {-p, 0., 1.}, {p, 0., -1.}, {-p, 0., -1.}};
+	bool adj[12][12];
+	std::map < std::pair < int, int >, int > ids;
+	int i, j, k, d, n = 0;
+	for (i = 0; i < 12; i++)
+		for (j = 0; j < 12; j++) {
+			double d2 = 0.;
+			for (k = 0; k < 3; k++)
+				d2 += (v[i][k] - v[j][k]) * (v[i][k] - v[j][k]);
+			adj[i][j] = fabs (d2 - 4.) < 1e-6;
+			if (adj[i][j])
+				ids[std::make_pair (i, j)] = n++;
+		}
+	add_atoms (doc, n);
+	for (i = 0; i < 12; i++)
+		for (j = 0; j < 12; j++) {
+			if (!adj[i][j])
+				continue;
+			d = ids[std::make_pair (i, j)];
+			if (i < j)
+				add_bond (doc, d, ids[std::make_pair (j, i)]);
+			// the pentagon around i
+			for (k = j + 1; k < 12; k++)
+				if (adj[i][k] && adj[j][k])
+					add_bond (doc, d, ids[std::make_pair (i, k)]);
+		}
+}
+
+// 7 pyranose rings linked by oxygen bridges, with a methyl on the first ring
+static void build_cyclodextrin (gcu::Document *doc)
+{
+	int i, j;
+	add_atoms (doc, 7 * 7 + 1);
+	for (i = 0; i < 7; i++) {
+		for (j = 0; j < 6; j++)
+			add_bond (doc, i * 7 + j, i * 7 + (j + 1) % 6);
+		add_bond (doc, i * 7, i * 7 + 6);
+		add_bond (doc, i * 7 + 6, (i + 1) % 7 * 7 + 3);
+	}
+	add_bond (doc, 1, 7 * 7);
+}
+
+// a hexagonal sheet drawn as a brick wall, the atoms at the ends of the first
+// and last rows have only one bond
+static void build_sheet (gcu::Document *doc, int width, int height)
+{
+	int x, y;
+	add_atoms (doc, width * height);
+	for (y = 0; y < height; y++)
+		for (x = 0; x < width; x++) {
+			if (x + 1 < width)
+				add_bond (doc, y * width + x, y * width + x + 1);
+			if (y + 1 < height && (x + y) % 2 == 0)
+				add_bond (doc, y * width + x, (y + 1) * width + x);
+		}
+}
+
+static gcu::Bond *get_bond (int i, int j)
+{
+	return atoms[i]->GetBond (atoms[j]);
+}
+
+static int test_fullerene ()
+{
+	gcu::Document *doc = new gcu::Document (NULL);
+	build_fullerene (doc);
+	CHECK (atoms.size () == 60 && bonds.size () == 90);
+	gcu::Molecule *mol = new gcu::Molecule (atoms[0]);
+	CHECK (mol->GetAtomsNumber () == 60 && mol->GetBondsNumber () == 90);
+	// the 12 pentagons and all hexagons but one, which depends on the others
+	std::map < unsigned, unsigned > sizes;
+	sizes[5] = 12;
+	sizes[6] = 19;
+	CHECK (check_cycles (mol, sizes));
+	// each atom is in exactly one pentagon, and each bond in a cycle
+	std::set < gcu::Cycle * > cycles = get_cycles ();
+	std::set < gcu::Cycle * >::iterator i;
+	std::set < gcu::Atom * > in_pentagons;
+	for (i = cycles.begin (); i != cycles.end (); i++)
+		if ((*i)->GetLength () == 5)
+			for (unsigned j = 0; j < atoms.size (); j++)
+				if ((*i)->Contains (atoms[j])) {
+					CHECK (in_pentagons.find (atoms[j]) == in_pentagons.end ());
+					in_pentagons.insert (atoms[j]);
+				}
+	CHECK (in_pentagons.size () == 60);
+	for (unsigned j = 0; j < bonds.size (); j++)
+		CHECK (bonds[j]->IsCyclic () > 0);
+	delete doc;
+	return 0;
+}
+
+static int test_cyclodextrin ()
+{
+	gcu::Document *doc = new gcu::Document (NULL);
+	build_cyclodextrin (doc);
+	gcu::Molecule *mol = new gcu::Molecule (atoms[0]);
+	// the pyranose rings and the macrocycle, 5 bonds long for each unit
+	std::map < unsigned, unsigned > sizes;
+	sizes[6] = 7;
+	sizes[35] = 1;
+	CHECK (check_cycles (mol, sizes));
+	std::set < gcu::Cycle * > cycles = get_cycles ();
+	std::set < gcu::Cycle * >::iterator c;
+	gcu::Cycle *macrocycle = NULL;
+	for (c = cycles.begin (); c != cycles.end (); c++)
+		if ((*c)->GetLength () == 35)
+			macrocycle = *c;
+	CHECK (macrocycle != NULL);
+	for (int i = 0; i < 7; i++) {
+		// the macrocycle goes through half of each pyranose ring
+		unsigned shared = 0;
+		for (int j = 0; j < 6; j++) {
+			gcu::Bond *bond = get_bond (i * 7 + j, i * 7 + (j + 1) % 6);
+			if (bond->IsInCycle (macrocycle)) {
+				CHECK (bond->IsCyclic () == 2);
+				shared++;
+			} else
+				CHECK (bond->IsCyclic () == 1);
+		}
+		CHECK (shared == 3);
+		// the bridges are only in the macrocycle
+		CHECK (get_bond (i * 7, i * 7 + 6)->IsCyclic () == 1);
+		CHECK (get_bond (i * 7, i * 7 + 6)->IsInCycle (macrocycle));
+		CHECK (get_bond (i * 7 + 6, (i + 1) % 7 * 7 + 3)->IsInCycle (macrocycle));
+		CHECK (macrocycle->Contains (atoms[i * 7 + 6]));
+		CHECK (macrocycle->Contains (atoms[i * 7]) && macrocycle->Contains (atoms[i * 7 + 3]));
+	}
+	// the methyl is not in a cycle
+	CHECK (get_bond (1, 7 * 7)->IsCyclic () == 0);
+	CHECK (!macrocycle->Contains (atoms[7 * 7]));
+	delete doc;
+	return 0;
+}
+
+static int test_sheet ()
+{
+	int width = SHEET_SIZE, y = SHEET_SIZE / 2, x = SHEET_SIZE / 2 - 1;
+	gcu::Document *doc = new gcu::Document (NULL);
+	build_sheet (doc, width, width);
+	gcu::Molecule *mol = new gcu::Molecule (atoms[0]);
+	unsigned n = bonds.size () - atoms.size () + 1;
+	std::map < unsigned, unsigned > sizes;
+	sizes[6] = n;
+	CHECK (check_cycles (mol, sizes));
+	// the bonds at the end of the first and last rows are not in a cycle
+	CHECK (get_bond (width - 2, width - 1)->IsCyclic () == 0);
+	CHECK (get_bond (width * width - 2, width * width - 1)->IsCyclic () == 0);
+	CHECK (get_bond (0, 1)->IsCyclic () == 1);
+
+	// removing a bond in the middle of the sheet merges two hexagons
+	gcu::Bond *bond = get_bond (y * width + x, y * width + x + 1);
+	CHECK (bond->IsCyclic () == 2);
+	gcu::Atom *atom0 = bond->GetAtom (0), *atom1 = bond->GetAtom (1);
+	atom0->RemoveBond (bond);
+	atom1->RemoveBond (bond);
+	mol->Remove (bond);
+	mol->UpdateCycles (bond);
+	CHECK (bond->IsCyclic () == 0);
+	bonds.erase (std::find (bonds.begin (), bonds.end (), bond));
+	sizes[6] = n - 2;
+	sizes[10] = 1;
+	CHECK (check_cycles (mol, sizes));
+
+	// adding it again splits the ring
+	atom0->AddBond (bond);
+	atom1->AddBond (bond);
+	mol->AddBond (bond);
+	mol->UpdateCycles (bond);
+	bonds.push_back (bond);
+	sizes.erase (10);
+	sizes[6] = n;
+	CHECK (check_cycles (mol, sizes));
+	CHECK (bond->IsCyclic () == 2);
+
+	// a new bond closes a four atoms ring at the end of the first row
+	bond = new_bond (width - 1, 2 * width - 1);
+	mol->AddBond (bond);
+	mol->UpdateCycles (bond);
+	sizes[4] = 1;
+	CHECK (check_cycles (mol, sizes));
+	CHECK (bond->IsCyclic () == 1);
+	CHECK (get_bond (width - 2, width - 1)->IsCyclic () == 1);
+	delete doc;
+	return 0;
+}
+
+// perceives the cycles of a new molecule and prints the time needed
+static gcu::Molecule *time_perception (char const *name)
+{
+	GTimer *timer = g_timer_new ();
+	gcu::Molecule *mol = new gcu::Molecule (atoms[0]);
+	unsigned n = mol->GetCyclesNumber ();
+	printf ("%s, %u atoms, %u bonds: %u cycles in %g s\n", name, mol->GetAtomsNumber (), mol->GetBondsNumber (), n, g_timer_elapsed (timer, NULL));
+	g_timer_destroy (timer);
+	return mol;
+}
+
+/* perceives the cycles of a fullerene, of beta-cyclodextrin and of a size x
+ size atoms hexagonal sheet, then removes and adds again a bond in the middle
+ of the sheet, updating the cycles each time */
+static int bench (int size)
+{
+	gcu::Document *doc = new gcu::Document (NULL);
+	build_fullerene (doc);
+	time_perception ("fullerene");
+	delete doc;
+	doc = new gcu::Document (NULL);
+	build_cyclodextrin (doc);
+	time_perception ("cyclodextrin");
+	delete doc;
+	doc = new gcu::Document (NULL);
+	build_sheet (doc, size, size);
+	gcu::Molecule *mol = time_perception ("sheet");
+
+	gcu::Bond *bond = get_bond ((size / 2) * size + size / 2 - 1, (size / 2) * size + size / 2);
+	gcu::Atom *atom0 = bond->GetAtom (0), *atom1 = bond->GetAtom (1);
+	GTimer *timer = g_timer_new ();
+	atom0->RemoveBond (bond);
+	atom1->RemoveBond (bond);
+	mol->Remove (bond);
+	mol->UpdateCycles (bond);
+	printf ("bond removed: %u cycles in %g s\n", mol->GetCyclesNumber (), g_timer_elapsed (timer, NULL));
+	g_timer_start (timer);
+	atom0->AddBond (bond);
+	atom1->AddBond (bond);
+	mol->AddBond (bond);
+	mol->UpdateCycles (bond);
+	printf ("bond added: %u cycles in %g s\n", mol->GetCyclesNumber (), g_timer_elapsed (timer, NULL));
+	g_timer_destroy (timer);
+	delete doc;
+	return 0;
+}
+
+/*!
+\a main function of the test. With --bench as first argument, it times the
+cycles perception for a fullerene, beta-cyclodextrin and a 100x100 atoms
+sheet (the size of the sheet might be given as second argument), and the
+update of the sheet cycles when a bond is removed and added again.
+*/
+int main (int argc, char *argv[])
+{
+	if (argc > 1 && !strcmp (argv[1], "--bench"))
+		return bench ((argc > 2)? atoi (argv[2]): 100);
+	if (test_fullerene () || test_cyclodextrin () || test_sheet ())
+		return 1;
+	return 0;
+}
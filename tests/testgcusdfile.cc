@@ -0,0 +1,181 @@
+/*
+ * Gnome Chemisty Utils
+ * tests/testgcusdfile.cc
+ *
+ * Copyright (C) 2026 Jean Bréfort <jean.brefort@normalesup.org>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301
+ * USA
+ */
+
+#include "config.h"
+#include "check.h"
+#include <gcu/sdfile.h>
+#include <gsf/gsf-input-memory.h>
+#include <gsf/gsf-output-memory.h>
+#include <gsf/gsf-utils.h>
+#include <glib.h>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+/*!\file
+Writes SDfile records with gcu::SDWriter, reads them back with gcu::SDReader,
+converts them to a RDfile and reads it, checking the structure blocks and the
+data items, including values with empty lines and lines made of spaces.
+*/
+
+#define RECORDS 1000
+
+static char const *molfile =
+"methanol\n"
+"  GChemUtl          2D\n"
+"\n"
+"  2  1  0  0  0  0            999 V2000\n"
+"    0.0000    0.0000    0.0000 C   0  0  0  0  0  0  0  0  0  0  0  0\n"
+"    1.4000    0.0000    0.0000 O   0  0  0  0  0  0  0  0  0  0  0  0\n"
+"  1  2  1  0\n"
+"M  END\n";
+
+// values with empty lines, even at both ends, or lines made of spaces must be
+// read back unchanged
+static char const *comments[] = {
+	"first line\nsecond line",
+	"first paragraph\n\nsecond paragraph",
+	"\nafter an empty line",
+	"before an empty line\n",
+	"\n\n",
+	" ",
+	"a single space\n \nbetween lines",
+	"  \n\n "
+};
+
+static int check_record (gcu::SDReader *reader, int i)
+{
+	char buf[32];
+	snprintf (buf, sizeof (buf), "%d", i + 1);
+	CHECK (reader->GetType () == gcu::SD_RECORD_MOLECULE);
+	CHECK (reader->GetLines () == 8);
+	CHECK (!strcmp (reader->GetTitle (), "methanol"));
+	// the empty third line of the molfile is kept
+	CHECK (!strcmp (reader->GetLine (2), ""));
+	CHECK (!strcmp (reader->GetLine (7), "M  END"));
+	CHECK (reader->GetDataCount () == 3);
+	CHECK (reader->GetData ("ID") && !strcmp (reader->GetData ("ID"), buf));
+	CHECK (reader->GetDataName (1) == "COMMENT");
+	CHECK (reader->GetDataValue (1) == comments[i % G_N_ELEMENTS (comments)]);
+	CHECK (reader->GetDataValue (2) == "");
+	CHECK (!reader->GetData ("MISSING"));
+	return 0;
+}
+
+static bool count_records (G_GNUC_UNUSED gcu::SDReader *reader, void *data)
+{
+	return ++*static_cast < int * > (data) < 10;
+}
+
+int main ()
+{
+	int i;
+	char buf[32];
+	gsf_init ();
+
+	GsfOutput *out = gsf_output_memory_new ();
+	gcu::SDWriter *writer = new gcu::SDWriter (out);
+	for (i = 0; i < RECORDS; i++) {
+		CHECK (writer->BeginRecord ());
+		CHECK (writer->WriteBlock (molfile));
+		snprintf (buf, sizeof (buf), "%d", i + 1);
+		CHECK (writer->WriteData ("ID", buf));
+		CHECK (writer->WriteData ("COMMENT", comments[i % G_N_ELEMENTS (comments)]));
+		CHECK (writer->WriteData ("EMPTY", ""));
+		CHECK (writer->EndRecord ());
+	}
+	// SDfiles can't store reactions
+	CHECK (!writer->BeginRecord (gcu::SD_RECORD_REACTION));
+	CHECK (writer->GetRecords () == RECORDS);
+	delete writer;
+	gsf_output_close (out);
+	gsf_off_t size = gsf_output_size (out);
+
+	GsfInput *in = gsf_input_memory_new (gsf_output_memory_get_bytes (GSF_OUTPUT_MEMORY (out)), size, FALSE);
+	gcu::SDReader *reader = new gcu::SDReader (in);
+	GsfOutput *rdout = gsf_output_memory_new ();
+	writer = new gcu::SDWriter (rdout, true);
+	for (i = 0; reader->Next (); i++) {
+		CHECK (!reader->IsRDfile ());
+		CHECK (reader->GetRecord () == static_cast < unsigned > (i + 1));
+		if (check_record (reader, i))
+			return 1;
+		snprintf (buf, sizeof (buf), "%d", i + 1);
+		if (i % 2) {
+			CHECK (writer->WriteRecord (*reader));
+		} else {
+			// a record without structure, then the record with a registry number
+			CHECK (writer->BeginRecord (gcu::SD_RECORD_NONE, buf));
+			CHECK (writer->WriteData ("ID", buf));
+			CHECK (writer->BeginRecord (gcu::SD_RECORD_MOLECULE, buf));
+			CHECK (writer->WriteBlock (molfile));
+			for (unsigned j = 0; j < reader->GetDataCount (); j++)
+				CHECK (writer->WriteData (reader->GetDataName (j).c_str (), reader->GetDataValue (j).c_str ()));
+			CHECK (writer->EndRecord ());
+		}
+	}
+	CHECK (i == RECORDS);
+	delete writer;
+	delete reader;
+	g_object_unref (in);
+	gsf_output_close (rdout);
+
+	in = gsf_input_memory_new (gsf_output_memory_get_bytes (GSF_OUTPUT_MEMORY (rdout)), gsf_output_size (rdout), FALSE);
+	reader = new gcu::SDReader (in);
+	for (i = 0; reader->Next (); ) {
+		CHECK (reader->IsRDfile ());
+		if (reader->GetType () == gcu::SD_RECORD_NONE) {
+			// only the even records have one of these
+			CHECK (i % 2 == 0);
+			CHECK (reader->GetLines () == 0);
+			snprintf (buf, sizeof (buf), "%d", i + 1);
+			CHECK (reader->GetRegistryNumber () == buf);
+			CHECK (reader->GetDataCount () == 1);
+			continue;
+		}
+		if (check_record (reader, i))
+			return 1;
+		if (i % 2 == 0) {
+			snprintf (buf, sizeof (buf), "%d", i + 1);
+			CHECK (reader->GetRegistryNumber () == buf);
+		}
+		i++;
+	}
+	CHECK (i == RECORDS);
+	delete reader;
+	g_object_unref (in);
+
+	// ForEach stops when the callback returns false
+	in = gsf_input_memory_new (gsf_output_memory_get_bytes (GSF_OUTPUT_MEMORY (out)), size, FALSE);
+	reader = new gcu::SDReader (in);
+	int n = 0;
+	CHECK (reader->ForEach (count_records, &n) == 10);
+	CHECK (reader->Next () && reader->GetRecord () == 11);
+	if (check_record (reader, 10))
+		return 1;
+	delete reader;
+	g_object_unref (in);
+	g_object_unref (rdout);
+	g_object_unref (out);
+	gsf_shutdown ();
+	return 0;
+}
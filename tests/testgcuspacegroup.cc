@@ -0,0 +1,182 @@
+/*
+ * Gnome Chemisty Utils
+ * tests/testgcuspacegroup.cc
+ *
+ * Copyright (C) 2026 Jean Bréfort <jean.brefort@normalesup.org>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301
+ * USA
+ */
+
+#include "config.h"
+#include "check.h"
+#include <gcu/spacegroup.h>
+#include <gcu/vector.h>
+#include <cmath>
+#include <cstdio>
+#include <list>
+#include <string>
+#include <vector>
+
+/*!\file
+Tests the expansion of positions by a space group, using
+gcu::SpaceGroup::Transform() and gcu::SpaceGroup::Expand(): the number of
+images of general and special positions in P m -3 m and their coordinates, and
+the reduction of the images to the unit cell.
+*/
+
+#define NPOSITIONS 7
+
+// the 48 operations of P m -3 m are the signed permutations of x, y and z
+static void build_group (gcu::SpaceGroup &group)
+{
+	static char const *perms[6] = {"xyz", "xzy", "yxz", "yzx", "zxy", "zyx"};
+	int p, s, c;
+	for (p = 0; p < 6; p++)
+		for (s = 0; s < 8; s++) {
+			std::string op;
+			for (c = 0; c < 3; c++) {
+				if (c)
+					op += ',';
+				if (s & (1 << c))
+					op += '-';
+				op += perms[p][c];
+			}
+			group.AddTransform (op);
+		}
+}
+
+static bool same (double a, double b)
+{
+	return fabs (a - b) < 1e-12;
+}
+
+/*
+Checks that the images of \a p are its \a count signed permutations, reduced to
+the unit cell, each coordinate v of \a p giving either v or 1 - v, and that
+they are all different.
+*/
+static int check_images (double const *p, double const *images, unsigned count, unsigned expected)
+{
+	static unsigned const perms[6][3] = {{0, 1, 2}, {0, 2, 1}, {1, 0, 2}, {1, 2, 0}, {2, 0, 1}, {2, 1, 0}};
+	unsigned i, j, k;
+	CHECK (count == expected);
+	for (i = 0; i < count; i++) {
+		double const *image = images + 3 * i;
+		for (j = 0; j < 6; j++) {
+			for (k = 0; k < 3; k++) {
+				double v = p[perms[j][k]], w = (v == 0.)? 0.: 1. - v;
+				if (!same (image[k], v) && !same (image[k], w))
+					break;
+			}
+			if (k == 3)
+				break;
+		}
+		CHECK (j < 6);
+		for (j = 0; j < i; j++)
+			CHECK (!same (image[0], images[3 * j]) || !same (image[1], images[3 * j + 1]) ||
+			       !same (image[2], images[3 * j + 2]));
+	}
+	return 0;
+}
+
+static int test_cubic ()
+{
+	// a general position, positions on a mirror, on a diagonal and on an axis,
+	// a face center, the origin and the body center
+	static double const positions[3 * NPOSITIONS] = {
+		.1, .2, .3,
+		.1, .2, 0.,
+		.1, .1, .1,
+		.2, 0., 0.,
+		.5, .5, 0.,
+		0., 0., 0.,
+		.5, .5, .5
+	};
+	static unsigned const expected[NPOSITIONS] = {48, 24, 8, 6, 3, 1, 1};
+	gcu::SpaceGroup group;
+	build_group (group);
+	CHECK (group.GetTransformsNumber () == 48);
+
+	unsigned i, k, total = 0;
+	std::vector <double> images (3 * NPOSITIONS * 48), single (3 * 48);
+	unsigned counts[NPOSITIONS];
+	for (i = 0; i < NPOSITIONS; i++)
+		total += expected[i];
+	CHECK (group.Expand (positions, NPOSITIONS, &images[0], counts) == total);
+	double const *image = &images[0];
+	for (i = 0; i < NPOSITIONS; i++) {
+		if (check_images (positions + 3 * i, image, counts[i], expected[i]))
+			return 1;
+		// the same images, in the same order, when the position is alone
+		CHECK (group.Expand (positions + 3 * i, 1, &single[0], NULL) == expected[i]);
+		std::list <gcu::Vector> l = group.Transform (gcu::Vector (positions[3 * i], positions[3 * i + 1], positions[3 * i + 2]));
+		CHECK (l.size () == expected[i]);
+		std::list <gcu::Vector>::iterator v = l.begin ();
+		for (k = 0; k < expected[i]; k++, v++, image += 3) {
+			CHECK (single[3 * k] == image[0] && single[3 * k + 1] == image[1] && single[3 * k + 2] == image[2]);
+			CHECK ((*v).GetX () == image[0] && (*v).GetY () == image[1] && (*v).GetZ () == image[2]);
+		}
+	}
+
+	// the images of the positions on an axis
+	static double const axis[6][3] = {
+		{.2, 0., 0.}, {.8, 0., 0.}, {0., .2, 0.}, {0., .8, 0.}, {0., 0., .2}, {0., 0., .8}
+	};
+	std::list <gcu::Vector> l = group.Transform (gcu::Vector (.2, 0., 0.));
+	for (i = 0; i < 6; i++) {
+		std::list <gcu::Vector>::iterator v, vend = l.end ();
+		for (v = l.begin (); v != vend; v++)
+			if (same ((*v).GetX (), axis[i][0]) && same ((*v).GetY (), axis[i][1]) && same ((*v).GetZ (), axis[i][2]))
+				break;
+		CHECK (v != vend);
+	}
+	// the face centers
+	static double const faces[3][3] = {{.5, .5, 0.}, {.5, 0., .5}, {0., .5, .5}};
+	l = group.Transform (gcu::Vector (0., .5, .5));
+	for (i = 0; i < 3; i++) {
+		std::list <gcu::Vector>::iterator v, vend = l.end ();
+		for (v = l.begin (); v != vend; v++)
+			if (same ((*v).GetX (), faces[i][0]) && same ((*v).GetY (), faces[i][1]) && same ((*v).GetZ (), faces[i][2]))
+				break;
+		CHECK (v != vend);
+	}
+	return 0;
+}
+
+static int test_translation ()
+{
+	// a body centering, the images are brought back into the unit cell
+	gcu::SpaceGroup group;
+	group.AddTransform ("x,y,z");
+	group.AddTransform ("x+1/2,y+1/2,z+1/2");
+	double position[3] = {.75, .25, .5}, images[6];
+	unsigned count;
+	CHECK (group.Expand (position, 1, images, &count) == 2 && count == 2);
+	CHECK (same (images[0], .75) && same (images[1], .25) && same (images[2], .5));
+	CHECK (same (images[3], .25) && same (images[4], .75) && same (images[5], 0.));
+	// the images of the origin are all different
+	std::list <gcu::Vector> l = group.Transform (gcu::Vector (0., 0., 0.));
+	CHECK (l.size () == 2);
+	CHECK (same (l.back ().GetX (), .5) && same (l.back ().GetY (), .5) && same (l.back ().GetZ (), .5));
+	return 0;
+}
+
+int main ()
+{
+	if (test_cubic () || test_translation ())
+		return 1;
+	return 0;
+}
@@ -0,0 +1,159 @@
+/*
+ * Gnome Chemisty Utils
+ * tests/testgcuspectrum.cc
+ *
+ * Copyright (C) 2026 Jean Bréfort <jean.brefort@normalesup.org>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301
+ * USA
+ */
+
+#include "config.h"
+#include "check.h"
+#include <gcu/fid.h>
+#include <gcu/jcamp.h>
+#include <gcu/spectrum.h>
+#include <glib.h>
+#include <cmath>
+#include <cstdio>
+#include <vector>
+
+/*!\file
+Loads sample JCAMP-DX files with gcu::JcampReader, and tests the unit
+conversions and the integration with baseline correction shared by gspectrum
+and the batch processor.
+*/
+
+static bool load (char const *name, gcu::JcampReader &reader)
+{
+	char *path = g_build_filename (SRCDIR, name, NULL), *contents;
+	gsize length;
+	bool res = g_file_get_contents (path, &contents, &length, NULL);
+	g_free (path);
+	if (!res)
+		return false;
+	res = reader.Load (contents, length);
+	g_free (contents);
+	return res;
+}
+
+static int test_infrared ()
+{
+	gcu::JcampReader reader;
+	CHECK (load ("ir.jdx", reader));
+	CHECK (!reader.HasNTuples ());
+	CHECK (reader.GetLabel ("TITLE") == "synthetic infrared spectrum");
+	CHECK (reader.GetLabel ("DATATYPE") == "INFRARED SPECTRUM");
+	CHECK (reader.GetUnit ('X') == "1/CM");
+	CHECK (reader.GetUnit ('Y') == "TRANSMITTANCE");
+	std::vector <double> &x = reader.GetX (), &y = reader.GetY ();
+	CHECK (x.size () == 11 && y.size () == 11);
+	unsigned i;
+	for (i = 0; i < 11; i++) {
+		CHECK (fabs (x[i] - (4000. - i)) < 1e-9);
+		CHECK (fabs (y[i] - ((i == 5)? .1: 1.)) < 1e-9);
+	}
+
+	// transmittance to absorbance and back
+	std::vector <double> a (y);
+	CHECK (gcu::ConvertSpectrumUnit ("TRANSMITTANCE", "ABSORBANCE", 0., &a[0], a.size ()));
+	CHECK (fabs (a[0]) < 1e-12 && fabs (a[5] - 1.) < 1e-12);
+	CHECK (gcu::ConvertSpectrumUnit ("ABSORBANCE", "TRANSMITTANCE", 0., &a[0], a.size ()));
+	for (i = 0; i < 11; i++)
+		CHECK (fabs (a[i] - y[i]) < 1e-12);
+	// wavenumbers to wavelengths
+	std::vector <double> w (x);
+	CHECK (gcu::ConvertSpectrumUnit ("1/CM", "NANOMETERS", 0., &w[0], w.size ()));
+	CHECK (fabs (w[0] - 2500.) < 1e-9);
+	CHECK (gcu::ConvertSpectrumUnit ("NM", "MICROMETERS", 0., &w[0], w.size ()));
+	CHECK (fabs (w[0] - 2.5) < 1e-12);
+	CHECK (gcu::ConvertSpectrumUnit ("MICROMETERS", "1/CM", 0., &w[0], w.size ()));
+	CHECK (fabs (w[10] - 3990.) < 1e-9);
+	// unsupported conversions are rejected and leave the values unchanged
+	CHECK (!gcu::ConvertSpectrumUnit ("1/CM", "ABSORBANCE", 0., &w[0], w.size ()));
+	CHECK (!gcu::ConvertSpectrumUnit ("HZ", "PPM", 0., &w[0], w.size ()));
+	CHECK (fabs (w[10] - 3990.) < 1e-9);
+	// the same unit needs no function
+	double factor, offset;
+	CHECK (gcu::GetSpectrumUnitConversion ("PPM", "ppm", 400., factor, offset) == NULL);
+	gcu::SpectrumUnitConversion conv = gcu::GetSpectrumUnitConversion ("PPM", "HZ", 400., factor, offset);
+	CHECK (conv != NULL && fabs (conv (2., factor, offset) - 800.) < 1e-12);
+	return 0;
+}
+
+static int test_fid ()
+{
+	gcu::JcampReader reader;
+	CHECK (load ("fid.jdx", reader));
+	CHECK (reader.HasNTuples ());
+	CHECK (reader.GetLabel ("DATATYPE") == "NMR FID");
+	CHECK (reader.GetNumber (".OBSERVEFREQUENCY", 0.) == 100.);
+	CHECK (reader.GetUnit ('X') == "SECONDS");
+	CHECK (reader.GetUnit ('R') == "ARBITRARY UNITS");
+	CHECK (reader.GetY ().empty ());
+	std::vector <double> &x = reader.GetX (), &re = reader.GetValues ('R'), &im = reader.GetValues ('I');
+	CHECK (x.size () == 8 && re.size () == 8 && im.size () == 8);
+	// a line at a quarter of the sampling frequency
+	static double const cosines[] = {1., 0., -1., 0.};
+	unsigned i;
+	for (i = 0; i < 8; i++) {
+		CHECK (fabs (x[i] - i * 1e-3) < 1e-12);
+		CHECK (fabs (re[i] - cosines[i % 4]) < 1e-12);
+		CHECK (fabs (im[i] - cosines[(i + 3) % 4]) < 1e-12);
+	}
+	gcu::FidProcessor fid;
+	fid.SetFID (&re[0], &im[0], 8, (x[7] - x[0]) / 7);
+	CHECK (fid.GetSize () == 8);
+	double const *sre = fid.GetReal (), *sim = fid.GetImaginary ();
+	for (i = 0; i < 8; i++)
+		CHECK (fabs (sre[i] - ((i == 1)? 8.: 0.)) < 1e-9 && fabs (sim[i]) < 1e-9);
+	std::vector <double> freq (8);
+	fid.GetFrequencies (10., &freq[0]);
+	CHECK (fabs (freq[7] - freq[0] - 1000.) < 1e-9);
+	CHECK (fabs (freq[0] + freq[7] - 20.) < 1e-9);
+	return 0;
+}
+
+static int test_integration ()
+{
+	// a gaussian line with an area of 12.5 points over a small offset
+	unsigned i, n = 501;
+	std::vector <double> x (n), y (n), integral (n);
+	for (i = 0; i < n; i++) {
+		x[i] = 10. - 10. * i / (n - 1);
+		y[i] = .002 + exp (-(x[i] - 5.) * (x[i] - 5.) / .02);
+	}
+	double area = sqrt (2. * M_PI) * 5.;
+	CHECK (gcu::IntegrateSpectrum (&x[0], &y[0], n, &integral[0]));
+	// without the baseline correction, the offset would add 8% to the area
+	CHECK (fabs (integral[n - 1] - integral[0] - area) < .02 * area);
+	// the integral is flat on both sides of the line
+	for (i = 0; i < 200; i++)
+		CHECK (fabs (integral[i] - integral[0]) < .05);
+	for (i = 300; i < n; i++)
+		CHECK (fabs (integral[i] - integral[n - 1]) < .05);
+	// too few points
+	CHECK (!gcu::IntegrateSpectrum (&x[0], &y[0], 1, &integral[0]));
+	return 0;
+}
+
+int main ()
+{
+	if (test_infrared ())
+		return 1;
+	if (test_fid ())
+		return 1;
+	return test_integration ();
+}